@@ -5,7 +5,15 @@
 #include <time.h>
 #include "request_response.h"
 #include "http_client.h"
+#include "request_engine.h"
+#include "persistence_worker.h"
+#include "collection_loader.h"
+#include "collection_importer.h"
 #include "collections.h"
+#include "history_store.h"
+#include "har_writer.h"
+#include "mock_server.h"
+#include "text_buffer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,12 +36,40 @@ typedef enum {
     CONTENT_TYPE_YAML = 5
 } ContentType;
 
+// Request fields edited through the UI, each has its own generation counter
+typedef enum {
+    SYNC_FIELD_METHOD = 0,
+    SYNC_FIELD_URL = 1,
+    SYNC_FIELD_BODY = 2,
+    SYNC_FIELD_AUTH = 3,
+    SYNC_FIELD_COUNT
+} SyncField;
+
+#define APP_STATE_MAX_REQUEST_TABS 16
+
+// One response tab, each has its own transfer and response history
+typedef struct {
+    int id;                         // Stable identity for the UI, never reused
+    char title[160];
+    int collection_index;           // Request the tab was opened for, -1 for the scratch request
+    int request_index;
+    char method[16];                // What was last sent from this tab
+    char url[2048];
+    Response response;
+    Response previous_response;     // Last completed response, kept for comparing runs
+    int transfer_id;                // Engine transfer in flight, 0 when idle
+    bool request_in_progress;
+    Request* sent_request;          // What went out, recorded to history and kept for HAR exports of the response
+} RequestTab;
+
 typedef struct {
     // Core functionality
     Request current_request;
-    Response current_response;
-    HttpClient* http_client;
-    bool request_in_progress;
+    RequestEngine* request_engine;  // Shared by all tabs, runs transfers off the UI thread
+    RequestTab request_tabs[APP_STATE_MAX_REQUEST_TABS];
+    int request_tab_count;
+    int active_request_tab;
+    int next_request_tab_id;
     char status_message[256];
     bool ssl_verify_enabled;
     
@@ -54,21 +90,24 @@ typedef struct {
     bool show_collection_rename_dialog;
     bool show_request_create_dialog;
     bool show_cookie_manager;
+    bool show_profiler;
+    bool show_history;
+    bool show_mock_server;
     
     // UI input buffers (moved from UIManager - single source of truth)
     char collection_name_buffer[256];
     char collection_description_buffer[512];
     char request_name_buffer[256];
     char url_buffer[2048];
-    char body_buffer[8192];  // Legacy buffer - kept for compatibility
+    TextBuffer body_buffer;  // Body as sent, grows with the request body
     char header_name_buffer[128];
     char header_value_buffer[512];
     
     // Separate content type buffers to prevent cross-contamination
-    char json_body_buffer[8192];
-    char plain_text_body_buffer[8192];
-    char xml_body_buffer[8192];
-    char yaml_body_buffer[8192];
+    TextBuffer json_body_buffer;
+    TextBuffer plain_text_body_buffer;
+    TextBuffer xml_body_buffer;
+    TextBuffer yaml_body_buffer;
     // Form data is handled separately with key-value pairs, not stored in buffers
     
     // Authentication buffers
@@ -103,6 +142,9 @@ typedef struct {
     // Change tracking for state synchronization
     bool ui_state_dirty;
     bool request_data_dirty;
+    bool active_request_edited;  // the next sync journals the active request even if no field moved
+    unsigned int field_generation[SYNC_FIELD_COUNT];   // bumped by every UI edit of a field
+    unsigned int synced_generation[SYNC_FIELD_COUNT];  // generation last copied into the request
     time_t last_ui_sync;
     
     // Enhanced unsaved changes tracking
@@ -113,12 +155,29 @@ typedef struct {
     bool auto_save_enabled;
     int auto_save_interval;         // seconds
     time_t last_auto_save;
+    PersistenceWorker* persistence_worker;  // Writes collections off the UI thread
+    double last_save_duration_ms;   // How long the last save took, shown in the status bar
+    int last_save_written;          // Collections the last save actually wrote
+    CollectionLoader* collection_loader;  // Reads collection files off the UI thread after startup
+    bool collections_loading;       // Some collections are still placeholders from the manifest
+    double load_started_ms;         // Startup timing, printed with TINYREQUEST_STARTUP_STATS
+    double manifest_ms;
+    double load_duration_ms;
+    int collections_loaded;
+    HistoryStore* history_store;    // Every sent request and its response, NULL when history is off
     
     // Import/Export state
     char last_export_path[1024];
     char last_import_path[1024];
     bool show_import_dialog;
+    CollectionImporter* importer;   // The import running or just finished, NULL otherwise
+    char import_message[256];       // Why the last import failed, shown in the import dialog
+    HarExport* har_export;          // The history export running or just finished, NULL otherwise
     bool show_export_dialog;
+
+    // Mock server, answers from its own copy of the collection's routes
+    MockServer* mock_server;        // NULL while stopped
+    char mock_collection_name[256];
 } AppState;
 
 // Application state management functions
@@ -126,6 +185,23 @@ AppState* app_state_create(void);
 void app_state_destroy(AppState* state);
 void app_state_reset_request(AppState* state);
 void app_state_reset_response(AppState* state);
+void app_state_keep_previous_response(AppState* state);
+
+// Request tab functions, the current response is the one of the active tab
+RequestTab* app_state_get_current_tab(AppState* state);
+Response* app_state_get_current_response(AppState* state);
+Response* app_state_get_previous_response(AppState* state);
+bool app_state_is_request_in_progress(AppState* state);
+bool app_state_is_active_request_in_progress(AppState* state);
+int app_state_count_requests_in_progress(AppState* state);
+int app_state_find_request_tab(AppState* state, int collection_index, int request_index);
+int app_state_open_request_tab(AppState* state, int collection_index, int request_index);
+void app_state_close_request_tab(AppState* state, int tab_index);
+void app_state_set_active_request_tab(AppState* state, int tab_index);
+int app_state_send_request(AppState* state, int tab_index, const Request* request);
+void app_state_cancel_request(AppState* state, int tab_index);
+void app_state_poll_requests(AppState* state);
+int app_state_open_history_entry(AppState* state, HistoryEntry* entry);
 
 // Collections integration functions
 Collection* app_state_get_active_collection(AppState* state);
@@ -154,6 +230,7 @@ time_t app_state_get_last_change_time(AppState* state);
 void app_state_sync_ui_to_request(AppState* state);
 void app_state_sync_request_to_ui(AppState* state);
 void app_state_mark_ui_dirty(AppState* state);
+void app_state_mark_field_dirty(AppState* state, SyncField field);
 void app_state_mark_request_dirty(AppState* state);
 bool app_state_needs_ui_sync(AppState* state);
 bool app_state_needs_request_sync(AppState* state);
@@ -161,13 +238,43 @@ void app_state_auto_sync(AppState* state);
 
 // Auto-save functions
 bool app_state_should_auto_save(AppState* state);
+double app_state_seconds_until_auto_save(AppState* state);
 void app_state_update_auto_save_time(AppState* state);
 int app_state_perform_auto_save(AppState* state);
 int app_state_save_all_collections(AppState* state);
 void app_state_check_and_perform_auto_save(AppState* state);
+int app_state_delete_collection_file(AppState* state, const char* collection_id);
+void app_state_poll_saves(AppState* state);
+int app_state_flush_saves(AppState* state);
+void app_state_poll_collection_loads(AppState* state);
+int app_state_ensure_collection_loaded(AppState* state, int collection_index);
+void app_state_request_collection_load(AppState* state, int collection_index);
+
+// Collection imports, run on a thread of their own
+bool app_state_start_import(AppState* state, const char* filepath);
+void app_state_cancel_import(AppState* state);
+void app_state_poll_import(AppState* state);
+
+// HAR exports of a tab's response or of history records, the latter on a thread of their own
+int app_state_export_response_har(AppState* state, int tab_index, const char* filepath, bool bodies);
+bool app_state_start_har_export(AppState* state, const uint64_t* ids, int id_count,
+                                uint64_t first_id, uint64_t last_id, const char* filepath, bool bodies);
+void app_state_poll_har_export(AppState* state);
+
+// Serves a collection on localhost with the responses history recorded for it, returns a MockServerError
+int app_state_start_mock_server(AppState* state, int collection_index, const MockServerOptions* options);
+void app_state_stop_mock_server(AppState* state);
+
+// Edit journal, called right after the collection edit with the generation from before it
+void app_state_journal_put_request(AppState* state, Collection* collection,
+                                   unsigned int base_generation, int request_index);
+void app_state_journal_remove_request(AppState* state, Collection* collection,
+                                      unsigned int base_generation, int request_index);
+void app_state_journal_set_collection(AppState* state, Collection* collection,
+                                      unsigned int base_generation);
 
 // Content type buffer management functions
-char* app_state_get_content_buffer(AppState* state, int content_type);
+TextBuffer* app_state_get_content_buffer(AppState* state, int content_type);
 void app_state_set_content_buffer(AppState* state, int content_type, const char* content);
 void app_state_clear_content_buffers(AppState* state);
 void app_state_sync_content_to_body_buffer(AppState* state, int content_type);
@@ -0,0 +1,101 @@
+/**
+ * binary_io.h
+ *
+ * little endian encoding for tinyrequest's binary files
+ *
+ * the collection journal and the binary collection store write numbers as
+ * fixed size little endian integers and strings as a 32 bit length
+ * followed by their bytes. a writer grows one buffer and remembers if an
+ * allocation failed, so encoders write everything and check once at the
+ * end. a reader never reads past its end, a read that would sets failed
+ * and returns zeros from then on.
+ *
+ * a request is encoded as its method, url, headers, body and the auth
+ * fields in the order Request declares them.
+ *
+ * blocks that are worth it can be stored zstd compressed when tinyrequest
+ * is built with zstd. every compressed block is tagged with its encoding,
+ * so a build without zstd still reads everything else in the file.
+ */
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "request_response.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BINARY_ENCODING_RAW 0
+#define BINARY_ENCODING_ZSTD 1
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} ByteWriter;
+
+typedef struct {
+    const unsigned char* cur;
+    const unsigned char* end;
+    bool failed;
+} ByteReader;
+
+/* fnv-1a, what every checksum in these files is */
+uint32_t binary_checksum(const void* data, size_t length);
+
+/* 64 bit fnv-1a, for naming content rather than checking it */
+uint64_t binary_hash64(const void* data, size_t length);
+
+void byte_writer_reserve(ByteWriter* writer, size_t extra);
+void byte_writer_bytes(ByteWriter* writer, const void* bytes, size_t length);
+void byte_writer_u8(ByteWriter* writer, unsigned int value);
+void byte_writer_u32(ByteWriter* writer, uint32_t value);
+void byte_writer_u64(ByteWriter* writer, uint64_t value);
+void byte_writer_data(ByteWriter* writer, const char* data, size_t length);
+void byte_writer_string(ByteWriter* writer, const char* text);
+void byte_writer_request(ByteWriter* writer, const Request* request);
+
+/* overwrites a number already written at offset */
+void byte_writer_patch_u32(ByteWriter* writer, size_t offset, uint32_t value);
+void byte_writer_patch_u64(ByteWriter* writer, size_t offset, uint64_t value);
+
+void byte_reader_init(ByteReader* reader, const void* data, size_t length);
+unsigned int byte_reader_u8(ByteReader* reader);
+uint32_t byte_reader_u32(ByteReader* reader);
+uint64_t byte_reader_u64(ByteReader* reader);
+
+/* points at a length-prefixed string inside the buffer */
+const char* byte_reader_data(ByteReader* reader, size_t* length);
+
+/* copies a string into a fixed field, cutting it to fit */
+void byte_reader_field(ByteReader* reader, char* dest, size_t dest_size);
+
+/* copies a string into a nul terminated malloc'd buffer */
+char* byte_reader_alloc(ByteReader* reader, size_t* length);
+
+/* fills a request set up with request_init, returns false if the encoding is broken */
+bool byte_reader_request(ByteReader* reader, Request* request);
+
+/* compresses a block of at least min_length bytes. returns a malloc'd buffer
+ * and its length, or NULL when the block should be stored as it is - it is
+ * too small, compression did not make it smaller or there is no zstd */
+unsigned char* binary_compress(const void* data, size_t length, size_t min_length, size_t* compressed_length);
+
+/* undoes binary_compress, raw_length is what the block was before. returns a
+ * malloc'd buffer or NULL if the block is broken or this build has no zstd */
+unsigned char* binary_decompress(const void* data, size_t length, size_t raw_length);
+
+/* false when binary_decompress can not work in this build */
+bool binary_compression_available(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
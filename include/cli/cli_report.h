@@ -0,0 +1,37 @@
+/**
+ * cli_report.h
+ *
+ * run reports for tinyrequest-cli
+ *
+ * writes what a run counted as a table for people, as json for scripts
+ * and dashboards, or as JUnit XML for ci servers. JUnit gets one test
+ * case per request, failed when any of its runs failed.
+ */
+
+#ifndef CLI_REPORT_H
+#define CLI_REPORT_H
+
+#include <stdio.h>
+#include "cli/cli_runner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CLI_REPORT_TEXT = 0,
+    CLI_REPORT_JSON,
+    CLI_REPORT_JUNIT
+} CliReportFormat;
+
+/* "text", "json" or "junit", -1 for anything else */
+int cli_report_parse_format(const char* name);
+
+/* writes the report, returns 0 or -1 when it could not be written */
+int cli_report_write(FILE* out, int format, const char* collection_name, const CliRunReport* report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * cli_runner.h
+ *
+ * headless collection runs for tinyrequest-cli
+ *
+ * runs requests of a collection on the request engine without a ui: one
+ * request, the whole collection in order, or the selection over and over
+ * for a number of iterations or a length of time as a load test. up to
+ * concurrency requests are kept in flight. with one the requests go out
+ * strictly in order, so a login can set the cookies the next request
+ * sends. cookies go through the collection's jar on the calling thread,
+ * the way the app handles them.
+ *
+ * results are counted per request: runs, failures, latencies and status
+ * classes. a run fails when the transfer failed or the status is 400 or
+ * above. every response can also go to a HAR file as it arrives, the
+ * writer streams it so a long load test costs no memory for it.
+ */
+
+#ifndef CLI_RUNNER_H
+#define CLI_RUNNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "collections.h"
+#include "har_writer.h"
+#include "request_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* every request in flight has a worker of its own */
+#define CLI_RUNNER_MAX_CONCURRENCY REQUEST_ENGINE_MAX_WORKERS
+
+/* status classes counted per request, the first one is failed transfers */
+#define CLI_STATUS_CLASSES 6
+
+/* called as each response arrives, response is only valid during the call */
+typedef void (*CliResultCallback)(const char* name, const Request* request, const Response* response,
+                                  int result, bool passed, void* user_data);
+
+typedef struct {
+    const int* request_indices;     /* requests to run in this order, NULL for all of them */
+    int request_count;
+    int iterations;                 /* times to run the selection, 0 to run until duration_seconds */
+    double duration_seconds;        /* load test length, 0 for no limit */
+    int concurrency;
+    const char* base_url;           /* replaces the scheme and host of every url, NULL to keep them */
+    bool insecure;                  /* skips certificate checks */
+    bool bail;                      /* submits nothing more after the first failure */
+    HarWriter* har;                 /* every request and response goes here, may be NULL */
+    CliResultCallback on_result;    /* may be NULL */
+    void* user_data;
+} CliRunOptions;
+
+typedef struct {
+    int request_index;
+    char name[256];
+    char method[16];
+    char url[2048];
+    int runs;
+    int failed;
+    int status_classes[CLI_STATUS_CLASSES];
+    char first_error[256];          /* what the first failed run ran into */
+    double* latencies;              /* milliseconds per run, sorted once the run finished */
+    int latency_count;
+    int latency_capacity;
+    int64_t bytes_received;
+} CliRequestStats;
+
+typedef struct {
+    CliRequestStats* requests;
+    int request_count;
+    int runs;
+    int failed;
+    int64_t started_at_ms;          /* unix time in milliseconds */
+    double elapsed_ms;
+    bool interrupted;               /* stopped by cli_runner_interrupt */
+    int har_result;                 /* PersistenceError of the first failed HAR write */
+} CliRunReport;
+
+/* runs the collection, blocking until the last response arrived. returns
+ * 0 once the report is filled in, -1 when the run could not start. the
+ * report needs cli_run_report_cleanup either way */
+int cli_runner_run(Collection* collection, const CliRunOptions* options, CliRunReport* report);
+
+/* stops submitting and cancels what is in flight, safe to call from a
+ * signal handler */
+void cli_runner_interrupt(void);
+
+/* latency at a percentile between 0 and 100, nearest rank, 0 without runs */
+double cli_request_stats_percentile(const CliRequestStats* stats, double percentile);
+double cli_request_stats_mean(const CliRequestStats* stats);
+
+void cli_run_report_cleanup(CliRunReport* report);
+
+void cli_runner_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * collection_importer.h
+ *
+ * collection imports for tinyrequest
+ *
+ * reads Postman v2.1 collections, Insomnia v4 exports and HAR files, as
+ * well as tinyrequest's own collection files, into a new collection. the
+ * format is told by the keys at the top of the file, not by its name.
+ *
+ * an import file can be far larger than what ends up in the collection, a
+ * HAR from a browser session is mostly response bodies. the file is mapped
+ * and walked once with json_reader.h, each request is built in place as
+ * its entry goes by and everything else is skipped without being copied.
+ * pages of the mapping the walk is done with are handed back as it goes,
+ * so a 300 MB file costs about the size of the requests it holds.
+ *
+ * a collection importer runs an import on a thread of its own. the ui
+ * reads its progress every frame, can cancel it at any time and takes the
+ * collection once it finished. the ui is woken through wake_signal_post.
+ */
+
+#ifndef COLLECTION_IMPORTER_H
+#define COLLECTION_IMPORTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "collections.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    COLLECTION_IMPORT_UNKNOWN = 0,
+    COLLECTION_IMPORT_TINYREQUEST,
+    COLLECTION_IMPORT_POSTMAN,
+    COLLECTION_IMPORT_INSOMNIA,
+    COLLECTION_IMPORT_HAR
+} CollectionImportFormat;
+
+typedef struct {
+    bool finished;
+    int result;             /* PersistenceError, once finished */
+    int format;             /* CollectionImportFormat, once known */
+    size_t bytes_done;
+    size_t bytes_total;
+    int request_count;
+    double elapsed_ms;
+} CollectionImportProgress;
+
+/* called between requests, returning false cancels the import */
+typedef bool (*CollectionImportCallback)(size_t bytes_done, size_t bytes_total, int request_count,
+                                         void* user_data);
+
+/* "Postman", "HAR" and so on */
+const char* collection_import_format_name(int format);
+
+/* imports a file into a collection with a new id, on the calling thread.
+ * format and callback may be null. returns a PersistenceError,
+ * PERSISTENCE_ERROR_CANCELLED when the callback stopped it. on failure the
+ * collection is left as it was */
+int collection_import_file(Collection* collection, const char* filepath, int* format,
+                           CollectionImportCallback callback, void* user_data);
+
+typedef struct CollectionImporter CollectionImporter;
+
+/* starts importing a file on a new thread, NULL if it could not be started */
+CollectionImporter* collection_importer_start(const char* filepath);
+
+/* cancels the import if it still runs, waits for the thread and frees it */
+void collection_importer_destroy(CollectionImporter* importer);
+
+void collection_importer_get_progress(CollectionImporter* importer, CollectionImportProgress* progress);
+void collection_importer_cancel(CollectionImporter* importer);
+
+/* moves the imported collection out once the import finished successfully.
+ * returns false before that or when it failed */
+bool collection_importer_take(CollectionImporter* importer, Collection* collection);
+
+void collection_importer_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * collection_journal.h
+ *
+ * append-only edit journal for tinyrequest collections
+ *
+ * saving an edit used to mean serializing and rewriting the whole
+ * collection file, so the cost of typing one character grew with the size
+ * of the collection. now an edit is written as one small record appended
+ * to <id>.journal next to the collection file and synced to disk, and the
+ * json file becomes a snapshot that is only rewritten now and then. a
+ * snapshot stores the sequence number of the last record it contains, so
+ * loading reads the snapshot and replays only the records after it, and a
+ * crash between writing a snapshot and trimming the journal loses nothing.
+ *
+ * a record carries one of
+ * - a whole request with its name, put at an index. this covers adding,
+ *   renaming and every field edit, and keeps a record independent of
+ *   what the ui changed in place before it
+ * - the removal of the request at an index
+ * - the collection name and description
+ * anything else, like cookies, still goes through a full snapshot.
+ *
+ * records are framed with their length and a checksum. replay stops at
+ * the first record that is torn or does not apply and cuts the journal
+ * there, so later appends never land behind garbage.
+ *
+ * journal files are only touched by the persistence worker thread, and by
+ * a loader thread while it reads a collection that nothing writes yet.
+ */
+
+#ifndef COLLECTION_JOURNAL_H
+#define COLLECTION_JOURNAL_H
+
+#include <stddef.h>
+#include "collections.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a journal this large is folded into a new snapshot */
+#define COLLECTION_JOURNAL_COMPACT_BYTES (256 * 1024)
+
+typedef enum {
+    COLLECTION_JOURNAL_PUT_REQUEST = 1,
+    COLLECTION_JOURNAL_REMOVE_REQUEST = 2,
+    COLLECTION_JOURNAL_SET_COLLECTION = 3
+} CollectionJournalOp;
+
+/* path of a collection's journal, the caller frees it */
+char* collection_journal_get_path(const char* collection_id);
+
+/* encode one record with sequence number seq. each returns a malloc'd
+ * record and its length, or NULL when out of memory or out of range */
+char* collection_journal_encode_put_request(const Collection* collection, int request_index,
+                                            unsigned long seq, size_t* length);
+char* collection_journal_encode_remove_request(int request_index, unsigned long seq, size_t* length);
+char* collection_journal_encode_set_collection(const Collection* collection, unsigned long seq,
+                                               size_t* length);
+
+/* appends records to the journal and waits until they are on disk.
+ * returns a PersistenceError */
+int collection_journal_append(const char* collection_id, const char* records, size_t length);
+
+/* applies the records newer than collection->journal_seq and sets
+ * journal_seq and journal_size. returns the number of records applied */
+int collection_journal_replay(Collection* collection);
+
+/* drops the records a snapshot up to through_seq contains, removing the
+ * file when nothing newer is left. returns a PersistenceError */
+int collection_journal_compact(const char* collection_id, unsigned long through_seq);
+
+/* removes the journal of a deleted collection, returns a PersistenceError */
+int collection_journal_remove(const char* collection_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
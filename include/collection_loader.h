@@ -0,0 +1,87 @@
+/**
+ * collection_loader.h
+ *
+ * background collection loading for tinyrequest
+ *
+ * startup used to open and parse every collection file on the ui thread
+ * before the first frame, so a large workspace kept the window blank for
+ * as long as the slowest disk took. now the tree is drawn from the manifest
+ * in collections_state.json right away, and the loader reads the files
+ * themselves on a small pool of threads. files are read in the order they
+ * were added, and a collection the user opens is moved to the front of the
+ * queue. the ui can also block on one file when it needs it this frame.
+ *
+ * every file is read and parsed once. a collection whose id was already
+ * claimed by another file is reported as a duplicate, the check is a hash
+ * lookup so it stays cheap with thousands of files.
+ *
+ * finished files are handed back through collection_loader_poll and the ui
+ * is woken through wake_signal_post.
+ */
+
+#ifndef COLLECTION_LOADER_H
+#define COLLECTION_LOADER_H
+
+#include <stdbool.h>
+#include "collections.h"
+#include "persistence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COLLECTION_LOADER_DEFAULT_THREADS 4
+#define COLLECTION_LOADER_MAX_THREADS 16
+
+/* one file read by the loader */
+typedef struct {
+    char file_id[64];           /* file name without .json */
+    int hint;                   /* index given to collection_loader_add_file */
+    int result;                 /* PersistenceError */
+    bool duplicate;             /* the collection id belongs to a file read earlier */
+    bool has_auth;              /* the file carried collection level auth */
+    PersistenceAuth auth;
+    Collection collection;      /* only set up when result is PERSISTENCE_SUCCESS */
+    double parse_ms;            /* reading and parsing on the loader thread */
+} LoadedCollection;
+
+typedef struct CollectionLoader CollectionLoader;
+
+/* loader lifecycle, the threads are started on first use. destroying the
+ * loader drops whatever was not read yet */
+CollectionLoader* collection_loader_create(int thread_count);
+void collection_loader_destroy(CollectionLoader* loader);
+
+/* queues a collection file. returns 1 when queued, 0 when a file with the
+ * same name was added before, -1 on failure */
+int collection_loader_add_file(CollectionLoader* loader, const char* filepath, int hint);
+
+/* moves a queued file to the front of the queue */
+void collection_loader_prioritize(CollectionLoader* loader, const char* file_id);
+
+/* waits for one file and takes its result, even if it has not been polled
+ * yet. returns false when the file is unknown, forgotten or already taken */
+bool collection_loader_take(CollectionLoader* loader, const char* file_id, LoadedCollection* loaded);
+
+/* waits until every queued file has been read */
+void collection_loader_wait_all(CollectionLoader* loader);
+
+/* drops a file, queued or finished, whose collection was deleted */
+void collection_loader_forget(CollectionLoader* loader, const char* file_id);
+
+/* takes the oldest finished file, returns false if there is none */
+bool collection_loader_poll(CollectionLoader* loader, LoadedCollection* loaded);
+
+/* files queued or being read */
+int collection_loader_get_pending_count(CollectionLoader* loader);
+
+/* frees what a polled or taken result still owns */
+void loaded_collection_cleanup(LoadedCollection* loaded);
+
+void collection_loader_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
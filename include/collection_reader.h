@@ -0,0 +1,44 @@
+/**
+ * collection_reader.h
+ *
+ * streaming collection file reader for tinyrequest
+ *
+ * loading a collection used to read the whole file into a buffer, build a
+ * cjson tree of it and then copy every field out of the tree, so a large
+ * import briefly needed about three times its size in memory. the reader
+ * maps the file instead and walks the json text once, decoding every
+ * string straight into the request or collection field it ends up in.
+ * nothing but the collection itself is allocated, and keys and values
+ * nobody reads are skipped without being copied at all.
+ *
+ * the schema is the one persistence_serialize_collection writes, with the
+ * same defaults and limits the cjson based loader applied.
+ */
+
+#ifndef COLLECTION_READER_H
+#define COLLECTION_READER_H
+
+#include <stdbool.h>
+#include "collections.h"
+#include "persistence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* fills a collection from a mapped file. collection level auth and cookies
+ * are only read when auth is given. returns a PersistenceError, with
+ * PERSISTENCE_ERROR_CORRUPTED_DATA for an empty file or one that is not json.
+ * on failure the collection is left as it was */
+int collection_reader_read_file(Collection* collection, const char* filepath,
+                                PersistenceAuth* auth, bool* has_auth);
+
+/* the same for json text already in memory, which does not need to be terminated */
+int collection_reader_read_buffer(Collection* collection, const char* data, size_t length,
+                                  PersistenceAuth* auth, bool* has_auth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
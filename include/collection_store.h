@@ -0,0 +1,93 @@
+/**
+ * collection_store.h
+ *
+ * binary collection files for tinyrequest
+ *
+ * a json collection file has to be parsed from the first byte to the last
+ * before anything in it can be shown, and a large one is mostly request
+ * bodies nobody is looking at. a store file is the same collection laid
+ * out for random access: a fixed header, the collection fields, one blob
+ * per request, and an index at the end. an index entry holds the name,
+ * method and url of its request next to where the blob is, so a request
+ * list can be read out of a mapped file touching only the index pages and
+ * a request is decoded only when it is asked for.
+ *
+ * request blobs of COLLECTION_STORE_COMPRESS_MIN bytes or more are stored
+ * zstd compressed when tinyrequest is built with zstd. a build without it
+ * still writes and reads uncompressed files.
+ *
+ * json stays the format collections are imported and exported in, the
+ * convert functions go from one to the other.
+ */
+
+#ifndef COLLECTION_STORE_H
+#define COLLECTION_STORE_H
+
+#include <stdbool.h>
+#include "collections.h"
+#include "persistence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COLLECTION_STORE_EXTENSION ".trc"
+
+/* request blobs smaller than this are never worth compressing */
+#define COLLECTION_STORE_COMPRESS_MIN 4096
+
+typedef struct CollectionStore CollectionStore;
+
+/* one index entry. the strings point into the mapped file and stay valid
+ * until the store is closed */
+typedef struct {
+    const char* name;
+    const char* method;
+    const char* url;
+    size_t size;        /* the encoded request, headers and body included */
+    bool compressed;
+} CollectionStoreEntry;
+
+/* true for a path ending in COLLECTION_STORE_EXTENSION */
+bool collection_store_is_store_path(const char* filepath);
+
+/* builds a store file for a collection, auth may be null. returns a malloc'd
+ * buffer and its length, or NULL when out of memory */
+char* collection_store_serialize(const Collection* collection, const PersistenceAuth* auth, size_t* length);
+
+/* maps a store file and checks its header and index. returns NULL and sets
+ * error to a PersistenceError if the file is missing or broken */
+CollectionStore* collection_store_open(const char* filepath, int* error);
+void collection_store_close(CollectionStore* store);
+
+/* fields of the collection itself, valid until the store is closed */
+const char* collection_store_get_id(const CollectionStore* store);
+const char* collection_store_get_name(const CollectionStore* store);
+int collection_store_get_request_count(const CollectionStore* store);
+
+/* reads index entry index, returns false if it is out of range */
+bool collection_store_get_entry(const CollectionStore* store, int index, CollectionStoreEntry* entry);
+
+/* decodes one request into a request set up with request_init. returns a PersistenceError */
+int collection_store_read_request(const CollectionStore* store, int index, Request* request);
+
+/* decodes the whole collection. collection level auth and cookies are only
+ * read when auth is given. on failure the collection is left as it was.
+ * returns a PersistenceError */
+int collection_store_read_collection(const CollectionStore* store, Collection* collection,
+                                     PersistenceAuth* auth, bool* has_auth);
+
+/* open, read_collection and close in one, the same contract as collection_reader_read_file */
+int collection_store_read_file(Collection* collection, const char* filepath,
+                               PersistenceAuth* auth, bool* has_auth);
+
+/* rewrite a collection file in the other format, auth and cookies included.
+ * return a PersistenceError */
+int collection_store_convert_from_json(const char* json_path, const char* store_path);
+int collection_store_convert_to_json(const char* store_path, const char* json_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
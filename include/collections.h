@@ -60,6 +60,11 @@ typedef struct {
     int request_capacity;
     time_t created_at;
     time_t modified_at;
+    unsigned int generation;  /* bumped with modified_at, lets views cache what they derive */
+    unsigned int saved_generation;  /* generation last written to disk */
+    bool loaded;              /* false for a placeholder whose file is still being read */
+    unsigned long journal_seq;  /* last journal record applied to or written for this collection */
+    size_t journal_size;      /* bytes in the journal since the last snapshot, decides compaction */
     CookieJar cookie_jar;
 } Collection;
 
@@ -77,6 +82,8 @@ void collection_init(Collection* collection, const char* name, const char* descr
 void collection_cleanup(Collection* collection);
 
 int collection_add_request(Collection* collection, const Request* request, const char* name);
+int collection_adopt_request(Collection* collection, Request* request, char* name);
+int collection_replace_request(Collection* collection, int request_index, Request* request, char* name);
 int collection_remove_request(Collection* collection, int request_index);
 int collection_duplicate_request(Collection* collection, int request_index);
 int collection_rename_request(Collection* collection, int request_index, const char* new_name);
@@ -86,6 +93,10 @@ const char* collection_get_request_name(Collection* collection, int request_inde
 int collection_set_name(Collection* collection, const char* name);
 int collection_set_description(Collection* collection, const char* description);
 void collection_update_modified_time(Collection* collection);
+bool collection_is_dirty(const Collection* collection);
+void collection_mark_saved(Collection* collection, unsigned int generation);
+int collection_copy(Collection* dest, const Collection* src);
+void collection_move(Collection* dest, Collection* src);
 
 CollectionManager* collection_manager_create(void);
 void collection_manager_destroy(CollectionManager* manager);
@@ -93,6 +104,7 @@ void collection_manager_init(CollectionManager* manager);
 void collection_manager_cleanup(CollectionManager* manager);
 
 int collection_manager_add_collection(CollectionManager* manager, Collection* collection);
+int collection_manager_adopt_collection(CollectionManager* manager, Collection* collection);
 int collection_manager_remove_collection(CollectionManager* manager, int collection_index);
 int collection_manager_duplicate_collection(CollectionManager* manager, int collection_index);
 Collection* collection_manager_get_collection(CollectionManager* manager, int collection_index);
@@ -0,0 +1,93 @@
+/**
+ * har_writer.h
+ *
+ * HAR 1.2 export for tinyrequest
+ *
+ * a HAR file is one json object with every entry inside it. building it as
+ * a cjson tree would hold a whole load run in memory before the first byte
+ * is written, so the writer streams it instead. har_writer_open writes the
+ * head of the log, har_writer_add writes one entry straight from a request
+ * and its response through a buffer and har_writer_close writes the tail.
+ * nothing but the buffer is held, however many entries there are.
+ *
+ * the file is written next to where it goes and renamed into place by
+ * har_writer_close, an export that fails or is aborted leaves nothing
+ * behind.
+ *
+ * timings come from the response's ResponseTimings. a response that has
+ * none, like one recorded before they were kept, is written with its whole
+ * time as wait. bodies are left out unless asked for, dashboards read the
+ * timings and sizes. a body that is not utf-8 text is written as base64,
+ * a header or url byte that is not utf-8 becomes U+FFFD.
+ *
+ * a history export writes history records to a HAR file on a thread of its
+ * own, a range can be far too large to write between two frames.
+ */
+
+#ifndef HAR_WRITER_H
+#define HAR_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "request_response.h"
+#include "history_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* writes request and response bodies along with everything else */
+#define HAR_WRITER_BODIES 1u
+
+typedef struct HarWriter HarWriter;
+
+/* starts a HAR file, NULL with error set to a PersistenceError on failure */
+HarWriter* har_writer_open(const char* filepath, unsigned int flags, int* error);
+
+/* writes one entry. result is what http_client_send_request returned, a
+ * failed transfer is written with status 0 and its error. comment may be
+ * NULL. returns a PersistenceError, after a failure only close or abort
+ * are left */
+int har_writer_add(HarWriter* writer, const Request* request, const Response* response, int result,
+                   const char* comment);
+
+int har_writer_get_count(const HarWriter* writer);
+
+/* finishes the file and moves it into place. returns a PersistenceError,
+ * the writer is freed either way */
+int har_writer_close(HarWriter* writer);
+
+/* drops the file, the writer is freed */
+void har_writer_abort(HarWriter* writer);
+
+typedef struct {
+    bool finished;
+    int result;             /* PersistenceError, once finished */
+    int written;
+    int total;              /* records to look at, some may be gone by then */
+} HarExportProgress;
+
+typedef struct HarExport HarExport;
+
+/* exports history records on a new thread. ids lists the records in the
+ * order they go into the file, or is NULL for every record from first_id
+ * to last_id, oldest first. records dropped from the history by then are
+ * left out. the store must outlive the export */
+HarExport* har_export_history_start(HistoryStore* store, const uint64_t* ids, int id_count,
+                                    uint64_t first_id, uint64_t last_id, const char* filepath,
+                                    unsigned int flags);
+
+void har_export_get_progress(HarExport* export_job, HarExportProgress* progress);
+void har_export_cancel(HarExport* export_job);
+
+/* cancels the export if it still runs, waits for the thread and frees it */
+void har_export_destroy(HarExport* export_job);
+
+void har_writer_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
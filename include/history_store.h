@@ -0,0 +1,124 @@
+/**
+ * history_store.h
+ *
+ * request history for tinyrequest
+ *
+ * every response used to be thrown away when the next one arrived. the
+ * history store keeps each sent request with its response headers, timing
+ * and body in history.log in the config directory. the log is append-only,
+ * a record is never rewritten once it is there.
+ *
+ * history.idx next to it has one fixed size entry per record in the order
+ * they were sent, so entry n is found without reading anything before it.
+ * an entry holds the record's place in the log, the send time, status,
+ * duration and a hash of the url, plus the id of the previous record for
+ * the same url hash. the entries double as the time index, send times only
+ * go up so a time is found with a binary search, and as the url index,
+ * following the chain from the newest record of a url visits every earlier
+ * one. neither file is ever read whole, the panel reads the rows it shows.
+ *
+ * response bodies are cut to HISTORY_STORE_BODY_LIMIT and stored zstd
+ * compressed when tinyrequest is built with zstd.
+ *
+ * records are encoded and written by a thread of the store, which also
+ * opens and checks the files at startup and drops the oldest records once
+ * the log holds more than HISTORY_STORE_MAX_ENTRIES or HISTORY_STORE_MAX_BYTES.
+ * ids are never reused, dropped records just fall off the front. everything
+ * else may be called from the ui thread.
+ */
+
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "request_response.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HISTORY_STORE_LOG_FILENAME "history.log"
+#define HISTORY_STORE_INDEX_FILENAME "history.idx"
+
+/* response bytes kept per record, the rest is cut off */
+#define HISTORY_STORE_BODY_LIMIT (256 * 1024)
+
+/* retention, going over either drops the oldest tenth */
+#define HISTORY_STORE_MAX_ENTRIES 1000000
+#define HISTORY_STORE_MAX_BYTES (1024ull * 1024 * 1024)
+
+/* records waiting for the thread, more are dropped instead of piling up */
+#define HISTORY_STORE_MAX_PENDING 256
+
+/* what a list row needs, read from the index and the front of the record */
+typedef struct {
+    uint64_t id;
+    int64_t sent_at_ms;     /* unix time in milliseconds */
+    double duration_ms;
+    int status_code;
+    int result;             /* what http_client_send_request returned, 0 when a response came */
+    size_t body_size;       /* response body as received, before the limit */
+    char method[16];
+    char url[512];          /* cut to fit, the full url is in the entry */
+} HistorySummary;
+
+/* a whole record */
+typedef struct {
+    HistorySummary summary;
+    Request request;
+    Response response;      /* is_truncated is set when the body was cut */
+} HistoryEntry;
+
+typedef struct HistoryStore HistoryStore;
+
+/* store lifecycle, the files are opened on the store's thread */
+HistoryStore* history_store_create(void);
+void history_store_destroy(HistoryStore* store);
+
+/* queues a sent request and what came back. returns -1 when it was dropped */
+int history_store_record(HistoryStore* store, const Request* request, const Response* response, int result);
+
+/* false until the files are opened and checked */
+bool history_store_is_ready(HistoryStore* store);
+
+/* changes whenever records are added or dropped, rows read before are stale */
+unsigned int history_store_get_generation(HistoryStore* store);
+
+/* number of records, row 0 is the newest */
+int history_store_get_count(HistoryStore* store);
+
+/* fills up to count summaries starting at first_row, returns how many */
+int history_store_read_summaries(HistoryStore* store, int first_row, int count, HistorySummary* summaries);
+
+/* one summary by id, returns false once the record is gone */
+bool history_store_read_summary(HistoryStore* store, uint64_t id, HistorySummary* summary);
+
+/* reads a whole record. returns a PersistenceError, the entry needs
+ * history_entry_cleanup either way */
+int history_store_read_entry(HistoryStore* store, uint64_t id, HistoryEntry* entry);
+void history_entry_cleanup(HistoryEntry* entry);
+
+/* the first row sent at or before a time, the row count when every record is newer */
+int history_store_find_row_by_time(HistoryStore* store, int64_t time_ms);
+
+/* ids of the oldest and newest record sent between two times, both
+ * included. false when there is none. ids in between were all sent in the
+ * range, though some may be dropped by the time they are read */
+bool history_store_find_time_range(HistoryStore* store, int64_t from_ms, int64_t to_ms,
+                                   uint64_t* first_id, uint64_t* last_id);
+
+/* ids of records for exactly this url, newest first, returns how many */
+int history_store_find_url(HistoryStore* store, const char* url, uint64_t* ids, int max_ids);
+
+/* drops every record */
+void history_store_clear(HistoryStore* store);
+
+void history_store_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
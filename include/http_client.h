@@ -44,6 +44,10 @@ void http_client_destroy(HttpClient* client);
 int http_client_send_request(HttpClient* client, const Request* request, Response* response);
 int http_client_send_request_with_cookies(HttpClient* client, const Request* request, Response* response, Collection* collection);
 
+/* cookie handling split out for callers that send the request elsewhere */
+int http_client_add_cookie_header(Request* request, Collection* collection);
+void http_client_store_response_cookies(Collection* collection, const char* url, const Response* response);
+
 void http_client_set_ssl_verification(HttpClient* client, int verify_peer, int verify_host);
 
 void http_client_set_max_response_size(HttpClient* client, size_t max_size);
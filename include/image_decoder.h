@@ -0,0 +1,75 @@
+/**
+ * image_decoder.h
+ *
+ * background image decoding for tinyrequest
+ *
+ * decoding a large png or jpeg takes long enough to drop frames, so image
+ * responses are decoded on a worker thread instead of the ui thread. the
+ * caller submits the encoded bytes with a key, keeps rendering, and polls
+ * for finished images once per frame. finished images are plain rgba pixel
+ * buffers, uploading them to the gpu is left to the ui.
+ *
+ * images wider or taller than the decoder's maximum dimension are scaled
+ * down with a box filter before they are handed back, so a 12000px photo
+ * still ends up as a texture the gpu can take.
+ *
+ * only the newest queued job is kept - if several images are submitted
+ * while one is decoding, the ones in between are dropped since the user
+ * has already moved past them.
+ */
+
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMAGE_DECODER_DEFAULT_MAX_DIMENSION 2048
+/* refuse anything that would decode into more than this many pixels */
+#define IMAGE_DECODER_MAX_SOURCE_PIXELS (256u * 1024u * 1024u)
+
+typedef struct ImageDecoder ImageDecoder;
+
+/* a finished job, pixels is null and error is set when decoding failed */
+typedef struct {
+    uint64_t key;
+    unsigned char* pixels; /* rgba, width * height * 4 bytes */
+    int width;
+    int height;
+    int source_width;
+    int source_height;
+    char error[128];
+} DecodedImage;
+
+/* decoder lifecycle */
+ImageDecoder* image_decoder_create(int max_dimension);
+void image_decoder_destroy(ImageDecoder* decoder);
+
+/* queues bytes for decoding, the data is copied so the caller can free it */
+int image_decoder_submit(ImageDecoder* decoder, uint64_t key, const void* data, size_t size);
+
+/* hands back one finished image, the caller owns it until decoded_image_cleanup */
+bool image_decoder_poll(ImageDecoder* decoder, DecodedImage* image);
+void decoded_image_cleanup(DecodedImage* image);
+
+/* true while the key is queued or being decoded */
+bool image_decoder_is_pending(ImageDecoder* decoder, uint64_t key);
+
+/* cheap identity for a body - size plus a hash of its first and last bytes */
+uint64_t image_decoder_key(const void* data, size_t size);
+
+/* true for content types the decoder can handle */
+bool image_decoder_supports_content_type(const char* content_type);
+
+void image_decoder_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * json_filter.h
+ *
+ * streaming jsonpath filtering for tinyrequest
+ *
+ * this module evaluates a subset of jsonpath against raw json bytes without
+ * building a document tree. the input can be fed in as many chunks as you
+ * like, the evaluator only keeps a small stack of open containers plus the
+ * bytes of values that actually match, so filtering a huge response costs
+ * about as much memory as the answer does.
+ *
+ * supported syntax:
+ *   $                 the root value
+ *   .name ['name']    an object member
+ *   .* [*]            every member or element
+ *   [n]               an array element (non-negative)
+ *   [start:end:step]  a range of array elements (non-negative)
+ *   ..name ..*        a member at any depth below the current node
+ *
+ * filter expressions and negative indexes need the whole document and are
+ * rejected at compile time. compiled queries are immutable, so they can be
+ * shared between threads, and the query cache hands out the same compiled
+ * query for the same expression.
+ *
+ * a runner filters a whole response on a worker thread for the ui. it
+ * copies the expression and the body, collects the matches in document
+ * order into one json array and wakes the main loop when it is done. only
+ * the newest submission is kept, one that arrives while a run is going
+ * stops that run.
+ */
+
+#ifndef JSON_FILTER_H
+#define JSON_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_FILTER_MAX_STEPS 32
+#define JSON_FILTER_MAX_DEPTH 256
+#define JSON_FILTER_MAX_NAME 128
+#define JSON_FILTER_CACHE_SIZE 16
+
+/* a runner stops collecting once the matches add up to this many bytes */
+#define JSON_FILTER_OUTPUT_LIMIT (64 * 1024 * 1024)
+
+typedef struct JsonFilterQuery JsonFilterQuery;
+typedef struct JsonFilterStream JsonFilterStream;
+typedef struct JsonFilterRunner JsonFilterRunner;
+
+/* what a runner hands back for one submission */
+typedef struct {
+    unsigned int generation;   /* the one it was submitted with */
+    char* output;              /* the matches as a json array, NULL on error, the caller frees it */
+    size_t output_size;
+    long match_count;          /* -1 when the expression or the json is broken */
+    bool truncated;            /* stopped at JSON_FILTER_OUTPUT_LIMIT */
+    char error[160];
+} JsonFilterResult;
+
+/*
+ * called once per matching value with its raw json text. ordinal is the
+ * position of the value in document order, nested matches are reported
+ * when they close so they can arrive before their parents. return nonzero
+ * to stop the evaluation early.
+ */
+typedef int (*JsonFilterMatchCallback)(const char* value, size_t length, size_t ordinal, void* userdata);
+
+/* query compilation */
+JsonFilterQuery* json_filter_compile(const char* expression, char* error, size_t error_size);
+void json_filter_query_destroy(JsonFilterQuery* query);
+const char* json_filter_query_expression(const JsonFilterQuery* query);
+
+/* shared cache of compiled queries, release every query you acquire */
+JsonFilterQuery* json_filter_cache_acquire(const char* expression, char* error, size_t error_size);
+void json_filter_cache_release(JsonFilterQuery* query);
+void json_filter_cache_clear(void);
+
+/* incremental evaluation over chunks of json */
+JsonFilterStream* json_filter_stream_create(const JsonFilterQuery* query, JsonFilterMatchCallback callback, void* userdata);
+void json_filter_stream_destroy(JsonFilterStream* stream);
+int json_filter_stream_feed(JsonFilterStream* stream, const char* data, size_t length);
+int json_filter_stream_finish(JsonFilterStream* stream);
+const char* json_filter_stream_error(const JsonFilterStream* stream);
+size_t json_filter_stream_match_count(const JsonFilterStream* stream);
+
+/* evaluates a whole buffer in one call, returns the number of matches or -1 */
+long json_filter_run(const JsonFilterQuery* query, const char* data, size_t length,
+                     JsonFilterMatchCallback callback, void* userdata,
+                     char* error, size_t error_size);
+
+/* background runs, the worker thread is started on first use */
+JsonFilterRunner* json_filter_runner_create(void);
+void json_filter_runner_destroy(JsonFilterRunner* runner);
+
+/* copies the expression and the json and queues them, stopping the run that is going */
+int json_filter_runner_submit(JsonFilterRunner* runner, unsigned int generation, const char* expression,
+                              const char* data, size_t length);
+
+/* moves the newest finished result out, returns false if nothing finished since the last call */
+bool json_filter_runner_take_result(JsonFilterRunner* runner, JsonFilterResult* result);
+
+/* true while a submission is queued or being filtered */
+bool json_filter_runner_is_pending(JsonFilterRunner* runner);
+
+void json_filter_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
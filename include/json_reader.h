@@ -0,0 +1,80 @@
+/**
+ * json_reader.h
+ *
+ * streaming json reader for tinyrequest
+ *
+ * building a cjson tree of a file holds every key and string of it in
+ * memory at once, on top of the text itself. the reader walks the text
+ * instead, with no tree at all: the caller steps through an object or an
+ * array member by member and reads each value straight into where it
+ * belongs, or skips it. nothing is allocated unless a value is asked for
+ * in a buffer of its own. the text does not need to be terminated, so a
+ * mapped file is read in place.
+ *
+ * the first error stops the reader, failed is set and every read after it
+ * comes back empty, so a walk can check once at the end. containers are
+ * entered with json_reader_enter and the caller lowers depth again once
+ * json_reader_next returned false for them.
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* deepest nesting the reader follows, the same limit cjson has */
+#define JSON_READER_MAX_DEPTH 1000
+
+typedef struct {
+    const char* cur;
+    const char* end;
+    bool failed;
+    int depth;
+} JsonReader;
+
+void json_reader_init(JsonReader* reader, const char* data, size_t length);
+void json_reader_fail(JsonReader* reader);
+
+/* next character that is not whitespace, 0 at the end */
+char json_reader_peek(JsonReader* reader);
+bool json_reader_consume(JsonReader* reader, char expected);
+
+/* compares a key without regard to case, the way cjson looks keys up.
+ * expected is lower case */
+bool json_key_is(const char* key, const char* expected);
+
+/* enters an object or array, open is '{' or '[' */
+bool json_reader_enter(JsonReader* reader, char open);
+
+/* call right after json_reader_enter. moves to the next member, returns false
+ * at the closing bracket or on an error. key may be NULL for arrays, a longer
+ * key is cut to key_size */
+bool json_reader_next(JsonReader* reader, char close, bool* first, char* key, size_t key_size);
+
+void json_reader_skip(JsonReader* reader);
+
+/* reads a string into a fixed field, cutting it to fit. length gets its
+ * untruncated size and may be NULL, dest may be NULL to just pass it */
+bool json_reader_string(JsonReader* reader, char* dest, size_t dest_size, size_t* length);
+
+/* reads a string into a buffer of its own, the caller frees it */
+char* json_reader_string_alloc(JsonReader* reader, size_t* length);
+
+bool json_reader_number(JsonReader* reader, double* value);
+bool json_reader_literal(JsonReader* reader, const char* literal);
+
+/* typed reads for object members, a value of another type is skipped and reported as missing */
+bool json_reader_string_field(JsonReader* reader, char* dest, size_t dest_size);
+bool json_reader_number_field(JsonReader* reader, double* value);
+bool json_reader_bool_field(JsonReader* reader, bool* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * json_validator.h
+ *
+ * background json validation for tinyrequest
+ *
+ * the json body editor used to parse its whole buffer on every frame just
+ * to print "valid json", which starts to show once bodies get large. the
+ * validator moves that parse onto a worker thread. the editor submits its
+ * text together with the buffer's edit generation once typing has settled,
+ * and reads back the newest result, which stays valid until the generation
+ * changes again.
+ *
+ * a failed parse reports where it failed as a byte offset and as a line
+ * and column, so the editor can point at the problem.
+ *
+ * only the newest submission is kept, anything submitted while a parse is
+ * running replaces what was waiting.
+ */
+
+#ifndef JSON_VALIDATOR_H
+#define JSON_VALIDATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned int generation; /* generation of the text that was checked */
+    bool valid;
+    size_t error_offset;     /* byte offset of the error in the text */
+    int error_line;          /* 1-based, 0 when the text is valid */
+    int error_column;        /* 1-based, counted in bytes */
+    char message[128];
+} JsonValidationResult;
+
+typedef struct JsonValidator JsonValidator;
+
+/* validator lifecycle */
+JsonValidator* json_validator_create(void);
+void json_validator_destroy(JsonValidator* validator);
+
+/* copies the text and queues it, replacing anything still waiting */
+int json_validator_submit(JsonValidator* validator, unsigned int generation, const char* text, size_t length);
+
+/* copies the newest finished result, returns false if nothing has finished yet */
+bool json_validator_get_result(JsonValidator* validator, JsonValidationResult* result);
+
+/* true while a submission is queued or being parsed */
+bool json_validator_is_pending(JsonValidator* validator);
+
+/* validates on the calling thread, for small inputs and callers without a validator */
+void json_validate_text(const char* text, size_t length, JsonValidationResult* result);
+
+void json_validator_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * mock_server.h
+ *
+ * local mock http server for tinyrequest
+ *
+ * serves the requests of a collection from 127.0.0.1 so a client can be
+ * built, tested and benchmarked without the real api or any network. each
+ * request of the collection becomes a route, matched on method and path.
+ * path segments written as ":id", "{id}" or "{{id}}" match any segment, a
+ * query string in the collection's url has to be there with the same
+ * values. the host of the url is ignored, when routes overlap the one
+ * with the most literal segments wins.
+ *
+ * a route answers with its example, the response last recorded in the
+ * history for that url or the one a HAR file holds for it. a route
+ * without an example answers 200 with an empty body, a path no route
+ * matches gets a 404. example bodies and header values are templates,
+ * {{method}}, {{path}}, {{body}}, {{now}}, {{seq}}, {{params.NAME}},
+ * {{query.NAME}} and {{header.NAME}} are replaced from the request being
+ * answered. anything else in braces is left as it is.
+ *
+ * latency, jitter and failures can be injected. whether a request fails
+ * and how long it waits follow from the seed and the order requests
+ * arrive in, two runs with the same seed inject the same errors.
+ *
+ * routes are added before mock_server_start and never change after it.
+ * the server listens on a thread of its own and answers on a pool of
+ * worker threads, everything else may be called from the ui thread. a
+ * kept-alive connection holds its worker while it is open, so the pool
+ * wants at least as many threads as the client keeps connections.
+ */
+
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "collections.h"
+#include "history_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_SERVER_DEFAULT_PORT 8089
+#define MOCK_SERVER_DEFAULT_THREADS 16
+#define MOCK_SERVER_MAX_THREADS 64
+
+/* longest a response is held back, latency and jitter together */
+#define MOCK_SERVER_MAX_DELAY_MS 60000
+
+typedef enum {
+    MOCK_SERVER_SUCCESS = 0,
+    MOCK_SERVER_ERROR_NULL_PARAM = -1,
+    MOCK_SERVER_ERROR_MEMORY_ALLOCATION = -2,
+    MOCK_SERVER_ERROR_INVALID_OPTIONS = -3,
+    MOCK_SERVER_ERROR_BIND = -4,            /* the port is taken or the address is not local */
+    MOCK_SERVER_ERROR_RUNNING = -5,         /* routes can not change once it started */
+    MOCK_SERVER_ERROR_FILE = -6             /* a HAR file could not be read */
+} MockServerError;
+
+typedef struct {
+    char host[64];              /* address to listen on, 127.0.0.1 by default */
+    int port;                   /* 0 picks a free one */
+    int threads;                /* requests answered at once */
+    int latency_ms;             /* every response waits this long */
+    int jitter_ms;              /* and up to this much longer */
+    double error_rate;          /* share of requests answered with error_status, 0 to 1 */
+    int error_status;
+    uint64_t seed;              /* decides which requests fail and their jitter */
+} MockServerOptions;
+
+typedef struct {
+    char method[16];
+    char path[512];             /* as matched, with its parameters */
+    bool has_example;
+    int status_code;            /* of the example, 200 without one */
+    uint64_t hits;
+} MockRouteInfo;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t matched;
+    uint64_t unmatched;
+    uint64_t errors_injected;
+} MockServerStats;
+
+typedef struct MockServer MockServer;
+
+void mock_server_options_init(MockServerOptions* options);
+
+/* a stopped server without routes, NULL when the options are out of range */
+MockServer* mock_server_create(const MockServerOptions* options);
+
+/* stops the server if it runs, waits for requests being answered and frees it */
+void mock_server_destroy(MockServer* server);
+
+/* adds a route for a request, example may be NULL. returns a MockServerError */
+int mock_server_add_route(MockServer* server, const char* method, const char* url, const Response* example);
+
+/* adds every request of the collection with the newest response history
+ * holds for its url. history may be NULL or still loading, the routes get
+ * no examples then. returns a MockServerError */
+int mock_server_add_collection(MockServer* server, Collection* collection, HistoryStore* history);
+
+/* adds every entry of a HAR file with its response, a later entry for the
+ * same method and url replaces an earlier one. returns a MockServerError */
+int mock_server_add_har_file(MockServer* server, const char* filepath);
+
+/* binds and starts answering. returns a MockServerError */
+int mock_server_start(MockServer* server);
+
+bool mock_server_is_running(MockServer* server);
+
+/* the port it listens on once started, the picked one for port 0 */
+int mock_server_get_port(MockServer* server);
+
+void mock_server_get_stats(MockServer* server, MockServerStats* stats);
+
+int mock_server_get_route_count(MockServer* server);
+bool mock_server_get_route(MockServer* server, int route_index, MockRouteInfo* info);
+
+const char* mock_server_error_string(int error);
+
+void mock_server_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,28 +26,58 @@
 extern "C" {
 #endif
 
+/* collection-level auth as it is written next to each collection, copied out
+ * of the app state so a collection can be serialized away from the ui thread */
+typedef struct {
+    int selected_auth_type;
+    char api_key_name[128];
+    char api_key_value[512];
+    char bearer_token[512];
+    char basic_username[256];
+    char basic_password[256];
+    char oauth_token[512];
+    int api_key_location;
+    bool api_key_enabled;
+    bool bearer_enabled;
+    bool basic_enabled;
+    bool oauth_enabled;
+} PersistenceAuth;
+
 int persistence_save_request(const Request* request, const char* name, const char* filename);
 int persistence_load_request(Request* request, const char* filename);
 
 int persistence_save_collection_new(const Collection* collection, const char* filepath);
 int persistence_save_collection_with_auth(const Collection* collection, const char* filepath, const void* app_state);
+void persistence_auth_from_app_state(PersistenceAuth* auth, const void* app_state);
+char* persistence_serialize_collection(const Collection* collection, const PersistenceAuth* auth);
 int persistence_load_collection_new(Collection* collection, const char* filepath);
 int persistence_load_collection_with_auth(Collection* collection, const char* filepath, void* app_state);
+int persistence_read_collection_file(Collection* collection, const char* filepath,
+                                     PersistenceAuth* auth, bool* has_auth);
+void persistence_apply_auth_to_app_state(const PersistenceAuth* auth, void* app_state);
 int persistence_export_collection(const Collection* collection, const char* filepath);
 int persistence_import_collection(Collection* collection, const char* filepath);
 
+typedef void (*PersistenceFileCallback)(const char* filepath, void* user_data);
+int persistence_for_each_collection_file(PersistenceFileCallback callback, void* user_data);
+
 int persistence_save_all_collections(const CollectionManager* manager);
 int persistence_save_all_collections_with_auth(const CollectionManager* manager, const void* app_state);
+int persistence_save_dirty_collections_with_auth(CollectionManager* manager, const void* app_state, int* written);
 int persistence_load_all_collections(CollectionManager* manager);
 int persistence_load_all_collections_with_auth(CollectionManager* manager, void* app_state);
 int persistence_save_collection_manager_state(const CollectionManager* manager);
+char* persistence_serialize_collection_manager_state(const CollectionManager* manager);
+unsigned long persistence_manager_state_hash(const CollectionManager* manager);
 int persistence_load_collection_manager_state(CollectionManager* manager);
+int persistence_load_collection_manifest(CollectionManager* manager);
 int persistence_delete_collection_file(const char* collection_id);
 
-int persistence_auto_save_collections(const CollectionManager* manager);
-int persistence_restore_from_auto_save(CollectionManager* manager);
-int persistence_create_auto_save_backup(const CollectionManager* manager);
-int persistence_cleanup_old_auto_saves(int keep_count);
+/* collection snapshots are json files, or binary store files (collection_store.h)
+ * when TINYREQUEST_COLLECTION_STORE=binary. loading takes either */
+char* persistence_get_collection_file_path(const char* collection_id);
+char* persistence_find_collection_file(const char* collection_id);
+int persistence_write_collection_snapshot(const Collection* collection, const PersistenceAuth* auth);
 
 int persistence_migrate_legacy_requests(CollectionManager* manager);
 int persistence_load_legacy_and_create_collection(CollectionManager* manager, const char* legacy_path);
@@ -57,6 +87,26 @@ int persistence_backup_legacy_data(void);
 int persistence_save_settings(const CollectionManager* manager, bool auto_save_enabled, int auto_save_interval);
 int persistence_load_settings(bool* auto_save_enabled, int* auto_save_interval);
 
+/* temp file, fsync and rename, so readers never see a partly written file */
+int persistence_write_file_atomic(const char* filepath, const char* data, size_t length);
+
+/* a whole file mapped read only. files are replaced with a rename, never
+ * truncated in place, so the mapping stays valid while it is open */
+typedef struct {
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+} PersistenceMappedFile;
+
+/* maps filepath, sequential tells the os it is read front to back once.
+ * an empty file is PERSISTENCE_ERROR_CORRUPTED_DATA. returns a PersistenceError */
+int persistence_map_file(PersistenceMappedFile* mapped, const char* filepath, bool sequential);
+void persistence_unmap_file(PersistenceMappedFile* mapped);
+void persistence_sync_parent_directory(const char* filepath);
+
 int persistence_create_config_dir(void);
 int persistence_create_collections_dir(void);
 int persistence_create_auto_save_dir(void);
@@ -79,7 +129,8 @@ typedef enum {
     PERSISTENCE_ERROR_MEMORY_ALLOCATION = -5,
     PERSISTENCE_ERROR_CORRUPTED_DATA = -6,
     PERSISTENCE_ERROR_DISK_FULL = -7,
-    PERSISTENCE_ERROR_INVALID_PATH = -8
+    PERSISTENCE_ERROR_INVALID_PATH = -8,
+    PERSISTENCE_ERROR_CANCELLED = -9
 } PersistenceError;
 
 const char* persistence_error_string(PersistenceError error);
@@ -0,0 +1,113 @@
+/**
+ * persistence_worker.h
+ *
+ * background saving for tinyrequest
+ *
+ * saves used to build the json and write it with fopen and fwrite on the
+ * ui thread, so a slow disk stalled the frame and a crash halfway through
+ * a write left a truncated collection behind. the worker moves both off the
+ * ui thread. the caller hands it a snapshot - a deep copy of the collection
+ * plus the auth fields it is written with - and keeps going. one thread
+ * serializes the snapshots and writes them through
+ * persistence_write_file_atomic, so every file on disk is either the old
+ * version or the new one.
+ *
+ * bursts of saves are coalesced. a collection has at most one snapshot in
+ * the queue and a newer one replaces it in place, and a job sits in the
+ * queue for a short moment before it is written so a quick run of edits
+ * becomes one write. deleting a collection file goes through the same
+ * queue, so it can never be overtaken by an older save of that collection.
+ *
+ * journal records (see collection_journal.h) go through the worker too.
+ * they are never coalesced and skip the coalescing window, so an edit is
+ * on disk a moment after it is made. after a snapshot is written the
+ * journal records it contains are trimmed.
+ *
+ * the auto-save snapshot (see snapshot_store.h) is taken by the worker as
+ * well. it is queued behind the saves it should contain, so it records the
+ * collections as they were when it was asked for.
+ *
+ * every finished job is reported back through persistence_worker_poll,
+ * with the generation its snapshot was taken at so the ui can mark exactly
+ * that state as saved. the ui is woken through wake_signal_post.
+ */
+
+#ifndef PERSISTENCE_WORKER_H
+#define PERSISTENCE_WORKER_H
+
+#include <stdbool.h>
+#include "collections.h"
+#include "persistence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* how long a job waits in the queue for newer snapshots before it is written */
+#define PERSISTENCE_WORKER_COALESCE_MS 150
+
+typedef enum {
+    PERSISTENCE_JOB_SAVE_COLLECTION = 0,
+    PERSISTENCE_JOB_SAVE_MANAGER_STATE,
+    PERSISTENCE_JOB_DELETE_COLLECTION,
+    PERSISTENCE_JOB_APPEND_JOURNAL,
+    PERSISTENCE_JOB_AUTO_SNAPSHOT
+} PersistenceJobKind;
+
+/* one finished job, handed back to the ui */
+typedef struct {
+    int kind;                   /* PersistenceJobKind */
+    char collection_id[64];     /* empty for the manager state */
+    unsigned int generation;    /* collection generation the snapshot was taken at */
+    unsigned long journal_seq;  /* last journal record a collection snapshot contains */
+    int result;                 /* PersistenceError */
+    double duration_ms;         /* serializing and writing */
+} PersistenceCompletion;
+
+typedef struct PersistenceWorker PersistenceWorker;
+
+/* worker lifecycle, the thread is started on first use. destroying the
+ * worker writes everything still queued before it returns */
+PersistenceWorker* persistence_worker_create(void);
+void persistence_worker_destroy(PersistenceWorker* worker);
+
+/* queues a snapshot of the collection. returns 1 when a snapshot was queued,
+ * 0 when this generation is already queued or being written, -1 on failure */
+int persistence_worker_save_collection(PersistenceWorker* worker, const Collection* collection,
+                                       const PersistenceAuth* auth);
+
+/* queues collections_state.json, returns 0 on success */
+int persistence_worker_save_manager_state(PersistenceWorker* worker, const CollectionManager* manager);
+
+/* queues journal records for a collection, taking ownership of them. returns 0 on success */
+int persistence_worker_append_journal(PersistenceWorker* worker, const char* collection_id,
+                                      unsigned int generation, char* records, size_t length);
+
+/* queues removing a collection file and its journal, replacing any save of it still waiting */
+int persistence_worker_delete_collection(PersistenceWorker* worker, const char* collection_id);
+
+/* queues an auto-save snapshot of what is on disk once everything queued
+ * before it is written, then rotates the snapshots. returns 0 on success */
+int persistence_worker_snapshot(PersistenceWorker* worker);
+
+/* queues every dirty collection and the manager state when it moved.
+ * returns the number of collection snapshots queued or -1 */
+int persistence_worker_save_dirty(PersistenceWorker* worker, const CollectionManager* manager,
+                                  const void* app_state);
+
+/* takes the oldest finished job, returns false if there is none */
+bool persistence_worker_poll(PersistenceWorker* worker, PersistenceCompletion* completion);
+
+/* jobs queued or being written */
+int persistence_worker_get_pending_count(PersistenceWorker* worker);
+
+/* writes everything queued right away and waits until it is on disk */
+void persistence_worker_flush(PersistenceWorker* worker);
+
+void persistence_worker_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * profiler.h
+ *
+ * frame and subsystem timing for tinyrequest
+ *
+ * a small always-compiled profiler for finding ui jank. the main loop marks
+ * the start and end of every frame, and interesting pieces of work are
+ * wrapped in named scopes. samples go into a ring of recent frames, which
+ * the profiler overlay reads to draw frame time graphs and per-scope
+ * breakdowns, and which can be written out as a chrome trace for
+ * chrome://tracing or perfetto.
+ *
+ * recording is off until profiler_set_enabled turns it on, a disabled scope
+ * costs one branch. everything here is meant for the ui thread only.
+ *
+ * scope names must be string literals or otherwise outlive the profiler,
+ * only the pointer is stored.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROFILER_FRAME_HISTORY 300
+#define PROFILER_MAX_SAMPLES_PER_FRAME 64
+#define PROFILER_MAX_DEPTH 16
+#define PROFILER_MAX_SCOPES 32
+
+/* one timed scope inside a frame */
+typedef struct {
+    const char* name;
+    double start_ms;    /* relative to the frame start */
+    double duration_ms;
+    int depth;
+} ProfilerSample;
+
+/* one recorded frame */
+typedef struct {
+    double start_ms;    /* relative to when recording started */
+    double duration_ms;
+    int sample_count;
+    ProfilerSample samples[PROFILER_MAX_SAMPLES_PER_FRAME];
+} ProfilerFrame;
+
+/* totals for one scope name over the recorded frames */
+typedef struct {
+    const char* name;
+    int calls;
+    int frames;         /* frames the scope appeared in */
+    double total_ms;
+    double max_ms;
+} ProfilerScopeStats;
+
+/* recording */
+void profiler_set_enabled(bool enabled);
+bool profiler_is_enabled(void);
+void profiler_reset(void);
+
+/* frame and scope markers */
+void profiler_frame_begin(void);
+void profiler_frame_end(void);
+int profiler_scope_begin(const char* name);
+void profiler_scope_end(int token);
+
+/* reading the history, oldest frame first */
+int profiler_get_frame_count(void);
+const ProfilerFrame* profiler_get_frame(int index);
+int profiler_get_frame_times(float* times, int max_count);
+double profiler_get_frame_percentile(double percentile);
+int profiler_get_scope_stats(ProfilerScopeStats* stats, int max_count);
+
+/* writes the recorded frames as chrome trace json, returns 0 on success */
+int profiler_export_chrome_trace(const char* path);
+
+/* the most memory the process has held so far, in kilobytes, or -1 where
+ * the platform does not say */
+long profiler_get_peak_rss_kb(void);
+
+#ifdef __cplusplus
+}
+
+/* times the rest of the enclosing block */
+class ProfilerScope {
+public:
+    explicit ProfilerScope(const char* name) : token_(profiler_scope_begin(name)) {}
+    ~ProfilerScope() { profiler_scope_end(token_); }
+    ProfilerScope(const ProfilerScope&) = delete;
+    ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+private:
+    int token_;
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfilerScope PROFILER_CONCAT(profiler_scope_, __LINE__)(name)
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * request_engine.h
+ *
+ * background request execution for tinyrequest
+ *
+ * sending a request used to block the ui thread until the server answered,
+ * so only one request could be in flight at a time. the engine runs
+ * transfers on a small pool of worker threads instead. every worker owns
+ * its own http client, and the workers share one curl connection, dns and
+ * tls session cache so a second request to the same host skips the
+ * handshake no matter which worker picks it up.
+ *
+ * the caller submits a copy of a request and gets a transfer id back. the
+ * ui polls the transfer once per frame for progress and takes the response
+ * when it is done. a transfer can be cancelled, and a released transfer is
+ * cleaned up by the engine on its own once the worker lets go of it.
+ *
+ * the ui is woken through wake_signal_post whenever a transfer makes
+ * progress or finishes.
+ */
+
+#ifndef REQUEST_ENGINE_H
+#define REQUEST_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "request_response.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REQUEST_ENGINE_DEFAULT_WORKERS 4
+#define REQUEST_ENGINE_MAX_WORKERS 16
+#define REQUEST_ENGINE_MAX_TRANSFERS 64
+
+typedef enum {
+    REQUEST_TRANSFER_QUEUED = 0,
+    REQUEST_TRANSFER_RUNNING,
+    REQUEST_TRANSFER_DONE,
+    REQUEST_TRANSFER_CANCELLED
+} RequestTransferState;
+
+/* a snapshot of one transfer for the ui */
+typedef struct {
+    int state;                  /* RequestTransferState */
+    double downloaded;          /* bytes received so far */
+    double download_total;      /* expected bytes, 0 when the server did not say */
+    double elapsed_ms;          /* time since a worker picked the transfer up */
+} RequestTransferProgress;
+
+typedef struct RequestEngine RequestEngine;
+
+/* engine lifecycle, workers are started on first use */
+RequestEngine* request_engine_create(int worker_count);
+void request_engine_destroy(RequestEngine* engine);
+
+/* applies to transfers submitted after the call */
+void request_engine_set_ssl_verification(RequestEngine* engine, bool verify);
+
+/* queues a copy of the request, returns a transfer id above 0 or -1 */
+int request_engine_submit(RequestEngine* engine, const Request* request);
+
+/* fills in the progress of a transfer, returns -1 for an unknown id */
+int request_engine_get_progress(RequestEngine* engine, int transfer_id, RequestTransferProgress* progress);
+
+/* moves the response of a finished transfer out and forgets the id.
+ * returns 1 when taken, 0 while still queued or running, -1 for an unknown id.
+ * result gets what http_client_send_request returned */
+int request_engine_take_response(RequestEngine* engine, int transfer_id, Response* response, int* result);
+
+/* asks a transfer to stop, it still has to be taken or released */
+void request_engine_cancel(RequestEngine* engine, int transfer_id);
+
+/* cancels a transfer nobody is waiting for, the engine frees it when the worker is done */
+void request_engine_release(RequestEngine* engine, int transfer_id);
+
+/* number of transfers queued or running */
+int request_engine_get_active_count(RequestEngine* engine);
+
+void request_engine_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
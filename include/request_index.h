@@ -0,0 +1,67 @@
+/**
+ * request_index.h
+ *
+ * search index over saved requests for tinyrequest
+ *
+ * the collections panel filters requests as you type. scanning every saved
+ * request on each keystroke is fine for a few hundred but not for the tens
+ * of thousands an imported collection can hold, so the index keeps a
+ * trigram posting list for the method, name and url of every request. a
+ * query only looks at requests that contain all of its trigrams and then
+ * checks those for the actual text.
+ *
+ * the index follows the collections instead of being rebuilt, each
+ * collection's generation tells it which ones changed since the last sync
+ * and only requests whose text differs are re-indexed. adding or removing
+ * requests shifts positions, so that still rebuilds everything.
+ *
+ * queries are split on spaces and every term has to appear, in any order
+ * and case-insensitively, so "post users" finds "POST /api/users/{id}".
+ */
+
+#ifndef REQUEST_INDEX_H
+#define REQUEST_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "collections.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REQUEST_INDEX_MAX_TERMS 8
+
+typedef struct {
+    int collection_index;
+    int request_index;
+} RequestIndexMatch;
+
+typedef struct RequestIndex RequestIndex;
+
+/* index lifecycle */
+RequestIndex* request_index_create(void);
+void request_index_destroy(RequestIndex* index);
+
+/* brings the index up to date with the collections, cheap when nothing changed */
+int request_index_sync(RequestIndex* index, CollectionManager* manager);
+
+/* re-reads one request, for edits that bypass the collection functions */
+int request_index_refresh_request(RequestIndex* index, CollectionManager* manager,
+                                  int collection_index, int request_index);
+
+/* finds requests matching every term, in collection order, returns the count or -1 */
+int request_index_search(RequestIndex* index, const char* query, const RequestIndexMatch** matches);
+
+int request_index_get_document_count(RequestIndex* index);
+
+/* changes whenever any document does, search results older than this are stale */
+unsigned int request_index_get_generation(RequestIndex* index);
+
+void request_index_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
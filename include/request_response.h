@@ -23,6 +23,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -67,6 +68,48 @@ typedef struct {
   bool auth_oauth_enabled;   /* Whether to send OAuth 2.0 auth */
 } Request;
 
+/* what a response body contains, decided once when the body arrives */
+typedef enum {
+  RESPONSE_KIND_EMPTY = 0,
+  RESPONSE_KIND_TEXT,
+  RESPONSE_KIND_JSON,
+  RESPONSE_KIND_XML,
+  RESPONSE_KIND_HTML,
+  RESPONSE_KIND_IMAGE,
+  RESPONSE_KIND_BINARY
+} ResponseKind;
+
+/* facts about a response that the ui would otherwise work out every frame */
+typedef struct {
+  bool valid;          /* false until response_compute_meta runs on this body */
+  int kind;            /* ResponseKind */
+  char mime_type[128]; /* lowercase media type without parameters */
+  char charset[32];    /* lowercase charset parameter, empty if not given */
+  char encoding[32];   /* content-encoding header, empty if not compressed */
+  size_t line_count;   /* number of lines in the body */
+  unsigned int generation; /* new for every body described, tells one response from the next */
+} ResponseMeta;
+
+/* where the time of a transfer went and what went over the wire, as libcurl
+ * measured it. phases that did not happen, like dns and connect on a reused
+ * connection, are -1. connect includes ssl, the way HAR counts it */
+typedef struct {
+  bool valid;                /* false unless the response came from libcurl */
+  int64_t started_at_ms;     /* unix time the transfer started, in milliseconds */
+  double dns_ms;
+  double connect_ms;
+  double ssl_ms;
+  double send_ms;
+  double wait_ms;            /* request sent until the first byte came back */
+  double receive_ms;
+  long request_header_size;  /* bytes of request headers sent */
+  long response_header_size; /* bytes of response headers received, status lines included */
+  int64_t download_size;     /* response body bytes as they came, before decoding */
+  char http_version[16];     /* "HTTP/1.1", "HTTP/2" */
+  char server_ip[48];
+  long local_port;           /* tells connections apart */
+} ResponseTimings;
+
 /* complete http response with all the parts */
 typedef struct {
   int status_code;      /* http status code like 200, 404, etc. */
@@ -77,6 +120,8 @@ typedef struct {
   double response_time; /* how long the request took in milliseconds */
   int is_truncated;     /* whether response was cut off due to size limits */
   size_t total_size;    /* total size if known from content-length header */
+  ResponseMeta meta;    /* cached description of the body, see response_get_meta */
+  ResponseTimings timings; /* per phase timings and wire sizes */
 } Response;
 
 /* error codes for when things go wrong */
@@ -127,6 +172,9 @@ void request_init(Request *request);
 /* cleans up a request's contents but doesn't free the struct itself */
 void request_cleanup(Request *request);
 
+/* deep copies a request into an uninitialized one */
+int request_copy(Request *dest, const Request *src);
+
 /* sets the body content for a request */
 int request_set_body(Request *request, const char *body, size_t size);
 
@@ -145,6 +193,12 @@ void response_cleanup(Response *response);
 /* sets the body content for a response */
 int response_set_body(Response *response, const char *body, size_t size);
 
+/* works out the response metadata from its headers and body */
+void response_compute_meta(Response *response);
+
+/* returns the cached metadata, computing it first if the body changed */
+const ResponseMeta *response_get_meta(Response *response);
+
 /* converts an error code to a human-readable string */
 const char *request_response_error_string(RequestResponseError error);
 
@@ -0,0 +1,119 @@
+/**
+ * response_diff.h
+ *
+ * comparing two responses for tinyrequest
+ *
+ * when tuning an endpoint you want to know the response did not change, so
+ * this module diffs two bodies on a background thread. the line diff hashes
+ * lines in parallel, drops lines that only exist on one side (they can never
+ * be part of the common subsequence) and runs a linear-space myers diff over
+ * what is left. a cost cap keeps pathological inputs from running away, the
+ * diff stays correct but may be a little longer than the minimal one.
+ *
+ * for json bodies there is also a structural diff that walks both parsed
+ * documents and reports added, removed and changed values by path, so
+ * reordered keys or different formatting do not show up as changes.
+ *
+ * the diff copies both inputs, the responses can go away while it runs.
+ * results are only readable once response_diff_is_running returns false.
+ */
+
+#ifndef RESPONSE_DIFF_H
+#define RESPONSE_DIFF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "request_response.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESPONSE_DIFF_MAX_WORKERS 8
+#define RESPONSE_DIFF_MAX_JSON_ENTRIES 100000
+
+typedef enum {
+    RESPONSE_DIFF_MODE_LINES = 0,
+    RESPONSE_DIFF_MODE_JSON = 1
+} ResponseDiffMode;
+
+typedef enum {
+    RESPONSE_DIFF_LEFT = 0,
+    RESPONSE_DIFF_RIGHT = 1
+} ResponseDiffSide;
+
+/* one row of the side-by-side view, a missing side has line -1 */
+typedef enum {
+    DIFF_ROW_EQUAL = 0,
+    DIFF_ROW_CHANGED,
+    DIFF_ROW_DELETED,
+    DIFF_ROW_INSERTED
+} DiffRowKind;
+
+typedef struct {
+    int left_line;
+    int right_line;
+    int kind;
+} DiffRow;
+
+/* one difference found by the structural json diff */
+typedef enum {
+    JSON_DIFF_ADDED = 0,
+    JSON_DIFF_REMOVED,
+    JSON_DIFF_CHANGED
+} JsonDiffKind;
+
+typedef struct {
+    int kind;
+    char path[256];
+    char left[128];
+    char right[128];
+} JsonDiffEntry;
+
+/* one header that differs between two responses */
+typedef struct {
+    int kind; /* JsonDiffKind */
+    char name[128];
+    char left[512];
+    char right[512];
+} HeaderDiffEntry;
+
+typedef struct ResponseDiff ResponseDiff;
+
+/* diff lifecycle */
+ResponseDiff* response_diff_create(void);
+void response_diff_destroy(ResponseDiff* diff);
+
+/* starts a new diff, cancelling any diff that is still running */
+int response_diff_start(ResponseDiff* diff, const char* left, size_t left_size,
+                        const char* right, size_t right_size, int mode);
+void response_diff_cancel(ResponseDiff* diff);
+
+/* status */
+bool response_diff_is_running(ResponseDiff* diff);
+unsigned int response_diff_get_generation(ResponseDiff* diff);
+const char* response_diff_get_error(ResponseDiff* diff);  /* "" without an error, like response_search_get_error */
+double response_diff_get_elapsed_ms(ResponseDiff* diff);
+int response_diff_get_mode(ResponseDiff* diff);
+
+/* line diff results */
+const DiffRow* response_diff_get_rows(ResponseDiff* diff, int* count);
+int response_diff_get_hunk_count(ResponseDiff* diff);
+int response_diff_get_hunk_row(ResponseDiff* diff, int hunk);
+const char* response_diff_get_line(ResponseDiff* diff, int side, int line, size_t* length);
+void response_diff_get_stats(ResponseDiff* diff, int* added, int* removed, int* changed);
+
+/* structural json diff results */
+const JsonDiffEntry* response_diff_get_json_entries(ResponseDiff* diff, int* count);
+bool response_diff_is_truncated(ResponseDiff* diff);
+
+/* compares two header lists by name, returns the number of entries or -1, free the array */
+int response_diff_headers(const HeaderList* left, const HeaderList* right, HeaderDiffEntry** entries);
+
+void response_diff_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
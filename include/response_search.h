@@ -0,0 +1,86 @@
+/**
+ * response_search.h
+ *
+ * incremental full-text search over response bodies for tinyrequest
+ *
+ * searching a big response on the ui thread would freeze the whole app, so
+ * this module splits the body into chunks and scans them on worker threads.
+ * matches are published as soon as a worker finds them, which means the ui
+ * can show the first hit long before the whole body has been scanned.
+ *
+ * plain substring search leans on memchr to skip ahead to candidate bytes
+ * and only then compares the rest of the pattern. case-insensitive search
+ * uses a folding table instead. regex search uses posix regular expressions
+ * and works line by line, so a regex match never spans a newline.
+ *
+ * the search keeps its own copy of the text it was given, so the response
+ * can be replaced or freed while workers are still running. the copy is
+ * made once per text, a new pattern searches it again without copying.
+ * a worker also indexes where lines start in it, so matches can be turned
+ * into line and column without scanning from the start of the body.
+ */
+
+#ifndef RESPONSE_SEARCH_H
+#define RESPONSE_SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESPONSE_SEARCH_MAX_PATTERN 256
+#define RESPONSE_SEARCH_MAX_WORKERS 8
+#define RESPONSE_SEARCH_MAX_MATCHES 1000000
+
+/* options that change how the pattern is matched */
+typedef enum {
+    RESPONSE_SEARCH_FLAG_NONE = 0,
+    RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE = 1 << 0,
+    RESPONSE_SEARCH_FLAG_REGEX = 1 << 1
+} ResponseSearchFlags;
+
+/* a single match as a byte range into the searched text */
+typedef struct {
+    size_t offset;
+    size_t length;
+} SearchMatch;
+
+/* opaque search state, owns its worker threads and match lists */
+typedef struct ResponseSearch ResponseSearch;
+
+/* search lifecycle */
+ResponseSearch* response_search_create(void);
+void response_search_destroy(ResponseSearch* search);
+
+/* copies the text later searches run on, cancelling any search that is still running */
+int response_search_set_text(ResponseSearch* search, const char* text, size_t text_size);
+
+/* starts a new search of the text last set, cancelling any search that is still running */
+int response_search_start(ResponseSearch* search, const char* pattern, int flags);
+void response_search_cancel(ResponseSearch* search);
+
+/* results, safe to call while workers are still running */
+int response_search_get_match_count(ResponseSearch* search);
+int response_search_get_match(ResponseSearch* search, int index, SearchMatch* match);
+int response_search_find_next_index(ResponseSearch* search, size_t offset);
+bool response_search_is_running(ResponseSearch* search);
+bool response_search_is_truncated(ResponseSearch* search);
+unsigned int response_search_get_generation(ResponseSearch* search);
+const char* response_search_get_error(ResponseSearch* search);
+
+/* zero based line and column of a byte offset, -1 while the line index is still being built */
+int response_search_locate(ResponseSearch* search, size_t offset, size_t* line, size_t* column);
+
+/* lines in the text, 0 while the line index is still being built */
+size_t response_search_get_line_count(ResponseSearch* search);
+
+/* returns true if this build supports RESPONSE_SEARCH_FLAG_REGEX */
+bool response_search_regex_supported(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * snapshot_store.h
+ *
+ * auto-save snapshots for tinyrequest
+ *
+ * a snapshot is every collection file, its journal and collections_state.json
+ * as they were on disk at one moment. the files themselves are stored once
+ * per distinct content in auto_save/objects, named by a hash of their bytes
+ * and their length, and a snapshot is a small manifest in auto_save/snapshots
+ * listing which object each file was. a collection that did not change since
+ * the last snapshot points at the object it already has, so it costs a line
+ * in the manifest and nothing else, and the objects directory only grows by
+ * the files that were actually edited.
+ *
+ * a file whose size and modification time match the last manifest is not
+ * even read again, unless it was modified in the same second that manifest
+ * was taken. a snapshot identical to the newest one is not written at all.
+ *
+ * rotation keeps the newest manifests and drops an object once no kept
+ * manifest refers to it any more. restoring a snapshot copies its objects
+ * back over the collections directory, it never parses a collection.
+ *
+ * everything here reads and writes the collection files, so it runs on the
+ * persistence worker thread while the app is up (see persistence_worker.h).
+ * a restore has to happen while tinyrequest is not running, the app would
+ * write its own collections back over it.
+ */
+
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* snapshots kept by the auto-save rotation */
+#define SNAPSHOT_STORE_KEEP 20
+
+/* one snapshot, as listed */
+typedef struct {
+    char name[64];          /* manifest name, what snapshot_store_restore takes */
+    int64_t created_at;     /* unix time in seconds */
+    int collection_count;
+} SnapshotInfo;
+
+/* takes a snapshot of the collections on disk. name gets the new manifest's
+ * name, or the newest one's when nothing changed and no snapshot was written,
+ * and may be null. returns a PersistenceError */
+int snapshot_store_create(char* name, size_t name_size, bool* created);
+
+/* keeps the newest keep_count snapshots and drops objects nothing refers to.
+ * returns a PersistenceError */
+int snapshot_store_rotate(int keep_count);
+
+/* lists the snapshots newest first into a malloc'd array the caller frees.
+ * returns a PersistenceError */
+int snapshot_store_list(SnapshotInfo** snapshots, int* count);
+
+/* puts the collections back the way a snapshot has them. the current state
+ * is snapshotted first, so a restore can itself be undone. returns a
+ * PersistenceError */
+int snapshot_store_restore(const char* name);
+
+void snapshot_store_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * text_buffer.h
+ *
+ * growable text storage for tinyrequest
+ *
+ * request bodies used to live in fixed 8 KB arrays, so anything larger was
+ * cut off in the editor. a text buffer is a nul-terminated string that
+ * grows on demand, with its length kept alongside so callers never have to
+ * strlen a multi-megabyte body. capacity grows geometrically, so typing
+ * into a large body does not reallocate on every keystroke.
+ *
+ * the data pointer is always valid once the buffer is initialized, an
+ * empty buffer points at an empty string, so it can be handed straight to
+ * code that expects a c string.
+ *
+ * every change bumps the buffer's generation, so work derived from the
+ * text, like validation, can be cached and redone only after an edit.
+ */
+
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* same limit request_set_body enforces */
+#define TEXT_BUFFER_MAX_SIZE (50 * 1024 * 1024)
+
+typedef struct {
+    char* data;       /* nul-terminated, never NULL after init */
+    size_t length;    /* bytes before the terminator */
+    size_t capacity;  /* bytes allocated, including the terminator */
+    unsigned int generation; /* bumped by every change to the content */
+} TextBuffer;
+
+/* buffer lifecycle */
+void text_buffer_init(TextBuffer* buffer);
+void text_buffer_cleanup(TextBuffer* buffer);
+
+/* makes room for at least capacity bytes including the terminator */
+int text_buffer_reserve(TextBuffer* buffer, size_t capacity);
+
+/* content changes, all return 0 on success and leave the buffer intact on failure */
+int text_buffer_set(TextBuffer* buffer, const char* text, size_t length);
+int text_buffer_set_cstr(TextBuffer* buffer, const char* text);
+int text_buffer_append(TextBuffer* buffer, const char* text, size_t length);
+int text_buffer_appendf(TextBuffer* buffer, const char* format, ...);
+void text_buffer_clear(TextBuffer* buffer);
+
+/* for code that edited data in place and knows the new length */
+void text_buffer_set_length(TextBuffer* buffer, size_t length);
+
+bool text_buffer_equals(const TextBuffer* buffer, const char* text, size_t length);
+
+void text_buffer_set_out_of_memory_handler(void (*handler)(const char* operation));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
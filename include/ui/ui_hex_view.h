@@ -0,0 +1,74 @@
+/**
+ * ui_hex_view.h
+ *
+ * hex and ascii viewer for binary data in tinyrequest
+ *
+ * binary responses like images, protobuf or octet-stream downloads can't be
+ * shown as text - imgui stops drawing at the first nul byte and everything
+ * else turns into noise. this widget shows the bytes as a classic hex dump
+ * with offsets, hex columns and a printable ascii column.
+ *
+ * only the rows that are actually on screen get formatted, so the cost per
+ * frame is the same for a 100 byte body and a multi-gigabyte one. imgui
+ * scrolls in floats, which stop telling rows apart after a few million, so
+ * bodies larger than HEX_VIEW_PAGE_SIZE are shown through a window of that
+ * many bytes with the offsets still counted from the start of the body.
+ * scrolling near either end of the window slides it on by half a page, so
+ * the body scrolls through without a seam and a dragged selection can run
+ * across any number of pages. it also supports selecting a byte range with
+ * the mouse, copying the selection and jumping straight to an offset.
+ */
+
+#ifndef UI_HEX_VIEW_H
+#define UI_HEX_VIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEX_VIEW_BYTES_PER_ROW 16
+#define HEX_VIEW_NO_OFFSET ((size_t)-1)
+
+/* bytes scrolled through at once, a million rows keep the float scroll position within a pixel or two */
+#define HEX_VIEW_PAGE_ROWS (1024 * 1024)
+#define HEX_VIEW_PAGE_SIZE ((size_t)HEX_VIEW_PAGE_ROWS * HEX_VIEW_BYTES_PER_ROW)
+
+/* the window slides by half a page, so the rows around the edge stay on screen */
+#define HEX_VIEW_PAGE_STEP (HEX_VIEW_PAGE_SIZE / 2)
+
+/* per-view state, zero it with ui_hex_view_reset before first use */
+typedef struct {
+    size_t selection_anchor;
+    size_t selection_cursor;
+    bool has_selection;
+    bool dragging;
+
+    size_t highlight_offset;
+    size_t highlight_length;
+    size_t scroll_to_offset;
+    size_t page_offset;         /* first byte of the window on screen, a multiple of HEX_VIEW_PAGE_STEP */
+
+    char goto_buffer[32];
+} HexViewState;
+
+void ui_hex_view_reset(HexViewState* view);
+
+/* draws the viewer filling the given size, like ImGui::BeginChild */
+void ui_hex_view_render(const char* id, const unsigned char* data, size_t size,
+                        HexViewState* view, float width, float height);
+
+/* draws the goto field and copy buttons for a view */
+void ui_hex_view_render_toolbar(const unsigned char* data, size_t size, HexViewState* view);
+
+/* helpers for callers that want to move the view themselves */
+void ui_hex_view_scroll_to(HexViewState* view, size_t offset);
+void ui_hex_view_set_highlight(HexViewState* view, size_t offset, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
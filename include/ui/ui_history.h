@@ -0,0 +1,30 @@
+/**
+ * ui_history.h
+ *
+ * request history window for tinyrequest
+ *
+ * a floating window, toggled with ctrl+h, listing every request sent with
+ * its status, duration and size, newest first. only the rows on screen are
+ * read from the history store, so a million entries scroll like a hundred.
+ * the list can be narrowed to one url or jumped to a day, and a selected
+ * entry shows its headers and body and can be opened in the response view.
+ * the whole history, a range of days or one url can be exported as HAR.
+ */
+
+#ifndef UI_HISTORY_H
+#define UI_HISTORY_H
+
+#include "app_state.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ui_history_toggle(AppState* state);
+void ui_history_render(AppState* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
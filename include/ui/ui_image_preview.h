@@ -0,0 +1,39 @@
+/**
+ * ui_image_preview.h
+ *
+ * image response preview for tinyrequest
+ *
+ * image bodies are handed to the background decoder and shown once their
+ * pixels have been uploaded to a gl texture. textures live in a small lru
+ * cache keyed by the response, so flipping back to an image that was
+ * already seen shows it straight away instead of decoding it again.
+ *
+ * at most one texture is uploaded per frame and nothing here blocks on the
+ * decoder, a frame where the image is not ready yet just shows a spinner.
+ */
+
+#ifndef UI_IMAGE_PREVIEW_H
+#define UI_IMAGE_PREVIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMAGE_PREVIEW_CACHE_SIZE 8
+
+/* draws the image for key, submitting the data for decoding if it is not cached */
+void ui_image_preview_render(const char* id, uint64_t key, const char* data, size_t size,
+                             float width, float height);
+
+/* frees all textures and stops the decoder, needs the gl context */
+void ui_image_preview_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
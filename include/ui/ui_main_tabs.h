@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 void ui_main_tabs_render(UIManager* ui, AppState* state);
+void ui_main_tabs_cleanup(void);
 
 void ui_main_tabs_render_collections_tab(UIManager* ui, AppState* state);
 void ui_main_tabs_render_request_tab(UIManager* ui, AppState* state);
@@ -47,6 +48,7 @@ void ui_collections_render_collection_node(UIManager* ui, AppState* state, const
 void ui_collections_render_request_node(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme, int collection_index, int request_index);
 
 void ui_collections_render_create_dialog(UIManager* ui, AppState* state);
+void ui_collections_render_import_dialog(UIManager* ui, AppState* state);
 void ui_collections_render_rename_dialog(UIManager* ui, AppState* state);
 void ui_collections_render_request_create_dialog(UIManager* ui, AppState* state);
 
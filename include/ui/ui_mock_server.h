@@ -0,0 +1,28 @@
+/**
+ * ui_mock_server.h
+ *
+ * mock server window for tinyrequest
+ *
+ * a floating window, toggled with ctrl+m, that serves a collection on
+ * localhost with the responses history recorded for it. latency, jitter
+ * and injected errors are set before starting. while it runs the window
+ * shows each route with how often it was hit.
+ */
+
+#ifndef UI_MOCK_SERVER_H
+#define UI_MOCK_SERVER_H
+
+#include "app_state.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ui_mock_server_toggle(AppState* state);
+void ui_mock_server_render(AppState* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * ui_profiler.h
+ *
+ * profiler overlay for tinyrequest
+ *
+ * a floating window, toggled with f12, that shows how long recent frames
+ * took and where the time went. recording runs only while the overlay is
+ * open. the recorded frames can be saved as a chrome trace next to the
+ * config files to attach to a bug report.
+ */
+
+#ifndef UI_PROFILER_H
+#define UI_PROFILER_H
+
+#include "app_state.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ui_profiler_toggle(AppState* state);
+void ui_profiler_render(AppState* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
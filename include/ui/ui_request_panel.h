@@ -40,6 +40,8 @@ void ui_request_panel_render_headers_panel(UIManager* ui, AppState* state, Heade
 
 void ui_request_panel_handle_keyboard_shortcuts(UIManager* ui, AppState* state);
 
+void ui_request_panel_cleanup(void);
+
 #ifdef __cplusplus
 }
 #endif
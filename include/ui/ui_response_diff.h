@@ -0,0 +1,29 @@
+/**
+ * ui_response_diff.h
+ *
+ * "compare with previous" view for tinyrequest
+ *
+ * shows how the current response differs from the one before it - status,
+ * timing, headers and body. body diffs run in the background through the
+ * response_diff module and are shown side by side, drawing only the rows
+ * that are on screen.
+ */
+
+#ifndef UI_RESPONSE_DIFF_H
+#define UI_RESPONSE_DIFF_H
+
+#include "app_state.h"
+#include "ui/theme.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ui_response_diff_render(AppState* state, const ModernGruvboxTheme* theme);
+void ui_response_diff_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
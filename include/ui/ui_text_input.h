@@ -0,0 +1,35 @@
+/**
+ * ui_text_input.h
+ *
+ * multiline editor bound to a growable text buffer for tinyrequest
+ *
+ * imgui edits text in place inside a caller-owned char array. with the
+ * resize callback it asks for a bigger array whenever the text would not
+ * fit, which is how request bodies can grow past any fixed size. this
+ * wraps that handshake so every body editor grows its buffer the same way.
+ *
+ * callers can also ask for a byte range to be selected, the editor takes
+ * keyboard focus the next time it is drawn and scrolls to the selection.
+ */
+
+#ifndef UI_TEXT_INPUT_H
+#define UI_TEXT_INPUT_H
+
+#include <stdbool.h>
+#include "text_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* draws an InputTextMultiline over the buffer, returns true when the text was edited */
+bool ui_text_input_multiline(const char* label, TextBuffer* buffer, float width, float height, int flags);
+
+/* selects length bytes at offset the next time the editor for buffer is drawn */
+void ui_text_input_select(TextBuffer* buffer, size_t offset, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
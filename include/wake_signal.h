@@ -0,0 +1,36 @@
+/**
+ * wake_signal.h
+ *
+ * waking the ui loop for tinyrequest
+ *
+ * the main loop sleeps while nothing is happening and only draws a frame
+ * when there is input or something else changed. work that finishes off the
+ * ui thread - a search chunk, a diff, a decoded image - calls
+ * wake_signal_post so its result shows up right away instead of on the
+ * next input event. code drawing an animation posts one as well to ask
+ * for another frame.
+ *
+ * the core modules do not know about glfw, the app registers a handler at
+ * startup that does the actual waking. posting with no handler is a no-op,
+ * so the core still works without a ui.
+ */
+
+#ifndef WAKE_SIGNAL_H
+#define WAKE_SIGNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* asks the ui loop to draw another frame, safe to call from any thread */
+void wake_signal_post(void);
+
+/* sets the function that wakes the ui loop, NULL clears it. the handler
+ * has to stay callable until every thread that may post has been joined */
+void wake_signal_set_handler(void (*handler)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#!/bin/bash
+# Startup benchmark: generates a throwaway home with many collection files and
+# starts tinyrequest against it three times: once without collections_state.json,
+# once with the manifest the first run wrote on exit, and once more with the
+# old cJSON loader for comparison. Each run quits on its own as soon as every
+# collection is loaded and prints its startup timings and peak RSS.
+#
+# usage: scripts/bench_startup.sh [collections=1000] [requests=20] [body_kb=0] [binary]
+# body_kb pads every request body, to see what large imports cost
+# needs a display, run it under xvfb-run on a headless machine
+set -e
+
+COUNT=${1:-1000}
+REQUESTS=${2:-20}
+BODY_KB=${3:-0}
+BINARY=${4:-"$(dirname "$0")/../cmake-build-debug/TinyRequest"}
+
+if [ ! -x "$BINARY" ]; then
+    echo "tinyrequest binary not found at $BINARY, build it first or pass its path"
+    exit 1
+fi
+
+BENCH_HOME=$(mktemp -d)
+trap 'rm -rf "$BENCH_HOME"' EXIT
+
+CONFIG_DIR="$BENCH_HOME/.config/tinyrequest"
+mkdir -p "$CONFIG_DIR/collections"
+echo "skip legacy migration" > "$CONFIG_DIR/migration_completed.marker"
+
+PADDING=$(head -c $((BODY_KB * 1024)) /dev/zero | tr '\0' 'x')
+
+echo "Generating $COUNT collections with $REQUESTS requests each..."
+for ((c = 0; c < COUNT; c++)); do
+    {
+        printf '{"id":"col_bench_%d","name":"Bench %d","description":"generated","created_at":0,"modified_at":0,"requests":[' "$c" "$c"
+        for ((r = 0; r < REQUESTS; r++)); do
+            [ "$r" -gt 0 ] && printf ','
+            printf '{"name":"Request %d","method":"POST","url":"https://example.com/api/%d/%d",' "$r" "$c" "$r"
+            printf '"headers":[{"name":"Content-Type","value":"application/json","enabled":true}],'
+            printf '"body":{"content":"{\\"collection\\":%d,\\"request\\":%d,\\"payload\\":\\"lorem ipsum dolor sit amet%s\\"}"}}' "$c" "$r" "$PADDING"
+        done
+        printf ']}\n'
+    } > "$CONFIG_DIR/collections/col_bench_$c.json"
+done
+
+echo "Cold start, no manifest:"
+HOME="$BENCH_HOME" TINYREQUEST_STARTUP_STATS=exit "$BINARY" | grep '^startup:'
+
+echo "Start with the manifest:"
+HOME="$BENCH_HOME" TINYREQUEST_STARTUP_STATS=exit "$BINARY" | grep '^startup:'
+
+echo "Start with the manifest, cJSON loader:"
+HOME="$BENCH_HOME" TINYREQUEST_STARTUP_STATS=exit TINYREQUEST_COLLECTION_PARSER=dom "$BINARY" | grep '^startup:'
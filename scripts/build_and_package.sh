@@ -35,6 +35,10 @@ else
     ls -la cmake-build-release/bin/ || true
     exit 1
 fi
+if [ -f "cmake-build-release/bin/tinyrequest-cli" ]; then
+    install -Dm755 cmake-build-release/bin/tinyrequest-cli debian/usr/bin/tinyrequest-cli
+    echo "Command line runner installed successfully"
+fi
 
 # 4. Copy assets to the debian package structure
 echo "Installing assets..."
@@ -25,8 +25,12 @@
 #include "font_awesome.h"
 #include "app_state.h"
 #include "persistence.h"
+#include "wake_signal.h"
+#include "profiler.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
@@ -34,6 +38,22 @@
 #define WINDOW_WIDTH 1200
 #define WINDOW_HEIGHT 800
 
+/* frames drawn after an event, imgui needs a few to settle hover and layout changes */
+#define IDLE_SETTLE_FRAMES 3
+/* longest sleep while a text field has focus, keeps the caret blinking */
+#define IDLE_CARET_WAIT_SECONDS 0.4
+/* longest sleep otherwise, so time based hints in the ui still refresh */
+#define IDLE_MAX_WAIT_SECONDS 5.0
+/* shortest sleep for an auto-save that is due, a failing save retries at this rate */
+#define IDLE_MIN_AUTO_SAVE_WAIT_SECONDS 1.0
+/* how often frame stats are printed when TINYREQUEST_FRAME_STATS is set */
+#define FRAME_STATS_INTERVAL_SECONDS 10.0
+
+/* wakes the main loop from glfwWaitEventsTimeout, glfw allows this from any thread */
+static void app_core_wake_handler(void) {
+    glfwPostEmptyEvent();
+}
+
 /* initializes all application subsystems and prepares for main loop */
 int app_core_init(Application* app) {
     printf("TinyRequest HTTP Client starting...\n");
@@ -73,6 +93,9 @@ int app_core_init(Application* app) {
     /* perform initial state synchronization to load any active request data into ui */
     app_state_auto_sync(app->state);
 
+    /* background workers wake the idle main loop when their results are ready */
+    wake_signal_set_handler(app_core_wake_handler);
+
     app->running = true;
     printf("Application initialized successfully\n");
     return 0;
@@ -83,6 +106,9 @@ void app_core_cleanup(Application* app) {
     if (app->state) {
         if (app->state->collection_manager && app->state->collection_manager->count > 0) {
             int save_result = app_state_save_all_collections(app->state);
+            if (save_result == 0) {
+                save_result = app_state_flush_saves(app->state);
+            }
             if (save_result == 0) {
                 printf("Saved %d collections on shutdown\n", app->state->collection_manager->count);
             } else {
@@ -102,36 +128,180 @@ void app_core_cleanup(Application* app) {
         app->state = NULL;
     }
 
+    /* the workers are joined by now, and glfw is still up for any late post */
+    wake_signal_set_handler(NULL);
+
     app_window_cleanup(app);
 }
 
+/* how long the loop may sleep before something time based needs a frame */
+static double app_core_idle_timeout(Application* app) {
+    double timeout = IDLE_MAX_WAIT_SECONDS;
+
+    if (ImGui::GetIO().WantTextInput) {
+        timeout = IDLE_CARET_WAIT_SECONDS;
+    }
+
+    double until_auto_save = app_state_seconds_until_auto_save(app->state);
+    if (until_auto_save >= 0.0) {
+        if (until_auto_save < IDLE_MIN_AUTO_SAVE_WAIT_SECONDS) {
+            until_auto_save = IDLE_MIN_AUTO_SAVE_WAIT_SECONDS;
+        }
+        if (until_auto_save < timeout) {
+            timeout = until_auto_save;
+        }
+    }
+
+    return timeout;
+}
+
+/* prints frames drawn and cpu time used since the last report, for checking idle cost */
+static void app_core_report_frame_stats(int* frames, double* report_time, clock_t* report_clock) {
+    double now = glfwGetTime();
+    if (now - *report_time < FRAME_STATS_INTERVAL_SECONDS) {
+        return;
+    }
+
+    clock_t cpu_now = clock();
+    double wall = now - *report_time;
+    double cpu = (double)(cpu_now - *report_clock) / CLOCKS_PER_SEC;
+    printf("Frame stats: %d frames in %.1fs (%.1f fps), cpu %.1f%%\n",
+           *frames, wall, *frames / wall, cpu / wall * 100.0);
+
+    *frames = 0;
+    *report_time = now;
+    *report_clock = cpu_now;
+}
+
+/* prints how long the first frame took to appear once collections started loading */
+static void app_core_report_first_frame(Application* app) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    double now_ms = ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+
+    printf("startup: first frame %.1f ms after loading started, %d of %d collections loaded\n",
+           now_ms - app->state->load_started_ms, app->state->collections_loaded,
+           app->state->collection_manager->count);
+}
+
 /* runs the main application event loop until shutdown */
 void app_core_run_main_loop(Application* app) {
+    int settle_frames = IDLE_SETTLE_FRAMES;
+    bool frame_stats = getenv("TINYREQUEST_FRAME_STATS") != NULL;
+    int stats_frames = 0;
+    double stats_time = glfwGetTime();
+    clock_t stats_clock = clock();
+    /* set to "exit" the app quits once every collection is loaded, see scripts/bench_startup.sh */
+    const char* startup_stats = getenv("TINYREQUEST_STARTUP_STATS");
+    bool first_frame = true;
+
     while (!glfwWindowShouldClose(app->window) && app->running) {
-        glfwPollEvents();
+        /*
+         * after an event keep drawing a few frames so imgui can settle, then
+         * sleep until the next event, a wakeup from a worker or a timer
+         */
+        if (settle_frames > 0) {
+            glfwPollEvents();
+            settle_frames--;
+        } else {
+            double timeout = app_core_idle_timeout(app);
+            double wait_start = glfwGetTime();
+            glfwWaitEventsTimeout(timeout);
+
+            /* waking early means an event arrived, a timeout only needs one frame */
+            if (glfwGetTime() - wait_start < timeout) {
+                settle_frames = IDLE_SETTLE_FRAMES - 1;
+            }
+        }
+
+        /* nothing to draw while minimized, but timers still run */
+        if (glfwGetWindowAttrib(app->window, GLFW_ICONIFIED)) {
+            app_state_poll_collection_loads(app->state);
+            app_state_poll_saves(app->state);
+            app_state_poll_import(app->state);
+            app_state_poll_har_export(app->state);
+            app_state_check_and_perform_auto_save(app->state);
+            settle_frames = 0;
+            continue;
+        }
+
+        if (frame_stats) {
+            stats_frames++;
+            app_core_report_frame_stats(&stats_frames, &stats_time, &stats_clock);
+        }
+
+        profiler_frame_begin();
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        ui_manager_render(app->ui_manager, app->state);
+        {
+            PROFILE_SCOPE("poll_requests");
+            app_state_poll_requests(app->state);
+        }
+
+        {
+            PROFILE_SCOPE("poll_collection_loads");
+            app_state_poll_collection_loads(app->state);
+        }
+
+        {
+            PROFILE_SCOPE("poll_saves");
+            app_state_poll_saves(app->state);
+        }
+
+        {
+            PROFILE_SCOPE("poll_import");
+            app_state_poll_import(app->state);
+        }
+
+        {
+            PROFILE_SCOPE("poll_har_export");
+            app_state_poll_har_export(app->state);
+        }
+
+        {
+            PROFILE_SCOPE("ui_manager_render");
+            ui_manager_render(app->ui_manager, app->state);
+        }
 
-        if (!app->state->request_in_progress) {
+        {
+            PROFILE_SCOPE("app_state_auto_sync");
             app_state_auto_sync(app->state);
         }
         
-        app_state_check_and_perform_auto_save(app->state);
+        {
+            PROFILE_SCOPE("auto_save");
+            app_state_check_and_perform_auto_save(app->state);
+        }
         app_core_update_window_title(app);
 
-        ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(app->window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(0.157f, 0.157f, 0.157f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            PROFILE_SCOPE("imgui_render");
+            ImGui::Render();
+            int display_w, display_h;
+            glfwGetFramebufferSize(app->window, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClearColor(0.157f, 0.157f, 0.157f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        /* the frame ends before the swap so vsync waits do not count as frame time */
+        profiler_frame_end();
 
         glfwSwapBuffers(app->window);
+
+        if (startup_stats) {
+            if (first_frame) {
+                app_core_report_first_frame(app);
+                first_frame = false;
+            }
+            if (strcmp(startup_stats, "exit") == 0 && !app->state->collections_loading) {
+                app->running = false;
+            }
+        }
     }
 }
 
@@ -142,19 +312,32 @@ void app_core_update_window_title(Application* app) {
     }
     
     char title[512];
-    if (app->state->request_in_progress) {
+    const RequestTab* tab = app_state_get_current_tab(app->state);
+    int in_flight = app_state_count_requests_in_progress(app->state);
+    if (tab && tab->request_in_progress) {
         snprintf(title, sizeof(title), "TinyRequest - Sending %s %s...", 
-                app->state->current_request.method, 
-                app->state->current_request.url);
-    } else if (app->state->current_response.status_code > 0) {
+                tab->method, 
+                tab->url);
+    } else if (tab && tab->response.status_code > 0) {
         snprintf(title, sizeof(title), "TinyRequest - %s %s [%d %s]", 
-                app->state->current_request.method,
-                app->state->current_request.url,
-                app->state->current_response.status_code,
-                app->state->current_response.status_text);
+                tab->method,
+                tab->url,
+                tab->response.status_code,
+                tab->response.status_text);
     } else {
         strcpy(title, "TinyRequest");
     }
+    if (in_flight > 1) {
+        size_t length = strlen(title);
+        snprintf(title + length, sizeof(title) - length, " (%d requests in flight)", in_flight);
+    }
+
+    /* only talk to the window system when the title actually changed */
+    static char last_title[512] = "";
+    if (strcmp(title, last_title) == 0) {
+        return;
+    }
+    strcpy(last_title, title);
     
     glfwSetWindowTitle(app->window, title);
 }
@@ -12,7 +12,6 @@
  */
 
 #include "app/app_theme.h"
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <stdio.h>
 
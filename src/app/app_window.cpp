@@ -8,6 +8,9 @@
 #include "app/app_types.h"
 #include "ui/ui_manager.h"
 #include "ui/ui_request_panel.h"
+#include "ui/ui_profiler.h"
+#include "ui/ui_history.h"
+#include "ui/ui_mock_server.h"
 #include "app_state.h"
 #include <stdio.h>
 #include <GLFW/glfw3.h>
@@ -40,7 +43,7 @@ void app_window_key_callback(GLFWwindow* window, int key, int scancode, int acti
         }
         
         if (key == GLFW_KEY_R && (mods & GLFW_MOD_CONTROL)) {
-            if (!app->state->request_in_progress) {
+            if (!app_state_is_active_request_in_progress(app->state)) {
                 ui_manager_handle_send_request(app->ui_manager, app->state);
             }
             return;
@@ -64,6 +67,21 @@ void app_window_key_callback(GLFWwindow* window, int key, int scancode, int acti
             return;
         }
         
+        if (key == GLFW_KEY_H && (mods & GLFW_MOD_CONTROL) && action == GLFW_PRESS) {
+            ui_history_toggle(app->state);
+            return;
+        }
+        
+        if (key == GLFW_KEY_M && (mods & GLFW_MOD_CONTROL) && action == GLFW_PRESS) {
+            ui_mock_server_toggle(app->state);
+            return;
+        }
+        
+        if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+            ui_profiler_toggle(app->state);
+            return;
+        }
+        
         if (key == GLFW_KEY_ESCAPE) {
             app->state->show_save_dialog = false;
             app->state->show_load_dialog = false;
@@ -15,11 +15,17 @@
 #include "app_state.h"
 #include "persistence.h"
 #include "collections.h"
+#include "collection_journal.h"
+#include "profiler.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
 
+static void start_collection_loads(AppState* state);
+static int load_placeholder(AppState* state, int collection_index, bool apply_auth);
+static void request_tab_drop_sent_request(RequestTab* tab);
+
 /* creates and initializes a new application state instance */
 AppState* app_state_create(void) {
     AppState* state = (AppState*)malloc(sizeof(AppState));
@@ -30,12 +36,10 @@ AppState* app_state_create(void) {
     memset(state, 0, sizeof(AppState));
 
     request_init(&state->current_request);
-    response_init(&state->current_response);
 
     state->collection_manager = collection_manager_create();
     if (!state->collection_manager) {
         request_cleanup(&state->current_request);
-        response_cleanup(&state->current_response);
         free(state);
         return NULL;
     }
@@ -59,17 +63,46 @@ AppState* app_state_create(void) {
 
     persistence_migrate_legacy_requests(state->collection_manager);
     
-    persistence_load_all_collections_with_auth(state->collection_manager, state);
+    state->collection_loader = collection_loader_create(COLLECTION_LOADER_DEFAULT_THREADS);
+    if (!state->collection_loader) {
+        collection_manager_destroy(state->collection_manager);
+        request_cleanup(&state->current_request);
+        free(state);
+        return NULL;
+    }
+
+    start_collection_loads(state);
+
+    state->request_engine = request_engine_create(REQUEST_ENGINE_DEFAULT_WORKERS);
+    if (!state->request_engine) {
+        collection_loader_destroy(state->collection_loader);
+        collection_manager_destroy(state->collection_manager);
+        request_cleanup(&state->current_request);
+        free(state);
+        return NULL;
+    }
 
-    state->http_client = http_client_create();
-    if (!state->http_client) {
+    state->persistence_worker = persistence_worker_create();
+    if (!state->persistence_worker) {
+        request_engine_destroy(state->request_engine);
+        collection_loader_destroy(state->collection_loader);
         collection_manager_destroy(state->collection_manager);
         request_cleanup(&state->current_request);
-        response_cleanup(&state->current_response);
         free(state);
         return NULL;
     }
 
+    /* history is nice to have, the app runs without it */
+    state->history_store = history_store_create();
+    if (!state->history_store) {
+        printf("Request history is off\n");
+    }
+
+    /* there is always at least one response tab */
+    state->next_request_tab_id = 1;
+    app_state_open_request_tab(state, -1, -1);
+    state->active_request_tab = 0;
+
     state->active_tab = TAB_COLLECTIONS;
     state->previous_tab = TAB_COLLECTIONS;
     state->selected_collection_index = -1;
@@ -80,6 +113,9 @@ AppState* app_state_create(void) {
     state->show_collection_rename_dialog = false;
     state->show_request_create_dialog = false;
     state->show_cookie_manager = false;
+    state->show_profiler = false;
+    state->show_history = false;
+    state->show_mock_server = false;
     state->show_import_dialog = false;
     state->show_export_dialog = false;
 
@@ -88,16 +124,16 @@ AppState* app_state_create(void) {
     memset(state->request_name_buffer, 0, sizeof(state->request_name_buffer));
     strncpy(state->url_buffer, "https://", sizeof(state->url_buffer) - 1);
     state->url_buffer[sizeof(state->url_buffer) - 1] = '\0';
-    memset(state->body_buffer, 0, sizeof(state->body_buffer));
+    text_buffer_init(&state->body_buffer);
     memset(state->header_name_buffer, 0, sizeof(state->header_name_buffer));
     memset(state->header_value_buffer, 0, sizeof(state->header_value_buffer));
     memset(state->last_export_path, 0, sizeof(state->last_export_path));
     memset(state->last_import_path, 0, sizeof(state->last_import_path));
 
-    memset(state->json_body_buffer, 0, sizeof(state->json_body_buffer));
-    memset(state->plain_text_body_buffer, 0, sizeof(state->plain_text_body_buffer));
-    memset(state->xml_body_buffer, 0, sizeof(state->xml_body_buffer));
-    memset(state->yaml_body_buffer, 0, sizeof(state->yaml_body_buffer));
+    text_buffer_init(&state->json_body_buffer);
+    text_buffer_init(&state->plain_text_body_buffer);
+    text_buffer_init(&state->xml_body_buffer);
+    text_buffer_init(&state->yaml_body_buffer);
 
     state->selected_method_index = 0; 
     state->show_headers_panel = true;
@@ -112,6 +148,8 @@ AppState* app_state_create(void) {
 
     state->ui_state_dirty = false;
     state->request_data_dirty = false;
+    memset(state->field_generation, 0, sizeof(state->field_generation));
+    memset(state->synced_generation, 0, sizeof(state->synced_generation));
     state->last_ui_sync = time(NULL);
     state->last_change_time = time(NULL);
     state->changes_since_last_save = false;
@@ -122,13 +160,14 @@ AppState* app_state_create(void) {
 
     strncpy(state->status_message, "Ready", sizeof(state->status_message) - 1);
     state->status_message[sizeof(state->status_message) - 1] = '\0';
-    state->request_in_progress = false;
     state->ssl_verify_enabled = true; 
 
     if (state->collection_manager->count > 0) {
 
         state->selected_collection_index = 0;
         collection_manager_set_active_collection(state->collection_manager, 0);
+        /* the first collection is opened right away, so it cannot wait for its turn */
+        app_state_ensure_collection_loaded(state, 0);
 
         Collection* first_collection = &state->collection_manager->collections[0];
         if (first_collection->request_count > 0) {
@@ -156,12 +195,9 @@ AppState* app_state_create(void) {
                 state->url_buffer[sizeof(state->url_buffer) - 1] = '\0';
 
                 if (active_request->body && active_request->body_size > 0) {
-                    size_t copy_size = (active_request->body_size < sizeof(state->body_buffer) - 1) ?
-                                      active_request->body_size : sizeof(state->body_buffer) - 1;
-                    memcpy(state->body_buffer, active_request->body, copy_size);
-                    state->body_buffer[copy_size] = '\0';
+                    text_buffer_set(&state->body_buffer, active_request->body, active_request->body_size);
 
-                    const char* content = state->body_buffer;
+                    const char* content = state->body_buffer.data;
 
                     app_state_clear_content_buffers(state);
 
@@ -216,7 +252,7 @@ AppState* app_state_create(void) {
                         }
                     }
                 } else {
-                    state->body_buffer[0] = '\0';
+                    text_buffer_clear(&state->body_buffer);
                     app_state_clear_content_buffers(state);
                 }
 
@@ -260,9 +296,42 @@ void app_state_destroy(AppState* state) {
         return;
     }
 
-    if (state->http_client) {
-        http_client_destroy(state->http_client);
-        state->http_client = NULL;
+    /* an import still running is cancelled, its collection never reaches the manager */
+    if (state->importer) {
+        collection_importer_destroy(state->importer);
+        state->importer = NULL;
+    }
+
+    /* waits for the requests it is answering, it holds nothing of the state */
+    app_state_stop_mock_server(state);
+
+    /* a history export reads from the store, it stops before the store goes */
+    if (state->har_export) {
+        har_export_destroy(state->har_export);
+        state->har_export = NULL;
+    }
+
+    /* stops every transfer before the collections their cookies go to are freed */
+    if (state->request_engine) {
+        request_engine_destroy(state->request_engine);
+        state->request_engine = NULL;
+    }
+
+    /* writes the responses that came in last */
+    if (state->history_store) {
+        history_store_destroy(state->history_store);
+        state->history_store = NULL;
+    }
+
+    /* writes whatever is still queued, the snapshots do not depend on the collections */
+    if (state->persistence_worker) {
+        persistence_worker_destroy(state->persistence_worker);
+        state->persistence_worker = NULL;
+    }
+
+    if (state->collection_loader) {
+        collection_loader_destroy(state->collection_loader);
+        state->collection_loader = NULL;
     }
 
     if (state->collection_manager) {
@@ -271,7 +340,17 @@ void app_state_destroy(AppState* state) {
     }
 
     request_cleanup(&state->current_request);
-    response_cleanup(&state->current_response);
+    for (int i = 0; i < state->request_tab_count; i++) {
+        request_tab_drop_sent_request(&state->request_tabs[i]);
+        response_cleanup(&state->request_tabs[i].response);
+        response_cleanup(&state->request_tabs[i].previous_response);
+    }
+
+    text_buffer_cleanup(&state->body_buffer);
+    text_buffer_cleanup(&state->json_body_buffer);
+    text_buffer_cleanup(&state->plain_text_body_buffer);
+    text_buffer_cleanup(&state->xml_body_buffer);
+    text_buffer_cleanup(&state->yaml_body_buffer);
 
     free(state);
 }
@@ -288,12 +367,381 @@ void app_state_reset_request(AppState* state) {
 
 /* resets the current response to its initial state */
 void app_state_reset_response(AppState* state) {
+    RequestTab* tab = app_state_get_current_tab(state);
+    if (!tab) {
+        return;
+    }
+
+    response_cleanup(&tab->response);
+    response_init(&tab->response);
+}
+
+/* forgets the copy of what the tab sent last */
+static void request_tab_drop_sent_request(RequestTab* tab) {
+    if (tab->sent_request) {
+        request_cleanup(tab->sent_request);
+        free(tab->sent_request);
+        tab->sent_request = NULL;
+    }
+}
+
+/* "METHOD label" for the tab strip, a long label is cut to what fits */
+static void request_tab_set_title(RequestTab* tab, const char* method, const char* label) {
+    int room = (int)(sizeof(tab->title) - sizeof(tab->method) - 1);
+    snprintf(tab->title, sizeof(tab->title), "%.15s %.*s", method, room, label);
+}
+
+/* moves a completed response into previous_response and clears the current one */
+static void request_tab_keep_previous_response(RequestTab* tab) {
+    if (tab->response.status_code > 0) {
+        response_cleanup(&tab->previous_response);
+        tab->previous_response = tab->response;
+    } else {
+        response_cleanup(&tab->response);
+    }
+    response_init(&tab->response);
+}
+
+/* moves the active tab's completed response into previous_response */
+void app_state_keep_previous_response(AppState* state) {
+    RequestTab* tab = app_state_get_current_tab(state);
+    if (!tab) {
+        return;
+    }
+
+    request_tab_keep_previous_response(tab);
+}
+
+/* returns the response tab shown in the response view */
+RequestTab* app_state_get_current_tab(AppState* state) {
+    if (!state || state->active_request_tab < 0 || state->active_request_tab >= state->request_tab_count) {
+        return NULL;
+    }
+
+    return &state->request_tabs[state->active_request_tab];
+}
+
+Response* app_state_get_current_response(AppState* state) {
+    RequestTab* tab = app_state_get_current_tab(state);
+    return tab ? &tab->response : NULL;
+}
+
+Response* app_state_get_previous_response(AppState* state) {
+    RequestTab* tab = app_state_get_current_tab(state);
+    return tab ? &tab->previous_response : NULL;
+}
+
+/* true while the tab shown in the response view waits for its transfer */
+bool app_state_is_request_in_progress(AppState* state) {
+    RequestTab* tab = app_state_get_current_tab(state);
+    return tab && tab->request_in_progress;
+}
+
+/* true while the request open in the editor is already being sent */
+bool app_state_is_active_request_in_progress(AppState* state) {
+    if (!state || !state->collection_manager) {
+        return false;
+    }
+
+    CollectionManager* manager = state->collection_manager;
+    int request_index = manager->active_request_index >= 0 ? manager->active_request_index : -1;
+    int tab_index = app_state_find_request_tab(state, manager->active_collection_index, request_index);
+    return tab_index >= 0 && state->request_tabs[tab_index].request_in_progress;
+}
+
+int app_state_count_requests_in_progress(AppState* state) {
+    if (!state) {
+        return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < state->request_tab_count; i++) {
+        if (state->request_tabs[i].request_in_progress) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* returns the tab opened for a request, request_index -1 is the scratch request of a collection */
+int app_state_find_request_tab(AppState* state, int collection_index, int request_index) {
+    if (!state) {
+        return -1;
+    }
+
+    for (int i = 0; i < state->request_tab_count; i++) {
+        if (state->request_tabs[i].collection_index == collection_index &&
+            state->request_tabs[i].request_index == request_index) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void request_tab_init(RequestTab* tab, int id, int collection_index, int request_index) {
+    memset(tab, 0, sizeof(RequestTab));
+    tab->id = id;
+    tab->collection_index = collection_index;
+    tab->request_index = request_index;
+    strncpy(tab->title, "Untitled", sizeof(tab->title) - 1);
+    response_init(&tab->response);
+    response_init(&tab->previous_response);
+}
+
+/* returns the tab for a request, opening one or taking over a tab that never sent anything */
+int app_state_open_request_tab(AppState* state, int collection_index, int request_index) {
     if (!state) {
+        return -1;
+    }
+
+    int tab_index = app_state_find_request_tab(state, collection_index, request_index);
+    if (tab_index >= 0) {
+        return tab_index;
+    }
+
+    for (int i = 0; i < state->request_tab_count; i++) {
+        RequestTab* tab = &state->request_tabs[i];
+        if (!tab->request_in_progress && tab->method[0] == '\0' && tab->response.status_code == 0) {
+            tab->collection_index = collection_index;
+            tab->request_index = request_index;
+            return i;
+        }
+    }
+
+    if (state->request_tab_count < APP_STATE_MAX_REQUEST_TABS) {
+        tab_index = state->request_tab_count++;
+    } else {
+        /* full, reuse the oldest idle tab that is not on screen */
+        for (int i = 0; i < state->request_tab_count; i++) {
+            if (i != state->active_request_tab && !state->request_tabs[i].request_in_progress) {
+                tab_index = i;
+                break;
+            }
+        }
+        if (tab_index < 0) {
+            return -1;
+        }
+        response_cleanup(&state->request_tabs[tab_index].response);
+        response_cleanup(&state->request_tabs[tab_index].previous_response);
+    }
+
+    request_tab_init(&state->request_tabs[tab_index], state->next_request_tab_id++, collection_index, request_index);
+    return tab_index;
+}
+
+/* closes a tab and drops its transfer, the last tab is emptied instead of closed */
+void app_state_close_request_tab(AppState* state, int tab_index) {
+    if (!state || tab_index < 0 || tab_index >= state->request_tab_count) {
+        return;
+    }
+
+    RequestTab* tab = &state->request_tabs[tab_index];
+    if (tab->request_in_progress) {
+        request_engine_release(state->request_engine, tab->transfer_id);
+    }
+    request_tab_drop_sent_request(tab);
+    response_cleanup(&tab->response);
+    response_cleanup(&tab->previous_response);
+
+    if (state->request_tab_count == 1) {
+        request_tab_init(tab, state->next_request_tab_id++, -1, -1);
+        return;
+    }
+
+    memmove(&state->request_tabs[tab_index], &state->request_tabs[tab_index + 1],
+            (size_t)(state->request_tab_count - tab_index - 1) * sizeof(RequestTab));
+    state->request_tab_count--;
+
+    if (state->active_request_tab > tab_index || state->active_request_tab >= state->request_tab_count) {
+        state->active_request_tab--;
+    }
+}
+
+void app_state_set_active_request_tab(AppState* state, int tab_index) {
+    if (!state || tab_index < 0 || tab_index >= state->request_tab_count) {
+        return;
+    }
+
+    state->active_request_tab = tab_index;
+}
+
+/* hands a copy of the request to the engine, the response arrives in app_state_poll_requests */
+int app_state_send_request(AppState* state, int tab_index, const Request* request) {
+    if (!state || !request || !state->request_engine || tab_index < 0 || tab_index >= state->request_tab_count) {
+        return -1;
+    }
+
+    RequestTab* tab = &state->request_tabs[tab_index];
+    if (tab->request_in_progress) {
+        return -1;
+    }
+
+    Request to_send;
+    if (request_copy(&to_send, request) != 0) {
+        snprintf(state->status_message, sizeof(state->status_message), "Failed to prepare request");
+        return -1;
+    }
+
+    /* cookies are read and written on this thread, the workers never see the jar */
+    Collection* collection = collection_manager_get_collection(state->collection_manager, tab->collection_index);
+    if (collection) {
+        http_client_add_cookie_header(&to_send, collection);
+    }
+
+    request_engine_set_ssl_verification(state->request_engine, state->ssl_verify_enabled);
+    int transfer_id = request_engine_submit(state->request_engine, &to_send);
+
+    if (transfer_id < 0) {
+        request_cleanup(&to_send);
+        snprintf(state->status_message, sizeof(state->status_message), "Failed to start request");
+        return -1;
+    }
+
+    /* the copy that went out, cookie header included, goes to history with the
+     * response and stays with the tab for HAR exports */
+    request_tab_drop_sent_request(tab);
+    tab->sent_request = (Request*)malloc(sizeof(Request));
+    if (tab->sent_request) {
+        *tab->sent_request = to_send;
+    } else {
+        request_cleanup(&to_send);
+    }
+
+    request_tab_keep_previous_response(tab);
+    tab->transfer_id = transfer_id;
+    tab->request_in_progress = true;
+
+    snprintf(tab->method, sizeof(tab->method), "%s", request->method);
+    snprintf(tab->url, sizeof(tab->url), "%s", request->url);
+
+    const char* name = collection ? collection_get_request_name(collection, tab->request_index) : NULL;
+    request_tab_set_title(tab, request->method, name ? name : request->url);
+
+    snprintf(state->status_message, sizeof(state->status_message), "Sending request...");
+    return 0;
+}
+
+void app_state_cancel_request(AppState* state, int tab_index) {
+    if (!state || tab_index < 0 || tab_index >= state->request_tab_count) {
+        return;
+    }
+
+    RequestTab* tab = &state->request_tabs[tab_index];
+    if (tab->request_in_progress) {
+        request_engine_cancel(state->request_engine, tab->transfer_id);
+    }
+}
+
+/* sums up how a finished transfer went in the status bar */
+static void app_state_describe_response(AppState* state, const Response* response, int result) {
+    if (result == 0) {
+
+        if (response->status_code >= 200 && response->status_code < 300) {
+            snprintf(state->status_message, sizeof(state->status_message), 
+                    "Success: %d %s (%.2f ms)", 
+                    response->status_code,
+                    response->status_text,
+                    response->response_time);
+        } else if (response->status_code > 0) {
+            snprintf(state->status_message, sizeof(state->status_message), 
+                    "HTTP %d: %s (%.2f ms)", 
+                    response->status_code,
+                    response->status_text,
+                    response->response_time);
+        } else {
+            snprintf(state->status_message, sizeof(state->status_message), 
+                    "Network Error: %s", 
+                    response->status_text);
+        }
+    } else {
+
+        if (response->status_text[0] != '\0') {
+            snprintf(state->status_message, sizeof(state->status_message), 
+                    "Error: %s", response->status_text);
+        } else {
+            snprintf(state->status_message, sizeof(state->status_message), 
+                    "Failed to send request (error code: %d)", result);
+        }
+    }
+}
+
+/* collects finished transfers into their tabs, called once per frame */
+void app_state_poll_requests(AppState* state) {
+    if (!state || !state->request_engine) {
         return;
     }
 
-    response_cleanup(&state->current_response);
-    response_init(&state->current_response);
+    for (int i = 0; i < state->request_tab_count; i++) {
+        RequestTab* tab = &state->request_tabs[i];
+        if (!tab->request_in_progress) {
+            continue;
+        }
+
+        Response response;
+        int result = -1;
+        int taken = request_engine_take_response(state->request_engine, tab->transfer_id, &response, &result);
+        if (taken == 0) {
+            continue;
+        }
+
+        tab->request_in_progress = false;
+        tab->transfer_id = 0;
+        if (taken < 0) {
+            request_tab_drop_sent_request(tab);
+            continue;
+        }
+
+        response_cleanup(&tab->response);
+        tab->response = response;
+
+        if (tab->sent_request && state->history_store) {
+            history_store_record(state->history_store, tab->sent_request, &tab->response, result);
+        }
+
+        Collection* collection = collection_manager_get_collection(state->collection_manager, tab->collection_index);
+        if (result == 0 && collection) {
+            http_client_store_response_cookies(collection, tab->url, &tab->response);
+        }
+
+        app_state_describe_response(state, &tab->response, result);
+    }
+}
+
+/* shows a response from history in the scratch tab, the entry's response is moved out */
+int app_state_open_history_entry(AppState* state, HistoryEntry* entry) {
+    if (!state || !entry) {
+        return -1;
+    }
+
+    int tab_index = app_state_open_request_tab(state, -1, -1);
+    if (tab_index < 0 || state->request_tabs[tab_index].request_in_progress) {
+        snprintf(state->status_message, sizeof(state->status_message), "No free response tab for the history entry");
+        return -1;
+    }
+
+    RequestTab* tab = &state->request_tabs[tab_index];
+    request_tab_keep_previous_response(tab);
+    tab->response = entry->response;
+    response_init(&entry->response);
+    if (tab->response.timings.started_at_ms <= 0) {
+        tab->response.timings.started_at_ms = entry->summary.sent_at_ms;
+    }
+
+    /* read before the request is moved out, that leaves the entry's one reset */
+    snprintf(tab->method, sizeof(tab->method), "%s", entry->request.method);
+    snprintf(tab->url, sizeof(tab->url), "%s", entry->request.url);
+    request_tab_set_title(tab, entry->request.method, entry->request.url);
+
+    request_tab_drop_sent_request(tab);
+    tab->sent_request = (Request*)malloc(sizeof(Request));
+    if (tab->sent_request) {
+        *tab->sent_request = entry->request;
+        request_init(&entry->request);
+    }
+
+    app_state_set_active_request_tab(state, tab_index);
+    app_state_set_active_tab(state, TAB_RESPONSE);
+    return 0;
 }
 
 /* returns the currently active collection or null if none selected */
@@ -326,6 +774,15 @@ int app_state_set_active_collection(AppState* state, int collection_index) {
 
     bool is_switching_collections = (state->collection_manager->active_collection_index != collection_index);
 
+    /* a placeholder is read now, which also brings in its auth, so it needs no second read below */
+    Collection* target = collection_manager_get_collection(state->collection_manager, collection_index);
+    if (target && !target->loaded) {
+        if (load_placeholder(state, collection_index, true) != 0) {
+            return -1;
+        }
+        is_switching_collections = false;
+    }
+
     int result = collection_manager_set_active_collection(state->collection_manager, collection_index);
     if (result == 0) {
         state->selected_collection_index = collection_index;
@@ -334,14 +791,21 @@ int app_state_set_active_collection(AppState* state, int collection_index) {
 
         if (is_switching_collections) {
 
+            /* only the collection level auth comes from the file. the requests in memory
+             * are newer than the snapshot, which may still have journal records on top */
             Collection* new_collection = app_state_get_active_collection(state);
             if (new_collection) {
-                char filename[128];
-                snprintf(filename, sizeof(filename), "%s.json", new_collection->id);
-                char* filepath = persistence_get_collections_path(filename);
+                char* filepath = persistence_find_collection_file(new_collection->id);
                 if (filepath) {
-
-                    persistence_load_collection_with_auth(new_collection, filepath, state);
+                    Collection on_disk;
+                    memset(&on_disk, 0, sizeof(Collection));
+                    PersistenceAuth auth;
+                    bool has_auth = false;
+                    if (persistence_read_collection_file(&on_disk, filepath, &auth, &has_auth) == PERSISTENCE_SUCCESS &&
+                        has_auth) {
+                        persistence_apply_auth_to_app_state(&auth, state);
+                    }
+                    collection_cleanup(&on_disk);
                     free(filepath);
                 }
             }
@@ -457,7 +921,7 @@ void app_state_clear_request_ui_buffers(AppState* state) {
 
     strncpy(state->url_buffer, "https://", sizeof(state->url_buffer) - 1);  
     state->url_buffer[sizeof(state->url_buffer) - 1] = '\0';
-    memset(state->body_buffer, 0, sizeof(state->body_buffer));
+    text_buffer_clear(&state->body_buffer);
     memset(state->header_name_buffer, 0, sizeof(state->header_name_buffer));
     memset(state->header_value_buffer, 0, sizeof(state->header_value_buffer));
 
@@ -485,6 +949,16 @@ bool app_state_should_auto_save(AppState* state) {
     return (current_time - state->last_auto_save) >= state->auto_save_interval;
 }
 
+/* returns how long until the next auto-save is due, or -1 if auto-save is off */
+double app_state_seconds_until_auto_save(AppState* state) {
+    if (!state || !state->auto_save_enabled) {
+        return -1.0;
+    }
+
+    double remaining = difftime(state->last_auto_save + state->auto_save_interval, time(NULL));
+    return remaining > 0.0 ? remaining : 0.0;
+}
+
 /* updates the last auto-save timestamp */
 void app_state_update_auto_save_time(AppState* state) {
     if (!state) {
@@ -494,14 +968,31 @@ void app_state_update_auto_save_time(AppState* state) {
     state->last_auto_save = time(NULL);
 }
 
-/* performs an auto-save operation with authentication data */
+/* queues a snapshot of every collection with journal records, which trims
+ * the journals. journal_size drops once the worker reports it written */
+static void compact_journals(AppState* state) {
+    PersistenceAuth auth;
+    persistence_auth_from_app_state(&auth, state);
+
+    for (int i = 0; i < state->collection_manager->count; i++) {
+        Collection* collection = &state->collection_manager->collections[i];
+        if (collection->loaded && collection->journal_size > 0) {
+            persistence_worker_save_collection(state->persistence_worker, collection, &auth);
+        }
+    }
+}
+
+/* queues the collections that changed since they were last written, and a
+ * snapshot behind them */
 int app_state_perform_auto_save(AppState* state) {
     if (!state || !state->collection_manager) {
         return -1;
     }
 
-    int result = persistence_save_all_collections_with_auth(state->collection_manager, state);
-    if (result == PERSISTENCE_SUCCESS) {
+    compact_journals(state);
+    int queued = persistence_worker_save_dirty(state->persistence_worker, state->collection_manager, state);
+    if (queued >= 0) {
+        persistence_worker_snapshot(state->persistence_worker);
         app_state_update_auto_save_time(state);
         return 0;
     } else {
@@ -509,14 +1000,18 @@ int app_state_perform_auto_save(AppState* state) {
     }
 }
 
-/* saves all collections and settings to persistent storage */
+/* saves every collection with unsaved changes plus the settings */
 int app_state_save_all_collections(AppState* state) {
     if (!state || !state->collection_manager) {
         return -1;
     }
 
-    int result = persistence_save_all_collections_with_auth(state->collection_manager, state);
-    if (result == PERSISTENCE_SUCCESS) {
+    /* an explicit save always writes what the user is looking at */
+    collection_update_modified_time(app_state_get_active_collection(state));
+    compact_journals(state);
+
+    int queued = persistence_worker_save_dirty(state->persistence_worker, state->collection_manager, state);
+    if (queued >= 0) {
 
         persistence_save_settings(state->collection_manager,
                                  state->auto_save_enabled,
@@ -528,150 +1023,705 @@ int app_state_save_all_collections(AppState* state) {
     }
 }
 
-/* checks if auto-save is needed and performs it if necessary */
-void app_state_check_and_perform_auto_save(AppState* state) {
-    if (!state || !state->auto_save_enabled) {
+/* removes a deleted collection's file, queued behind any save of it still in flight */
+int app_state_delete_collection_file(AppState* state, const char* collection_id) {
+    if (!state || !collection_id) {
+        return -1;
+    }
+
+    collection_loader_forget(state->collection_loader, collection_id);
+    return persistence_worker_delete_collection(state->persistence_worker, collection_id);
+}
+
+static Collection* find_collection_by_id(CollectionManager* manager, const char* collection_id) {
+    for (int i = 0; i < manager->count; i++) {
+        if (strcmp(manager->collections[i].id, collection_id) == 0) {
+            return &manager->collections[i];
+        }
+    }
+    return NULL;
+}
+
+static bool any_collection_dirty(const CollectionManager* manager) {
+    for (int i = 0; i < manager->count; i++) {
+        if (collection_is_dirty(&manager->collections[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* a journaled edit counted as saved the moment it was queued. if the append
+ * failed the collection is made dirty again and gets a snapshot instead */
+static void journal_appended(AppState* state, const PersistenceCompletion* completion) {
+    if (completion->result != PERSISTENCE_SUCCESS) {
+        Collection* collection = find_collection_by_id(state->collection_manager, completion->collection_id);
+        if (collection) {
+            collection_update_modified_time(collection);
+            persistence_worker_save_dirty(state->persistence_worker, state->collection_manager, state);
+        }
         return;
     }
 
-    if (app_state_should_auto_save(state)) {
-        app_state_perform_auto_save(state);
+    if (!any_collection_dirty(state->collection_manager)) {
+        state->unsaved_changes = false;
     }
 }
 
-/* synchronizes ui buffer data to the active request structure */
-void app_state_sync_ui_to_request(AppState* state) {
-    if (!state) {
+/* marks what the persistence worker wrote as saved and reports failures, called once per frame */
+void app_state_poll_saves(AppState* state) {
+    if (!state || !state->persistence_worker || !state->collection_manager) {
         return;
     }
 
-    Request* active_request = app_state_get_active_request(state);
-    if (!active_request) {
-        active_request = &state->current_request;
+    PersistenceCompletion completion;
+    int written = 0;
+    double duration_ms = 0.0;
 
-        if (strlen(active_request->method) == 0) {
-            strncpy(active_request->method, "GET", sizeof(active_request->method) - 1);
-            active_request->method[sizeof(active_request->method) - 1] = '\0';
+    while (persistence_worker_poll(state->persistence_worker, &completion)) {
+        if (completion.kind == PERSISTENCE_JOB_APPEND_JOURNAL) {
+            journal_appended(state, &completion);
+            continue;
         }
-        if (strlen(active_request->url) == 0) {
-            strncpy(active_request->url, "https://", sizeof(active_request->url) - 1);
-            active_request->url[sizeof(active_request->url) - 1] = '\0';
+
+        if (completion.result != PERSISTENCE_SUCCESS) {
+            const char* operation = completion.kind == PERSISTENCE_JOB_DELETE_COLLECTION ? "delete the collection file" :
+                                    completion.kind == PERSISTENCE_JOB_AUTO_SNAPSHOT ? "take an auto-save snapshot" :
+                                    "save collections";
+            snprintf(state->status_message, sizeof(state->status_message), "%s",
+                     persistence_get_user_friendly_error((PersistenceError)completion.result, operation));
+            continue;
         }
-    }
 
-    bool changes_made = false;
+        if (completion.kind != PERSISTENCE_JOB_SAVE_COLLECTION) {
+            continue;
+        }
 
-    // Synchronize authentication data from global state to request
-    if (active_request->selected_auth_type != state->selected_auth_type) {
-        active_request->selected_auth_type = state->selected_auth_type;
-        changes_made = true;
+        /* edits made after the snapshot keep the collection dirty. the journal is
+         * trimmed up to the snapshot, records appended after it was taken are
+         * still there and keep counting until a snapshot contains them too */
+        Collection* collection = find_collection_by_id(state->collection_manager, completion.collection_id);
+        if (collection) {
+            collection_mark_saved(collection, completion.generation);
+            if (completion.journal_seq >= collection->journal_seq) {
+                collection->journal_size = 0;
+            }
+        }
+        written++;
+        duration_ms += completion.duration_ms;
     }
-    
-    if (strcmp(active_request->auth_api_key_name, state->auth_api_key_name) != 0) {
-        strncpy(active_request->auth_api_key_name, state->auth_api_key_name, sizeof(active_request->auth_api_key_name) - 1);
-        active_request->auth_api_key_name[sizeof(active_request->auth_api_key_name) - 1] = '\0';
-        changes_made = true;
+
+    if (written > 0) {
+        state->last_save_written = written;
+        state->last_save_duration_ms = duration_ms;
     }
-    
-    if (strcmp(active_request->auth_api_key_value, state->auth_api_key_value) != 0) {
-        strncpy(active_request->auth_api_key_value, state->auth_api_key_value, sizeof(active_request->auth_api_key_value) - 1);
-        active_request->auth_api_key_value[sizeof(active_request->auth_api_key_value) - 1] = '\0';
-        changes_made = true;
+}
+
+/* blocks until every queued save is on disk, returns -1 if a collection is still unsaved */
+int app_state_flush_saves(AppState* state) {
+    if (!state || !state->collection_manager) {
+        return -1;
     }
-    
-    if (strcmp(active_request->auth_bearer_token, state->auth_bearer_token) != 0) {
-        strncpy(active_request->auth_bearer_token, state->auth_bearer_token, sizeof(active_request->auth_bearer_token) - 1);
-        active_request->auth_bearer_token[sizeof(active_request->auth_bearer_token) - 1] = '\0';
-        changes_made = true;
+
+    persistence_worker_flush(state->persistence_worker);
+    app_state_poll_saves(state);
+
+    return any_collection_dirty(state->collection_manager) ? -1 : 0;
+}
+
+/* starts importing a file, false while another import still runs */
+bool app_state_start_import(AppState* state, const char* filepath) {
+    if (!state || !filepath || filepath[0] == '\0' || state->importer) {
+        return false;
     }
-    
-    if (strcmp(active_request->auth_basic_username, state->auth_basic_username) != 0) {
-        strncpy(active_request->auth_basic_username, state->auth_basic_username, sizeof(active_request->auth_basic_username) - 1);
-        active_request->auth_basic_username[sizeof(active_request->auth_basic_username) - 1] = '\0';
-        changes_made = true;
+
+    state->import_message[0] = '\0';
+    state->importer = collection_importer_start(filepath);
+    if (!state->importer) {
+        snprintf(state->import_message, sizeof(state->import_message), "Could not start the import");
+        return false;
     }
-    
-    if (strcmp(active_request->auth_basic_password, state->auth_basic_password) != 0) {
-        strncpy(active_request->auth_basic_password, state->auth_basic_password, sizeof(active_request->auth_basic_password) - 1);
-        active_request->auth_basic_password[sizeof(active_request->auth_basic_password) - 1] = '\0';
-        changes_made = true;
+    return true;
+}
+
+void app_state_cancel_import(AppState* state) {
+    if (state && state->importer) {
+        collection_importer_cancel(state->importer);
     }
-    
-    if (strcmp(active_request->auth_oauth_token, state->auth_oauth_token) != 0) {
-        strncpy(active_request->auth_oauth_token, state->auth_oauth_token, sizeof(active_request->auth_oauth_token) - 1);
-        active_request->auth_oauth_token[sizeof(active_request->auth_oauth_token) - 1] = '\0';
-        changes_made = true;
+}
+
+/* adds the collection a finished import read and makes it the active one,
+ * called once per frame. the new collection is saved right away */
+void app_state_poll_import(AppState* state) {
+    if (!state || !state->importer || !state->collection_manager) {
+        return;
     }
-    
-    if (active_request->auth_api_key_location != state->auth_api_key_location) {
-        active_request->auth_api_key_location = state->auth_api_key_location;
-        changes_made = true;
+
+    CollectionImportProgress progress;
+    collection_importer_get_progress(state->importer, &progress);
+    if (!progress.finished) {
+        return;
     }
-    
-    // Synchronize authentication checkboxes
-    if (active_request->auth_api_key_enabled != state->auth_api_key_enabled) {
-        active_request->auth_api_key_enabled = state->auth_api_key_enabled;
-        changes_made = true;
+
+    Collection imported;
+    memset(&imported, 0, sizeof(Collection));
+    if (collection_importer_take(state->importer, &imported)) {
+        int index = collection_manager_adopt_collection(state->collection_manager, &imported);
+        if (index < 0) {
+            collection_cleanup(&imported);
+            snprintf(state->import_message, sizeof(state->import_message),
+                     "Not enough memory to add the imported collection");
+        } else {
+            app_state_set_active_collection(state, index);
+            app_state_save_all_collections(state);
+            snprintf(state->status_message, sizeof(state->status_message),
+                     "Imported %d requests from %s in %.1f s", progress.request_count,
+                     collection_import_format_name(progress.format), progress.elapsed_ms / 1000.0);
+            state->show_import_dialog = false;
+        }
+    } else if (progress.result == PERSISTENCE_ERROR_CANCELLED) {
+        snprintf(state->import_message, sizeof(state->import_message), "Import cancelled");
+    } else if (progress.result == PERSISTENCE_ERROR_CORRUPTED_DATA && progress.format == COLLECTION_IMPORT_UNKNOWN) {
+        snprintf(state->import_message, sizeof(state->import_message),
+                 "Not a Postman, Insomnia, HAR or TinyRequest collection");
+    } else {
+        snprintf(state->import_message, sizeof(state->import_message), "%s",
+                 persistence_get_user_friendly_error((PersistenceError)progress.result, "import the collection"));
     }
-    
-    if (active_request->auth_bearer_enabled != state->auth_bearer_enabled) {
-        active_request->auth_bearer_enabled = state->auth_bearer_enabled;
-        changes_made = true;
+
+    collection_importer_destroy(state->importer);
+    state->importer = NULL;
+}
+
+/* writes a tab's response and the request it answered to a HAR file of one
+ * entry, on the calling thread */
+int app_state_export_response_har(AppState* state, int tab_index, const char* filepath, bool bodies) {
+    if (!state || tab_index < 0 || tab_index >= state->request_tab_count) {
+        return -1;
     }
-    
-    if (active_request->auth_basic_enabled != state->auth_basic_enabled) {
-        active_request->auth_basic_enabled = state->auth_basic_enabled;
-        changes_made = true;
+
+    RequestTab* tab = &state->request_tabs[tab_index];
+    if (!tab->sent_request || tab->request_in_progress) {
+        snprintf(state->status_message, sizeof(state->status_message), "No response to export");
+        return -1;
     }
-    
-    if (active_request->auth_oauth_enabled != state->auth_oauth_enabled) {
-        active_request->auth_oauth_enabled = state->auth_oauth_enabled;
-        changes_made = true;
+
+    int result = PERSISTENCE_SUCCESS;
+    HarWriter* writer = har_writer_open(filepath, bodies ? HAR_WRITER_BODIES : 0, &result);
+    if (writer) {
+        result = har_writer_add(writer, tab->sent_request, &tab->response, 0, NULL);
+        if (result == PERSISTENCE_SUCCESS) {
+            result = har_writer_close(writer);
+        } else {
+            har_writer_abort(writer);
+        }
     }
 
-    const char* methods[] = { "GET", "POST", "PUT", "DELETE", "PATCH", "HEAD", "OPTIONS" };
-    const int method_count = sizeof(methods) / sizeof(methods[0]);
-    if (state->selected_method_index >= 0 && state->selected_method_index < method_count) {
-        const char* new_method = methods[state->selected_method_index];
-        if (strcmp(active_request->method, new_method) != 0) {
-            strncpy(active_request->method, new_method, sizeof(active_request->method) - 1);
-            active_request->method[sizeof(active_request->method) - 1] = '\0';
-            changes_made = true;
+    if (result != PERSISTENCE_SUCCESS) {
+        snprintf(state->status_message, sizeof(state->status_message), "%s",
+                 persistence_get_user_friendly_error((PersistenceError)result, "export the HAR file"));
+        return -1;
+    }
+
+    snprintf(state->status_message, sizeof(state->status_message), "Exported the response to %s", filepath);
+    return 0;
+}
+
+/* starts exporting history records, false while another export still runs */
+bool app_state_start_har_export(AppState* state, const uint64_t* ids, int id_count,
+                                uint64_t first_id, uint64_t last_id, const char* filepath, bool bodies) {
+    if (!state || !state->history_store || state->har_export) {
+        return false;
+    }
+
+    state->har_export = har_export_history_start(state->history_store, ids, id_count, first_id, last_id,
+                                                 filepath, bodies ? HAR_WRITER_BODIES : 0);
+    if (!state->har_export) {
+        snprintf(state->status_message, sizeof(state->status_message), "Could not start the HAR export");
+        return false;
+    }
+    return true;
+}
+
+/* reports a finished history export in the status bar, called once per frame */
+void app_state_poll_har_export(AppState* state) {
+    if (!state || !state->har_export) {
+        return;
+    }
+
+    HarExportProgress progress;
+    har_export_get_progress(state->har_export, &progress);
+    if (!progress.finished) {
+        return;
+    }
+
+    if (progress.result == PERSISTENCE_SUCCESS) {
+        snprintf(state->status_message, sizeof(state->status_message), "Exported %d history entries to HAR",
+                 progress.written);
+    } else if (progress.result == PERSISTENCE_ERROR_CANCELLED) {
+        snprintf(state->status_message, sizeof(state->status_message), "HAR export cancelled");
+    } else {
+        snprintf(state->status_message, sizeof(state->status_message), "%s",
+                 persistence_get_user_friendly_error((PersistenceError)progress.result, "export the HAR file"));
+    }
+
+    har_export_destroy(state->har_export);
+    state->har_export = NULL;
+}
+
+/* builds the routes from the collection and starts answering. the routes
+ * are copied, later edits to the collection need a restart */
+int app_state_start_mock_server(AppState* state, int collection_index, const MockServerOptions* options) {
+    if (!state || !state->collection_manager) {
+        return MOCK_SERVER_ERROR_NULL_PARAM;
+    }
+    if (state->mock_server) {
+        return MOCK_SERVER_ERROR_RUNNING;
+    }
+
+    Collection* collection = collection_manager_get_collection(state->collection_manager, collection_index);
+    if (!collection || !collection->loaded) {
+        return MOCK_SERVER_ERROR_NULL_PARAM;
+    }
+
+    MockServer* server = mock_server_create(options);
+    if (!server) {
+        return MOCK_SERVER_ERROR_INVALID_OPTIONS;
+    }
+
+    int result = mock_server_add_collection(server, collection, state->history_store);
+    if (result == MOCK_SERVER_SUCCESS) {
+        result = mock_server_start(server);
+    }
+    if (result != MOCK_SERVER_SUCCESS) {
+        mock_server_destroy(server);
+        snprintf(state->status_message, sizeof(state->status_message), "Mock server: %s",
+                 mock_server_error_string(result));
+        return result;
+    }
+
+    state->mock_server = server;
+    snprintf(state->mock_collection_name, sizeof(state->mock_collection_name), "%s", collection->name);
+    snprintf(state->status_message, sizeof(state->status_message), "Serving %.*s on port %d",
+             (int)(sizeof(state->status_message) - sizeof("Serving  on port 65535")), collection->name,
+             mock_server_get_port(server));
+    return MOCK_SERVER_SUCCESS;
+}
+
+void app_state_stop_mock_server(AppState* state) {
+    if (!state || !state->mock_server) {
+        return;
+    }
+    mock_server_destroy(state->mock_server);
+    state->mock_server = NULL;
+    state->mock_collection_name[0] = '\0';
+}
+
+/* queues one journal record. it is only written when everything before the
+ * edit is already on disk, otherwise the collection stays dirty and the
+ * snapshot queued below carries the edit. a journal that grew large enough
+ * is folded into a snapshot right away */
+static void journal_edit(AppState* state, Collection* collection, unsigned int base_generation,
+                         unsigned long seq, char* record, size_t length) {
+    if (record && collection->loaded && collection->saved_generation == base_generation &&
+        persistence_worker_append_journal(state->persistence_worker, collection->id,
+                                          collection->generation, record, length) == 0) {
+        collection->journal_seq = seq;
+        collection->journal_size += length;
+        collection_mark_saved(collection, collection->generation);
+
+        /* queued once as the journal crosses the limit, the auto-save retries one that failed */
+        if (collection->journal_size > COLLECTION_JOURNAL_COMPACT_BYTES &&
+            collection->journal_size - length <= COLLECTION_JOURNAL_COMPACT_BYTES) {
+            PersistenceAuth auth;
+            persistence_auth_from_app_state(&auth, state);
+            persistence_worker_save_collection(state->persistence_worker, collection, &auth);
         }
+    } else {
+        free(record);
     }
 
-    if (strcmp(active_request->url, state->url_buffer) != 0) {
-        strncpy(active_request->url, state->url_buffer, sizeof(active_request->url) - 1);
-        active_request->url[sizeof(active_request->url) - 1] = '\0';
-        changes_made = true;
+    state->unsaved_changes = true;
+    state->changes_since_last_save = true;
+    state->last_change_time = time(NULL);
+
+    persistence_worker_save_dirty(state->persistence_worker, state->collection_manager, state);
+}
+
+void app_state_journal_put_request(AppState* state, Collection* collection,
+                                   unsigned int base_generation, int request_index) {
+    if (!state || !collection) {
+        return;
+    }
+
+    size_t length = 0;
+    unsigned long seq = collection->journal_seq + 1;
+    char* record = collection_journal_encode_put_request(collection, request_index, seq, &length);
+    journal_edit(state, collection, base_generation, seq, record, length);
+}
+
+void app_state_journal_remove_request(AppState* state, Collection* collection,
+                                      unsigned int base_generation, int request_index) {
+    if (!state || !collection) {
+        return;
     }
 
-    const char* current_method = (state->selected_method_index >= 0 && state->selected_method_index < method_count) ?
-                                methods[state->selected_method_index] : "GET";
-    bool method_supports_body = (strcmp(current_method, "POST") == 0 ||
-                                strcmp(current_method, "PUT") == 0 ||
-                                strcmp(current_method, "PATCH") == 0 ||
-                                strcmp(current_method, "DELETE") == 0);
+    size_t length = 0;
+    unsigned long seq = collection->journal_seq + 1;
+    char* record = collection_journal_encode_remove_request(request_index, seq, &length);
+    journal_edit(state, collection, base_generation, seq, record, length);
+}
+
+void app_state_journal_set_collection(AppState* state, Collection* collection,
+                                      unsigned int base_generation) {
+    if (!state || !collection) {
+        return;
+    }
 
-    if (method_supports_body && strlen(state->body_buffer) > 0) {
+    size_t length = 0;
+    unsigned long seq = collection->journal_seq + 1;
+    char* record = collection_journal_encode_set_collection(collection, seq, &length);
+    journal_edit(state, collection, base_generation, seq, record, length);
+}
 
-        bool body_changed = false;
-        size_t body_buffer_len = strlen(state->body_buffer);
+static double app_state_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
 
-        if (!active_request->body || active_request->body_size != body_buffer_len ||
-            memcmp(active_request->body, state->body_buffer, body_buffer_len) != 0) {
-            body_changed = true;
+static void queue_collection_file(AppState* state, const char* collection_id, int collection_index) {
+    /* with no file at all the load fails and the placeholder is dropped like before */
+    char* filepath = persistence_find_collection_file(collection_id);
+    if (!filepath) {
+        filepath = persistence_get_collection_file_path(collection_id);
+    }
+    if (filepath) {
+        collection_loader_add_file(state->collection_loader, filepath, collection_index);
+        free(filepath);
+    }
+}
+
+/* files the manifest does not list, such as ones copied in by hand, are appended as they load */
+static void queue_unlisted_collection_file(const char* filepath, void* user_data) {
+    collection_loader_add_file((CollectionLoader*)user_data, filepath, -1);
+}
+
+/* fills the tree from the manifest and starts reading the collection files in the background */
+static void start_collection_loads(AppState* state) {
+    CollectionManager* manager = state->collection_manager;
+    state->load_started_ms = app_state_now_ms();
+
+    int listed = persistence_load_collection_manifest(manager);
+    state->manifest_ms = app_state_now_ms() - state->load_started_ms;
+
+    for (int i = 0; i < manager->count; i++) {
+        if (!manager->collections[i].loaded) {
+            queue_collection_file(state, manager->collections[i].id, i);
         }
+    }
+    persistence_for_each_collection_file(queue_unlisted_collection_file, state->collection_loader);
 
-        if (body_changed) {
-            int result = request_set_body(active_request, state->body_buffer, body_buffer_len);
-            if (result == 0) {
-                changes_made = true;
-            }
+    state->collections_loading = true;
+
+    /* without a manifest there is nothing to draw yet, so wait for the files as before */
+    if (listed < 0) {
+        collection_loader_wait_all(state->collection_loader);
+        app_state_poll_collection_loads(state);
+    }
+}
+
+/* manager index of the placeholder a file was queued for, -1 for an unlisted file */
+static int find_placeholder(CollectionManager* manager, const LoadedCollection* loaded) {
+    if (loaded->hint < 0) {
+        return -1;
+    }
+
+    int hint = loaded->hint;
+    if (hint < manager->count && !manager->collections[hint].loaded &&
+        strcmp(manager->collections[hint].id, loaded->file_id) == 0) {
+        return hint;
+    }
+
+    /* collections were deleted or added since the file was queued */
+    for (int i = 0; i < manager->count; i++) {
+        if (!manager->collections[i].loaded && strcmp(manager->collections[i].id, loaded->file_id) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* puts a finished file into the manager, returns its index or -1 when it was not usable.
+ * collection level auth is applied when the collection lands at auth_index */
+static int adopt_loaded_collection(AppState* state, LoadedCollection* loaded, int placeholder, int auth_index) {
+    CollectionManager* manager = state->collection_manager;
+
+    if (loaded->result != PERSISTENCE_SUCCESS || loaded->duplicate) {
+        if (loaded->duplicate) {
+            printf("Skipping duplicate collection: %s\n", loaded->collection.name);
         }
+        loaded_collection_cleanup(loaded);
+        return -1;
+    }
+
+    int index = placeholder;
+    if (index >= 0) {
+        /* a new generation so everything cached for the empty placeholder is rebuilt */
+        Collection* collection = &manager->collections[index];
+        unsigned int generation = collection->generation + 1;
+        collection_move(collection, &loaded->collection);
+        collection->generation = generation;
+        collection_mark_saved(collection, generation);
     } else {
+        /* just read from disk, nothing to write back */
+        collection_mark_saved(&loaded->collection, loaded->collection.generation);
+        index = collection_manager_adopt_collection(manager, &loaded->collection);
+        if (index < 0) {
+            loaded_collection_cleanup(loaded);
+            return -1;
+        }
+    }
+
+    /* collection level auth belongs to whichever collection is open */
+    if (loaded->has_auth && index == auth_index) {
+        persistence_apply_auth_to_app_state(&loaded->auth, state);
+    }
+
+    state->collections_loaded++;
+    loaded_collection_cleanup(loaded);
+    return index;
+}
+
+/* drops a placeholder whose file could not be read and keeps the indices pointing at the same collections */
+static void remove_placeholder(AppState* state, int collection_index) {
+    if (collection_manager_remove_collection(state->collection_manager, collection_index) != 0) {
+        return;
+    }
+
+    if (state->selected_collection_index == collection_index) {
+        state->selected_collection_index = -1;
+    } else if (state->selected_collection_index > collection_index) {
+        state->selected_collection_index--;
+    }
+
+    for (int i = 0; i < state->request_tab_count; i++) {
+        RequestTab* tab = &state->request_tabs[i];
+        if (tab->collection_index == collection_index) {
+            tab->collection_index = -1;
+            tab->request_index = -1;
+        } else if (tab->collection_index > collection_index) {
+            tab->collection_index--;
+        }
+    }
+}
+
+/* takes the files the loader finished, called once per frame */
+void app_state_poll_collection_loads(AppState* state) {
+    if (!state || !state->collection_loader || !state->collections_loading) {
+        return;
+    }
+
+    CollectionManager* manager = state->collection_manager;
+    bool finished = collection_loader_get_pending_count(state->collection_loader) == 0;
+
+    LoadedCollection loaded;
+    while (collection_loader_poll(state->collection_loader, &loaded)) {
+        adopt_loaded_collection(state, &loaded, find_placeholder(manager, &loaded), manager->active_collection_index);
+    }
+
+    if (!finished) {
+        return;
+    }
+
+    /* whatever is still a placeholder had a missing, broken or duplicate file */
+    for (int i = manager->count - 1; i >= 0; i--) {
+        if (!manager->collections[i].loaded) {
+            printf("Could not load collection: %s\n", manager->collections[i].name);
+            remove_placeholder(state, i);
+        }
+    }
+
+    state->collections_loading = false;
+    state->load_duration_ms = app_state_now_ms() - state->load_started_ms;
+
+    if (getenv("TINYREQUEST_STARTUP_STATS")) {
+        printf("startup: manifest %.1f ms, %d collections with %d requests loaded in %.1f ms, peak rss %ld kb\n",
+               state->manifest_ms, state->collections_loaded,
+               collection_manager_get_total_requests(manager), state->load_duration_ms,
+               profiler_get_peak_rss_kb());
+    }
+}
+
+static int load_placeholder(AppState* state, int collection_index, bool apply_auth) {
+    Collection* collection = collection_manager_get_collection(state->collection_manager, collection_index);
+    if (!collection) {
+        return -1;
+    }
+    if (collection->loaded) {
+        return 0;
+    }
+
+    LoadedCollection loaded;
+    if (collection_loader_take(state->collection_loader, collection->id, &loaded) &&
+        adopt_loaded_collection(state, &loaded, collection_index, apply_auth ? collection_index : -1) >= 0) {
+        return 0;
+    }
+
+    /* the placeholder stays until loading finishes so no index moves under the caller */
+    snprintf(state->status_message, sizeof(state->status_message), "Could not load collection '%.*s'",
+             (int)(sizeof(state->status_message) - sizeof("Could not load collection ''")), collection->name);
+    return -1;
+}
+
+/* reads a placeholder right away, blocking until its file is parsed. returns 0 once it is usable */
+int app_state_ensure_collection_loaded(AppState* state, int collection_index) {
+    if (!state || !state->collection_manager) {
+        return -1;
+    }
 
-        if (active_request->body) {
+    return load_placeholder(state, collection_index,
+                            collection_index == state->collection_manager->active_collection_index);
+}
+
+/* moves a placeholder to the front of the loader queue without waiting for it */
+void app_state_request_collection_load(AppState* state, int collection_index) {
+    if (!state || !state->collection_manager) {
+        return;
+    }
+
+    Collection* collection = collection_manager_get_collection(state->collection_manager, collection_index);
+    if (collection && !collection->loaded) {
+        collection_loader_prioritize(state->collection_loader, collection->id);
+    }
+}
+
+/* checks if auto-save is needed and performs it if necessary */
+void app_state_check_and_perform_auto_save(AppState* state) {
+    if (!state || !state->auto_save_enabled) {
+        return;
+    }
+
+    if (!app_state_should_auto_save(state)) {
+        return;
+    }
+
+    /* nothing was edited since the last save, just restart the interval */
+    if (!state->changes_since_last_save) {
+        app_state_update_auto_save_time(state);
+        return;
+    }
+
+    if (app_state_perform_auto_save(state) == 0) {
+        state->changes_since_last_save = false;
+    }
+}
+
+/* returns true if the ui edited a field since it was last copied to the request */
+static bool sync_field_pending(const AppState* state, int field) {
+    return state->field_generation[field] != state->synced_generation[field];
+}
+
+/* copies one string field if it differs, returns true if anything changed */
+static bool sync_string_field(char* dest, size_t dest_size, const char* src) {
+    if (strcmp(dest, src) == 0) {
+        return false;
+    }
+    snprintf(dest, dest_size, "%s", src);
+    return true;
+}
+
+/* copies the authentication buffers and checkboxes into the request */
+static bool sync_auth_to_request(AppState* state, Request* request) {
+    bool changes_made = false;
+
+    if (request->selected_auth_type != state->selected_auth_type) {
+        request->selected_auth_type = state->selected_auth_type;
+        changes_made = true;
+    }
+    if (request->auth_api_key_location != state->auth_api_key_location) {
+        request->auth_api_key_location = state->auth_api_key_location;
+        changes_made = true;
+    }
+
+    changes_made |= sync_string_field(request->auth_api_key_name, sizeof(request->auth_api_key_name), state->auth_api_key_name);
+    changes_made |= sync_string_field(request->auth_api_key_value, sizeof(request->auth_api_key_value), state->auth_api_key_value);
+    changes_made |= sync_string_field(request->auth_bearer_token, sizeof(request->auth_bearer_token), state->auth_bearer_token);
+    changes_made |= sync_string_field(request->auth_basic_username, sizeof(request->auth_basic_username), state->auth_basic_username);
+    changes_made |= sync_string_field(request->auth_basic_password, sizeof(request->auth_basic_password), state->auth_basic_password);
+    changes_made |= sync_string_field(request->auth_oauth_token, sizeof(request->auth_oauth_token), state->auth_oauth_token);
+
+    // Synchronize authentication checkboxes
+    if (request->auth_api_key_enabled != state->auth_api_key_enabled ||
+        request->auth_bearer_enabled != state->auth_bearer_enabled ||
+        request->auth_basic_enabled != state->auth_basic_enabled ||
+        request->auth_oauth_enabled != state->auth_oauth_enabled) {
+        request->auth_api_key_enabled = state->auth_api_key_enabled;
+        request->auth_bearer_enabled = state->auth_bearer_enabled;
+        request->auth_basic_enabled = state->auth_basic_enabled;
+        request->auth_oauth_enabled = state->auth_oauth_enabled;
+        changes_made = true;
+    }
+
+    return changes_made;
+}
+
+/* synchronizes ui buffer data to the active request structure, copying only fields edited since the last sync */
+void app_state_sync_ui_to_request(AppState* state) {
+    if (!state) {
+        return;
+    }
+
+    Request* active_request = app_state_get_active_request(state);
+    if (!active_request) {
+        active_request = &state->current_request;
+
+        if (strlen(active_request->method) == 0) {
+            strncpy(active_request->method, "GET", sizeof(active_request->method) - 1);
+            active_request->method[sizeof(active_request->method) - 1] = '\0';
+        }
+        if (strlen(active_request->url) == 0) {
+            strncpy(active_request->url, "https://", sizeof(active_request->url) - 1);
+            active_request->url[sizeof(active_request->url) - 1] = '\0';
+        }
+    }
+
+    bool changes_made = false;
+
+    // Synchronize authentication data from global state to request
+    if (sync_field_pending(state, SYNC_FIELD_AUTH)) {
+        changes_made |= sync_auth_to_request(state, active_request);
+    }
+
+    const char* methods[] = { "GET", "POST", "PUT", "DELETE", "PATCH", "HEAD", "OPTIONS" };
+    const int method_count = sizeof(methods) / sizeof(methods[0]);
+    bool method_pending = sync_field_pending(state, SYNC_FIELD_METHOD);
+    if (method_pending && state->selected_method_index >= 0 && state->selected_method_index < method_count) {
+        changes_made |= sync_string_field(active_request->method, sizeof(active_request->method),
+                                          methods[state->selected_method_index]);
+    }
+
+    if (sync_field_pending(state, SYNC_FIELD_URL)) {
+        changes_made |= sync_string_field(active_request->url, sizeof(active_request->url), state->url_buffer);
+    }
+
+    /* the method decides whether a body is sent, so a method change re-checks the body too */
+    if (method_pending || sync_field_pending(state, SYNC_FIELD_BODY)) {
+        const char* current_method = (state->selected_method_index >= 0 && state->selected_method_index < method_count) ?
+                                    methods[state->selected_method_index] : "GET";
+        bool method_supports_body = (strcmp(current_method, "POST") == 0 ||
+                                    strcmp(current_method, "PUT") == 0 ||
+                                    strcmp(current_method, "PATCH") == 0 ||
+                                    strcmp(current_method, "DELETE") == 0);
+
+        if (method_supports_body && state->body_buffer.length > 0) {
+            if (!active_request->body ||
+                !text_buffer_equals(&state->body_buffer, active_request->body, active_request->body_size)) {
+                if (request_set_body(active_request, state->body_buffer.data, state->body_buffer.length) == 0) {
+                    changes_made = true;
+                }
+            }
+        } else if (active_request->body) {
             free(active_request->body);
             active_request->body = NULL;
             active_request->body_size = 0;
@@ -679,16 +1729,19 @@ void app_state_sync_ui_to_request(AppState* state) {
         }
     }
 
-    if (active_request != &state->current_request) {
-        changes_made = true;
-    }
-
+    memcpy(state->synced_generation, state->field_generation, sizeof(state->synced_generation));
     state->ui_state_dirty = false;
     state->last_ui_sync = time(NULL);
 
-    if (changes_made && active_request != &state->current_request) {
-        app_state_mark_changed(state);
+    Collection* collection = app_state_get_active_collection(state);
+    if ((changes_made || state->active_request_edited) && collection &&
+        active_request != &state->current_request) {
+        unsigned int base_generation = collection->generation;
+        collection_update_modified_time(collection);
+        app_state_journal_put_request(state, collection, base_generation,
+                                      state->collection_manager->active_request_index);
     }
+    state->active_request_edited = false;
 }
 
 /* synchronizes active request data to ui buffers */
@@ -702,20 +1755,6 @@ void app_state_sync_request_to_ui(AppState* state) {
         active_request = &state->current_request;
     }
 
-    printf("DEBUG: app_state_sync_request_to_ui called - active_request: %p\n", (void*)active_request);
-    if (active_request) {
-        printf("DEBUG: BEFORE sync - request auth data - type: %d, api_key_name: '%s', bearer_token: '%s', api_key_enabled: %s, bearer_enabled: %s\n",
-               active_request->selected_auth_type,
-               active_request->auth_api_key_name,
-               active_request->auth_bearer_token,
-               active_request->auth_api_key_enabled ? "true" : "false",
-               active_request->auth_bearer_enabled ? "true" : "false");
-        printf("DEBUG: BEFORE sync - global state auth data - type: %d, api_key_name: '%s', bearer_token: '%s'\n",
-               state->selected_auth_type,
-               state->auth_api_key_name,
-               state->auth_bearer_token);
-    }
-
     const char* methods[] = { "GET", "POST", "PUT", "DELETE", "PATCH", "HEAD", "OPTIONS" };
     const int method_count = sizeof(methods) / sizeof(methods[0]);
 
@@ -754,20 +1793,10 @@ void app_state_sync_request_to_ui(AppState* state) {
     state->auth_basic_enabled = active_request->auth_basic_enabled;
     state->auth_oauth_enabled = active_request->auth_oauth_enabled;
     
-    printf("DEBUG: AFTER sync - global state auth data - type: %d, api_key_name: '%s', bearer_token: '%s', api_key_enabled: %s, bearer_enabled: %s\n",
-           state->selected_auth_type,
-           state->auth_api_key_name,
-           state->auth_bearer_token,
-           state->auth_api_key_enabled ? "true" : "false",
-           state->auth_bearer_enabled ? "true" : "false");
-
     if (active_request->body && active_request->body_size > 0) {
-        size_t copy_size = (active_request->body_size < sizeof(state->body_buffer) - 1) ?
-                          active_request->body_size : sizeof(state->body_buffer) - 1;
-        memcpy(state->body_buffer, active_request->body, copy_size);
-        state->body_buffer[copy_size] = '\0';
+        text_buffer_set(&state->body_buffer, active_request->body, active_request->body_size);
 
-        const char* content = state->body_buffer;
+        const char* content = state->body_buffer.data;
 
         app_state_clear_content_buffers(state);
 
@@ -823,17 +1852,30 @@ void app_state_sync_request_to_ui(AppState* state) {
             }
         }
     } else {
-        state->body_buffer[0] = '\0';
+        text_buffer_clear(&state->body_buffer);
         app_state_clear_content_buffers(state);
     }
 
+    /* the buffers now mirror the request, nothing is waiting to go back */
+    memcpy(state->synced_generation, state->field_generation, sizeof(state->synced_generation));
     state->request_data_dirty = false;
     state->last_ui_sync = time(NULL);
 }
 
-/* marks ui state as dirty to trigger synchronization */
+/* records a ui edit of one request field so the next sync copies just that field */
+void app_state_mark_field_dirty(AppState* state, SyncField field) {
+    if (state && field >= 0 && field < SYNC_FIELD_COUNT) {
+        state->field_generation[field]++;
+        state->ui_state_dirty = true;
+    }
+}
+
+/* marks every field as edited, for changes that are not tied to a single field */
 void app_state_mark_ui_dirty(AppState* state) {
     if (state) {
+        for (int i = 0; i < SYNC_FIELD_COUNT; i++) {
+            state->field_generation[i]++;
+        }
         state->ui_state_dirty = true;
     }
 }
@@ -879,6 +1921,10 @@ void app_state_mark_changed(AppState* state) {
     state->unsaved_changes = true;
     state->changes_since_last_save = true;
     state->last_change_time = time(NULL);
+
+    /* the edit reaches the active request on the next sync, which journals it */
+    state->active_request_edited = true;
+    state->ui_state_dirty = true;
 }
 
 /* marks the application state as saved */
@@ -903,26 +1949,26 @@ time_t app_state_get_last_change_time(AppState* state) {
 }
 
 /* returns the appropriate content buffer for the specified type */
-char* app_state_get_content_buffer(AppState* state, int content_type) {
+TextBuffer* app_state_get_content_buffer(AppState* state, int content_type) {
     if (!state) {
         return NULL;
     }
 
     switch (content_type) {
         case CONTENT_TYPE_JSON:
-            return state->json_body_buffer;
+            return &state->json_body_buffer;
         case CONTENT_TYPE_PLAIN_TEXT:
-            return state->plain_text_body_buffer;
+            return &state->plain_text_body_buffer;
         case CONTENT_TYPE_XML:
-            return state->xml_body_buffer;
+            return &state->xml_body_buffer;
         case CONTENT_TYPE_YAML:
-            return state->yaml_body_buffer;
+            return &state->yaml_body_buffer;
         case CONTENT_TYPE_FORM_DATA:
         case CONTENT_TYPE_FORM_URL_ENCODED:
 
-            return state->body_buffer;
+            return &state->body_buffer;
         default:
-            return state->body_buffer; 
+            return &state->body_buffer; 
     }
 }
 
@@ -932,31 +1978,10 @@ void app_state_set_content_buffer(AppState* state, int content_type, const char*
         return;
     }
 
-    char* buffer = app_state_get_content_buffer(state, content_type);
-    if (buffer) {
-        size_t buffer_size;
-        switch (content_type) {
-            case CONTENT_TYPE_JSON:
-                buffer_size = sizeof(state->json_body_buffer);
-                break;
-            case CONTENT_TYPE_PLAIN_TEXT:
-                buffer_size = sizeof(state->plain_text_body_buffer);
-                break;
-            case CONTENT_TYPE_XML:
-                buffer_size = sizeof(state->xml_body_buffer);
-                break;
-            case CONTENT_TYPE_YAML:
-                buffer_size = sizeof(state->yaml_body_buffer);
-                break;
-            default:
-                buffer_size = sizeof(state->body_buffer);
-                break;
-        }
-
-        strncpy(buffer, content, buffer_size - 1);
-        buffer[buffer_size - 1] = '\0';
-        app_state_mark_ui_dirty(state);
-        app_state_set_unsaved_changes(state, true);
+    TextBuffer* buffer = app_state_get_content_buffer(state, content_type);
+    if (buffer && buffer->data != content) {
+        /* filling a per-type buffer is not an edit, the body itself syncs through body_buffer */
+        text_buffer_set_cstr(buffer, content);
     }
 }
 
@@ -966,10 +1991,10 @@ void app_state_clear_content_buffers(AppState* state) {
         return;
     }
 
-    memset(state->json_body_buffer, 0, sizeof(state->json_body_buffer));
-    memset(state->plain_text_body_buffer, 0, sizeof(state->plain_text_body_buffer));
-    memset(state->xml_body_buffer, 0, sizeof(state->xml_body_buffer));
-    memset(state->yaml_body_buffer, 0, sizeof(state->yaml_body_buffer));
+    text_buffer_clear(&state->json_body_buffer);
+    text_buffer_clear(&state->plain_text_body_buffer);
+    text_buffer_clear(&state->xml_body_buffer);
+    text_buffer_clear(&state->yaml_body_buffer);
 }
 
 /* synchronizes content from specific buffer to main body buffer */
@@ -978,12 +2003,11 @@ void app_state_sync_content_to_body_buffer(AppState* state, int content_type) {
         return;
     }
 
-    char* source_buffer = app_state_get_content_buffer(state, content_type);
+    TextBuffer* source_buffer = app_state_get_content_buffer(state, content_type);
     if (source_buffer) {
 
-        if (source_buffer != state->body_buffer) {
-            strncpy(state->body_buffer, source_buffer, sizeof(state->body_buffer) - 1);
-            state->body_buffer[sizeof(state->body_buffer) - 1] = '\0';
+        if (source_buffer != &state->body_buffer) {
+            text_buffer_set(&state->body_buffer, source_buffer->data, source_buffer->length);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,307 @@
+/**
+ * little endian encoding for tinyrequest's binary files
+ */
+
+#include "binary_io.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef TINYREQUEST_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/* level 3 is zstd's default, fast enough to run on every save */
+#define BINARY_ZSTD_LEVEL 3
+
+uint32_t binary_checksum(const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint64_t binary_hash64(const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void byte_writer_reserve(ByteWriter* writer, size_t extra) {
+    if (writer->failed || writer->length + extra <= writer->capacity) {
+        return;
+    }
+
+    size_t capacity = writer->capacity > 0 ? writer->capacity : 256;
+    while (capacity < writer->length + extra) {
+        capacity *= 2;
+    }
+
+    unsigned char* data = (unsigned char*)realloc(writer->data, capacity);
+    if (!data) {
+        writer->failed = true;
+        return;
+    }
+    writer->data = data;
+    writer->capacity = capacity;
+}
+
+void byte_writer_bytes(ByteWriter* writer, const void* bytes, size_t length) {
+    byte_writer_reserve(writer, length);
+    if (!writer->failed && length > 0) {
+        memcpy(writer->data + writer->length, bytes, length);
+        writer->length += length;
+    }
+}
+
+void byte_writer_u8(ByteWriter* writer, unsigned int value) {
+    unsigned char byte = (unsigned char)value;
+    byte_writer_bytes(writer, &byte, 1);
+}
+
+void byte_writer_u32(ByteWriter* writer, uint32_t value) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    byte_writer_bytes(writer, bytes, sizeof(bytes));
+}
+
+void byte_writer_u64(ByteWriter* writer, uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    byte_writer_bytes(writer, bytes, sizeof(bytes));
+}
+
+void byte_writer_data(ByteWriter* writer, const char* data, size_t length) {
+    if (length > UINT32_MAX) {
+        writer->failed = true;
+        return;
+    }
+    byte_writer_u32(writer, (uint32_t)length);
+    byte_writer_bytes(writer, data, length);
+}
+
+void byte_writer_string(ByteWriter* writer, const char* text) {
+    byte_writer_data(writer, text ? text : "", text ? strlen(text) : 0);
+}
+
+void byte_writer_request(ByteWriter* writer, const Request* request) {
+    byte_writer_string(writer, request->method);
+    byte_writer_string(writer, request->url);
+
+    byte_writer_u32(writer, (uint32_t)request->headers.count);
+    for (int i = 0; i < request->headers.count; i++) {
+        byte_writer_string(writer, request->headers.headers[i].name);
+        byte_writer_string(writer, request->headers.headers[i].value);
+    }
+
+    byte_writer_data(writer, request->body, request->body ? request->body_size : 0);
+
+    byte_writer_u32(writer, (uint32_t)request->selected_auth_type);
+    byte_writer_string(writer, request->auth_api_key_name);
+    byte_writer_string(writer, request->auth_api_key_value);
+    byte_writer_string(writer, request->auth_bearer_token);
+    byte_writer_string(writer, request->auth_basic_username);
+    byte_writer_string(writer, request->auth_basic_password);
+    byte_writer_string(writer, request->auth_oauth_token);
+    byte_writer_u32(writer, (uint32_t)request->auth_api_key_location);
+    byte_writer_u8(writer, (request->auth_api_key_enabled ? 1u : 0u) | (request->auth_bearer_enabled ? 2u : 0u) |
+                           (request->auth_basic_enabled ? 4u : 0u) | (request->auth_oauth_enabled ? 8u : 0u));
+}
+
+void byte_writer_patch_u32(ByteWriter* writer, size_t offset, uint32_t value) {
+    if (writer->failed || offset + 4 > writer->length) {
+        return;
+    }
+    for (int i = 0; i < 4; i++) {
+        writer->data[offset + i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+void byte_writer_patch_u64(ByteWriter* writer, size_t offset, uint64_t value) {
+    byte_writer_patch_u32(writer, offset, (uint32_t)value);
+    byte_writer_patch_u32(writer, offset + 4, (uint32_t)(value >> 32));
+}
+
+void byte_reader_init(ByteReader* reader, const void* data, size_t length) {
+    reader->cur = (const unsigned char*)data;
+    reader->end = reader->cur + length;
+    reader->failed = false;
+}
+
+unsigned int byte_reader_u8(ByteReader* reader) {
+    if (reader->failed || reader->cur >= reader->end) {
+        reader->failed = true;
+        return 0;
+    }
+    return *reader->cur++;
+}
+
+uint32_t byte_reader_u32(ByteReader* reader) {
+    if (reader->failed || reader->end - reader->cur < 4) {
+        reader->failed = true;
+        return 0;
+    }
+
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)reader->cur[i] << (8 * i);
+    }
+    reader->cur += 4;
+    return value;
+}
+
+uint64_t byte_reader_u64(ByteReader* reader) {
+    uint64_t low = byte_reader_u32(reader);
+    uint64_t high = byte_reader_u32(reader);
+    return low | (high << 32);
+}
+
+const char* byte_reader_data(ByteReader* reader, size_t* length) {
+    uint32_t size = byte_reader_u32(reader);
+    if (reader->failed || (size_t)(reader->end - reader->cur) < size) {
+        reader->failed = true;
+        return NULL;
+    }
+
+    const char* data = (const char*)reader->cur;
+    reader->cur += size;
+    *length = size;
+    return data;
+}
+
+void byte_reader_field(ByteReader* reader, char* dest, size_t dest_size) {
+    size_t length = 0;
+    const char* data = byte_reader_data(reader, &length);
+    if (!data) {
+        dest[0] = '\0';
+        return;
+    }
+    if (length >= dest_size) {
+        length = dest_size - 1;
+    }
+    memcpy(dest, data, length);
+    dest[length] = '\0';
+}
+
+char* byte_reader_alloc(ByteReader* reader, size_t* length) {
+    const char* data = byte_reader_data(reader, length);
+    if (!data) {
+        return NULL;
+    }
+
+    char* copy = (char*)malloc(*length + 1);
+    if (!copy) {
+        reader->failed = true;
+        return NULL;
+    }
+    memcpy(copy, data, *length);
+    copy[*length] = '\0';
+    return copy;
+}
+
+bool byte_reader_request(ByteReader* reader, Request* request) {
+    byte_reader_field(reader, request->method, sizeof(request->method));
+    byte_reader_field(reader, request->url, sizeof(request->url));
+
+    uint32_t header_count = byte_reader_u32(reader);
+    for (uint32_t i = 0; i < header_count && !reader->failed; i++) {
+        Header header;
+        byte_reader_field(reader, header.name, sizeof(header.name));
+        byte_reader_field(reader, header.value, sizeof(header.value));
+        if (!reader->failed) {
+            header_list_add(&request->headers, header.name, header.value);
+        }
+    }
+
+    size_t body_length = 0;
+    char* body = byte_reader_alloc(reader, &body_length);
+    if (body && body_length > 0) {
+        free(request->body);
+        request->body = body;
+        request->body_size = body_length;
+    } else {
+        free(body);
+    }
+
+    request->selected_auth_type = (int)byte_reader_u32(reader);
+    byte_reader_field(reader, request->auth_api_key_name, sizeof(request->auth_api_key_name));
+    byte_reader_field(reader, request->auth_api_key_value, sizeof(request->auth_api_key_value));
+    byte_reader_field(reader, request->auth_bearer_token, sizeof(request->auth_bearer_token));
+    byte_reader_field(reader, request->auth_basic_username, sizeof(request->auth_basic_username));
+    byte_reader_field(reader, request->auth_basic_password, sizeof(request->auth_basic_password));
+    byte_reader_field(reader, request->auth_oauth_token, sizeof(request->auth_oauth_token));
+    request->auth_api_key_location = (int)byte_reader_u32(reader);
+    unsigned int flags = byte_reader_u8(reader);
+    request->auth_api_key_enabled = (flags & 1u) != 0;
+    request->auth_bearer_enabled = (flags & 2u) != 0;
+    request->auth_basic_enabled = (flags & 4u) != 0;
+    request->auth_oauth_enabled = (flags & 8u) != 0;
+
+    return !reader->failed;
+}
+
+unsigned char* binary_compress(const void* data, size_t length, size_t min_length, size_t* compressed_length) {
+#ifdef TINYREQUEST_HAVE_ZSTD
+    if (length < min_length || length == 0) {
+        return NULL;
+    }
+
+    size_t bound = ZSTD_compressBound(length);
+    unsigned char* compressed = (unsigned char*)malloc(bound);
+    if (!compressed) {
+        return NULL;
+    }
+
+    size_t written = ZSTD_compress(compressed, bound, data, length, BINARY_ZSTD_LEVEL);
+    if (ZSTD_isError(written) || written >= length) {
+        free(compressed);
+        return NULL;
+    }
+
+    *compressed_length = written;
+    return compressed;
+#else
+    (void)data;
+    (void)length;
+    (void)min_length;
+    (void)compressed_length;
+    return NULL;
+#endif
+}
+
+unsigned char* binary_decompress(const void* data, size_t length, size_t raw_length) {
+#ifdef TINYREQUEST_HAVE_ZSTD
+    unsigned char* raw = (unsigned char*)malloc(raw_length > 0 ? raw_length : 1);
+    if (!raw) {
+        return NULL;
+    }
+
+    size_t written = ZSTD_decompress(raw, raw_length, data, length);
+    if (ZSTD_isError(written) || written != raw_length) {
+        free(raw);
+        return NULL;
+    }
+    return raw;
+#else
+    (void)data;
+    (void)length;
+    (void)raw_length;
+    return NULL;
+#endif
+}
+
+bool binary_compression_available(void) {
+#ifdef TINYREQUEST_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
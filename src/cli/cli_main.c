@@ -0,0 +1,763 @@
+/**
+ * tinyrequest-cli, runs collections without a window
+ *
+ * the same collections the app edits run here in ci and on servers: a
+ * collection file in any format the app imports, or a collection the app
+ * saved, picked by name or id. the exit status tells whether every run
+ * passed.
+ *
+ * with --mock the collection is served by the mock server instead, and
+ * --against-mock runs it against a mock server of its own, a test that
+ * needs neither the real api nor a network. --convert rewrites a collection
+ * file between json and the binary .trc format without running it.
+ *
+ * --list-snapshots and --restore-snapshot reach the auto-save snapshots the
+ * app takes. a restore has to run while the app is closed, the app would
+ * save its own collections back over it.
+ */
+
+#include "cli/cli_runner.h"
+#include "cli/cli_report.h"
+#include "collection_importer.h"
+#include "collection_journal.h"
+#include "collection_store.h"
+#include "history_store.h"
+#include "mock_server.h"
+#include "persistence.h"
+#include "snapshot_store.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <signal.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#define dup _dup
+#define dup2 _dup2
+#define fdopen _fdopen
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+#define CLI_EXIT_PASSED 0
+#define CLI_EXIT_FAILED 1
+#define CLI_EXIT_USAGE 2
+
+/* most --request options taken */
+#define CLI_MAX_SELECTED 256
+
+/* how long the history gets to open before the mock serves without it */
+#define CLI_HISTORY_WAIT_MS 10000
+
+typedef struct {
+    const char* source;
+    const char* selected[CLI_MAX_SELECTED];
+    int selected_count;
+    int iterations;
+    double duration_seconds;
+    int concurrency;
+    int format;
+    const char* report_path;
+    const char* har_path;
+    bool har_bodies;
+    bool insecure;
+    bool bail;
+    bool list;
+    bool quiet;
+    bool mock;
+    bool against_mock;
+    const char* convert_path;
+    bool list_snapshots;
+    const char* restore_snapshot;
+    const char* examples_path;
+    MockServerOptions mock_options;
+} CliOptions;
+
+static void print_usage(FILE* out) {
+    fputs("usage: tinyrequest-cli [options] <collection>\n"
+          "       tinyrequest-cli --list-snapshots | --restore-snapshot NAME\n"
+          "\n"
+          "<collection> is a collection file (TinyRequest, Postman v2.1, Insomnia v4 or HAR)\n"
+          "or the name or id of a collection saved by TinyRequest.\n"
+          "\n"
+          "  -r, --request NAME       run only this request, by name or number from 1, repeatable\n"
+          "  -n, --iterations N       run the selection N times (default 1)\n"
+          "  -d, --duration SECONDS   keep running the selection this long, a load test\n"
+          "  -c, --concurrency N      requests in flight at once, 1 to 16 (default 1)\n"
+          "  -o, --output FORMAT      report as text, json or junit (default text)\n"
+          "  -f, --report FILE        write the report to FILE instead of stdout\n"
+          "      --har FILE           write every request and response to a HAR file\n"
+          "      --har-bodies         include bodies in the HAR file\n"
+          "  -k, --insecure           do not verify TLS certificates\n"
+          "      --bail               stop after the first failed request\n"
+          "  -l, --list               list the requests of the collection and exit\n"
+          "      --convert FILE       write the collection to FILE in the other format and exit,\n"
+          "                           TinyRequest json to .trc or .trc to json\n"
+          "  -q, --quiet              no line per response in text output\n"
+          "  -h, --help               show this help\n"
+          "\n"
+          "Auto-save snapshots:\n"
+          "      --list-snapshots     list the snapshots of the saved collections, newest first\n"
+          "      --restore-snapshot NAME\n"
+          "                           put the saved collections back the way snapshot NAME has\n"
+          "                           them, close TinyRequest first. the current state is\n"
+          "                           snapshotted before, so a restore can be undone\n"
+          "\n"
+          "Mock server:\n"
+          "      --mock               serve the collection on 127.0.0.1 until interrupted\n"
+          "      --against-mock       run the collection against a mock server on a free port\n"
+          "      --examples FILE      answer with the responses of this HAR file\n"
+          "      --port N             port for --mock (default 8089)\n"
+          "      --threads N          requests answered at once, 1 to 64 (default 16)\n"
+          "      --latency MS         hold every response back this long\n"
+          "      --jitter MS          and up to this much longer\n"
+          "      --error-rate P       answer this share of requests, 0 to 1, with an error\n"
+          "      --error-status CODE  status of injected errors (default 503)\n"
+          "      --seed N             decides which requests fail and their jitter (default 1)\n"
+          "\n"
+          "The mock answers each request with the response the app last recorded\n"
+          "for it, or with the HAR file's when the collection is one or --examples\n"
+          "names one.\n"
+          "\n"
+          "A run fails when the transfer fails or the status is 400 or above.\n"
+          "Exit status: 0 when every run passed, 1 when one failed, 2 on bad usage\n"
+          "or a collection that could not be read.\n", out);
+}
+
+static bool parse_int(const char* text, int min, int max, int* value) {
+    char* end = NULL;
+    long parsed = text ? strtol(text, &end, 10) : 0;
+    if (!text || end == text || *end != '\0' || parsed < min || parsed > max) {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+static bool parse_rate(const char* text, double* value) {
+    char* end = NULL;
+    double parsed = text ? strtod(text, &end) : -1.0;
+    if (!text || end == text || *end != '\0' || parsed < 0.0 || parsed > 1.0) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+static bool parse_seconds(const char* text, double* value) {
+    char* end = NULL;
+    double parsed = text ? strtod(text, &end) : 0.0;
+    if (!text || end == text || *end != '\0' || parsed <= 0.0) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+static bool is_option(const char* arg, const char* short_name, const char* long_name) {
+    return (short_name && strcmp(arg, short_name) == 0) || strcmp(arg, long_name) == 0;
+}
+
+/* returns -1 to go on, otherwise the exit status */
+static int parse_options(int argc, char** argv, CliOptions* options) {
+    memset(options, 0, sizeof(CliOptions));
+    options->concurrency = 1;
+    options->format = CLI_REPORT_TEXT;
+    mock_server_options_init(&options->mock_options);
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool valid = true;
+
+        if (is_option(arg, "-h", "--help")) {
+            print_usage(stdout);
+            return CLI_EXIT_PASSED;
+        } else if (is_option(arg, "-r", "--request")) {
+            valid = value && options->selected_count < CLI_MAX_SELECTED;
+            if (valid) {
+                options->selected[options->selected_count++] = value;
+            }
+            i++;
+        } else if (is_option(arg, "-n", "--iterations")) {
+            valid = parse_int(value, 1, 100000000, &options->iterations);
+            i++;
+        } else if (is_option(arg, "-d", "--duration")) {
+            valid = parse_seconds(value, &options->duration_seconds);
+            i++;
+        } else if (is_option(arg, "-c", "--concurrency")) {
+            valid = parse_int(value, 1, CLI_RUNNER_MAX_CONCURRENCY, &options->concurrency);
+            i++;
+        } else if (is_option(arg, "-o", "--output")) {
+            options->format = cli_report_parse_format(value);
+            valid = options->format >= 0;
+            i++;
+        } else if (is_option(arg, "-f", "--report")) {
+            options->report_path = value;
+            valid = value != NULL;
+            i++;
+        } else if (is_option(arg, NULL, "--har")) {
+            options->har_path = value;
+            valid = value != NULL;
+            i++;
+        } else if (is_option(arg, NULL, "--har-bodies")) {
+            options->har_bodies = true;
+        } else if (is_option(arg, "-k", "--insecure")) {
+            options->insecure = true;
+        } else if (is_option(arg, NULL, "--bail")) {
+            options->bail = true;
+        } else if (is_option(arg, "-l", "--list")) {
+            options->list = true;
+        } else if (is_option(arg, NULL, "--convert")) {
+            options->convert_path = value;
+            valid = value != NULL;
+            i++;
+        } else if (is_option(arg, NULL, "--list-snapshots")) {
+            options->list_snapshots = true;
+        } else if (is_option(arg, NULL, "--restore-snapshot")) {
+            options->restore_snapshot = value;
+            valid = value != NULL;
+            i++;
+        } else if (is_option(arg, "-q", "--quiet")) {
+            options->quiet = true;
+        } else if (is_option(arg, NULL, "--mock")) {
+            options->mock = true;
+        } else if (is_option(arg, NULL, "--against-mock")) {
+            options->against_mock = true;
+        } else if (is_option(arg, NULL, "--examples")) {
+            options->examples_path = value;
+            valid = value != NULL;
+            i++;
+        } else if (is_option(arg, NULL, "--port")) {
+            valid = parse_int(value, 0, 65535, &options->mock_options.port);
+            i++;
+        } else if (is_option(arg, NULL, "--threads")) {
+            valid = parse_int(value, 1, MOCK_SERVER_MAX_THREADS, &options->mock_options.threads);
+            i++;
+        } else if (is_option(arg, NULL, "--latency")) {
+            valid = parse_int(value, 0, MOCK_SERVER_MAX_DELAY_MS, &options->mock_options.latency_ms);
+            i++;
+        } else if (is_option(arg, NULL, "--jitter")) {
+            valid = parse_int(value, 0, MOCK_SERVER_MAX_DELAY_MS, &options->mock_options.jitter_ms);
+            i++;
+        } else if (is_option(arg, NULL, "--error-rate")) {
+            valid = parse_rate(value, &options->mock_options.error_rate);
+            i++;
+        } else if (is_option(arg, NULL, "--error-status")) {
+            valid = parse_int(value, 100, 599, &options->mock_options.error_status);
+            i++;
+        } else if (is_option(arg, NULL, "--seed")) {
+            int seed = 0;
+            valid = parse_int(value, 0, 2147483647, &seed);
+            options->mock_options.seed = (uint64_t)seed;
+            i++;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            fprintf(stderr, "tinyrequest-cli: unknown option %s\n", arg);
+            return CLI_EXIT_USAGE;
+        } else if (!options->source) {
+            options->source = arg;
+        } else {
+            fprintf(stderr, "tinyrequest-cli: only one collection can be run at a time\n");
+            return CLI_EXIT_USAGE;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "tinyrequest-cli: bad or missing value for %s\n", arg);
+            return CLI_EXIT_USAGE;
+        }
+    }
+
+    /* snapshots cover every saved collection, they take no collection or run options */
+    if (options->list_snapshots || options->restore_snapshot) {
+        if (options->source || (options->list_snapshots && options->restore_snapshot)) {
+            fprintf(stderr, "tinyrequest-cli: --list-snapshots and --restore-snapshot go on their own\n");
+            return CLI_EXIT_USAGE;
+        }
+        return -1;
+    }
+    if (!options->source) {
+        print_usage(stderr);
+        return CLI_EXIT_USAGE;
+    }
+    if (options->convert_path && (options->mock || options->against_mock || options->list)) {
+        fprintf(stderr, "tinyrequest-cli: --convert does not go with --mock, --against-mock or --list\n");
+        return CLI_EXIT_USAGE;
+    }
+    if (options->mock && options->against_mock) {
+        fprintf(stderr, "tinyrequest-cli: --mock and --against-mock do not go together\n");
+        return CLI_EXIT_USAGE;
+    }
+    if (options->examples_path && !options->mock && !options->against_mock) {
+        fprintf(stderr, "tinyrequest-cli: --examples needs --mock or --against-mock\n");
+        return CLI_EXIT_USAGE;
+    }
+    if (options->mock_options.latency_ms + options->mock_options.jitter_ms > MOCK_SERVER_MAX_DELAY_MS) {
+        fprintf(stderr, "tinyrequest-cli: latency and jitter add up to more than %d ms\n", MOCK_SERVER_MAX_DELAY_MS);
+        return CLI_EXIT_USAGE;
+    }
+    return -1;
+}
+
+/* reads a collection the app saved, with the edits its journal holds on top */
+static int load_saved_collection(const char* collection_id, Collection* collection) {
+    char* filepath = persistence_find_collection_file(collection_id);
+    if (!filepath) {
+        return PERSISTENCE_ERROR_FILE_NOT_FOUND;
+    }
+
+    int result = persistence_read_collection_file(collection, filepath, NULL, NULL);
+    free(filepath);
+    if (result == PERSISTENCE_SUCCESS) {
+        collection_journal_replay(collection);
+    }
+    return result;
+}
+
+typedef struct {
+    const char* name;
+    char id[64];
+} SavedCollectionSearch;
+
+static void match_collection_file(const char* filepath, void* user_data) {
+    SavedCollectionSearch* search = (SavedCollectionSearch*)user_data;
+    if (search->id[0] != '\0') {
+        return;
+    }
+
+    Collection collection;
+    memset(&collection, 0, sizeof(Collection));
+    if (persistence_read_collection_file(&collection, filepath, NULL, NULL) == PERSISTENCE_SUCCESS &&
+        strcmp(collection.name, search->name) == 0) {
+        snprintf(search->id, sizeof(search->id), "%s", collection.id);
+    }
+    collection_cleanup(&collection);
+}
+
+/* a file is imported, anything else is looked up among the saved
+ * collections by id and then by name. format says what the file was,
+ * COLLECTION_IMPORT_UNKNOWN for a saved collection */
+static int load_collection(const char* source, Collection* collection, int* format) {
+    *format = COLLECTION_IMPORT_UNKNOWN;
+    if (persistence_file_exists(source)) {
+        return collection_import_file(collection, source, format, NULL, NULL);
+    }
+
+    if (load_saved_collection(source, collection) == PERSISTENCE_SUCCESS) {
+        return PERSISTENCE_SUCCESS;
+    }
+
+    /* the manifest has every name without reading a collection, older
+     * setups without one have their files read until a name matches */
+    SavedCollectionSearch search;
+    memset(&search, 0, sizeof(search));
+    search.name = source;
+
+    CollectionManager* manager = collection_manager_create();
+    if (manager && persistence_load_collection_manifest(manager) == PERSISTENCE_SUCCESS) {
+        int index = collection_manager_find_collection_by_name(manager, source);
+        Collection* placeholder = collection_manager_get_collection(manager, index);
+        if (placeholder) {
+            snprintf(search.id, sizeof(search.id), "%s", placeholder->id);
+        }
+    } else {
+        persistence_for_each_collection_file(match_collection_file, &search);
+    }
+    collection_manager_destroy(manager);
+
+    if (search.id[0] == '\0') {
+        return PERSISTENCE_ERROR_FILE_NOT_FOUND;
+    }
+    return load_saved_collection(search.id, collection);
+}
+
+/* rewrites a collection file, or the file of a saved collection, in the
+ * other format. auth and cookies go along, the converter reads and writes
+ * them the way the app does */
+static int convert_collection(const char* source, const char* target) {
+    bool is_file = persistence_file_exists(source);
+    char* saved_path = is_file ? NULL : persistence_find_collection_file(source);
+    const char* filepath = is_file ? source : saved_path;
+    if (!filepath) {
+        fprintf(stderr, "tinyrequest-cli: %s: no such collection file\n", source);
+        return CLI_EXIT_USAGE;
+    }
+
+    bool to_store = collection_store_is_store_path(target);
+    if (collection_store_is_store_path(filepath) == to_store) {
+        fprintf(stderr, "tinyrequest-cli: --convert goes from json to %s or from %s to json\n",
+                COLLECTION_STORE_EXTENSION, COLLECTION_STORE_EXTENSION);
+        free(saved_path);
+        return CLI_EXIT_USAGE;
+    }
+
+    int result = to_store ? collection_store_convert_from_json(filepath, target) :
+                            collection_store_convert_to_json(filepath, target);
+    if (result != PERSISTENCE_SUCCESS) {
+        fprintf(stderr, "tinyrequest-cli: %s: %s\n", filepath,
+                persistence_get_user_friendly_error((PersistenceError)result, "convert the collection"));
+    }
+    free(saved_path);
+    return result == PERSISTENCE_SUCCESS ? CLI_EXIT_PASSED : CLI_EXIT_USAGE;
+}
+
+static void list_snapshots(FILE* out) {
+    SnapshotInfo* snapshots = NULL;
+    int count = 0;
+    int result = snapshot_store_list(&snapshots, &count);
+    if (result != PERSISTENCE_SUCCESS) {
+        fprintf(stderr, "tinyrequest-cli: %s\n",
+                persistence_get_user_friendly_error((PersistenceError)result, "list the snapshots"));
+        return;
+    }
+    if (count == 0) {
+        fprintf(out, "No snapshots yet\n");
+    }
+
+    for (int i = 0; i < count; i++) {
+        time_t created_at = (time_t)snapshots[i].created_at;
+        struct tm local;
+        char when[32] = "";
+#ifdef _WIN32
+        localtime_s(&local, &created_at);
+#else
+        localtime_r(&created_at, &local);
+#endif
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+        fprintf(out, "%-40s %s  %d collection%s\n", snapshots[i].name, when, snapshots[i].collection_count,
+                snapshots[i].collection_count == 1 ? "" : "s");
+    }
+    free(snapshots);
+}
+
+static int restore_snapshot(FILE* out, const char* name) {
+    int result = snapshot_store_restore(name);
+    if (result != PERSISTENCE_SUCCESS) {
+        fprintf(stderr, "tinyrequest-cli: %s: %s\n", name,
+                persistence_get_user_friendly_error((PersistenceError)result, "restore the snapshot"));
+        return CLI_EXIT_USAGE;
+    }
+    fprintf(out, "Restored %s, the state before it is the newest snapshot now\n", name);
+    return CLI_EXIT_PASSED;
+}
+
+/* every request a --request option names, by number or by name */
+static int select_requests(Collection* collection, const CliOptions* options, int* indices, int max_indices) {
+    int count = 0;
+    for (int i = 0; i < options->selected_count; i++) {
+        int number = 0;
+        int found = 0;
+        if (parse_int(options->selected[i], 1, collection->request_count, &number) && count < max_indices) {
+            indices[count++] = number - 1;
+            continue;
+        }
+
+        for (int r = 0; r < collection->request_count && count < max_indices; r++) {
+            const char* name = collection_get_request_name(collection, r);
+            if (name && strcmp(name, options->selected[i]) == 0) {
+                indices[count++] = r;
+                found++;
+            }
+        }
+        if (found == 0) {
+            fprintf(stderr, "tinyrequest-cli: no request named '%s' in %s\n", options->selected[i], collection->name);
+            return -1;
+        }
+    }
+    return count;
+}
+
+/* the core logs what it does with printf. the report gets stdout to
+ * itself and everything else printed goes to stderr, so a json or junit
+ * report can be piped straight into another tool */
+static FILE* claim_stdout(void) {
+    fflush(stdout);
+    int report_fd = dup(fileno(stdout));
+    FILE* out = report_fd >= 0 ? fdopen(report_fd, "w") : NULL;
+    if (!out || dup2(fileno(stderr), fileno(stdout)) < 0) {
+        return stdout;
+    }
+    return out;
+}
+
+static void list_requests(FILE* out, Collection* collection) {
+    fprintf(out, "%s, %d requests\n", collection->name, collection->request_count);
+    for (int i = 0; i < collection->request_count; i++) {
+        const Request* request = collection_get_request(collection, i);
+        const char* name = collection_get_request_name(collection, i);
+        fprintf(out, "%4d  %-7s %s  %s\n", i + 1, request->method, name ? name : "", request->url);
+    }
+}
+
+static void print_result(const char* name, const Request* request, const Response* response, int result,
+                         bool passed, void* user_data) {
+    FILE* out = (FILE*)user_data;
+    (void)request;
+
+    if (result != 0 || response->status_code == 0) {
+        fprintf(out, "  FAIL  ---  %-32.32s %s\n", name, response->status_text);
+    } else {
+        fprintf(out, "  %s  %3d  %-32.32s %8.1f ms\n", passed ? "PASS" : "FAIL", response->status_code, name,
+                response->response_time);
+    }
+    fflush(out);
+}
+
+static volatile sig_atomic_t g_stop_serving = 0;
+
+static void handle_interrupt(int signal_number) {
+    (void)signal_number;
+    g_stop_serving = 1;
+    cli_runner_interrupt();
+}
+
+static void cli_sleep_ms(int milliseconds) {
+#ifdef _WIN32
+    Sleep((DWORD)milliseconds);
+#else
+    struct timespec ts = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+/* routes for the collection with the responses the app recorded for its
+ * urls. the history is opened on a thread of its own, it gets a while to
+ * be ready before the routes go without examples */
+static int add_recorded_examples(MockServer* server, Collection* collection) {
+    HistoryStore* history = history_store_create();
+    for (int waited = 0; history && !history_store_is_ready(history) && waited < CLI_HISTORY_WAIT_MS; waited += 50) {
+        cli_sleep_ms(50);
+    }
+    if (history && !history_store_is_ready(history)) {
+        fprintf(stderr, "tinyrequest-cli: the history did not open in time, serving without examples\n");
+    }
+
+    int result = mock_server_add_collection(server, collection, history);
+    history_store_destroy(history);
+    return result;
+}
+
+/* a HAR file brings its own examples, the collection it was imported
+ * from has the same requests */
+static MockServer* start_mock_server(const CliOptions* options, Collection* collection, int format, int* result) {
+    MockServer* server = mock_server_create(&options->mock_options);
+    if (!server) {
+        *result = MOCK_SERVER_ERROR_INVALID_OPTIONS;
+        return NULL;
+    }
+
+    if (options->examples_path) {
+        *result = mock_server_add_collection(server, collection, NULL);
+        if (*result == MOCK_SERVER_SUCCESS) {
+            *result = mock_server_add_har_file(server, options->examples_path);
+        }
+    } else if (format == COLLECTION_IMPORT_HAR) {
+        *result = mock_server_add_har_file(server, options->source);
+    } else {
+        *result = add_recorded_examples(server, collection);
+    }
+
+    if (*result == MOCK_SERVER_SUCCESS) {
+        *result = mock_server_start(server);
+    }
+    if (*result != MOCK_SERVER_SUCCESS) {
+        mock_server_destroy(server);
+        return NULL;
+    }
+    return server;
+}
+
+static void print_mock_routes(FILE* out, MockServer* server) {
+    for (int i = 0; i < mock_server_get_route_count(server); i++) {
+        MockRouteInfo route;
+        if (mock_server_get_route(server, i, &route)) {
+            fprintf(out, "  %-7s %-48s %s\n", route.method, route.path, route.has_example ? "example" : "no example");
+        }
+    }
+}
+
+/* serves until interrupted, then says what it answered */
+static int serve_mock(FILE* out, const CliOptions* options, Collection* collection, int format) {
+    int result = MOCK_SERVER_SUCCESS;
+    MockServer* server = start_mock_server(options, collection, format, &result);
+    if (!server) {
+        fprintf(stderr, "tinyrequest-cli: mock server: %s\n", mock_server_error_string(result));
+        return CLI_EXIT_USAGE;
+    }
+
+    fprintf(out, "Serving %s on http://%s:%d, Ctrl+C stops\n", collection->name, options->mock_options.host,
+            mock_server_get_port(server));
+    print_mock_routes(out, server);
+    fflush(out);
+
+    while (!g_stop_serving && mock_server_is_running(server)) {
+        cli_sleep_ms(100);
+    }
+
+    MockServerStats stats;
+    mock_server_get_stats(server, &stats);
+    fprintf(out, "\n%llu requests, %llu matched, %llu without a route, %llu errors injected\n",
+            (unsigned long long)stats.requests, (unsigned long long)stats.matched,
+            (unsigned long long)stats.unmatched, (unsigned long long)stats.errors_injected);
+    mock_server_destroy(server);
+    return CLI_EXIT_PASSED;
+}
+
+int main(int argc, char** argv) {
+    CliOptions options;
+    int exit_status = parse_options(argc, argv, &options);
+    if (exit_status >= 0) {
+        return exit_status;
+    }
+    if (options.convert_path) {
+        return convert_collection(options.source, options.convert_path);
+    }
+    if (options.list_snapshots) {
+        list_snapshots(stdout);
+        return CLI_EXIT_PASSED;
+    }
+    if (options.restore_snapshot) {
+        return restore_snapshot(stdout, options.restore_snapshot);
+    }
+
+    FILE* out = claim_stdout();
+
+    signal(SIGINT, handle_interrupt);
+    signal(SIGTERM, handle_interrupt);
+
+    Collection collection;
+    memset(&collection, 0, sizeof(Collection));
+    int format = COLLECTION_IMPORT_UNKNOWN;
+    int result = load_collection(options.source, &collection, &format);
+    if (result != PERSISTENCE_SUCCESS) {
+        fprintf(stderr, "tinyrequest-cli: %s: %s\n", options.source,
+                persistence_get_user_friendly_error((PersistenceError)result, "read the collection"));
+        collection_cleanup(&collection);
+        return CLI_EXIT_USAGE;
+    }
+
+    if (options.list) {
+        list_requests(out, &collection);
+        collection_cleanup(&collection);
+        fclose(out);
+        return CLI_EXIT_PASSED;
+    }
+
+    if (options.mock) {
+        exit_status = serve_mock(out, &options, &collection, format);
+        collection_cleanup(&collection);
+        fclose(out);
+        return exit_status;
+    }
+
+    int selected[CLI_MAX_SELECTED];
+    int selected_count = select_requests(&collection, &options, selected, CLI_MAX_SELECTED);
+    if (selected_count < 0 || collection.request_count == 0) {
+        if (selected_count >= 0) {
+            fprintf(stderr, "tinyrequest-cli: %s has no requests\n", collection.name);
+        }
+        collection_cleanup(&collection);
+        return CLI_EXIT_USAGE;
+    }
+
+    /* on a free port, so runs side by side do not get in each other's way */
+    MockServer* mock = NULL;
+    char mock_url[96];
+    if (options.against_mock) {
+        options.mock_options.port = 0;
+        mock = start_mock_server(&options, &collection, format, &result);
+        if (!mock) {
+            fprintf(stderr, "tinyrequest-cli: mock server: %s\n", mock_server_error_string(result));
+            collection_cleanup(&collection);
+            return CLI_EXIT_USAGE;
+        }
+        snprintf(mock_url, sizeof(mock_url), "http://%s:%d", options.mock_options.host, mock_server_get_port(mock));
+    }
+
+    FILE* report_file = out;
+    if (options.report_path) {
+        report_file = fopen(options.report_path, "w");
+        if (!report_file) {
+            fprintf(stderr, "tinyrequest-cli: cannot write the report to %s\n", options.report_path);
+            mock_server_destroy(mock);
+            collection_cleanup(&collection);
+            return CLI_EXIT_USAGE;
+        }
+    }
+
+    HarWriter* har = NULL;
+    if (options.har_path) {
+        har = har_writer_open(options.har_path, options.har_bodies ? HAR_WRITER_BODIES : 0, &result);
+        if (!har) {
+            fprintf(stderr, "tinyrequest-cli: %s: %s\n", options.har_path,
+                    persistence_get_user_friendly_error((PersistenceError)result, "write the HAR file"));
+            if (report_file != out) {
+                fclose(report_file);
+            }
+            mock_server_destroy(mock);
+            collection_cleanup(&collection);
+            return CLI_EXIT_USAGE;
+        }
+    }
+
+    CliRunOptions run;
+    memset(&run, 0, sizeof(run));
+    run.request_indices = selected_count > 0 ? selected : NULL;
+    run.request_count = selected_count;
+    run.iterations = options.iterations;
+    run.duration_seconds = options.duration_seconds;
+    run.concurrency = options.concurrency;
+    run.base_url = mock ? mock_url : NULL;
+    run.insecure = options.insecure;
+    run.bail = options.bail;
+    run.har = har;
+
+    /* a line per response while it runs, a load test only gets the summary */
+    if (options.format == CLI_REPORT_TEXT && report_file == out && !options.quiet &&
+        options.duration_seconds <= 0.0) {
+        run.on_result = print_result;
+        run.user_data = out;
+    }
+
+    CliRunReport report;
+    bool ran = cli_runner_run(&collection, &run, &report) == 0;
+    if (!ran) {
+        fprintf(stderr, "tinyrequest-cli: could not start the run\n");
+        exit_status = CLI_EXIT_USAGE;
+    } else {
+        if (cli_report_write(report_file, options.format, collection.name, &report) != 0) {
+            fprintf(stderr, "tinyrequest-cli: could not write the report\n");
+            exit_status = CLI_EXIT_USAGE;
+        } else {
+            exit_status = report.failed > 0 || report.interrupted ? CLI_EXIT_FAILED : CLI_EXIT_PASSED;
+        }
+    }
+
+    /* a HAR file that missed responses is not left behind */
+    if (har) {
+        int har_result = report.har_result;
+        if (ran && har_result == PERSISTENCE_SUCCESS) {
+            har_result = har_writer_close(har);
+        } else {
+            har_writer_abort(har);
+        }
+        if (har_result != PERSISTENCE_SUCCESS) {
+            fprintf(stderr, "tinyrequest-cli: %s: %s\n", options.har_path,
+                    persistence_get_user_friendly_error((PersistenceError)har_result, "write the HAR file"));
+        }
+    }
+
+    cli_run_report_cleanup(&report);
+    mock_server_destroy(mock);
+    if (report_file != out && fclose(report_file) != 0) {
+        fprintf(stderr, "tinyrequest-cli: could not write the report to %s\n", options.report_path);
+        exit_status = CLI_EXIT_USAGE;
+    }
+    collection_cleanup(&collection);
+    if (fclose(out) != 0 && exit_status == CLI_EXIT_PASSED) {
+        exit_status = CLI_EXIT_USAGE;
+    }
+    return exit_status;
+}
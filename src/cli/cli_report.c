@@ -0,0 +1,228 @@
+/**
+ * run reports for tinyrequest-cli
+ */
+
+#include "cli/cli_report.h"
+#include "cJSON.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char* STATUS_CLASS_NAMES[CLI_STATUS_CLASSES] = { "error", "1xx", "2xx", "3xx", "4xx", "5xx" };
+
+int cli_report_parse_format(const char* name) {
+    if (!name) {
+        return -1;
+    }
+    if (strcmp(name, "text") == 0) {
+        return CLI_REPORT_TEXT;
+    }
+    if (strcmp(name, "json") == 0) {
+        return CLI_REPORT_JSON;
+    }
+    if (strcmp(name, "junit") == 0) {
+        return CLI_REPORT_JUNIT;
+    }
+    return -1;
+}
+
+static double requests_per_second(const CliRunReport* report) {
+    return report->elapsed_ms > 0.0 ? report->runs * 1000.0 / report->elapsed_ms : 0.0;
+}
+
+static void format_utc(int64_t time_ms, char* out, size_t out_size) {
+    time_t seconds = (time_t)(time_ms / 1000);
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    strftime(out, out_size, "%Y-%m-%dT%H:%M:%S", &utc);
+}
+
+/* --- text --- */
+
+static int write_text(FILE* out, const char* collection_name, const CliRunReport* report) {
+    fprintf(out, "\n%s\n\n", collection_name);
+    fprintf(out, "  %-7s %-32s %7s %7s %9s %9s %9s %9s %9s\n", "", "request", "runs", "failed", "min ms",
+            "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    for (int i = 0; i < report->request_count; i++) {
+        const CliRequestStats* stats = &report->requests[i];
+        fprintf(out, "  %-7s %-32.32s %7d %7d", stats->method, stats->name, stats->runs, stats->failed);
+        if (stats->latency_count > 0) {
+            fprintf(out, " %9.1f %9.1f %9.1f %9.1f %9.1f\n", stats->latencies[0],
+                    cli_request_stats_percentile(stats, 50.0), cli_request_stats_percentile(stats, 90.0),
+                    cli_request_stats_percentile(stats, 99.0), stats->latencies[stats->latency_count - 1]);
+        } else {
+            fprintf(out, " %9s %9s %9s %9s %9s\n", "-", "-", "-", "-", "-");
+        }
+    }
+
+    fprintf(out, "\n%d runs, %d failed in %.2f s, %.1f requests/s%s\n", report->runs, report->failed,
+            report->elapsed_ms / 1000.0, requests_per_second(report), report->interrupted ? ", interrupted" : "");
+
+    for (int i = 0; i < report->request_count; i++) {
+        const CliRequestStats* stats = &report->requests[i];
+        if (stats->first_error[0] != '\0') {
+            fprintf(out, "  %s: %s\n", stats->name, stats->first_error);
+        }
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+/* --- json --- */
+
+static cJSON* request_to_json(const CliRequestStats* stats) {
+    cJSON* json = cJSON_CreateObject();
+    if (!json) {
+        return NULL;
+    }
+
+    cJSON_AddStringToObject(json, "name", stats->name);
+    cJSON_AddStringToObject(json, "method", stats->method);
+    cJSON_AddStringToObject(json, "url", stats->url);
+    cJSON_AddNumberToObject(json, "runs", stats->runs);
+    cJSON_AddNumberToObject(json, "failed", stats->failed);
+    cJSON_AddNumberToObject(json, "bytes_received", (double)stats->bytes_received);
+
+    cJSON* latency = cJSON_AddObjectToObject(json, "latency_ms");
+    if (latency && stats->latency_count > 0) {
+        cJSON_AddNumberToObject(latency, "min", stats->latencies[0]);
+        cJSON_AddNumberToObject(latency, "mean", cli_request_stats_mean(stats));
+        cJSON_AddNumberToObject(latency, "p50", cli_request_stats_percentile(stats, 50.0));
+        cJSON_AddNumberToObject(latency, "p90", cli_request_stats_percentile(stats, 90.0));
+        cJSON_AddNumberToObject(latency, "p95", cli_request_stats_percentile(stats, 95.0));
+        cJSON_AddNumberToObject(latency, "p99", cli_request_stats_percentile(stats, 99.0));
+        cJSON_AddNumberToObject(latency, "max", stats->latencies[stats->latency_count - 1]);
+    }
+
+    cJSON* status = cJSON_AddObjectToObject(json, "status");
+    for (int i = 0; status && i < CLI_STATUS_CLASSES; i++) {
+        if (stats->status_classes[i] > 0) {
+            cJSON_AddNumberToObject(status, STATUS_CLASS_NAMES[i], stats->status_classes[i]);
+        }
+    }
+
+    if (stats->first_error[0] != '\0') {
+        cJSON_AddStringToObject(json, "first_error", stats->first_error);
+    }
+    return json;
+}
+
+static int write_json(FILE* out, const char* collection_name, const CliRunReport* report) {
+    cJSON* json = cJSON_CreateObject();
+    if (!json) {
+        return -1;
+    }
+
+    char started[32];
+    format_utc(report->started_at_ms, started, sizeof(started));
+    cJSON_AddStringToObject(json, "collection", collection_name);
+    cJSON_AddStringToObject(json, "started_at", started);
+    cJSON_AddNumberToObject(json, "elapsed_ms", report->elapsed_ms);
+    cJSON_AddNumberToObject(json, "runs", report->runs);
+    cJSON_AddNumberToObject(json, "failed", report->failed);
+    cJSON_AddNumberToObject(json, "requests_per_second", requests_per_second(report));
+    cJSON_AddBoolToObject(json, "interrupted", report->interrupted);
+
+    cJSON* requests = cJSON_AddArrayToObject(json, "requests");
+    for (int i = 0; requests && i < report->request_count; i++) {
+        cJSON* request = request_to_json(&report->requests[i]);
+        if (request) {
+            cJSON_AddItemToArray(requests, request);
+        }
+    }
+
+    char* text = cJSON_Print(json);
+    cJSON_Delete(json);
+    if (!text) {
+        return -1;
+    }
+
+    fprintf(out, "%s\n", text);
+    free(text);
+    return ferror(out) ? -1 : 0;
+}
+
+/* --- junit --- */
+
+static void write_xml_text(FILE* out, const char* text) {
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        switch (*p) {
+            case '&':  fputs("&amp;", out); break;
+            case '<':  fputs("&lt;", out); break;
+            case '>':  fputs("&gt;", out); break;
+            case '"':  fputs("&quot;", out); break;
+            case '\'': fputs("&apos;", out); break;
+            default:
+                /* xml 1.0 has no way to write other control characters */
+                if (*p >= 0x20 || *p == '\t' || *p == '\n' || *p == '\r') {
+                    fputc(*p, out);
+                }
+                break;
+        }
+    }
+}
+
+static int write_junit(FILE* out, const char* collection_name, const CliRunReport* report) {
+    int failures = 0;
+    int skipped = 0;
+    for (int i = 0; i < report->request_count; i++) {
+        failures += report->requests[i].failed > 0 || (report->requests[i].runs == 0 &&
+                                                      report->requests[i].first_error[0] != '\0');
+        skipped += report->requests[i].runs == 0 && report->requests[i].first_error[0] == '\0';
+    }
+
+    char started[32];
+    format_utc(report->started_at_ms, started, sizeof(started));
+
+    fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites name=\"tinyrequest\">\n", out);
+    fputs("  <testsuite name=\"", out);
+    write_xml_text(out, collection_name);
+    fprintf(out, "\" tests=\"%d\" failures=\"%d\" errors=\"0\" skipped=\"%d\" time=\"%.3f\" timestamp=\"%s\">\n",
+            report->request_count, failures, skipped, report->elapsed_ms / 1000.0, started);
+
+    for (int i = 0; i < report->request_count; i++) {
+        const CliRequestStats* stats = &report->requests[i];
+        fputs("    <testcase classname=\"", out);
+        write_xml_text(out, collection_name);
+        fputs("\" name=\"", out);
+        write_xml_text(out, stats->name);
+        fprintf(out, "\" time=\"%.3f\"", cli_request_stats_mean(stats) / 1000.0);
+
+        if (stats->failed > 0 || (stats->runs == 0 && stats->first_error[0] != '\0')) {
+            fputs(">\n      <failure type=\"request\" message=\"", out);
+            write_xml_text(out, stats->first_error);
+            fprintf(out, "\">%d of %d runs failed, ", stats->failed, stats->runs);
+            write_xml_text(out, stats->url);
+            fputs("</failure>\n    </testcase>\n", out);
+        } else if (stats->runs == 0) {
+            fputs(">\n      <skipped/>\n    </testcase>\n", out);
+        } else {
+            fputs("/>\n", out);
+        }
+    }
+
+    fputs("  </testsuite>\n</testsuites>\n", out);
+    return ferror(out) ? -1 : 0;
+}
+
+int cli_report_write(FILE* out, int format, const char* collection_name, const CliRunReport* report) {
+    if (!out || !report) {
+        return -1;
+    }
+    if (!collection_name) {
+        collection_name = "";
+    }
+
+    switch (format) {
+        case CLI_REPORT_JSON:
+            return write_json(out, collection_name, report);
+        case CLI_REPORT_JUNIT:
+            return write_junit(out, collection_name, report);
+        default:
+            return write_text(out, collection_name, report);
+    }
+}
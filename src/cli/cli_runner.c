@@ -0,0 +1,434 @@
+/**
+ * headless collection runs for tinyrequest-cli
+ *
+ * the engine wakes this thread through wake_signal_post the same way it
+ * wakes the ui loop, so the runner sleeps on a condition variable instead
+ * of polling and takes every response the moment it is done.
+ */
+
+#include "cli/cli_runner.h"
+#include "http_client.h"
+#include "persistence.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+/* longest the runner sleeps without a wake, it checks for an interrupt after it */
+#define RUNNER_WAIT_MS 100
+
+typedef struct {
+    int transfer_id;        /* 0 while the slot is free */
+    int stats_index;
+    Request* sent;          /* what went out, kept for the HAR file */
+} InFlight;
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+static pthread_mutex_t g_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake_cond = PTHREAD_COND_INITIALIZER;
+static bool g_woken = false;
+
+/* global out-of-memory handler */
+static void (*g_cli_runner_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_cli_runner_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_cli_runner_out_of_memory_handler) {
+        g_cli_runner_out_of_memory_handler(operation);
+    } else {
+        default_cli_runner_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void cli_runner_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_cli_runner_out_of_memory_handler = handler;
+}
+
+void cli_runner_interrupt(void) {
+    g_interrupted = 1;
+}
+
+static double runner_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int64_t runner_unix_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void runner_wake(void) {
+    pthread_mutex_lock(&g_wake_mutex);
+    g_woken = true;
+    pthread_cond_broadcast(&g_wake_cond);
+    pthread_mutex_unlock(&g_wake_mutex);
+}
+
+/* sleeps until the engine posts a wake or timeout_ms passed */
+static void runner_wait(double timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    long long nanoseconds = deadline.tv_nsec + (long long)(timeout_ms * 1000000.0);
+    deadline.tv_sec += (time_t)(nanoseconds / 1000000000LL);
+    deadline.tv_nsec = (long)(nanoseconds % 1000000000LL);
+
+    pthread_mutex_lock(&g_wake_mutex);
+    while (!g_woken && !g_interrupted) {
+        if (pthread_cond_timedwait(&g_wake_cond, &g_wake_mutex, &deadline) != 0) {
+            break;
+        }
+    }
+    g_woken = false;
+    pthread_mutex_unlock(&g_wake_mutex);
+}
+
+static int compare_latencies(const void* a, const void* b) {
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+    return (left > right) - (left < right);
+}
+
+static void drop_sent(InFlight* slot) {
+    if (slot->sent) {
+        request_cleanup(slot->sent);
+        free(slot->sent);
+        slot->sent = NULL;
+    }
+    slot->transfer_id = 0;
+}
+
+/* sends a copy of the request with the jar's cookies, the copy stays with
+ * the slot when it goes to the HAR file */
+static int submit_request(RequestEngine* engine, Collection* collection, CliRequestStats* stats,
+                          InFlight* slot, bool keep_sent) {
+    Request* request = collection_get_request(collection, stats->request_index);
+    Request to_send;
+    if (!request || request_copy(&to_send, request) != 0) {
+        return -1;
+    }
+    snprintf(to_send.url, sizeof(to_send.url), "%s", stats->url);
+    http_client_add_cookie_header(&to_send, collection);
+
+    int transfer_id = request_engine_submit(engine, &to_send);
+    if (transfer_id <= 0) {
+        request_cleanup(&to_send);
+        return -1;
+    }
+
+    slot->transfer_id = transfer_id;
+    slot->sent = keep_sent ? (Request*)malloc(sizeof(Request)) : NULL;
+    if (slot->sent) {
+        *slot->sent = to_send;
+    } else {
+        request_cleanup(&to_send);
+    }
+    return 0;
+}
+
+static bool run_passed(const Response* response, int result) {
+    return result == 0 && response->status_code > 0 && response->status_code < 400;
+}
+
+static void record_run(CliRunReport* report, CliRequestStats* stats, const Response* response, int result,
+                       bool passed) {
+    stats->runs++;
+    report->runs++;
+
+    int status_class = 0;
+    if (result == 0 && response->status_code >= 100 && response->status_code < 600) {
+        status_class = response->status_code / 100;
+    }
+    stats->status_classes[status_class]++;
+
+    if (stats->latency_count == stats->latency_capacity) {
+        int capacity = stats->latency_capacity ? stats->latency_capacity * 2 : 64;
+        double* grown = (double*)realloc(stats->latencies, (size_t)capacity * sizeof(double));
+        if (grown) {
+            stats->latencies = grown;
+            stats->latency_capacity = capacity;
+        } else {
+            handle_out_of_memory("cli runner latencies");
+        }
+    }
+    if (stats->latency_count < stats->latency_capacity) {
+        stats->latencies[stats->latency_count++] = response->response_time;
+    }
+
+    stats->bytes_received += response->timings.valid ? response->timings.download_size
+                                                     : (int64_t)response->body_size;
+
+    if (passed) {
+        return;
+    }
+
+    stats->failed++;
+    report->failed++;
+    if (stats->first_error[0] != '\0') {
+        return;
+    }
+    if (result != 0 || response->status_code == 0) {
+        snprintf(stats->first_error, sizeof(stats->first_error), "%s",
+                 response->status_text[0] ? response->status_text : "Request failed");
+    } else {
+        snprintf(stats->first_error, sizeof(stats->first_error), "HTTP %d %s", response->status_code,
+                 response->status_text);
+    }
+}
+
+/* swaps the scheme and host of a url for base, keeping path and query */
+static void rebase_url(const char* url, const char* base, char* out, size_t out_size) {
+    const char* path = strstr(url, "://");
+    path = path ? strchr(path + 3, '/') : strchr(url, '/');
+    if (!path) {
+        path = strchr(url, '?');
+    }
+
+    size_t base_length = strlen(base);
+    while (base_length > 0 && base[base_length - 1] == '/') {
+        base_length--;
+    }
+    snprintf(out, out_size, "%.*s%s", (int)base_length, base, path ? path : "/");
+}
+
+static int init_stats(Collection* collection, const CliRunOptions* options, CliRunReport* report) {
+    int count = options->request_indices ? options->request_count : collection->request_count;
+    if (count <= 0) {
+        return 0;
+    }
+
+    report->requests = (CliRequestStats*)calloc((size_t)count, sizeof(CliRequestStats));
+    if (!report->requests) {
+        handle_out_of_memory("cli runner stats");
+        return -1;
+    }
+    report->request_count = count;
+
+    for (int i = 0; i < count; i++) {
+        CliRequestStats* stats = &report->requests[i];
+        stats->request_index = options->request_indices ? options->request_indices[i] : i;
+
+        const Request* request = collection_get_request(collection, stats->request_index);
+        const char* name = collection_get_request_name(collection, stats->request_index);
+        if (!request) {
+            return -1;
+        }
+        /* an unnamed request goes by its url, cut to fit like the app's tab titles */
+        snprintf(stats->name, sizeof(stats->name), "%.*s", (int)sizeof(stats->name) - 1, name ? name : request->url);
+        snprintf(stats->method, sizeof(stats->method), "%s", request->method);
+        if (options->base_url) {
+            rebase_url(request->url, options->base_url, stats->url, sizeof(stats->url));
+        } else {
+            snprintf(stats->url, sizeof(stats->url), "%s", request->url);
+        }
+    }
+    return 0;
+}
+
+int cli_runner_run(Collection* collection, const CliRunOptions* options, CliRunReport* report) {
+    if (!report) {
+        return -1;
+    }
+    memset(report, 0, sizeof(CliRunReport));
+    if (!collection || !options || init_stats(collection, options, report) != 0) {
+        return -1;
+    }
+
+    report->started_at_ms = runner_unix_ms();
+    if (report->request_count == 0) {
+        return 0;
+    }
+
+    int concurrency = options->concurrency;
+    if (concurrency < 1) {
+        concurrency = 1;
+    } else if (concurrency > CLI_RUNNER_MAX_CONCURRENCY) {
+        concurrency = CLI_RUNNER_MAX_CONCURRENCY;
+    }
+
+    int iterations = options->iterations;
+    if (iterations <= 0 && options->duration_seconds <= 0.0) {
+        iterations = 1;
+    }
+    int64_t total_jobs = iterations > 0 ? (int64_t)iterations * report->request_count : -1;
+
+    /* the handler has to be in place before the engine starts its workers */
+    wake_signal_set_handler(runner_wake);
+    RequestEngine* engine = request_engine_create(concurrency);
+    if (!engine) {
+        return -1;
+    }
+    request_engine_set_ssl_verification(engine, !options->insecure);
+
+    double started = runner_now_ms();
+    double deadline = options->duration_seconds > 0.0 ? started + options->duration_seconds * 1000.0 : 0.0;
+
+    InFlight slots[CLI_RUNNER_MAX_CONCURRENCY];
+    memset(slots, 0, sizeof(slots));
+    HarWriter* har = options->har;
+    int64_t next_job = 0;
+    int in_flight = 0;
+    bool stopped = false;
+
+    for (;;) {
+        if (g_interrupted && !report->interrupted) {
+            report->interrupted = true;
+            stopped = true;
+            for (int i = 0; i < concurrency; i++) {
+                if (slots[i].transfer_id) {
+                    request_engine_cancel(engine, slots[i].transfer_id);
+                }
+            }
+        }
+        if (deadline > 0.0 && runner_now_ms() >= deadline) {
+            stopped = true;
+        }
+
+        /* a free slot gets the next request of the selection, round after round */
+        for (int i = 0; i < concurrency && !stopped && (total_jobs < 0 || next_job < total_jobs); i++) {
+            if (slots[i].transfer_id) {
+                continue;
+            }
+
+            int stats_index = (int)(next_job % report->request_count);
+            if (submit_request(engine, collection, &report->requests[stats_index], &slots[i], har != NULL) != 0) {
+                snprintf(report->requests[stats_index].first_error, sizeof(report->requests[stats_index].first_error),
+                         "Could not start the request");
+                stopped = true;
+                break;
+            }
+            slots[i].stats_index = stats_index;
+            next_job++;
+            in_flight++;
+        }
+
+        if (in_flight == 0) {
+            break;
+        }
+
+        bool took_any = false;
+        for (int i = 0; i < concurrency; i++) {
+            if (!slots[i].transfer_id) {
+                continue;
+            }
+
+            Response response;
+            int result = -1;
+            int taken = request_engine_take_response(engine, slots[i].transfer_id, &response, &result);
+            if (taken == 0) {
+                continue;
+            }
+
+            took_any = true;
+            in_flight--;
+            if (taken < 0) {
+                drop_sent(&slots[i]);
+                continue;
+            }
+
+            CliRequestStats* stats = &report->requests[slots[i].stats_index];
+            if (result == 0) {
+                http_client_store_response_cookies(collection, stats->url, &response);
+            }
+
+            /* transfers cancelled by an interrupt did not fail, they were never let finish */
+            if (!(report->interrupted && result != 0)) {
+                bool passed = run_passed(&response, result);
+                record_run(report, stats, &response, result, passed);
+
+                if (har && slots[i].sent) {
+                    int written = har_writer_add(har, slots[i].sent, &response, result, stats->name);
+                    if (written != PERSISTENCE_SUCCESS) {
+                        report->har_result = written;
+                        har = NULL;
+                    }
+                }
+                if (options->on_result) {
+                    options->on_result(stats->name, slots[i].sent, &response, result, passed, options->user_data);
+                }
+                if (!passed && options->bail) {
+                    stopped = true;
+                }
+            }
+
+            response_cleanup(&response);
+            drop_sent(&slots[i]);
+        }
+
+        if (!took_any) {
+            double timeout = RUNNER_WAIT_MS;
+            if (deadline > 0.0 && !stopped) {
+                double left = deadline - runner_now_ms();
+                timeout = left < 1.0 ? 1.0 : left < timeout ? left : timeout;
+            }
+            runner_wait(timeout);
+        }
+    }
+
+    report->elapsed_ms = runner_now_ms() - started;
+    request_engine_destroy(engine);
+    wake_signal_set_handler(NULL);
+
+    for (int i = 0; i < report->request_count; i++) {
+        CliRequestStats* stats = &report->requests[i];
+        if (stats->latency_count > 1) {
+            qsort(stats->latencies, (size_t)stats->latency_count, sizeof(double), compare_latencies);
+        }
+    }
+    return 0;
+}
+
+double cli_request_stats_percentile(const CliRequestStats* stats, double percentile) {
+    if (!stats || stats->latency_count == 0) {
+        return 0.0;
+    }
+
+    double rank = percentile / 100.0 * stats->latency_count;
+    int index = (int)rank;
+    if ((double)index < rank) {
+        index++;
+    }
+    if (index < 1) {
+        index = 1;
+    } else if (index > stats->latency_count) {
+        index = stats->latency_count;
+    }
+    return stats->latencies[index - 1];
+}
+
+double cli_request_stats_mean(const CliRequestStats* stats) {
+    if (!stats || stats->latency_count == 0) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < stats->latency_count; i++) {
+        sum += stats->latencies[i];
+    }
+    return sum / stats->latency_count;
+}
+
+void cli_run_report_cleanup(CliRunReport* report) {
+    if (!report) {
+        return;
+    }
+
+    for (int i = 0; i < report->request_count; i++) {
+        free(report->requests[i].latencies);
+    }
+    free(report->requests);
+    memset(report, 0, sizeof(CliRunReport));
+}
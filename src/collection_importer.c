@@ -0,0 +1,1161 @@
+/**
+ * collection imports for tinyrequest
+ *
+ * each format has a reader per object it cares about, walking its keys in
+ * whatever order they come. a request is filled in on the stack while its
+ * object goes by and adopted into the collection at the closing brace, the
+ * name last since it is often derived from the rest. what we have no field
+ * for - responses, timings, cookies, scripts - is skipped.
+ *
+ * Postman folders are flattened into request names, "folder / request".
+ */
+
+#include "collection_importer.h"
+#include "collection_reader.h"
+#include "json_reader.h"
+#include "persistence.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/* request_set_body refuses anything larger, the collection reader does too */
+#define MAX_BODY_SIZE (50 * 1024 * 1024)
+
+/* mapped pages behind the walk are given back in steps this large */
+#define RELEASE_STEP (16 * 1024 * 1024)
+
+/* deeper Postman folders are skipped, each level holds a request on the stack */
+#define MAX_FOLDER_DEPTH 64
+
+/* the ui is woken at most this often while an import runs */
+#define PROGRESS_WAKE_MS 50.0
+
+typedef struct {
+    JsonReader reader;
+    const char* data;
+    size_t length;
+    const char* released;
+    Collection* collection;
+    int format;
+    bool has_name;
+    bool own_format;
+    bool cancelled;
+    bool out_of_room;
+    int folder_depth;
+    CollectionImportCallback callback;
+    void* user_data;
+} ImportContext;
+
+/* auth as the formats describe it, mapped onto a request at the end */
+typedef struct {
+    char type[32];
+    char token[512];
+    char username[256];
+    char password[256];
+    char key[128];
+    char value[512];
+    char location[16];
+    bool disabled;
+} ImportAuth;
+
+struct CollectionImporter {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    char filepath[1024];
+    bool cancel_requested;
+    CollectionImportProgress progress;
+    Collection collection;
+    double started_ms;
+    double last_wake_ms;        /* import thread only */
+};
+
+/* global out-of-memory handler */
+static void (*g_collection_importer_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_collection_importer_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_collection_importer_out_of_memory_handler) {
+        g_collection_importer_out_of_memory_handler(operation);
+    } else {
+        default_collection_importer_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void collection_importer_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_collection_importer_out_of_memory_handler = handler;
+}
+
+static double importer_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+const char* collection_import_format_name(int format) {
+    switch (format) {
+        case COLLECTION_IMPORT_TINYREQUEST: return "TinyRequest";
+        case COLLECTION_IMPORT_POSTMAN:     return "Postman";
+        case COLLECTION_IMPORT_INSOMNIA:    return "Insomnia";
+        case COLLECTION_IMPORT_HAR:         return "HAR";
+        default:                            return "Unknown";
+    }
+}
+
+/* --- requests --- */
+
+/* gives back the mapped pages the walk is done with. they are only read
+ * again if the file turns out to be a tinyrequest collection */
+static void release_pages(ImportContext* context) {
+#ifndef _WIN32
+    if (context->reader.cur - context->released < RELEASE_STEP) {
+        return;
+    }
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t start = (size_t)(context->released - context->data);
+    size_t end = (size_t)(context->reader.cur - context->data);
+    if (page_size > 0) {
+        start = (start + (size_t)page_size - 1) / (size_t)page_size * (size_t)page_size;
+        end = end / (size_t)page_size * (size_t)page_size;
+    }
+    if (end > start) {
+        madvise((void*)(context->data + start), end - start, MADV_DONTNEED);
+    }
+    context->released = context->data + end;
+#else
+    (void)context;
+#endif
+}
+
+/* reports progress after a request, the callback may stop the import here */
+static void request_done(ImportContext* context) {
+    release_pages(context);
+    if (context->callback &&
+        !context->callback((size_t)(context->reader.cur - context->data), context->length,
+                           context->collection->request_count, context->user_data)) {
+        context->cancelled = true;
+        json_reader_fail(&context->reader);
+    }
+}
+
+static void adopt_request(ImportContext* context, Request* request, const char* name) {
+    size_t length = strlen(name);
+    char* owned_name = (char*)malloc(length + 1);
+    if (!owned_name) {
+        handle_out_of_memory("import request name");
+        request_cleanup(request);
+        context->out_of_room = true;
+        json_reader_fail(&context->reader);
+        return;
+    }
+    memcpy(owned_name, name, length + 1);
+
+    /* a collection stops growing somewhere past 16k requests, the import
+     * stops with it rather than leaving the rest out quietly */
+    if (collection_adopt_request(context->collection, request, owned_name) < 0) {
+        handle_out_of_memory("import request");
+        free(owned_name);
+        request_cleanup(request);
+        context->out_of_room = true;
+        json_reader_fail(&context->reader);
+        return;
+    }
+    request_done(context);
+}
+
+/* "GET /path" for requests the file gives no name */
+static void name_from_url(const Request* request, char* name, size_t name_size) {
+    const char* path = strstr(request->url, "://");
+    path = path ? strchr(path + 3, '/') : NULL;
+    size_t length = path ? strcspn(path, "?#") : 0;
+    if (length > 120) {
+        length = 120;
+    }
+    snprintf(name, name_size, "%s %.*s", request->method[0] ? request->method : "GET",
+             (int)(length > 0 ? length : 1), length > 0 ? path : "/");
+}
+
+static void set_body(Request* request, char* body, size_t length) {
+    if (!body) {
+        return;
+    }
+    free(request->body);
+    request->body = NULL;
+    request->body_size = 0;
+    if (length == 0 || length > MAX_BODY_SIZE) {
+        free(body);
+        return;
+    }
+    request->body = body;
+    request->body_size = length;
+}
+
+/* a string member into a fixed field, false when it is not a string or
+ * was cut to fit */
+static bool read_exact_field(JsonReader* reader, char* dest, size_t dest_size) {
+    if (json_reader_peek(reader) != '"') {
+        json_reader_skip(reader);
+        return false;
+    }
+    size_t length = 0;
+    return json_reader_string(reader, dest, dest_size, &length) && length < dest_size;
+}
+
+/* a list of { <name_key>, value, disabled } objects into headers. the client
+ * sets content-length itself and pseudo headers are not headers at all */
+static void read_headers(JsonReader* reader, HeaderList* headers, const char* name_key) {
+    if (!json_reader_enter(reader, '[')) {
+        return;
+    }
+
+    bool first = true;
+    while (json_reader_next(reader, ']', &first, NULL, 0)) {
+        if (json_reader_peek(reader) != '{') {
+            json_reader_skip(reader);
+            continue;
+        }
+        if (!json_reader_enter(reader, '{')) {
+            return;
+        }
+
+        Header header;
+        bool has_name = false;
+        bool has_value = false;
+        bool disabled = false;
+        bool first_key = true;
+        char key[32];
+        while (json_reader_next(reader, '}', &first_key, key, sizeof(key))) {
+            if (json_key_is(key, name_key)) {
+                has_name = read_exact_field(reader, header.name, sizeof(header.name));
+            } else if (json_key_is(key, "value")) {
+                has_value = read_exact_field(reader, header.value, sizeof(header.value));
+            } else if (json_key_is(key, "disabled")) {
+                json_reader_bool_field(reader, &disabled);
+            } else {
+                json_reader_skip(reader);
+            }
+        }
+        reader->depth--;
+
+        if (has_name && has_value && !disabled && header.name[0] != ':' &&
+            !json_key_is(header.name, "content-length")) {
+            header_list_add(headers, header.name, header.value);
+        }
+    }
+    reader->depth--;
+}
+
+static bool has_header(HeaderList* headers, const char* name) {
+    return header_list_find(headers, name) >= 0;
+}
+
+/* a string member into a buffer of its own, once. other types and repeats are skipped */
+static void read_form_field(JsonReader* reader, char** dest, size_t* length) {
+    if (*dest || json_reader_peek(reader) != '"') {
+        json_reader_skip(reader);
+        return;
+    }
+    *dest = json_reader_string_alloc(reader, length);
+}
+
+/* writes text the way a browser encodes a form field, space as + and
+ * everything but letters, digits and *-._ as %XX. dest has room for
+ * three times the length */
+static size_t form_encode(char* dest, const char* text, size_t length) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t written = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '*' ||
+            c == '-' || c == '.' || c == '_') {
+            dest[written++] = (char)c;
+        } else if (c == ' ') {
+            dest[written++] = '+';
+        } else {
+            dest[written++] = '%';
+            dest[written++] = hex[c >> 4];
+            dest[written++] = hex[c & 0x0F];
+        }
+    }
+    return written;
+}
+
+/* a list of { <name_key>, value, disabled } objects as an urlencoded form.
+ * Postman and Insomnia store the names and values decoded, so both are
+ * encoded here */
+static char* read_form(JsonReader* reader, const char* name_key, size_t* length) {
+    *length = 0;
+    if (!json_reader_enter(reader, '[')) {
+        return NULL;
+    }
+
+    char* form = NULL;
+    size_t capacity = 0;
+    bool first = true;
+    while (json_reader_next(reader, ']', &first, NULL, 0)) {
+        if (json_reader_peek(reader) != '{') {
+            json_reader_skip(reader);
+            continue;
+        }
+        if (!json_reader_enter(reader, '{')) {
+            break;
+        }
+
+        char* name = NULL;
+        size_t name_length = 0;
+        char* value = NULL;
+        size_t value_length = 0;
+        bool disabled = false;
+        bool first_key = true;
+        char key[32];
+        while (json_reader_next(reader, '}', &first_key, key, sizeof(key))) {
+            if (json_key_is(key, name_key)) {
+                read_form_field(reader, &name, &name_length);
+            } else if (json_key_is(key, "value")) {
+                read_form_field(reader, &value, &value_length);
+            } else if (json_key_is(key, "disabled")) {
+                json_reader_bool_field(reader, &disabled);
+            } else {
+                json_reader_skip(reader);
+            }
+        }
+        reader->depth--;
+
+        if (disabled || reader->failed || !name || name_length == 0) {
+            free(name);
+            free(value);
+            continue;
+        }
+
+        /* separator, '=' and the terminator around fields that at most triple */
+        size_t needed = *length + 3 + (name_length + value_length) * 3;
+        if (needed > capacity) {
+            capacity = needed * 2;
+            char* grown = (char*)realloc(form, capacity);
+            if (!grown) {
+                handle_out_of_memory("import form body");
+                free(name);
+                free(value);
+                free(form);
+                json_reader_fail(reader);
+                *length = 0;
+                return NULL;
+            }
+            form = grown;
+        }
+        if (*length > 0) {
+            form[(*length)++] = '&';
+        }
+        *length += form_encode(form + *length, name, name_length);
+        form[(*length)++] = '=';
+        if (value) {
+            *length += form_encode(form + *length, value, value_length);
+        }
+        form[*length] = '\0';
+        free(name);
+        free(value);
+    }
+    reader->depth--;
+    return form;
+}
+
+/* Postman keeps auth parameters as a list of { key, value } */
+static void read_auth_parameters(JsonReader* reader, ImportAuth* auth) {
+    if (!json_reader_enter(reader, '[')) {
+        return;
+    }
+
+    bool first = true;
+    while (json_reader_next(reader, ']', &first, NULL, 0)) {
+        if (json_reader_peek(reader) != '{') {
+            json_reader_skip(reader);
+            continue;
+        }
+        if (!json_reader_enter(reader, '{')) {
+            return;
+        }
+
+        char name[32] = "";
+        char value[512] = "";
+        bool first_key = true;
+        char key[32];
+        while (json_reader_next(reader, '}', &first_key, key, sizeof(key))) {
+            if (json_key_is(key, "key")) {
+                json_reader_string_field(reader, name, sizeof(name));
+            } else if (json_key_is(key, "value")) {
+                json_reader_string_field(reader, value, sizeof(value));
+            } else {
+                json_reader_skip(reader);
+            }
+        }
+        reader->depth--;
+
+        if (json_key_is(name, "token") || json_key_is(name, "accesstoken")) {
+            snprintf(auth->token, sizeof(auth->token), "%.*s", (int)sizeof(auth->token) - 1, value);
+        } else if (json_key_is(name, "username")) {
+            snprintf(auth->username, sizeof(auth->username), "%.*s", (int)sizeof(auth->username) - 1, value);
+        } else if (json_key_is(name, "password")) {
+            snprintf(auth->password, sizeof(auth->password), "%.*s", (int)sizeof(auth->password) - 1, value);
+        } else if (json_key_is(name, "key")) {
+            snprintf(auth->key, sizeof(auth->key), "%.*s", (int)sizeof(auth->key) - 1, value);
+        } else if (json_key_is(name, "value")) {
+            snprintf(auth->value, sizeof(auth->value), "%.*s", (int)sizeof(auth->value) - 1, value);
+        } else if (json_key_is(name, "in")) {
+            snprintf(auth->location, sizeof(auth->location), "%.*s", (int)sizeof(auth->location) - 1, value);
+        }
+    }
+    reader->depth--;
+}
+
+static void apply_auth(Request* request, const ImportAuth* auth) {
+    if (auth->disabled) {
+        return;
+    }
+
+    if (json_key_is(auth->type, "bearer")) {
+        request->selected_auth_type = 2;
+        snprintf(request->auth_bearer_token, sizeof(request->auth_bearer_token), "%s", auth->token);
+    } else if (json_key_is(auth->type, "basic")) {
+        request->selected_auth_type = 3;
+        snprintf(request->auth_basic_username, sizeof(request->auth_basic_username), "%s", auth->username);
+        snprintf(request->auth_basic_password, sizeof(request->auth_basic_password), "%s", auth->password);
+    } else if (json_key_is(auth->type, "apikey")) {
+        request->selected_auth_type = 1;
+        snprintf(request->auth_api_key_name, sizeof(request->auth_api_key_name), "%s", auth->key);
+        snprintf(request->auth_api_key_value, sizeof(request->auth_api_key_value), "%s", auth->value);
+        request->auth_api_key_location =
+            json_key_is(auth->location, "query") || json_key_is(auth->location, "queryparams") ? 1 : 0;
+    } else if (json_key_is(auth->type, "oauth2") && auth->token[0] != '\0') {
+        request->selected_auth_type = 4;
+        snprintf(request->auth_oauth_token, sizeof(request->auth_oauth_token), "%s", auth->token);
+    }
+}
+
+/* --- HAR --- */
+
+static void read_har_post_data(JsonReader* reader, Request* request) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    char mime_type[128] = "";
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "text") && json_reader_peek(reader) == '"') {
+            size_t length = 0;
+            char* text = json_reader_string_alloc(reader, &length);
+            set_body(request, text, length);
+        } else if (json_key_is(key, "mimetype")) {
+            json_reader_string_field(reader, mime_type, sizeof(mime_type));
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (request->body && mime_type[0] != '\0' && !has_header(&request->headers, "Content-Type")) {
+        header_list_add(&request->headers, "Content-Type", mime_type);
+    }
+}
+
+static void read_har_request(ImportContext* context) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    Request request;
+    request_init(&request);
+    bool has_url = false;
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "method")) {
+            json_reader_string_field(reader, request.method, sizeof(request.method));
+        } else if (json_key_is(key, "url")) {
+            has_url = read_exact_field(reader, request.url, sizeof(request.url));
+        } else if (json_key_is(key, "headers") && c == '[') {
+            read_headers(reader, &request.headers, "name");
+        } else if (json_key_is(key, "postdata") && c == '{') {
+            read_har_post_data(reader, &request);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    /* a url that does not fit would be sent somewhere else */
+    if (reader->failed || !has_url) {
+        request_cleanup(&request);
+        return;
+    }
+
+    char name[256];
+    name_from_url(&request, name, sizeof(name));
+    adopt_request(context, &request, name);
+}
+
+static void read_har_log(ImportContext* context) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (!json_key_is(key, "entries") || json_reader_peek(reader) != '[') {
+            json_reader_skip(reader);
+            continue;
+        }
+        if (!json_reader_enter(reader, '[')) {
+            return;
+        }
+
+        bool first_entry = true;
+        while (json_reader_next(reader, ']', &first_entry, NULL, 0)) {
+            if (json_reader_peek(reader) != '{') {
+                json_reader_skip(reader);
+                continue;
+            }
+            if (!json_reader_enter(reader, '{')) {
+                return;
+            }
+
+            bool first_key = true;
+            char entry_key[32];
+            while (json_reader_next(reader, '}', &first_key, entry_key, sizeof(entry_key))) {
+                if (json_key_is(entry_key, "request") && json_reader_peek(reader) == '{') {
+                    read_har_request(context);
+                } else {
+                    json_reader_skip(reader);
+                }
+            }
+            reader->depth--;
+        }
+        reader->depth--;
+    }
+    reader->depth--;
+}
+
+/* --- Postman --- */
+
+static void read_postman_url(JsonReader* reader, Request* request, bool* has_url) {
+    if (json_reader_peek(reader) == '"') {
+        *has_url = read_exact_field(reader, request->url, sizeof(request->url));
+        return;
+    }
+    if (json_reader_peek(reader) != '{' || !json_reader_enter(reader, '{')) {
+        json_reader_skip(reader);
+        return;
+    }
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "raw")) {
+            *has_url = read_exact_field(reader, request->url, sizeof(request->url));
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+static void read_postman_body(JsonReader* reader, Request* request) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    char mode[32] = "raw";
+    char* raw = NULL;
+    size_t raw_length = 0;
+    char* form = NULL;
+    size_t form_length = 0;
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "mode")) {
+            json_reader_string_field(reader, mode, sizeof(mode));
+        } else if (json_key_is(key, "raw") && c == '"' && !raw) {
+            raw = json_reader_string_alloc(reader, &raw_length);
+        } else if (json_key_is(key, "urlencoded") && c == '[' && !form) {
+            form = read_form(reader, "key", &form_length);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    /* the mode may come after the bodies, the one it names wins */
+    if (json_key_is(mode, "urlencoded")) {
+        set_body(request, form, form_length);
+        free(raw);
+        if (request->body && !has_header(&request->headers, "Content-Type")) {
+            header_list_add(&request->headers, "Content-Type", "application/x-www-form-urlencoded");
+        }
+    } else {
+        set_body(request, raw, raw_length);
+        free(form);
+    }
+}
+
+static void read_postman_auth(JsonReader* reader, ImportAuth* auth) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "type")) {
+            json_reader_string_field(reader, auth->type, sizeof(auth->type));
+        } else if (json_reader_peek(reader) == '[') {
+            /* every type's parameters are read, the type may come last */
+            read_auth_parameters(reader, auth);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+static void read_postman_request(JsonReader* reader, Request* request, bool* has_url) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    ImportAuth auth;
+    memset(&auth, 0, sizeof(auth));
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "method")) {
+            json_reader_string_field(reader, request->method, sizeof(request->method));
+        } else if (json_key_is(key, "url")) {
+            read_postman_url(reader, request, has_url);
+        } else if (json_key_is(key, "header") && c == '[') {
+            read_headers(reader, &request->headers, "key");
+        } else if (json_key_is(key, "body") && c == '{') {
+            read_postman_body(reader, request);
+        } else if (json_key_is(key, "auth") && c == '{') {
+            read_postman_auth(reader, &auth);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    apply_auth(request, &auth);
+}
+
+static void read_postman_items(ImportContext* context, const char* prefix);
+
+/* a request or a folder of more items */
+static void read_postman_item(ImportContext* context, const char* prefix) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    Request request;
+    request_init(&request);
+    char name[256] = "";
+    bool has_request = false;
+    bool has_url = false;
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "name")) {
+            json_reader_string_field(reader, name, sizeof(name));
+        } else if (json_key_is(key, "item") && c == '[' && context->folder_depth < MAX_FOLDER_DEPTH) {
+            /* exports put the name first, a folder named after its items goes unnamed */
+            char folder[256];
+            if (snprintf(folder, sizeof(folder), "%s%s / ", prefix, name[0] ? name : "Folder") >= (int)sizeof(folder)) {
+                /* a path too deep to spell out ends in ... */
+                memcpy(folder + sizeof(folder) - sizeof("... / "), "... / ", sizeof("... / "));
+            }
+            context->folder_depth++;
+            read_postman_items(context, folder);
+            context->folder_depth--;
+        } else if (json_key_is(key, "request") && (c == '{' || c == '"')) {
+            has_request = true;
+            snprintf(request.method, sizeof(request.method), "GET");
+            if (c == '"') {
+                has_url = read_exact_field(reader, request.url, sizeof(request.url));
+            } else {
+                read_postman_request(reader, &request, &has_url);
+            }
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (reader->failed || !has_request || !has_url) {
+        request_cleanup(&request);
+        return;
+    }
+
+    char full_name[256];
+    if (name[0] == '\0') {
+        name_from_url(&request, name, sizeof(name));
+    }
+    snprintf(full_name, sizeof(full_name), "%s%s", prefix, name);
+    adopt_request(context, &request, full_name);
+}
+
+static void read_postman_items(ImportContext* context, const char* prefix) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '[')) {
+        return;
+    }
+
+    bool first = true;
+    while (json_reader_next(reader, ']', &first, NULL, 0)) {
+        if (json_reader_peek(reader) == '{') {
+            read_postman_item(context, prefix);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+static void read_postman_info(ImportContext* context) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    Collection* collection = context->collection;
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "name")) {
+            char name[sizeof(collection->name)] = "";
+            if (json_reader_string_field(reader, name, sizeof(name)) && name[0] != '\0') {
+                memcpy(collection->name, name, sizeof(name));
+                context->has_name = true;
+            }
+        } else if (json_key_is(key, "description")) {
+            json_reader_string_field(reader, collection->description, sizeof(collection->description));
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+/* --- Insomnia --- */
+
+static void read_insomnia_body(JsonReader* reader, Request* request) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    char mime_type[128] = "";
+    char* text = NULL;
+    size_t text_length = 0;
+    char* form = NULL;
+    size_t form_length = 0;
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "text") && c == '"' && !text) {
+            text = json_reader_string_alloc(reader, &text_length);
+        } else if (json_key_is(key, "params") && c == '[' && !form) {
+            form = read_form(reader, "name", &form_length);
+        } else if (json_key_is(key, "mimetype")) {
+            json_reader_string_field(reader, mime_type, sizeof(mime_type));
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (text) {
+        set_body(request, text, text_length);
+        free(form);
+    } else if (strcmp(mime_type, "application/x-www-form-urlencoded") == 0) {
+        set_body(request, form, form_length);
+    } else {
+        free(form);
+    }
+
+    if (request->body && mime_type[0] != '\0' && !has_header(&request->headers, "Content-Type")) {
+        header_list_add(&request->headers, "Content-Type", mime_type);
+    }
+}
+
+static void read_insomnia_auth(JsonReader* reader, ImportAuth* auth) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "type")) {
+            json_reader_string_field(reader, auth->type, sizeof(auth->type));
+        } else if (json_key_is(key, "token") || json_key_is(key, "accesstoken")) {
+            json_reader_string_field(reader, auth->token, sizeof(auth->token));
+        } else if (json_key_is(key, "username")) {
+            json_reader_string_field(reader, auth->username, sizeof(auth->username));
+        } else if (json_key_is(key, "password")) {
+            json_reader_string_field(reader, auth->password, sizeof(auth->password));
+        } else if (json_key_is(key, "key")) {
+            json_reader_string_field(reader, auth->key, sizeof(auth->key));
+        } else if (json_key_is(key, "value")) {
+            json_reader_string_field(reader, auth->value, sizeof(auth->value));
+        } else if (json_key_is(key, "addto")) {
+            json_reader_string_field(reader, auth->location, sizeof(auth->location));
+        } else if (json_key_is(key, "disabled")) {
+            json_reader_bool_field(reader, &auth->disabled);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+/* every resource is read the same way, its _type decides at the end what it was */
+static void read_insomnia_resource(ImportContext* context) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    Request request;
+    request_init(&request);
+    ImportAuth auth;
+    memset(&auth, 0, sizeof(auth));
+    char type[32] = "";
+    char name[256] = "";
+    bool has_url = false;
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "_type")) {
+            json_reader_string_field(reader, type, sizeof(type));
+        } else if (json_key_is(key, "name")) {
+            json_reader_string_field(reader, name, sizeof(name));
+        } else if (json_key_is(key, "method")) {
+            json_reader_string_field(reader, request.method, sizeof(request.method));
+        } else if (json_key_is(key, "url")) {
+            has_url = read_exact_field(reader, request.url, sizeof(request.url));
+        } else if (json_key_is(key, "headers") && c == '[') {
+            read_headers(reader, &request.headers, "name");
+        } else if (json_key_is(key, "body") && c == '{') {
+            read_insomnia_body(reader, &request);
+        } else if (json_key_is(key, "authentication") && c == '{') {
+            read_insomnia_auth(reader, &auth);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (!reader->failed && strcmp(type, "workspace") == 0 && name[0] != '\0' && !context->has_name) {
+        snprintf(context->collection->name, sizeof(context->collection->name), "%s", name);
+        context->has_name = true;
+    }
+
+    if (reader->failed || strcmp(type, "request") != 0 || !has_url) {
+        request_cleanup(&request);
+        return;
+    }
+
+    apply_auth(&request, &auth);
+    if (name[0] == '\0') {
+        name_from_url(&request, name, sizeof(name));
+    }
+    adopt_request(context, &request, name);
+}
+
+static void read_insomnia_resources(ImportContext* context) {
+    JsonReader* reader = &context->reader;
+    if (!json_reader_enter(reader, '[')) {
+        return;
+    }
+
+    bool first = true;
+    while (json_reader_next(reader, ']', &first, NULL, 0)) {
+        if (json_reader_peek(reader) == '{') {
+            read_insomnia_resource(context);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+/* --- files --- */
+
+/* the top level keys tell the format: log for HAR, info and item for
+ * Postman, resources for Insomnia and requests for our own files */
+static void read_document(ImportContext* context) {
+    JsonReader* reader = &context->reader;
+    if (json_reader_peek(reader) != '{' || !json_reader_enter(reader, '{')) {
+        json_reader_fail(reader);
+        return;
+    }
+
+    bool first = true;
+    char key[32];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "log") && c == '{') {
+            context->format = COLLECTION_IMPORT_HAR;
+            read_har_log(context);
+        } else if (json_key_is(key, "info") && c == '{') {
+            context->format = COLLECTION_IMPORT_POSTMAN;
+            read_postman_info(context);
+        } else if (json_key_is(key, "item") && c == '[') {
+            context->format = COLLECTION_IMPORT_POSTMAN;
+            read_postman_items(context, "");
+        } else if (json_key_is(key, "resources") && c == '[') {
+            context->format = COLLECTION_IMPORT_INSOMNIA;
+            read_insomnia_resources(context);
+        } else {
+            if (json_key_is(key, "requests") && c == '[') {
+                context->own_format = true;
+            }
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+/* the file name without its directory and extension */
+static void name_from_path(const char* filepath, char* name, size_t name_size) {
+    const char* base = filepath + strlen(filepath);
+    while (base > filepath && base[-1] != '/' && base[-1] != '\\') {
+        base--;
+    }
+    const char* dot = strrchr(base, '.');
+    size_t length = dot && dot > base ? (size_t)(dot - base) : strlen(base);
+    snprintf(name, name_size, "%.*s", (int)length, base);
+}
+
+static int import_buffer(Collection* collection, const char* data, size_t length, const char* filepath,
+                         int* format, CollectionImportCallback callback, void* user_data) {
+    Collection imported;
+    memset(&imported, 0, sizeof(Collection));
+    char name[256];
+    name_from_path(filepath, name, sizeof(name));
+    collection_init(&imported, name[0] ? name : "Imported Collection", "");
+
+    ImportContext context;
+    memset(&context, 0, sizeof(context));
+    json_reader_init(&context.reader, data, length);
+    context.data = data;
+    context.length = length;
+    context.released = data;
+    context.collection = &imported;
+    context.callback = callback;
+    context.user_data = user_data;
+
+    read_document(&context);
+
+    int result = PERSISTENCE_SUCCESS;
+    if (context.cancelled) {
+        result = PERSISTENCE_ERROR_CANCELLED;
+    } else if (context.out_of_room) {
+        result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    } else if (context.reader.failed) {
+        result = PERSISTENCE_ERROR_INVALID_JSON;
+    } else if (context.format == COLLECTION_IMPORT_UNKNOWN && context.own_format) {
+        /* read again by the collection reader, under a new id so importing a
+         * collection next to itself makes a copy. it has no journal here */
+        char id[sizeof(imported.id)];
+        memcpy(id, imported.id, sizeof(id));
+        result = collection_reader_read_buffer(&imported, data, length, NULL, NULL);
+        memcpy(imported.id, id, sizeof(id));
+        imported.journal_seq = 0;
+        imported.journal_size = 0;
+        context.format = COLLECTION_IMPORT_TINYREQUEST;
+        if (result == PERSISTENCE_SUCCESS && callback) {
+            callback(length, length, imported.request_count, user_data);
+        }
+    } else if (context.format == COLLECTION_IMPORT_UNKNOWN) {
+        result = PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    if (format) {
+        *format = context.format;
+    }
+    if (result != PERSISTENCE_SUCCESS) {
+        collection_cleanup(&imported);
+        return result;
+    }
+
+    collection_move(collection, &imported);
+    return PERSISTENCE_SUCCESS;
+}
+
+int collection_import_file(Collection* collection, const char* filepath, int* format,
+                           CollectionImportCallback callback, void* user_data) {
+    if (format) {
+        *format = COLLECTION_IMPORT_UNKNOWN;
+    }
+    if (!collection || !filepath) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    PersistenceMappedFile mapped;
+    int result = persistence_map_file(&mapped, filepath, true);
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    result = import_buffer(collection, mapped.data, mapped.size, filepath, format, callback, user_data);
+
+    persistence_unmap_file(&mapped);
+    return result;
+}
+
+/* --- importer thread --- */
+
+static bool importer_progress(size_t bytes_done, size_t bytes_total, int request_count, void* user_data) {
+    CollectionImporter* importer = (CollectionImporter*)user_data;
+
+    pthread_mutex_lock(&importer->mutex);
+    importer->progress.bytes_done = bytes_done;
+    importer->progress.bytes_total = bytes_total;
+    importer->progress.request_count = request_count;
+    bool cancelled = importer->cancel_requested;
+    pthread_mutex_unlock(&importer->mutex);
+
+    double now = importer_now_ms();
+    if (now - importer->last_wake_ms >= PROGRESS_WAKE_MS) {
+        importer->last_wake_ms = now;
+        wake_signal_post();
+    }
+    return !cancelled;
+}
+
+static void* importer_thread(void* arg) {
+    CollectionImporter* importer = (CollectionImporter*)arg;
+
+    Collection collection;
+    memset(&collection, 0, sizeof(Collection));
+    int format = COLLECTION_IMPORT_UNKNOWN;
+    int result = collection_import_file(&collection, importer->filepath, &format, importer_progress, importer);
+
+    pthread_mutex_lock(&importer->mutex);
+    if (result == PERSISTENCE_SUCCESS) {
+        collection_move(&importer->collection, &collection);
+        importer->progress.request_count = importer->collection.request_count;
+        importer->progress.bytes_done = importer->progress.bytes_total;
+    }
+    importer->progress.result = result;
+    importer->progress.format = format;
+    importer->progress.elapsed_ms = importer_now_ms() - importer->started_ms;
+    importer->progress.finished = true;
+    pthread_mutex_unlock(&importer->mutex);
+
+    wake_signal_post();
+    return NULL;
+}
+
+CollectionImporter* collection_importer_start(const char* filepath) {
+    if (!filepath || filepath[0] == '\0') {
+        return NULL;
+    }
+
+    CollectionImporter* importer = (CollectionImporter*)calloc(1, sizeof(CollectionImporter));
+    if (!importer) {
+        handle_out_of_memory("collection importer creation");
+        return NULL;
+    }
+
+    snprintf(importer->filepath, sizeof(importer->filepath), "%s", filepath);
+    importer->started_ms = importer_now_ms();
+    pthread_mutex_init(&importer->mutex, NULL);
+
+    if (pthread_create(&importer->thread, NULL, importer_thread, importer) != 0) {
+        pthread_mutex_destroy(&importer->mutex);
+        free(importer);
+        return NULL;
+    }
+    return importer;
+}
+
+void collection_importer_destroy(CollectionImporter* importer) {
+    if (!importer) {
+        return;
+    }
+
+    collection_importer_cancel(importer);
+    pthread_join(importer->thread, NULL);
+
+    collection_cleanup(&importer->collection);
+    pthread_mutex_destroy(&importer->mutex);
+    free(importer);
+}
+
+void collection_importer_get_progress(CollectionImporter* importer, CollectionImportProgress* progress) {
+    if (!importer || !progress) {
+        return;
+    }
+
+    pthread_mutex_lock(&importer->mutex);
+    *progress = importer->progress;
+    if (!progress->finished) {
+        progress->elapsed_ms = importer_now_ms() - importer->started_ms;
+    }
+    pthread_mutex_unlock(&importer->mutex);
+}
+
+void collection_importer_cancel(CollectionImporter* importer) {
+    if (!importer) {
+        return;
+    }
+
+    pthread_mutex_lock(&importer->mutex);
+    importer->cancel_requested = true;
+    pthread_mutex_unlock(&importer->mutex);
+}
+
+bool collection_importer_take(CollectionImporter* importer, Collection* collection) {
+    if (!importer || !collection) {
+        return false;
+    }
+
+    pthread_mutex_lock(&importer->mutex);
+    bool ready = importer->progress.finished && importer->progress.result == PERSISTENCE_SUCCESS &&
+                 importer->collection.loaded;
+    if (ready) {
+        collection_move(collection, &importer->collection);
+    }
+    pthread_mutex_unlock(&importer->mutex);
+    return ready;
+}
@@ -0,0 +1,426 @@
+/**
+ * append-only edit journal for tinyrequest collections
+ *
+ * a record on disk is its body length and an fnv-1a checksum of the body,
+ * both as 32 bit little endian numbers, followed by the body:
+ *
+ *   seq (8 bytes) | modified_at (8 bytes) | op (1 byte) | payload
+ *
+ * the payload is encoded the way binary_io.h describes. a put payload is
+ * the index, the name and the request.
+ */
+
+#include "collection_journal.h"
+#include "binary_io.h"
+#include "persistence.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define RECORD_FRAME_SIZE 8
+#define RECORD_HEADER_SIZE 17
+
+/* leaves room for the frame and writes the common part of the body */
+static void begin_record(ByteWriter* writer, unsigned long seq, time_t modified_at, CollectionJournalOp op) {
+    memset(writer, 0, sizeof(ByteWriter));
+    byte_writer_u32(writer, 0);
+    byte_writer_u32(writer, 0);
+    byte_writer_u64(writer, (uint64_t)seq);
+    byte_writer_u64(writer, (uint64_t)(int64_t)modified_at);
+    byte_writer_u8(writer, (unsigned int)op);
+}
+
+/* fills in the frame and hands the record over */
+static char* finish_record(ByteWriter* writer, size_t* length) {
+    size_t body_length = writer->length - RECORD_FRAME_SIZE;
+    if (writer->failed || body_length > UINT32_MAX) {
+        free(writer->data);
+        return NULL;
+    }
+
+    byte_writer_patch_u32(writer, 0, (uint32_t)body_length);
+    byte_writer_patch_u32(writer, 4, binary_checksum(writer->data + RECORD_FRAME_SIZE, body_length));
+
+    *length = writer->length;
+    return (char*)writer->data;
+}
+
+char* collection_journal_encode_put_request(const Collection* collection, int request_index,
+                                            unsigned long seq, size_t* length) {
+    if (!collection || !length || request_index < 0 || request_index >= collection->request_count) {
+        return NULL;
+    }
+
+    ByteWriter writer;
+    begin_record(&writer, seq, collection->modified_at, COLLECTION_JOURNAL_PUT_REQUEST);
+    byte_writer_u32(&writer, (uint32_t)request_index);
+    byte_writer_string(&writer, collection->request_names[request_index]);
+    byte_writer_request(&writer, &collection->requests[request_index]);
+    return finish_record(&writer, length);
+}
+
+char* collection_journal_encode_remove_request(int request_index, unsigned long seq, size_t* length) {
+    if (!length || request_index < 0) {
+        return NULL;
+    }
+
+    ByteWriter writer;
+    begin_record(&writer, seq, time(NULL), COLLECTION_JOURNAL_REMOVE_REQUEST);
+    byte_writer_u32(&writer, (uint32_t)request_index);
+    return finish_record(&writer, length);
+}
+
+char* collection_journal_encode_set_collection(const Collection* collection, unsigned long seq,
+                                               size_t* length) {
+    if (!collection || !length) {
+        return NULL;
+    }
+
+    ByteWriter writer;
+    begin_record(&writer, seq, collection->modified_at, COLLECTION_JOURNAL_SET_COLLECTION);
+    byte_writer_string(&writer, collection->name);
+    byte_writer_string(&writer, collection->description);
+    return finish_record(&writer, length);
+}
+
+static bool apply_put_request(Collection* collection, ByteReader* reader) {
+    uint32_t index = byte_reader_u32(reader);
+    size_t name_length = 0;
+    char* name = byte_reader_alloc(reader, &name_length);
+
+    Request request;
+    request_init(&request);
+    byte_reader_request(reader, &request);
+
+    int result = -1;
+    if (!reader->failed && name) {
+        if (index == (uint32_t)collection->request_count) {
+            result = collection_adopt_request(collection, &request, name);
+        } else if (index < (uint32_t)collection->request_count) {
+            result = collection_replace_request(collection, (int)index, &request, name);
+        }
+    }
+
+    if (result < 0) {
+        free(name);
+        request_cleanup(&request);
+        return false;
+    }
+    return true;
+}
+
+static bool apply_record(Collection* collection, const unsigned char* body, size_t length) {
+    ByteReader reader;
+    byte_reader_init(&reader, body + RECORD_HEADER_SIZE, length - RECORD_HEADER_SIZE);
+    unsigned int op = body[16];
+    bool applied = false;
+
+    switch (op) {
+        case COLLECTION_JOURNAL_PUT_REQUEST:
+            applied = apply_put_request(collection, &reader);
+            break;
+
+        case COLLECTION_JOURNAL_REMOVE_REQUEST: {
+            uint32_t index = byte_reader_u32(&reader);
+            applied = !reader.failed && index < (uint32_t)collection->request_count &&
+                      collection_remove_request(collection, (int)index) == 0;
+            break;
+        }
+
+        case COLLECTION_JOURNAL_SET_COLLECTION: {
+            char name[sizeof(collection->name)];
+            char description[sizeof(collection->description)];
+            byte_reader_field(&reader, name, sizeof(name));
+            byte_reader_field(&reader, description, sizeof(description));
+            if (!reader.failed && name[0] != '\0') {
+                memcpy(collection->name, name, sizeof(name));
+                memcpy(collection->description, description, sizeof(description));
+                applied = true;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return applied;
+}
+
+/* size of the record at data if it is whole and its checksum matches, 0 otherwise */
+static size_t check_record(const unsigned char* data, size_t available, unsigned long* seq) {
+    if (available < RECORD_FRAME_SIZE) {
+        return 0;
+    }
+
+    ByteReader frame;
+    byte_reader_init(&frame, data, available);
+    uint32_t body_length = byte_reader_u32(&frame);
+    uint32_t checksum = byte_reader_u32(&frame);
+    if (body_length < RECORD_HEADER_SIZE || available - RECORD_FRAME_SIZE < body_length ||
+        binary_checksum(data + RECORD_FRAME_SIZE, body_length) != checksum) {
+        return 0;
+    }
+
+    *seq = (unsigned long)byte_reader_u64(&frame);
+    return RECORD_FRAME_SIZE + body_length;
+}
+
+char* collection_journal_get_path(const char* collection_id) {
+    if (!collection_id || collection_id[0] == '\0') {
+        return NULL;
+    }
+
+    char filename[128];
+    snprintf(filename, sizeof(filename), "%s.journal", collection_id);
+    return persistence_get_collections_path(filename);
+}
+
+/* reads the whole journal, NULL with length 0 when there is none */
+static unsigned char* read_journal(const char* path, size_t* length, int* error) {
+    *length = 0;
+    *error = PERSISTENCE_SUCCESS;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        if (errno != ENOENT) {
+            *error = PERSISTENCE_ERROR_PERMISSION_DENIED;
+        }
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    unsigned char* data = (unsigned char*)malloc((size_t)size);
+    if (!data) {
+        fclose(file);
+        *error = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
+    }
+
+    size_t read_size = fread(data, 1, (size_t)size, file);
+    fclose(file);
+
+    *length = read_size;
+    return data;
+}
+
+/* cuts the journal after its last good record */
+static void truncate_journal(const char* path, size_t length) {
+#ifdef _WIN32
+    int fd = _open(path, _O_WRONLY | _O_BINARY);
+    if (fd >= 0) {
+        _chsize_s(fd, (long long)length);
+        _commit(fd);
+        _close(fd);
+    }
+#else
+    if (truncate(path, (off_t)length) == 0) {
+        int fd = open(path, O_WRONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+#endif
+}
+
+int collection_journal_replay(Collection* collection) {
+    if (!collection) {
+        return 0;
+    }
+
+    char* path = collection_journal_get_path(collection->id);
+    if (!path) {
+        return 0;
+    }
+
+    size_t length = 0;
+    int error = PERSISTENCE_SUCCESS;
+    unsigned char* data = read_journal(path, &length, &error);
+
+    /* the snapshot's modified time stays unless a record brings a newer one */
+    time_t modified_at = collection->modified_at;
+    size_t offset = 0;
+    int applied = 0;
+
+    while (offset < length) {
+        unsigned long seq = 0;
+        size_t record_size = check_record(data + offset, length - offset, &seq);
+        if (record_size == 0) {
+            break;
+        }
+
+        if (seq > collection->journal_seq) {
+            /* a gap means an earlier append failed, and what follows was
+             * made on top of an edit that is not here */
+            if (seq != collection->journal_seq + 1) {
+                break;
+            }
+
+            const unsigned char* body = data + offset + RECORD_FRAME_SIZE;
+            if (!apply_record(collection, body, record_size - RECORD_FRAME_SIZE)) {
+                break;
+            }
+
+            ByteReader header;
+            byte_reader_init(&header, body + 8, 8);
+            modified_at = (time_t)(int64_t)byte_reader_u64(&header);
+            collection->journal_seq = seq;
+            applied++;
+        }
+        offset += record_size;
+    }
+
+    if (offset < length) {
+        printf("Journal for collection %s ends in a damaged record, keeping %zu of %zu bytes\n",
+               collection->id, offset, length);
+        truncate_journal(path, offset);
+    }
+
+    collection->modified_at = modified_at;
+    collection->journal_size = offset;
+
+    free(data);
+    free(path);
+    return applied;
+}
+
+int collection_journal_append(const char* collection_id, const char* records, size_t length) {
+    if (!records || length == 0) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    char* path = collection_journal_get_path(collection_id);
+    if (!path) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    int result = PERSISTENCE_SUCCESS;
+    bool created = !persistence_file_exists(path);
+
+#ifdef _WIN32
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) {
+        free(path);
+        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+
+    if (_write(fd, records, (unsigned int)length) != (int)length || _commit(fd) != 0) {
+        result = PERSISTENCE_ERROR_DISK_FULL;
+    }
+    _close(fd);
+#else
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        free(path);
+        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+
+    size_t written = 0;
+    while (written < length) {
+        ssize_t count = write(fd, records + written, length - written);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            result = PERSISTENCE_ERROR_DISK_FULL;
+            break;
+        }
+        written += (size_t)count;
+    }
+
+#ifdef __APPLE__
+    if (result == PERSISTENCE_SUCCESS && fsync(fd) != 0) {
+#else
+    if (result == PERSISTENCE_SUCCESS && fdatasync(fd) != 0) {
+#endif
+        result = PERSISTENCE_ERROR_DISK_FULL;
+    }
+    close(fd);
+#endif
+
+    /* a new file is only durable once its directory entry is */
+    if (result == PERSISTENCE_SUCCESS && created) {
+        persistence_sync_parent_directory(path);
+    }
+
+    free(path);
+    return result;
+}
+
+int collection_journal_compact(const char* collection_id, unsigned long through_seq) {
+    char* path = collection_journal_get_path(collection_id);
+    if (!path) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    size_t length = 0;
+    int result = PERSISTENCE_SUCCESS;
+    unsigned char* data = read_journal(path, &length, &result);
+    if (!data) {
+        free(path);
+        return result;
+    }
+
+    /* records are in sequence order, find the first one the snapshot does not have */
+    size_t offset = 0;
+    size_t keep_from = length;
+    size_t keep_to = length;
+    while (offset < length) {
+        unsigned long seq = 0;
+        size_t record_size = check_record(data + offset, length - offset, &seq);
+        if (record_size == 0) {
+            keep_to = offset;
+            break;
+        }
+        if (seq > through_seq && keep_from == length) {
+            keep_from = offset;
+        }
+        offset += record_size;
+    }
+
+    if (keep_from >= keep_to) {
+        if (remove(path) != 0 && errno != ENOENT) {
+            result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+        }
+    } else if (keep_from > 0 || keep_to < length) {
+        result = persistence_write_file_atomic(path, (const char*)data + keep_from, keep_to - keep_from);
+    }
+
+    free(data);
+    free(path);
+    return result;
+}
+
+int collection_journal_remove(const char* collection_id) {
+    char* path = collection_journal_get_path(collection_id);
+    if (!path) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    int result = PERSISTENCE_SUCCESS;
+    if (remove(path) != 0 && errno != ENOENT) {
+        result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+    free(path);
+    return result;
+}
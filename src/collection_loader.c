@@ -0,0 +1,564 @@
+/**
+ * background collection loading for tinyrequest
+ *
+ * jobs live in one growing array and are never reordered, so a job is
+ * known by its index everywhere. the threads take jobs from the front of
+ * the array, a prioritized job is pushed onto a small urgent list that is
+ * looked at first. finished jobs go onto a done list in the order they
+ * finished, collection_loader_take can pull one out of the middle.
+ *
+ * two open addressing tables keep the lookups constant time. one maps a
+ * file name to its job, the other maps a collection id to the job that
+ * claimed it. a job claims its file name when it is added, since files
+ * are normally named after the collection they hold, and the id inside
+ * the file once it has been parsed.
+ */
+
+#include "collection_loader.h"
+#include "collection_journal.h"
+#include "collection_store.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef enum {
+    LOADER_JOB_QUEUED = 0,
+    LOADER_JOB_RUNNING,
+    LOADER_JOB_DONE,
+    LOADER_JOB_TAKEN
+} LoaderJobState;
+
+typedef struct {
+    char filepath[1024];
+    char file_id[64];
+    char content_id[64];        /* id found in the file, claimed once it differs from file_id */
+    int hint;
+    int state;                  /* LoaderJobState */
+    bool forgotten;             /* drop the result instead of handing it out */
+    LoadedCollection* result;   /* set while LOADER_JOB_DONE */
+} LoaderJob;
+
+struct CollectionLoader {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        /* new jobs and shutdown */
+    pthread_cond_t done_cond;   /* a job finished */
+    pthread_t threads[COLLECTION_LOADER_MAX_THREADS];
+    int thread_count;
+    bool threads_started;
+    bool shutting_down;
+
+    LoaderJob* jobs;
+    int job_count;
+    int job_capacity;
+    int next_job;               /* no queued job before this index */
+    int pending;                /* queued or running */
+
+    int* urgent;                /* prioritized job indices, the last one runs first */
+    int urgent_count;
+    int urgent_capacity;
+
+    int* done;                  /* finished job indices in the order they finished */
+    int done_head;
+    int done_count;
+    int done_capacity;
+
+    /* open addressing, -1 marks a free slot */
+    int* files;                 /* job index by file_id */
+    int* claims;                /* job index * 2 + 1 when the content id claimed it, by id */
+    int table_capacity;
+};
+
+/* global out-of-memory handler */
+static void (*g_loader_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_loader_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_loader_out_of_memory_handler) {
+        g_loader_out_of_memory_handler(operation);
+    } else {
+        default_loader_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void collection_loader_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_loader_out_of_memory_handler = handler;
+}
+
+static double loader_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned long hash_id(const char* id) {
+    unsigned long hash = 2166136261u;
+    for (const char* c = id; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    return hash;
+}
+
+static const char* claim_key(const CollectionLoader* loader, int entry) {
+    const LoaderJob* job = &loader->jobs[entry / 2];
+    return (entry & 1) ? job->content_id : job->file_id;
+}
+
+/* slot holding key, or the free slot it would go into */
+static int table_slot(const CollectionLoader* loader, const int* table, bool claims, const char* key) {
+    int mask = loader->table_capacity - 1;
+    int slot = (int)(hash_id(key) & (unsigned long)mask);
+    while (table[slot] >= 0) {
+        const char* existing = claims ? claim_key(loader, table[slot]) : loader->jobs[table[slot]].file_id;
+        if (strcmp(existing, key) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/* keeps both tables at most half full, call with the mutex held */
+static int tables_reserve(CollectionLoader* loader, int entries) {
+    if (entries * 2 <= loader->table_capacity) {
+        return 0;
+    }
+
+    int capacity = loader->table_capacity > 0 ? loader->table_capacity : 256;
+    while (entries * 2 > capacity) {
+        capacity *= 2;
+    }
+
+    int* files = (int*)malloc((size_t)capacity * sizeof(int));
+    int* claims = (int*)malloc((size_t)capacity * sizeof(int));
+    if (!files || !claims) {
+        free(files);
+        free(claims);
+        handle_out_of_memory("collection loader table");
+        return -1;
+    }
+    memset(files, 0xFF, (size_t)capacity * sizeof(int));
+    memset(claims, 0xFF, (size_t)capacity * sizeof(int));
+
+    int* old_files = loader->files;
+    int* old_claims = loader->claims;
+    int old_capacity = loader->table_capacity;
+    loader->files = files;
+    loader->claims = claims;
+    loader->table_capacity = capacity;
+
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_files[i] >= 0) {
+            files[table_slot(loader, files, false, loader->jobs[old_files[i]].file_id)] = old_files[i];
+        }
+        if (old_claims[i] >= 0) {
+            claims[table_slot(loader, claims, true, claim_key(loader, old_claims[i]))] = old_claims[i];
+        }
+    }
+
+    free(old_files);
+    free(old_claims);
+    return 0;
+}
+
+static int find_job(const CollectionLoader* loader, const char* file_id) {
+    if (!file_id || loader->table_capacity == 0) {
+        return -1;
+    }
+    return loader->files[table_slot(loader, loader->files, false, file_id)];
+}
+
+/* claims a collection id for a job, returns false if another job holds it */
+static bool claim_id(CollectionLoader* loader, int job_index, bool content) {
+    const LoaderJob* job = &loader->jobs[job_index];
+    const char* id = content ? job->content_id : job->file_id;
+    int slot = table_slot(loader, loader->claims, true, id);
+    if (loader->claims[slot] >= 0) {
+        return loader->claims[slot] / 2 == job_index;
+    }
+    loader->claims[slot] = job_index * 2 + (content ? 1 : 0);
+    return true;
+}
+
+static int push_index(int** array, int* count, int* capacity, int value) {
+    if (*count >= *capacity) {
+        int grown = *capacity > 0 ? *capacity * 2 : 64;
+        int* resized = (int*)realloc(*array, (size_t)grown * sizeof(int));
+        if (!resized) {
+            handle_out_of_memory("collection loader queue");
+            return -1;
+        }
+        *array = resized;
+        *capacity = grown;
+    }
+    (*array)[(*count)++] = value;
+    return 0;
+}
+
+/* next queued job, urgent ones first, call with the mutex held */
+static int next_queued_job(CollectionLoader* loader) {
+    while (loader->urgent_count > 0) {
+        int index = loader->urgent[--loader->urgent_count];
+        if (loader->jobs[index].state == LOADER_JOB_QUEUED) {
+            return index;
+        }
+    }
+    while (loader->next_job < loader->job_count) {
+        int index = loader->next_job++;
+        if (loader->jobs[index].state == LOADER_JOB_QUEUED) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+static void* collection_loader_thread(void* arg) {
+    CollectionLoader* loader = (CollectionLoader*)arg;
+
+    pthread_mutex_lock(&loader->mutex);
+    while (!loader->shutting_down) {
+        int index = next_queued_job(loader);
+        if (index < 0) {
+            pthread_cond_wait(&loader->cond, &loader->mutex);
+            continue;
+        }
+
+        LoaderJob* job = &loader->jobs[index];
+        job->state = LOADER_JOB_RUNNING;
+        char filepath[sizeof(job->filepath)];
+        char file_id[sizeof(job->file_id)];
+        memcpy(filepath, job->filepath, sizeof(filepath));
+        memcpy(file_id, job->file_id, sizeof(file_id));
+        pthread_mutex_unlock(&loader->mutex);
+
+        LoadedCollection* loaded = (LoadedCollection*)calloc(1, sizeof(LoadedCollection));
+        if (loaded) {
+            double started = loader_now_ms();
+            loaded->result = persistence_read_collection_file(&loaded->collection, filepath,
+                                                              &loaded->auth, &loaded->has_auth);
+
+            /* the journal belongs to the file saves go to, a stray copy under another name skips it */
+            if (loaded->result == PERSISTENCE_SUCCESS && strcmp(loaded->collection.id, file_id) == 0) {
+                collection_journal_replay(&loaded->collection);
+            }
+            loaded->parse_ms = loader_now_ms() - started;
+        } else {
+            handle_out_of_memory("collection loader result");
+        }
+
+        pthread_mutex_lock(&loader->mutex);
+        /* the array may have moved while the file was read */
+        job = &loader->jobs[index];
+        if (loaded) {
+            memcpy(loaded->file_id, job->file_id, sizeof(loaded->file_id));
+            loaded->hint = job->hint;
+            if (loaded->result == PERSISTENCE_SUCCESS) {
+                snprintf(job->content_id, sizeof(job->content_id), "%s", loaded->collection.id);
+                bool content_is_file = strcmp(job->content_id, job->file_id) == 0;
+                loaded->duplicate = !claim_id(loader, index, !content_is_file);
+            }
+        }
+
+        loader->pending--;
+        if (job->forgotten || !loaded ||
+            push_index(&loader->done, &loader->done_count, &loader->done_capacity, index) != 0) {
+            loaded_collection_cleanup(loaded);
+            free(loaded);
+            job->state = LOADER_JOB_TAKEN;
+        } else {
+            job->result = loaded;
+            job->state = LOADER_JOB_DONE;
+        }
+        pthread_cond_broadcast(&loader->done_cond);
+        wake_signal_post();
+    }
+    pthread_mutex_unlock(&loader->mutex);
+
+    return NULL;
+}
+
+/* starts the threads, call with the mutex held */
+static void start_threads(CollectionLoader* loader) {
+    int wanted = loader->thread_count;
+    loader->thread_count = 0;
+    for (int i = 0; i < wanted; i++) {
+        if (pthread_create(&loader->threads[i], NULL, collection_loader_thread, loader) != 0) {
+            break;
+        }
+        loader->thread_count++;
+    }
+    loader->threads_started = true;
+}
+
+/* creates a loader with the given number of threads, they are started on first use */
+CollectionLoader* collection_loader_create(int thread_count) {
+    CollectionLoader* loader = (CollectionLoader*)calloc(1, sizeof(CollectionLoader));
+    if (!loader) {
+        handle_out_of_memory("collection loader creation");
+        return NULL;
+    }
+
+    if (thread_count <= 0) {
+        thread_count = COLLECTION_LOADER_DEFAULT_THREADS;
+    } else if (thread_count > COLLECTION_LOADER_MAX_THREADS) {
+        thread_count = COLLECTION_LOADER_MAX_THREADS;
+    }
+
+    pthread_mutex_init(&loader->mutex, NULL);
+    pthread_cond_init(&loader->cond, NULL);
+    pthread_cond_init(&loader->done_cond, NULL);
+    loader->thread_count = thread_count;
+    return loader;
+}
+
+/* stops the threads once they finish the file in hand and frees every result */
+void collection_loader_destroy(CollectionLoader* loader) {
+    if (!loader) {
+        return;
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    loader->shutting_down = true;
+    pthread_cond_broadcast(&loader->cond);
+    pthread_mutex_unlock(&loader->mutex);
+
+    if (loader->threads_started) {
+        for (int i = 0; i < loader->thread_count; i++) {
+            pthread_join(loader->threads[i], NULL);
+        }
+    }
+
+    for (int i = 0; i < loader->job_count; i++) {
+        if (loader->jobs[i].result) {
+            loaded_collection_cleanup(loader->jobs[i].result);
+            free(loader->jobs[i].result);
+        }
+    }
+
+    free(loader->jobs);
+    free(loader->urgent);
+    free(loader->done);
+    free(loader->files);
+    free(loader->claims);
+    pthread_cond_destroy(&loader->done_cond);
+    pthread_cond_destroy(&loader->cond);
+    pthread_mutex_destroy(&loader->mutex);
+    free(loader);
+}
+
+/* file name without the directory and the extension */
+static void file_id_from_path(const char* filepath, char* file_id, size_t size) {
+    const char* name = filepath;
+    for (const char* c = filepath; *c; c++) {
+        if (*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+
+    size_t length = strlen(name);
+    size_t store_extension = strlen(COLLECTION_STORE_EXTENSION);
+    if (length > 5 && strcmp(name + length - 5, ".json") == 0) {
+        length -= 5;
+    } else if (length > store_extension && strcmp(name + length - store_extension, COLLECTION_STORE_EXTENSION) == 0) {
+        length -= store_extension;
+    }
+    if (length >= size) {
+        length = size - 1;
+    }
+    memcpy(file_id, name, length);
+    file_id[length] = '\0';
+}
+
+int collection_loader_add_file(CollectionLoader* loader, const char* filepath, int hint) {
+    if (!loader || !filepath) {
+        return -1;
+    }
+
+    char file_id[64];
+    file_id_from_path(filepath, file_id, sizeof(file_id));
+
+    pthread_mutex_lock(&loader->mutex);
+
+    if (find_job(loader, file_id) >= 0) {
+        pthread_mutex_unlock(&loader->mutex);
+        return 0;
+    }
+
+    if (tables_reserve(loader, loader->job_count * 2 + 2) != 0) {
+        pthread_mutex_unlock(&loader->mutex);
+        return -1;
+    }
+
+    if (loader->job_count >= loader->job_capacity) {
+        int capacity = loader->job_capacity > 0 ? loader->job_capacity * 2 : 64;
+        LoaderJob* jobs = (LoaderJob*)realloc(loader->jobs, (size_t)capacity * sizeof(LoaderJob));
+        if (!jobs) {
+            pthread_mutex_unlock(&loader->mutex);
+            handle_out_of_memory("collection loader job");
+            return -1;
+        }
+        loader->jobs = jobs;
+        loader->job_capacity = capacity;
+    }
+
+    int index = loader->job_count++;
+    LoaderJob* job = &loader->jobs[index];
+    memset(job, 0, sizeof(LoaderJob));
+    snprintf(job->filepath, sizeof(job->filepath), "%s", filepath);
+    memcpy(job->file_id, file_id, sizeof(job->file_id));
+    job->hint = hint;
+    job->state = LOADER_JOB_QUEUED;
+
+    loader->files[table_slot(loader, loader->files, false, file_id)] = index;
+    claim_id(loader, index, false);
+    loader->pending++;
+
+    if (!loader->threads_started) {
+        start_threads(loader);
+    }
+    pthread_cond_signal(&loader->cond);
+    pthread_mutex_unlock(&loader->mutex);
+    return 1;
+}
+
+/* call with the mutex held */
+static void prioritize_job(CollectionLoader* loader, int index) {
+    if (index >= 0 && loader->jobs[index].state == LOADER_JOB_QUEUED) {
+        push_index(&loader->urgent, &loader->urgent_count, &loader->urgent_capacity, index);
+    }
+}
+
+void collection_loader_prioritize(CollectionLoader* loader, const char* file_id) {
+    if (!loader) {
+        return;
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    prioritize_job(loader, find_job(loader, file_id));
+    pthread_mutex_unlock(&loader->mutex);
+}
+
+/* moves a finished result out and marks the job taken, call with the mutex held */
+static void take_result(CollectionLoader* loader, int index, LoadedCollection* loaded) {
+    LoaderJob* job = &loader->jobs[index];
+    *loaded = *job->result;
+    free(job->result);
+    job->result = NULL;
+    job->state = LOADER_JOB_TAKEN;
+}
+
+bool collection_loader_take(CollectionLoader* loader, const char* file_id, LoadedCollection* loaded) {
+    if (!loader || !loaded) {
+        return false;
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    int index = find_job(loader, file_id);
+    if (index < 0 || loader->jobs[index].forgotten) {
+        pthread_mutex_unlock(&loader->mutex);
+        return false;
+    }
+
+    prioritize_job(loader, index);
+    pthread_cond_signal(&loader->cond);
+    while (loader->thread_count > 0 &&
+           (loader->jobs[index].state == LOADER_JOB_QUEUED || loader->jobs[index].state == LOADER_JOB_RUNNING)) {
+        pthread_cond_wait(&loader->done_cond, &loader->mutex);
+    }
+
+    bool taken = loader->jobs[index].state == LOADER_JOB_DONE;
+    if (taken) {
+        take_result(loader, index, loaded);
+    }
+    pthread_mutex_unlock(&loader->mutex);
+    return taken;
+}
+
+void collection_loader_wait_all(CollectionLoader* loader) {
+    if (!loader) {
+        return;
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    while (loader->pending > 0 && loader->thread_count > 0) {
+        pthread_cond_wait(&loader->done_cond, &loader->mutex);
+    }
+    pthread_mutex_unlock(&loader->mutex);
+}
+
+void collection_loader_forget(CollectionLoader* loader, const char* file_id) {
+    if (!loader) {
+        return;
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    int index = find_job(loader, file_id);
+    if (index >= 0) {
+        LoaderJob* job = &loader->jobs[index];
+        job->forgotten = true;
+        if (job->state == LOADER_JOB_QUEUED) {
+            job->state = LOADER_JOB_TAKEN;
+            loader->pending--;
+        } else if (job->state == LOADER_JOB_DONE) {
+            loaded_collection_cleanup(job->result);
+            free(job->result);
+            job->result = NULL;
+            job->state = LOADER_JOB_TAKEN;
+        }
+    }
+    pthread_mutex_unlock(&loader->mutex);
+}
+
+bool collection_loader_poll(CollectionLoader* loader, LoadedCollection* loaded) {
+    if (!loader || !loaded) {
+        return false;
+    }
+
+    bool found = false;
+    pthread_mutex_lock(&loader->mutex);
+    while (loader->done_head < loader->done_count) {
+        int index = loader->done[loader->done_head++];
+        if (loader->jobs[index].state == LOADER_JOB_DONE) {
+            take_result(loader, index, loaded);
+            found = true;
+            break;
+        }
+    }
+    if (loader->done_head == loader->done_count) {
+        loader->done_head = 0;
+        loader->done_count = 0;
+    }
+    pthread_mutex_unlock(&loader->mutex);
+    return found;
+}
+
+int collection_loader_get_pending_count(CollectionLoader* loader) {
+    if (!loader) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    int pending = loader->pending;
+    pthread_mutex_unlock(&loader->mutex);
+    return pending;
+}
+
+void loaded_collection_cleanup(LoadedCollection* loaded) {
+    if (!loaded) {
+        return;
+    }
+
+    if (loaded->result == PERSISTENCE_SUCCESS) {
+        collection_cleanup(&loaded->collection);
+    }
+    memset(loaded, 0, sizeof(LoadedCollection));
+}
@@ -0,0 +1,483 @@
+/**
+ * streaming collection file reader for tinyrequest
+ *
+ * the json is walked with the cursor from json_reader.h, each key of the
+ * collection schema decoding its value straight into the field it ends up
+ * in.
+ *
+ * files are mapped read only. saves replace a collection file with a
+ * rename instead of rewriting it, so a mapping is never truncated under
+ * the reader.
+ */
+
+#include "collection_reader.h"
+#include "json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* request_set_body refuses anything larger, so the loader did too */
+#define MAX_BODY_SIZE (50 * 1024 * 1024)
+
+/* reads an auth object. only the fields of the selected type survive, every
+ * enabled flag defaults to true for files written before they existed */
+static void read_auth(JsonReader* reader, PersistenceAuth* auth, bool* has_type) {
+    memset(auth, 0, sizeof(PersistenceAuth));
+    auth->api_key_enabled = true;
+    auth->bearer_enabled = true;
+    auth->basic_enabled = true;
+    auth->oauth_enabled = true;
+    *has_type = false;
+
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    bool first = true;
+    char key[64];
+    double number = 0.0;
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "type")) {
+            if (json_reader_number_field(reader, &number)) {
+                auth->selected_auth_type = (int)number;
+                *has_type = true;
+            }
+        } else if (json_key_is(key, "api_key_enabled")) {
+            json_reader_bool_field(reader, &auth->api_key_enabled);
+        } else if (json_key_is(key, "bearer_enabled")) {
+            json_reader_bool_field(reader, &auth->bearer_enabled);
+        } else if (json_key_is(key, "basic_enabled")) {
+            json_reader_bool_field(reader, &auth->basic_enabled);
+        } else if (json_key_is(key, "oauth_enabled")) {
+            json_reader_bool_field(reader, &auth->oauth_enabled);
+        } else if (json_key_is(key, "api_key_name")) {
+            json_reader_string_field(reader, auth->api_key_name, sizeof(auth->api_key_name));
+        } else if (json_key_is(key, "api_key_value")) {
+            json_reader_string_field(reader, auth->api_key_value, sizeof(auth->api_key_value));
+        } else if (json_key_is(key, "api_key_location")) {
+            if (json_reader_number_field(reader, &number)) {
+                auth->api_key_location = (int)number;
+            }
+        } else if (json_key_is(key, "bearer_token")) {
+            json_reader_string_field(reader, auth->bearer_token, sizeof(auth->bearer_token));
+        } else if (json_key_is(key, "basic_username")) {
+            json_reader_string_field(reader, auth->basic_username, sizeof(auth->basic_username));
+        } else if (json_key_is(key, "basic_password")) {
+            json_reader_string_field(reader, auth->basic_password, sizeof(auth->basic_password));
+        } else if (json_key_is(key, "oauth_token")) {
+            json_reader_string_field(reader, auth->oauth_token, sizeof(auth->oauth_token));
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    /* an auth object without a type counts as no auth at all */
+    if (!*has_type) {
+        memset(auth, 0, sizeof(PersistenceAuth));
+        return;
+    }
+
+    int type = auth->selected_auth_type;
+    if (type != 1) {
+        auth->api_key_name[0] = '\0';
+        auth->api_key_value[0] = '\0';
+        auth->api_key_location = 0;
+    }
+    if (type != 2) {
+        auth->bearer_token[0] = '\0';
+    }
+    if (type != 3) {
+        auth->basic_username[0] = '\0';
+        auth->basic_password[0] = '\0';
+    }
+    if (type != 4) {
+        auth->oauth_token[0] = '\0';
+    }
+}
+
+static void read_headers(JsonReader* reader, HeaderList* headers) {
+    if (!json_reader_enter(reader, '[')) {
+        return;
+    }
+
+    bool first = true;
+    while (json_reader_next(reader, ']', &first, NULL, 0)) {
+        if (json_reader_peek(reader) != '{') {
+            json_reader_skip(reader);
+            continue;
+        }
+        if (!json_reader_enter(reader, '{')) {
+            return;
+        }
+
+        Header header;
+        size_t name_length = 0;
+        size_t value_length = 0;
+        bool has_name = false;
+        bool has_value = false;
+        bool enabled = true;
+
+        bool first_key = true;
+        char key[64];
+        while (json_reader_next(reader, '}', &first_key, key, sizeof(key))) {
+            if (json_key_is(key, "name") && json_reader_peek(reader) == '"') {
+                has_name = json_reader_string(reader, header.name, sizeof(header.name), &name_length);
+            } else if (json_key_is(key, "value") && json_reader_peek(reader) == '"') {
+                has_value = json_reader_string(reader, header.value, sizeof(header.value), &value_length);
+            } else if (json_key_is(key, "enabled")) {
+                json_reader_bool_field(reader, &enabled);
+            } else {
+                json_reader_skip(reader);
+            }
+        }
+        reader->depth--;
+
+        /* header_list_add turns down what does not fit, the truncated copy must not sneak in */
+        if (enabled && has_name && has_value &&
+            name_length < sizeof(header.name) && value_length < sizeof(header.value)) {
+            header_list_add(headers, header.name, header.value);
+        }
+    }
+    reader->depth--;
+}
+
+/* copies json text without the whitespace between tokens, for bodies saved as objects */
+static char* minify_json(const char* start, const char* end, size_t* length) {
+    char* text = (char*)malloc((size_t)(end - start) + 1);
+    if (!text) {
+        return NULL;
+    }
+
+    size_t out = 0;
+    bool in_string = false;
+    for (const char* p = start; p < end; p++) {
+        char c = *p;
+        if (in_string) {
+            text[out++] = c;
+            if (c == '\\' && p + 1 < end) {
+                text[out++] = *++p;
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+            text[out++] = c;
+        } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            text[out++] = c;
+        }
+    }
+    text[out] = '\0';
+    *length = out;
+    return text;
+}
+
+static void set_body(Request* request, char* body, size_t length) {
+    if (!body) {
+        return;
+    }
+    if (length == 0) {
+        free(body);
+        return;
+    }
+
+    /* request_set_body drops the old body before it turns down a large one */
+    free(request->body);
+    request->body = NULL;
+    request->body_size = 0;
+    if (length > MAX_BODY_SIZE) {
+        free(body);
+        return;
+    }
+    request->body = body;
+    request->body_size = length;
+}
+
+static void read_body(JsonReader* reader, Request* request) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    bool first = true;
+    char key[64];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (!json_key_is(key, "content")) {
+            json_reader_skip(reader);
+        } else if (c == '"') {
+            size_t length = 0;
+            char* body = json_reader_string_alloc(reader, &length);
+            set_body(request, body, length);
+        } else if (c == '{' || c == '[') {
+            const char* start = reader->cur;
+            json_reader_skip(reader);
+            if (!reader->failed) {
+                size_t length = 0;
+                char* body = minify_json(start, reader->cur, &length);
+                set_body(request, body, length);
+            }
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+}
+
+static void read_request(JsonReader* reader, Collection* collection) {
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    Request request;
+    request_init(&request);
+    char name[256] = "Unnamed Request";
+    PersistenceAuth auth;
+    bool has_auth_type = false;
+
+    bool first = true;
+    char key[64];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "name")) {
+            json_reader_string_field(reader, name, sizeof(name));
+        } else if (json_key_is(key, "method")) {
+            json_reader_string_field(reader, request.method, sizeof(request.method));
+        } else if (json_key_is(key, "url")) {
+            json_reader_string_field(reader, request.url, sizeof(request.url));
+        } else if (json_key_is(key, "headers") && c == '[') {
+            read_headers(reader, &request.headers);
+        } else if (json_key_is(key, "body") && c == '{') {
+            read_body(reader, &request);
+        } else if (json_key_is(key, "auth") && c == '{') {
+            read_auth(reader, &auth, &has_auth_type);
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (reader->failed || name[0] == '\0') {
+        request_cleanup(&request);
+        return;
+    }
+
+    /* without a type the request keeps the defaults request_init gave it */
+    if (has_auth_type) {
+        request.selected_auth_type = auth.selected_auth_type;
+        request.auth_api_key_enabled = auth.api_key_enabled;
+        request.auth_bearer_enabled = auth.bearer_enabled;
+        request.auth_basic_enabled = auth.basic_enabled;
+        request.auth_oauth_enabled = auth.oauth_enabled;
+        snprintf(request.auth_api_key_name, sizeof(request.auth_api_key_name), "%s", auth.api_key_name);
+        snprintf(request.auth_api_key_value, sizeof(request.auth_api_key_value), "%s", auth.api_key_value);
+        snprintf(request.auth_bearer_token, sizeof(request.auth_bearer_token), "%s", auth.bearer_token);
+        snprintf(request.auth_basic_username, sizeof(request.auth_basic_username), "%s", auth.basic_username);
+        snprintf(request.auth_basic_password, sizeof(request.auth_basic_password), "%s", auth.basic_password);
+        snprintf(request.auth_oauth_token, sizeof(request.auth_oauth_token), "%s", auth.oauth_token);
+        request.auth_api_key_location = auth.api_key_location;
+    }
+
+    size_t name_length = strlen(name);
+    char* owned_name = (char*)malloc(name_length + 1);
+    if (!owned_name) {
+        request_cleanup(&request);
+        return;
+    }
+    memcpy(owned_name, name, name_length + 1);
+
+    if (collection_adopt_request(collection, &request, owned_name) < 0) {
+        free(owned_name);
+        request_cleanup(&request);
+    }
+}
+
+static void read_cookie(JsonReader* reader, CookieJar* jar) {
+    if (jar->count >= jar->capacity) {
+        json_reader_skip(reader);
+        return;
+    }
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    StoredCookie* cookie = &jar->cookies[jar->count];
+    memset(cookie, 0, sizeof(StoredCookie));
+    strncpy(cookie->path, "/", sizeof(cookie->path) - 1);
+
+    bool first = true;
+    char key[64];
+    double number = 0.0;
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        if (json_key_is(key, "name")) {
+            json_reader_string_field(reader, cookie->name, sizeof(cookie->name));
+        } else if (json_key_is(key, "value")) {
+            json_reader_string_field(reader, cookie->value, sizeof(cookie->value));
+        } else if (json_key_is(key, "domain")) {
+            json_reader_string_field(reader, cookie->domain, sizeof(cookie->domain));
+        } else if (json_key_is(key, "path")) {
+            json_reader_string_field(reader, cookie->path, sizeof(cookie->path));
+        } else if (json_key_is(key, "expires")) {
+            if (json_reader_number_field(reader, &number)) {
+                cookie->expires = (time_t)number;
+            }
+        } else if (json_key_is(key, "max_age")) {
+            if (json_reader_number_field(reader, &number)) {
+                cookie->max_age = (int)number;
+            }
+        } else if (json_key_is(key, "secure")) {
+            json_reader_bool_field(reader, &cookie->secure);
+        } else if (json_key_is(key, "http_only")) {
+            json_reader_bool_field(reader, &cookie->http_only);
+        } else if (json_key_is(key, "same_site_strict")) {
+            json_reader_bool_field(reader, &cookie->same_site_strict);
+        } else if (json_key_is(key, "same_site_lax")) {
+            json_reader_bool_field(reader, &cookie->same_site_lax);
+        } else if (json_key_is(key, "created_at")) {
+            if (json_reader_number_field(reader, &number)) {
+                cookie->created_at = (time_t)number;
+            }
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (cookie->name[0] != '\0') {
+        jar->count++;
+    }
+}
+
+static void read_collection(JsonReader* reader, Collection* collection, PersistenceAuth* auth, bool* has_auth) {
+    /* a top level array parsed fine before and gave an empty collection */
+    if (json_reader_peek(reader) != '{') {
+        json_reader_skip(reader);
+        return;
+    }
+    if (!json_reader_enter(reader, '{')) {
+        return;
+    }
+
+    bool has_created_at = false;
+    bool has_modified_at = false;
+    double created_at = 0.0;
+    double modified_at = 0.0;
+    double journal_seq = 0.0;
+
+    bool first = true;
+    char key[64];
+    while (json_reader_next(reader, '}', &first, key, sizeof(key))) {
+        char c = json_reader_peek(reader);
+        if (json_key_is(key, "id")) {
+            json_reader_string_field(reader, collection->id, sizeof(collection->id));
+        } else if (json_key_is(key, "name")) {
+            json_reader_string_field(reader, collection->name, sizeof(collection->name));
+        } else if (json_key_is(key, "description")) {
+            json_reader_string_field(reader, collection->description, sizeof(collection->description));
+        } else if (json_key_is(key, "created_at")) {
+            has_created_at = json_reader_number_field(reader, &created_at);
+        } else if (json_key_is(key, "modified_at")) {
+            has_modified_at = json_reader_number_field(reader, &modified_at);
+        } else if (json_key_is(key, "journal_seq")) {
+            json_reader_number_field(reader, &journal_seq);
+        } else if (json_key_is(key, "requests") && c == '[') {
+            if (!json_reader_enter(reader, '[')) {
+                break;
+            }
+            bool first_request = true;
+            while (json_reader_next(reader, ']', &first_request, NULL, 0)) {
+                if (json_reader_peek(reader) == '{') {
+                    read_request(reader, collection);
+                } else {
+                    json_reader_skip(reader);
+                }
+            }
+            reader->depth--;
+        } else if (auth && json_key_is(key, "auth") && c == '{') {
+            read_auth(reader, auth, has_auth);
+        } else if (auth && json_key_is(key, "cookies") && c == '[') {
+            if (!json_reader_enter(reader, '[')) {
+                break;
+            }
+            collection->cookie_jar.count = 0;
+            bool first_cookie = true;
+            while (json_reader_next(reader, ']', &first_cookie, NULL, 0)) {
+                if (json_reader_peek(reader) == '{') {
+                    read_cookie(reader, &collection->cookie_jar);
+                } else {
+                    json_reader_skip(reader);
+                }
+            }
+            reader->depth--;
+        } else {
+            json_reader_skip(reader);
+        }
+    }
+    reader->depth--;
+
+    if (has_created_at) {
+        collection->created_at = (time_t)created_at;
+    }
+    if (has_modified_at) {
+        collection->modified_at = (time_t)modified_at;
+    }
+    if (journal_seq > 0) {
+        collection->journal_seq = (unsigned long)journal_seq;
+    }
+}
+
+int collection_reader_read_buffer(Collection* collection, const char* data, size_t length,
+                                  PersistenceAuth* auth, bool* has_auth) {
+    if (!collection || !data) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    JsonReader reader;
+    json_reader_init(&reader, data, length);
+    char c = json_reader_peek(&reader);
+    if (c != '{' && c != '[') {
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    /* built on the side, so a broken file leaves the collection alone */
+    Collection loaded;
+    memset(&loaded, 0, sizeof(Collection));
+    collection_init(&loaded, "Untitled Collection", "");
+
+    PersistenceAuth loaded_auth;
+    bool loaded_has_auth = false;
+    memset(&loaded_auth, 0, sizeof(PersistenceAuth));
+
+    read_collection(&reader, &loaded, auth ? &loaded_auth : NULL, &loaded_has_auth);
+
+    if (reader.failed) {
+        collection_cleanup(&loaded);
+        return PERSISTENCE_ERROR_INVALID_JSON;
+    }
+
+    collection_move(collection, &loaded);
+    if (auth) {
+        *auth = loaded_auth;
+        if (has_auth) {
+            *has_auth = loaded_has_auth;
+        }
+    }
+    return PERSISTENCE_SUCCESS;
+}
+
+int collection_reader_read_file(Collection* collection, const char* filepath,
+                                PersistenceAuth* auth, bool* has_auth) {
+    if (!collection || !filepath) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    PersistenceMappedFile mapped;
+    int result = persistence_map_file(&mapped, filepath, true);
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    result = collection_reader_read_buffer(collection, mapped.data, mapped.size, auth, has_auth);
+
+    persistence_unmap_file(&mapped);
+    return result;
+}
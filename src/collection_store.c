@@ -0,0 +1,601 @@
+/**
+ * binary collection files for tinyrequest
+ *
+ * numbers are little endian. a file is
+ *
+ *   header    magic "TRQC" | version | flags | request count (4 bytes each)
+ *             meta offset | meta length | index offset | index length (8 bytes each)
+ *             meta checksum | index checksum (4 bytes each)
+ *   meta      id, name, description, created_at, modified_at, journal_seq,
+ *             then with STORE_FLAG_HAS_AUTH the collection auth and cookies
+ *   blobs     one request each, encoded the way binary_io.h describes,
+ *             possibly zstd compressed
+ *   index     one 4 byte entry offset per request, relative to the index,
+ *             then the entries: blob offset (8 bytes), stored length, raw
+ *             length, blob checksum (4 bytes each), encoding (1 byte),
+ *             name, method and url
+ *
+ * strings in the meta and the index are a 32 bit length, their bytes and a
+ * nul, so the index can hand out pointers into the mapping. the index goes
+ * last so the file is written front to back in one pass. the meta and the
+ * index are checksummed as a whole when the file is opened, a blob when
+ * its request is read.
+ */
+
+#include "collection_store.h"
+#include "collection_reader.h"
+#include "binary_io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define STORE_MAGIC "TRQC"
+#define STORE_VERSION 1
+#define STORE_HEADER_SIZE 56
+#define STORE_FLAG_HAS_AUTH 1u
+
+/* a request blob is never bigger than the largest body plus its other fields */
+#define STORE_MAX_RAW_SIZE (64 * 1024 * 1024)
+
+typedef struct {
+    uint64_t blob_offset;
+    uint32_t stored_length;
+    uint32_t raw_length;
+    uint32_t checksum;
+    unsigned int encoding;
+    const char* name;
+    const char* method;
+    const char* url;
+} StoreEntry;
+
+struct CollectionStore {
+    PersistenceMappedFile mapped;
+    const unsigned char* data;
+    size_t size;
+    uint32_t flags;
+    uint32_t request_count;
+    const unsigned char* meta;
+    size_t meta_length;
+    const unsigned char* index;
+    size_t index_length;
+    const char* id;
+    const char* name;
+};
+
+bool collection_store_is_store_path(const char* filepath) {
+    if (!filepath) {
+        return false;
+    }
+
+    size_t length = strlen(filepath);
+    size_t extension_length = strlen(COLLECTION_STORE_EXTENSION);
+    return length > extension_length &&
+           strcmp(filepath + length - extension_length, COLLECTION_STORE_EXTENSION) == 0;
+}
+
+static void write_cstring(ByteWriter* writer, const char* text) {
+    byte_writer_string(writer, text);
+    byte_writer_u8(writer, 0);
+}
+
+/* points at a string written by write_cstring */
+static const char* read_cstring(ByteReader* reader) {
+    size_t length = 0;
+    const char* text = byte_reader_data(reader, &length);
+    if (!text || byte_reader_u8(reader) != 0 || memchr(text, '\0', length)) {
+        reader->failed = true;
+        return "";
+    }
+    return text;
+}
+
+static void copy_field(char* dest, size_t dest_size, const char* src) {
+    size_t length = strlen(src);
+    if (length >= dest_size) {
+        length = dest_size - 1;
+    }
+    memcpy(dest, src, length);
+    dest[length] = '\0';
+}
+
+static void write_meta(ByteWriter* writer, const Collection* collection, const PersistenceAuth* auth) {
+    write_cstring(writer, collection->id);
+    write_cstring(writer, collection->name);
+    write_cstring(writer, collection->description);
+    byte_writer_u64(writer, (uint64_t)(int64_t)collection->created_at);
+    byte_writer_u64(writer, (uint64_t)(int64_t)collection->modified_at);
+    byte_writer_u64(writer, (uint64_t)collection->journal_seq);
+
+    if (!auth) {
+        return;
+    }
+
+    byte_writer_u32(writer, (uint32_t)auth->selected_auth_type);
+    byte_writer_string(writer, auth->api_key_name);
+    byte_writer_string(writer, auth->api_key_value);
+    byte_writer_string(writer, auth->bearer_token);
+    byte_writer_string(writer, auth->basic_username);
+    byte_writer_string(writer, auth->basic_password);
+    byte_writer_string(writer, auth->oauth_token);
+    byte_writer_u32(writer, (uint32_t)auth->api_key_location);
+    byte_writer_u8(writer, (auth->api_key_enabled ? 1u : 0u) | (auth->bearer_enabled ? 2u : 0u) |
+                           (auth->basic_enabled ? 4u : 0u) | (auth->oauth_enabled ? 8u : 0u));
+
+    /* the json format keeps cookies next to the auth, only snapshots that carry auth have them */
+    const CookieJar* jar = &collection->cookie_jar;
+    byte_writer_u32(writer, (uint32_t)jar->count);
+    for (int i = 0; i < jar->count; i++) {
+        const StoredCookie* cookie = &jar->cookies[i];
+        byte_writer_string(writer, cookie->name);
+        byte_writer_string(writer, cookie->value);
+        byte_writer_string(writer, cookie->domain);
+        byte_writer_string(writer, cookie->path);
+        byte_writer_u64(writer, (uint64_t)(int64_t)cookie->expires);
+        byte_writer_u32(writer, (uint32_t)cookie->max_age);
+        byte_writer_u8(writer, (cookie->secure ? 1u : 0u) | (cookie->http_only ? 2u : 0u) |
+                               (cookie->same_site_strict ? 4u : 0u) | (cookie->same_site_lax ? 8u : 0u));
+        byte_writer_u64(writer, (uint64_t)(int64_t)cookie->created_at);
+    }
+}
+
+/* appends one request blob to out, compressed when that pays off */
+static void write_blob(ByteWriter* out, const ByteWriter* raw, StoreEntry* entry) {
+    size_t compressed_length = 0;
+    unsigned char* compressed = binary_compress(raw->data, raw->length, COLLECTION_STORE_COMPRESS_MIN,
+                                                &compressed_length);
+    const unsigned char* stored = compressed ? compressed : raw->data;
+    size_t stored_length = compressed ? compressed_length : raw->length;
+
+    entry->encoding = compressed ? BINARY_ENCODING_ZSTD : BINARY_ENCODING_RAW;
+    entry->blob_offset = out->length;
+    entry->stored_length = (uint32_t)stored_length;
+    entry->raw_length = (uint32_t)raw->length;
+    entry->checksum = binary_checksum(stored, stored_length);
+    byte_writer_bytes(out, stored, stored_length);
+
+    free(compressed);
+}
+
+char* collection_store_serialize(const Collection* collection, const PersistenceAuth* auth, size_t* length) {
+    if (!collection || !length || collection->request_count < 0) {
+        return NULL;
+    }
+
+    uint32_t count = (uint32_t)collection->request_count;
+    ByteWriter out;
+    ByteWriter table;
+    ByteWriter entries;
+    ByteWriter raw;
+    memset(&out, 0, sizeof(ByteWriter));
+    memset(&table, 0, sizeof(ByteWriter));
+    memset(&entries, 0, sizeof(ByteWriter));
+    memset(&raw, 0, sizeof(ByteWriter));
+
+    byte_writer_bytes(&out, STORE_MAGIC, 4);
+    byte_writer_u32(&out, STORE_VERSION);
+    byte_writer_u32(&out, auth ? STORE_FLAG_HAS_AUTH : 0u);
+    byte_writer_u32(&out, count);
+    for (int i = 0; i < 4; i++) {
+        byte_writer_u64(&out, 0);
+    }
+    byte_writer_u32(&out, 0);
+    byte_writer_u32(&out, 0);
+
+    size_t meta_offset = out.length;
+    write_meta(&out, collection, auth);
+    size_t meta_length = out.length - meta_offset;
+
+    for (uint32_t i = 0; i < count && !out.failed; i++) {
+        const char* name = collection->request_names[i] ? collection->request_names[i] : "Unnamed Request";
+        const Request* request = &collection->requests[i];
+
+        /* one scratch buffer for every blob */
+        raw.length = 0;
+        byte_writer_request(&raw, request);
+        if (raw.failed || raw.length > STORE_MAX_RAW_SIZE) {
+            out.failed = true;
+            break;
+        }
+
+        StoreEntry entry;
+        write_blob(&out, &raw, &entry);
+
+        byte_writer_u32(&table, (uint32_t)(count * 4u + entries.length));
+        byte_writer_u64(&entries, entry.blob_offset);
+        byte_writer_u32(&entries, entry.stored_length);
+        byte_writer_u32(&entries, entry.raw_length);
+        byte_writer_u32(&entries, entry.checksum);
+        byte_writer_u8(&entries, entry.encoding);
+        write_cstring(&entries, name);
+        write_cstring(&entries, request->method);
+        write_cstring(&entries, request->url);
+    }
+
+    size_t index_offset = out.length;
+    byte_writer_bytes(&out, table.data, table.length);
+    byte_writer_bytes(&out, entries.data, entries.length);
+    size_t index_length = out.length - index_offset;
+
+    bool failed = out.failed || table.failed || entries.failed || raw.failed ||
+                  index_length - table.length > UINT32_MAX;
+    free(table.data);
+    free(entries.data);
+    free(raw.data);
+
+    if (failed) {
+        free(out.data);
+        return NULL;
+    }
+
+    byte_writer_patch_u64(&out, 16, meta_offset);
+    byte_writer_patch_u64(&out, 24, meta_length);
+    byte_writer_patch_u64(&out, 32, index_offset);
+    byte_writer_patch_u64(&out, 40, index_length);
+    byte_writer_patch_u32(&out, 48, binary_checksum(out.data + meta_offset, meta_length));
+    byte_writer_patch_u32(&out, 52, binary_checksum(out.data + index_offset, index_length));
+
+    *length = out.length;
+    return (char*)out.data;
+}
+
+/* true if length bytes at offset lie inside the file */
+static bool store_range_ok(const CollectionStore* store, uint64_t offset, uint64_t length) {
+    return offset <= store->size && length <= store->size - offset;
+}
+
+static bool store_parse_header(CollectionStore* store) {
+    if (store->size < STORE_HEADER_SIZE || memcmp(store->data, STORE_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    ByteReader header;
+    byte_reader_init(&header, store->data + 4, STORE_HEADER_SIZE - 4);
+    uint32_t version = byte_reader_u32(&header);
+    store->flags = byte_reader_u32(&header);
+    store->request_count = byte_reader_u32(&header);
+    uint64_t meta_offset = byte_reader_u64(&header);
+    uint64_t meta_length = byte_reader_u64(&header);
+    uint64_t index_offset = byte_reader_u64(&header);
+    uint64_t index_length = byte_reader_u64(&header);
+    uint32_t meta_checksum = byte_reader_u32(&header);
+    uint32_t index_checksum = byte_reader_u32(&header);
+
+    if (header.failed || version != STORE_VERSION || store->request_count > INT32_MAX ||
+        !store_range_ok(store, meta_offset, meta_length) || !store_range_ok(store, index_offset, index_length) ||
+        index_length / 4 < store->request_count) {
+        return false;
+    }
+
+    store->meta = store->data + meta_offset;
+    store->meta_length = (size_t)meta_length;
+    store->index = store->data + index_offset;
+    store->index_length = (size_t)index_length;
+
+    if (binary_checksum(store->meta, store->meta_length) != meta_checksum ||
+        binary_checksum(store->index, store->index_length) != index_checksum) {
+        return false;
+    }
+
+    ByteReader meta;
+    byte_reader_init(&meta, store->meta, store->meta_length);
+    store->id = read_cstring(&meta);
+    store->name = read_cstring(&meta);
+    return !meta.failed;
+}
+
+static void store_unmap(CollectionStore* store) {
+    persistence_unmap_file(&store->mapped);
+    store->data = NULL;
+}
+
+/* maps the file read only, entries are read in any order */
+static int store_map(CollectionStore* store, const char* filepath) {
+    int result = persistence_map_file(&store->mapped, filepath, false);
+    if (result == PERSISTENCE_SUCCESS) {
+        store->data = (const unsigned char*)store->mapped.data;
+        store->size = store->mapped.size;
+    }
+    return result;
+}
+
+CollectionStore* collection_store_open(const char* filepath, int* error) {
+    int result = PERSISTENCE_SUCCESS;
+    CollectionStore* store = NULL;
+
+    if (!filepath) {
+        result = PERSISTENCE_ERROR_NULL_PARAM;
+    } else if (!(store = (CollectionStore*)calloc(1, sizeof(CollectionStore)))) {
+        result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    } else if ((result = store_map(store, filepath)) == PERSISTENCE_SUCCESS && !store_parse_header(store)) {
+        result = PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    if (result != PERSISTENCE_SUCCESS && store) {
+        store_unmap(store);
+        free(store);
+        store = NULL;
+    }
+    if (error) {
+        *error = result;
+    }
+    return store;
+}
+
+void collection_store_close(CollectionStore* store) {
+    if (!store) {
+        return;
+    }
+
+    store_unmap(store);
+    free(store);
+}
+
+const char* collection_store_get_id(const CollectionStore* store) {
+    return store ? store->id : NULL;
+}
+
+const char* collection_store_get_name(const CollectionStore* store) {
+    return store ? store->name : NULL;
+}
+
+int collection_store_get_request_count(const CollectionStore* store) {
+    return store ? (int)store->request_count : 0;
+}
+
+static bool store_read_entry(const CollectionStore* store, int index, StoreEntry* entry) {
+    if (!store || index < 0 || (uint32_t)index >= store->request_count) {
+        return false;
+    }
+
+    ByteReader table;
+    byte_reader_init(&table, store->index + (size_t)index * 4, 4);
+    uint32_t offset = byte_reader_u32(&table);
+    if (offset < store->request_count * 4u || offset >= store->index_length) {
+        return false;
+    }
+
+    ByteReader reader;
+    byte_reader_init(&reader, store->index + offset, store->index_length - offset);
+    entry->blob_offset = byte_reader_u64(&reader);
+    entry->stored_length = byte_reader_u32(&reader);
+    entry->raw_length = byte_reader_u32(&reader);
+    entry->checksum = byte_reader_u32(&reader);
+    entry->encoding = byte_reader_u8(&reader);
+    entry->name = read_cstring(&reader);
+    entry->method = read_cstring(&reader);
+    entry->url = read_cstring(&reader);
+
+    return !reader.failed && store_range_ok(store, entry->blob_offset, entry->stored_length) &&
+           entry->raw_length <= STORE_MAX_RAW_SIZE;
+}
+
+bool collection_store_get_entry(const CollectionStore* store, int index, CollectionStoreEntry* entry) {
+    StoreEntry stored;
+    if (!entry || !store_read_entry(store, index, &stored)) {
+        return false;
+    }
+
+    entry->name = stored.name;
+    entry->method = stored.method;
+    entry->url = stored.url;
+    entry->size = stored.raw_length;
+    entry->compressed = stored.encoding != BINARY_ENCODING_RAW;
+    return true;
+}
+
+int collection_store_read_request(const CollectionStore* store, int index, Request* request) {
+    if (!store || !request) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    StoreEntry entry;
+    if (!store_read_entry(store, index, &entry)) {
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    const unsigned char* blob = store->data + entry.blob_offset;
+    if (binary_checksum(blob, entry.stored_length) != entry.checksum) {
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    unsigned char* decompressed = NULL;
+    size_t raw_length = entry.stored_length;
+
+    if (entry.encoding == BINARY_ENCODING_ZSTD) {
+        if (!binary_compression_available()) {
+            printf("Request %d of collection %s is zstd compressed, this build has no zstd\n", index, store->id);
+            return PERSISTENCE_ERROR_CORRUPTED_DATA;
+        }
+        decompressed = binary_decompress(blob, entry.stored_length, entry.raw_length);
+        if (!decompressed) {
+            return PERSISTENCE_ERROR_CORRUPTED_DATA;
+        }
+        blob = decompressed;
+        raw_length = entry.raw_length;
+    } else if (entry.encoding != BINARY_ENCODING_RAW || entry.raw_length != entry.stored_length) {
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    ByteReader reader;
+    byte_reader_init(&reader, blob, raw_length);
+    bool ok = byte_reader_request(&reader, request);
+    free(decompressed);
+
+    return ok ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_CORRUPTED_DATA;
+}
+
+/* fills auth and the cookie jar from the part of the meta after journal_seq */
+static void read_meta_auth(ByteReader* meta, PersistenceAuth* auth, CookieJar* jar) {
+    auth->selected_auth_type = (int)byte_reader_u32(meta);
+    byte_reader_field(meta, auth->api_key_name, sizeof(auth->api_key_name));
+    byte_reader_field(meta, auth->api_key_value, sizeof(auth->api_key_value));
+    byte_reader_field(meta, auth->bearer_token, sizeof(auth->bearer_token));
+    byte_reader_field(meta, auth->basic_username, sizeof(auth->basic_username));
+    byte_reader_field(meta, auth->basic_password, sizeof(auth->basic_password));
+    byte_reader_field(meta, auth->oauth_token, sizeof(auth->oauth_token));
+    auth->api_key_location = (int)byte_reader_u32(meta);
+    unsigned int flags = byte_reader_u8(meta);
+    auth->api_key_enabled = (flags & 1u) != 0;
+    auth->bearer_enabled = (flags & 2u) != 0;
+    auth->basic_enabled = (flags & 4u) != 0;
+    auth->oauth_enabled = (flags & 8u) != 0;
+
+    uint32_t cookie_count = byte_reader_u32(meta);
+    jar->count = 0;
+    for (uint32_t i = 0; i < cookie_count && !meta->failed; i++) {
+        StoredCookie cookie;
+        memset(&cookie, 0, sizeof(StoredCookie));
+        byte_reader_field(meta, cookie.name, sizeof(cookie.name));
+        byte_reader_field(meta, cookie.value, sizeof(cookie.value));
+        byte_reader_field(meta, cookie.domain, sizeof(cookie.domain));
+        byte_reader_field(meta, cookie.path, sizeof(cookie.path));
+        cookie.expires = (time_t)(int64_t)byte_reader_u64(meta);
+        cookie.max_age = (int)byte_reader_u32(meta);
+        unsigned int cookie_flags = byte_reader_u8(meta);
+        cookie.secure = (cookie_flags & 1u) != 0;
+        cookie.http_only = (cookie_flags & 2u) != 0;
+        cookie.same_site_strict = (cookie_flags & 4u) != 0;
+        cookie.same_site_lax = (cookie_flags & 8u) != 0;
+        cookie.created_at = (time_t)(int64_t)byte_reader_u64(meta);
+
+        /* the jar has a fixed capacity, the json reader drops the rest too */
+        if (!meta->failed && cookie.name[0] != '\0' && jar->count < jar->capacity) {
+            jar->cookies[jar->count++] = cookie;
+        }
+    }
+}
+
+int collection_store_read_collection(const CollectionStore* store, Collection* collection,
+                                     PersistenceAuth* auth, bool* has_auth) {
+    if (!store || !collection) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    /* built on the side, so a broken file leaves the collection alone */
+    Collection loaded;
+    memset(&loaded, 0, sizeof(Collection));
+    collection_init(&loaded, "Untitled Collection", "");
+
+    PersistenceAuth loaded_auth;
+    memset(&loaded_auth, 0, sizeof(PersistenceAuth));
+    bool loaded_has_auth = (store->flags & STORE_FLAG_HAS_AUTH) != 0;
+
+    ByteReader meta;
+    byte_reader_init(&meta, store->meta, store->meta_length);
+    copy_field(loaded.id, sizeof(loaded.id), read_cstring(&meta));
+    copy_field(loaded.name, sizeof(loaded.name), read_cstring(&meta));
+    copy_field(loaded.description, sizeof(loaded.description), read_cstring(&meta));
+    loaded.created_at = (time_t)(int64_t)byte_reader_u64(&meta);
+    loaded.modified_at = (time_t)(int64_t)byte_reader_u64(&meta);
+    loaded.journal_seq = (unsigned long)byte_reader_u64(&meta);
+    if (auth && loaded_has_auth) {
+        read_meta_auth(&meta, &loaded_auth, &loaded.cookie_jar);
+    }
+
+    int result = meta.failed ? PERSISTENCE_ERROR_CORRUPTED_DATA : PERSISTENCE_SUCCESS;
+
+    for (uint32_t i = 0; i < store->request_count && result == PERSISTENCE_SUCCESS; i++) {
+        StoreEntry entry;
+        if (!store_read_entry(store, (int)i, &entry)) {
+            result = PERSISTENCE_ERROR_CORRUPTED_DATA;
+            break;
+        }
+
+        Request request;
+        request_init(&request);
+        result = collection_store_read_request(store, (int)i, &request);
+
+        size_t name_length = strlen(entry.name);
+        char* name = result == PERSISTENCE_SUCCESS ? (char*)malloc(name_length + 1) : NULL;
+        if (name) {
+            memcpy(name, entry.name, name_length + 1);
+        } else if (result == PERSISTENCE_SUCCESS) {
+            result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        }
+
+        /* an unnamed request is skipped, the way the json reader does it */
+        if (result != PERSISTENCE_SUCCESS || collection_adopt_request(&loaded, &request, name) < 0) {
+            free(name);
+            request_cleanup(&request);
+        }
+    }
+
+    if (result != PERSISTENCE_SUCCESS) {
+        collection_cleanup(&loaded);
+        return result;
+    }
+
+    collection_move(collection, &loaded);
+    if (auth) {
+        *auth = loaded_auth;
+        if (has_auth) {
+            *has_auth = loaded_has_auth;
+        }
+    }
+    return PERSISTENCE_SUCCESS;
+}
+
+int collection_store_read_file(Collection* collection, const char* filepath,
+                               PersistenceAuth* auth, bool* has_auth) {
+    if (!collection || !filepath) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    int result = PERSISTENCE_SUCCESS;
+    CollectionStore* store = collection_store_open(filepath, &result);
+    if (!store) {
+        return result;
+    }
+
+    result = collection_store_read_collection(store, collection, auth, has_auth);
+    collection_store_close(store);
+    return result;
+}
+
+int collection_store_convert_from_json(const char* json_path, const char* store_path) {
+    if (!json_path || !store_path) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    Collection collection;
+    memset(&collection, 0, sizeof(Collection));
+    PersistenceAuth auth;
+    bool has_auth = false;
+
+    int result = collection_reader_read_file(&collection, json_path, &auth, &has_auth);
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    size_t length = 0;
+    char* data = collection_store_serialize(&collection, has_auth ? &auth : NULL, &length);
+    result = data ? persistence_write_file_atomic(store_path, data, length) : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+
+    free(data);
+    collection_cleanup(&collection);
+    return result;
+}
+
+int collection_store_convert_to_json(const char* store_path, const char* json_path) {
+    if (!store_path || !json_path) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    Collection collection;
+    memset(&collection, 0, sizeof(Collection));
+    PersistenceAuth auth;
+    bool has_auth = false;
+
+    int result = collection_store_read_file(&collection, store_path, &auth, &has_auth);
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    char* json = persistence_serialize_collection(&collection, has_auth ? &auth : NULL);
+    result = json ? persistence_write_file_atomic(json_path, json, strlen(json)) : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+
+    free(json);
+    collection_cleanup(&collection);
+    return result;
+}
@@ -24,13 +24,18 @@ static void handle_collections_out_of_memory(const char* operation) {
 #define DEFAULT_REQUEST_CAPACITY 16
 #define DEFAULT_COOKIE_CAPACITY 32
 
-static void generate_collection_id(char* id_buffer, size_t buffer_size) {
+static int g_ids_seeded = 0;
 
-    static int seeded = 0;
-    if (!seeded) {
+static void seed_collection_ids(void) {
+    if (!g_ids_seeded) {
         srand((unsigned int)time(NULL));
-        seeded = 1;
+        g_ids_seeded = 1;
     }
+}
+
+static void generate_collection_id(char* id_buffer, size_t buffer_size) {
+
+    seed_collection_ids();
 
     time_t now = time(NULL);
     int random_part = rand() % 10000;
@@ -87,6 +92,11 @@ void collection_init(Collection* collection, const char* name, const char* descr
     }
 
     generate_collection_id(collection->id, sizeof(collection->id));
+    collection->generation = 0;
+    collection->saved_generation = 0;
+    collection->loaded = true;
+    collection->journal_seq = 0;
+    collection->journal_size = 0;
 
     const char* safe_name = name ? name : "Untitled Collection";
     const char* safe_description = description ? description : "";
@@ -242,12 +252,6 @@ int collection_add_request(Collection* collection, const Request* request, const
     collection->requests[index].auth_bearer_enabled = request->auth_bearer_enabled;
     collection->requests[index].auth_basic_enabled = request->auth_basic_enabled;
     collection->requests[index].auth_oauth_enabled = request->auth_oauth_enabled;
-    
-    printf("DEBUG: collection_add_request - copied auth data: type=%d, api_key_name='%s', bearer_token='%s', api_key_enabled=%s\n",
-           collection->requests[index].selected_auth_type,
-           collection->requests[index].auth_api_key_name,
-           collection->requests[index].auth_bearer_token,
-           collection->requests[index].auth_api_key_enabled ? "true" : "false");
 
     collection->request_names[index] = malloc(name_len + 1);
     if (!collection->request_names[index]) {
@@ -265,6 +269,56 @@ int collection_add_request(Collection* collection, const Request* request, const
     return index;
 }
 
+/* appends a request by moving it in, the collection takes over its body, headers and the
+ * malloc'd name. unlike add_request nothing is copied and the modified time is left alone,
+ * which is what a loader filling a collection wants. on failure the caller keeps both */
+int collection_adopt_request(Collection* collection, Request* request, char* name) {
+    if (!collection || !request || !name || name[0] == '\0') {
+        return -1;
+    }
+
+    if (collection->request_count >= collection->request_capacity) {
+        if (resize_array((void**)&collection->requests, &collection->request_capacity, sizeof(Request)) != 0) {
+            return -1;
+        }
+
+        char** new_names = realloc(collection->request_names, collection->request_capacity * sizeof(char*));
+        if (!new_names) {
+            return -1;
+        }
+        collection->request_names = new_names;
+
+        for (int i = collection->request_count; i < collection->request_capacity; i++) {
+            collection->request_names[i] = NULL;
+        }
+    }
+
+    int index = collection->request_count;
+    collection->requests[index] = *request;
+    collection->request_names[index] = name;
+    collection->request_count++;
+
+    request_init(request);
+    return index;
+}
+
+/* swaps in a new version of a request, taking ownership the way adopt_request does */
+int collection_replace_request(Collection* collection, int request_index, Request* request, char* name) {
+    if (!collection || !request || !name || name[0] == '\0' ||
+        request_index < 0 || request_index >= collection->request_count) {
+        return -1;
+    }
+
+    request_cleanup(&collection->requests[request_index]);
+    free(collection->request_names[request_index]);
+
+    collection->requests[request_index] = *request;
+    collection->request_names[request_index] = name;
+
+    request_init(request);
+    return request_index;
+}
+
 int collection_remove_request(Collection* collection, int request_index) {
     if (!collection || request_index < 0 || request_index >= collection->request_count) {
         return -1;
@@ -369,9 +423,90 @@ int collection_set_description(Collection* collection, const char* description)
 void collection_update_modified_time(Collection* collection) {
     if (collection) {
         collection->modified_at = time(NULL);
+        collection->generation++;
     }
 }
 
+/* true when the collection changed since it was last written */
+bool collection_is_dirty(const Collection* collection) {
+    return collection && collection->generation != collection->saved_generation;
+}
+
+/* records that the collection as of generation is on disk. a snapshot can finish after
+ * journaled edits already made a newer generation durable, so this never moves back */
+void collection_mark_saved(Collection* collection, unsigned int generation) {
+    if (collection && (int)(generation - collection->saved_generation) > 0) {
+        collection->saved_generation = generation;
+    }
+}
+
+/* deep copies a collection with its id and generations, used to snapshot it for saving */
+int collection_copy(Collection* dest, const Collection* src) {
+    if (!dest || !src) {
+        return -1;
+    }
+
+    *dest = *src;
+    int capacity = src->request_count > 0 ? src->request_count : 1;
+    dest->requests = malloc(capacity * sizeof(Request));
+    dest->request_names = calloc(capacity, sizeof(char*));
+    dest->request_count = 0;
+    dest->request_capacity = capacity;
+    dest->cookie_jar.cookies = NULL;
+    dest->cookie_jar.count = 0;
+    dest->cookie_jar.capacity = 0;
+
+    if (!dest->requests || !dest->request_names) {
+        handle_collections_out_of_memory("collection copy");
+        collection_cleanup(dest);
+        return -1;
+    }
+
+    for (int i = 0; i < src->request_count; i++) {
+        if (request_copy(&dest->requests[i], &src->requests[i]) != 0) {
+            collection_cleanup(dest);
+            return -1;
+        }
+        dest->request_count++;
+
+        if (src->request_names[i]) {
+            size_t name_len = strlen(src->request_names[i]);
+            dest->request_names[i] = malloc(name_len + 1);
+            if (!dest->request_names[i]) {
+                handle_collections_out_of_memory("collection copy");
+                collection_cleanup(dest);
+                return -1;
+            }
+            memcpy(dest->request_names[i], src->request_names[i], name_len + 1);
+        }
+    }
+
+    if (src->cookie_jar.count > 0) {
+        dest->cookie_jar.cookies = malloc(src->cookie_jar.count * sizeof(StoredCookie));
+        if (!dest->cookie_jar.cookies) {
+            handle_collections_out_of_memory("collection copy");
+            collection_cleanup(dest);
+            return -1;
+        }
+        memcpy(dest->cookie_jar.cookies, src->cookie_jar.cookies, src->cookie_jar.count * sizeof(StoredCookie));
+        dest->cookie_jar.count = src->cookie_jar.count;
+        dest->cookie_jar.capacity = src->cookie_jar.count;
+    }
+
+    return 0;
+}
+
+/* hands the requests and cookies of src to dest without copying them, src is left empty */
+void collection_move(Collection* dest, Collection* src) {
+    if (!dest || !src || dest == src) {
+        return;
+    }
+
+    collection_cleanup(dest);
+    *dest = *src;
+    memset(src, 0, sizeof(Collection));
+}
+
 CollectionManager* collection_manager_create(void) {
     CollectionManager* manager = malloc(sizeof(CollectionManager));
     if (!manager) {
@@ -379,6 +514,8 @@ CollectionManager* collection_manager_create(void) {
         return NULL;
     }
 
+    /* seeded here on the ui thread, before collection_loader threads create collections too */
+    seed_collection_ids();
     collection_manager_init(manager);
     return manager;
 }
@@ -459,6 +596,8 @@ int collection_manager_add_collection(CollectionManager* manager, Collection* co
 
     manager->collections[index].created_at = collection->created_at;
     manager->collections[index].modified_at = collection->modified_at;
+    manager->collections[index].generation = 0;
+    manager->collections[index].loaded = true;
 
     cookie_jar_init(&manager->collections[index].cookie_jar);
 
@@ -472,9 +611,6 @@ int collection_manager_add_collection(CollectionManager* manager, Collection* co
                              src_cookie->same_site_strict, src_cookie->same_site_lax);
     }
 
-    printf("DEBUG: Copied %d cookies to collection manager (source had %d cookies)\n",
-           manager->collections[index].cookie_jar.count, collection->cookie_jar.count);
-
     for (int i = 0; i < collection->request_capacity; i++) {
         manager->collections[index].request_names[i] = NULL;
     }
@@ -485,6 +621,9 @@ int collection_manager_add_collection(CollectionManager* manager, Collection* co
                               collection->request_names[i]);
     }
 
+    /* a new collection has never been written, loaders mark it saved */
+    manager->collections[index].saved_generation = manager->collections[index].generation - 1u;
+
     manager->count++;
 
     if (manager->active_collection_index == -1) {
@@ -495,6 +634,31 @@ int collection_manager_add_collection(CollectionManager* manager, Collection* co
     return index;
 }
 
+/* appends a collection by moving it in, unlike add_collection nothing is copied */
+int collection_manager_adopt_collection(CollectionManager* manager, Collection* collection) {
+    if (!manager || !collection) {
+        return -1;
+    }
+
+    if (manager->count >= manager->capacity) {
+        if (resize_array((void**)&manager->collections, &manager->capacity, sizeof(Collection)) != 0) {
+            return -1;
+        }
+    }
+
+    int index = manager->count;
+    manager->collections[index] = *collection;
+    memset(collection, 0, sizeof(Collection));
+    manager->count++;
+
+    if (manager->active_collection_index == -1) {
+        manager->active_collection_index = index;
+        manager->active_request_index = manager->collections[index].request_count > 0 ? 0 : -1;
+    }
+
+    return index;
+}
+
 int collection_manager_remove_collection(CollectionManager* manager, int collection_index) {
     if (!manager || collection_index < 0 || collection_index >= manager->count) {
         return -1;
@@ -1127,7 +1291,7 @@ char* cookie_jar_build_cookie_header(CookieJar* jar, const char* url, bool is_se
         size_t remaining = total_size - current_len - 1;
 
         size_t name_len = strlen(matching_cookies[i]->name);
-        if (name_len < remaining) {
+        if (name_len <= remaining) {
             strncat(cookie_header, matching_cookies[i]->name, remaining);
             current_len += name_len;
             remaining -= name_len;
@@ -1140,7 +1304,7 @@ char* cookie_jar_build_cookie_header(CookieJar* jar, const char* url, bool is_se
         }
 
         size_t value_len = strlen(matching_cookies[i]->value);
-        if (value_len < remaining) {
+        if (value_len <= remaining) {
             strncat(cookie_header, matching_cookies[i]->value, remaining);
             current_len += value_len;
             remaining -= value_len;
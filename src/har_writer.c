@@ -0,0 +1,705 @@
+/**
+ * HAR 1.2 export for tinyrequest
+ *
+ * entries are written in the order HAR lists their fields, one entry per
+ * line. strings are escaped as they are copied into the buffer and bodies
+ * go through in place or as base64, nothing is formatted anywhere else
+ * first. the buffer goes to the file whenever it fills up.
+ */
+
+#include "har_writer.h"
+#include "persistence.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define HAR_BUFFER_SIZE (256 * 1024)
+
+/* bytes base64 encodes per step, a multiple of 3 */
+#define BASE64_CHUNK 3072
+
+/* an export checks for cancelling and reports progress this often */
+#define EXPORT_PROGRESS_RECORDS 64
+
+/* the ui is woken at most this often while an export runs */
+#define EXPORT_WAKE_MS 50.0
+
+struct HarWriter {
+    FILE* file;
+    char* filepath;
+    char* temp_path;
+    unsigned int flags;
+    int count;
+    bool failed;
+    size_t used;
+    char buffer[HAR_BUFFER_SIZE];
+};
+
+struct HarExport {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    HistoryStore* store;
+    uint64_t* ids;
+    uint64_t first_id;
+    char* filepath;
+    unsigned int flags;
+    bool cancel_requested;
+    HarExportProgress progress;
+};
+
+/* global out-of-memory handler */
+static void (*g_har_writer_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_har_writer_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_har_writer_out_of_memory_handler) {
+        g_har_writer_out_of_memory_handler(operation);
+    } else {
+        default_har_writer_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void har_writer_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_har_writer_out_of_memory_handler = handler;
+}
+
+static double har_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* --- output --- */
+
+static void flush_buffer(HarWriter* writer) {
+    if (!writer->failed && writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        writer->failed = true;
+    }
+    writer->used = 0;
+}
+
+static void out_bytes(HarWriter* writer, const char* data, size_t length) {
+    if (writer->failed) {
+        return;
+    }
+    if (length > HAR_BUFFER_SIZE - writer->used) {
+        flush_buffer(writer);
+        if (length >= HAR_BUFFER_SIZE) {
+            if (!writer->failed && fwrite(data, 1, length, writer->file) != length) {
+                writer->failed = true;
+            }
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->used, data, length);
+    writer->used += length;
+}
+
+static void out_text(HarWriter* writer, const char* text) {
+    out_bytes(writer, text, strlen(text));
+}
+
+static void out_format(HarWriter* writer, const char* format, ...) {
+    char text[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length > 0) {
+        out_bytes(writer, text, (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1);
+    }
+}
+
+/* a phase or a time in milliseconds, -1 for one that did not happen */
+static void out_ms(HarWriter* writer, double ms) {
+    if (ms < 0.0) {
+        out_text(writer, "-1");
+    } else {
+        out_format(writer, "%.3f", ms);
+    }
+}
+
+/* length of the utf-8 sequence starting at data[i], 0 when the bytes there are not one */
+static size_t utf8_sequence_length(const unsigned char* data, size_t length, size_t i) {
+    unsigned char c = data[i];
+    if (c < 0x80) {
+        return 1;
+    }
+
+    size_t extra = (c & 0xe0) == 0xc0 ? 1 : (c & 0xf0) == 0xe0 ? 2 : (c & 0xf8) == 0xf0 ? 3 : 0;
+    if (extra == 0 || c == 0xc0 || c == 0xc1 || c > 0xf4 || extra >= length - i) {
+        return 0;
+    }
+    for (size_t k = 1; k <= extra; k++) {
+        if ((data[i + k] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    /* overlong forms, surrogates and code points above U+10FFFF show in the second byte */
+    unsigned char second = data[i + 1];
+    if ((c == 0xe0 && second < 0xa0) || (c == 0xed && second > 0x9f) || (c == 0xf0 && second < 0x90) ||
+        (c == 0xf4 && second > 0x8f)) {
+        return 0;
+    }
+    return extra + 1;
+}
+
+/* utf-8 without NUL bytes goes into the file as a string, anything else as base64 */
+static bool is_text(const unsigned char* data, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        if (data[i] == 0) {
+            return false;
+        }
+        size_t sequence = utf8_sequence_length(data, length, i);
+        if (sequence == 0) {
+            return false;
+        }
+        i += sequence;
+    }
+    return true;
+}
+
+/* a json string. headers and urls come off the wire as they are, a byte
+ * that is not part of valid utf-8 is written as U+FFFD so the file still parses */
+static void out_string(HarWriter* writer, const char* text, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)text;
+    out_bytes(writer, "\"", 1);
+
+    size_t start = 0;
+    size_t i = 0;
+    while (i < length) {
+        unsigned char c = bytes[i];
+        if (c >= 0x80) {
+            size_t sequence = utf8_sequence_length(bytes, length, i);
+            if (sequence > 0) {
+                i += sequence;
+                continue;
+            }
+            out_bytes(writer, text + start, i - start);
+            out_bytes(writer, "\xef\xbf\xbd", 3);
+            start = ++i;
+            continue;
+        }
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            i++;
+            continue;
+        }
+
+        out_bytes(writer, text + start, i - start);
+        start = ++i;
+        switch (c) {
+            case '"':  out_bytes(writer, "\\\"", 2); break;
+            case '\\': out_bytes(writer, "\\\\", 2); break;
+            case '\n': out_bytes(writer, "\\n", 2); break;
+            case '\r': out_bytes(writer, "\\r", 2); break;
+            case '\t': out_bytes(writer, "\\t", 2); break;
+            default:   out_format(writer, "\\u%04x", c); break;
+        }
+    }
+    out_bytes(writer, text + start, length - start);
+
+    out_bytes(writer, "\"", 1);
+}
+
+static void out_cstring(HarWriter* writer, const char* text) {
+    out_string(writer, text, strlen(text));
+}
+
+static void out_base64(HarWriter* writer, const unsigned char* data, size_t length) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char encoded[BASE64_CHUNK / 3 * 4];
+
+    out_bytes(writer, "\"", 1);
+    for (size_t offset = 0; offset < length; offset += BASE64_CHUNK) {
+        size_t chunk = length - offset < BASE64_CHUNK ? length - offset : BASE64_CHUNK;
+        const unsigned char* in = data + offset;
+        size_t used = 0;
+        for (size_t i = 0; i < chunk; i += 3) {
+            uint32_t triple = (uint32_t)in[i] << 16;
+            if (i + 1 < chunk) {
+                triple |= (uint32_t)in[i + 1] << 8;
+            }
+            if (i + 2 < chunk) {
+                triple |= in[i + 2];
+            }
+            encoded[used++] = alphabet[(triple >> 18) & 63];
+            encoded[used++] = alphabet[(triple >> 12) & 63];
+            encoded[used++] = i + 1 < chunk ? alphabet[(triple >> 6) & 63] : '=';
+            encoded[used++] = i + 2 < chunk ? alphabet[triple & 63] : '=';
+        }
+        out_bytes(writer, encoded, used);
+    }
+    out_bytes(writer, "\"", 1);
+}
+
+/* writes "text" and, for a body that is not text, "encoding" after it */
+static void out_body(HarWriter* writer, const char* body, size_t length) {
+    out_text(writer, ",\"text\":");
+    if (is_text((const unsigned char*)body, length)) {
+        out_string(writer, body, length);
+    } else {
+        out_base64(writer, (const unsigned char*)body, length);
+        out_text(writer, ",\"encoding\":\"base64\"");
+    }
+}
+
+static void out_time(HarWriter* writer, int64_t time_ms) {
+    time_t seconds = (time_t)(time_ms / 1000);
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    out_format(writer, "\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\"", utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday,
+               utc.tm_hour, utc.tm_min, utc.tm_sec, (int)(time_ms % 1000));
+}
+
+static void out_headers(HarWriter* writer, const HeaderList* headers) {
+    out_bytes(writer, "[", 1);
+    for (int i = 0; i < headers->count; i++) {
+        out_text(writer, i > 0 ? ",{\"name\":" : "{\"name\":");
+        out_cstring(writer, headers->headers[i].name);
+        out_text(writer, ",\"value\":");
+        out_cstring(writer, headers->headers[i].value);
+        out_bytes(writer, "}", 1);
+    }
+    out_bytes(writer, "]", 1);
+}
+
+/* the query as it is in the url, not decoded */
+static void out_query(HarWriter* writer, const char* url) {
+    out_bytes(writer, "[", 1);
+
+    const char* query = strchr(url, '?');
+    if (query) {
+        query++;
+        size_t query_length = strcspn(query, "#");
+        bool first = true;
+        while (query_length > 0) {
+            size_t pair_length = 0;
+            while (pair_length < query_length && query[pair_length] != '&') {
+                pair_length++;
+            }
+
+            if (pair_length > 0) {
+                size_t name_length = 0;
+                while (name_length < pair_length && query[name_length] != '=') {
+                    name_length++;
+                }
+                const char* value = name_length < pair_length ? query + name_length + 1 : query + pair_length;
+
+                out_text(writer, first ? "{\"name\":" : ",{\"name\":");
+                out_string(writer, query, name_length);
+                out_text(writer, ",\"value\":");
+                out_string(writer, value, (size_t)(query + pair_length - value));
+                out_bytes(writer, "}", 1);
+                first = false;
+            }
+
+            query += pair_length;
+            query_length -= pair_length;
+            if (query_length > 0) {
+                query++;
+                query_length--;
+            }
+        }
+    }
+
+    out_bytes(writer, "]", 1);
+}
+
+static const char* find_header(const HeaderList* headers, const char* name) {
+    for (int i = 0; i < headers->count; i++) {
+        const char* a = headers->headers[i].name;
+        const char* b = name;
+        while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0') {
+            return headers->headers[i].value;
+        }
+    }
+    return NULL;
+}
+
+/* --- writer --- */
+
+HarWriter* har_writer_open(const char* filepath, unsigned int flags, int* error) {
+    int unused;
+    if (!error) {
+        error = &unused;
+    }
+    *error = PERSISTENCE_SUCCESS;
+
+    if (!filepath || filepath[0] == '\0') {
+        *error = PERSISTENCE_ERROR_INVALID_PATH;
+        return NULL;
+    }
+
+    HarWriter* writer = (HarWriter*)malloc(sizeof(HarWriter));
+    size_t path_length = strlen(filepath);
+    char* path = (char*)malloc(path_length + 1);
+    char* temp_path = (char*)malloc(path_length + sizeof(".tmp"));
+    if (!writer || !path || !temp_path) {
+        handle_out_of_memory("HAR writer creation");
+        free(writer);
+        free(path);
+        free(temp_path);
+        *error = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
+    }
+    memcpy(path, filepath, path_length + 1);
+    memcpy(temp_path, filepath, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    writer->file = fopen(temp_path, "wb");
+    if (!writer->file) {
+        free(writer);
+        free(path);
+        free(temp_path);
+        *error = PERSISTENCE_ERROR_PERMISSION_DENIED;
+        return NULL;
+    }
+
+    writer->filepath = path;
+    writer->temp_path = temp_path;
+    writer->flags = flags;
+    writer->count = 0;
+    writer->failed = false;
+    writer->used = 0;
+
+    out_text(writer, "{\"log\":{\"version\":\"1.2\",\"creator\":{\"name\":\"TinyRequest\",\"version\":\"1.0\"},"
+                     "\"pages\":[],\"entries\":[");
+    return writer;
+}
+
+int har_writer_add(HarWriter* writer, const Request* request, const Response* response, int result,
+                   const char* comment) {
+    if (!writer || !request || !response) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+    if (writer->failed) {
+        return PERSISTENCE_ERROR_DISK_FULL;
+    }
+
+    /* without timings the whole time is waiting, which is what most of it usually is */
+    const ResponseTimings* timings = &response->timings;
+    bool timed = timings->valid;
+    double dns = timed ? timings->dns_ms : -1.0;
+    double connect = timed ? timings->connect_ms : -1.0;
+    double ssl = timed ? timings->ssl_ms : -1.0;
+    double send = timed ? timings->send_ms : 0.0;
+    double wait = timed ? timings->wait_ms : (response->response_time > 0.0 ? response->response_time : 0.0);
+    double receive = timed ? timings->receive_ms : 0.0;
+    double total = (dns > 0.0 ? dns : 0.0) + (connect > 0.0 ? connect : 0.0) + send + wait + receive;
+
+    int64_t started_at_ms = timings->started_at_ms;
+    if (started_at_ms <= 0) {
+        started_at_ms = (int64_t)time(NULL) * 1000 - (int64_t)total;
+    }
+
+    const char* version = timed && timings->http_version[0] ? timings->http_version : "HTTP/1.1";
+    bool bodies = (writer->flags & HAR_WRITER_BODIES) != 0;
+    bool failed = result != 0 || response->status_code == 0;
+
+    out_text(writer, writer->count > 0 ? ",\n{\"startedDateTime\":" : "\n{\"startedDateTime\":");
+    out_time(writer, started_at_ms);
+    out_text(writer, ",\"time\":");
+    out_ms(writer, total);
+
+    out_text(writer, ",\"request\":{\"method\":");
+    out_cstring(writer, request->method);
+    out_text(writer, ",\"url\":");
+    out_cstring(writer, request->url);
+    out_text(writer, ",\"httpVersion\":");
+    out_cstring(writer, version);
+    out_text(writer, ",\"cookies\":[],\"headers\":");
+    out_headers(writer, &request->headers);
+    out_text(writer, ",\"queryString\":");
+    out_query(writer, request->url);
+    size_t request_body_size = request->body ? request->body_size : 0;
+    if (request_body_size > 0) {
+        const char* content_type = find_header(&request->headers, "Content-Type");
+        out_text(writer, ",\"postData\":{\"mimeType\":");
+        out_cstring(writer, content_type ? content_type : "");
+        if (bodies) {
+            out_body(writer, request->body, request_body_size);
+        } else {
+            out_text(writer, ",\"text\":\"\"");
+        }
+        out_bytes(writer, "}", 1);
+    }
+    out_format(writer, ",\"headersSize\":%ld,\"bodySize\":%zu}",
+               timed ? timings->request_header_size : -1L, request_body_size);
+
+    const char* content_type = find_header(&response->headers, "Content-Type");
+    const char* location = find_header(&response->headers, "Location");
+    size_t body_size = response->body ? response->body_size : 0;
+    size_t content_size = response->total_size > body_size ? response->total_size : body_size;
+
+    out_format(writer, ",\"response\":{\"status\":%d,\"statusText\":", failed ? 0 : response->status_code);
+    out_cstring(writer, response->status_text);
+    out_text(writer, ",\"httpVersion\":");
+    out_cstring(writer, version);
+    out_text(writer, ",\"cookies\":[],\"headers\":");
+    out_headers(writer, &response->headers);
+    out_format(writer, ",\"content\":{\"size\":%zu,\"mimeType\":", content_size);
+    out_cstring(writer, content_type ? content_type : "x-unknown");
+    if (bodies && body_size > 0) {
+        out_body(writer, response->body, body_size);
+        if (response->is_truncated || content_size > body_size) {
+            out_format(writer, ",\"comment\":\"cut to %zu bytes\"", body_size);
+        }
+    }
+    out_text(writer, "},\"redirectURL\":");
+    out_cstring(writer, location ? location : "");
+    out_format(writer, ",\"headersSize\":%ld,\"bodySize\":%lld", timed ? timings->response_header_size : -1L,
+               timed ? (long long)timings->download_size : (long long)content_size);
+    if (failed) {
+        out_text(writer, ",\"_error\":");
+        out_cstring(writer, response->status_text[0] ? response->status_text : "request failed");
+    }
+    out_bytes(writer, "}", 1);
+
+    out_text(writer, ",\"cache\":{},\"timings\":{\"blocked\":-1,\"dns\":");
+    out_ms(writer, dns);
+    out_text(writer, ",\"connect\":");
+    out_ms(writer, connect);
+    out_text(writer, ",\"send\":");
+    out_ms(writer, send);
+    out_text(writer, ",\"wait\":");
+    out_ms(writer, wait);
+    out_text(writer, ",\"receive\":");
+    out_ms(writer, receive);
+    out_text(writer, ",\"ssl\":");
+    out_ms(writer, ssl);
+    out_bytes(writer, "}", 1);
+
+    if (timed && timings->server_ip[0] != '\0') {
+        out_text(writer, ",\"serverIPAddress\":");
+        out_cstring(writer, timings->server_ip);
+    }
+    if (timed && timings->local_port > 0) {
+        out_format(writer, ",\"connection\":\"%ld\"", timings->local_port);
+    }
+    if (comment && comment[0] != '\0') {
+        out_text(writer, ",\"comment\":");
+        out_cstring(writer, comment);
+    }
+    out_bytes(writer, "}", 1);
+
+    writer->count++;
+    return writer->failed ? PERSISTENCE_ERROR_DISK_FULL : PERSISTENCE_SUCCESS;
+}
+
+int har_writer_get_count(const HarWriter* writer) {
+    return writer ? writer->count : 0;
+}
+
+static void writer_free(HarWriter* writer) {
+    free(writer->filepath);
+    free(writer->temp_path);
+    free(writer);
+}
+
+int har_writer_close(HarWriter* writer) {
+    if (!writer) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    out_text(writer, "\n]}}\n");
+    flush_buffer(writer);
+    bool failed = writer->failed || fflush(writer->file) != 0;
+    if (fclose(writer->file) != 0) {
+        failed = true;
+    }
+
+    int result = PERSISTENCE_SUCCESS;
+    if (failed) {
+        result = PERSISTENCE_ERROR_DISK_FULL;
+    } else {
+#ifdef _WIN32
+        bool renamed = MoveFileExA(writer->temp_path, writer->filepath, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        bool renamed = rename(writer->temp_path, writer->filepath) == 0;
+#endif
+        if (!renamed) {
+            result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+        }
+    }
+
+    if (result != PERSISTENCE_SUCCESS) {
+        remove(writer->temp_path);
+    }
+    writer_free(writer);
+    return result;
+}
+
+void har_writer_abort(HarWriter* writer) {
+    if (!writer) {
+        return;
+    }
+
+    fclose(writer->file);
+    remove(writer->temp_path);
+    writer_free(writer);
+}
+
+/* --- history exports --- */
+
+static bool export_report(HarExport* export_job, int written, double* last_wake_ms) {
+    pthread_mutex_lock(&export_job->mutex);
+    export_job->progress.written = written;
+    bool cancelled = export_job->cancel_requested;
+    pthread_mutex_unlock(&export_job->mutex);
+
+    double now = har_now_ms();
+    if (now - *last_wake_ms >= EXPORT_WAKE_MS) {
+        *last_wake_ms = now;
+        wake_signal_post();
+    }
+    return !cancelled;
+}
+
+static void* export_thread(void* arg) {
+    HarExport* export_job = (HarExport*)arg;
+    int total = export_job->progress.total;
+    int written = 0;
+    double last_wake_ms = 0.0;
+
+    int result = PERSISTENCE_SUCCESS;
+    HarWriter* writer = har_writer_open(export_job->filepath, export_job->flags, &result);
+
+    for (int i = 0; writer && i < total; i++) {
+        if (i % EXPORT_PROGRESS_RECORDS == 0 && !export_report(export_job, written, &last_wake_ms)) {
+            result = PERSISTENCE_ERROR_CANCELLED;
+            break;
+        }
+
+        uint64_t id = export_job->ids ? export_job->ids[i] : export_job->first_id + (uint64_t)i;
+        HistoryEntry entry;
+        if (history_store_read_entry(export_job->store, id, &entry) == PERSISTENCE_SUCCESS) {
+            /* records from before the timings were kept still know when they were sent */
+            if (entry.response.timings.started_at_ms <= 0) {
+                entry.response.timings.started_at_ms = entry.summary.sent_at_ms;
+            }
+            result = har_writer_add(writer, &entry.request, &entry.response, entry.summary.result, NULL);
+            written++;
+        }
+        history_entry_cleanup(&entry);
+
+        if (result != PERSISTENCE_SUCCESS) {
+            break;
+        }
+    }
+
+    if (writer && result == PERSISTENCE_SUCCESS) {
+        result = har_writer_close(writer);
+    } else if (writer) {
+        har_writer_abort(writer);
+    }
+
+    pthread_mutex_lock(&export_job->mutex);
+    export_job->progress.written = written;
+    export_job->progress.result = result;
+    export_job->progress.finished = true;
+    pthread_mutex_unlock(&export_job->mutex);
+
+    wake_signal_post();
+    return NULL;
+}
+
+HarExport* har_export_history_start(HistoryStore* store, const uint64_t* ids, int id_count,
+                                    uint64_t first_id, uint64_t last_id, const char* filepath,
+                                    unsigned int flags) {
+    if (!store || !filepath || filepath[0] == '\0' || (ids && id_count <= 0) || (!ids && last_id < first_id)) {
+        return NULL;
+    }
+
+    HarExport* export_job = (HarExport*)calloc(1, sizeof(HarExport));
+    size_t path_length = strlen(filepath);
+    char* path = (char*)malloc(path_length + 1);
+    uint64_t* id_copy = ids ? (uint64_t*)malloc((size_t)id_count * sizeof(uint64_t)) : NULL;
+    if (!export_job || !path || (ids && !id_copy)) {
+        handle_out_of_memory("HAR export creation");
+        free(export_job);
+        free(path);
+        free(id_copy);
+        return NULL;
+    }
+    memcpy(path, filepath, path_length + 1);
+    if (ids) {
+        memcpy(id_copy, ids, (size_t)id_count * sizeof(uint64_t));
+    }
+
+    uint64_t range = last_id - first_id + 1;
+    export_job->store = store;
+    export_job->ids = id_copy;
+    export_job->first_id = first_id;
+    export_job->filepath = path;
+    export_job->flags = flags;
+    export_job->progress.total = ids ? id_count : (range > INT32_MAX ? INT32_MAX : (int)range);
+    pthread_mutex_init(&export_job->mutex, NULL);
+
+    if (pthread_create(&export_job->thread, NULL, export_thread, export_job) != 0) {
+        pthread_mutex_destroy(&export_job->mutex);
+        free(export_job->ids);
+        free(export_job->filepath);
+        free(export_job);
+        return NULL;
+    }
+    return export_job;
+}
+
+void har_export_get_progress(HarExport* export_job, HarExportProgress* progress) {
+    if (!export_job || !progress) {
+        return;
+    }
+
+    pthread_mutex_lock(&export_job->mutex);
+    *progress = export_job->progress;
+    pthread_mutex_unlock(&export_job->mutex);
+}
+
+void har_export_cancel(HarExport* export_job) {
+    if (!export_job) {
+        return;
+    }
+
+    pthread_mutex_lock(&export_job->mutex);
+    export_job->cancel_requested = true;
+    pthread_mutex_unlock(&export_job->mutex);
+}
+
+void har_export_destroy(HarExport* export_job) {
+    if (!export_job) {
+        return;
+    }
+
+    har_export_cancel(export_job);
+    pthread_join(export_job->thread, NULL);
+
+    pthread_mutex_destroy(&export_job->mutex);
+    free(export_job->ids);
+    free(export_job->filepath);
+    free(export_job);
+}
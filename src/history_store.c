@@ -0,0 +1,1371 @@
+/**
+ * request history for tinyrequest
+ *
+ * numbers are little endian. history.log is
+ *
+ *   header    magic "TRHL" | version (4 bytes each)
+ *   records   payload length | payload checksum (4 bytes each), the payload
+ *
+ * a payload is the id, send time, duration in microseconds (8 bytes each),
+ * status, result (4 bytes each), the response body size (8 bytes), the
+ * request as binary_io.h encodes it, the status text, the response headers,
+ * a flags byte, the body encoding (1 byte), the body length before
+ * compression (4 bytes) and the stored body. method and url lead the
+ * request, so a list row only needs the first few kilobytes of a record.
+ *
+ * records written since the timings were kept end with them: the start
+ * time, the dns, connect, ssl, send, wait and receive phases in
+ * microseconds, -1 for a phase that did not happen (8 bytes each), the
+ * request and response header sizes (4 bytes each), the downloaded size
+ * (8 bytes), the http version, the server address and the local port
+ * (4 bytes). older records just end after the body.
+ *
+ * history.idx is
+ *
+ *   header    magic "TRHI" | version (4 bytes each) | id of entry 0 (8 bytes)
+ *   entries   log offset | send time | id + 1 of the previous record with
+ *             the same url hash, 0 for none (8 bytes each) | payload length |
+ *             url hash (4 bytes each)
+ *
+ * a record goes to the log before its entry goes to the index. when the
+ * app stops in between, or the index is lost or was written for another
+ * log, opening puts the index back together from the log and cuts a torn
+ * record off the end. neither file is synced, losing the last few records
+ * to a power cut is fine for a history.
+ */
+
+#include "history_store.h"
+#include "binary_io.h"
+#include "persistence.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#define LOG_MAGIC "TRHL"
+#define INDEX_MAGIC "TRHI"
+#define HISTORY_VERSION 1
+#define LOG_HEADER_SIZE 8
+#define INDEX_HEADER_SIZE 16
+#define INDEX_ENTRY_SIZE 32
+#define RECORD_FRAME_SIZE 8
+
+/* the fixed fields before the request in a payload */
+#define PAYLOAD_FIXED_SIZE 40
+
+/* enough of a payload for its fixed fields, method and a full url */
+#define SUMMARY_READ_SIZE (PAYLOAD_FIXED_SIZE + 4 + 16 + 4 + 2048)
+
+/* no record comes close, both bodies are cut to the limit */
+#define MAX_RECORD_SIZE (16 * 1024 * 1024)
+
+/* bodies smaller than this are not worth compressing */
+#define BODY_COMPRESS_MIN 1024
+
+#define RECORD_FLAG_BODY_CUT 1u
+#define RECORD_FLAG_REQUEST_BODY_CUT 2u
+
+/* index entries read at a time when scanning */
+#define SCAN_CHUNK_ENTRIES 4096
+
+#define COPY_CHUNK_SIZE (64 * 1024)
+
+typedef struct {
+    uint64_t offset;
+    int64_t sent_at_ms;
+    uint64_t previous;
+    uint32_t length;
+    uint32_t url_hash;
+} IndexEntry;
+
+/* the newest record of a url hash, id_plus_one 0 marks a free slot */
+typedef struct {
+    uint32_t hash;
+    uint64_t id_plus_one;
+} UrlHead;
+
+/* a record encoded on the ui thread, the thread adds the id and the body */
+typedef struct {
+    ByteWriter record;      /* frame and payload up to the body */
+    char* body;
+    size_t body_length;
+    uint32_t url_hash;
+    ResponseTimings timings;
+} PendingRecord;
+
+struct HistoryStore {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;    /* new records, clear requests and shutdown */
+    pthread_t thread;
+    bool thread_started;
+    bool shutting_down;
+    bool ready;
+    bool failed;            /* the files could not be opened, records are dropped */
+    bool clear_requested;
+    bool retention_failed;  /* not retried until the next start */
+
+    PendingRecord* pending[HISTORY_STORE_MAX_PENDING];
+    int pending_count;
+
+    /* the files and what is in them, read and written under the mutex */
+    FILE* log;
+    FILE* index;
+    char* log_path;
+    char* index_path;
+    uint64_t log_size;
+    uint64_t first_id;
+    uint64_t next_id;
+    int64_t last_sent_at_ms;
+    unsigned int generation;
+
+    /* the newest record of every url hash, written by the thread under the mutex */
+    UrlHead* heads;
+    size_t head_capacity;
+    size_t head_count;
+};
+
+/* global out-of-memory handler */
+static void (*g_history_store_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_history_store_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_history_store_out_of_memory_handler) {
+        g_history_store_out_of_memory_handler(operation);
+    } else {
+        default_history_store_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void history_store_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_history_store_out_of_memory_handler = handler;
+}
+
+static int64_t history_now_ms(void) {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (int64_t)(ticks / 10000 - 11644473600000ull);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+static uint32_t url_hash(const char* url) {
+    return binary_checksum(url, strlen(url));
+}
+
+/* --- files --- */
+
+static bool file_seek(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t file_size(FILE* file) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    long long size = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    off_t size = ftello(file);
+#endif
+    return size > 0 ? (uint64_t)size : 0;
+}
+
+static bool file_read_at(FILE* file, uint64_t offset, void* buffer, size_t length) {
+    return file_seek(file, offset) && fread(buffer, 1, length, file) == length;
+}
+
+static bool file_write_at(FILE* file, uint64_t offset, const void* buffer, size_t length) {
+    return file_seek(file, offset) && fwrite(buffer, 1, length, file) == length && fflush(file) == 0;
+}
+
+static void file_truncate(FILE* file, uint64_t length) {
+    fflush(file);
+#ifdef _WIN32
+    _chsize_s(_fileno(file), (long long)length);
+#else
+    if (ftruncate(fileno(file), (off_t)length) != 0) {
+        perror("history: truncate");
+    }
+#endif
+}
+
+static bool replace_file(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+static void write_log_header(FILE* file) {
+    ByteWriter writer = {0};
+    byte_writer_bytes(&writer, LOG_MAGIC, 4);
+    byte_writer_u32(&writer, HISTORY_VERSION);
+    if (!writer.failed) {
+        file_write_at(file, 0, writer.data, writer.length);
+    }
+    free(writer.data);
+}
+
+static void write_index_header(FILE* file, uint64_t first_id) {
+    ByteWriter writer = {0};
+    byte_writer_bytes(&writer, INDEX_MAGIC, 4);
+    byte_writer_u32(&writer, HISTORY_VERSION);
+    byte_writer_u64(&writer, first_id);
+    if (!writer.failed) {
+        file_write_at(file, 0, writer.data, writer.length);
+    }
+    free(writer.data);
+}
+
+static bool header_ok(const unsigned char* header, const char* magic) {
+    ByteReader reader;
+    byte_reader_init(&reader, header + 4, 4);
+    return memcmp(header, magic, 4) == 0 && byte_reader_u32(&reader) == HISTORY_VERSION;
+}
+
+/* opens a file for reading and writing, creating it when it is missing */
+static FILE* open_or_create(const char* path) {
+    FILE* file = fopen(path, "r+b");
+    if (!file) {
+        file = fopen(path, "w+b");
+    }
+    return file;
+}
+
+/* --- index entries --- */
+
+static void encode_entry(unsigned char* out, const IndexEntry* entry) {
+    ByteWriter writer = {0};
+    byte_writer_u64(&writer, entry->offset);
+    byte_writer_u64(&writer, (uint64_t)entry->sent_at_ms);
+    byte_writer_u64(&writer, entry->previous);
+    byte_writer_u32(&writer, entry->length);
+    byte_writer_u32(&writer, entry->url_hash);
+    if (!writer.failed) {
+        memcpy(out, writer.data, INDEX_ENTRY_SIZE);
+    } else {
+        memset(out, 0, INDEX_ENTRY_SIZE);
+    }
+    free(writer.data);
+}
+
+static void decode_entry(const unsigned char* in, IndexEntry* entry) {
+    ByteReader reader;
+    byte_reader_init(&reader, in, INDEX_ENTRY_SIZE);
+    entry->offset = byte_reader_u64(&reader);
+    entry->sent_at_ms = (int64_t)byte_reader_u64(&reader);
+    entry->previous = byte_reader_u64(&reader);
+    entry->length = byte_reader_u32(&reader);
+    entry->url_hash = byte_reader_u32(&reader);
+}
+
+static bool read_entry(FILE* index, uint64_t position, IndexEntry* entry) {
+    unsigned char bytes[INDEX_ENTRY_SIZE];
+    if (!file_read_at(index, INDEX_HEADER_SIZE + position * INDEX_ENTRY_SIZE, bytes, sizeof(bytes))) {
+        return false;
+    }
+    decode_entry(bytes, entry);
+    return true;
+}
+
+static uint64_t entry_count(const HistoryStore* store) {
+    return store->next_id - store->first_id;
+}
+
+/* --- url heads --- */
+
+static UrlHead* find_head(UrlHead* heads, size_t capacity, uint32_t hash) {
+    size_t slot = hash & (capacity - 1);
+    while (heads[slot].id_plus_one != 0 && heads[slot].hash != hash) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return &heads[slot];
+}
+
+static bool set_head(HistoryStore* store, uint32_t hash, uint64_t id) {
+    if ((store->head_count + 1) * 10 > store->head_capacity * 7) {
+        size_t capacity = store->head_capacity > 0 ? store->head_capacity * 2 : 1024;
+        UrlHead* heads = (UrlHead*)calloc(capacity, sizeof(UrlHead));
+        if (!heads) {
+            handle_out_of_memory("history url index");
+            return false;
+        }
+        for (size_t i = 0; i < store->head_capacity; i++) {
+            if (store->heads[i].id_plus_one != 0) {
+                *find_head(heads, capacity, store->heads[i].hash) = store->heads[i];
+            }
+        }
+        free(store->heads);
+        store->heads = heads;
+        store->head_capacity = capacity;
+    }
+
+    UrlHead* head = find_head(store->heads, store->head_capacity, hash);
+    if (head->id_plus_one == 0) {
+        store->head_count++;
+    }
+    head->hash = hash;
+    head->id_plus_one = id + 1;
+    return true;
+}
+
+static uint64_t get_head(const HistoryStore* store, uint32_t hash) {
+    if (store->head_capacity == 0) {
+        return 0;
+    }
+    return find_head(store->heads, store->head_capacity, hash)->id_plus_one;
+}
+
+static void reset_heads(HistoryStore* store) {
+    free(store->heads);
+    store->heads = NULL;
+    store->head_capacity = 0;
+    store->head_count = 0;
+}
+
+/* --- records --- */
+
+/* reads the fixed fields at the front of a payload */
+static void read_payload_fixed(ByteReader* reader, HistorySummary* summary) {
+    summary->id = byte_reader_u64(reader);
+    summary->sent_at_ms = (int64_t)byte_reader_u64(reader);
+    summary->duration_ms = (double)byte_reader_u64(reader) / 1000.0;
+    summary->status_code = (int)byte_reader_u32(reader);
+    summary->result = (int)byte_reader_u32(reader);
+    summary->body_size = (size_t)byte_reader_u64(reader);
+}
+
+/* reads the summary of the record an entry points at, the url in full when
+ * full_url is given. call with the mutex held or from the thread while
+ * nothing else has the files */
+static bool read_summary_at(FILE* log, const IndexEntry* entry, HistorySummary* summary,
+                            char* full_url, size_t full_url_size) {
+    unsigned char buffer[SUMMARY_READ_SIZE];
+    size_t length = entry->length < sizeof(buffer) ? entry->length : sizeof(buffer);
+    if (!file_read_at(log, entry->offset + RECORD_FRAME_SIZE, buffer, length)) {
+        return false;
+    }
+
+    ByteReader reader;
+    byte_reader_init(&reader, buffer, length);
+    read_payload_fixed(&reader, summary);
+    byte_reader_field(&reader, summary->method, sizeof(summary->method));
+
+    size_t url_length = 0;
+    const char* url = byte_reader_data(&reader, &url_length);
+    if (!url) {
+        return false;
+    }
+
+    size_t cut = url_length < sizeof(summary->url) ? url_length : sizeof(summary->url) - 1;
+    memcpy(summary->url, url, cut);
+    summary->url[cut] = '\0';
+
+    if (full_url) {
+        cut = url_length < full_url_size ? url_length : full_url_size - 1;
+        memcpy(full_url, url, cut);
+        full_url[cut] = '\0';
+    }
+    return true;
+}
+
+/* reads and checks the payload of the record at offset, NULL if it is torn or broken */
+static unsigned char* read_payload(FILE* log, uint64_t offset, uint64_t log_size, uint32_t* length) {
+    unsigned char frame[RECORD_FRAME_SIZE];
+    if (offset + RECORD_FRAME_SIZE > log_size || !file_read_at(log, offset, frame, sizeof(frame))) {
+        return NULL;
+    }
+
+    ByteReader reader;
+    byte_reader_init(&reader, frame, sizeof(frame));
+    uint32_t payload_length = byte_reader_u32(&reader);
+    uint32_t checksum = byte_reader_u32(&reader);
+    if (payload_length < PAYLOAD_FIXED_SIZE || payload_length > MAX_RECORD_SIZE ||
+        offset + RECORD_FRAME_SIZE + payload_length > log_size) {
+        return NULL;
+    }
+
+    unsigned char* payload = (unsigned char*)malloc(payload_length);
+    if (!payload) {
+        handle_out_of_memory("history record");
+        return NULL;
+    }
+
+    if (!file_read_at(log, offset + RECORD_FRAME_SIZE, payload, payload_length) ||
+        binary_checksum(payload, payload_length) != checksum) {
+        free(payload);
+        return NULL;
+    }
+
+    *length = payload_length;
+    return payload;
+}
+
+/* the id, send time and url hash of a payload read with read_payload */
+static bool describe_payload(const unsigned char* payload, uint32_t length,
+                             uint64_t* id, int64_t* sent_at_ms, uint32_t* hash) {
+    ByteReader reader;
+    byte_reader_init(&reader, payload, length);
+
+    HistorySummary summary;
+    read_payload_fixed(&reader, &summary);
+    size_t method_length = 0;
+    size_t url_length = 0;
+    byte_reader_data(&reader, &method_length);
+    const char* url = byte_reader_data(&reader, &url_length);
+    if (!url) {
+        return false;
+    }
+
+    *id = summary.id;
+    *sent_at_ms = summary.sent_at_ms;
+    *hash = binary_checksum(url, url_length);
+    return true;
+}
+
+/* --- opening --- */
+
+/* points every url hash at its newest record */
+static bool build_heads(HistoryStore* store, FILE* index, uint64_t count) {
+    unsigned char* chunk = (unsigned char*)malloc((size_t)SCAN_CHUNK_ENTRIES * INDEX_ENTRY_SIZE);
+    if (!chunk) {
+        handle_out_of_memory("history url index");
+        return false;
+    }
+
+    bool ok = true;
+    for (uint64_t start = 0; start < count && ok; start += SCAN_CHUNK_ENTRIES) {
+        uint64_t chunk_count = count - start < SCAN_CHUNK_ENTRIES ? count - start : SCAN_CHUNK_ENTRIES;
+        ok = file_read_at(index, INDEX_HEADER_SIZE + start * INDEX_ENTRY_SIZE, chunk,
+                          (size_t)chunk_count * INDEX_ENTRY_SIZE);
+        for (uint64_t i = 0; i < chunk_count && ok; i++) {
+            IndexEntry entry;
+            decode_entry(chunk + i * INDEX_ENTRY_SIZE, &entry);
+            ok = set_head(store, entry.url_hash, store->first_id + start + i);
+        }
+    }
+
+    free(chunk);
+    return ok;
+}
+
+/* true when the last index entry matches the record it points at */
+static bool index_matches_log(HistoryStore* store, FILE* log, FILE* index, uint64_t count) {
+    IndexEntry last;
+    if (!read_entry(index, count - 1, &last) || last.offset < LOG_HEADER_SIZE) {
+        return false;
+    }
+
+    uint32_t length = 0;
+    unsigned char* payload = read_payload(log, last.offset, store->log_size, &length);
+    if (!payload) {
+        return false;
+    }
+
+    uint64_t id = 0;
+    int64_t sent_at_ms = 0;
+    uint32_t hash = 0;
+    bool ok = length == last.length && describe_payload(payload, length, &id, &sent_at_ms, &hash) &&
+              id == store->first_id + count - 1 && hash == last.url_hash;
+    free(payload);
+    return ok;
+}
+
+/* opens both files, repairs what a crash left behind and loads the url heads.
+ * runs on the thread before the store is ready, so nothing else looks at them */
+static bool open_files(HistoryStore* store) {
+    if (persistence_create_config_dir() != 0) {
+        return false;
+    }
+
+    store->log_path = persistence_get_config_path(HISTORY_STORE_LOG_FILENAME);
+    store->index_path = persistence_get_config_path(HISTORY_STORE_INDEX_FILENAME);
+    if (!store->log_path || !store->index_path) {
+        return false;
+    }
+
+    FILE* log = open_or_create(store->log_path);
+    FILE* index = log ? open_or_create(store->index_path) : NULL;
+    if (!log || !index) {
+        if (log) {
+            fclose(log);
+        }
+        return false;
+    }
+
+    unsigned char header[INDEX_HEADER_SIZE];
+    store->log_size = file_size(log);
+    if (store->log_size < LOG_HEADER_SIZE || !file_read_at(log, 0, header, LOG_HEADER_SIZE) ||
+        !header_ok(header, LOG_MAGIC)) {
+        if (store->log_size > 0) {
+            printf("History log %s is not readable, starting a new one\n", store->log_path);
+        }
+        file_truncate(log, 0);
+        write_log_header(log);
+        store->log_size = LOG_HEADER_SIZE;
+    }
+
+    uint64_t index_size = file_size(index);
+    uint64_t count = 0;
+    store->first_id = 1;
+    if (index_size >= INDEX_HEADER_SIZE && file_read_at(index, 0, header, INDEX_HEADER_SIZE) &&
+        header_ok(header, INDEX_MAGIC)) {
+        ByteReader reader;
+        byte_reader_init(&reader, header + 8, 8);
+        store->first_id = byte_reader_u64(&reader);
+        count = (index_size - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+        if (store->first_id == 0) {
+            store->first_id = 1;
+            count = 0;
+        }
+    }
+
+    if (count > 0 && !index_matches_log(store, log, index, count)) {
+        printf("History index does not match the log, rebuilding it\n");
+        count = 0;
+    }
+
+    uint64_t position = LOG_HEADER_SIZE;
+    if (count > 0) {
+        IndexEntry last;
+        read_entry(index, count - 1, &last);
+        position = last.offset + RECORD_FRAME_SIZE + last.length;
+        store->last_sent_at_ms = last.sent_at_ms;
+    }
+
+    file_truncate(index, INDEX_HEADER_SIZE + count * INDEX_ENTRY_SIZE);
+    write_index_header(index, store->first_id);
+    store->next_id = store->first_id + count;
+
+    if (!build_heads(store, index, count)) {
+        fclose(log);
+        fclose(index);
+        return false;
+    }
+
+    /* records the index does not know about yet, normally none */
+    while (position < store->log_size) {
+        uint32_t length = 0;
+        unsigned char* payload = read_payload(log, position, store->log_size, &length);
+        if (!payload) {
+            break;
+        }
+
+        uint64_t id = 0;
+        int64_t sent_at_ms = 0;
+        uint32_t hash = 0;
+        bool described = describe_payload(payload, length, &id, &sent_at_ms, &hash);
+        free(payload);
+        if (!described || id == 0) {
+            break;
+        }
+
+        if (store->next_id == store->first_id) {
+            /* the index is being rebuilt, the log decides where the ids start */
+            store->first_id = id;
+            store->next_id = id;
+            write_index_header(index, id);
+        } else if (id != store->next_id) {
+            break;
+        }
+
+        IndexEntry entry = { position, sent_at_ms, get_head(store, hash), length, hash };
+        unsigned char bytes[INDEX_ENTRY_SIZE];
+        encode_entry(bytes, &entry);
+        if (!file_write_at(index, INDEX_HEADER_SIZE + entry_count(store) * INDEX_ENTRY_SIZE, bytes, sizeof(bytes)) ||
+            !set_head(store, hash, id)) {
+            break;
+        }
+
+        store->next_id++;
+        store->last_sent_at_ms = sent_at_ms;
+        position += RECORD_FRAME_SIZE + length;
+    }
+
+    if (position < store->log_size) {
+        printf("Cutting %llu bytes of unreadable history off %s\n",
+               (unsigned long long)(store->log_size - position), store->log_path);
+        file_truncate(log, position);
+        store->log_size = position;
+    }
+
+    store->log = log;
+    store->index = index;
+    return true;
+}
+
+/* --- writing --- */
+
+static void write_phase(ByteWriter* writer, double ms) {
+    byte_writer_u64(writer, (uint64_t)(int64_t)(ms < 0.0 ? -1.0 : ms * 1000.0));
+}
+
+static void write_timings(ByteWriter* writer, const ResponseTimings* timings) {
+    byte_writer_u64(writer, (uint64_t)timings->started_at_ms);
+    write_phase(writer, timings->dns_ms);
+    write_phase(writer, timings->connect_ms);
+    write_phase(writer, timings->ssl_ms);
+    write_phase(writer, timings->send_ms);
+    write_phase(writer, timings->wait_ms);
+    write_phase(writer, timings->receive_ms);
+    byte_writer_u32(writer, (uint32_t)timings->request_header_size);
+    byte_writer_u32(writer, (uint32_t)timings->response_header_size);
+    byte_writer_u64(writer, (uint64_t)timings->download_size);
+    byte_writer_string(writer, timings->http_version);
+    byte_writer_string(writer, timings->server_ip);
+    byte_writer_u32(writer, (uint32_t)timings->local_port);
+}
+
+/* finishes a pending record and appends it to both files */
+static void write_record(HistoryStore* store, PendingRecord* pending) {
+    size_t stored_length = 0;
+    unsigned char* compressed = binary_compress(pending->body, pending->body_length, BODY_COMPRESS_MIN, &stored_length);
+
+    ByteWriter* record = &pending->record;
+    byte_writer_u8(record, compressed ? BINARY_ENCODING_ZSTD : BINARY_ENCODING_RAW);
+    byte_writer_u32(record, (uint32_t)pending->body_length);
+    if (compressed) {
+        byte_writer_data(record, (const char*)compressed, stored_length);
+    } else {
+        byte_writer_data(record, pending->body, pending->body_length);
+    }
+    free(compressed);
+    if (pending->timings.valid) {
+        write_timings(record, &pending->timings);
+    }
+
+    size_t payload_length = record->length - RECORD_FRAME_SIZE;
+    if (record->failed || payload_length > MAX_RECORD_SIZE) {
+        handle_out_of_memory("history record");
+        return;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+
+    /* the clock can step back, the index needs send times that never do */
+    ByteReader reader;
+    byte_reader_init(&reader, record->data + RECORD_FRAME_SIZE + 8, 8);
+    int64_t sent_at_ms = (int64_t)byte_reader_u64(&reader);
+    if (sent_at_ms < store->last_sent_at_ms) {
+        sent_at_ms = store->last_sent_at_ms;
+    }
+
+    uint64_t id = store->next_id;
+    byte_writer_patch_u64(record, RECORD_FRAME_SIZE, id);
+    byte_writer_patch_u64(record, RECORD_FRAME_SIZE + 8, (uint64_t)sent_at_ms);
+    byte_writer_patch_u32(record, 0, (uint32_t)payload_length);
+    byte_writer_patch_u32(record, 4, binary_checksum(record->data + RECORD_FRAME_SIZE, payload_length));
+
+    IndexEntry entry = { store->log_size, sent_at_ms, get_head(store, pending->url_hash),
+                         (uint32_t)payload_length, pending->url_hash };
+    unsigned char bytes[INDEX_ENTRY_SIZE];
+    encode_entry(bytes, &entry);
+
+    if (!file_write_at(store->log, store->log_size, record->data, record->length)) {
+        file_truncate(store->log, store->log_size);
+    } else if (!file_write_at(store->index, INDEX_HEADER_SIZE + entry_count(store) * INDEX_ENTRY_SIZE,
+                              bytes, sizeof(bytes))) {
+        file_truncate(store->index, INDEX_HEADER_SIZE + entry_count(store) * INDEX_ENTRY_SIZE);
+        file_truncate(store->log, store->log_size);
+    } else {
+        set_head(store, pending->url_hash, id);
+        store->log_size += record->length;
+        store->next_id++;
+        store->last_sent_at_ms = sent_at_ms;
+        store->generation++;
+    }
+
+    pthread_mutex_unlock(&store->mutex);
+}
+
+static void pending_free(PendingRecord* pending) {
+    if (pending) {
+        free(pending->record.data);
+        free(pending->body);
+        free(pending);
+    }
+}
+
+/* drops every record but keeps counting ids from where they were */
+static void clear_files(HistoryStore* store) {
+    pthread_mutex_lock(&store->mutex);
+    file_truncate(store->log, LOG_HEADER_SIZE);
+    file_truncate(store->index, INDEX_HEADER_SIZE);
+    write_index_header(store->index, store->next_id);
+    store->log_size = LOG_HEADER_SIZE;
+    store->first_id = store->next_id;
+    store->generation++;
+    reset_heads(store);
+    pthread_mutex_unlock(&store->mutex);
+}
+
+/* the first entry whose record starts at or after offset */
+static uint64_t find_entry_by_offset(FILE* index, uint64_t count, uint64_t offset) {
+    uint64_t low = 0;
+    uint64_t high = count;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        IndexEntry entry;
+        if (!read_entry(index, middle, &entry)) {
+            return count;
+        }
+        if (entry.offset < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* copies the newest records into new files and swaps them in. only the
+ * thread writes, so the old files are read without the lock while the ui
+ * keeps reading them under it */
+static bool drop_oldest(HistoryStore* store, uint64_t drop) {
+    uint64_t count = entry_count(store);
+    FILE* old_log = fopen(store->log_path, "rb");
+    FILE* old_index = fopen(store->index_path, "rb");
+    size_t path_length = strlen(store->log_path) + 5;
+    char* log_temp = (char*)malloc(path_length);
+    char* index_temp = (char*)malloc(strlen(store->index_path) + 5);
+    unsigned char* chunk = (unsigned char*)malloc(COPY_CHUNK_SIZE);
+    FILE* new_log = NULL;
+    FILE* new_index = NULL;
+    bool ok = old_log && old_index && log_temp && index_temp && chunk;
+
+    if (ok) {
+        snprintf(log_temp, path_length, "%s.tmp", store->log_path);
+        snprintf(index_temp, strlen(store->index_path) + 5, "%s.tmp", store->index_path);
+        new_log = fopen(log_temp, "w+b");
+        new_index = fopen(index_temp, "w+b");
+        ok = new_log && new_index;
+    }
+
+    IndexEntry first;
+    ok = ok && read_entry(old_index, drop, &first);
+    uint64_t shift = ok ? first.offset - LOG_HEADER_SIZE : 0;
+
+    if (ok) {
+        write_log_header(new_log);
+        write_index_header(new_index, store->first_id + drop);
+        ok = file_seek(old_log, first.offset) && file_seek(new_log, LOG_HEADER_SIZE);
+    }
+
+    for (uint64_t copied = first.offset; ok && copied < store->log_size;) {
+        size_t length = store->log_size - copied < COPY_CHUNK_SIZE ? (size_t)(store->log_size - copied) : COPY_CHUNK_SIZE;
+        ok = fread(chunk, 1, length, old_log) == length && fwrite(chunk, 1, length, new_log) == length;
+        copied += length;
+    }
+
+    ok = ok && file_seek(old_index, INDEX_HEADER_SIZE + drop * INDEX_ENTRY_SIZE) && file_seek(new_index, INDEX_HEADER_SIZE);
+    for (uint64_t i = drop; ok && i < count; i++) {
+        unsigned char bytes[INDEX_ENTRY_SIZE];
+        IndexEntry entry;
+        ok = fread(bytes, 1, sizeof(bytes), old_index) == sizeof(bytes);
+        if (ok) {
+            decode_entry(bytes, &entry);
+            entry.offset -= shift;
+            encode_entry(bytes, &entry);
+            ok = fwrite(bytes, 1, sizeof(bytes), new_index) == sizeof(bytes);
+        }
+    }
+
+    ok = ok && fflush(new_log) == 0 && fflush(new_index) == 0;
+
+    if (old_log) {
+        fclose(old_log);
+    }
+    if (old_index) {
+        fclose(old_index);
+    }
+    if (new_log) {
+        fclose(new_log);
+    }
+    if (new_index) {
+        fclose(new_index);
+    }
+
+    if (ok) {
+        /* a crash between the two renames leaves an index that does not match
+         * the log, opening rebuilds it from whichever log made it */
+        pthread_mutex_lock(&store->mutex);
+        fclose(store->log);
+        fclose(store->index);
+        ok = replace_file(log_temp, store->log_path) && replace_file(index_temp, store->index_path);
+        store->log = open_or_create(store->log_path);
+        store->index = open_or_create(store->index_path);
+        if (ok && store->log && store->index) {
+            store->log_size -= shift;
+            store->first_id += drop;
+        } else {
+            /* the files are no longer what the counts say, start over from them */
+            ok = false;
+            store->failed = true;
+            store->ready = false;
+        }
+        store->generation++;
+        pthread_mutex_unlock(&store->mutex);
+    } else if (log_temp && index_temp) {
+        remove(log_temp);
+        remove(index_temp);
+    }
+
+    free(log_temp);
+    free(index_temp);
+    free(chunk);
+    return ok;
+}
+
+/* keeps the log under both limits, dropping the oldest tenth when it is over */
+static void apply_retention(HistoryStore* store) {
+    uint64_t count = entry_count(store);
+    if (store->retention_failed || (count <= HISTORY_STORE_MAX_ENTRIES && store->log_size <= HISTORY_STORE_MAX_BYTES)) {
+        return;
+    }
+
+    uint64_t keep_entries = (uint64_t)HISTORY_STORE_MAX_ENTRIES / 10 * 9;
+    uint64_t keep_bytes = HISTORY_STORE_MAX_BYTES / 10 * 9;
+    uint64_t drop = count > keep_entries ? count - keep_entries : 0;
+    if (store->log_size > keep_bytes) {
+        uint64_t by_size = find_entry_by_offset(store->index, count, store->log_size - keep_bytes);
+        if (by_size > drop) {
+            drop = by_size;
+        }
+    }
+    if (drop >= count) {
+        drop = count - 1;
+    }
+
+    if (drop == 0 || !drop_oldest(store, drop)) {
+        printf("Could not trim the history, it will grow past its limit until the next start\n");
+        store->retention_failed = true;
+    }
+}
+
+/* --- the thread --- */
+
+static void* history_thread_main(void* arg) {
+    HistoryStore* store = (HistoryStore*)arg;
+
+    bool opened = open_files(store);
+    if (!opened) {
+        printf("History is off, %s could not be opened\n",
+               store->log_path ? store->log_path : HISTORY_STORE_LOG_FILENAME);
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    store->ready = opened;
+    store->failed = !opened;
+    store->generation++;
+    pthread_mutex_unlock(&store->mutex);
+    wake_signal_post();
+
+    PendingRecord* batch[HISTORY_STORE_MAX_PENDING];
+    for (;;) {
+        pthread_mutex_lock(&store->mutex);
+        while (!store->shutting_down && store->pending_count == 0 && !store->clear_requested) {
+            pthread_cond_wait(&store->cond, &store->mutex);
+        }
+
+        bool clear = store->clear_requested;
+        store->clear_requested = false;
+        int count = store->pending_count;
+        memcpy(batch, store->pending, (size_t)count * sizeof(PendingRecord*));
+        store->pending_count = 0;
+        bool usable = store->ready;
+        bool stop = store->shutting_down && count == 0 && !clear;
+        pthread_mutex_unlock(&store->mutex);
+
+        if (stop) {
+            break;
+        }
+
+        if (usable && clear) {
+            clear_files(store);
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (usable) {
+                write_record(store, batch[i]);
+            }
+            pending_free(batch[i]);
+        }
+
+        if (usable && count > 0) {
+            apply_retention(store);
+        }
+        wake_signal_post();
+    }
+
+    return NULL;
+}
+
+HistoryStore* history_store_create(void) {
+    HistoryStore* store = (HistoryStore*)calloc(1, sizeof(HistoryStore));
+    if (!store) {
+        handle_out_of_memory("history store");
+        return NULL;
+    }
+
+    pthread_mutex_init(&store->mutex, NULL);
+    pthread_cond_init(&store->cond, NULL);
+
+    if (pthread_create(&store->thread, NULL, history_thread_main, store) != 0) {
+        pthread_cond_destroy(&store->cond);
+        pthread_mutex_destroy(&store->mutex);
+        free(store);
+        return NULL;
+    }
+    store->thread_started = true;
+    return store;
+}
+
+/* writes what is still queued and closes the files */
+void history_store_destroy(HistoryStore* store) {
+    if (!store) {
+        return;
+    }
+
+    if (store->thread_started) {
+        pthread_mutex_lock(&store->mutex);
+        store->shutting_down = true;
+        pthread_cond_signal(&store->cond);
+        pthread_mutex_unlock(&store->mutex);
+        pthread_join(store->thread, NULL);
+    }
+
+    for (int i = 0; i < store->pending_count; i++) {
+        pending_free(store->pending[i]);
+    }
+    if (store->log) {
+        fclose(store->log);
+    }
+    if (store->index) {
+        fclose(store->index);
+    }
+
+    reset_heads(store);
+    free(store->log_path);
+    free(store->index_path);
+    pthread_cond_destroy(&store->cond);
+    pthread_mutex_destroy(&store->mutex);
+    free(store);
+}
+
+/* encodes everything but the body on the calling thread, the body is only copied */
+int history_store_record(HistoryStore* store, const Request* request, const Response* response, int result) {
+    if (!store || !request || !response) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    bool full = store->failed || store->pending_count >= HISTORY_STORE_MAX_PENDING;
+    pthread_mutex_unlock(&store->mutex);
+    if (full) {
+        return -1;
+    }
+
+    PendingRecord* pending = (PendingRecord*)calloc(1, sizeof(PendingRecord));
+    if (!pending) {
+        handle_out_of_memory("history record");
+        return -1;
+    }
+
+    /* a big upload is cut like a big response, the copy shares the body */
+    Request sent = *request;
+    unsigned int flags = 0;
+    if (sent.body && sent.body_size > HISTORY_STORE_BODY_LIMIT) {
+        sent.body_size = HISTORY_STORE_BODY_LIMIT;
+        flags |= RECORD_FLAG_REQUEST_BODY_CUT;
+    }
+
+    size_t body_length = response->body ? response->body_size : 0;
+    if (body_length > HISTORY_STORE_BODY_LIMIT) {
+        body_length = HISTORY_STORE_BODY_LIMIT;
+        flags |= RECORD_FLAG_BODY_CUT;
+    }
+    if (response->is_truncated) {
+        flags |= RECORD_FLAG_BODY_CUT;
+    }
+
+    double duration_ms = response->response_time > 0.0 ? response->response_time : 0.0;
+    int64_t sent_at_ms = history_now_ms() - (int64_t)duration_ms;
+
+    ByteWriter* record = &pending->record;
+    byte_writer_u32(record, 0);    /* length and checksum, filled in by the thread */
+    byte_writer_u32(record, 0);
+    byte_writer_u64(record, 0);    /* id, given out by the thread */
+    byte_writer_u64(record, (uint64_t)sent_at_ms);
+    byte_writer_u64(record, (uint64_t)(duration_ms * 1000.0));
+    byte_writer_u32(record, (uint32_t)response->status_code);
+    byte_writer_u32(record, (uint32_t)result);
+    byte_writer_u64(record, response->total_size > response->body_size ? response->total_size : response->body_size);
+    byte_writer_request(record, &sent);
+    byte_writer_string(record, response->status_text);
+    byte_writer_u32(record, (uint32_t)response->headers.count);
+    for (int i = 0; i < response->headers.count; i++) {
+        byte_writer_string(record, response->headers.headers[i].name);
+        byte_writer_string(record, response->headers.headers[i].value);
+    }
+    byte_writer_u8(record, flags);
+
+    if (body_length > 0) {
+        pending->body = (char*)malloc(body_length);
+        if (pending->body) {
+            memcpy(pending->body, response->body, body_length);
+            pending->body_length = body_length;
+        }
+    }
+
+    if (record->failed || (body_length > 0 && !pending->body)) {
+        handle_out_of_memory("history record");
+        pending_free(pending);
+        return -1;
+    }
+    pending->url_hash = url_hash(request->url);
+    pending->timings = response->timings;
+
+    pthread_mutex_lock(&store->mutex);
+    bool queued = !store->failed && store->pending_count < HISTORY_STORE_MAX_PENDING;
+    if (queued) {
+        store->pending[store->pending_count++] = pending;
+        pthread_cond_signal(&store->cond);
+    }
+    pthread_mutex_unlock(&store->mutex);
+
+    if (!queued) {
+        pending_free(pending);
+        return -1;
+    }
+    return 0;
+}
+
+bool history_store_is_ready(HistoryStore* store) {
+    if (!store) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    bool ready = store->ready;
+    pthread_mutex_unlock(&store->mutex);
+    return ready;
+}
+
+unsigned int history_store_get_generation(HistoryStore* store) {
+    if (!store) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    unsigned int generation = store->generation;
+    pthread_mutex_unlock(&store->mutex);
+    return generation;
+}
+
+int history_store_get_count(HistoryStore* store) {
+    if (!store) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    uint64_t count = store->ready ? entry_count(store) : 0;
+    pthread_mutex_unlock(&store->mutex);
+    return count > INT32_MAX ? INT32_MAX : (int)count;
+}
+
+int history_store_read_summaries(HistoryStore* store, int first_row, int count, HistorySummary* summaries) {
+    if (!store || !summaries || first_row < 0 || count <= 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    uint64_t total = store->ready ? entry_count(store) : 0;
+    if ((uint64_t)first_row >= total) {
+        pthread_mutex_unlock(&store->mutex);
+        return 0;
+    }
+    if ((uint64_t)first_row + (uint64_t)count > total) {
+        count = (int)(total - (uint64_t)first_row);
+    }
+
+    /* rows run newest first, so the entries are read in one go from the oldest row */
+    uint64_t oldest = total - (uint64_t)first_row - (uint64_t)count;
+    unsigned char* entries = (unsigned char*)malloc((size_t)count * INDEX_ENTRY_SIZE);
+    int filled = 0;
+    if (entries && file_read_at(store->index, INDEX_HEADER_SIZE + oldest * INDEX_ENTRY_SIZE, entries,
+                                (size_t)count * INDEX_ENTRY_SIZE)) {
+        for (int row = 0; row < count; row++) {
+            IndexEntry entry;
+            decode_entry(entries + (size_t)(count - 1 - row) * INDEX_ENTRY_SIZE, &entry);
+            if (!read_summary_at(store->log, &entry, &summaries[filled], NULL, 0)) {
+                break;
+            }
+            filled++;
+        }
+    }
+    pthread_mutex_unlock(&store->mutex);
+
+    free(entries);
+    return filled;
+}
+
+bool history_store_read_summary(HistoryStore* store, uint64_t id, HistorySummary* summary) {
+    if (!store || !summary) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    bool ok = store->ready && id >= store->first_id && id < store->next_id;
+    IndexEntry entry;
+    ok = ok && read_entry(store->index, id - store->first_id, &entry) &&
+         read_summary_at(store->log, &entry, summary, NULL, 0);
+    pthread_mutex_unlock(&store->mutex);
+    return ok;
+}
+
+static double read_phase(ByteReader* reader) {
+    int64_t microseconds = (int64_t)byte_reader_u64(reader);
+    return microseconds < 0 ? -1.0 : microseconds / 1000.0;
+}
+
+static void read_timings(ByteReader* reader, ResponseTimings* timings) {
+    timings->started_at_ms = (int64_t)byte_reader_u64(reader);
+    timings->dns_ms = read_phase(reader);
+    timings->connect_ms = read_phase(reader);
+    timings->ssl_ms = read_phase(reader);
+    timings->send_ms = read_phase(reader);
+    timings->wait_ms = read_phase(reader);
+    timings->receive_ms = read_phase(reader);
+    timings->request_header_size = (long)byte_reader_u32(reader);
+    timings->response_header_size = (long)byte_reader_u32(reader);
+    timings->download_size = (int64_t)byte_reader_u64(reader);
+    byte_reader_field(reader, timings->http_version, sizeof(timings->http_version));
+    byte_reader_field(reader, timings->server_ip, sizeof(timings->server_ip));
+    timings->local_port = (long)byte_reader_u32(reader);
+    timings->valid = !reader->failed;
+}
+
+static bool read_response(ByteReader* reader, Response* response) {
+    byte_reader_field(reader, response->status_text, sizeof(response->status_text));
+
+    uint32_t header_count = byte_reader_u32(reader);
+    for (uint32_t i = 0; i < header_count && !reader->failed; i++) {
+        Header header;
+        byte_reader_field(reader, header.name, sizeof(header.name));
+        byte_reader_field(reader, header.value, sizeof(header.value));
+        if (!reader->failed) {
+            header_list_add(&response->headers, header.name, header.value);
+        }
+    }
+
+    unsigned int flags = byte_reader_u8(reader);
+    unsigned int encoding = byte_reader_u8(reader);
+    uint32_t raw_length = byte_reader_u32(reader);
+    size_t stored_length = 0;
+    const char* stored = byte_reader_data(reader, &stored_length);
+    if (!stored || raw_length > HISTORY_STORE_BODY_LIMIT) {
+        return false;
+    }
+
+    response->is_truncated = (flags & RECORD_FLAG_BODY_CUT) != 0;
+    if (reader->cur < reader->end) {
+        read_timings(reader, &response->timings);
+    }
+
+    if (encoding == BINARY_ENCODING_RAW) {
+        return stored_length == raw_length && response_set_body(response, stored, stored_length) == 0;
+    }
+
+    if (encoding != BINARY_ENCODING_ZSTD || !binary_compression_available()) {
+        return false;
+    }
+
+    unsigned char* body = binary_decompress(stored, stored_length, raw_length);
+    bool ok = body && response_set_body(response, (const char*)body, raw_length) == 0;
+    free(body);
+    return ok;
+}
+
+int history_store_read_entry(HistoryStore* store, uint64_t id, HistoryEntry* entry) {
+    if (!store || !entry) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    memset(&entry->summary, 0, sizeof(entry->summary));
+    request_init(&entry->request);
+    response_init(&entry->response);
+
+    pthread_mutex_lock(&store->mutex);
+    bool found = store->ready && id >= store->first_id && id < store->next_id;
+    IndexEntry index_entry;
+    found = found && read_entry(store->index, id - store->first_id, &index_entry);
+    uint32_t length = 0;
+    unsigned char* payload = found ? read_payload(store->log, index_entry.offset, store->log_size, &length) : NULL;
+    pthread_mutex_unlock(&store->mutex);
+
+    if (!found) {
+        return PERSISTENCE_ERROR_FILE_NOT_FOUND;
+    }
+    if (!payload) {
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    ByteReader reader;
+    byte_reader_init(&reader, payload, length);
+    read_payload_fixed(&reader, &entry->summary);
+
+    ByteReader request_reader = reader;
+    byte_reader_field(&request_reader, entry->summary.method, sizeof(entry->summary.method));
+    byte_reader_field(&request_reader, entry->summary.url, sizeof(entry->summary.url));
+
+    bool ok = entry->summary.id == id && byte_reader_request(&reader, &entry->request) &&
+              read_response(&reader, &entry->response);
+    free(payload);
+
+    if (!ok) {
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    entry->response.status_code = entry->summary.status_code;
+    entry->response.response_time = entry->summary.duration_ms;
+    entry->response.total_size = entry->summary.body_size;
+    return PERSISTENCE_SUCCESS;
+}
+
+void history_entry_cleanup(HistoryEntry* entry) {
+    if (!entry) {
+        return;
+    }
+
+    request_cleanup(&entry->request);
+    response_cleanup(&entry->response);
+}
+
+/* how many entries were sent at or before time_ms, send times never go
+ * down. called with the mutex held */
+static uint64_t entries_sent_by(HistoryStore* store, int64_t time_ms) {
+    uint64_t low = 0;
+    uint64_t high = store->ready ? entry_count(store) : 0;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        IndexEntry entry;
+        if (!read_entry(store->index, middle, &entry)) {
+            break;
+        }
+        if (entry.sent_at_ms <= time_ms) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int history_store_find_row_by_time(HistoryStore* store, int64_t time_ms) {
+    if (!store) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    uint64_t total = store->ready ? entry_count(store) : 0;
+    uint64_t row = total - entries_sent_by(store, time_ms);
+    pthread_mutex_unlock(&store->mutex);
+
+    return row > INT32_MAX ? INT32_MAX : (int)row;
+}
+
+bool history_store_find_time_range(HistoryStore* store, int64_t from_ms, int64_t to_ms,
+                                   uint64_t* first_id, uint64_t* last_id) {
+    if (!store || !first_id || !last_id || from_ms > to_ms) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    uint64_t first = entries_sent_by(store, from_ms - 1);
+    uint64_t end = entries_sent_by(store, to_ms);
+    *first_id = store->first_id + first;
+    *last_id = store->first_id + end - 1;
+    pthread_mutex_unlock(&store->mutex);
+
+    return first < end;
+}
+
+int history_store_find_url(HistoryStore* store, const char* url, uint64_t* ids, int max_ids) {
+    if (!store || !url || !ids || max_ids <= 0) {
+        return 0;
+    }
+
+    uint32_t hash = url_hash(url);
+    int found = 0;
+    char record_url[2048];
+
+    pthread_mutex_lock(&store->mutex);
+    uint64_t next = store->ready ? get_head(store, hash) : 0;
+    while (next > store->first_id && next <= store->next_id && found < max_ids) {
+        uint64_t id = next - 1;
+        IndexEntry entry;
+        HistorySummary summary;
+        if (!read_entry(store->index, id - store->first_id, &entry) ||
+            !read_summary_at(store->log, &entry, &summary, record_url, sizeof(record_url))) {
+            break;
+        }
+
+        /* the chain is per hash, other urls can share it */
+        if (strcmp(record_url, url) == 0) {
+            ids[found++] = id;
+        }
+
+        if (entry.previous >= next) {
+            break;
+        }
+        next = entry.previous;
+    }
+    pthread_mutex_unlock(&store->mutex);
+
+    return found;
+}
+
+void history_store_clear(HistoryStore* store) {
+    if (!store) {
+        return;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    for (int i = 0; i < store->pending_count; i++) {
+        pending_free(store->pending[i]);
+    }
+    store->pending_count = 0;
+    store->clear_requested = true;
+    pthread_cond_signal(&store->cond);
+    pthread_mutex_unlock(&store->mutex);
+}
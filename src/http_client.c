@@ -16,6 +16,7 @@
  */
 
 #include "http_client.h"
+#include "wake_signal.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -201,6 +202,9 @@ static int tinyrequest_progress_callback(void* clientp, curl_off_t dltotal, curl
 
     HttpClient* client = (HttpClient*)clientp;
 
+    /* let the ui redraw the progress it shows */
+    wake_signal_post();
+
     /* call user progress callback if set */
     if (client->progress_callback) {
         return client->progress_callback(client->progress_userdata, 
@@ -279,6 +283,71 @@ static size_t write_header_callback(char* buffer, size_t size, size_t nitems, vo
     return realsize;
 }
 
+/* milliseconds from the start of the transfer to a point libcurl recorded,
+ * -1 when the transfer never passed it or passed it on an earlier one */
+static double transfer_point_ms(CURL* curl, CURLINFO info) {
+    curl_off_t microseconds = 0;
+    if (curl_easy_getinfo(curl, info, &microseconds) != CURLE_OK || microseconds <= 0) {
+        return -1.0;
+    }
+    return microseconds / 1000.0;
+}
+
+static double phase_ms(double from, double to) {
+    return to > from ? to - from : 0.0;
+}
+
+/* splits the transfer into the phases HAR reports and keeps the sizes as sent and received */
+static void read_transfer_timings(CURL* curl, const Request* request, Response* response,
+                                  const struct timeval* start_time) {
+    ResponseTimings* timings = &response->timings;
+    memset(timings, 0, sizeof(ResponseTimings));
+    timings->valid = true;
+    timings->started_at_ms = (int64_t)start_time->tv_sec * 1000 + start_time->tv_usec / 1000;
+
+    double dns = transfer_point_ms(curl, CURLINFO_NAMELOOKUP_TIME_T);
+    double connect = transfer_point_ms(curl, CURLINFO_CONNECT_TIME_T);
+    double ssl = transfer_point_ms(curl, CURLINFO_APPCONNECT_TIME_T);
+    double pretransfer = transfer_point_ms(curl, CURLINFO_PRETRANSFER_TIME_T);
+    double first_byte = transfer_point_ms(curl, CURLINFO_STARTTRANSFER_TIME_T);
+    double total = transfer_point_ms(curl, CURLINFO_TOTAL_TIME_T);
+
+    /* a reused connection skips straight to sending */
+    double connected = ssl > 0.0 ? ssl : connect > 0.0 ? connect : dns > 0.0 ? dns : 0.0;
+    double sent = pretransfer > 0.0 ? pretransfer : connected;
+    timings->dns_ms = dns > 0.0 ? dns : -1.0;
+    timings->connect_ms = connect > 0.0 ? phase_ms(dns > 0.0 ? dns : 0.0, connected) : -1.0;
+    timings->ssl_ms = ssl > 0.0 && connect > 0.0 ? phase_ms(connect, ssl) : -1.0;
+    timings->send_ms = phase_ms(connected, sent);
+    timings->wait_ms = phase_ms(sent, first_byte > 0.0 ? first_byte : total);
+    timings->receive_ms = first_byte > 0.0 ? phase_ms(first_byte, total) : 0.0;
+
+    /* the request size counts a body sent along with the headers */
+    long header_size = 0;
+    long request_size = 0;
+    curl_off_t downloaded = 0;
+    curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &header_size);
+    curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &request_size);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    long body_size = request->body ? (long)request->body_size : 0;
+    timings->request_header_size = request_size > body_size ? request_size - body_size : request_size;
+    timings->response_header_size = header_size;
+    timings->download_size = (int64_t)downloaded;
+
+    long version = 0;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &version);
+    const char* version_name = version == CURL_HTTP_VERSION_1_0 ? "HTTP/1.0" :
+                               version == CURL_HTTP_VERSION_2_0 ? "HTTP/2" :
+                               version == CURL_HTTP_VERSION_3 ? "HTTP/3" : "HTTP/1.1";
+    snprintf(timings->http_version, sizeof(timings->http_version), "%s", version_name);
+
+    char* server_ip = NULL;
+    if (curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &server_ip) == CURLE_OK && server_ip) {
+        snprintf(timings->server_ip, sizeof(timings->server_ip), "%s", server_ip);
+    }
+    curl_easy_getinfo(curl, CURLINFO_LOCAL_PORT, &timings->local_port);
+}
+
 /* sends an http request and populates the response */
 int http_client_send_request(HttpClient* client, const Request* request, Response* response) {
     if (!client || !client->curl_handle || !request || !response) {
@@ -468,6 +537,7 @@ int http_client_send_request(HttpClient* client, const Request* request, Respons
     double elapsed_seconds = (end_time.tv_sec - start_time.tv_sec) +
                             (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
     response->response_time = elapsed_seconds * 1000.0; 
+    read_transfer_timings(curl, request, response, &start_time);
 
     /* get response code */
     long response_code;
@@ -560,6 +630,9 @@ int http_client_send_request(HttpClient* client, const Request* request, Respons
         }
     }
 
+    /* describe the body once here instead of every frame in the ui */
+    response_compute_meta(response);
+
     /* clean up headers */
     if (headers) {
         curl_slist_free_all(headers);
@@ -577,10 +650,10 @@ int http_client_send_request(HttpClient* client, const Request* request, Respons
     return (res == CURLE_OK) ? 0 : -1;
 }
 
-/* sends an http request with automatic cookie handling */
-int http_client_send_request_with_cookies(HttpClient* client, const Request* request, Response* response, Collection* collection) {
-    if (!client || !client->curl_handle || !request || !response || !collection) {
-        return -1; 
+/* adds the collection's matching cookies to the request as a cookie header */
+int http_client_add_cookie_header(Request* request, Collection* collection) {
+    if (!request || !collection) {
+        return -1;
     }
 
     /* first, clean up expired cookies from the collection's cookie jar */
@@ -590,81 +663,85 @@ int http_client_send_request_with_cookies(HttpClient* client, const Request* req
     bool is_secure = (strncmp(request->url, "https://", 8) == 0);
 
     /* build cookie header from the collection's cookie jar */
-    printf("DEBUG: Building cookie header for URL: %s (secure: %s)\n", request->url, is_secure ? "yes" : "no");
-    printf("DEBUG: Collection has %d cookies in jar\n", collection->cookie_jar.count);
-
-    for (int i = 0; i < collection->cookie_jar.count; i++) {
-        StoredCookie* cookie = &collection->cookie_jar.cookies[i];
-        printf("DEBUG: Cookie %d: %s=%s (domain: %s, path: %s, secure: %s, expired: %s)\n",
-               i, cookie->name, cookie->value, cookie->domain, cookie->path,
-               cookie->secure ? "yes" : "no",
-               cookie_jar_is_cookie_expired(cookie) ? "yes" : "no");
-    }
-
     char* cookie_header = cookie_jar_build_cookie_header(&collection->cookie_jar, request->url, is_secure);
 
-    if (cookie_header && strlen(cookie_header) > 0) {
-        printf("DEBUG: Built cookie header: %s\n", cookie_header);
-    } else {
-        printf("DEBUG: No cookie header built (no matching cookies)\n");
-    }
-
-    /* create a modified request with the cookie header if we have cookies */
-    Request modified_request = *request; 
-    HeaderList modified_headers;
-    header_list_init(&modified_headers);
-
-    /* copy all existing headers */
-    for (int i = 0; i < request->headers.count; i++) {
-        header_list_add(&modified_headers, request->headers.headers[i].name, request->headers.headers[i].value);
-    }
-
-    /* add or update the cookie header if we have cookies to send */
+    int result = 0;
     if (cookie_header && strlen(cookie_header) > 0) {
 
+        /* add or update the cookie header */
         bool cookie_header_found = false;
-        for (int i = 0; i < modified_headers.count; i++) {
-            if (strcasecmp(modified_headers.headers[i].name, "Cookie") == 0) {
+        for (int i = 0; i < request->headers.count; i++) {
+            if (strcasecmp(request->headers.headers[i].name, "Cookie") == 0) {
 
-                strncpy(modified_headers.headers[i].value, cookie_header, sizeof(modified_headers.headers[i].value) - 1);
-                modified_headers.headers[i].value[sizeof(modified_headers.headers[i].value) - 1] = '\0';
+                strncpy(request->headers.headers[i].value, cookie_header, sizeof(request->headers.headers[i].value) - 1);
+                request->headers.headers[i].value[sizeof(request->headers.headers[i].value) - 1] = '\0';
                 cookie_header_found = true;
                 break;
             }
         }
 
         if (!cookie_header_found) {
-            header_list_add(&modified_headers, "Cookie", cookie_header);
+            result = header_list_add(&request->headers, "Cookie", cookie_header);
         }
     }
 
+    if (cookie_header) {
+        free(cookie_header);
+    }
+
+    return result;
+}
+
+/* stores any set-cookie headers of a response in the collection's cookie jar */
+void http_client_store_response_cookies(Collection* collection, const char* url, const Response* response) {
+    if (!collection || !url || !response) {
+        return;
+    }
+
+    for (int i = 0; i < response->headers.count; i++) {
+        if (strcasecmp(response->headers.headers[i].name, "Set-Cookie") == 0) {
+
+            int cookie_result = cookie_jar_parse_set_cookie(&collection->cookie_jar,
+                                                          response->headers.headers[i].value,
+                                                          url);
+            if (cookie_result >= 0) {
+
+                collection_update_modified_time(collection);
+            }
+        }
+    }
+}
+
+/* sends an http request with automatic cookie handling */
+int http_client_send_request_with_cookies(HttpClient* client, const Request* request, Response* response, Collection* collection) {
+    if (!client || !client->curl_handle || !request || !response || !collection) {
+        return -1; 
+    }
+
+    /* create a modified request with its own header list for the cookie header */
+    Request modified_request = *request; 
+    HeaderList modified_headers;
+    header_list_init(&modified_headers);
+
+    /* copy all existing headers */
+    for (int i = 0; i < request->headers.count; i++) {
+        header_list_add(&modified_headers, request->headers.headers[i].name, request->headers.headers[i].value);
+    }
+
     /* update the modified request to use the new headers */
     modified_request.headers = modified_headers;
+    http_client_add_cookie_header(&modified_request, collection);
 
     /* send the request using the original function */
     int result = http_client_send_request(client, &modified_request, response);
 
     /* after receiving the response, process any set-cookie headers */
-    if (result == 0 && response->headers.count > 0) {
-        for (int i = 0; i < response->headers.count; i++) {
-            if (strcasecmp(response->headers.headers[i].name, "Set-Cookie") == 0) {
-
-                int cookie_result = cookie_jar_parse_set_cookie(&collection->cookie_jar,
-                                                              response->headers.headers[i].value,
-                                                              request->url);
-                if (cookie_result >= 0) {
-
-                    collection_update_modified_time(collection);
-                }
-            }
-        }
+    if (result == 0) {
+        http_client_store_response_cookies(collection, request->url, response);
     }
 
     /* clean up */
-    if (cookie_header) {
-        free(cookie_header);
-    }
-    header_list_cleanup(&modified_headers);
+    header_list_cleanup(&modified_request.headers);
 
     return result;
 }
@@ -0,0 +1,381 @@
+/**
+ * background image decoding for tinyrequest
+ *
+ * one worker thread is started the first time something is submitted and
+ * lives until the decoder is destroyed. there is a single queue slot, a new
+ * submission replaces whatever was waiting in it, and a short list of
+ * finished images that the ui drains with image_decoder_poll. decoding
+ * itself is done by stb_image, whose implementation is compiled here so
+ * the core library links without the gui, app_theme.cpp uses it for the
+ * window icon.
+ */
+
+#include "image_decoder.h"
+#include "wake_signal.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <strings.h>
+#include <limits.h>
+#include <pthread.h>
+
+/* finished images waiting for the ui, older ones are dropped past this */
+#define IMAGE_DECODER_MAX_FINISHED 4
+
+typedef struct {
+    uint64_t key;
+    unsigned char* data;
+    size_t size;
+} ImageDecodeJob;
+
+struct ImageDecoder {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+    bool shutting_down;
+    int max_dimension;
+
+    bool has_queued;
+    ImageDecodeJob queued;
+    bool has_active;
+    uint64_t active_key;
+
+    DecodedImage finished[IMAGE_DECODER_MAX_FINISHED];
+    int finished_count;
+};
+
+/* global out-of-memory handler */
+static void (*g_decoder_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_decoder_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_decoder_out_of_memory_handler) {
+        g_decoder_out_of_memory_handler(operation);
+    } else {
+        default_decoder_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void image_decoder_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_decoder_out_of_memory_handler = handler;
+}
+
+/* frees the pixels of a finished image */
+void decoded_image_cleanup(DecodedImage* image) {
+    if (!image) {
+        return;
+    }
+
+    free(image->pixels);
+    image->pixels = NULL;
+    image->width = 0;
+    image->height = 0;
+}
+
+/* box-filters rgba pixels down to dst_width x dst_height, every source pixel is read once */
+static unsigned char* downscale_rgba(const unsigned char* src, int src_width, int src_height,
+                                     int dst_width, int dst_height) {
+    unsigned char* dst = (unsigned char*)malloc((size_t)dst_width * dst_height * 4);
+    if (!dst) {
+        handle_out_of_memory("image downscale");
+        return NULL;
+    }
+
+    for (int dy = 0; dy < dst_height; dy++) {
+        int sy0 = (int)((int64_t)dy * src_height / dst_height);
+        int sy1 = (int)((int64_t)(dy + 1) * src_height / dst_height);
+        if (sy1 <= sy0) sy1 = sy0 + 1;
+
+        for (int dx = 0; dx < dst_width; dx++) {
+            int sx0 = (int)((int64_t)dx * src_width / dst_width);
+            int sx1 = (int)((int64_t)(dx + 1) * src_width / dst_width);
+            if (sx1 <= sx0) sx1 = sx0 + 1;
+
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int sy = sy0; sy < sy1; sy++) {
+                const unsigned char* p = src + ((size_t)sy * src_width + sx0) * 4;
+                for (int sx = sx0; sx < sx1; sx++, p += 4) {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                    sum[3] += p[3];
+                }
+            }
+
+            uint32_t count = (uint32_t)((sy1 - sy0) * (sx1 - sx0));
+            unsigned char* out = dst + ((size_t)dy * dst_width + dx) * 4;
+            for (int c = 0; c < 4; c++) {
+                out[c] = (unsigned char)((sum[c] + count / 2) / count);
+            }
+        }
+    }
+
+    return dst;
+}
+
+/* decodes one job into result, runs without the lock held */
+static void decode_job(const ImageDecodeJob* job, int max_dimension, DecodedImage* result) {
+    memset(result, 0, sizeof(DecodedImage));
+    result->key = job->key;
+
+    if (job->size > INT_MAX) {
+        snprintf(result->error, sizeof(result->error), "Image is too large to decode");
+        return;
+    }
+
+    int width, height, channels;
+    if (!stbi_info_from_memory(job->data, (int)job->size, &width, &height, &channels)) {
+        snprintf(result->error, sizeof(result->error), "Unsupported image: %s", stbi_failure_reason());
+        return;
+    }
+    if ((uint64_t)width * (uint64_t)height > IMAGE_DECODER_MAX_SOURCE_PIXELS) {
+        snprintf(result->error, sizeof(result->error), "Image is too large to preview (%dx%d)", width, height);
+        return;
+    }
+
+    unsigned char* pixels = stbi_load_from_memory(job->data, (int)job->size, &width, &height, &channels, 4);
+    if (!pixels) {
+        snprintf(result->error, sizeof(result->error), "Failed to decode image: %s", stbi_failure_reason());
+        return;
+    }
+
+    result->source_width = width;
+    result->source_height = height;
+
+    if (width > max_dimension || height > max_dimension) {
+        double scale = (double)max_dimension / (double)(width > height ? width : height);
+        int dst_width = (int)(width * scale);
+        int dst_height = (int)(height * scale);
+        if (dst_width < 1) dst_width = 1;
+        if (dst_height < 1) dst_height = 1;
+
+        unsigned char* scaled = downscale_rgba(pixels, width, height, dst_width, dst_height);
+        stbi_image_free(pixels);
+        if (!scaled) {
+            snprintf(result->error, sizeof(result->error), "Out of memory scaling image");
+            return;
+        }
+
+        result->pixels = scaled;
+        result->width = dst_width;
+        result->height = dst_height;
+        return;
+    }
+
+    /* stb allocates with malloc, so the buffer can be handed out as is */
+    result->pixels = pixels;
+    result->width = width;
+    result->height = height;
+}
+
+/* worker loop, takes the queued job, decodes it and publishes the result */
+static void* image_decoder_worker(void* arg) {
+    ImageDecoder* decoder = (ImageDecoder*)arg;
+
+    pthread_mutex_lock(&decoder->mutex);
+    while (!decoder->shutting_down) {
+        if (!decoder->has_queued) {
+            pthread_cond_wait(&decoder->cond, &decoder->mutex);
+            continue;
+        }
+
+        ImageDecodeJob job = decoder->queued;
+        decoder->has_queued = false;
+        decoder->has_active = true;
+        decoder->active_key = job.key;
+        pthread_mutex_unlock(&decoder->mutex);
+
+        DecodedImage result;
+        decode_job(&job, decoder->max_dimension, &result);
+        free(job.data);
+
+        pthread_mutex_lock(&decoder->mutex);
+        decoder->has_active = false;
+        if (decoder->finished_count == IMAGE_DECODER_MAX_FINISHED) {
+            decoded_image_cleanup(&decoder->finished[0]);
+            memmove(&decoder->finished[0], &decoder->finished[1],
+                    sizeof(DecodedImage) * (IMAGE_DECODER_MAX_FINISHED - 1));
+            decoder->finished_count--;
+        }
+        decoder->finished[decoder->finished_count++] = result;
+        wake_signal_post();
+    }
+    pthread_mutex_unlock(&decoder->mutex);
+
+    return NULL;
+}
+
+/* creates a decoder, the worker thread is started on first use */
+ImageDecoder* image_decoder_create(int max_dimension) {
+    ImageDecoder* decoder = (ImageDecoder*)calloc(1, sizeof(ImageDecoder));
+    if (!decoder) {
+        handle_out_of_memory("image decoder creation");
+        return NULL;
+    }
+
+    pthread_mutex_init(&decoder->mutex, NULL);
+    pthread_cond_init(&decoder->cond, NULL);
+    decoder->max_dimension = max_dimension > 0 ? max_dimension : IMAGE_DECODER_DEFAULT_MAX_DIMENSION;
+    return decoder;
+}
+
+/* stops the worker and frees everything that was not collected */
+void image_decoder_destroy(ImageDecoder* decoder) {
+    if (!decoder) {
+        return;
+    }
+
+    pthread_mutex_lock(&decoder->mutex);
+    decoder->shutting_down = true;
+    pthread_cond_signal(&decoder->cond);
+    pthread_mutex_unlock(&decoder->mutex);
+
+    if (decoder->thread_started) {
+        pthread_join(decoder->thread, NULL);
+    }
+
+    if (decoder->has_queued) {
+        free(decoder->queued.data);
+    }
+    for (int i = 0; i < decoder->finished_count; i++) {
+        decoded_image_cleanup(&decoder->finished[i]);
+    }
+
+    pthread_cond_destroy(&decoder->cond);
+    pthread_mutex_destroy(&decoder->mutex);
+    free(decoder);
+}
+
+/* copies the bytes and puts them in the queue slot, replacing anything still waiting */
+int image_decoder_submit(ImageDecoder* decoder, uint64_t key, const void* data, size_t size) {
+    if (!decoder || !data || size == 0) {
+        return -1;
+    }
+
+    unsigned char* copy = (unsigned char*)malloc(size);
+    if (!copy) {
+        handle_out_of_memory("image decode job");
+        return -1;
+    }
+    memcpy(copy, data, size);
+
+    pthread_mutex_lock(&decoder->mutex);
+
+    if (!decoder->thread_started) {
+        if (pthread_create(&decoder->thread, NULL, image_decoder_worker, decoder) != 0) {
+            pthread_mutex_unlock(&decoder->mutex);
+            free(copy);
+            return -1;
+        }
+        decoder->thread_started = true;
+    }
+
+    if (decoder->has_queued) {
+        free(decoder->queued.data);
+    }
+    decoder->queued.key = key;
+    decoder->queued.data = copy;
+    decoder->queued.size = size;
+    decoder->has_queued = true;
+
+    pthread_cond_signal(&decoder->cond);
+    pthread_mutex_unlock(&decoder->mutex);
+    return 0;
+}
+
+/* takes the oldest finished image, returns false if there is none */
+bool image_decoder_poll(ImageDecoder* decoder, DecodedImage* image) {
+    if (!decoder || !image) {
+        return false;
+    }
+
+    bool found = false;
+    pthread_mutex_lock(&decoder->mutex);
+    if (decoder->finished_count > 0) {
+        *image = decoder->finished[0];
+        decoder->finished_count--;
+        memmove(&decoder->finished[0], &decoder->finished[1], sizeof(DecodedImage) * decoder->finished_count);
+        found = true;
+    }
+    pthread_mutex_unlock(&decoder->mutex);
+
+    return found;
+}
+
+/* true while the key is waiting in the queue or being decoded */
+bool image_decoder_is_pending(ImageDecoder* decoder, uint64_t key) {
+    if (!decoder) {
+        return false;
+    }
+
+    pthread_mutex_lock(&decoder->mutex);
+    bool pending = (decoder->has_queued && decoder->queued.key == key) ||
+                   (decoder->has_active && decoder->active_key == key);
+    pthread_mutex_unlock(&decoder->mutex);
+
+    return pending;
+}
+
+/* fnv-1a over the size and up to 64kb from each end, enough to tell responses apart */
+uint64_t image_decoder_key(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    const size_t sample = 64 * 1024;
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < sizeof(size); i++) {
+        hash ^= (size >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ULL;
+    }
+
+    if (!bytes) {
+        return hash;
+    }
+
+    size_t head = size < sample ? size : sample;
+    for (size_t i = 0; i < head; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    size_t tail_start = size > sample * 2 ? size - sample : head;
+    for (size_t i = tail_start; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/* the formats stb_image can read */
+bool image_decoder_supports_content_type(const char* content_type) {
+    if (!content_type) {
+        return false;
+    }
+
+    static const char* supported[] = {
+        "image/png", "image/jpeg", "image/jpg", "image/pjpeg", "image/gif",
+        "image/bmp", "image/x-bmp", "image/x-ms-bmp", "image/vnd.adobe.photoshop",
+        "image/x-tga", "image/x-targa", "image/x-portable-pixmap", "image/x-portable-graymap",
+        "image/vnd.radiance", NULL
+    };
+
+    for (int i = 0; supported[i]; i++) {
+        size_t length = strlen(supported[i]);
+        if (strncasecmp(content_type, supported[i], length) == 0 &&
+            (content_type[length] == '\0' || content_type[length] == ';' || content_type[length] == ' ')) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,1339 @@
+/**
+ * streaming jsonpath filtering for tinyrequest
+ *
+ * a query is compiled into a short list of steps and evaluated as a small
+ * state machine. state n means "the first n steps have matched the path to
+ * this node", and each open container remembers the set of states that
+ * reached it as a bitmask. entering a child moves every state forward by
+ * one step if the child's key or index fits, descendant steps also stay
+ * where they are so they keep looking deeper. when the final state is
+ * reached the value's raw bytes are captured until it closes.
+ *
+ * the json tokenizer works one byte at a time and keeps all of its state
+ * in the stream, so chunk boundaries can fall anywhere, even in the middle
+ * of a string escape. containers whose state set is empty can never match,
+ * so their keys are not even copied.
+ *
+ * the runner follows the json validator: one thread started on first use,
+ * a single queue slot that new submissions overwrite, and a wakeup for the
+ * main loop once a result is ready.
+ */
+
+#include "json_filter.h"
+#include "wake_signal.h"
+#include "cJSON.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef enum {
+    STEP_NAME,
+    STEP_WILDCARD,
+    STEP_INDEX,
+    STEP_SLICE
+} FilterStepType;
+
+/* one selector in a compiled query */
+typedef struct {
+    FilterStepType type;
+    bool descendant;
+    char name[JSON_FILTER_MAX_NAME];
+    long start;
+    long end;
+    long step;
+} FilterStep;
+
+struct JsonFilterQuery {
+    char* expression;
+    FilterStep steps[JSON_FILTER_MAX_STEPS];
+    int step_count;
+    int refcount;
+    bool cached;
+};
+
+typedef enum {
+    SCAN_VALUE,
+    SCAN_VALUE_OR_END,
+    SCAN_KEY_OR_END,
+    SCAN_NEXT_KEY,
+    SCAN_KEY,
+    SCAN_COLON,
+    SCAN_STRING,
+    SCAN_LITERAL,
+    SCAN_AFTER_VALUE,
+    SCAN_ERROR
+} ScanState;
+
+/* an open object or array */
+typedef struct {
+    char type;
+    uint64_t states;
+    long index;
+} FilterFrame;
+
+/* a matching value whose bytes are still being collected */
+typedef struct {
+    int depth;
+    size_t ordinal;
+    size_t pending_from;
+    char* data;
+    size_t length;
+    size_t capacity;
+} FilterCapture;
+
+struct JsonFilterStream {
+    const JsonFilterQuery* query;
+    JsonFilterMatchCallback callback;
+    void* userdata;
+
+    ScanState state;
+    FilterFrame frames[JSON_FILTER_MAX_DEPTH];
+    int depth;
+
+    bool in_escape;
+    int unicode_digits;
+    unsigned int unicode_value;
+    unsigned int high_surrogate;
+    char key[JSON_FILTER_MAX_NAME];
+    size_t key_length;
+    bool key_overflow;
+    bool key_wanted;
+
+    FilterCapture captures[JSON_FILTER_MAX_DEPTH + 1];
+    int capture_count;
+
+    size_t values_started;
+    size_t match_count;
+    size_t offset;
+    bool stopped;
+    char error[128];
+};
+
+/* global out-of-memory handler */
+static void (*g_filter_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_filter_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_filter_out_of_memory_handler) {
+        g_filter_out_of_memory_handler(operation);
+    } else {
+        default_filter_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom out-of-memory handler for filter allocations */
+void json_filter_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_filter_out_of_memory_handler = handler;
+}
+
+static void set_error(char* error, size_t error_size, const char* message, size_t position) {
+    if (error && error_size > 0) {
+        snprintf(error, error_size, "%s at position %zu", message, position);
+    }
+}
+
+/* parses an integer, returns 1 if it did, 0 if there are no digits and -1
+ * with the error set if it does not fit in a long */
+static int parse_number(const char** cursor, long* value, const char* expression, char* error, size_t error_size) {
+    const char* p = *cursor;
+    long result = 0;
+    bool negative = false;
+
+    if (*p == '-') {
+        negative = true;
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        return 0;
+    }
+    while (*p >= '0' && *p <= '9') {
+        int digit = *p - '0';
+        if (result > (LONG_MAX - digit) / 10) {
+            set_error(error, error_size, "Number too large", (size_t)(*cursor - expression));
+            return -1;
+        }
+        result = result * 10 + digit;
+        p++;
+    }
+
+    *value = negative ? -result : result;
+    *cursor = p;
+    return 1;
+}
+
+/* parses the contents of a [...] selector */
+static bool parse_bracket(const char** cursor, FilterStep* step, const char* expression,
+                          char* error, size_t error_size) {
+    const char* p = *cursor;
+
+    while (*p == ' ') p++;
+
+    if (*p == '\'' || *p == '"') {
+        char quote = *p++;
+        size_t length = 0;
+        while (*p && *p != quote) {
+            if (*p == '\\' && p[1]) {
+                p++;
+            }
+            if (length >= sizeof(step->name) - 1) {
+                set_error(error, error_size, "Member name too long", (size_t)(p - expression));
+                return false;
+            }
+            step->name[length++] = *p++;
+        }
+        if (*p != quote) {
+            set_error(error, error_size, "Unterminated member name", (size_t)(p - expression));
+            return false;
+        }
+        step->name[length] = '\0';
+        step->type = STEP_NAME;
+        p++;
+    } else if (*p == '*') {
+        step->type = STEP_WILDCARD;
+        p++;
+    } else if (*p == '?' || *p == '(') {
+        set_error(error, error_size, "Filter expressions are not supported", (size_t)(p - expression));
+        return false;
+    } else {
+        long first = 0;
+        int has_first = parse_number(&p, &first, expression, error, error_size);
+        if (has_first < 0) {
+            return false;
+        }
+
+        while (*p == ' ') p++;
+        if (*p == ':') {
+            long end = -1;
+            long stride = 1;
+            p++;
+            while (*p == ' ') p++;
+            int has_end = parse_number(&p, &end, expression, error, error_size);
+            if (has_end < 0) {
+                return false;
+            }
+            while (*p == ' ') p++;
+            if (*p == ':') {
+                p++;
+                while (*p == ' ') p++;
+                int has_stride = parse_number(&p, &stride, expression, error, error_size);
+                if (has_stride < 0) {
+                    return false;
+                }
+                if (has_stride == 0) {
+                    stride = 1;
+                }
+            }
+            if ((has_first && first < 0) || (has_end && end < 0) || stride < 1) {
+                set_error(error, error_size, "Negative slice bounds are not supported", (size_t)(p - expression));
+                return false;
+            }
+            step->type = STEP_SLICE;
+            step->start = has_first ? first : 0;
+            step->end = has_end ? end : -1;
+            step->step = stride;
+        } else if (has_first) {
+            if (first < 0) {
+                set_error(error, error_size, "Negative indexes are not supported", (size_t)(p - expression));
+                return false;
+            }
+            step->type = STEP_INDEX;
+            step->start = first;
+        } else {
+            set_error(error, error_size, "Expected index, name or *", (size_t)(p - expression));
+            return false;
+        }
+    }
+
+    while (*p == ' ') p++;
+    if (*p != ']') {
+        set_error(error, error_size, "Expected ]", (size_t)(p - expression));
+        return false;
+    }
+
+    *cursor = p + 1;
+    return true;
+}
+
+/* compiles a jsonpath expression into steps */
+JsonFilterQuery* json_filter_compile(const char* expression, char* error, size_t error_size) {
+    if (error && error_size > 0) {
+        error[0] = '\0';
+    }
+    if (!expression) {
+        return NULL;
+    }
+
+    JsonFilterQuery* query = (JsonFilterQuery*)malloc(sizeof(JsonFilterQuery));
+    if (!query) {
+        handle_out_of_memory("json filter compilation");
+        return NULL;
+    }
+    memset(query, 0, sizeof(JsonFilterQuery));
+
+    query->expression = (char*)malloc(strlen(expression) + 1);
+    if (!query->expression) {
+        handle_out_of_memory("json filter expression copy");
+        free(query);
+        return NULL;
+    }
+    strcpy(query->expression, expression);
+
+    const char* p = expression;
+    while (*p == ' ') p++;
+    if (*p == '$') {
+        p++;
+    }
+
+    while (*p && *p != ' ') {
+        if (query->step_count >= JSON_FILTER_MAX_STEPS) {
+            set_error(error, error_size, "Too many path steps", (size_t)(p - expression));
+            json_filter_query_destroy(query);
+            return NULL;
+        }
+
+        FilterStep* step = &query->steps[query->step_count];
+        memset(step, 0, sizeof(FilterStep));
+
+        if (*p == '.') {
+            p++;
+            if (*p == '.') {
+                step->descendant = true;
+                p++;
+            }
+
+            if (*p == '[') {
+                p++;
+                if (!parse_bracket(&p, step, expression, error, error_size)) {
+                    json_filter_query_destroy(query);
+                    return NULL;
+                }
+            } else if (*p == '*') {
+                step->type = STEP_WILDCARD;
+                p++;
+            } else {
+                size_t length = 0;
+                while (*p && *p != '.' && *p != '[' && *p != ' ') {
+                    if (length >= sizeof(step->name) - 1) {
+                        set_error(error, error_size, "Member name too long", (size_t)(p - expression));
+                        json_filter_query_destroy(query);
+                        return NULL;
+                    }
+                    step->name[length++] = *p++;
+                }
+                if (length == 0) {
+                    set_error(error, error_size, "Expected member name", (size_t)(p - expression));
+                    json_filter_query_destroy(query);
+                    return NULL;
+                }
+                step->name[length] = '\0';
+                step->type = STEP_NAME;
+            }
+        } else if (*p == '[') {
+            p++;
+            if (!parse_bracket(&p, step, expression, error, error_size)) {
+                json_filter_query_destroy(query);
+                return NULL;
+            }
+        } else {
+            set_error(error, error_size, "Unexpected character", (size_t)(p - expression));
+            json_filter_query_destroy(query);
+            return NULL;
+        }
+
+        query->step_count++;
+    }
+
+    while (*p == ' ') p++;
+    if (*p) {
+        set_error(error, error_size, "Unexpected trailing text", (size_t)(p - expression));
+        json_filter_query_destroy(query);
+        return NULL;
+    }
+
+    return query;
+}
+
+/* frees a query that did not come from the cache */
+void json_filter_query_destroy(JsonFilterQuery* query) {
+    if (!query) {
+        return;
+    }
+
+    free(query->expression);
+    free(query);
+}
+
+/* returns the text the query was compiled from */
+const char* json_filter_query_expression(const JsonFilterQuery* query) {
+    return query ? query->expression : "";
+}
+
+/* small lru of compiled queries shared by the ui, collection runs and load tests */
+typedef struct {
+    JsonFilterQuery* query;
+    unsigned long last_used;
+} FilterCacheEntry;
+
+static FilterCacheEntry g_filter_cache[JSON_FILTER_CACHE_SIZE];
+static unsigned long g_filter_cache_clock = 0;
+static pthread_mutex_t g_filter_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* returns a compiled query for expression, compiling it on a cache miss */
+JsonFilterQuery* json_filter_cache_acquire(const char* expression, char* error, size_t error_size) {
+    if (!expression) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_filter_cache_mutex);
+
+    for (int i = 0; i < JSON_FILTER_CACHE_SIZE; i++) {
+        JsonFilterQuery* cached = g_filter_cache[i].query;
+        if (cached && strcmp(cached->expression, expression) == 0) {
+            cached->refcount++;
+            g_filter_cache[i].last_used = ++g_filter_cache_clock;
+            pthread_mutex_unlock(&g_filter_cache_mutex);
+            if (error && error_size > 0) {
+                error[0] = '\0';
+            }
+            return cached;
+        }
+    }
+
+    pthread_mutex_unlock(&g_filter_cache_mutex);
+
+    /* compile outside the lock, a duplicate insert from another thread is harmless */
+    JsonFilterQuery* query = json_filter_compile(expression, error, error_size);
+    if (!query) {
+        return NULL;
+    }
+    query->refcount = 1;
+
+    pthread_mutex_lock(&g_filter_cache_mutex);
+
+    int victim = -1;
+    for (int i = 0; i < JSON_FILTER_CACHE_SIZE; i++) {
+        if (!g_filter_cache[i].query) {
+            victim = i;
+            break;
+        }
+        if (g_filter_cache[i].query->refcount == 0 &&
+            (victim < 0 || g_filter_cache[i].last_used < g_filter_cache[victim].last_used)) {
+            victim = i;
+        }
+    }
+
+    if (victim >= 0) {
+        if (g_filter_cache[victim].query) {
+            json_filter_query_destroy(g_filter_cache[victim].query);
+        }
+        query->cached = true;
+        g_filter_cache[victim].query = query;
+        g_filter_cache[victim].last_used = ++g_filter_cache_clock;
+    }
+
+    pthread_mutex_unlock(&g_filter_cache_mutex);
+    return query;
+}
+
+/* gives back a query from json_filter_cache_acquire */
+void json_filter_cache_release(JsonFilterQuery* query) {
+    if (!query) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_filter_cache_mutex);
+    query->refcount--;
+    bool destroy = !query->cached && query->refcount <= 0;
+    pthread_mutex_unlock(&g_filter_cache_mutex);
+
+    if (destroy) {
+        json_filter_query_destroy(query);
+    }
+}
+
+/* drops every cached query that is not currently in use */
+void json_filter_cache_clear(void) {
+    pthread_mutex_lock(&g_filter_cache_mutex);
+    for (int i = 0; i < JSON_FILTER_CACHE_SIZE; i++) {
+        JsonFilterQuery* query = g_filter_cache[i].query;
+        if (!query) {
+            continue;
+        }
+        if (query->refcount <= 0) {
+            json_filter_query_destroy(query);
+        } else {
+            /* still in use, the last release frees it */
+            query->cached = false;
+        }
+        g_filter_cache[i].query = NULL;
+    }
+    pthread_mutex_unlock(&g_filter_cache_mutex);
+}
+
+/* creates an evaluator for one document (or a stream of json lines) */
+JsonFilterStream* json_filter_stream_create(const JsonFilterQuery* query, JsonFilterMatchCallback callback, void* userdata) {
+    if (!query || !callback) {
+        return NULL;
+    }
+
+    JsonFilterStream* stream = (JsonFilterStream*)malloc(sizeof(JsonFilterStream));
+    if (!stream) {
+        handle_out_of_memory("json filter stream creation");
+        return NULL;
+    }
+
+    memset(stream, 0, sizeof(JsonFilterStream));
+    stream->query = query;
+    stream->callback = callback;
+    stream->userdata = userdata;
+    stream->state = SCAN_VALUE;
+
+    return stream;
+}
+
+/* frees an evaluator and any partially captured values */
+void json_filter_stream_destroy(JsonFilterStream* stream) {
+    if (!stream) {
+        return;
+    }
+
+    for (int i = 0; i < stream->capture_count; i++) {
+        free(stream->captures[i].data);
+    }
+    free(stream);
+}
+
+/* advances the state set across one edge of the document tree */
+static uint64_t step_states(const JsonFilterQuery* query, uint64_t states, const char* key,
+                            size_t key_length, bool has_key, long index) {
+    uint64_t next = 0;
+
+    for (int s = 0; s < query->step_count; s++) {
+        if (!(states & ((uint64_t)1 << s))) {
+            continue;
+        }
+
+        const FilterStep* step = &query->steps[s];
+        bool matches = false;
+
+        switch (step->type) {
+            case STEP_NAME:
+                matches = has_key && strlen(step->name) == key_length &&
+                          memcmp(step->name, key, key_length) == 0;
+                break;
+            case STEP_WILDCARD:
+                matches = true;
+                break;
+            case STEP_INDEX:
+                matches = !has_key && index == step->start;
+                break;
+            case STEP_SLICE:
+                matches = !has_key && index >= step->start &&
+                          (step->end < 0 || index < step->end) &&
+                          (index - step->start) % step->step == 0;
+                break;
+        }
+
+        if (matches) {
+            next |= (uint64_t)1 << (s + 1);
+        }
+        if (step->descendant) {
+            next |= (uint64_t)1 << s;
+        }
+    }
+
+    return next;
+}
+
+/* appends the not yet copied part of a capture from the current chunk */
+static bool capture_append(FilterCapture* capture, const char* data, size_t end) {
+    size_t count = end - capture->pending_from;
+    if (count == 0) {
+        return true;
+    }
+
+    if (capture->length + count + 1 > capture->capacity) {
+        size_t new_capacity = capture->capacity ? capture->capacity * 2 : 256;
+        while (new_capacity < capture->length + count + 1) {
+            new_capacity *= 2;
+        }
+        char* grown = (char*)realloc(capture->data, new_capacity);
+        if (!grown) {
+            handle_out_of_memory("json filter capture");
+            return false;
+        }
+        capture->data = grown;
+        capture->capacity = new_capacity;
+    }
+
+    memcpy(capture->data + capture->length, data + capture->pending_from, count);
+    capture->length += count;
+    capture->data[capture->length] = '\0';
+    capture->pending_from = end;
+    return true;
+}
+
+/* called when a value starts at data[pos], decides whether it is captured */
+static uint64_t begin_value(JsonFilterStream* stream, size_t pos) {
+    const JsonFilterQuery* query = stream->query;
+    uint64_t states;
+
+    if (stream->depth == 0) {
+        states = 1;
+    } else {
+        FilterFrame* parent = &stream->frames[stream->depth - 1];
+        if (parent->states == 0) {
+            states = 0;
+        } else if (parent->type == '{') {
+            states = step_states(query, parent->states, stream->key, stream->key_length,
+                                 !stream->key_overflow, -1);
+        } else {
+            states = step_states(query, parent->states, NULL, 0, false, parent->index);
+        }
+    }
+
+    size_t ordinal = stream->values_started++;
+
+    if (states & ((uint64_t)1 << query->step_count)) {
+        FilterCapture* capture = &stream->captures[stream->capture_count++];
+        memset(capture, 0, sizeof(FilterCapture));
+        capture->depth = stream->depth;
+        capture->ordinal = ordinal;
+        capture->pending_from = pos;
+    }
+
+    return states;
+}
+
+/* called when the value at the current depth ends just before data[end] */
+static bool end_value(JsonFilterStream* stream, const char* data, size_t end) {
+    if (stream->capture_count == 0) {
+        return true;
+    }
+
+    FilterCapture* capture = &stream->captures[stream->capture_count - 1];
+    if (capture->depth != stream->depth) {
+        return true;
+    }
+
+    bool ok = capture_append(capture, data, end);
+    stream->capture_count--;
+
+    if (ok) {
+        stream->match_count++;
+        if (stream->callback(capture->data ? capture->data : "", capture->length,
+                             capture->ordinal, stream->userdata) != 0) {
+            stream->stopped = true;
+        }
+    }
+    free(capture->data);
+    return ok;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int fail(JsonFilterStream* stream, const char* message, size_t pos) {
+    set_error(stream->error, sizeof(stream->error), message, stream->offset + pos);
+    stream->state = SCAN_ERROR;
+    return -1;
+}
+
+/* appends one decoded byte to the current key, if anyone needs it */
+static void key_push(JsonFilterStream* stream, char c) {
+    if (!stream->key_wanted) {
+        return;
+    }
+    if (stream->key_length < sizeof(stream->key) - 1) {
+        stream->key[stream->key_length++] = c;
+    } else {
+        stream->key_overflow = true;
+    }
+}
+
+/* appends a \u escape to the current key as utf-8 */
+static void key_push_codepoint(JsonFilterStream* stream, unsigned int cp) {
+    if (cp < 0x80) {
+        key_push(stream, (char)cp);
+    } else if (cp < 0x800) {
+        key_push(stream, (char)(0xC0 | (cp >> 6)));
+        key_push(stream, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        key_push(stream, (char)(0xE0 | (cp >> 12)));
+        key_push(stream, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        key_push(stream, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        key_push(stream, (char)(0xF0 | (cp >> 18)));
+        key_push(stream, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        key_push(stream, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        key_push(stream, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+/* a complete \u escape. a high surrogate waits for the low one that has to
+ * follow it, false for a surrogate without its other half */
+static bool unicode_escape(JsonFilterStream* stream, bool is_key) {
+    unsigned int cp = stream->unicode_value;
+    if (stream->high_surrogate != 0) {
+        if (cp < 0xDC00 || cp > 0xDFFF) {
+            return false;
+        }
+        cp = 0x10000 + ((stream->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+        stream->high_surrogate = 0;
+    } else if (cp >= 0xD800 && cp <= 0xDBFF) {
+        stream->high_surrogate = cp;
+        return true;
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return false;
+    }
+    if (is_key) {
+        key_push_codepoint(stream, cp);
+    }
+    return true;
+}
+
+/* tracks escapes inside a string. returns 1 when c closes the string, -1
+ * when it makes an invalid escape */
+static int string_byte(JsonFilterStream* stream, char c, bool is_key) {
+    if (stream->unicode_digits > 0) {
+        unsigned int digit;
+        if (c >= '0' && c <= '9') digit = (unsigned int)(c - '0');
+        else if (c >= 'a' && c <= 'f') digit = (unsigned int)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') digit = (unsigned int)(c - 'A' + 10);
+        else return -1;
+        stream->unicode_value = (stream->unicode_value << 4) | digit;
+        if (--stream->unicode_digits == 0 && !unicode_escape(stream, is_key)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    if (stream->in_escape) {
+        stream->in_escape = false;
+        if (c == 'u') {
+            stream->unicode_digits = 4;
+            stream->unicode_value = 0;
+            return 0;
+        }
+        if (stream->high_surrogate != 0) {
+            return -1;
+        }
+        char decoded;
+        switch (c) {
+            case '"': case '\\': case '/': decoded = c; break;
+            case 'n': decoded = '\n'; break;
+            case 't': decoded = '\t'; break;
+            case 'r': decoded = '\r'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            default: return -1;
+        }
+        if (is_key) {
+            key_push(stream, decoded);
+        }
+        return 0;
+    }
+
+    if (c == '\\') {
+        stream->in_escape = true;
+        return 0;
+    }
+    if (stream->high_surrogate != 0) {
+        return -1;
+    }
+    if (c == '"') {
+        return 1;
+    }
+    if (is_key) {
+        key_push(stream, c);
+    }
+    return 0;
+}
+
+/* starts reading the key whose opening quote was just seen */
+static void start_key(JsonFilterStream* stream) {
+    stream->key_length = 0;
+    stream->key_overflow = false;
+    stream->key_wanted = stream->frames[stream->depth - 1].states != 0;
+    stream->in_escape = false;
+    stream->unicode_digits = 0;
+    stream->high_surrogate = 0;
+    stream->state = SCAN_KEY;
+}
+
+/* starts the value whose first byte is data[i] */
+static int start_value(JsonFilterStream* stream, const char* data, size_t i) {
+    char c = data[i];
+    uint64_t states = begin_value(stream, i);
+
+    if (c == '{' || c == '[') {
+        if (stream->depth >= JSON_FILTER_MAX_DEPTH) {
+            return fail(stream, "Nesting too deep", i);
+        }
+        FilterFrame* frame = &stream->frames[stream->depth++];
+        frame->type = c;
+        frame->states = states;
+        frame->index = 0;
+        stream->state = (c == '{') ? SCAN_KEY_OR_END : SCAN_VALUE_OR_END;
+    } else if (c == '"') {
+        stream->in_escape = false;
+        stream->unicode_digits = 0;
+        stream->high_surrogate = 0;
+        stream->state = SCAN_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+        stream->state = SCAN_LITERAL;
+    } else {
+        return fail(stream, "Unexpected character", i);
+    }
+    return 0;
+}
+
+/* closes the innermost container with the bracket at data[i] */
+static int close_container(JsonFilterStream* stream, const char* data, size_t i) {
+    char c = data[i];
+    if (stream->depth == 0) {
+        return fail(stream, "Unexpected closing bracket", i);
+    }
+
+    FilterFrame* frame = &stream->frames[stream->depth - 1];
+    if ((c == '}' && frame->type != '{') || (c == ']' && frame->type != '[')) {
+        return fail(stream, "Mismatched closing bracket", i);
+    }
+
+    stream->depth--;
+    if (!end_value(stream, data, i + 1)) {
+        return fail(stream, "Out of memory", i);
+    }
+    stream->state = (stream->depth == 0) ? SCAN_VALUE : SCAN_AFTER_VALUE;
+    return 0;
+}
+
+/* feeds the next chunk of json into the evaluator */
+int json_filter_stream_feed(JsonFilterStream* stream, const char* data, size_t length) {
+    if (!stream || (!data && length > 0)) {
+        return -1;
+    }
+    if (stream->state == SCAN_ERROR) {
+        return -1;
+    }
+
+    for (int k = 0; k < stream->capture_count; k++) {
+        stream->captures[k].pending_from = 0;
+    }
+
+    for (size_t i = 0; i < length && !stream->stopped; i++) {
+        char c = data[i];
+
+        switch (stream->state) {
+            case SCAN_VALUE:
+                if (is_space(c)) break;
+                if (start_value(stream, data, i) != 0) return -1;
+                break;
+
+            case SCAN_VALUE_OR_END:
+                if (is_space(c)) break;
+                if (c == ']') {
+                    if (close_container(stream, data, i) != 0) return -1;
+                } else if (start_value(stream, data, i) != 0) {
+                    return -1;
+                }
+                break;
+
+            case SCAN_KEY_OR_END:
+                if (is_space(c)) break;
+                if (c == '}') {
+                    if (close_container(stream, data, i) != 0) return -1;
+                } else if (c == '"') {
+                    start_key(stream);
+                } else {
+                    return fail(stream, "Expected object key", i);
+                }
+                break;
+
+            case SCAN_NEXT_KEY:
+                /* a comma has to be followed by another member */
+                if (is_space(c)) break;
+                if (c != '"') return fail(stream, "Expected object key", i);
+                start_key(stream);
+                break;
+
+            case SCAN_KEY: {
+                int end = string_byte(stream, c, true);
+                if (end < 0) return fail(stream, "Invalid escape", i);
+                if (end > 0) {
+                    stream->key[stream->key_length] = '\0';
+                    stream->state = SCAN_COLON;
+                }
+                break;
+            }
+
+            case SCAN_COLON:
+                if (is_space(c)) break;
+                if (c != ':') return fail(stream, "Expected ':'", i);
+                stream->state = SCAN_VALUE;
+                break;
+
+            case SCAN_STRING: {
+                if (!stream->in_escape && stream->unicode_digits == 0 && stream->high_surrogate == 0) {
+                    /* plain string bytes never change state, skip them in bulk */
+                    while (i < length && data[i] != '"' && data[i] != '\\') {
+                        i++;
+                    }
+                    if (i == length) {
+                        break;
+                    }
+                    c = data[i];
+                }
+                int end = string_byte(stream, c, false);
+                if (end < 0) return fail(stream, "Invalid escape", i);
+                if (end > 0) {
+                    if (!end_value(stream, data, i + 1)) return fail(stream, "Out of memory", i);
+                    stream->state = (stream->depth == 0) ? SCAN_VALUE : SCAN_AFTER_VALUE;
+                }
+                break;
+            }
+
+            case SCAN_LITERAL:
+                if (!is_space(c) && c != ',' && c != ']' && c != '}') break;
+                if (!end_value(stream, data, i)) return fail(stream, "Out of memory", i);
+                if (stream->depth == 0) {
+                    stream->state = SCAN_VALUE;
+                    if (!is_space(c)) return fail(stream, "Unexpected character", i);
+                    break;
+                }
+                stream->state = SCAN_AFTER_VALUE;
+                /* fall through - the delimiter belongs to the container */
+
+            case SCAN_AFTER_VALUE:
+                if (is_space(c)) break;
+                if (c == ',') {
+                    FilterFrame* frame = &stream->frames[stream->depth - 1];
+                    if (frame->type == '[') {
+                        frame->index++;
+                        stream->state = SCAN_VALUE;
+                    } else {
+                        stream->state = SCAN_NEXT_KEY;
+                    }
+                } else if (c == ']' || c == '}') {
+                    if (close_container(stream, data, i) != 0) return -1;
+                } else {
+                    return fail(stream, "Expected ',' or closing bracket", i);
+                }
+                break;
+
+            case SCAN_ERROR:
+                return -1;
+        }
+    }
+
+    for (int k = 0; k < stream->capture_count; k++) {
+        if (!capture_append(&stream->captures[k], data, length)) {
+            return fail(stream, "Out of memory", length);
+        }
+    }
+
+    stream->offset += length;
+    return 0;
+}
+
+/* signals end of input, flushing a trailing top-level literal */
+int json_filter_stream_finish(JsonFilterStream* stream) {
+    if (!stream) {
+        return -1;
+    }
+    if (stream->state == SCAN_ERROR) {
+        return -1;
+    }
+    if (stream->stopped) {
+        return 0;
+    }
+
+    if (stream->state == SCAN_LITERAL && stream->depth == 0) {
+        for (int k = 0; k < stream->capture_count; k++) {
+            stream->captures[k].pending_from = 0;
+        }
+        end_value(stream, "", 0);
+        stream->state = SCAN_VALUE;
+    }
+
+    if (stream->depth > 0 || stream->state != SCAN_VALUE) {
+        set_error(stream->error, sizeof(stream->error), "Unexpected end of input", stream->offset);
+        stream->state = SCAN_ERROR;
+        return -1;
+    }
+    return 0;
+}
+
+/* returns the reason feeding failed, or an empty string */
+const char* json_filter_stream_error(const JsonFilterStream* stream) {
+    return stream ? stream->error : "";
+}
+
+/* returns how many values have matched so far */
+size_t json_filter_stream_match_count(const JsonFilterStream* stream) {
+    return stream ? stream->match_count : 0;
+}
+
+/* evaluates a complete buffer */
+long json_filter_run(const JsonFilterQuery* query, const char* data, size_t length,
+                     JsonFilterMatchCallback callback, void* userdata,
+                     char* error, size_t error_size) {
+    if (error && error_size > 0) {
+        error[0] = '\0';
+    }
+
+    JsonFilterStream* stream = json_filter_stream_create(query, callback, userdata);
+    if (!stream) {
+        return -1;
+    }
+
+    long result = -1;
+    if (json_filter_stream_feed(stream, data, length) == 0 &&
+        json_filter_stream_finish(stream) == 0) {
+        result = (long)stream->match_count;
+    } else if (error && error_size > 0) {
+        snprintf(error, error_size, "%s", stream->error);
+    }
+
+    json_filter_stream_destroy(stream);
+    return result;
+}
+
+/* one queued run, the runner owns both copies */
+typedef struct {
+    unsigned int generation;
+    char* expression;
+    char* data;
+    size_t length;
+} FilterRunJob;
+
+/* a match kept by a run until they are put in document order */
+typedef struct {
+    size_t ordinal;
+    char* text;
+    size_t length;
+} FilterMatchEntry;
+
+typedef struct {
+    FilterMatchEntry* items;
+    size_t count;
+    size_t capacity;
+    size_t total_length;
+    bool truncated;
+    atomic_int* cancel;
+} FilterMatchList;
+
+struct JsonFilterRunner {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+    bool shutting_down;
+
+    bool has_queued;
+    FilterRunJob queued;
+    bool has_active;
+    atomic_int cancel;
+
+    bool has_result;
+    JsonFilterResult result;
+};
+
+static void free_run_job(FilterRunJob* job) {
+    free(job->expression);
+    free(job->data);
+    memset(job, 0, sizeof(FilterRunJob));
+}
+
+static int collect_match(const char* value, size_t length, size_t ordinal, void* userdata) {
+    FilterMatchList* list = (FilterMatchList*)userdata;
+
+    if (atomic_load(list->cancel)) {
+        return 1;
+    }
+    if (list->total_length + length > JSON_FILTER_OUTPUT_LIMIT) {
+        list->truncated = true;
+        return 1;
+    }
+
+    if (list->count == list->capacity) {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : 64;
+        FilterMatchEntry* grown = (FilterMatchEntry*)realloc(list->items, new_capacity * sizeof(FilterMatchEntry));
+        if (!grown) {
+            handle_out_of_memory("json filter matches");
+            list->truncated = true;
+            return 1;
+        }
+        list->items = grown;
+        list->capacity = new_capacity;
+    }
+
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) {
+        handle_out_of_memory("json filter match");
+        list->truncated = true;
+        return 1;
+    }
+    memcpy(copy, value, length);
+    copy[length] = '\0';
+
+    list->items[list->count].ordinal = ordinal;
+    list->items[list->count].text = copy;
+    list->items[list->count].length = length;
+    list->count++;
+    list->total_length += length;
+    return 0;
+}
+
+static int compare_matches(const void* a, const void* b) {
+    size_t left = ((const FilterMatchEntry*)a)->ordinal;
+    size_t right = ((const FilterMatchEntry*)b)->ordinal;
+    return (left > right) - (left < right);
+}
+
+/* joins the matches into a json array, nested matches arrive before their parents so they are sorted first */
+static char* join_matches(FilterMatchList* list, size_t* output_size) {
+    qsort(list->items, list->count, sizeof(FilterMatchEntry), compare_matches);
+
+    char* output = (char*)malloc(4 + list->total_length + list->count * 4);
+    if (!output) {
+        handle_out_of_memory("json filter output");
+        return NULL;
+    }
+
+    size_t pos = 0;
+    output[pos++] = '[';
+    for (size_t i = 0; i < list->count; i++) {
+        output[pos++] = '\n';
+        output[pos++] = ' ';
+        output[pos++] = ' ';
+        memcpy(output + pos, list->items[i].text, list->items[i].length);
+        pos += list->items[i].length;
+        if (i + 1 < list->count) {
+            output[pos++] = ',';
+        }
+    }
+    output[pos++] = '\n';
+    output[pos++] = ']';
+    output[pos] = '\0';
+
+    /* small results are worth pretty printing, big ones stay as they came */
+    if (pos < 1024 * 1024) {
+        cJSON* json = cJSON_Parse(output);
+        char* formatted = json ? cJSON_Print(json) : NULL;
+        cJSON_Delete(json);
+        if (formatted) {
+            free(output);
+            output = formatted;
+            pos = strlen(formatted);
+        }
+    }
+
+    *output_size = pos;
+    return output;
+}
+
+/* filters one job, returns false if a newer submission stopped it */
+static bool run_filter_job(JsonFilterRunner* runner, const FilterRunJob* job, JsonFilterResult* result) {
+    memset(result, 0, sizeof(JsonFilterResult));
+    result->generation = job->generation;
+    result->match_count = -1;
+
+    JsonFilterQuery* query = json_filter_cache_acquire(job->expression, result->error, sizeof(result->error));
+    if (!query) {
+        return true;
+    }
+
+    FilterMatchList list;
+    memset(&list, 0, sizeof(list));
+    list.cancel = &runner->cancel;
+    long matched = json_filter_run(query, job->data, job->length, collect_match, &list,
+                                   result->error, sizeof(result->error));
+    json_filter_cache_release(query);
+
+    bool cancelled = atomic_load(&runner->cancel) != 0;
+    /* stopping early on the size cap is reported as truncation, not as a parse error */
+    if (!cancelled && (matched >= 0 || list.truncated)) {
+        result->error[0] = '\0';
+        result->output = join_matches(&list, &result->output_size);
+        if (result->output) {
+            result->match_count = (long)list.count;
+            result->truncated = list.truncated;
+        } else {
+            snprintf(result->error, sizeof(result->error), "Out of memory");
+        }
+    }
+
+    for (size_t i = 0; i < list.count; i++) {
+        free(list.items[i].text);
+    }
+    free(list.items);
+    return !cancelled;
+}
+
+/* worker loop, takes the queued job, filters it and publishes the result */
+static void* json_filter_runner_worker(void* arg) {
+    JsonFilterRunner* runner = (JsonFilterRunner*)arg;
+
+    pthread_mutex_lock(&runner->mutex);
+    while (!runner->shutting_down) {
+        if (!runner->has_queued) {
+            pthread_cond_wait(&runner->cond, &runner->mutex);
+            continue;
+        }
+
+        FilterRunJob job = runner->queued;
+        runner->has_queued = false;
+        runner->has_active = true;
+        atomic_store(&runner->cancel, 0);
+        pthread_mutex_unlock(&runner->mutex);
+
+        JsonFilterResult result;
+        bool finished = run_filter_job(runner, &job, &result);
+        free_run_job(&job);
+
+        pthread_mutex_lock(&runner->mutex);
+        runner->has_active = false;
+        if (finished) {
+            free(runner->result.output);
+            runner->result = result;
+            runner->has_result = true;
+            wake_signal_post();
+        } else {
+            free(result.output);
+        }
+    }
+    pthread_mutex_unlock(&runner->mutex);
+
+    return NULL;
+}
+
+/* creates a runner, the worker thread is started on first use */
+JsonFilterRunner* json_filter_runner_create(void) {
+    JsonFilterRunner* runner = (JsonFilterRunner*)calloc(1, sizeof(JsonFilterRunner));
+    if (!runner) {
+        handle_out_of_memory("json filter runner creation");
+        return NULL;
+    }
+
+    pthread_mutex_init(&runner->mutex, NULL);
+    pthread_cond_init(&runner->cond, NULL);
+    atomic_init(&runner->cancel, 0);
+    return runner;
+}
+
+/* stops the run that is going and frees anything still queued or unread */
+void json_filter_runner_destroy(JsonFilterRunner* runner) {
+    if (!runner) {
+        return;
+    }
+
+    pthread_mutex_lock(&runner->mutex);
+    runner->shutting_down = true;
+    atomic_store(&runner->cancel, 1);
+    pthread_cond_signal(&runner->cond);
+    pthread_mutex_unlock(&runner->mutex);
+
+    if (runner->thread_started) {
+        pthread_join(runner->thread, NULL);
+    }
+
+    if (runner->has_queued) {
+        free_run_job(&runner->queued);
+    }
+    free(runner->result.output);
+
+    pthread_cond_destroy(&runner->cond);
+    pthread_mutex_destroy(&runner->mutex);
+    free(runner);
+}
+
+/* copies the job into the queue slot, replacing anything still waiting */
+int json_filter_runner_submit(JsonFilterRunner* runner, unsigned int generation, const char* expression,
+                              const char* data, size_t length) {
+    if (!runner || !expression || (!data && length > 0)) {
+        return -1;
+    }
+
+    FilterRunJob job;
+    job.generation = generation;
+    job.expression = (char*)malloc(strlen(expression) + 1);
+    job.data = (char*)malloc(length + 1);
+    job.length = length;
+    if (!job.expression || !job.data) {
+        handle_out_of_memory("json filter job");
+        free_run_job(&job);
+        return -1;
+    }
+    strcpy(job.expression, expression);
+    if (length > 0) {
+        memcpy(job.data, data, length);
+    }
+    job.data[length] = '\0';
+
+    pthread_mutex_lock(&runner->mutex);
+
+    if (!runner->thread_started) {
+        if (pthread_create(&runner->thread, NULL, json_filter_runner_worker, runner) != 0) {
+            pthread_mutex_unlock(&runner->mutex);
+            free_run_job(&job);
+            return -1;
+        }
+        runner->thread_started = true;
+    }
+
+    if (runner->has_queued) {
+        free_run_job(&runner->queued);
+    }
+    runner->queued = job;
+    runner->has_queued = true;
+    if (runner->has_active) {
+        atomic_store(&runner->cancel, 1);
+    }
+
+    pthread_cond_signal(&runner->cond);
+    pthread_mutex_unlock(&runner->mutex);
+    return 0;
+}
+
+/* hands the newest finished result to the caller, who frees its output */
+bool json_filter_runner_take_result(JsonFilterRunner* runner, JsonFilterResult* result) {
+    if (!runner || !result) {
+        return false;
+    }
+
+    pthread_mutex_lock(&runner->mutex);
+    bool found = runner->has_result;
+    if (found) {
+        *result = runner->result;
+        runner->result.output = NULL;
+        runner->has_result = false;
+    }
+    pthread_mutex_unlock(&runner->mutex);
+
+    return found;
+}
+
+/* true while a submission is waiting or being filtered */
+bool json_filter_runner_is_pending(JsonFilterRunner* runner) {
+    if (!runner) {
+        return false;
+    }
+
+    pthread_mutex_lock(&runner->mutex);
+    bool pending = runner->has_queued || runner->has_active;
+    pthread_mutex_unlock(&runner->mutex);
+
+    return pending;
+}
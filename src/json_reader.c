@@ -0,0 +1,377 @@
+/**
+ * streaming json reader for tinyrequest
+ *
+ * the reader is a cursor over the raw json text. objects are walked key by
+ * key and each key decides what happens to its value: decoded into a
+ * fixed field, decoded into one malloc'd buffer of the right size for
+ * bodies and request names, or skipped. strings are decoded in a single
+ * pass, a string's raw length is an upper bound for its decoded length so
+ * a body never needs a second buffer.
+ */
+
+#include "json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+void json_reader_init(JsonReader* reader, const char* data, size_t length) {
+    reader->cur = data;
+    reader->end = data + length;
+    reader->failed = false;
+    reader->depth = 0;
+}
+
+void json_reader_fail(JsonReader* reader) {
+    reader->failed = true;
+    reader->cur = reader->end;
+}
+
+/* next character that is not whitespace, 0 at the end */
+char json_reader_peek(JsonReader* reader) {
+    while (reader->cur < reader->end &&
+           (*reader->cur == ' ' || *reader->cur == '\t' || *reader->cur == '\n' || *reader->cur == '\r')) {
+        reader->cur++;
+    }
+    return reader->cur < reader->end ? *reader->cur : '\0';
+}
+
+bool json_reader_consume(JsonReader* reader, char expected) {
+    if (json_reader_peek(reader) != expected) {
+        json_reader_fail(reader);
+        return false;
+    }
+    reader->cur++;
+    return true;
+}
+
+/* cjson matches keys without regard to case, so old files may rely on it */
+bool json_key_is(const char* key, const char* expected) {
+    for (; *key && *expected; key++, expected++) {
+        char a = (*key >= 'A' && *key <= 'Z') ? (char)(*key + 32) : *key;
+        if (a != *expected) {
+            return false;
+        }
+    }
+    return *key == *expected;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(const char* p, const char* end, unsigned int* value) {
+    if (end - p < 4) {
+        return false;
+    }
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        *value = (*value << 4) | (unsigned int)digit;
+    }
+    return true;
+}
+
+/* finds the closing quote of a string whose text starts at start */
+static const char* string_end(const char* start, const char* end) {
+    for (const char* p = start; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/* appends one byte if there is room, the length keeps counting either way */
+static void put_byte(char* dest, size_t dest_size, size_t* length, char c) {
+    if (dest && *length + 1 < dest_size) {
+        dest[*length] = c;
+    }
+    (*length)++;
+}
+
+/* decodes the escapes of a string body into dest, truncating like strncpy into a
+ * fixed field. returns the full decoded length or (size_t)-1 for a bad escape */
+static size_t decode_string(const char* src, const char* src_end, char* dest, size_t dest_size) {
+    size_t length = 0;
+
+    for (const char* p = src; p < src_end; p++) {
+        if (*p != '\\') {
+            put_byte(dest, dest_size, &length, *p);
+            continue;
+        }
+
+        if (++p >= src_end) {
+            return (size_t)-1;
+        }
+        switch (*p) {
+            case '"':  put_byte(dest, dest_size, &length, '"'); break;
+            case '\\': put_byte(dest, dest_size, &length, '\\'); break;
+            case '/':  put_byte(dest, dest_size, &length, '/'); break;
+            case 'b':  put_byte(dest, dest_size, &length, '\b'); break;
+            case 'f':  put_byte(dest, dest_size, &length, '\f'); break;
+            case 'n':  put_byte(dest, dest_size, &length, '\n'); break;
+            case 'r':  put_byte(dest, dest_size, &length, '\r'); break;
+            case 't':  put_byte(dest, dest_size, &length, '\t'); break;
+            case 'u': {
+                unsigned int code = 0;
+                if (!read_hex4(p + 1, src_end, &code)) {
+                    return (size_t)-1;
+                }
+                p += 4;
+
+                /* a high surrogate has to be followed by its low half */
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    unsigned int low = 0;
+                    if (src_end - p < 7 || p[1] != '\\' || p[2] != 'u' || !read_hex4(p + 3, src_end, &low) ||
+                        low < 0xDC00 || low > 0xDFFF) {
+                        return (size_t)-1;
+                    }
+                    p += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return (size_t)-1;
+                }
+
+                if (code < 0x80) {
+                    put_byte(dest, dest_size, &length, (char)code);
+                } else if (code < 0x800) {
+                    put_byte(dest, dest_size, &length, (char)(0xC0 | (code >> 6)));
+                    put_byte(dest, dest_size, &length, (char)(0x80 | (code & 0x3F)));
+                } else if (code < 0x10000) {
+                    put_byte(dest, dest_size, &length, (char)(0xE0 | (code >> 12)));
+                    put_byte(dest, dest_size, &length, (char)(0x80 | ((code >> 6) & 0x3F)));
+                    put_byte(dest, dest_size, &length, (char)(0x80 | (code & 0x3F)));
+                } else {
+                    put_byte(dest, dest_size, &length, (char)(0xF0 | (code >> 18)));
+                    put_byte(dest, dest_size, &length, (char)(0x80 | ((code >> 12) & 0x3F)));
+                    put_byte(dest, dest_size, &length, (char)(0x80 | ((code >> 6) & 0x3F)));
+                    put_byte(dest, dest_size, &length, (char)(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+            default:
+                return (size_t)-1;
+        }
+    }
+
+    if (dest && dest_size > 0) {
+        dest[length < dest_size ? length : dest_size - 1] = '\0';
+    }
+    return length;
+}
+
+/* reads a string into a fixed field, length gets its untruncated size */
+bool json_reader_string(JsonReader* reader, char* dest, size_t dest_size, size_t* length) {
+    if (!json_reader_consume(reader, '"')) {
+        return false;
+    }
+
+    const char* close = string_end(reader->cur, reader->end);
+    if (!close) {
+        json_reader_fail(reader);
+        return false;
+    }
+
+    size_t decoded = decode_string(reader->cur, close, dest, dest_size);
+    if (decoded == (size_t)-1) {
+        json_reader_fail(reader);
+        return false;
+    }
+
+    reader->cur = close + 1;
+    if (length) {
+        *length = decoded;
+    }
+    return true;
+}
+
+/* reads a string into a buffer of its own, the caller frees it */
+char* json_reader_string_alloc(JsonReader* reader, size_t* length) {
+    if (!json_reader_consume(reader, '"')) {
+        return NULL;
+    }
+
+    const char* close = string_end(reader->cur, reader->end);
+    if (!close) {
+        json_reader_fail(reader);
+        return NULL;
+    }
+
+    size_t raw_length = (size_t)(close - reader->cur);
+    char* text = (char*)malloc(raw_length + 1);
+    if (!text) {
+        json_reader_fail(reader);
+        return NULL;
+    }
+
+    size_t decoded = decode_string(reader->cur, close, text, raw_length + 1);
+    if (decoded == (size_t)-1) {
+        free(text);
+        json_reader_fail(reader);
+        return NULL;
+    }
+
+    reader->cur = close + 1;
+    *length = decoded;
+    return text;
+}
+
+static bool json_is_number_start(char c) {
+    return c == '-' || (c >= '0' && c <= '9');
+}
+
+bool json_reader_number(JsonReader* reader, double* value) {
+    json_reader_peek(reader);
+
+    /* the mapping is not terminated, so strtod gets a copy of the token */
+    char token[64];
+    size_t length = 0;
+    while (reader->cur + length < reader->end && length < sizeof(token) - 1) {
+        char c = reader->cur[length];
+        if (!(json_is_number_start(c) || c == '+' || c == '.' || c == 'e' || c == 'E')) {
+            break;
+        }
+        token[length++] = c;
+    }
+    token[length] = '\0';
+
+    char* parsed_end = NULL;
+    double parsed = strtod(token, &parsed_end);
+    if (length == 0 || parsed_end != token + length) {
+        json_reader_fail(reader);
+        return false;
+    }
+
+    reader->cur += length;
+    *value = parsed;
+    return true;
+}
+
+bool json_reader_literal(JsonReader* reader, const char* literal) {
+    size_t length = strlen(literal);
+    json_reader_peek(reader);
+    if ((size_t)(reader->end - reader->cur) < length || memcmp(reader->cur, literal, length) != 0) {
+        json_reader_fail(reader);
+        return false;
+    }
+    reader->cur += length;
+    return true;
+}
+
+/* call right after '{' or '['. moves to the next member, returns false at the closing
+ * bracket or on an error. key may be NULL for arrays */
+bool json_reader_next(JsonReader* reader, char close, bool* first, char* key, size_t key_size) {
+    char c = json_reader_peek(reader);
+    if (c == close) {
+        reader->cur++;
+        return false;
+    }
+
+    if (!*first) {
+        if (c != ',') {
+            json_reader_fail(reader);
+            return false;
+        }
+        reader->cur++;
+    }
+    *first = false;
+
+    if (key) {
+        if (!json_reader_string(reader, key, key_size, NULL) || !json_reader_consume(reader, ':')) {
+            return false;
+        }
+    }
+    return !reader->failed;
+}
+
+bool json_reader_enter(JsonReader* reader, char open) {
+    if (reader->depth >= JSON_READER_MAX_DEPTH) {
+        json_reader_fail(reader);
+        return false;
+    }
+    if (!json_reader_consume(reader, open)) {
+        return false;
+    }
+    reader->depth++;
+    return true;
+}
+
+static void skip_container(JsonReader* reader, char open, char close) {
+    if (!json_reader_enter(reader, open)) {
+        return;
+    }
+
+    bool first = true;
+    char key[8];
+    while (json_reader_next(reader, close, &first, open == '{' ? key : NULL, sizeof(key))) {
+        json_reader_skip(reader);
+    }
+    reader->depth--;
+}
+
+void json_reader_skip(JsonReader* reader) {
+    double number = 0.0;
+
+    switch (json_reader_peek(reader)) {
+        case '"':
+            json_reader_string(reader, NULL, 0, NULL);
+            break;
+        case '{':
+            skip_container(reader, '{', '}');
+            break;
+        case '[':
+            skip_container(reader, '[', ']');
+            break;
+        case 't':
+            json_reader_literal(reader, "true");
+            break;
+        case 'f':
+            json_reader_literal(reader, "false");
+            break;
+        case 'n':
+            json_reader_literal(reader, "null");
+            break;
+        default:
+            json_reader_number(reader, &number);
+            break;
+    }
+}
+
+/* typed reads for object members, a value of another type is skipped and reported as missing */
+bool json_reader_string_field(JsonReader* reader, char* dest, size_t dest_size) {
+    if (json_reader_peek(reader) != '"') {
+        json_reader_skip(reader);
+        return false;
+    }
+    return json_reader_string(reader, dest, dest_size, NULL);
+}
+
+bool json_reader_number_field(JsonReader* reader, double* value) {
+    if (!json_is_number_start(json_reader_peek(reader))) {
+        json_reader_skip(reader);
+        return false;
+    }
+    return json_reader_number(reader, value);
+}
+
+bool json_reader_bool_field(JsonReader* reader, bool* value) {
+    char c = json_reader_peek(reader);
+    if (c == 't' && json_reader_literal(reader, "true")) {
+        *value = true;
+        return true;
+    }
+    if (c == 'f' && json_reader_literal(reader, "false")) {
+        *value = false;
+        return true;
+    }
+    json_reader_skip(reader);
+    return false;
+}
@@ -0,0 +1,504 @@
+/**
+ * background json validation for tinyrequest
+ *
+ * validation does not build a document, it only scans the text and checks
+ * the grammar, so a large body costs one pass and no allocations besides
+ * the copy handed to the worker. open objects and arrays are tracked on a
+ * fixed stack with the same nesting limit cjson uses, which keeps a body
+ * of ten thousand brackets from recursing off the end of the thread stack.
+ *
+ * the worker follows the image decoder: one thread started on first use,
+ * a single queue slot that new submissions overwrite, and a wakeup for the
+ * main loop once a result is ready.
+ */
+
+#include "json_validator.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* matches CJSON_NESTING_LIMIT, anything deeper would not parse at send time either */
+#define JSON_VALIDATOR_MAX_DEPTH 1000
+
+typedef struct {
+    unsigned int generation;
+    char* text;
+    size_t length;
+} JsonValidationJob;
+
+struct JsonValidator {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+    bool shutting_down;
+
+    bool has_queued;
+    JsonValidationJob queued;
+    bool has_active;
+
+    bool has_result;
+    JsonValidationResult result;
+};
+
+/* scanner state for one validation pass */
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t pos;
+    const char* error;
+} JsonScanner;
+
+/* global out-of-memory handler */
+static void (*g_validator_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_validator_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_validator_out_of_memory_handler) {
+        g_validator_out_of_memory_handler(operation);
+    } else {
+        default_validator_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void json_validator_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_validator_out_of_memory_handler = handler;
+}
+
+/* ------------------------------------------------------------------ */
+/* scanning                                                            */
+/* ------------------------------------------------------------------ */
+
+static bool scanner_fail(JsonScanner* scanner, const char* message) {
+    scanner->error = message;
+    return false;
+}
+
+static void skip_whitespace(JsonScanner* scanner) {
+    while (scanner->pos < scanner->length) {
+        char c = scanner->text[scanner->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        scanner->pos++;
+    }
+}
+
+static bool at_end(JsonScanner* scanner) {
+    return scanner->pos >= scanner->length;
+}
+
+static bool is_hex_digit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/* scans a string starting at its opening quote */
+static bool scan_string(JsonScanner* scanner) {
+    scanner->pos++;
+    while (scanner->pos < scanner->length) {
+        unsigned char c = (unsigned char)scanner->text[scanner->pos];
+        if (c == '"') {
+            scanner->pos++;
+            return true;
+        }
+        if (c < 0x20) {
+            return scanner_fail(scanner, "Control character in string");
+        }
+        if (c != '\\') {
+            scanner->pos++;
+            continue;
+        }
+
+        scanner->pos++;
+        if (at_end(scanner)) {
+            break;
+        }
+        char escape = scanner->text[scanner->pos];
+        if (escape == 'u') {
+            for (int i = 1; i <= 4; i++) {
+                if (scanner->pos + i >= scanner->length) {
+                    scanner->pos = scanner->length;
+                    return scanner_fail(scanner, "Unterminated string");
+                }
+                if (!is_hex_digit(scanner->text[scanner->pos + i])) {
+                    scanner->pos += i;
+                    return scanner_fail(scanner, "Invalid \\u escape in string");
+                }
+            }
+            scanner->pos += 5;
+        } else if (escape != '\0' && strchr("\"\\/bfnrt", escape)) {
+            scanner->pos++;
+        } else {
+            return scanner_fail(scanner, "Invalid escape in string");
+        }
+    }
+    return scanner_fail(scanner, "Unterminated string");
+}
+
+/* scans a number, leading zeros and bare signs are rejected like the spec says */
+static bool scan_number(JsonScanner* scanner) {
+    const char* text = scanner->text;
+
+    if (text[scanner->pos] == '-') {
+        scanner->pos++;
+    }
+    if (at_end(scanner) || !is_digit(text[scanner->pos])) {
+        return scanner_fail(scanner, "Invalid number");
+    }
+    if (text[scanner->pos] == '0') {
+        scanner->pos++;
+    } else {
+        while (!at_end(scanner) && is_digit(text[scanner->pos])) {
+            scanner->pos++;
+        }
+    }
+
+    if (!at_end(scanner) && text[scanner->pos] == '.') {
+        scanner->pos++;
+        if (at_end(scanner) || !is_digit(text[scanner->pos])) {
+            return scanner_fail(scanner, "Expected digits after decimal point");
+        }
+        while (!at_end(scanner) && is_digit(text[scanner->pos])) {
+            scanner->pos++;
+        }
+    }
+
+    if (!at_end(scanner) && (text[scanner->pos] == 'e' || text[scanner->pos] == 'E')) {
+        scanner->pos++;
+        if (!at_end(scanner) && (text[scanner->pos] == '+' || text[scanner->pos] == '-')) {
+            scanner->pos++;
+        }
+        if (at_end(scanner) || !is_digit(text[scanner->pos])) {
+            return scanner_fail(scanner, "Expected digits in exponent");
+        }
+        while (!at_end(scanner) && is_digit(text[scanner->pos])) {
+            scanner->pos++;
+        }
+    }
+    return true;
+}
+
+static bool scan_literal(JsonScanner* scanner, const char* literal) {
+    size_t length = strlen(literal);
+    for (size_t i = 0; i < length; i++) {
+        if (scanner->pos >= scanner->length) {
+            return scanner_fail(scanner, "Unexpected end of input");
+        }
+        if (scanner->text[scanner->pos] != literal[i]) {
+            return scanner_fail(scanner, "Invalid literal, expected true, false or null");
+        }
+        scanner->pos++;
+    }
+    return true;
+}
+
+/* scans an object key and the colon after it */
+static bool scan_key(JsonScanner* scanner) {
+    skip_whitespace(scanner);
+    if (at_end(scanner)) {
+        return scanner_fail(scanner, "Unexpected end of input");
+    }
+    if (scanner->text[scanner->pos] != '"') {
+        return scanner_fail(scanner, "Expected string key");
+    }
+    if (!scan_string(scanner)) {
+        return false;
+    }
+    skip_whitespace(scanner);
+    if (at_end(scanner)) {
+        return scanner_fail(scanner, "Unexpected end of input");
+    }
+    if (scanner->text[scanner->pos] != ':') {
+        return scanner_fail(scanner, "Expected ':' after object key");
+    }
+    scanner->pos++;
+    return true;
+}
+
+/* checks a whole document, on failure scanner->pos is where it went wrong */
+static bool scan_document(JsonScanner* scanner) {
+    char stack[JSON_VALIDATOR_MAX_DEPTH];
+    int depth = 0;
+
+    for (;;) {
+        /* a value is expected here */
+        skip_whitespace(scanner);
+        if (at_end(scanner)) {
+            return scanner_fail(scanner, "Unexpected end of input");
+        }
+
+        char c = scanner->text[scanner->pos];
+        bool opened = false;
+        if (c == '{' || c == '[') {
+            scanner->pos++;
+            skip_whitespace(scanner);
+            char close = c == '{' ? '}' : ']';
+            if (!at_end(scanner) && scanner->text[scanner->pos] == close) {
+                scanner->pos++;
+            } else {
+                if (depth >= JSON_VALIDATOR_MAX_DEPTH) {
+                    return scanner_fail(scanner, "Nesting too deep");
+                }
+                stack[depth++] = c;
+                opened = true;
+                if (c == '{' && !scan_key(scanner)) {
+                    return false;
+                }
+            }
+        } else if (c == '"') {
+            if (!scan_string(scanner)) {
+                return false;
+            }
+        } else if (c == '-' || is_digit(c)) {
+            if (!scan_number(scanner)) {
+                return false;
+            }
+        } else if (c == 't') {
+            if (!scan_literal(scanner, "true")) {
+                return false;
+            }
+        } else if (c == 'f') {
+            if (!scan_literal(scanner, "false")) {
+                return false;
+            }
+        } else if (c == 'n') {
+            if (!scan_literal(scanner, "null")) {
+                return false;
+            }
+        } else {
+            return scanner_fail(scanner, "Unexpected character");
+        }
+
+        if (opened) {
+            continue;
+        }
+
+        /* a value just ended, close containers until one wants another element */
+        for (;;) {
+            skip_whitespace(scanner);
+            if (depth == 0) {
+                if (!at_end(scanner)) {
+                    return scanner_fail(scanner, "Unexpected data after JSON value");
+                }
+                return true;
+            }
+            if (at_end(scanner)) {
+                return scanner_fail(scanner, "Unexpected end of input");
+            }
+
+            char top = stack[depth - 1];
+            c = scanner->text[scanner->pos];
+            if (c == ',') {
+                scanner->pos++;
+                if (top == '{' && !scan_key(scanner)) {
+                    return false;
+                }
+                break;
+            }
+            if ((top == '{' && c == '}') || (top == '[' && c == ']')) {
+                scanner->pos++;
+                depth--;
+                continue;
+            }
+            return scanner_fail(scanner, top == '{' ? "Expected ',' or '}'" : "Expected ',' or ']'");
+        }
+    }
+}
+
+/* validates on the calling thread */
+void json_validate_text(const char* text, size_t length, JsonValidationResult* result) {
+    if (!result) {
+        return;
+    }
+
+    unsigned int generation = result->generation;
+    memset(result, 0, sizeof(JsonValidationResult));
+    result->generation = generation;
+
+    JsonScanner scanner = {text ? text : "", text ? length : 0, 0, NULL};
+    if (scan_document(&scanner)) {
+        result->valid = true;
+        return;
+    }
+
+    size_t offset = scanner.pos < scanner.length ? scanner.pos : scanner.length;
+    result->error_offset = offset;
+
+    int line = 1;
+    size_t line_start = 0;
+    const char* cursor = scanner.text;
+    const char* end = scanner.text + offset;
+    while (cursor < end) {
+        const char* newline = (const char*)memchr(cursor, '\n', (size_t)(end - cursor));
+        if (!newline) {
+            break;
+        }
+        line++;
+        line_start = (size_t)(newline - scanner.text) + 1;
+        cursor = newline + 1;
+    }
+    result->error_line = line;
+    result->error_column = (int)(offset - line_start) + 1;
+
+    unsigned char bad = offset < scanner.length ? (unsigned char)scanner.text[offset] : 0;
+    if (strcmp(scanner.error, "Unexpected character") == 0 && bad >= 0x20 && bad < 0x7f) {
+        snprintf(result->message, sizeof(result->message), "Unexpected character '%c'", bad);
+    } else {
+        snprintf(result->message, sizeof(result->message), "%s", scanner.error);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* worker                                                              */
+/* ------------------------------------------------------------------ */
+
+/* worker loop, takes the queued text, scans it and publishes the result */
+static void* json_validator_worker(void* arg) {
+    JsonValidator* validator = (JsonValidator*)arg;
+
+    pthread_mutex_lock(&validator->mutex);
+    while (!validator->shutting_down) {
+        if (!validator->has_queued) {
+            pthread_cond_wait(&validator->cond, &validator->mutex);
+            continue;
+        }
+
+        JsonValidationJob job = validator->queued;
+        validator->has_queued = false;
+        validator->has_active = true;
+        pthread_mutex_unlock(&validator->mutex);
+
+        JsonValidationResult result;
+        result.generation = job.generation;
+        json_validate_text(job.text, job.length, &result);
+        free(job.text);
+
+        pthread_mutex_lock(&validator->mutex);
+        validator->has_active = false;
+        validator->result = result;
+        validator->has_result = true;
+        wake_signal_post();
+    }
+    pthread_mutex_unlock(&validator->mutex);
+
+    return NULL;
+}
+
+/* creates a validator, the worker thread is started on first use */
+JsonValidator* json_validator_create(void) {
+    JsonValidator* validator = (JsonValidator*)calloc(1, sizeof(JsonValidator));
+    if (!validator) {
+        handle_out_of_memory("json validator creation");
+        return NULL;
+    }
+
+    pthread_mutex_init(&validator->mutex, NULL);
+    pthread_cond_init(&validator->cond, NULL);
+    return validator;
+}
+
+/* stops the worker and frees anything still queued */
+void json_validator_destroy(JsonValidator* validator) {
+    if (!validator) {
+        return;
+    }
+
+    pthread_mutex_lock(&validator->mutex);
+    validator->shutting_down = true;
+    pthread_cond_signal(&validator->cond);
+    pthread_mutex_unlock(&validator->mutex);
+
+    if (validator->thread_started) {
+        pthread_join(validator->thread, NULL);
+    }
+
+    if (validator->has_queued) {
+        free(validator->queued.text);
+    }
+
+    pthread_cond_destroy(&validator->cond);
+    pthread_mutex_destroy(&validator->mutex);
+    free(validator);
+}
+
+/* copies the text into the queue slot, replacing anything still waiting */
+int json_validator_submit(JsonValidator* validator, unsigned int generation, const char* text, size_t length) {
+    if (!validator || (!text && length > 0)) {
+        return -1;
+    }
+
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) {
+        handle_out_of_memory("json validation job");
+        return -1;
+    }
+    if (length > 0) {
+        memcpy(copy, text, length);
+    }
+    copy[length] = '\0';
+
+    pthread_mutex_lock(&validator->mutex);
+
+    if (!validator->thread_started) {
+        if (pthread_create(&validator->thread, NULL, json_validator_worker, validator) != 0) {
+            pthread_mutex_unlock(&validator->mutex);
+            free(copy);
+            return -1;
+        }
+        validator->thread_started = true;
+    }
+
+    if (validator->has_queued) {
+        free(validator->queued.text);
+    }
+    validator->queued.generation = generation;
+    validator->queued.text = copy;
+    validator->queued.length = length;
+    validator->has_queued = true;
+
+    pthread_cond_signal(&validator->cond);
+    pthread_mutex_unlock(&validator->mutex);
+    return 0;
+}
+
+/* copies the newest finished result */
+bool json_validator_get_result(JsonValidator* validator, JsonValidationResult* result) {
+    if (!validator || !result) {
+        return false;
+    }
+
+    pthread_mutex_lock(&validator->mutex);
+    bool found = validator->has_result;
+    if (found) {
+        *result = validator->result;
+    }
+    pthread_mutex_unlock(&validator->mutex);
+
+    return found;
+}
+
+/* true while a submission is waiting or being scanned */
+bool json_validator_is_pending(JsonValidator* validator) {
+    if (!validator) {
+        return false;
+    }
+
+    pthread_mutex_lock(&validator->mutex);
+    bool pending = validator->has_queued || validator->has_active;
+    pthread_mutex_unlock(&validator->mutex);
+
+    return pending;
+}
@@ -0,0 +1,989 @@
+/**
+ * local mock http server for tinyrequest
+ *
+ * built on the bundled cpp-httplib. one handler, registered for every path
+ * of every method httplib knows, answers everything. the routes are a
+ * plain array that is only read once the server runs, so answering takes
+ * no lock until the counters are updated.
+ */
+
+#include "mock_server.h"
+#include "wake_signal.h"
+#include "cJSON.h"
+
+/* httplib queues 5 connections by default, a load test opens one per
+ * worker at once and the rest would wait out a syn retry */
+#define CPPHTTPLIB_LISTEN_BACKLOG 128
+#include "httplib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+
+/* the ui is woken at most this often while requests come in */
+#define MOCK_WAKE_MS 100.0
+
+/* a held back response checks this often whether the server is stopping */
+#define MOCK_DELAY_SLICE_MS 50
+
+#define MOCK_MAX_PARAMS 16
+
+typedef struct {
+    char method[16];
+    char path[512];
+    HeaderList query;           /* what the url's query string asks for */
+    int literal_segments;
+    bool has_example;
+    int status_code;
+    HeaderList headers;
+    char* body;
+    size_t body_size;
+    bool body_is_template;
+    char content_type[512];     /* as long as a header value */
+    uint64_t hits;
+} MockRoute;
+
+struct MockServer {
+    MockServerOptions options;
+    MockRoute* routes;
+    int route_count;
+    int route_capacity;
+    httplib::Server* http;
+    pthread_t thread;
+    bool thread_started;
+    int port;
+    volatile bool stopping;
+    pthread_mutex_t mutex;
+    uint64_t next_seq;
+    MockServerStats stats;
+    double last_wake_ms;
+};
+
+typedef struct {
+    char name[64];
+    std::string value;
+} MockParam;
+
+typedef struct {
+    const httplib::Request* request;
+    uint64_t seq;
+    MockParam params[MOCK_MAX_PARAMS];
+    int param_count;
+} MockTemplateContext;
+
+extern "C" {
+
+/* global out-of-memory handler */
+static void (*g_mock_server_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_mock_server_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_mock_server_out_of_memory_handler) {
+        g_mock_server_out_of_memory_handler(operation);
+    } else {
+        default_mock_server_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void mock_server_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_mock_server_out_of_memory_handler = handler;
+}
+
+}
+
+static double mock_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int64_t mock_unix_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* splitmix64, spreads the seed and arrival number into an even draw */
+static uint64_t mock_mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+/* memmem, which windows does not have */
+static const char* find_bytes(const char* data, size_t length, const char* needle, size_t needle_length) {
+    for (size_t i = 0; i + needle_length <= length; i++) {
+        if (data[i] == needle[0] && memcmp(data + i, needle, needle_length) == 0) {
+            return data + i;
+        }
+    }
+    return NULL;
+}
+
+/* --- paths --- */
+
+/* the path of a url, without scheme, host, query or fragment */
+static void url_path(const char* url, char* path, size_t path_size, const char** query) {
+    const char* start = strstr(url, "://");
+    start = start ? strchr(start + 3, '/') : strchr(url, '/');
+    *query = NULL;
+
+    size_t length = 0;
+    if (start) {
+        length = strcspn(start, "?#");
+        if (start[length] == '?') {
+            *query = start + length + 1;
+        }
+    } else {
+        const char* mark = strchr(url, '?');
+        if (mark) {
+            *query = mark + 1;
+        }
+    }
+
+    if (length == 0) {
+        snprintf(path, path_size, "/");
+    } else {
+        snprintf(path, path_size, "%.*s", (int)length, start);
+    }
+}
+
+/* the next non-empty segment from *cursor, false at the end of the path */
+static bool next_segment(const char** cursor, const char** segment, size_t* length) {
+    const char* p = *cursor;
+    while (*p == '/') {
+        p++;
+    }
+    if (*p == '\0') {
+        *cursor = p;
+        return false;
+    }
+    *segment = p;
+    while (*p != '\0' && *p != '/') {
+        p++;
+    }
+    *length = (size_t)(p - *segment);
+    *cursor = p;
+    return true;
+}
+
+/* ":id", "{id}" and "{{id}}" match any segment. writes the name when it is one */
+static bool segment_parameter(const char* segment, size_t length, char* name, size_t name_size) {
+    size_t skip = 0;
+    size_t trail = 0;
+    if (length > 1 && segment[0] == ':') {
+        skip = 1;
+    } else if (length > 4 && strncmp(segment, "{{", 2) == 0 && strncmp(segment + length - 2, "}}", 2) == 0) {
+        skip = trail = 2;
+    } else if (length > 2 && segment[0] == '{' && segment[length - 1] == '}') {
+        skip = trail = 1;
+    } else {
+        return false;
+    }
+
+    if (name) {
+        snprintf(name, name_size, "%.*s", (int)(length - skip - trail), segment + skip);
+    }
+    return true;
+}
+
+static bool value_is_parameter(const char* value) {
+    return segment_parameter(value, strlen(value), NULL, 0);
+}
+
+static int count_literal_segments(const char* path) {
+    const char* cursor = path;
+    const char* segment = NULL;
+    size_t length = 0;
+    int count = 0;
+    while (next_segment(&cursor, &segment, &length)) {
+        count += !segment_parameter(segment, length, NULL, 0);
+    }
+    return count;
+}
+
+/* splits a query string into name and value pairs, decoded the way the
+ * server decodes the query of a request */
+static void parse_query(const char* query, HeaderList* list) {
+    while (query && *query != '\0' && *query != '#') {
+        size_t length = strcspn(query, "&#");
+        const char* equals = (const char*)memchr(query, '=', length);
+        size_t name_length = equals ? (size_t)(equals - query) : length;
+
+        std::string name = httplib::detail::decode_path(std::string(query, name_length), true);
+        std::string value = equals ? httplib::detail::decode_path(std::string(equals + 1, length - name_length - 1), true)
+                                   : std::string();
+        if (!name.empty()) {
+            header_list_add(list, name.c_str(), value.c_str());
+        }
+
+        query += length;
+        if (*query == '&') {
+            query++;
+        }
+    }
+}
+
+/* whether the route takes the request, filling in its path parameters */
+static bool route_matches(const MockRoute* route, const httplib::Request& request, MockTemplateContext* context) {
+    /* httplib answers HEAD with the GET handler and leaves the body out */
+    if (strcasecmp(route->method, request.method.c_str()) != 0 &&
+        !(request.method == "HEAD" && strcmp(route->method, "GET") == 0)) {
+        return false;
+    }
+
+    context->param_count = 0;
+    const char* route_cursor = route->path;
+    const char* request_cursor = request.path.c_str();
+    const char* route_segment = NULL;
+    const char* request_segment = NULL;
+    size_t route_length = 0;
+    size_t request_length = 0;
+
+    for (;;) {
+        bool more_route = next_segment(&route_cursor, &route_segment, &route_length);
+        bool more_request = next_segment(&request_cursor, &request_segment, &request_length);
+        if (!more_route || !more_request) {
+            if (more_route || more_request) {
+                return false;
+            }
+            break;
+        }
+
+        char name[64];
+        if (segment_parameter(route_segment, route_length, name, sizeof(name))) {
+            if (context->param_count < MOCK_MAX_PARAMS) {
+                MockParam* param = &context->params[context->param_count++];
+                snprintf(param->name, sizeof(param->name), "%s", name);
+                param->value.assign(request_segment, request_length);
+            }
+        } else if (route_length != request_length || memcmp(route_segment, request_segment, route_length) != 0) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < route->query.count; i++) {
+        const Header* pair = &route->query.headers[i];
+        if (!request.has_param(pair->name)) {
+            return false;
+        }
+        if (!value_is_parameter(pair->value) && request.get_param_value(pair->name) != pair->value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* the matching route with the most literal segments, then the most query
+ * values, then one with an example, then the first added */
+static int find_route(MockServer* server, const httplib::Request& request, MockTemplateContext* context) {
+    int best = -1;
+    MockTemplateContext candidate;
+    candidate.request = context->request;
+    candidate.seq = context->seq;
+
+    for (int i = 0; i < server->route_count; i++) {
+        const MockRoute* route = &server->routes[i];
+        if (!route_matches(route, request, &candidate)) {
+            continue;
+        }
+
+        if (best >= 0) {
+            const MockRoute* current = &server->routes[best];
+            if (route->literal_segments != current->literal_segments) {
+                if (route->literal_segments < current->literal_segments) {
+                    continue;
+                }
+            } else if (route->query.count != current->query.count) {
+                if (route->query.count < current->query.count) {
+                    continue;
+                }
+            } else if (route->has_example == current->has_example || !route->has_example) {
+                continue;
+            }
+        }
+
+        best = i;
+        context->param_count = candidate.param_count;
+        for (int p = 0; p < candidate.param_count; p++) {
+            snprintf(context->params[p].name, sizeof(context->params[p].name), "%s", candidate.params[p].name);
+            context->params[p].value = candidate.params[p].value;
+        }
+    }
+    return best;
+}
+
+/* --- templates --- */
+
+static bool content_type_is_text(const char* content_type) {
+    if (content_type[0] == '\0') {
+        return true;
+    }
+    return strncasecmp(content_type, "text/", 5) == 0 || strstr(content_type, "json") != NULL ||
+           strstr(content_type, "xml") != NULL || strstr(content_type, "javascript") != NULL ||
+           strstr(content_type, "x-www-form-urlencoded") != NULL;
+}
+
+/* what a placeholder stands for, false when it is not one */
+static bool template_value(const MockTemplateContext* context, const char* key, size_t length, std::string& out) {
+    const httplib::Request& request = *context->request;
+    std::string name(key, length);
+
+    if (name == "method") {
+        out += request.method;
+    } else if (name == "path") {
+        out += request.path;
+    } else if (name == "body") {
+        out += request.body;
+    } else if (name == "now") {
+        out += std::to_string(mock_unix_ms());
+    } else if (name == "seq") {
+        out += std::to_string(context->seq);
+    } else if (name.compare(0, 7, "params.") == 0) {
+        for (int i = 0; i < context->param_count; i++) {
+            if (name.compare(7, std::string::npos, context->params[i].name) == 0) {
+                out += context->params[i].value;
+                break;
+            }
+        }
+    } else if (name.compare(0, 6, "query.") == 0) {
+        out += request.get_param_value(name.substr(6));
+    } else if (name.compare(0, 7, "header.") == 0) {
+        out += request.get_header_value(name.substr(7));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static std::string render_template(const MockTemplateContext* context, const char* text, size_t length) {
+    std::string out;
+    out.reserve(length);
+
+    size_t i = 0;
+    while (i < length) {
+        const char* open = find_bytes(text + i, length - i, "{{", 2);
+        if (!open) {
+            out.append(text + i, length - i);
+            break;
+        }
+
+        size_t start = (size_t)(open - text);
+        const char* close = find_bytes(open + 2, length - start - 2, "}}", 2);
+        if (!close) {
+            out.append(text + i, length - i);
+            break;
+        }
+
+        out.append(text + i, start - i);
+        const char* key = open + 2;
+        size_t key_length = (size_t)(close - key);
+        while (key_length > 0 && isspace((unsigned char)*key)) {
+            key++;
+            key_length--;
+        }
+        while (key_length > 0 && isspace((unsigned char)key[key_length - 1])) {
+            key_length--;
+        }
+
+        if (!template_value(context, key, key_length, out)) {
+            out.append(open, (size_t)(close + 2 - open));
+        }
+        i = (size_t)(close + 2 - text);
+    }
+    return out;
+}
+
+/* --- answering --- */
+
+/* headers the server writes itself or that no longer fit the stored body */
+static bool header_is_hop_by_hop(const char* name) {
+    static const char* const skipped[] = {
+        "content-length", "transfer-encoding", "connection", "keep-alive", "content-encoding", "content-type"
+    };
+    for (size_t i = 0; i < sizeof(skipped) / sizeof(skipped[0]); i++) {
+        if (strcasecmp(name, skipped[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* holds the response back in slices so stopping the server is not held up */
+static void mock_delay(MockServer* server, int delay_ms) {
+    while (delay_ms > 0 && !server->stopping) {
+        int slice = delay_ms < MOCK_DELAY_SLICE_MS ? delay_ms : MOCK_DELAY_SLICE_MS;
+        struct timespec ts = { 0, (long)slice * 1000000L };
+        nanosleep(&ts, NULL);
+        delay_ms -= slice;
+    }
+}
+
+static void answer_route(const MockRoute* route, const MockTemplateContext* context, httplib::Response& response) {
+    response.status = route->has_example ? route->status_code : 200;
+
+    for (int i = 0; i < route->headers.count; i++) {
+        const Header* header = &route->headers.headers[i];
+        if (header_is_hop_by_hop(header->name)) {
+            continue;
+        }
+        if (strstr(header->value, "{{")) {
+            response.set_header(header->name, render_template(context, header->value, strlen(header->value)));
+        } else {
+            response.set_header(header->name, header->value);
+        }
+    }
+
+    const char* content_type = route->content_type[0] ? route->content_type : "text/plain";
+    if (route->body_is_template) {
+        response.set_content(render_template(context, route->body, route->body_size), content_type);
+    } else if (route->body_size > 0) {
+        response.set_content(route->body, route->body_size, content_type);
+    }
+}
+
+static void handle_request(MockServer* server, const httplib::Request& request,
+                                                       httplib::Response& response) {
+    MockTemplateContext context;
+    context.request = &request;
+
+    pthread_mutex_lock(&server->mutex);
+    context.seq = ++server->next_seq;
+    pthread_mutex_unlock(&server->mutex);
+
+    int route_index = find_route(server, request, &context);
+
+    /* the draws depend on nothing but the seed and the arrival number */
+    uint64_t draw = mock_mix(server->options.seed ^ context.seq);
+    bool inject_error = server->options.error_rate > 0.0 &&
+                        (double)(draw >> 11) / (double)(1ull << 53) < server->options.error_rate;
+    int delay_ms = server->options.latency_ms;
+    if (server->options.jitter_ms > 0) {
+        delay_ms += (int)(mock_mix(draw) % (uint64_t)(server->options.jitter_ms + 1));
+    }
+    mock_delay(server, delay_ms);
+
+    if (inject_error) {
+        response.status = server->options.error_status;
+        response.set_content("{\"error\":\"injected by the tinyrequest mock server\"}", "application/json");
+    } else if (route_index >= 0) {
+        answer_route(&server->routes[route_index], &context, response);
+    } else {
+        response.status = 404;
+        response.set_content("no route for " + request.method + " " + request.path + "\n", "text/plain");
+    }
+    response.set_header("X-Mock-Seq", std::to_string(context.seq));
+
+    pthread_mutex_lock(&server->mutex);
+    server->stats.requests++;
+    if (route_index >= 0) {
+        server->stats.matched++;
+        server->routes[route_index].hits++;
+    } else {
+        server->stats.unmatched++;
+    }
+    server->stats.errors_injected += inject_error;
+    double now = mock_now_ms();
+    bool wake = now - server->last_wake_ms >= MOCK_WAKE_MS;
+    if (wake) {
+        server->last_wake_ms = now;
+    }
+    pthread_mutex_unlock(&server->mutex);
+
+    if (wake) {
+        wake_signal_post();
+    }
+}
+
+static void* server_thread_main(void* arg) {
+    MockServer* server = (MockServer*)arg;
+    server->http->listen_after_bind();
+    wake_signal_post();
+    return NULL;
+}
+
+/* --- routes --- */
+
+static void route_cleanup(MockRoute* route) {
+    header_list_cleanup(&route->query);
+    header_list_cleanup(&route->headers);
+    free(route->body);
+    route->body = NULL;
+}
+
+/* copies an example into the route, the route is left as it was on failure */
+static int route_set_example(MockRoute* route, const Response* example) {
+    char* body = NULL;
+    if (example->body_size > 0) {
+        body = (char*)malloc(example->body_size);
+        if (!body) {
+            handle_out_of_memory("mock route body");
+            return MOCK_SERVER_ERROR_MEMORY_ALLOCATION;
+        }
+        memcpy(body, example->body, example->body_size);
+    }
+
+    HeaderList headers;
+    header_list_init(&headers);
+    const char* content_type = "";
+    for (int i = 0; i < example->headers.count; i++) {
+        const Header* header = &example->headers.headers[i];
+        if (strcasecmp(header->name, "content-type") == 0) {
+            content_type = header->value;
+        }
+        /* headers the list does not take, too long or with line breaks, are left out */
+        if (header_list_add(&headers, header->name, header->value) == REQUEST_RESPONSE_ERROR_MEMORY_ALLOCATION) {
+            header_list_cleanup(&headers);
+            free(body);
+            return MOCK_SERVER_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+
+    header_list_cleanup(&route->headers);
+    free(route->body);
+    route->headers = headers;
+    route->body = body;
+    route->body_size = example->body_size;
+    route->has_example = true;
+    route->status_code = example->status_code > 0 ? example->status_code : 200;
+    snprintf(route->content_type, sizeof(route->content_type), "%s", content_type);
+    route->body_is_template = body && content_type_is_text(content_type) &&
+                              find_bytes(body, example->body_size, "{{", 2) != NULL;
+    return MOCK_SERVER_SUCCESS;
+}
+
+static int find_route_by_method_path(MockServer* server, const char* method, const char* path, const HeaderList* query) {
+    for (int i = 0; i < server->route_count; i++) {
+        const MockRoute* route = &server->routes[i];
+        if (strcasecmp(route->method, method) != 0 || strcmp(route->path, path) != 0 ||
+            route->query.count != query->count) {
+            continue;
+        }
+        bool same = true;
+        for (int q = 0; q < query->count && same; q++) {
+            same = strcmp(route->query.headers[q].name, query->headers[q].name) == 0 &&
+                   strcmp(route->query.headers[q].value, query->headers[q].value) == 0;
+        }
+        if (same) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+extern "C" {
+
+void mock_server_options_init(MockServerOptions* options) {
+    if (!options) {
+        return;
+    }
+    memset(options, 0, sizeof(MockServerOptions));
+    snprintf(options->host, sizeof(options->host), "127.0.0.1");
+    options->port = MOCK_SERVER_DEFAULT_PORT;
+    options->threads = MOCK_SERVER_DEFAULT_THREADS;
+    options->error_status = 503;
+    options->seed = 1;
+}
+
+MockServer* mock_server_create(const MockServerOptions* options) {
+    MockServerOptions defaults;
+    if (!options) {
+        mock_server_options_init(&defaults);
+        options = &defaults;
+    }
+
+    if (options->port < 0 || options->port > 65535 || options->threads < 1 ||
+        options->threads > MOCK_SERVER_MAX_THREADS || options->latency_ms < 0 || options->jitter_ms < 0 ||
+        options->latency_ms + options->jitter_ms > MOCK_SERVER_MAX_DELAY_MS || options->error_rate < 0.0 ||
+        options->error_rate > 1.0 || options->error_status < 100 || options->error_status > 599 ||
+        options->host[0] == '\0') {
+        return NULL;
+    }
+
+    MockServer* server = (MockServer*)calloc(1, sizeof(MockServer));
+    if (!server) {
+        handle_out_of_memory("mock server");
+        return NULL;
+    }
+
+    server->options = *options;
+    pthread_mutex_init(&server->mutex, NULL);
+    return server;
+}
+
+void mock_server_destroy(MockServer* server) {
+    if (!server) {
+        return;
+    }
+
+    if (server->http) {
+        server->stopping = true;
+        server->http->stop();
+        if (server->thread_started) {
+            pthread_join(server->thread, NULL);
+        }
+        delete server->http;
+    }
+
+    for (int i = 0; i < server->route_count; i++) {
+        route_cleanup(&server->routes[i]);
+    }
+    free(server->routes);
+    pthread_mutex_destroy(&server->mutex);
+    free(server);
+}
+
+int mock_server_add_route(MockServer* server, const char* method, const char* url, const Response* example) {
+    if (!server || !method || !url) {
+        return MOCK_SERVER_ERROR_NULL_PARAM;
+    }
+    if (server->http) {
+        return MOCK_SERVER_ERROR_RUNNING;
+    }
+
+    char path[512];
+    const char* query_string = NULL;
+    url_path(url, path, sizeof(path), &query_string);
+
+    HeaderList query;
+    header_list_init(&query);
+    parse_query(query_string, &query);
+
+    /* the same request twice is one route, the newer example wins */
+    int existing = find_route_by_method_path(server, method, path, &query);
+    if (existing >= 0) {
+        header_list_cleanup(&query);
+        return example ? route_set_example(&server->routes[existing], example) : MOCK_SERVER_SUCCESS;
+    }
+
+    if (server->route_count == server->route_capacity) {
+        int capacity = server->route_capacity == 0 ? 16 : server->route_capacity * 2;
+        MockRoute* routes = (MockRoute*)realloc(server->routes, (size_t)capacity * sizeof(MockRoute));
+        if (!routes) {
+            handle_out_of_memory("mock routes");
+            header_list_cleanup(&query);
+            return MOCK_SERVER_ERROR_MEMORY_ALLOCATION;
+        }
+        server->routes = routes;
+        server->route_capacity = capacity;
+    }
+
+    MockRoute* route = &server->routes[server->route_count];
+    memset(route, 0, sizeof(MockRoute));
+    snprintf(route->method, sizeof(route->method), "%s", method);
+    for (char* p = route->method; *p; p++) {
+        *p = (char)toupper((unsigned char)*p);
+    }
+    snprintf(route->path, sizeof(route->path), "%s", path);
+    route->query = query;
+    route->literal_segments = count_literal_segments(path);
+    route->status_code = 200;
+    header_list_init(&route->headers);
+
+    if (example) {
+        int result = route_set_example(route, example);
+        if (result != MOCK_SERVER_SUCCESS) {
+            route_cleanup(route);
+            return result;
+        }
+    }
+
+    server->route_count++;
+    return MOCK_SERVER_SUCCESS;
+}
+
+int mock_server_add_collection(MockServer* server, Collection* collection, HistoryStore* history) {
+    if (!server || !collection) {
+        return MOCK_SERVER_ERROR_NULL_PARAM;
+    }
+
+    bool examples = history && history_store_is_ready(history);
+    for (int i = 0; i < collection->request_count; i++) {
+        const Request* request = &collection->requests[i];
+
+        HistoryEntry entry;
+        bool found = false;
+        uint64_t id = 0;
+        if (examples && history_store_find_url(history, request->url, &id, 1) == 1) {
+            found = history_store_read_entry(history, id, &entry) == 0 && entry.summary.result == 0;
+            if (!found) {
+                history_entry_cleanup(&entry);
+            }
+        }
+
+        int result = mock_server_add_route(server, request->method, request->url, found ? &entry.response : NULL);
+        if (found) {
+            history_entry_cleanup(&entry);
+        }
+        if (result != MOCK_SERVER_SUCCESS) {
+            return result;
+        }
+    }
+    return MOCK_SERVER_SUCCESS;
+}
+
+}
+
+static int base64_value(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+/* decodes in place, skipping whitespace and padding. returns the length */
+static size_t base64_decode_in_place(char* text) {
+    size_t out = 0;
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (const char* p = text; *p; p++) {
+        int value = base64_value((unsigned char)*p);
+        if (value < 0) {
+            continue;
+        }
+        bits = (bits << 6) | (uint32_t)value;
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            text[out++] = (char)((bits >> bit_count) & 0xff);
+        }
+    }
+    return out;
+}
+
+/* the response of one HAR entry, false when it has none worth serving */
+static bool har_entry_response(cJSON* json, Response* response) {
+    cJSON* status = cJSON_GetObjectItemCaseSensitive(json, "status");
+    if (!cJSON_IsNumber(status) || status->valueint <= 0) {
+        return false;
+    }
+    response->status_code = status->valueint;
+
+    cJSON* header = NULL;
+    cJSON_ArrayForEach(header, cJSON_GetObjectItemCaseSensitive(json, "headers")) {
+        cJSON* name = cJSON_GetObjectItemCaseSensitive(header, "name");
+        cJSON* value = cJSON_GetObjectItemCaseSensitive(header, "value");
+        if (cJSON_IsString(name) && cJSON_IsString(value) && name->valuestring[0] != ':') {
+            header_list_add(&response->headers, name->valuestring, value->valuestring);
+        }
+    }
+
+    cJSON* content = cJSON_GetObjectItemCaseSensitive(json, "content");
+    cJSON* text = cJSON_GetObjectItemCaseSensitive(content, "text");
+    cJSON* mime_type = cJSON_GetObjectItemCaseSensitive(content, "mimeType");
+    if (cJSON_IsString(mime_type) && mime_type->valuestring[0] != '\0' &&
+        header_list_find(&response->headers, "Content-Type") < 0) {
+        header_list_add(&response->headers, "Content-Type", mime_type->valuestring);
+    }
+    if (cJSON_IsString(text)) {
+        cJSON* encoding = cJSON_GetObjectItemCaseSensitive(content, "encoding");
+        size_t length = strlen(text->valuestring);
+        if (cJSON_IsString(encoding) && strcmp(encoding->valuestring, "base64") == 0) {
+            length = base64_decode_in_place(text->valuestring);
+        }
+        response_set_body(response, text->valuestring, length);
+    }
+    return true;
+}
+
+extern "C" {
+
+int mock_server_add_har_file(MockServer* server, const char* filepath) {
+    if (!server || !filepath) {
+        return MOCK_SERVER_ERROR_NULL_PARAM;
+    }
+    if (server->http) {
+        return MOCK_SERVER_ERROR_RUNNING;
+    }
+
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        return MOCK_SERVER_ERROR_FILE;
+    }
+
+    char* data = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+        rewind(file);
+    }
+    if (size >= 0) {
+        data = (char*)malloc((size_t)size + 1);
+        if (!data) {
+            handle_out_of_memory("mock HAR file");
+        } else if (fread(data, 1, (size_t)size, file) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    if (!data) {
+        return size >= 0 ? MOCK_SERVER_ERROR_MEMORY_ALLOCATION : MOCK_SERVER_ERROR_FILE;
+    }
+
+    cJSON* json = cJSON_ParseWithLength(data, (size_t)size);
+    free(data);
+    cJSON* entries = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(json, "log"), "entries");
+    if (!cJSON_IsArray(entries)) {
+        cJSON_Delete(json);
+        return MOCK_SERVER_ERROR_FILE;
+    }
+
+    int result = MOCK_SERVER_SUCCESS;
+    cJSON* entry = NULL;
+    cJSON_ArrayForEach(entry, entries) {
+        cJSON* request = cJSON_GetObjectItemCaseSensitive(entry, "request");
+        cJSON* method = cJSON_GetObjectItemCaseSensitive(request, "method");
+        cJSON* url = cJSON_GetObjectItemCaseSensitive(request, "url");
+        if (!cJSON_IsString(method) || !cJSON_IsString(url)) {
+            continue;
+        }
+
+        Response response;
+        response_init(&response);
+        bool has_response = har_entry_response(cJSON_GetObjectItemCaseSensitive(entry, "response"), &response);
+        result = mock_server_add_route(server, method->valuestring, url->valuestring, has_response ? &response : NULL);
+        response_cleanup(&response);
+        if (result != MOCK_SERVER_SUCCESS) {
+            break;
+        }
+    }
+
+    cJSON_Delete(json);
+    return result;
+}
+
+int mock_server_start(MockServer* server) {
+    if (!server) {
+        return MOCK_SERVER_ERROR_NULL_PARAM;
+    }
+    if (server->http) {
+        return MOCK_SERVER_ERROR_RUNNING;
+    }
+
+    httplib::Server* http = new (std::nothrow) httplib::Server();
+    if (!http) {
+        handle_out_of_memory("mock http server");
+        return MOCK_SERVER_ERROR_MEMORY_ALLOCATION;
+    }
+
+    int threads = server->options.threads;
+    http->new_task_queue = [threads] { return new httplib::ThreadPool((size_t)threads); };
+    httplib::Server::Handler handler = [server](const httplib::Request& request, httplib::Response& response) {
+        handle_request(server, request, response);
+    };
+    http->Get(".*", handler);
+    http->Post(".*", handler);
+    http->Put(".*", handler);
+    http->Patch(".*", handler);
+    http->Delete(".*", handler);
+    http->Options(".*", handler);
+
+    int port = server->options.port;
+    if (port == 0) {
+        port = http->bind_to_any_port(server->options.host);
+    } else if (!http->bind_to_port(server->options.host, port)) {
+        port = -1;
+    }
+    if (port <= 0) {
+        delete http;
+        return MOCK_SERVER_ERROR_BIND;
+    }
+
+    server->http = http;
+    server->port = port;
+    server->stopping = false;
+    if (pthread_create(&server->thread, NULL, server_thread_main, server) != 0) {
+        server->http = NULL;
+        delete http;
+        return MOCK_SERVER_ERROR_MEMORY_ALLOCATION;
+    }
+    server->thread_started = true;
+    http->wait_until_ready();
+    return MOCK_SERVER_SUCCESS;
+}
+
+bool mock_server_is_running(MockServer* server) {
+    return server && server->http && !server->stopping && server->http->is_running();
+}
+
+int mock_server_get_port(MockServer* server) {
+    return server && server->http ? server->port : 0;
+}
+
+void mock_server_get_stats(MockServer* server, MockServerStats* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(MockServerStats));
+    if (!server) {
+        return;
+    }
+    pthread_mutex_lock(&server->mutex);
+    *stats = server->stats;
+    pthread_mutex_unlock(&server->mutex);
+}
+
+int mock_server_get_route_count(MockServer* server) {
+    return server ? server->route_count : 0;
+}
+
+bool mock_server_get_route(MockServer* server, int route_index, MockRouteInfo* info) {
+    if (!server || !info || route_index < 0 || route_index >= server->route_count) {
+        return false;
+    }
+
+    const MockRoute* route = &server->routes[route_index];
+    snprintf(info->method, sizeof(info->method), "%s", route->method);
+    if (route->query.count == 0) {
+        snprintf(info->path, sizeof(info->path), "%s", route->path);
+    } else {
+        size_t used = (size_t)snprintf(info->path, sizeof(info->path), "%s", route->path);
+        for (int i = 0; i < route->query.count && used < sizeof(info->path); i++) {
+            used += (size_t)snprintf(info->path + used, sizeof(info->path) - used, "%c%s=%s", i == 0 ? '?' : '&',
+                                     route->query.headers[i].name, route->query.headers[i].value);
+        }
+    }
+    info->has_example = route->has_example;
+    info->status_code = route->status_code;
+
+    pthread_mutex_lock(&server->mutex);
+    info->hits = route->hits;
+    pthread_mutex_unlock(&server->mutex);
+    return true;
+}
+
+const char* mock_server_error_string(int error) {
+    switch (error) {
+        case MOCK_SERVER_SUCCESS:
+            return "Success";
+        case MOCK_SERVER_ERROR_NULL_PARAM:
+            return "Missing parameter";
+        case MOCK_SERVER_ERROR_MEMORY_ALLOCATION:
+            return "Out of memory";
+        case MOCK_SERVER_ERROR_INVALID_OPTIONS:
+            return "Options out of range";
+        case MOCK_SERVER_ERROR_BIND:
+            return "Could not listen on that address and port, it may be in use";
+        case MOCK_SERVER_ERROR_RUNNING:
+            return "The server is already running";
+        case MOCK_SERVER_ERROR_FILE:
+            return "Could not read the HAR file";
+        default:
+            return "Unknown error";
+    }
+}
+
+}
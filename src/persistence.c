@@ -17,6 +17,10 @@
 
 #include "persistence.h"
 #include "app_state.h"
+#include "collection_reader.h"
+#include "collection_importer.h"
+#include "collection_journal.h"
+#include "collection_store.h"
 #include "cJSON.h"
 #include <stdlib.h>
 #include <string.h>
@@ -26,14 +30,187 @@
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
+#include <io.h>
 #define mkdir(path, mode) _mkdir(path)
 #else
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
 #endif
 
+/* flushes the directory entry of a renamed or new file, best effort. windows
+ * has no such thing, MOVEFILE_WRITE_THROUGH covers renames there */
+void persistence_sync_parent_directory(const char* filepath) {
+#ifndef _WIN32
+    const char* slash = strrchr(filepath, '/');
+    if (!slash) {
+        return;
+    }
+
+    size_t length = (size_t)(slash - filepath);
+    char* directory = malloc(length + 2);
+    if (!directory) {
+        return;
+    }
+    if (length == 0) {
+        directory[length++] = '/';
+    } else {
+        memcpy(directory, filepath, length);
+    }
+    directory[length] = '\0';
+
+    int fd = open(directory, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    free(directory);
+#else
+    (void)filepath;
+#endif
+}
+
+/* writes data to a temp file next to filepath, syncs it and renames it over the old file,
+ * so a crash leaves either the previous contents or the new ones but never half a file */
+int persistence_write_file_atomic(const char* filepath, const char* data, size_t length) {
+    if (!filepath || (!data && length > 0)) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    size_t path_length = strlen(filepath);
+    char* temp_path = malloc(path_length + sizeof(".tmp"));
+    if (!temp_path) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    memcpy(temp_path, filepath, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        free(temp_path);
+        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+
+    bool failed = length > 0 && fwrite(data, 1, length, file) != length;
+    if (!failed && fflush(file) != 0) {
+        failed = true;
+    }
+#ifdef _WIN32
+    if (!failed && _commit(_fileno(file)) != 0) {
+        failed = true;
+    }
+#else
+    if (!failed && fsync(fileno(file)) != 0) {
+        failed = true;
+    }
+#endif
+    if (fclose(file) != 0) {
+        failed = true;
+    }
+
+    if (failed) {
+        remove(temp_path);
+        free(temp_path);
+        return PERSISTENCE_ERROR_DISK_FULL;
+    }
+
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temp_path, filepath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool renamed = rename(temp_path, filepath) == 0;
+    if (renamed) {
+        persistence_sync_parent_directory(filepath);
+    }
+#endif
+
+    if (!renamed) {
+        remove(temp_path);
+    }
+    free(temp_path);
+    return renamed ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_PERMISSION_DENIED;
+}
+
+/* maps a whole file read only, what the collection readers and the store parse in place */
+int persistence_map_file(PersistenceMappedFile* mapped, const char* filepath, bool sequential) {
+    if (!mapped || !filepath) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+    memset(mapped, 0, sizeof(PersistenceMappedFile));
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | (sequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0), NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return persistence_file_exists(filepath) ? PERSISTENCE_ERROR_PERMISSION_DENIED
+                                                 : PERSISTENCE_ERROR_FILE_NOT_FOUND;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const char* data = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    mapped->file = file;
+    mapped->mapping = mapping;
+    mapped->data = data;
+    mapped->size = (size_t)size.QuadPart;
+#else
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        return persistence_file_exists(filepath) ? PERSISTENCE_ERROR_PERMISSION_DENIED
+                                                 : PERSISTENCE_ERROR_FILE_NOT_FOUND;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        close(fd);
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
+
+    size_t size = (size_t)file_stat.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    if (sequential) {
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+
+    mapped->data = (const char*)data;
+    mapped->size = size;
+#endif
+    return PERSISTENCE_SUCCESS;
+}
+
+void persistence_unmap_file(PersistenceMappedFile* mapped) {
+    if (!mapped || !mapped->data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapped->data);
+    CloseHandle(mapped->mapping);
+    CloseHandle(mapped->file);
+#else
+    munmap((void*)mapped->data, mapped->size);
+#endif
+    memset(mapped, 0, sizeof(PersistenceMappedFile));
+}
+
 /* saves a single request to a json file */
 int persistence_save_request(const Request* request, const char* name, const char* filename) {
     if (!request || !name || !filename) {
@@ -131,21 +308,12 @@ int persistence_save_request(const Request* request, const char* name, const cha
     }
 
     /* write json to file */
-    FILE* file = fopen(full_path, "w");
-    if (!file) {
-        free(json_string);
-        free(full_path);
-        return -1;
-    }
-
-    size_t json_len = strlen(json_string);
-    size_t written = fwrite(json_string, 1, json_len, file);
-    fclose(file);
+    int result = persistence_write_file_atomic(full_path, json_string, strlen(json_string));
 
     free(json_string);
     free(full_path);
 
-    return (written == json_len) ? 0 : -1;
+    return (result == PERSISTENCE_SUCCESS) ? 0 : -1;
 }
 
 /* loads a single request from a json file */
@@ -359,21 +527,16 @@ char* persistence_get_config_path(const char* filename) {
 /* checks if a file exists at the given path */
 int persistence_file_exists(const char* filepath) {
     if (!filepath) {
-        printf("DEBUG: persistence_file_exists called with NULL filepath\n");
         return 0;
     }
 
-    printf("DEBUG: Checking if file exists: %s\n", filepath);
-
 #ifdef _WIN32
     DWORD attrs = GetFileAttributesA(filepath);
     int exists = (attrs != INVALID_FILE_ATTRIBUTES && !(attrs & FILE_ATTRIBUTE_DIRECTORY));
-    printf("DEBUG: File exists result: %s (attrs: %lu)\n", exists ? "YES" : "NO", attrs);
     return exists;
 #else
     struct stat st;
     int result = (stat(filepath, &st) == 0 && S_ISREG(st.st_mode));
-    printf("DEBUG: File exists result: %s\n", result ? "YES" : "NO");
     return result;
 #endif
 }
@@ -514,32 +677,49 @@ int persistence_save_collection_new(const Collection* collection, const char* fi
     }
 
     /* write json to file */
-    FILE* file = fopen(filepath, "w");
-    if (!file) {
-        free(json_string);
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    size_t json_len = strlen(json_string);
-    size_t written = fwrite(json_string, 1, json_len, file);
-    fclose(file);
+    int result = persistence_write_file_atomic(filepath, json_string, strlen(json_string));
     free(json_string);
 
-    return (written == json_len) ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_DISK_FULL;
+    return result;
 }
 
-/* saves a collection with authentication data to a json file */
-int persistence_save_collection_with_auth(const Collection* collection, const char* filepath, const void* app_state) {
-    if (!collection || !filepath) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
+/* copies the collection-level auth fields out of the app state */
+void persistence_auth_from_app_state(PersistenceAuth* auth, const void* app_state) {
+    if (!auth) {
+        return;
     }
 
+    memset(auth, 0, sizeof(PersistenceAuth));
+
     const AppState* state = (const AppState*)app_state;
+    if (!state) {
+        return;
+    }
+
+    auth->selected_auth_type = state->selected_auth_type;
+    memcpy(auth->api_key_name, state->auth_api_key_name, sizeof(auth->api_key_name));
+    memcpy(auth->api_key_value, state->auth_api_key_value, sizeof(auth->api_key_value));
+    memcpy(auth->bearer_token, state->auth_bearer_token, sizeof(auth->bearer_token));
+    memcpy(auth->basic_username, state->auth_basic_username, sizeof(auth->basic_username));
+    memcpy(auth->basic_password, state->auth_basic_password, sizeof(auth->basic_password));
+    memcpy(auth->oauth_token, state->auth_oauth_token, sizeof(auth->oauth_token));
+    auth->api_key_location = state->auth_api_key_location;
+    auth->api_key_enabled = state->auth_api_key_enabled;
+    auth->bearer_enabled = state->auth_bearer_enabled;
+    auth->basic_enabled = state->auth_basic_enabled;
+    auth->oauth_enabled = state->auth_oauth_enabled;
+}
+
+/* builds the json text for a collection, auth may be null. the caller frees the result */
+char* persistence_serialize_collection(const Collection* collection, const PersistenceAuth* auth) {
+    if (!collection) {
+        return NULL;
+    }
 
     /* create json object for the collection */
     cJSON* json = cJSON_CreateObject();
     if (!json) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
     /* add collection metadata */
@@ -551,7 +731,7 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
 
     if (!json_id || !json_name || !json_description || !json_created_at || !json_modified_at) {
         cJSON_Delete(json);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
     cJSON_AddItemToObject(json, "id", json_id);
@@ -560,18 +740,23 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
     cJSON_AddItemToObject(json, "created_at", json_created_at);
     cJSON_AddItemToObject(json, "modified_at", json_modified_at);
 
-    /* add collection-level authentication data from appstate */
-    if (state) {
+    /* journal records up to this one are part of the snapshot */
+    if (collection->journal_seq > 0) {
+        cJSON_AddNumberToObject(json, "journal_seq", (double)collection->journal_seq);
+    }
+
+    /* add collection-level authentication data */
+    if (auth) {
         cJSON* collection_auth = cJSON_CreateObject();
         if (collection_auth) {
-            cJSON* auth_type = cJSON_CreateNumber(state->selected_auth_type);
+            cJSON* auth_type = cJSON_CreateNumber(auth->selected_auth_type);
             cJSON_AddItemToObject(collection_auth, "type", auth_type);
 
             // Save authentication checkbox states
-            cJSON* auth_api_key_enabled = cJSON_CreateBool(state->auth_api_key_enabled);
-            cJSON* auth_bearer_enabled = cJSON_CreateBool(state->auth_bearer_enabled);
-            cJSON* auth_basic_enabled = cJSON_CreateBool(state->auth_basic_enabled);
-            cJSON* auth_oauth_enabled = cJSON_CreateBool(state->auth_oauth_enabled);
+            cJSON* auth_api_key_enabled = cJSON_CreateBool(auth->api_key_enabled);
+            cJSON* auth_bearer_enabled = cJSON_CreateBool(auth->bearer_enabled);
+            cJSON* auth_basic_enabled = cJSON_CreateBool(auth->basic_enabled);
+            cJSON* auth_oauth_enabled = cJSON_CreateBool(auth->oauth_enabled);
             
             if (auth_api_key_enabled && auth_bearer_enabled && auth_basic_enabled && auth_oauth_enabled) {
                 cJSON_AddItemToObject(collection_auth, "api_key_enabled", auth_api_key_enabled);
@@ -580,31 +765,30 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
                 cJSON_AddItemToObject(collection_auth, "oauth_enabled", auth_oauth_enabled);
             }
 
-            if (state->selected_auth_type == 1) {
-                cJSON* api_key_name = cJSON_CreateString(state->auth_api_key_name);
-                cJSON* api_key_value = cJSON_CreateString(state->auth_api_key_value);
+            if (auth->selected_auth_type == 1) {
+                cJSON* api_key_name = cJSON_CreateString(auth->api_key_name);
+                cJSON* api_key_value = cJSON_CreateString(auth->api_key_value);
 
-                printf("DEBUG: Saving API key location: %d\n", state->auth_api_key_location);
-                cJSON* api_key_location = cJSON_CreateNumber((double)state->auth_api_key_location);
+                cJSON* api_key_location = cJSON_CreateNumber((double)auth->api_key_location);
                 if (api_key_name && api_key_value && api_key_location) {
                     cJSON_AddItemToObject(collection_auth, "api_key_name", api_key_name);
                     cJSON_AddItemToObject(collection_auth, "api_key_value", api_key_value);
                     cJSON_AddItemToObject(collection_auth, "api_key_location", api_key_location);
                 }
-            } else if (state->selected_auth_type == 2) {
-                cJSON* bearer_token = cJSON_CreateString(state->auth_bearer_token);
+            } else if (auth->selected_auth_type == 2) {
+                cJSON* bearer_token = cJSON_CreateString(auth->bearer_token);
                 if (bearer_token) {
                     cJSON_AddItemToObject(collection_auth, "bearer_token", bearer_token);
                 }
-            } else if (state->selected_auth_type == 3) {
-                cJSON* basic_username = cJSON_CreateString(state->auth_basic_username);
-                cJSON* basic_password = cJSON_CreateString(state->auth_basic_password);
+            } else if (auth->selected_auth_type == 3) {
+                cJSON* basic_username = cJSON_CreateString(auth->basic_username);
+                cJSON* basic_password = cJSON_CreateString(auth->basic_password);
                 if (basic_username && basic_password) {
                     cJSON_AddItemToObject(collection_auth, "basic_username", basic_username);
                     cJSON_AddItemToObject(collection_auth, "basic_password", basic_password);
                 }
-            } else if (state->selected_auth_type == 4) {
-                cJSON* oauth_token = cJSON_CreateString(state->auth_oauth_token);
+            } else if (auth->selected_auth_type == 4) {
+                cJSON* oauth_token = cJSON_CreateString(auth->oauth_token);
                 if (oauth_token) {
                     cJSON_AddItemToObject(collection_auth, "oauth_token", oauth_token);
                 }
@@ -613,12 +797,9 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
             cJSON_AddItemToObject(json, "auth", collection_auth);
         }
 
-        printf("DEBUG: Saving cookies to persistence - collection has %d cookies\n", collection->cookie_jar.count);
-
         if (collection->cookie_jar.count > 0) {
             cJSON* collection_cookies = cJSON_CreateArray();
             if (collection_cookies) {
-                printf("DEBUG: Created cookies JSON array, saving %d cookies\n", collection->cookie_jar.count);
                 for (int i = 0; i < collection->cookie_jar.count; i++) {
                     const StoredCookie* cookie = &collection->cookie_jar.cookies[i];
                     cJSON* cookie_obj = cJSON_CreateObject();
@@ -664,14 +845,14 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
     cJSON* json_requests = cJSON_CreateArray();
     if (!json_requests) {
         cJSON_Delete(json);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
     for (int i = 0; i < collection->request_count; i++) {
         cJSON* json_request = cJSON_CreateObject();
         if (!json_request) {
             cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            return NULL;
         }
 
         const Request* request = &collection->requests[i];
@@ -684,7 +865,7 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
         if (!req_name || !req_method || !req_url) {
             cJSON_Delete(json_request);
             cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            return NULL;
         }
 
         cJSON_AddItemToObject(json_request, "name", req_name);
@@ -695,7 +876,7 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
         if (!req_headers) {
             cJSON_Delete(json_request);
             cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            return NULL;
         }
 
         for (int j = 0; j < request->headers.count; j++) {
@@ -703,7 +884,7 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
             if (!header_obj) {
                 cJSON_Delete(json_request);
                 cJSON_Delete(json);
-                return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+                return NULL;
             }
 
             cJSON* header_name = cJSON_CreateString(request->headers.headers[j].name);
@@ -714,7 +895,7 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
                 cJSON_Delete(header_obj);
                 cJSON_Delete(json_request);
                 cJSON_Delete(json);
-                return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+                return NULL;
             }
 
             cJSON_AddItemToObject(header_obj, "name", header_name);
@@ -728,15 +909,11 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
         if (!req_body) {
             cJSON_Delete(json_request);
             cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            return NULL;
         }
 
         cJSON* body_type = cJSON_CreateString("raw");
 
-        if (request->body) {
-            printf("DEBUG: Saving body content: '%s'\n", request->body);
-        }
-
         cJSON* body_content = NULL;
         if (request->body && strlen(request->body) > 0) {
 
@@ -748,7 +925,6 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
             if (is_multipart_form || is_urlencoded_form) {
 
                 body_content = cJSON_CreateString(request->body);
-                printf("DEBUG: Saving form data content: '%s'\n", request->body);
             } else {
 
                 const char* trimmed = request->body;
@@ -779,7 +955,7 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
             cJSON_Delete(req_body);
             cJSON_Delete(json_request);
             cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            return NULL;
         }
 
         cJSON_AddItemToObject(req_body, "type", body_type);
@@ -845,42 +1021,36 @@ int persistence_save_collection_with_auth(const Collection* collection, const ch
     char* json_string = cJSON_Print(json);
     cJSON_Delete(json);
 
-    if (!json_string) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
-    }
-
-    /* write json to file */
-    FILE* file = fopen(filepath, "w");
-    if (!file) {
-        free(json_string);
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    size_t json_len = strlen(json_string);
-    size_t written = fwrite(json_string, 1, json_len, file);
-    fclose(file);
-    free(json_string);
-
-    return (written == json_len) ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_DISK_FULL;
+    return json_string;
 }
 
-int persistence_load_collection_new(Collection* collection, const char* filepath) {
+/* saves a collection with authentication data to a json file */
+int persistence_save_collection_with_auth(const Collection* collection, const char* filepath, const void* app_state) {
     if (!collection || !filepath) {
         return PERSISTENCE_ERROR_NULL_PARAM;
     }
 
-    int validation_result = persistence_validate_collection_file(filepath);
-    if (validation_result != PERSISTENCE_SUCCESS) {
-        if (validation_result == PERSISTENCE_ERROR_CORRUPTED_DATA || 
-            validation_result == PERSISTENCE_ERROR_INVALID_JSON) {
-            return persistence_handle_corrupted_file(filepath, "load collection");
-        }
-        return validation_result;
+    PersistenceAuth auth;
+    persistence_auth_from_app_state(&auth, app_state);
+
+    char* json_string = persistence_serialize_collection(collection, app_state ? &auth : NULL);
+    if (!json_string) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
     }
 
+    int result = persistence_write_file_atomic(filepath, json_string, strlen(json_string));
+    free(json_string);
+
+    return result;
+}
+
+/* reads a whole file into a nul terminated buffer, the caller frees it */
+static char* read_whole_file(const char* filepath, size_t* length, int* error) {
     FILE* file = fopen(filepath, "rb");
     if (!file) {
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+        *error = persistence_file_exists(filepath) ? PERSISTENCE_ERROR_PERMISSION_DENIED
+                                                   : PERSISTENCE_ERROR_FILE_NOT_FOUND;
+        return NULL;
     }
 
     fseek(file, 0, SEEK_END);
@@ -889,38 +1059,41 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
 
     if (file_size <= 0) {
         fclose(file);
-        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+        *error = PERSISTENCE_ERROR_CORRUPTED_DATA;
+        return NULL;
     }
 
-    char* json_string = (char*)malloc(file_size + 1);
-    if (!json_string) {
+    char* text = (char*)malloc((size_t)file_size + 1);
+    if (!text) {
         fclose(file);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        *error = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
-    size_t read_size = fread(json_string, 1, file_size, file);
-    json_string[read_size] = '\0';
+    size_t read_size = fread(text, 1, (size_t)file_size, file);
+    text[read_size] = '\0';
     fclose(file);
 
     if (read_size != (size_t)file_size) {
-        free(json_string);
-        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+        free(text);
+        *error = PERSISTENCE_ERROR_CORRUPTED_DATA;
+        return NULL;
     }
 
-    cJSON* json = cJSON_Parse(json_string);
-    free(json_string);
-
-    if (!json) {
-        return PERSISTENCE_ERROR_INVALID_JSON;
-    }
+    *length = read_size;
+    *error = PERSISTENCE_SUCCESS;
+    return text;
+}
 
+/* fills a collection from parsed json, metadata and requests */
+static void parse_collection_json(Collection* collection, const cJSON* json) {
     collection_cleanup(collection);
 
-    cJSON* json_id = cJSON_GetObjectItem(json, "id");
-    cJSON* json_name = cJSON_GetObjectItem(json, "name");
-    cJSON* json_description = cJSON_GetObjectItem(json, "description");
-    cJSON* json_created_at = cJSON_GetObjectItem(json, "created_at");
-    cJSON* json_modified_at = cJSON_GetObjectItem(json, "modified_at");
+    const cJSON* json_id = cJSON_GetObjectItem(json, "id");
+    const cJSON* json_name = cJSON_GetObjectItem(json, "name");
+    const cJSON* json_description = cJSON_GetObjectItem(json, "description");
+    const cJSON* json_created_at = cJSON_GetObjectItem(json, "created_at");
+    const cJSON* json_modified_at = cJSON_GetObjectItem(json, "modified_at");
 
     collection_init(collection, "Untitled Collection", "");
 
@@ -939,17 +1112,9 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
         collection->description[sizeof(collection->description) - 1] = '\0';
     }
 
-    if (json_created_at && cJSON_IsNumber(json_created_at)) {
-        collection->created_at = (time_t)json_created_at->valuedouble;
-    }
-
-    if (json_modified_at && cJSON_IsNumber(json_modified_at)) {
-        collection->modified_at = (time_t)json_modified_at->valuedouble;
-    }
-
-    cJSON* json_requests = cJSON_GetObjectItem(json, "requests");
+    const cJSON* json_requests = cJSON_GetObjectItem(json, "requests");
     if (json_requests && cJSON_IsArray(json_requests)) {
-        cJSON* json_request = NULL;
+        const cJSON* json_request = NULL;
         cJSON_ArrayForEach(json_request, json_requests) {
             if (!cJSON_IsObject(json_request)) {
                 continue;
@@ -1007,14 +1172,12 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
 
                         const char* content = body_content->valuestring;
                         if (content && strlen(content) > 0) {
-                            printf("DEBUG: Loading string body content: '%s'\n", content);
                             request_set_body(&temp_request, content, strlen(content));
                         }
                     } else if (cJSON_IsObject(body_content) || cJSON_IsArray(body_content)) {
 
                         char* json_string = cJSON_PrintUnformatted(body_content);
                         if (json_string) {
-                            printf("DEBUG: Loading JSON body content: '%s'\n", json_string);
                             request_set_body(&temp_request, json_string, strlen(json_string));
                             free(json_string);
                         }
@@ -1024,14 +1187,10 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
 
             // Load per-request authentication data
             cJSON* req_auth = cJSON_GetObjectItem(json_request, "auth");
-            printf("DEBUG: Loading request '%s' - auth object found: %s\n",
-                   request_name, req_auth ? "yes" : "no");
             if (req_auth && cJSON_IsObject(req_auth)) {
                 cJSON* auth_type = cJSON_GetObjectItem(req_auth, "type");
                 if (auth_type && cJSON_IsNumber(auth_type)) {
                     temp_request.selected_auth_type = (int)auth_type->valuedouble;
-                    printf("DEBUG: Loaded auth type: %d for request '%s'\n",
-                           temp_request.selected_auth_type, request_name);
                     
                     // Load authentication checkbox states (default to true for backward compatibility)
                     cJSON* auth_api_key_enabled = cJSON_GetObjectItem(req_auth, "api_key_enabled");
@@ -1048,13 +1207,6 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
                     temp_request.auth_oauth_enabled = auth_oauth_enabled && cJSON_IsBool(auth_oauth_enabled) ?
                                                      cJSON_IsTrue(auth_oauth_enabled) : true;
                     
-                    printf("DEBUG: Loaded checkboxes for request '%s' - api_key: %s, bearer: %s, basic: %s, oauth: %s\n",
-                           request_name,
-                           temp_request.auth_api_key_enabled ? "true" : "false",
-                           temp_request.auth_bearer_enabled ? "true" : "false",
-                           temp_request.auth_basic_enabled ? "true" : "false",
-                           temp_request.auth_oauth_enabled ? "true" : "false");
-                    
                     // Load authentication data based on type
                     if (temp_request.selected_auth_type == 1) { // API Key
                         cJSON* api_key_name = cJSON_GetObjectItem(req_auth, "api_key_name");
@@ -1100,7 +1252,6 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
                 }
             } else {
                 // No auth object found - initialize with defaults (checkboxes enabled for backward compatibility)
-                printf("DEBUG: No auth object found for request '%s' - using defaults\n", request_name);
                 temp_request.selected_auth_type = 0;
                 memset(temp_request.auth_api_key_name, 0, sizeof(temp_request.auth_api_key_name));
                 memset(temp_request.auth_api_key_value, 0, sizeof(temp_request.auth_api_key_value));
@@ -1119,74 +1270,37 @@ int persistence_load_collection_new(Collection* collection, const char* filepath
             if (collection_add_request(collection, &temp_request, request_name) < 0) {
                 request_cleanup(&temp_request);
             } else {
-                printf("DEBUG: Successfully added request '%s' to collection with auth type: %d\n",
-                       request_name, temp_request.selected_auth_type);
                 request_cleanup(&temp_request);
             }
         }
     }
 
-    cJSON_Delete(json);
-    return PERSISTENCE_SUCCESS;
-}
-
-int persistence_load_collection_with_auth(Collection* collection, const char* filepath, void* app_state) {
-    if (!collection || !filepath) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
-    }
-
-    AppState* state = (AppState*)app_state;
-
-    int result = persistence_load_collection_new(collection, filepath);
-    if (result != PERSISTENCE_SUCCESS) {
-        return result;
-    }
-
-    if (!state) {
-        return PERSISTENCE_SUCCESS; 
-    }
-
-    FILE* file = fopen(filepath, "rb");
-    if (!file) {
-        return PERSISTENCE_SUCCESS; 
-    }
-
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    if (file_size <= 0) {
-        fclose(file);
-        return PERSISTENCE_SUCCESS;
+    /* adding the requests stamped the collection with the current time */
+    if (json_created_at && cJSON_IsNumber(json_created_at)) {
+        collection->created_at = (time_t)json_created_at->valuedouble;
     }
 
-    char* json_string = (char*)malloc(file_size + 1);
-    if (!json_string) {
-        fclose(file);
-        return PERSISTENCE_SUCCESS;
+    if (json_modified_at && cJSON_IsNumber(json_modified_at)) {
+        collection->modified_at = (time_t)json_modified_at->valuedouble;
     }
 
-    size_t read_size = fread(json_string, 1, file_size, file);
-    json_string[read_size] = '\0';
-    fclose(file);
-
-    if (read_size != (size_t)file_size) {
-        free(json_string);
-        return PERSISTENCE_SUCCESS;
+    const cJSON* json_journal_seq = cJSON_GetObjectItem(json, "journal_seq");
+    if (json_journal_seq && cJSON_IsNumber(json_journal_seq) && json_journal_seq->valuedouble > 0) {
+        collection->journal_seq = (unsigned long)json_journal_seq->valuedouble;
     }
+}
 
-    cJSON* json = cJSON_Parse(json_string);
-    free(json_string);
-
-    if (!json) {
-        return PERSISTENCE_SUCCESS;
-    }
+/* reads the collection-level auth, has_auth is set when the file has one */
+static void parse_collection_auth(const cJSON* json, PersistenceAuth* auth, bool* has_auth) {
+    memset(auth, 0, sizeof(PersistenceAuth));
+    *has_auth = false;
 
-    cJSON* collection_auth = cJSON_GetObjectItem(json, "auth");
+    const cJSON* collection_auth = cJSON_GetObjectItem(json, "auth");
     if (collection_auth && cJSON_IsObject(collection_auth)) {
         cJSON* auth_type = cJSON_GetObjectItem(collection_auth, "type");
         if (auth_type && cJSON_IsNumber(auth_type)) {
-            state->selected_auth_type = (int)auth_type->valuedouble;
+            auth->selected_auth_type = (int)auth_type->valuedouble;
+            *has_auth = true;
 
             // Load authentication checkbox states (default to true for backward compatibility)
             cJSON* auth_api_key_enabled = cJSON_GetObjectItem(collection_auth, "api_key_enabled");
@@ -1195,83 +1309,78 @@ int persistence_load_collection_with_auth(Collection* collection, const char* fi
             cJSON* auth_oauth_enabled = cJSON_GetObjectItem(collection_auth, "oauth_enabled");
 
             if (auth_api_key_enabled && cJSON_IsBool(auth_api_key_enabled)) {
-                state->auth_api_key_enabled = cJSON_IsTrue(auth_api_key_enabled);
+                auth->api_key_enabled = cJSON_IsTrue(auth_api_key_enabled);
             } else {
-                state->auth_api_key_enabled = true; // Default to enabled for backward compatibility
+                auth->api_key_enabled = true; // Default to enabled for backward compatibility
             }
 
             if (auth_bearer_enabled && cJSON_IsBool(auth_bearer_enabled)) {
-                state->auth_bearer_enabled = cJSON_IsTrue(auth_bearer_enabled);
+                auth->bearer_enabled = cJSON_IsTrue(auth_bearer_enabled);
             } else {
-                state->auth_bearer_enabled = true; // Default to enabled for backward compatibility
+                auth->bearer_enabled = true; // Default to enabled for backward compatibility
             }
 
             if (auth_basic_enabled && cJSON_IsBool(auth_basic_enabled)) {
-                state->auth_basic_enabled = cJSON_IsTrue(auth_basic_enabled);
+                auth->basic_enabled = cJSON_IsTrue(auth_basic_enabled);
             } else {
-                state->auth_basic_enabled = true; // Default to enabled for backward compatibility
+                auth->basic_enabled = true; // Default to enabled for backward compatibility
             }
 
             if (auth_oauth_enabled && cJSON_IsBool(auth_oauth_enabled)) {
-                state->auth_oauth_enabled = cJSON_IsTrue(auth_oauth_enabled);
+                auth->oauth_enabled = cJSON_IsTrue(auth_oauth_enabled);
             } else {
-                state->auth_oauth_enabled = true; // Default to enabled for backward compatibility
+                auth->oauth_enabled = true; // Default to enabled for backward compatibility
             }
 
-            if (state->selected_auth_type == 1) {
+            if (auth->selected_auth_type == 1) {
                 cJSON* api_key_name = cJSON_GetObjectItem(collection_auth, "api_key_name");
                 cJSON* api_key_value = cJSON_GetObjectItem(collection_auth, "api_key_value");
                 cJSON* api_key_location = cJSON_GetObjectItem(collection_auth, "api_key_location");
 
                 if (api_key_name && cJSON_IsString(api_key_name)) {
-                    strncpy(state->auth_api_key_name, api_key_name->valuestring, sizeof(state->auth_api_key_name) - 1);
-                    state->auth_api_key_name[sizeof(state->auth_api_key_name) - 1] = '\0';
+                    strncpy(auth->api_key_name, api_key_name->valuestring, sizeof(auth->api_key_name) - 1);
+                    auth->api_key_name[sizeof(auth->api_key_name) - 1] = '\0';
                 }
                 if (api_key_value && cJSON_IsString(api_key_value)) {
-                    strncpy(state->auth_api_key_value, api_key_value->valuestring, sizeof(state->auth_api_key_value) - 1);
-                    state->auth_api_key_value[sizeof(state->auth_api_key_value) - 1] = '\0';
+                    strncpy(auth->api_key_value, api_key_value->valuestring, sizeof(auth->api_key_value) - 1);
+                    auth->api_key_value[sizeof(auth->api_key_value) - 1] = '\0';
                 }
                 if (api_key_location && cJSON_IsNumber(api_key_location)) {
-                    state->auth_api_key_location = (int)api_key_location->valuedouble;
-                    printf("DEBUG: Loaded API key location: %d (from JSON: %f)\n",
-                           state->auth_api_key_location, api_key_location->valuedouble);
+                    auth->api_key_location = (int)api_key_location->valuedouble;
                 }
-            } else if (state->selected_auth_type == 2) {
+            } else if (auth->selected_auth_type == 2) {
                 cJSON* bearer_token = cJSON_GetObjectItem(collection_auth, "bearer_token");
                 if (bearer_token && cJSON_IsString(bearer_token)) {
-                    strncpy(state->auth_bearer_token, bearer_token->valuestring, sizeof(state->auth_bearer_token) - 1);
-                    state->auth_bearer_token[sizeof(state->auth_bearer_token) - 1] = '\0';
+                    strncpy(auth->bearer_token, bearer_token->valuestring, sizeof(auth->bearer_token) - 1);
+                    auth->bearer_token[sizeof(auth->bearer_token) - 1] = '\0';
                 }
-            } else if (state->selected_auth_type == 3) {
+            } else if (auth->selected_auth_type == 3) {
                 cJSON* basic_username = cJSON_GetObjectItem(collection_auth, "basic_username");
                 cJSON* basic_password = cJSON_GetObjectItem(collection_auth, "basic_password");
 
                 if (basic_username && cJSON_IsString(basic_username)) {
-                    strncpy(state->auth_basic_username, basic_username->valuestring, sizeof(state->auth_basic_username) - 1);
-                    state->auth_basic_username[sizeof(state->auth_basic_username) - 1] = '\0';
+                    strncpy(auth->basic_username, basic_username->valuestring, sizeof(auth->basic_username) - 1);
+                    auth->basic_username[sizeof(auth->basic_username) - 1] = '\0';
                 }
                 if (basic_password && cJSON_IsString(basic_password)) {
-                    strncpy(state->auth_basic_password, basic_password->valuestring, sizeof(state->auth_basic_password) - 1);
-                    state->auth_basic_password[sizeof(state->auth_basic_password) - 1] = '\0';
+                    strncpy(auth->basic_password, basic_password->valuestring, sizeof(auth->basic_password) - 1);
+                    auth->basic_password[sizeof(auth->basic_password) - 1] = '\0';
                 }
-            } else if (state->selected_auth_type == 4) {
+            } else if (auth->selected_auth_type == 4) {
                 cJSON* oauth_token = cJSON_GetObjectItem(collection_auth, "oauth_token");
                 if (oauth_token && cJSON_IsString(oauth_token)) {
-                    strncpy(state->auth_oauth_token, oauth_token->valuestring, sizeof(state->auth_oauth_token) - 1);
-                    state->auth_oauth_token[sizeof(state->auth_oauth_token) - 1] = '\0';
+                    strncpy(auth->oauth_token, oauth_token->valuestring, sizeof(auth->oauth_token) - 1);
+                    auth->oauth_token[sizeof(auth->oauth_token) - 1] = '\0';
                 }
             }
         }
     }
+}
 
-    cJSON* collection_cookies = cJSON_GetObjectItem(json, "cookies");
-    printf("DEBUG: Loading cookies from persistence - found cookies array: %s\n",
-           collection_cookies ? "yes" : "no");
-
+/* reads the cookies saved with a collection into its jar */
+static void parse_collection_cookies(const cJSON* json, Collection* collection) {
+    const cJSON* collection_cookies = cJSON_GetObjectItem(json, "cookies");
     if (collection_cookies && cJSON_IsArray(collection_cookies)) {
-        int cookie_array_size = cJSON_GetArraySize(collection_cookies);
-        printf("DEBUG: Cookie array has %d items\n", cookie_array_size);
-
         collection->cookie_jar.count = 0;
 
         cJSON* cookie_item = NULL;
@@ -1337,29 +1446,138 @@ int persistence_load_collection_with_auth(Collection* collection, const char* fi
 
                 if (strlen(cookie->name) > 0) {
                     collection->cookie_jar.count++;
-                    printf("DEBUG: Loaded cookie: %s=%s (domain: %s, path: %s)\n",
-                           cookie->name, cookie->value, cookie->domain, cookie->path);
                 }
             }
         }
-        printf("DEBUG: Loaded %d cookies from collection file\n", collection->cookie_jar.count);
     }
-
-    cJSON_Delete(json);
-    return PERSISTENCE_SUCCESS;
 }
 
-int persistence_export_collection(const Collection* collection, const char* filepath) {
+/* the cjson based loader, kept so TINYREQUEST_COLLECTION_PARSER=dom can compare
+ * it against the streaming reader */
+static int read_collection_file_dom(Collection* collection, const char* filepath,
+                                    PersistenceAuth* auth, bool* has_auth) {
+    size_t length = 0;
+    int error = PERSISTENCE_SUCCESS;
+    char* json_string = read_whole_file(filepath, &length, &error);
+    if (!json_string) {
+        return error;
+    }
 
-    return persistence_save_collection_new(collection, filepath);
-}
+    const char* trimmed = json_string;
+    while (*trimmed == ' ' || *trimmed == '\t' || *trimmed == '\n' || *trimmed == '\r') {
+        trimmed++;
+    }
+    if (*trimmed != '{' && *trimmed != '[') {
+        free(json_string);
+        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    }
 
-int persistence_import_collection(Collection* collection, const char* filepath) {
+    cJSON* json = cJSON_Parse(json_string);
+    free(json_string);
 
-    return persistence_load_collection_new(collection, filepath);
-}
+    if (!json) {
+        return PERSISTENCE_ERROR_INVALID_JSON;
+    }
 
-int persistence_save_all_collections(const CollectionManager* manager) {
+    parse_collection_json(collection, json);
+
+    if (auth) {
+        bool found = false;
+        parse_collection_auth(json, auth, &found);
+        parse_collection_cookies(json, collection);
+        if (has_auth) {
+            *has_auth = found;
+        }
+    }
+
+    cJSON_Delete(json);
+    return PERSISTENCE_SUCCESS;
+}
+
+/* reads and parses a collection file in one pass. the collection-level auth and the
+ * cookies are only read when auth is given, has_auth tells if the file had any auth */
+int persistence_read_collection_file(Collection* collection, const char* filepath,
+                                     PersistenceAuth* auth, bool* has_auth) {
+    if (!collection || !filepath) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    const char* parser = getenv("TINYREQUEST_COLLECTION_PARSER");
+    int result;
+    if (collection_store_is_store_path(filepath)) {
+        result = collection_store_read_file(collection, filepath, auth, has_auth);
+    } else if (parser && strcmp(parser, "dom") == 0) {
+        result = read_collection_file_dom(collection, filepath, auth, has_auth);
+    } else {
+        result = collection_reader_read_file(collection, filepath, auth, has_auth);
+    }
+
+    if (result == PERSISTENCE_ERROR_CORRUPTED_DATA) {
+        return persistence_handle_corrupted_file(filepath, "load collection");
+    }
+    return result;
+}
+
+int persistence_load_collection_new(Collection* collection, const char* filepath) {
+    return persistence_read_collection_file(collection, filepath, NULL, NULL);
+}
+
+/* copies collection-level auth read from a file into the app state, the way the ui shows it */
+void persistence_apply_auth_to_app_state(const PersistenceAuth* auth, void* app_state) {
+    AppState* state = (AppState*)app_state;
+    if (!auth || !state) {
+        return;
+    }
+
+    state->selected_auth_type = auth->selected_auth_type;
+    state->auth_api_key_enabled = auth->api_key_enabled;
+    state->auth_bearer_enabled = auth->bearer_enabled;
+    state->auth_basic_enabled = auth->basic_enabled;
+    state->auth_oauth_enabled = auth->oauth_enabled;
+
+    if (auth->selected_auth_type == 1) {
+        memcpy(state->auth_api_key_name, auth->api_key_name, sizeof(state->auth_api_key_name));
+        memcpy(state->auth_api_key_value, auth->api_key_value, sizeof(state->auth_api_key_value));
+        state->auth_api_key_location = auth->api_key_location;
+    } else if (auth->selected_auth_type == 2) {
+        memcpy(state->auth_bearer_token, auth->bearer_token, sizeof(state->auth_bearer_token));
+    } else if (auth->selected_auth_type == 3) {
+        memcpy(state->auth_basic_username, auth->basic_username, sizeof(state->auth_basic_username));
+        memcpy(state->auth_basic_password, auth->basic_password, sizeof(state->auth_basic_password));
+    } else if (auth->selected_auth_type == 4) {
+        memcpy(state->auth_oauth_token, auth->oauth_token, sizeof(state->auth_oauth_token));
+    }
+}
+
+int persistence_load_collection_with_auth(Collection* collection, const char* filepath, void* app_state) {
+    if (!collection || !filepath) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    if (!app_state) {
+        return persistence_read_collection_file(collection, filepath, NULL, NULL);
+    }
+
+    PersistenceAuth auth;
+    bool has_auth = false;
+    int result = persistence_read_collection_file(collection, filepath, &auth, &has_auth);
+    if (result == PERSISTENCE_SUCCESS && has_auth) {
+        persistence_apply_auth_to_app_state(&auth, app_state);
+    }
+    return result;
+}
+
+int persistence_export_collection(const Collection* collection, const char* filepath) {
+
+    return persistence_save_collection_new(collection, filepath);
+}
+
+int persistence_import_collection(Collection* collection, const char* filepath) {
+
+    return collection_import_file(collection, filepath, NULL, NULL, NULL);
+}
+
+int persistence_save_all_collections(const CollectionManager* manager) {
     if (!manager) {
         return PERSISTENCE_ERROR_NULL_PARAM;
     }
@@ -1373,19 +1591,7 @@ int persistence_save_all_collections(const CollectionManager* manager) {
     }
 
     for (int i = 0; i < manager->count; i++) {
-        const Collection* collection = &manager->collections[i];
-
-        char filename[128];
-        snprintf(filename, sizeof(filename), "%s.json", collection->id);
-
-        char* filepath = persistence_get_collections_path(filename);
-        if (!filepath) {
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
-        }
-
-        int result = persistence_save_collection_new(collection, filepath);
-        free(filepath);
-
+        int result = persistence_write_collection_snapshot(&manager->collections[i], NULL);
         if (result != PERSISTENCE_SUCCESS) {
             return result;
         }
@@ -1407,67 +1613,220 @@ int persistence_save_all_collections_with_auth(const CollectionManager* manager,
         return PERSISTENCE_ERROR_PERMISSION_DENIED;
     }
 
+    PersistenceAuth auth;
+    persistence_auth_from_app_state(&auth, app_state);
+
+    for (int i = 0; i < manager->count; i++) {
+        int result = persistence_write_collection_snapshot(&manager->collections[i], app_state ? &auth : NULL);
+        if (result != PERSISTENCE_SUCCESS) {
+            return result;
+        }
+    }
+
+    return persistence_save_collection_manager_state(manager);
+}
+
+/* fnv-1a over what collections_state.json holds, to skip rewriting it when nothing moved */
+unsigned long persistence_manager_state_hash(const CollectionManager* manager) {
+    unsigned long hash = 2166136261u;
+    int numbers[3] = { manager->count, manager->active_collection_index, manager->active_request_index };
+
+    for (size_t i = 0; i < sizeof(numbers); i++) {
+        hash = (hash ^ ((const unsigned char*)numbers)[i]) * 16777619u;
+    }
+    /* the manifest carries names and descriptions too */
     for (int i = 0; i < manager->count; i++) {
         const Collection* collection = &manager->collections[i];
+        const char* fields[3] = { collection->id, collection->name, collection->description };
+        for (int f = 0; f < 3; f++) {
+            for (const char* c = fields[f]; *c; c++) {
+                hash = (hash ^ (unsigned char)*c) * 16777619u;
+            }
+            hash = (hash ^ 0xFF) * 16777619u;
+        }
+    }
+    return hash;
+}
 
-        char filename[128];
-        snprintf(filename, sizeof(filename), "%s.json", collection->id);
+static unsigned long g_saved_manager_state_hash = 0;
 
-        char* filepath = persistence_get_collections_path(filename);
-        if (!filepath) {
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+/* writes only the collections that changed since they were last saved, counts them in written */
+int persistence_save_dirty_collections_with_auth(CollectionManager* manager, const void* app_state, int* written) {
+    if (written) {
+        *written = 0;
+    }
+    if (!manager) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    bool directories_ready = false;
+    PersistenceAuth auth;
+    persistence_auth_from_app_state(&auth, app_state);
+
+    for (int i = 0; i < manager->count; i++) {
+        Collection* collection = &manager->collections[i];
+        if (!collection_is_dirty(collection)) {
+            continue;
         }
 
-        int result = persistence_save_collection_with_auth(collection, filepath, app_state);
-        free(filepath);
+        if (!directories_ready) {
+            if (persistence_create_config_dir() != 0 || persistence_create_collections_dir() != 0) {
+                return PERSISTENCE_ERROR_PERMISSION_DENIED;
+            }
+            directories_ready = true;
+        }
 
+        /* anything edited while writing keeps the collection dirty for the next save */
+        unsigned int generation = collection->generation;
+
+        int result = persistence_write_collection_snapshot(collection, app_state ? &auth : NULL);
         if (result != PERSISTENCE_SUCCESS) {
             return result;
         }
+
+        collection_mark_saved(collection, generation);
+        if (written) {
+            (*written)++;
+        }
+    }
+
+    unsigned long state_hash = persistence_manager_state_hash(manager);
+    if (state_hash == g_saved_manager_state_hash) {
+        return PERSISTENCE_SUCCESS;
+    }
+
+    if (!directories_ready && persistence_create_config_dir() != 0) {
+        return PERSISTENCE_ERROR_PERMISSION_DENIED;
     }
 
     return persistence_save_collection_manager_state(manager);
 }
 
-int persistence_delete_collection_file(const char* collection_id) {
-    if (!collection_id) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
-    }
+/* new snapshots go to the binary store when TINYREQUEST_COLLECTION_STORE=binary */
+static bool use_binary_store(void) {
+    const char* store = getenv("TINYREQUEST_COLLECTION_STORE");
+    return store && strcmp(store, "binary") == 0;
+}
 
+static char* collection_path_in_format(const char* collection_id, bool binary) {
     char filename[128];
-    snprintf(filename, sizeof(filename), "%s.json", collection_id);
+    snprintf(filename, sizeof(filename), "%s%s", collection_id, binary ? COLLECTION_STORE_EXTENSION : ".json");
+    return persistence_get_collections_path(filename);
+}
 
-    char* filepath = persistence_get_collections_path(filename);
-    if (!filepath) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+/* where the next snapshot of a collection is written, the caller frees it */
+char* persistence_get_collection_file_path(const char* collection_id) {
+    if (!collection_id) {
+        return NULL;
     }
+    return collection_path_in_format(collection_id, use_binary_store());
+}
 
-    if (!persistence_file_exists(filepath)) {
+/* the snapshot on disk in either format, the one new snapshots use first. NULL if there is none */
+char* persistence_find_collection_file(const char* collection_id) {
+    if (!collection_id) {
+        return NULL;
+    }
+
+    bool binary = use_binary_store();
+    for (int attempt = 0; attempt < 2; attempt++, binary = !binary) {
+        char* filepath = collection_path_in_format(collection_id, binary);
+        if (filepath && persistence_file_exists(filepath)) {
+            return filepath;
+        }
         free(filepath);
-        return PERSISTENCE_SUCCESS; 
     }
+    return NULL;
+}
 
-    int result = remove(filepath);
-    free(filepath);
+/* writes a snapshot in the configured format and drops one in the other format */
+int persistence_write_collection_snapshot(const Collection* collection, const PersistenceAuth* auth) {
+    if (!collection) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
 
-    if (result == 0) {
-        printf("Deleted collection file: %s\n", filename);
-        return PERSISTENCE_SUCCESS;
+    bool binary = use_binary_store();
+    char* filepath = collection_path_in_format(collection->id, binary);
+
+    size_t length = 0;
+    char* data;
+    if (binary) {
+        data = collection_store_serialize(collection, auth, &length);
     } else {
-        printf("Error: %s\n", persistence_get_user_friendly_error(PERSISTENCE_ERROR_PERMISSION_DENIED, "delete collection file"));
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+        data = persistence_serialize_collection(collection, auth);
+        length = data ? strlen(data) : 0;
     }
+
+    int result = (filepath && data) ? persistence_write_file_atomic(filepath, data, length)
+                                    : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    free(data);
+    free(filepath);
+
+    /* left behind it would be loaded as a second copy on the next start */
+    if (result == PERSISTENCE_SUCCESS) {
+        char* stale = collection_path_in_format(collection->id, !binary);
+        if (stale) {
+            remove(stale);
+            free(stale);
+        }
+    }
+    return result;
 }
 
-int persistence_load_all_collections(CollectionManager* manager) {
-    if (!manager) {
+int persistence_delete_collection_file(const char* collection_id) {
+    if (!collection_id) {
         return PERSISTENCE_ERROR_NULL_PARAM;
     }
 
-    persistence_load_collection_manager_state(manager);
+    for (int binary = 0; binary < 2; binary++) {
+        char* filepath = collection_path_in_format(collection_id, binary != 0);
+        if (!filepath) {
+            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        }
+
+        if (persistence_file_exists(filepath)) {
+            if (remove(filepath) != 0) {
+                free(filepath);
+                printf("Error: %s\n", persistence_get_user_friendly_error(PERSISTENCE_ERROR_PERMISSION_DENIED, "delete collection file"));
+                return PERSISTENCE_ERROR_PERMISSION_DENIED;
+            }
+            printf("Deleted collection file: %s\n", filepath);
+        }
+        free(filepath);
+    }
+
+    return PERSISTENCE_SUCCESS;
+}
+
+static bool has_suffix(const char* name, const char* suffix) {
+    size_t name_length = strlen(name);
+    size_t suffix_length = strlen(suffix);
+    return name_length > suffix_length && strcmp(name + name_length - suffix_length, suffix) == 0;
+}
+
+/* true for a snapshot in the format new snapshots do not use when one in
+ * that format sits next to it, left over from a crash between the two */
+static bool is_superseded_collection_file(const char* filepath) {
+    bool binary = use_binary_store();
+    const char* other = binary ? ".json" : COLLECTION_STORE_EXTENSION;
+    if (!has_suffix(filepath, other)) {
+        return false;
+    }
+
+    char twin[1024];
+    size_t stem = strlen(filepath) - strlen(other);
+    snprintf(twin, sizeof(twin), "%.*s%s", (int)stem, filepath, binary ? COLLECTION_STORE_EXTENSION : ".json");
+    return persistence_file_exists(twin);
+}
+
+/* calls back with the full path of every collection file in the collections directory, in either format */
+int persistence_for_each_collection_file(PersistenceFileCallback callback, void* user_data) {
+    if (!callback) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
 
     if (persistence_create_collections_dir() != 0) {
-        return PERSISTENCE_SUCCESS; 
+        return PERSISTENCE_SUCCESS;
     }
 
     char* collections_dir = persistence_get_collections_path("");
@@ -1480,76 +1839,41 @@ int persistence_load_all_collections(CollectionManager* manager) {
         collections_dir[len-1] = '\0';
     }
 
-    printf("Loading collections from directory: %s\n", collections_dir);
-
 #ifdef _WIN32
-    WIN32_FIND_DATAA find_data;
-    char search_pattern[1024];
-    snprintf(search_pattern, sizeof(search_pattern), "%s\\*.json", collections_dir);
-
-    HANDLE find_handle = FindFirstFileA(search_pattern, &find_data);
-    if (find_handle != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                char filepath[1024];
-                snprintf(filepath, sizeof(filepath), "%s\\%s", collections_dir, find_data.cFileName);
-
-                printf("Loading collection from: %s\n", filepath);
-                Collection temp_collection;
-                if (persistence_load_collection_new(&temp_collection, filepath) == PERSISTENCE_SUCCESS) {
-
-                    bool is_duplicate = false;
-                    for (int i = 0; i < manager->count; i++) {
-                        if (strcmp(manager->collections[i].id, temp_collection.id) == 0) {
-                            printf("Skipping duplicate collection: %s\n", temp_collection.name);
-                            is_duplicate = true;
-                            break;
-                        }
+    const char* extensions[2] = { ".json", COLLECTION_STORE_EXTENSION };
+    for (int e = 0; e < 2; e++) {
+        WIN32_FIND_DATAA find_data;
+        char search_pattern[1024];
+        snprintf(search_pattern, sizeof(search_pattern), "%s\\*%s", collections_dir, extensions[e]);
+
+        HANDLE find_handle = FindFirstFileA(search_pattern, &find_data);
+        if (find_handle != INVALID_HANDLE_VALUE) {
+            do {
+                if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+                    has_suffix(find_data.cFileName, extensions[e])) {
+                    char filepath[1024];
+                    snprintf(filepath, sizeof(filepath), "%s\\%s", collections_dir, find_data.cFileName);
+                    if (!is_superseded_collection_file(filepath)) {
+                        callback(filepath, user_data);
                     }
-
-                    if (!is_duplicate) {
-                        collection_manager_add_collection(manager, &temp_collection);
-                        printf("Added collection: %s\n", temp_collection.name);
-                    }
-                    collection_cleanup(&temp_collection);
                 }
-            }
-        } while (FindNextFileA(find_handle, &find_data));
-        FindClose(find_handle);
+            } while (FindNextFileA(find_handle, &find_data));
+            FindClose(find_handle);
+        }
     }
 #else
-
-    #include <dirent.h>
     DIR* dir = opendir(collections_dir);
     if (dir != NULL) {
         struct dirent* entry;
         while ((entry = readdir(dir)) != NULL) {
 
-            if (strstr(entry->d_name, ".json") != NULL) {
+            if (has_suffix(entry->d_name, ".json") || has_suffix(entry->d_name, COLLECTION_STORE_EXTENSION)) {
                 char full_path[1024];
                 snprintf(full_path, sizeof(full_path), "%s/%s", collections_dir, entry->d_name);
                 struct stat file_stat;
-                if (stat(full_path, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
-                    printf("Loading collection from: %s\n", full_path);
-                    Collection temp_collection;
-                    memset(&temp_collection, 0, sizeof(Collection));
-                    if (persistence_load_collection_new(&temp_collection, full_path) == PERSISTENCE_SUCCESS) {
-
-                        bool is_duplicate = false;
-                        for (int i = 0; i < manager->count; i++) {
-                            if (strcmp(manager->collections[i].id, temp_collection.id) == 0) {
-                                printf("Skipping duplicate collection: %s\n", temp_collection.name);
-                                is_duplicate = true;
-                                break;
-                            }
-                        }
-
-                        if (!is_duplicate) {
-                            collection_manager_add_collection(manager, &temp_collection);
-                            printf("Added collection: %s\n", temp_collection.name);
-                        }
-                        collection_cleanup(&temp_collection);
-                    }
+                if (stat(full_path, &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+                    !is_superseded_collection_file(full_path)) {
+                    callback(full_path, user_data);
                 }
             }
         }
@@ -1558,151 +1882,79 @@ int persistence_load_all_collections(CollectionManager* manager) {
 #endif
 
     free(collections_dir);
-    printf("Loaded %d collections total\n", manager->count);
     return PERSISTENCE_SUCCESS;
 }
 
-int persistence_load_all_collections_with_auth(CollectionManager* manager, void* app_state) {
-    if (!manager) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
-    }
+typedef struct {
+    CollectionManager* manager;
+    AppState* state;
+} LoadAllContext;
 
-    AppState* state = (AppState*)app_state;
+static void load_collection_file_into_manager(const char* filepath, void* user_data) {
+    LoadAllContext* context = (LoadAllContext*)user_data;
+    CollectionManager* manager = context->manager;
 
-    persistence_load_collection_manager_state(manager);
+    printf("Loading collection from: %s\n", filepath);
+    Collection temp_collection;
+    memset(&temp_collection, 0, sizeof(Collection));
 
-    if (persistence_create_collections_dir() != 0) {
-        return PERSISTENCE_SUCCESS; 
+    int load_result;
+    if (context->state) {
+        load_result = persistence_load_collection_with_auth(&temp_collection, filepath, context->state);
+    } else {
+        load_result = persistence_load_collection_new(&temp_collection, filepath);
     }
 
-    char* collections_dir = persistence_get_collections_path("");
-    if (!collections_dir) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    if (load_result != PERSISTENCE_SUCCESS) {
+        return;
     }
 
-    size_t len = strlen(collections_dir);
-    if (len > 0 && (collections_dir[len-1] == '/' || collections_dir[len-1] == '\\')) {
-        collections_dir[len-1] = '\0';
+    for (int i = 0; i < manager->count; i++) {
+        if (strcmp(manager->collections[i].id, temp_collection.id) == 0) {
+            printf("Skipping duplicate collection: %s\n", temp_collection.name);
+            collection_cleanup(&temp_collection);
+            return;
+        }
     }
 
-    printf("Loading collections with authentication from directory: %s\n", collections_dir);
-
-    bool first_collection_loaded = false;
-
-#ifdef _WIN32
-    WIN32_FIND_DATAA find_data;
-    char search_pattern[1024];
-    snprintf(search_pattern, sizeof(search_pattern), "%s\\*.json", collections_dir);
-
-    HANDLE find_handle = FindFirstFileA(search_pattern, &find_data);
-    if (find_handle != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                char filepath[1024];
-                snprintf(filepath, sizeof(filepath), "%s\\%s", collections_dir, find_data.cFileName);
-
-                printf("Loading collection from: %s\n", filepath);
-                Collection temp_collection;
-
-                int load_result;
-                if (state) {
+    collection_journal_replay(&temp_collection);
 
-                    load_result = persistence_load_collection_with_auth(&temp_collection, filepath, state);
-
-                    if (!first_collection_loaded && load_result == PERSISTENCE_SUCCESS) {
-                        first_collection_loaded = true;
-                    }
-                } else {
-                    load_result = persistence_load_collection_new(&temp_collection, filepath);
-                }
-
-                if (load_result == PERSISTENCE_SUCCESS) {
-
-                    bool is_duplicate = false;
-                    for (int i = 0; i < manager->count; i++) {
-                        if (strcmp(manager->collections[i].id, temp_collection.id) == 0) {
-                            printf("Skipping duplicate collection: %s\n", temp_collection.name);
-                            is_duplicate = true;
-                            break;
-                        }
-                    }
-
-                    if (!is_duplicate) {
-                        collection_manager_add_collection(manager, &temp_collection);
-                        printf("Added collection: %s\n", temp_collection.name);
-                    }
-                    collection_cleanup(&temp_collection);
-                }
-            }
-        } while (FindNextFileA(find_handle, &find_data));
-        FindClose(find_handle);
+    /* just read from disk, nothing to write back */
+    collection_mark_saved(&temp_collection, temp_collection.generation);
+    printf("Added collection: %s\n", temp_collection.name);
+    if (collection_manager_adopt_collection(manager, &temp_collection) < 0) {
+        collection_cleanup(&temp_collection);
     }
-#else
-
-    #include <dirent.h>
-    DIR* dir = opendir(collections_dir);
-    if (dir != NULL) {
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != NULL) {
-
-            if (strstr(entry->d_name, ".json") != NULL) {
-                char full_path[1024];
-                snprintf(full_path, sizeof(full_path), "%s/%s", collections_dir, entry->d_name);
-                struct stat file_stat;
-                if (stat(full_path, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
-                    printf("Loading collection from: %s\n", full_path);
-                    Collection temp_collection;
-                    memset(&temp_collection, 0, sizeof(Collection));
-
-                    int load_result;
-                    if (state) {
-
-                        load_result = persistence_load_collection_with_auth(&temp_collection, full_path, state);
+}
 
-                        if (!first_collection_loaded && load_result == PERSISTENCE_SUCCESS) {
-                            first_collection_loaded = true;
-                        }
-                    } else {
-                        load_result = persistence_load_collection_new(&temp_collection, full_path);
-                    }
+int persistence_load_all_collections(CollectionManager* manager) {
+    return persistence_load_all_collections_with_auth(manager, NULL);
+}
 
-                    if (load_result == PERSISTENCE_SUCCESS) {
+/* reads every collection file in turn on the calling thread, the app uses collection_loader instead */
+int persistence_load_all_collections_with_auth(CollectionManager* manager, void* app_state) {
+    if (!manager) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
 
-                        bool is_duplicate = false;
-                        for (int i = 0; i < manager->count; i++) {
-                            if (strcmp(manager->collections[i].id, temp_collection.id) == 0) {
-                                printf("Skipping duplicate collection: %s\n", temp_collection.name);
-                                is_duplicate = true;
-                                break;
-                            }
-                        }
+    persistence_load_collection_manager_state(manager);
 
-                        if (!is_duplicate) {
-                            collection_manager_add_collection(manager, &temp_collection);
-                            printf("Added collection: %s\n", temp_collection.name);
-                        }
-                        collection_cleanup(&temp_collection);
-                    }
-                }
-            }
-        }
-        closedir(dir);
-    }
-#endif
+    LoadAllContext context = { manager, (AppState*)app_state };
+    int result = persistence_for_each_collection_file(load_collection_file_into_manager, &context);
 
-    free(collections_dir);
-    printf("Loaded %d collections total with authentication data\n", manager->count);
-    return PERSISTENCE_SUCCESS;
+    printf("Loaded %d collections total\n", manager->count);
+    return result;
 }
 
-int persistence_save_collection_manager_state(const CollectionManager* manager) {
+/* builds the json text for collections_state.json. the caller frees the result */
+char* persistence_serialize_collection_manager_state(const CollectionManager* manager) {
     if (!manager) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
+        return NULL;
     }
 
     cJSON* json = cJSON_CreateObject();
     if (!json) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
     cJSON* active_collection = cJSON_CreateNumber(manager->active_collection_index);
@@ -1711,7 +1963,7 @@ int persistence_save_collection_manager_state(const CollectionManager* manager)
 
     if (!active_collection || !active_request || !collection_count) {
         cJSON_Delete(json);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
     cJSON_AddItemToObject(json, "active_collection_index", active_collection);
@@ -1721,7 +1973,7 @@ int persistence_save_collection_manager_state(const CollectionManager* manager)
     cJSON* collection_ids = cJSON_CreateArray();
     if (!collection_ids) {
         cJSON_Delete(json);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
     for (int i = 0; i < manager->count; i++) {
@@ -1732,9 +1984,40 @@ int persistence_save_collection_manager_state(const CollectionManager* manager)
     }
     cJSON_AddItemToObject(json, "collection_ids", collection_ids);
 
+    /* enough to draw the tree before any collection file is read */
+    cJSON* collections = cJSON_CreateArray();
+    if (!collections) {
+        cJSON_Delete(json);
+        return NULL;
+    }
+
+    for (int i = 0; i < manager->count; i++) {
+        const Collection* collection = &manager->collections[i];
+        cJSON* entry = cJSON_CreateObject();
+        if (!entry) {
+            continue;
+        }
+        cJSON_AddStringToObject(entry, "id", collection->id);
+        cJSON_AddStringToObject(entry, "name", collection->name);
+        cJSON_AddStringToObject(entry, "description", collection->description);
+        cJSON_AddNumberToObject(entry, "created_at", (double)collection->created_at);
+        cJSON_AddNumberToObject(entry, "modified_at", (double)collection->modified_at);
+        cJSON_AddItemToArray(collections, entry);
+    }
+    cJSON_AddItemToObject(json, "collections", collections);
+
     char* json_string = cJSON_Print(json);
     cJSON_Delete(json);
 
+    return json_string;
+}
+
+int persistence_save_collection_manager_state(const CollectionManager* manager) {
+    if (!manager) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+
+    char* json_string = persistence_serialize_collection_manager_state(manager);
     if (!json_string) {
         return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
     }
@@ -1745,78 +2028,43 @@ int persistence_save_collection_manager_state(const CollectionManager* manager)
         return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
     }
 
-    FILE* file = fopen(filepath, "w");
-    if (!file) {
-        free(json_string);
-        free(filepath);
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    size_t json_len = strlen(json_string);
-    size_t written = fwrite(json_string, 1, json_len, file);
-    fclose(file);
+    int result = persistence_write_file_atomic(filepath, json_string, strlen(json_string));
 
     free(json_string);
     free(filepath);
 
-    return (written == json_len) ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_DISK_FULL;
-}
-
-int persistence_load_collection_manager_state(CollectionManager* manager) {
-    if (!manager) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
     }
 
+    g_saved_manager_state_hash = persistence_manager_state_hash(manager);
+    return PERSISTENCE_SUCCESS;
+}
+
+static cJSON* read_collection_manager_state(int* error) {
     char* filepath = persistence_get_config_path("collections_state.json");
     if (!filepath) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
-    }
-
-    if (!persistence_file_exists(filepath)) {
-        free(filepath);
-        return PERSISTENCE_ERROR_FILE_NOT_FOUND;
-    }
-
-    FILE* file = fopen(filepath, "rb");
-    if (!file) {
-        free(filepath);
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    if (file_size <= 0) {
-        fclose(file);
-        free(filepath);
-        return PERSISTENCE_ERROR_CORRUPTED_DATA;
-    }
-
-    char* json_string = (char*)malloc(file_size + 1);
-    if (!json_string) {
-        fclose(file);
-        free(filepath);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        *error = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
     }
 
-    size_t read_size = fread(json_string, 1, file_size, file);
-    json_string[read_size] = '\0';
-    fclose(file);
+    size_t length = 0;
+    char* json_string = read_whole_file(filepath, &length, error);
     free(filepath);
-
-    if (read_size != (size_t)file_size) {
-        free(json_string);
-        return PERSISTENCE_ERROR_CORRUPTED_DATA;
+    if (!json_string) {
+        return NULL;
     }
 
     cJSON* json = cJSON_Parse(json_string);
     free(json_string);
 
     if (!json) {
-        return PERSISTENCE_ERROR_INVALID_JSON;
+        *error = PERSISTENCE_ERROR_INVALID_JSON;
     }
+    return json;
+}
 
+static void apply_active_indices(CollectionManager* manager, const cJSON* json) {
     cJSON* active_collection = cJSON_GetObjectItem(json, "active_collection_index");
     cJSON* active_request = cJSON_GetObjectItem(json, "active_request_index");
 
@@ -1827,130 +2075,88 @@ int persistence_load_collection_manager_state(CollectionManager* manager) {
     if (active_request && cJSON_IsNumber(active_request)) {
         manager->active_request_index = (int)active_request->valuedouble;
     }
-
-    cJSON_Delete(json);
-    return PERSISTENCE_SUCCESS;
-}
-
-int persistence_auto_save_collections(const CollectionManager* manager) {
-    if (!manager) {
-        return PERSISTENCE_ERROR_NULL_PARAM;
-    }
-
-    int backup_result = persistence_create_auto_save_backup(manager);
-    if (backup_result != PERSISTENCE_SUCCESS) {
-        return backup_result;
-    }
-
-    return persistence_save_all_collections(manager);
 }
 
-int persistence_restore_from_auto_save(CollectionManager* manager) {
+int persistence_load_collection_manager_state(CollectionManager* manager) {
     if (!manager) {
         return PERSISTENCE_ERROR_NULL_PARAM;
     }
 
-    char* backup_path = persistence_get_auto_save_path("collections_backup.json");
-    if (!backup_path) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    int error = PERSISTENCE_SUCCESS;
+    cJSON* json = read_collection_manager_state(&error);
+    if (!json) {
+        return error;
     }
 
-    if (!persistence_file_exists(backup_path)) {
-        free(backup_path);
-        return PERSISTENCE_ERROR_FILE_NOT_FOUND;
-    }
+    apply_active_indices(manager, json);
 
-    free(backup_path);
+    cJSON_Delete(json);
     return PERSISTENCE_SUCCESS;
 }
 
-int persistence_create_auto_save_backup(const CollectionManager* manager) {
+/* adds an empty, not yet loaded collection for every manifest entry in
+ * collections_state.json. returns how many were added, or a PersistenceError
+ * when there is no manifest - files written before it existed only list ids */
+int persistence_load_collection_manifest(CollectionManager* manager) {
     if (!manager) {
         return PERSISTENCE_ERROR_NULL_PARAM;
     }
 
-    if (persistence_create_auto_save_dir() != 0) {
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    cJSON* json = cJSON_CreateObject();
+    int error = PERSISTENCE_SUCCESS;
+    cJSON* json = read_collection_manager_state(&error);
     if (!json) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
-    }
-
-    cJSON* timestamp = cJSON_CreateNumber((double)time(NULL));
-    if (!timestamp) {
-        cJSON_Delete(json);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return error;
     }
-    cJSON_AddItemToObject(json, "backup_timestamp", timestamp);
 
-    cJSON* collections_array = cJSON_CreateArray();
-    if (!collections_array) {
+    cJSON* collections = cJSON_GetObjectItem(json, "collections");
+    if (!collections || !cJSON_IsArray(collections)) {
+        apply_active_indices(manager, json);
         cJSON_Delete(json);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return PERSISTENCE_ERROR_FILE_NOT_FOUND;
     }
 
-    for (int i = 0; i < manager->count; i++) {
-        const Collection* collection = &manager->collections[i];
+    int added = 0;
+    cJSON* entry = NULL;
+    cJSON_ArrayForEach(entry, collections) {
+        cJSON* id = cJSON_GetObjectItem(entry, "id");
+        cJSON* name = cJSON_GetObjectItem(entry, "name");
+        cJSON* description = cJSON_GetObjectItem(entry, "description");
+        cJSON* created_at = cJSON_GetObjectItem(entry, "created_at");
+        cJSON* modified_at = cJSON_GetObjectItem(entry, "modified_at");
 
-        cJSON* collection_json = cJSON_CreateObject();
-        if (!collection_json) {
-            cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        if (!id || !cJSON_IsString(id) || !id->valuestring[0] || !name || !cJSON_IsString(name)) {
+            continue;
         }
 
-        cJSON* col_id = cJSON_CreateString(collection->id);
-        cJSON* col_name = cJSON_CreateString(collection->name);
-        cJSON* col_request_count = cJSON_CreateNumber(collection->request_count);
-
-        if (!col_id || !col_name || !col_request_count) {
-            cJSON_Delete(collection_json);
-            cJSON_Delete(json);
-            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        Collection placeholder;
+        memset(&placeholder, 0, sizeof(Collection));
+        collection_init(&placeholder, name->valuestring,
+                        description && cJSON_IsString(description) ? description->valuestring : "");
+        strncpy(placeholder.id, id->valuestring, sizeof(placeholder.id) - 1);
+        placeholder.id[sizeof(placeholder.id) - 1] = '\0';
+        if (created_at && cJSON_IsNumber(created_at)) {
+            placeholder.created_at = (time_t)created_at->valuedouble;
         }
+        if (modified_at && cJSON_IsNumber(modified_at)) {
+            placeholder.modified_at = (time_t)modified_at->valuedouble;
+        }
+        placeholder.loaded = false;
 
-        cJSON_AddItemToObject(collection_json, "id", col_id);
-        cJSON_AddItemToObject(collection_json, "name", col_name);
-        cJSON_AddItemToObject(collection_json, "request_count", col_request_count);
-
-        cJSON_AddItemToArray(collections_array, collection_json);
-    }
-    cJSON_AddItemToObject(json, "collections", collections_array);
-
-    char* json_string = cJSON_Print(json);
-    cJSON_Delete(json);
-
-    if (!json_string) {
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        if (collection_manager_adopt_collection(manager, &placeholder) < 0) {
+            collection_cleanup(&placeholder);
+            break;
+        }
+        added++;
     }
 
-    char* backup_path = persistence_get_auto_save_path("collections_backup.json");
-    if (!backup_path) {
-        free(json_string);
-        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    apply_active_indices(manager, json);
+    if (manager->active_collection_index >= manager->count) {
+        manager->active_collection_index = manager->count > 0 ? 0 : -1;
+        manager->active_request_index = -1;
     }
 
-    FILE* file = fopen(backup_path, "w");
-    if (!file) {
-        free(json_string);
-        free(backup_path);
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    size_t json_len = strlen(json_string);
-    size_t written = fwrite(json_string, 1, json_len, file);
-    fclose(file);
-
-    free(json_string);
-    free(backup_path);
-
-    return (written == json_len) ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_DISK_FULL;
-}
-
-int persistence_cleanup_old_auto_saves(int keep_count) {
-
-    return PERSISTENCE_SUCCESS;
+    cJSON_Delete(json);
+    return added;
 }
 
 int persistence_migrate_legacy_requests(CollectionManager* manager) {
@@ -2284,21 +2490,12 @@ int persistence_save_settings(const CollectionManager* manager, bool auto_save_e
         return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
     }
 
-    FILE* file = fopen(filepath, "w");
-    if (!file) {
-        free(json_string);
-        free(filepath);
-        return PERSISTENCE_ERROR_PERMISSION_DENIED;
-    }
-
-    size_t json_len = strlen(json_string);
-    size_t written = fwrite(json_string, 1, json_len, file);
-    fclose(file);
+    int result = persistence_write_file_atomic(filepath, json_string, strlen(json_string));
 
     free(json_string);
     free(filepath);
 
-    return (written == json_len) ? PERSISTENCE_SUCCESS : PERSISTENCE_ERROR_DISK_FULL;
+    return result;
 }
 
 int persistence_load_settings(bool* auto_save_enabled, int* auto_save_interval) {
@@ -2678,6 +2875,8 @@ const char* persistence_error_string(PersistenceError error) {
             return "Disk full or unable to write file";
         case PERSISTENCE_ERROR_INVALID_PATH:
             return "Invalid file path or location";
+        case PERSISTENCE_ERROR_CANCELLED:
+            return "Operation cancelled";
         default:
             return "Unknown error occurred";
     }
@@ -2718,6 +2917,10 @@ const char* persistence_get_user_friendly_error(PersistenceError error, const ch
             snprintf(error_buffer, sizeof(error_buffer), 
                     "Invalid file location for %s. Please check the file path.", operation);
             break;
+        case PERSISTENCE_ERROR_CANCELLED:
+            snprintf(error_buffer, sizeof(error_buffer), 
+                    "Cancelled before being able to %s.", operation);
+            break;
         default:
             snprintf(error_buffer, sizeof(error_buffer), 
                     "An unknown error occurred while trying to %s.", operation);
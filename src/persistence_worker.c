@@ -0,0 +1,588 @@
+/**
+ * background saving for tinyrequest
+ *
+ * one worker thread is started the first time something is queued and
+ * lives until the worker is destroyed. jobs own everything they write - a
+ * collection snapshot, or text that was cheap enough to serialize on the
+ * ui thread - so the thread never touches live app state. the queue is
+ * kept in submission order and a job keeps its place and its age when a
+ * newer snapshot replaces it, so a steady stream of edits still gets
+ * written every PERSISTENCE_WORKER_COALESCE_MS. journal appends are taken
+ * ahead of everything else, in the order they were queued.
+ */
+
+#include "persistence_worker.h"
+#include "collection_journal.h"
+#include "snapshot_store.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef struct {
+    int kind;                   /* PersistenceJobKind */
+    char collection_id[64];
+    unsigned int generation;
+    Collection snapshot;        /* PERSISTENCE_JOB_SAVE_COLLECTION */
+    bool has_auth;
+    PersistenceAuth auth;
+    char* text;                 /* PERSISTENCE_JOB_SAVE_MANAGER_STATE and the journal records */
+    size_t text_length;
+    double queued_ms;
+} PersistenceJob;
+
+struct PersistenceWorker {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        /* new jobs, flush requests and shutdown */
+    pthread_cond_t idle_cond;   /* a job finished */
+    pthread_t thread;
+    bool thread_started;
+    bool shutting_down;
+    int flush_requests;
+
+    PersistenceJob** jobs;
+    int job_count;
+    int job_capacity;
+    PersistenceJob* active;
+
+    PersistenceCompletion* finished;
+    int finished_count;
+    int finished_capacity;
+
+    /* ui thread only, what collections_state.json was last queued with */
+    bool has_state_hash;
+    unsigned long queued_state_hash;
+};
+
+/* global out-of-memory handler */
+static void (*g_persistence_worker_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_persistence_worker_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_persistence_worker_out_of_memory_handler) {
+        g_persistence_worker_out_of_memory_handler(operation);
+    } else {
+        default_persistence_worker_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void persistence_worker_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_persistence_worker_out_of_memory_handler = handler;
+}
+
+static double persistence_worker_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void job_free(PersistenceJob* job) {
+    if (!job) {
+        return;
+    }
+
+    if (job->kind == PERSISTENCE_JOB_SAVE_COLLECTION) {
+        collection_cleanup(&job->snapshot);
+    }
+    free(job->text);
+    free(job);
+}
+
+static PersistenceJob* job_create(int kind, const char* collection_id) {
+    PersistenceJob* job = (PersistenceJob*)calloc(1, sizeof(PersistenceJob));
+    if (!job) {
+        handle_out_of_memory("persistence job");
+        return NULL;
+    }
+
+    job->kind = kind;
+    if (collection_id) {
+        snprintf(job->collection_id, sizeof(job->collection_id), "%s", collection_id);
+    }
+    return job;
+}
+
+/* serializes and writes one job, runs without the lock held */
+static void run_job(const PersistenceJob* job, PersistenceCompletion* completion) {
+    memset(completion, 0, sizeof(PersistenceCompletion));
+    completion->kind = job->kind;
+    completion->generation = job->generation;
+    memcpy(completion->collection_id, job->collection_id, sizeof(completion->collection_id));
+
+    double started = persistence_worker_now_ms();
+    int result = PERSISTENCE_SUCCESS;
+    char* filepath = NULL;
+
+    switch (job->kind) {
+        case PERSISTENCE_JOB_SAVE_COLLECTION:
+            if (persistence_create_config_dir() != 0 || persistence_create_collections_dir() != 0) {
+                result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+                break;
+            }
+            result = persistence_write_collection_snapshot(&job->snapshot, job->has_auth ? &job->auth : NULL);
+            completion->journal_seq = job->snapshot.journal_seq;
+
+            /* what is left of the journal is replayed on top of the new snapshot, a failed
+             * trim only means the same records are skipped again on the next load */
+            if (result == PERSISTENCE_SUCCESS) {
+                collection_journal_compact(job->collection_id, job->snapshot.journal_seq);
+            }
+            break;
+
+        case PERSISTENCE_JOB_SAVE_MANAGER_STATE:
+            if (persistence_create_config_dir() != 0) {
+                result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+                break;
+            }
+            filepath = persistence_get_config_path("collections_state.json");
+            if (!filepath) {
+                result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+                break;
+            }
+            result = persistence_write_file_atomic(filepath, job->text, strlen(job->text));
+            break;
+
+        case PERSISTENCE_JOB_DELETE_COLLECTION:
+            result = persistence_delete_collection_file(job->collection_id);
+            if (result == PERSISTENCE_SUCCESS) {
+                result = collection_journal_remove(job->collection_id);
+            }
+            break;
+
+        case PERSISTENCE_JOB_APPEND_JOURNAL:
+            /* records only make sense on top of a snapshot, without one the ui writes one instead */
+            filepath = persistence_find_collection_file(job->collection_id);
+            if (!filepath) {
+                result = PERSISTENCE_ERROR_FILE_NOT_FOUND;
+            } else {
+                result = collection_journal_append(job->collection_id, job->text, job->text_length);
+            }
+            break;
+
+        case PERSISTENCE_JOB_AUTO_SNAPSHOT:
+            result = snapshot_store_create(NULL, 0, NULL);
+            if (result == PERSISTENCE_SUCCESS) {
+                result = snapshot_store_rotate(SNAPSHOT_STORE_KEEP);
+            }
+            break;
+
+        default:
+            result = PERSISTENCE_ERROR_NULL_PARAM;
+            break;
+    }
+
+    free(filepath);
+
+    completion->result = result;
+    completion->duration_ms = persistence_worker_now_ms() - started;
+}
+
+/* waits on cond for up to wait_ms, the mutex must be held */
+static void timed_wait(PersistenceWorker* worker, double wait_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    long long nanoseconds = deadline.tv_nsec + (long long)(wait_ms * 1000000.0);
+    deadline.tv_sec += (time_t)(nanoseconds / 1000000000LL);
+    deadline.tv_nsec = (long)(nanoseconds % 1000000000LL);
+
+    pthread_cond_timedwait(&worker->cond, &worker->mutex, &deadline);
+}
+
+/* adds a completion for the ui, the mutex must be held */
+static void push_completion(PersistenceWorker* worker, const PersistenceCompletion* completion) {
+    if (worker->finished_count >= worker->finished_capacity) {
+        int capacity = worker->finished_capacity > 0 ? worker->finished_capacity * 2 : 16;
+        PersistenceCompletion* finished = (PersistenceCompletion*)realloc(worker->finished,
+                                                                          capacity * sizeof(PersistenceCompletion));
+        if (!finished) {
+            /* the collection simply stays dirty and is written again by the next save */
+            handle_out_of_memory("persistence completion");
+            return;
+        }
+        worker->finished = finished;
+        worker->finished_capacity = capacity;
+    }
+
+    worker->finished[worker->finished_count++] = *completion;
+}
+
+/* worker loop, writes the oldest job once it has waited out the coalescing window */
+static void* persistence_worker_thread(void* arg) {
+    PersistenceWorker* worker = (PersistenceWorker*)arg;
+
+    pthread_mutex_lock(&worker->mutex);
+    for (;;) {
+        if (worker->job_count == 0) {
+            if (worker->shutting_down) {
+                break;
+            }
+            pthread_cond_wait(&worker->cond, &worker->mutex);
+            continue;
+        }
+
+        /* an edit waiting for its journal append goes before any snapshot */
+        int index = 0;
+        for (int i = 0; i < worker->job_count; i++) {
+            if (worker->jobs[i]->kind == PERSISTENCE_JOB_APPEND_JOURNAL) {
+                index = i;
+                break;
+            }
+        }
+
+        PersistenceJob* job = worker->jobs[index];
+        double wait_ms = job->queued_ms + PERSISTENCE_WORKER_COALESCE_MS - persistence_worker_now_ms();
+        if (job->kind != PERSISTENCE_JOB_APPEND_JOURNAL && wait_ms > 0.0 &&
+            !worker->shutting_down && worker->flush_requests == 0) {
+            timed_wait(worker, wait_ms);
+            continue;
+        }
+
+        worker->job_count--;
+        memmove(&worker->jobs[index], &worker->jobs[index + 1],
+                (worker->job_count - index) * sizeof(PersistenceJob*));
+        worker->active = job;
+        pthread_mutex_unlock(&worker->mutex);
+
+        PersistenceCompletion completion;
+        run_job(job, &completion);
+
+        pthread_mutex_lock(&worker->mutex);
+        worker->active = NULL;
+        job_free(job);
+        push_completion(worker, &completion);
+        pthread_cond_broadcast(&worker->idle_cond);
+        wake_signal_post();
+    }
+    pthread_mutex_unlock(&worker->mutex);
+
+    return NULL;
+}
+
+/* creates a worker, the thread is started on first use */
+PersistenceWorker* persistence_worker_create(void) {
+    PersistenceWorker* worker = (PersistenceWorker*)calloc(1, sizeof(PersistenceWorker));
+    if (!worker) {
+        handle_out_of_memory("persistence worker creation");
+        return NULL;
+    }
+
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    pthread_cond_init(&worker->idle_cond, NULL);
+    return worker;
+}
+
+/* writes what is still queued, stops the thread and frees everything */
+void persistence_worker_destroy(PersistenceWorker* worker) {
+    if (!worker) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+    worker->shutting_down = true;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+
+    if (worker->thread_started) {
+        pthread_join(worker->thread, NULL);
+    }
+
+    for (int i = 0; i < worker->job_count; i++) {
+        job_free(worker->jobs[i]);
+    }
+    free(worker->jobs);
+    free(worker->finished);
+
+    pthread_cond_destroy(&worker->idle_cond);
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->mutex);
+    free(worker);
+}
+
+/* index of the queued job a new one would replace, -1 if there is none. journal
+ * records and snapshots are never replaced and never replace anything, a
+ * snapshot has to stay behind the saves queued before it. a second one just
+ * finds nothing new. the mutex must be held */
+static int find_queued_job(PersistenceWorker* worker, int kind, const char* collection_id) {
+    if (kind == PERSISTENCE_JOB_APPEND_JOURNAL || kind == PERSISTENCE_JOB_AUTO_SNAPSHOT) {
+        return -1;
+    }
+
+    for (int i = 0; i < worker->job_count; i++) {
+        const PersistenceJob* job = worker->jobs[i];
+        if (job->kind == PERSISTENCE_JOB_APPEND_JOURNAL || job->kind == PERSISTENCE_JOB_AUTO_SNAPSHOT) {
+            continue;
+        }
+        if (kind == PERSISTENCE_JOB_SAVE_MANAGER_STATE) {
+            if (job->kind == PERSISTENCE_JOB_SAVE_MANAGER_STATE) {
+                return i;
+            }
+        } else if (job->kind != PERSISTENCE_JOB_SAVE_MANAGER_STATE &&
+                   strcmp(job->collection_id, collection_id) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* puts a job in the queue, replacing the one it supersedes in place. takes ownership of job */
+static int enqueue_job(PersistenceWorker* worker, PersistenceJob* job) {
+    pthread_mutex_lock(&worker->mutex);
+
+    if (!worker->thread_started) {
+        if (pthread_create(&worker->thread, NULL, persistence_worker_thread, worker) != 0) {
+            pthread_mutex_unlock(&worker->mutex);
+            job_free(job);
+            return -1;
+        }
+        worker->thread_started = true;
+    }
+
+    int index = find_queued_job(worker, job->kind, job->collection_id);
+    if (index >= 0) {
+        job->queued_ms = worker->jobs[index]->queued_ms;
+        job_free(worker->jobs[index]);
+        worker->jobs[index] = job;
+    } else {
+        if (worker->job_count >= worker->job_capacity) {
+            int capacity = worker->job_capacity > 0 ? worker->job_capacity * 2 : 16;
+            PersistenceJob** jobs = (PersistenceJob**)realloc(worker->jobs, capacity * sizeof(PersistenceJob*));
+            if (!jobs) {
+                pthread_mutex_unlock(&worker->mutex);
+                handle_out_of_memory("persistence queue");
+                job_free(job);
+                return -1;
+            }
+            worker->jobs = jobs;
+            worker->job_capacity = capacity;
+        }
+        job->queued_ms = persistence_worker_now_ms();
+        worker->jobs[worker->job_count++] = job;
+    }
+
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+    return 0;
+}
+
+/* true when this generation of the collection is already queued or being written */
+static bool is_generation_pending(PersistenceWorker* worker, const Collection* collection) {
+    pthread_mutex_lock(&worker->mutex);
+
+    bool pending = false;
+    int index = find_queued_job(worker, PERSISTENCE_JOB_SAVE_COLLECTION, collection->id);
+    if (index >= 0) {
+        const PersistenceJob* job = worker->jobs[index];
+        pending = job->kind == PERSISTENCE_JOB_SAVE_COLLECTION && job->generation == collection->generation;
+    } else if (worker->active && worker->active->kind == PERSISTENCE_JOB_SAVE_COLLECTION) {
+        pending = worker->active->generation == collection->generation &&
+                  strcmp(worker->active->collection_id, collection->id) == 0;
+    }
+
+    pthread_mutex_unlock(&worker->mutex);
+    return pending;
+}
+
+/* snapshots the collection on the calling thread and queues it */
+int persistence_worker_save_collection(PersistenceWorker* worker, const Collection* collection,
+                                       const PersistenceAuth* auth) {
+    if (!worker || !collection) {
+        return -1;
+    }
+
+    /* a placeholder from the manifest has no requests yet, writing it would empty the file */
+    if (!collection->loaded) {
+        return 0;
+    }
+
+    if (is_generation_pending(worker, collection)) {
+        return 0;
+    }
+
+    PersistenceJob* job = job_create(PERSISTENCE_JOB_SAVE_COLLECTION, collection->id);
+    if (!job) {
+        return -1;
+    }
+
+    if (collection_copy(&job->snapshot, collection) != 0) {
+        free(job);
+        return -1;
+    }
+    job->generation = collection->generation;
+    if (auth) {
+        job->auth = *auth;
+        job->has_auth = true;
+    }
+
+    return enqueue_job(worker, job) == 0 ? 1 : -1;
+}
+
+/* the manager state is a handful of ids, it is serialized right away */
+int persistence_worker_save_manager_state(PersistenceWorker* worker, const CollectionManager* manager) {
+    if (!worker || !manager) {
+        return -1;
+    }
+
+    PersistenceJob* job = job_create(PERSISTENCE_JOB_SAVE_MANAGER_STATE, NULL);
+    if (!job) {
+        return -1;
+    }
+
+    job->text = persistence_serialize_collection_manager_state(manager);
+    if (!job->text) {
+        free(job);
+        return -1;
+    }
+
+    return enqueue_job(worker, job);
+}
+
+int persistence_worker_append_journal(PersistenceWorker* worker, const char* collection_id,
+                                      unsigned int generation, char* records, size_t length) {
+    if (!worker || !collection_id || collection_id[0] == '\0' || !records || length == 0) {
+        free(records);
+        return -1;
+    }
+
+    PersistenceJob* job = job_create(PERSISTENCE_JOB_APPEND_JOURNAL, collection_id);
+    if (!job) {
+        free(records);
+        return -1;
+    }
+
+    job->generation = generation;
+    job->text = records;
+    job->text_length = length;
+    return enqueue_job(worker, job);
+}
+
+int persistence_worker_delete_collection(PersistenceWorker* worker, const char* collection_id) {
+    if (!worker || !collection_id || collection_id[0] == '\0') {
+        return -1;
+    }
+
+    PersistenceJob* job = job_create(PERSISTENCE_JOB_DELETE_COLLECTION, collection_id);
+    if (!job) {
+        return -1;
+    }
+
+    return enqueue_job(worker, job);
+}
+
+/* the snapshot reads the files itself, the job carries nothing */
+int persistence_worker_snapshot(PersistenceWorker* worker) {
+    if (!worker) {
+        return -1;
+    }
+
+    PersistenceJob* job = job_create(PERSISTENCE_JOB_AUTO_SNAPSHOT, NULL);
+    if (!job) {
+        return -1;
+    }
+    return enqueue_job(worker, job);
+}
+
+/* queues every collection that changed since it was last written */
+int persistence_worker_save_dirty(PersistenceWorker* worker, const CollectionManager* manager,
+                                  const void* app_state) {
+    if (!worker || !manager) {
+        return -1;
+    }
+
+    PersistenceAuth auth;
+    persistence_auth_from_app_state(&auth, app_state);
+
+    bool failed = false;
+    int queued = 0;
+
+    for (int i = 0; i < manager->count; i++) {
+        const Collection* collection = &manager->collections[i];
+        if (!collection_is_dirty(collection)) {
+            continue;
+        }
+
+        int result = persistence_worker_save_collection(worker, collection, app_state ? &auth : NULL);
+        if (result < 0) {
+            failed = true;
+        } else {
+            queued += result;
+        }
+    }
+
+    unsigned long state_hash = persistence_manager_state_hash(manager);
+    if (!worker->has_state_hash || state_hash != worker->queued_state_hash) {
+        if (persistence_worker_save_manager_state(worker, manager) == 0) {
+            worker->queued_state_hash = state_hash;
+            worker->has_state_hash = true;
+        } else {
+            failed = true;
+        }
+    }
+
+    return failed ? -1 : queued;
+}
+
+/* takes the oldest finished job, returns false if there is none */
+bool persistence_worker_poll(PersistenceWorker* worker, PersistenceCompletion* completion) {
+    if (!worker || !completion) {
+        return false;
+    }
+
+    bool found = false;
+    pthread_mutex_lock(&worker->mutex);
+    if (worker->finished_count > 0) {
+        *completion = worker->finished[0];
+        worker->finished_count--;
+        memmove(&worker->finished[0], &worker->finished[1], worker->finished_count * sizeof(PersistenceCompletion));
+        found = true;
+    }
+    pthread_mutex_unlock(&worker->mutex);
+
+    /* a failed state write is queued again by the next save */
+    if (found && completion->kind == PERSISTENCE_JOB_SAVE_MANAGER_STATE &&
+        completion->result != PERSISTENCE_SUCCESS) {
+        worker->has_state_hash = false;
+    }
+
+    return found;
+}
+
+int persistence_worker_get_pending_count(PersistenceWorker* worker) {
+    if (!worker) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+    int pending = worker->job_count + (worker->active ? 1 : 0);
+    pthread_mutex_unlock(&worker->mutex);
+
+    return pending;
+}
+
+/* skips the coalescing window and blocks until the queue has drained */
+void persistence_worker_flush(PersistenceWorker* worker) {
+    if (!worker) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+    if (worker->thread_started) {
+        worker->flush_requests++;
+        pthread_cond_signal(&worker->cond);
+        while (worker->job_count > 0 || worker->active) {
+            pthread_cond_wait(&worker->idle_cond, &worker->mutex);
+        }
+        worker->flush_requests--;
+    }
+    pthread_mutex_unlock(&worker->mutex);
+}
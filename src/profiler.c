@@ -0,0 +1,306 @@
+/**
+ * frame and subsystem timing for tinyrequest
+ *
+ * frames live in a fixed ring so recording never allocates. each frame
+ * keeps its own sample array, a scope token is simply the index of its
+ * sample in the current frame. open scopes are tracked with a depth
+ * counter, which is all the trace and the overlay need to nest them.
+ */
+
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static ProfilerFrame g_frames[PROFILER_FRAME_HISTORY];
+static int g_frame_head = 0;   /* slot the next frame is recorded into */
+static int g_frame_count = 0;
+static bool g_enabled = false;
+static bool g_in_frame = false;
+static int g_depth = 0;
+static double g_origin_ms = 0.0;
+static double g_frame_start_ms = 0.0;
+
+static double profiler_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* turns recording on or off, history is kept either way */
+void profiler_set_enabled(bool enabled) {
+    if (enabled && !g_enabled && g_frame_count == 0) {
+        g_origin_ms = profiler_now_ms();
+    }
+    g_enabled = enabled;
+    if (!enabled) {
+        g_in_frame = false;
+    }
+}
+
+bool profiler_is_enabled(void) {
+    return g_enabled;
+}
+
+/* drops every recorded frame */
+void profiler_reset(void) {
+    g_frame_head = 0;
+    g_frame_count = 0;
+    g_in_frame = false;
+    g_depth = 0;
+    g_origin_ms = profiler_now_ms();
+}
+
+/* starts recording a frame into the next ring slot */
+void profiler_frame_begin(void) {
+    if (!g_enabled) {
+        return;
+    }
+
+    ProfilerFrame* frame = &g_frames[g_frame_head];
+    g_frame_start_ms = profiler_now_ms();
+    frame->start_ms = g_frame_start_ms - g_origin_ms;
+    frame->duration_ms = 0.0;
+    frame->sample_count = 0;
+    g_depth = 0;
+    g_in_frame = true;
+}
+
+/* finishes the current frame and makes it visible to readers */
+void profiler_frame_end(void) {
+    if (!g_in_frame) {
+        return;
+    }
+
+    g_frames[g_frame_head].duration_ms = profiler_now_ms() - g_frame_start_ms;
+    g_frame_head = (g_frame_head + 1) % PROFILER_FRAME_HISTORY;
+    if (g_frame_count < PROFILER_FRAME_HISTORY) {
+        g_frame_count++;
+    }
+    g_in_frame = false;
+}
+
+/* opens a scope, returns a token for profiler_scope_end or -1 if nothing is recorded */
+int profiler_scope_begin(const char* name) {
+    if (!g_in_frame || !name) {
+        return -1;
+    }
+
+    ProfilerFrame* frame = &g_frames[g_frame_head];
+    if (frame->sample_count >= PROFILER_MAX_SAMPLES_PER_FRAME || g_depth >= PROFILER_MAX_DEPTH) {
+        return -1;
+    }
+
+    int token = frame->sample_count++;
+    ProfilerSample* sample = &frame->samples[token];
+    sample->name = name;
+    sample->start_ms = profiler_now_ms() - g_frame_start_ms;
+    sample->duration_ms = 0.0;
+    sample->depth = g_depth++;
+    return token;
+}
+
+/* closes a scope opened in the current frame */
+void profiler_scope_end(int token) {
+    if (token < 0 || !g_in_frame) {
+        return;
+    }
+
+    ProfilerFrame* frame = &g_frames[g_frame_head];
+    if (token >= frame->sample_count) {
+        return;
+    }
+
+    ProfilerSample* sample = &frame->samples[token];
+    sample->duration_ms = profiler_now_ms() - g_frame_start_ms - sample->start_ms;
+    if (g_depth > 0) {
+        g_depth--;
+    }
+}
+
+int profiler_get_frame_count(void) {
+    return g_frame_count;
+}
+
+/* returns a recorded frame, index 0 is the oldest */
+const ProfilerFrame* profiler_get_frame(int index) {
+    if (index < 0 || index >= g_frame_count) {
+        return NULL;
+    }
+
+    int oldest = (g_frame_head - g_frame_count + PROFILER_FRAME_HISTORY) % PROFILER_FRAME_HISTORY;
+    return &g_frames[(oldest + index) % PROFILER_FRAME_HISTORY];
+}
+
+/* copies frame durations oldest first for plotting, returns how many were copied */
+int profiler_get_frame_times(float* times, int max_count) {
+    if (!times || max_count <= 0) {
+        return 0;
+    }
+
+    int count = g_frame_count < max_count ? g_frame_count : max_count;
+    int skip = g_frame_count - count;
+    for (int i = 0; i < count; i++) {
+        times[i] = (float)profiler_get_frame(skip + i)->duration_ms;
+    }
+    return count;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+    return (left > right) - (left < right);
+}
+
+/* returns the frame time below which the given fraction of frames fall, 0.99 for p99 */
+double profiler_get_frame_percentile(double percentile) {
+    if (g_frame_count == 0) {
+        return 0.0;
+    }
+
+    double durations[PROFILER_FRAME_HISTORY];
+    for (int i = 0; i < g_frame_count; i++) {
+        durations[i] = profiler_get_frame(i)->duration_ms;
+    }
+    qsort(durations, (size_t)g_frame_count, sizeof(double), compare_doubles);
+
+    if (percentile <= 0.0) {
+        return durations[0];
+    }
+    int index = (int)(percentile * g_frame_count + 0.999999) - 1;
+    if (index < 0) {
+        index = 0;
+    } else if (index >= g_frame_count) {
+        index = g_frame_count - 1;
+    }
+    return durations[index];
+}
+
+/* sums every scope by name over the recorded frames, returns the number of distinct scopes */
+int profiler_get_scope_stats(ProfilerScopeStats* stats, int max_count) {
+    if (!stats || max_count <= 0) {
+        return 0;
+    }
+
+    int last_frame[PROFILER_MAX_SCOPES];
+    int count = 0;
+
+    for (int f = 0; f < g_frame_count; f++) {
+        const ProfilerFrame* frame = profiler_get_frame(f);
+        for (int s = 0; s < frame->sample_count; s++) {
+            const ProfilerSample* sample = &frame->samples[s];
+
+            int slot = -1;
+            for (int i = 0; i < count; i++) {
+                if (stats[i].name == sample->name || strcmp(stats[i].name, sample->name) == 0) {
+                    slot = i;
+                    break;
+                }
+            }
+            if (slot < 0) {
+                if (count >= max_count || count >= PROFILER_MAX_SCOPES) {
+                    continue;
+                }
+                slot = count++;
+                memset(&stats[slot], 0, sizeof(ProfilerScopeStats));
+                stats[slot].name = sample->name;
+                last_frame[slot] = -1;
+            }
+
+            ProfilerScopeStats* entry = &stats[slot];
+            entry->calls++;
+            entry->total_ms += sample->duration_ms;
+            if (sample->duration_ms > entry->max_ms) {
+                entry->max_ms = sample->duration_ms;
+            }
+            if (last_frame[slot] != f) {
+                last_frame[slot] = f;
+                entry->frames++;
+            }
+        }
+    }
+
+    return count;
+}
+
+static void write_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+/* writes one complete ("X") trace event, times in microseconds */
+static void write_trace_event(FILE* file, const char* name, const char* category,
+                              double start_ms, double duration_ms, bool* first) {
+    fputs(*first ? "\n" : ",\n", file);
+    *first = false;
+    fputs("{\"name\":", file);
+    write_json_string(file, name);
+    fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+            category, start_ms * 1000.0, duration_ms * 1000.0);
+}
+
+/* writes the recorded frames as chrome trace json */
+int profiler_export_chrome_trace(const char* path) {
+    if (!path) {
+        return -1;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return -1;
+    }
+
+    bool first = true;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    fputs("\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"ui\"}}", file);
+    first = false;
+
+    for (int f = 0; f < g_frame_count; f++) {
+        const ProfilerFrame* frame = profiler_get_frame(f);
+        write_trace_event(file, "frame", "frame", frame->start_ms, frame->duration_ms, &first);
+        for (int s = 0; s < frame->sample_count; s++) {
+            const ProfilerSample* sample = &frame->samples[s];
+            write_trace_event(file, sample->name, "scope", frame->start_ms + sample->start_ms,
+                              sample->duration_ms, &first);
+        }
+    }
+
+    fputs("\n]}\n", file);
+
+    bool failed = ferror(file) != 0;
+    if (fclose(file) != 0) {
+        failed = true;
+    }
+    return failed ? -1 : 0;
+}
+
+long profiler_get_peak_rss_kb(void) {
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    /* macos reports bytes, linux kilobytes */
+    return (long)(usage.ru_maxrss / 1024);
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#endif
+}
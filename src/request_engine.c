@@ -0,0 +1,480 @@
+/**
+ * background request execution for tinyrequest
+ *
+ * transfers live in a fixed table of slots, a slot is free while its id is
+ * 0. the worker threads and their http clients are created on the ui
+ * thread the first time something is submitted, since curl's global setup
+ * inside http_client_create is not safe to race. each worker takes the
+ * oldest queued slot, sends it without holding the engine lock and puts
+ * the response back into the slot for the ui to take.
+ *
+ * the ui never touches the request or response of a running slot, the
+ * only fields both sides write are the state, the progress numbers and
+ * the cancel flags, and those are guarded by the engine mutex.
+ */
+
+#include "request_engine.h"
+#include "http_client.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef struct {
+    int id;                     /* 0 while the slot is free */
+    int state;                  /* RequestTransferState */
+    unsigned long sequence;     /* submission order, the oldest queued slot runs first */
+    bool verify_ssl;
+    bool cancel_requested;
+    bool released;              /* nobody will take the response, free it when done */
+    Request request;
+    Response response;
+    int result;
+    double downloaded;
+    double download_total;
+    double started_ms;
+    double finished_ms;
+} RequestTransfer;
+
+typedef struct {
+    RequestEngine* engine;
+    HttpClient* client;
+    pthread_t thread;
+    RequestTransfer* transfer;  /* slot being sent, only read by this worker's progress callback */
+} RequestEngineWorker;
+
+struct RequestEngine {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool workers_started;
+    bool shutting_down;
+    bool verify_ssl;
+    int worker_count;
+    RequestEngineWorker workers[REQUEST_ENGINE_MAX_WORKERS];
+
+    RequestTransfer transfers[REQUEST_ENGINE_MAX_TRANSFERS];
+    int next_id;
+    unsigned long next_sequence;
+
+    CURLSH* share;
+    pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+};
+
+/* global out-of-memory handler */
+static void (*g_engine_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_engine_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_engine_out_of_memory_handler) {
+        g_engine_out_of_memory_handler(operation);
+    } else {
+        default_engine_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void request_engine_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_engine_out_of_memory_handler = handler;
+}
+
+static double engine_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr) {
+    (void)handle;
+    (void)access;
+    RequestEngine* engine = (RequestEngine*)userptr;
+    pthread_mutex_lock(&engine->share_locks[data]);
+}
+
+static void share_unlock(CURL* handle, curl_lock_data data, void* userptr) {
+    (void)handle;
+    RequestEngine* engine = (RequestEngine*)userptr;
+    pthread_mutex_unlock(&engine->share_locks[data]);
+}
+
+/* frees what a slot owns and marks it free, call with the mutex held */
+static void transfer_clear(RequestTransfer* transfer) {
+    request_cleanup(&transfer->request);
+    response_cleanup(&transfer->response);
+    memset(transfer, 0, sizeof(RequestTransfer));
+}
+
+static RequestTransfer* find_transfer(RequestEngine* engine, int transfer_id) {
+    if (transfer_id <= 0) {
+        return NULL;
+    }
+    for (int i = 0; i < REQUEST_ENGINE_MAX_TRANSFERS; i++) {
+        if (engine->transfers[i].id == transfer_id) {
+            return &engine->transfers[i];
+        }
+    }
+    return NULL;
+}
+
+/* oldest queued slot, call with the mutex held */
+static RequestTransfer* next_queued_transfer(RequestEngine* engine) {
+    RequestTransfer* oldest = NULL;
+    for (int i = 0; i < REQUEST_ENGINE_MAX_TRANSFERS; i++) {
+        RequestTransfer* transfer = &engine->transfers[i];
+        if (transfer->id != 0 && transfer->state == REQUEST_TRANSFER_QUEUED &&
+            (!oldest || transfer->sequence < oldest->sequence)) {
+            oldest = transfer;
+        }
+    }
+    return oldest;
+}
+
+/* records download progress and tells curl to stop once the transfer is cancelled */
+static int worker_progress_callback(void* userdata, double total, double now) {
+    RequestEngineWorker* worker = (RequestEngineWorker*)userdata;
+    RequestEngine* engine = worker->engine;
+
+    pthread_mutex_lock(&engine->mutex);
+    RequestTransfer* transfer = worker->transfer;
+    bool cancel = engine->shutting_down;
+    if (transfer) {
+        transfer->downloaded = now;
+        transfer->download_total = total;
+        cancel = cancel || transfer->cancel_requested;
+    }
+    pthread_mutex_unlock(&engine->mutex);
+
+    return cancel ? 1 : 0;
+}
+
+static void* request_engine_worker(void* arg) {
+    RequestEngineWorker* worker = (RequestEngineWorker*)arg;
+    RequestEngine* engine = worker->engine;
+
+    pthread_mutex_lock(&engine->mutex);
+    while (!engine->shutting_down) {
+        RequestTransfer* transfer = next_queued_transfer(engine);
+        if (!transfer) {
+            pthread_cond_wait(&engine->cond, &engine->mutex);
+            continue;
+        }
+
+        transfer->state = REQUEST_TRANSFER_RUNNING;
+        transfer->started_ms = engine_now_ms();
+        worker->transfer = transfer;
+        bool verify = transfer->verify_ssl;
+        pthread_mutex_unlock(&engine->mutex);
+
+        http_client_set_ssl_verification(worker->client, verify ? 1 : 0, verify ? 2 : 0);
+
+        Response response;
+        response_init(&response);
+        int result = http_client_send_request(worker->client, &transfer->request, &response);
+
+        pthread_mutex_lock(&engine->mutex);
+        worker->transfer = NULL;
+        if (transfer->released) {
+            response_cleanup(&response);
+            transfer_clear(transfer);
+        } else {
+            request_cleanup(&transfer->request);
+            transfer->response = response;
+            transfer->result = result;
+            transfer->finished_ms = engine_now_ms();
+            transfer->state = transfer->cancel_requested ? REQUEST_TRANSFER_CANCELLED : REQUEST_TRANSFER_DONE;
+        }
+        wake_signal_post();
+    }
+    pthread_mutex_unlock(&engine->mutex);
+
+    return NULL;
+}
+
+/* creates the clients and threads, call with the mutex held */
+static int start_workers(RequestEngine* engine) {
+    for (int i = 0; i < engine->worker_count; i++) {
+        RequestEngineWorker* worker = &engine->workers[i];
+        worker->engine = engine;
+        worker->client = http_client_create();
+        if (!worker->client) {
+            engine->worker_count = i;
+            break;
+        }
+
+        if (engine->share) {
+            curl_easy_setopt(worker->client->curl_handle, CURLOPT_SHARE, engine->share);
+        }
+        http_client_set_progress_callback(worker->client, worker_progress_callback, worker);
+
+        if (pthread_create(&worker->thread, NULL, request_engine_worker, worker) != 0) {
+            http_client_destroy(worker->client);
+            worker->client = NULL;
+            engine->worker_count = i;
+            break;
+        }
+    }
+
+    engine->workers_started = true;
+    return engine->worker_count > 0 ? 0 : -1;
+}
+
+/* creates an engine with the given number of workers, they are started on first use */
+RequestEngine* request_engine_create(int worker_count) {
+    RequestEngine* engine = (RequestEngine*)calloc(1, sizeof(RequestEngine));
+    if (!engine) {
+        handle_out_of_memory("request engine creation");
+        return NULL;
+    }
+
+    if (worker_count <= 0) {
+        worker_count = REQUEST_ENGINE_DEFAULT_WORKERS;
+    } else if (worker_count > REQUEST_ENGINE_MAX_WORKERS) {
+        worker_count = REQUEST_ENGINE_MAX_WORKERS;
+    }
+
+    pthread_mutex_init(&engine->mutex, NULL);
+    pthread_cond_init(&engine->cond, NULL);
+    engine->worker_count = worker_count;
+    engine->verify_ssl = true;
+    engine->next_id = 1;
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&engine->share_locks[i], NULL);
+    }
+
+    /* without a share handle every worker simply keeps its own connections */
+    engine->share = curl_share_init();
+    if (engine->share) {
+        curl_share_setopt(engine->share, CURLSHOPT_LOCKFUNC, share_lock);
+        curl_share_setopt(engine->share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+        curl_share_setopt(engine->share, CURLSHOPT_USERDATA, engine);
+        curl_share_setopt(engine->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(engine->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(engine->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    return engine;
+}
+
+/* cancels everything in flight, waits for the workers and frees the engine */
+void request_engine_destroy(RequestEngine* engine) {
+    if (!engine) {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    engine->shutting_down = true;
+    pthread_cond_broadcast(&engine->cond);
+    pthread_mutex_unlock(&engine->mutex);
+
+    if (engine->workers_started) {
+        for (int i = 0; i < engine->worker_count; i++) {
+            pthread_join(engine->workers[i].thread, NULL);
+        }
+    }
+
+    /* clients go before the share handle they point at */
+    for (int i = 0; i < engine->worker_count; i++) {
+        if (engine->workers[i].client) {
+            http_client_destroy(engine->workers[i].client);
+        }
+    }
+    if (engine->share) {
+        curl_share_cleanup(engine->share);
+    }
+
+    for (int i = 0; i < REQUEST_ENGINE_MAX_TRANSFERS; i++) {
+        if (engine->transfers[i].id != 0) {
+            transfer_clear(&engine->transfers[i]);
+        }
+    }
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&engine->share_locks[i]);
+    }
+    pthread_cond_destroy(&engine->cond);
+    pthread_mutex_destroy(&engine->mutex);
+    free(engine);
+}
+
+void request_engine_set_ssl_verification(RequestEngine* engine, bool verify) {
+    if (!engine) {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    engine->verify_ssl = verify;
+    pthread_mutex_unlock(&engine->mutex);
+}
+
+/* copies the request into a free slot and wakes a worker */
+int request_engine_submit(RequestEngine* engine, const Request* request) {
+    if (!engine || !request) {
+        return -1;
+    }
+
+    Request copy;
+    if (request_copy(&copy, request) != 0) {
+        handle_out_of_memory("request engine submit");
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+
+    if (!engine->workers_started && start_workers(engine) != 0) {
+        pthread_mutex_unlock(&engine->mutex);
+        request_cleanup(&copy);
+        return -1;
+    }
+
+    RequestTransfer* transfer = NULL;
+    for (int i = 0; i < REQUEST_ENGINE_MAX_TRANSFERS; i++) {
+        if (engine->transfers[i].id == 0) {
+            transfer = &engine->transfers[i];
+            break;
+        }
+    }
+    if (!transfer) {
+        pthread_mutex_unlock(&engine->mutex);
+        request_cleanup(&copy);
+        return -1;
+    }
+
+    transfer->id = engine->next_id++;
+    if (engine->next_id <= 0) {
+        engine->next_id = 1;
+    }
+    transfer->state = REQUEST_TRANSFER_QUEUED;
+    transfer->sequence = engine->next_sequence++;
+    transfer->verify_ssl = engine->verify_ssl;
+    transfer->request = copy;
+    response_init(&transfer->response);
+    int transfer_id = transfer->id;
+
+    pthread_cond_signal(&engine->cond);
+    pthread_mutex_unlock(&engine->mutex);
+    return transfer_id;
+}
+
+int request_engine_get_progress(RequestEngine* engine, int transfer_id, RequestTransferProgress* progress) {
+    if (!engine || !progress) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    RequestTransfer* transfer = find_transfer(engine, transfer_id);
+    if (!transfer) {
+        pthread_mutex_unlock(&engine->mutex);
+        return -1;
+    }
+
+    progress->state = transfer->state;
+    progress->downloaded = transfer->downloaded;
+    progress->download_total = transfer->download_total;
+    if (transfer->state == REQUEST_TRANSFER_QUEUED) {
+        progress->elapsed_ms = 0.0;
+    } else if (transfer->state == REQUEST_TRANSFER_RUNNING) {
+        progress->elapsed_ms = engine_now_ms() - transfer->started_ms;
+    } else {
+        progress->elapsed_ms = transfer->finished_ms - transfer->started_ms;
+    }
+    pthread_mutex_unlock(&engine->mutex);
+
+    return 0;
+}
+
+/* hands a finished response to the caller, response is overwritten without being freed */
+int request_engine_take_response(RequestEngine* engine, int transfer_id, Response* response, int* result) {
+    if (!engine || !response) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    RequestTransfer* transfer = find_transfer(engine, transfer_id);
+    if (!transfer) {
+        pthread_mutex_unlock(&engine->mutex);
+        return -1;
+    }
+    if (transfer->state == REQUEST_TRANSFER_QUEUED || transfer->state == REQUEST_TRANSFER_RUNNING) {
+        pthread_mutex_unlock(&engine->mutex);
+        return 0;
+    }
+
+    *response = transfer->response;
+    response_init(&transfer->response);
+    if (transfer->state == REQUEST_TRANSFER_CANCELLED) {
+        response->status_code = 0;
+        strncpy(response->status_text, "Cancelled", sizeof(response->status_text) - 1);
+        response->status_text[sizeof(response->status_text) - 1] = '\0';
+    }
+    if (result) {
+        *result = transfer->state == REQUEST_TRANSFER_DONE ? transfer->result : -1;
+    }
+    transfer_clear(transfer);
+    pthread_mutex_unlock(&engine->mutex);
+
+    return 1;
+}
+
+/* a queued transfer is cancelled on the spot, a running one at curl's next progress call */
+void request_engine_cancel(RequestEngine* engine, int transfer_id) {
+    if (!engine) {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    RequestTransfer* transfer = find_transfer(engine, transfer_id);
+    if (transfer) {
+        transfer->cancel_requested = true;
+        if (transfer->state == REQUEST_TRANSFER_QUEUED) {
+            request_cleanup(&transfer->request);
+            transfer->state = REQUEST_TRANSFER_CANCELLED;
+            wake_signal_post();
+        }
+    }
+    pthread_mutex_unlock(&engine->mutex);
+}
+
+void request_engine_release(RequestEngine* engine, int transfer_id) {
+    if (!engine) {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    RequestTransfer* transfer = find_transfer(engine, transfer_id);
+    if (transfer) {
+        if (transfer->state == REQUEST_TRANSFER_RUNNING) {
+            transfer->cancel_requested = true;
+            transfer->released = true;
+        } else {
+            transfer_clear(transfer);
+        }
+    }
+    pthread_mutex_unlock(&engine->mutex);
+}
+
+int request_engine_get_active_count(RequestEngine* engine) {
+    if (!engine) {
+        return 0;
+    }
+
+    int count = 0;
+    pthread_mutex_lock(&engine->mutex);
+    for (int i = 0; i < REQUEST_ENGINE_MAX_TRANSFERS; i++) {
+        const RequestTransfer* transfer = &engine->transfers[i];
+        if (transfer->id != 0 && (transfer->state == REQUEST_TRANSFER_QUEUED ||
+                                  transfer->state == REQUEST_TRANSFER_RUNNING)) {
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&engine->mutex);
+
+    return count;
+}
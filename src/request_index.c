@@ -0,0 +1,651 @@
+/**
+ * search index over saved requests for tinyrequest
+ *
+ * each request becomes one document, "method name url" in lower case, and
+ * documents are numbered in tree order so results come out grouped by
+ * collection without sorting. trigrams are folded to 6 bits per character,
+ * which lets the posting lists live in a flat 256k entry table instead of a
+ * hash map. folding merges some rare punctuation, that only costs a few
+ * extra candidates since every candidate is checked against the real text.
+ *
+ * posting lists stay sorted by document id. a full build appends ids in
+ * order, an update of one document only touches the lists of trigrams it
+ * gained or lost, which for a typed character is a handful.
+ */
+
+#include "request_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define TRIGRAM_CHAR_BITS 6
+#define TRIGRAM_TABLE_SIZE (1u << (3 * TRIGRAM_CHAR_BITS))
+/* request names are capped at this many bytes when collections add them */
+#define REQUEST_INDEX_MAX_NAME 255
+/* method, space, name, space, url */
+#define REQUEST_INDEX_MAX_TEXT (sizeof(((Request*)0)->method) + REQUEST_INDEX_MAX_NAME + sizeof(((Request*)0)->url) + 2)
+#define REQUEST_INDEX_MAX_TERM 256
+/* intersect by binary search once a list is this many times longer than the candidates */
+#define REQUEST_INDEX_GALLOP_RATIO 8
+
+typedef struct {
+    int* ids;
+    int count;
+    int capacity;
+} PostingList;
+
+typedef struct {
+    char* text;
+    size_t length;
+    int collection_index;
+    int request_index;
+} IndexDocument;
+
+/* what the index last saw of a collection */
+typedef struct {
+    const Request* requests;
+    int request_count;
+    unsigned int generation;
+    int first_document;
+} IndexedCollection;
+
+struct RequestIndex {
+    PostingList* postings;
+
+    IndexDocument* documents;
+    int document_count;
+    int document_capacity;
+    unsigned int generation;
+
+    IndexedCollection* collections;
+    int collection_count;
+    int collection_capacity;
+
+    RequestIndexMatch* matches;
+    int match_capacity;
+    int* candidates;
+    int candidate_capacity;
+
+    char text_scratch[REQUEST_INDEX_MAX_TEXT + 1];
+    uint32_t old_codes[REQUEST_INDEX_MAX_TEXT];
+    uint32_t new_codes[REQUEST_INDEX_MAX_TEXT];
+};
+
+/* global out-of-memory handler */
+static void (*g_index_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_index_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_index_out_of_memory_handler) {
+        g_index_out_of_memory_handler(operation);
+    } else {
+        default_index_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void request_index_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_index_out_of_memory_handler = handler;
+}
+
+/* ------------------------------------------------------------------ */
+/* trigrams                                                            */
+/* ------------------------------------------------------------------ */
+
+static char fold_case(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+/* maps a lower-case byte to 6 bits, letters, digits and url punctuation keep their own code */
+static uint32_t fold_char(unsigned char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 1;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 27;
+    }
+    switch (c) {
+        case '/': return 37;
+        case '.': return 38;
+        case '-': return 39;
+        case '_': return 40;
+        case ':': return 41;
+        case '?': return 42;
+        case '=': return 43;
+        case '&': return 44;
+        case ' ': return 45;
+        case '{': return 46;
+        case '}': return 47;
+        case '%': return 48;
+        default: return 49 + c % 15;
+    }
+}
+
+static int compare_codes(const void* a, const void* b) {
+    uint32_t left = *(const uint32_t*)a;
+    uint32_t right = *(const uint32_t*)b;
+    return (left > right) - (left < right);
+}
+
+static uint32_t trigram_code(const char* text) {
+    return (fold_char((unsigned char)text[0]) << (2 * TRIGRAM_CHAR_BITS)) |
+           (fold_char((unsigned char)text[1]) << TRIGRAM_CHAR_BITS) |
+           fold_char((unsigned char)text[2]);
+}
+
+/* fills codes with the sorted, distinct trigrams of text, returns how many */
+static int collect_trigrams(const char* text, size_t length, uint32_t* codes) {
+    if (length < 3) {
+        return 0;
+    }
+
+    int count = 0;
+    for (size_t i = 0; i + 2 < length; i++) {
+        codes[count++] = trigram_code(text + i);
+    }
+    qsort(codes, (size_t)count, sizeof(uint32_t), compare_codes);
+
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || codes[unique - 1] != codes[i]) {
+            codes[unique++] = codes[i];
+        }
+    }
+    return unique;
+}
+
+/* ------------------------------------------------------------------ */
+/* posting lists                                                       */
+/* ------------------------------------------------------------------ */
+
+static int posting_reserve(PostingList* list, int capacity) {
+    if (capacity <= list->capacity) {
+        return 0;
+    }
+
+    int new_capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+    int* ids = (int*)realloc(list->ids, (size_t)new_capacity * sizeof(int));
+    if (!ids) {
+        handle_out_of_memory("request index posting list");
+        return -1;
+    }
+    list->ids = ids;
+    list->capacity = new_capacity;
+    return 0;
+}
+
+/* first position in the list whose id is not below id */
+static int posting_lower_bound(const PostingList* list, int id) {
+    int low = 0;
+    int high = list->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (list->ids[mid] < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static int posting_insert(PostingList* list, int id) {
+    int position = posting_lower_bound(list, id);
+    if (position < list->count && list->ids[position] == id) {
+        return 0;
+    }
+    if (posting_reserve(list, list->count + 1) != 0) {
+        return -1;
+    }
+    memmove(&list->ids[position + 1], &list->ids[position], (size_t)(list->count - position) * sizeof(int));
+    list->ids[position] = id;
+    list->count++;
+    return 0;
+}
+
+static void posting_remove(PostingList* list, int id) {
+    int position = posting_lower_bound(list, id);
+    if (position < list->count && list->ids[position] == id) {
+        memmove(&list->ids[position], &list->ids[position + 1], (size_t)(list->count - position - 1) * sizeof(int));
+        list->count--;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* documents                                                           */
+/* ------------------------------------------------------------------ */
+
+/* writes the lower-case "method name url" text of a request, returns its length */
+static size_t build_document_text(const Request* request, const char* name, char* text) {
+    size_t length = 0;
+
+    for (const char* c = request->method; *c && length < sizeof(request->method); c++) {
+        text[length++] = fold_case(*c);
+    }
+    text[length++] = ' ';
+
+    size_t name_length = 0;
+    for (const char* c = name ? name : ""; *c && name_length < REQUEST_INDEX_MAX_NAME; c++, name_length++) {
+        text[length++] = fold_case(*c);
+    }
+    text[length++] = ' ';
+
+    for (size_t i = 0; request->url[i] && i < sizeof(request->url); i++) {
+        text[length++] = fold_case(request->url[i]);
+    }
+
+    text[length] = '\0';
+    return length;
+}
+
+static void free_documents(RequestIndex* index) {
+    for (int i = 0; i < index->document_count; i++) {
+        free(index->documents[i].text);
+    }
+    index->document_count = 0;
+}
+
+static void reset_postings(RequestIndex* index) {
+    if (!index->postings) {
+        return;
+    }
+    for (uint32_t i = 0; i < TRIGRAM_TABLE_SIZE; i++) {
+        index->postings[i].count = 0;
+    }
+}
+
+static char* copy_text(const char* text, size_t length) {
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) {
+        handle_out_of_memory("request index document");
+        return NULL;
+    }
+    memcpy(copy, text, length + 1);
+    return copy;
+}
+
+/* re-indexes one document if its text changed, touching only the trigrams that differ */
+static int refresh_document(RequestIndex* index, int id, const Request* request, const char* name) {
+    IndexDocument* document = &index->documents[id];
+    size_t length = build_document_text(request, name, index->text_scratch);
+    if (length == document->length && memcmp(document->text, index->text_scratch, length) == 0) {
+        return 0;
+    }
+
+    char* text = copy_text(index->text_scratch, length);
+    if (!text) {
+        return -1;
+    }
+
+    int old_count = collect_trigrams(document->text, document->length, index->old_codes);
+    int new_count = collect_trigrams(text, length, index->new_codes);
+
+    int i = 0;
+    int j = 0;
+    int result = 0;
+    while (i < old_count || j < new_count) {
+        if (j >= new_count || (i < old_count && index->old_codes[i] < index->new_codes[j])) {
+            posting_remove(&index->postings[index->old_codes[i++]], id);
+        } else if (i >= old_count || index->new_codes[j] < index->old_codes[i]) {
+            if (posting_insert(&index->postings[index->new_codes[j++]], id) != 0) {
+                result = -1;
+            }
+        } else {
+            i++;
+            j++;
+        }
+    }
+
+    free(document->text);
+    document->text = text;
+    document->length = length;
+    index->generation++;
+    return result;
+}
+
+/* throws everything away and indexes every request again */
+static int rebuild(RequestIndex* index, CollectionManager* manager) {
+    free_documents(index);
+    reset_postings(index);
+    index->collection_count = 0;
+    index->generation++;
+
+    if (!index->postings) {
+        index->postings = (PostingList*)calloc(TRIGRAM_TABLE_SIZE, sizeof(PostingList));
+        if (!index->postings) {
+            handle_out_of_memory("request index table");
+            return -1;
+        }
+    }
+
+    int total = collection_manager_get_total_requests(manager);
+    if (total > index->document_capacity) {
+        IndexDocument* documents = (IndexDocument*)realloc(index->documents, (size_t)total * sizeof(IndexDocument));
+        if (!documents) {
+            handle_out_of_memory("request index documents");
+            return -1;
+        }
+        index->documents = documents;
+        index->document_capacity = total;
+    }
+    if (manager->count > index->collection_capacity) {
+        IndexedCollection* collections = (IndexedCollection*)realloc(index->collections,
+                                                                     (size_t)manager->count * sizeof(IndexedCollection));
+        if (!collections) {
+            handle_out_of_memory("request index collections");
+            return -1;
+        }
+        index->collections = collections;
+        index->collection_capacity = manager->count;
+    }
+
+    for (int c = 0; c < manager->count; c++) {
+        Collection* collection = &manager->collections[c];
+        IndexedCollection* indexed = &index->collections[c];
+        indexed->requests = collection->requests;
+        indexed->request_count = collection->request_count;
+        indexed->generation = collection->generation;
+        indexed->first_document = index->document_count;
+
+        for (int r = 0; r < collection->request_count; r++) {
+            size_t length = build_document_text(&collection->requests[r], collection->request_names[r],
+                                                index->text_scratch);
+            char* text = copy_text(index->text_scratch, length);
+            if (!text) {
+                free_documents(index);
+                reset_postings(index);
+                return -1;
+            }
+
+            int id = index->document_count++;
+            IndexDocument* document = &index->documents[id];
+            document->text = text;
+            document->length = length;
+            document->collection_index = c;
+            document->request_index = r;
+
+            /*
+             * ids only grow during a build, so appending keeps every list
+             * sorted, and a repeated trigram is caught by the last id alone
+             */
+            for (size_t k = 0; k + 2 < length; k++) {
+                PostingList* list = &index->postings[trigram_code(text + k)];
+                if (list->count > 0 && list->ids[list->count - 1] == id) {
+                    continue;
+                }
+                if (posting_reserve(list, list->count + 1) != 0) {
+                    free_documents(index);
+                    reset_postings(index);
+                    return -1;
+                }
+                list->ids[list->count++] = id;
+            }
+        }
+    }
+
+    index->collection_count = manager->count;
+    return 0;
+}
+
+/* true when requests were added, removed or moved since the index last looked */
+static bool layout_changed(RequestIndex* index, CollectionManager* manager) {
+    if (!index->postings || manager->count != index->collection_count) {
+        return true;
+    }
+    for (int c = 0; c < manager->count; c++) {
+        const Collection* collection = &manager->collections[c];
+        const IndexedCollection* indexed = &index->collections[c];
+        if (collection->requests != indexed->requests || collection->request_count != indexed->request_count) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ------------------------------------------------------------------ */
+/* public api                                                          */
+/* ------------------------------------------------------------------ */
+
+/* creates an empty index, the trigram table is allocated on first sync */
+RequestIndex* request_index_create(void) {
+    RequestIndex* index = (RequestIndex*)calloc(1, sizeof(RequestIndex));
+    if (!index) {
+        handle_out_of_memory("request index creation");
+        return NULL;
+    }
+    return index;
+}
+
+void request_index_destroy(RequestIndex* index) {
+    if (!index) {
+        return;
+    }
+
+    free_documents(index);
+    if (index->postings) {
+        for (uint32_t i = 0; i < TRIGRAM_TABLE_SIZE; i++) {
+            free(index->postings[i].ids);
+        }
+        free(index->postings);
+    }
+    free(index->documents);
+    free(index->collections);
+    free(index->matches);
+    free(index->candidates);
+    free(index);
+}
+
+/* rebuilds after layout changes, otherwise re-reads only collections whose generation moved */
+int request_index_sync(RequestIndex* index, CollectionManager* manager) {
+    if (!index || !manager) {
+        return -1;
+    }
+
+    if (layout_changed(index, manager)) {
+        return rebuild(index, manager);
+    }
+
+    int result = 0;
+    for (int c = 0; c < manager->count; c++) {
+        Collection* collection = &manager->collections[c];
+        IndexedCollection* indexed = &index->collections[c];
+        if (collection->generation == indexed->generation) {
+            continue;
+        }
+
+        for (int r = 0; r < collection->request_count; r++) {
+            if (refresh_document(index, indexed->first_document + r, &collection->requests[r],
+                                 collection->request_names[r]) != 0) {
+                result = -1;
+            }
+        }
+        indexed->generation = collection->generation;
+    }
+    return result;
+}
+
+/* re-reads one request, for edits that bypass the collection functions */
+int request_index_refresh_request(RequestIndex* index, CollectionManager* manager,
+                                  int collection_index, int request_index) {
+    if (!index || !manager) {
+        return -1;
+    }
+    if (layout_changed(index, manager)) {
+        return rebuild(index, manager);
+    }
+
+    Collection* collection = collection_manager_get_collection(manager, collection_index);
+    if (!collection || request_index < 0 || request_index >= collection->request_count) {
+        return -1;
+    }
+
+    int id = index->collections[collection_index].first_document + request_index;
+    return refresh_document(index, id, &collection->requests[request_index],
+                            collection->request_names[request_index]);
+}
+
+static int compare_list_sizes(const void* a, const void* b) {
+    const PostingList* left = *(const PostingList* const*)a;
+    const PostingList* right = *(const PostingList* const*)b;
+    return (left->count > right->count) - (left->count < right->count);
+}
+
+/* keeps the candidates that are also in list */
+static int intersect_candidates(int* candidates, int count, const PostingList* list) {
+    int kept = 0;
+
+    if (list->count > count * REQUEST_INDEX_GALLOP_RATIO) {
+        for (int i = 0; i < count; i++) {
+            int position = posting_lower_bound(list, candidates[i]);
+            if (position < list->count && list->ids[position] == candidates[i]) {
+                candidates[kept++] = candidates[i];
+            }
+        }
+        return kept;
+    }
+
+    int j = 0;
+    for (int i = 0; i < count && j < list->count; i++) {
+        while (j < list->count && list->ids[j] < candidates[i]) {
+            j++;
+        }
+        if (j < list->count && list->ids[j] == candidates[i]) {
+            candidates[kept++] = candidates[i];
+        }
+    }
+    return kept;
+}
+
+static bool document_matches(const IndexDocument* document, char terms[][REQUEST_INDEX_MAX_TERM], int term_count) {
+    for (int t = 0; t < term_count; t++) {
+        if (!strstr(document->text, terms[t])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* finds requests matching every term, in collection order */
+int request_index_search(RequestIndex* index, const char* query, const RequestIndexMatch** matches) {
+    if (!index || !query || !matches) {
+        return -1;
+    }
+    *matches = index->matches;
+
+    /* split into lower-case terms */
+    char terms[REQUEST_INDEX_MAX_TERMS][REQUEST_INDEX_MAX_TERM];
+    int term_count = 0;
+    const char* cursor = query;
+    while (*cursor && term_count < REQUEST_INDEX_MAX_TERMS) {
+        while (*cursor == ' ' || *cursor == '\t') {
+            cursor++;
+        }
+        size_t length = 0;
+        while (cursor[length] && cursor[length] != ' ' && cursor[length] != '\t') {
+            length++;
+        }
+        if (length == 0) {
+            break;
+        }
+        size_t copy = length < REQUEST_INDEX_MAX_TERM - 1 ? length : REQUEST_INDEX_MAX_TERM - 1;
+        for (size_t i = 0; i < copy; i++) {
+            terms[term_count][i] = fold_case(cursor[i]);
+        }
+        terms[term_count][copy] = '\0';
+        term_count++;
+        cursor += length;
+    }
+
+    if (term_count == 0 || index->document_count == 0) {
+        return 0;
+    }
+
+    if (index->match_capacity < index->document_count) {
+        RequestIndexMatch* grown = (RequestIndexMatch*)realloc(index->matches,
+                                                               (size_t)index->document_count * sizeof(RequestIndexMatch));
+        if (!grown) {
+            handle_out_of_memory("request index matches");
+            return -1;
+        }
+        index->matches = grown;
+        index->match_capacity = index->document_count;
+        *matches = index->matches;
+    }
+
+    /* posting lists of every trigram in every term */
+    const PostingList* lists[REQUEST_INDEX_MAX_TERMS * REQUEST_INDEX_MAX_TERM];
+    int list_count = 0;
+    for (int t = 0; t < term_count; t++) {
+        int code_count = collect_trigrams(terms[t], strlen(terms[t]), index->new_codes);
+        for (int k = 0; k < code_count; k++) {
+            const PostingList* list = &index->postings[index->new_codes[k]];
+            if (list->count == 0) {
+                return 0;
+            }
+            /* a trigram every request has cannot narrow anything down */
+            if (list->count < index->document_count) {
+                lists[list_count++] = list;
+            }
+        }
+    }
+
+    int match_count = 0;
+    if (list_count == 0) {
+        /* only short or very common terms, nothing to narrow with */
+        for (int id = 0; id < index->document_count; id++) {
+            if (document_matches(&index->documents[id], terms, term_count)) {
+                index->matches[match_count].collection_index = index->documents[id].collection_index;
+                index->matches[match_count].request_index = index->documents[id].request_index;
+                match_count++;
+            }
+        }
+        return match_count;
+    }
+
+    /* start from the rarest trigram and narrow down */
+    qsort(lists, (size_t)list_count, sizeof(PostingList*), compare_list_sizes);
+    if (index->candidate_capacity < lists[0]->count) {
+        int* grown = (int*)realloc(index->candidates, (size_t)lists[0]->count * sizeof(int));
+        if (!grown) {
+            handle_out_of_memory("request index candidates");
+            return -1;
+        }
+        index->candidates = grown;
+        index->candidate_capacity = lists[0]->count;
+    }
+    memcpy(index->candidates, lists[0]->ids, (size_t)lists[0]->count * sizeof(int));
+    int candidate_count = lists[0]->count;
+    for (int l = 1; l < list_count && candidate_count > 0; l++) {
+        if (lists[l] != lists[l - 1]) {
+            candidate_count = intersect_candidates(index->candidates, candidate_count, lists[l]);
+        }
+    }
+
+    for (int i = 0; i < candidate_count; i++) {
+        const IndexDocument* document = &index->documents[index->candidates[i]];
+        if (document_matches(document, terms, term_count)) {
+            index->matches[match_count].collection_index = document->collection_index;
+            index->matches[match_count].request_index = document->request_index;
+            match_count++;
+        }
+    }
+    return match_count;
+}
+
+int request_index_get_document_count(RequestIndex* index) {
+    return index ? index->document_count : 0;
+}
+
+unsigned int request_index_get_generation(RequestIndex* index) {
+    return index ? index->generation : 0;
+}
@@ -20,6 +20,9 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <strings.h>
+#include <stdatomic.h>
 
 /* global out-of-memory handler */
 static void (*g_out_of_memory_handler)(const char* operation) = NULL;
@@ -253,6 +256,41 @@ void request_cleanup(Request* request) {
     request->body_size = 0;
 }
 
+/* deep copies src into dest, dest must not own anything yet */
+int request_copy(Request* dest, const Request* src) {
+    if (dest == NULL || src == NULL) {
+        return -1;
+    }
+    
+    /* scalars and fixed buffers come across as they are */
+    *dest = *src;
+    header_list_init(&dest->headers);
+    dest->body = NULL;
+    dest->body_size = 0;
+    
+    /* the source headers were validated when they were added */
+    if (src->headers.count > 0) {
+        dest->headers.headers = (Header*)malloc((size_t)src->headers.count * sizeof(Header));
+        if (dest->headers.headers == NULL) {
+            handle_out_of_memory("request copy headers");
+            return REQUEST_RESPONSE_ERROR_MEMORY_ALLOCATION;
+        }
+        memcpy(dest->headers.headers, src->headers.headers, (size_t)src->headers.count * sizeof(Header));
+        dest->headers.count = src->headers.count;
+        dest->headers.capacity = src->headers.count;
+    }
+    
+    if (src->body != NULL && src->body_size > 0) {
+        int result = request_set_body(dest, src->body, src->body_size);
+        if (result != 0) {
+            request_cleanup(dest);
+            return result;
+        }
+    }
+    
+    return 0;
+}
+
 /* sets the request body with size validation and memory management */
 int request_set_body(Request* request, const char* body, size_t size) {
     if (request == NULL) {
@@ -340,6 +378,9 @@ void response_init(Response* response) {
     /* initialize large response handling fields */
     response->is_truncated = 0;
     response->total_size = 0;
+
+    memset(&response->meta, 0, sizeof(ResponseMeta));
+    memset(&response->timings, 0, sizeof(ResponseTimings));
 }
 
 /* cleans up a response structure and frees its resources */
@@ -362,6 +403,7 @@ void response_cleanup(Response* response) {
         response->body = NULL;
     }
     response->body_size = 0;
+    response->meta.valid = false;
 }
 
 /* sets the response body with size validation and memory management */
@@ -376,6 +418,7 @@ int response_set_body(Response* response, const char* body, size_t size) {
         response->body = NULL;
         response->body_size = 0;
     }
+    response->meta.valid = false;
     
     /* if body is null or size is 0, just clear the body */
     if (body == NULL || size == 0) {
@@ -406,6 +449,172 @@ int response_set_body(Response* response, const char* body, size_t size) {
     return 0;
 }
 
+/* copies a header value token lowercased, stopping at ';' or the end */
+static void copy_lowercase_token(char* dest, size_t dest_size, const char* src) {
+    size_t length = 0;
+
+    while (*src == ' ' || *src == '\t' || *src == '"') {
+        src++;
+    }
+    while (*src && *src != ';' && *src != '"' && *src != ' ' && *src != ',' && length + 1 < dest_size) {
+        dest[length++] = (char)tolower((unsigned char)*src);
+        src++;
+    }
+    dest[length] = '\0';
+}
+
+static bool ends_with(const char* text, const char* suffix) {
+    size_t text_length = strlen(text);
+    size_t suffix_length = strlen(suffix);
+    return text_length >= suffix_length && strcmp(text + text_length - suffix_length, suffix) == 0;
+}
+
+/* maps a media type to a kind, returns RESPONSE_KIND_EMPTY when the type says nothing useful */
+static int kind_from_mime_type(const char* mime) {
+    static const char* binary_types[] = {
+        "audio/", "video/", "font/",
+        "application/octet-stream", "application/pdf", "application/zip",
+        "application/gzip", "application/x-protobuf", "application/protobuf",
+        "application/grpc", "application/vnd.google.protobuf", "application/msgpack",
+        "application/x-msgpack", "application/cbor", "application/wasm",
+        NULL
+    };
+
+    if (!mime[0]) {
+        return RESPONSE_KIND_EMPTY;
+    }
+    if (ends_with(mime, "/json") || ends_with(mime, "+json")) {
+        return RESPONSE_KIND_JSON;
+    }
+    if (strcmp(mime, "text/html") == 0 || strcmp(mime, "application/xhtml+xml") == 0) {
+        return RESPONSE_KIND_HTML;
+    }
+    if (ends_with(mime, "/xml") || ends_with(mime, "+xml")) {
+        return RESPONSE_KIND_XML;
+    }
+    if (strncmp(mime, "image/", 6) == 0) {
+        return RESPONSE_KIND_IMAGE;
+    }
+    for (int i = 0; binary_types[i]; i++) {
+        if (strncmp(mime, binary_types[i], strlen(binary_types[i])) == 0) {
+            return RESPONSE_KIND_BINARY;
+        }
+    }
+    if (strncmp(mime, "text/", 5) == 0) {
+        return RESPONSE_KIND_TEXT;
+    }
+    return RESPONSE_KIND_EMPTY;
+}
+
+/* guesses the kind from the first bytes of the body when there is no usable content type */
+static int kind_from_body(const char* body, size_t size) {
+    size_t offset = 0;
+    while (offset < size && (body[offset] == ' ' || body[offset] == '\t' ||
+                             body[offset] == '\r' || body[offset] == '\n')) {
+        offset++;
+    }
+
+    const char* start = body + offset;
+    size_t remaining = size - offset;
+    if (remaining > 0 && (*start == '{' || *start == '[')) {
+        return RESPONSE_KIND_JSON;
+    }
+    if (remaining >= 5 && strncmp(start, "<?xml", 5) == 0) {
+        return RESPONSE_KIND_XML;
+    }
+    if ((remaining >= 9 && strncasecmp(start, "<!DOCTYPE", 9) == 0) ||
+        (remaining >= 5 && strncasecmp(start, "<html", 5) == 0)) {
+        return RESPONSE_KIND_HTML;
+    }
+    return RESPONSE_KIND_TEXT;
+}
+
+/* last generation handed to a body, responses are described on transfer threads too */
+static atomic_uint g_meta_generation;
+
+/* works out the metadata once so the ui never has to scan headers or sniff the body per frame */
+void response_compute_meta(Response* response) {
+    if (response == NULL) {
+        return;
+    }
+
+    ResponseMeta* meta = &response->meta;
+    memset(meta, 0, sizeof(ResponseMeta));
+    meta->generation = atomic_fetch_add(&g_meta_generation, 1) + 1;
+
+    for (int i = 0; i < response->headers.count; i++) {
+        const Header* header = &response->headers.headers[i];
+        if (strcasecmp(header->name, "content-type") == 0 && !meta->mime_type[0]) {
+            copy_lowercase_token(meta->mime_type, sizeof(meta->mime_type), header->value);
+
+            for (const char* param = strchr(header->value, ';'); param; param = strchr(param + 1, ';')) {
+                const char* name = param + 1;
+                while (*name == ' ' || *name == '\t') {
+                    name++;
+                }
+                if (strncasecmp(name, "charset=", 8) == 0) {
+                    copy_lowercase_token(meta->charset, sizeof(meta->charset), name + 8);
+                    break;
+                }
+            }
+        } else if (strcasecmp(header->name, "content-encoding") == 0 && !meta->encoding[0]) {
+            copy_lowercase_token(meta->encoding, sizeof(meta->encoding), header->value);
+            if (strcmp(meta->encoding, "identity") == 0) {
+                meta->encoding[0] = '\0';
+            }
+        }
+    }
+
+    meta->valid = true;
+
+    if (response->body == NULL || response->body_size == 0) {
+        meta->kind = RESPONSE_KIND_EMPTY;
+        return;
+    }
+
+    meta->kind = kind_from_mime_type(meta->mime_type);
+    if (meta->kind == RESPONSE_KIND_EMPTY) {
+        meta->kind = kind_from_body(response->body, response->body_size);
+    }
+
+    /* svg is an image but it is text */
+    if (meta->kind == RESPONSE_KIND_IMAGE && strncmp(meta->mime_type, "image/svg", 9) == 0) {
+        meta->kind = RESPONSE_KIND_XML;
+    }
+
+    /* a nul byte in the first few kilobytes is a strong hint, text never has one */
+    if (meta->kind != RESPONSE_KIND_IMAGE && meta->kind != RESPONSE_KIND_BINARY) {
+        size_t probe = response->body_size < 8192 ? response->body_size : 8192;
+        if (memchr(response->body, '\0', probe) != NULL) {
+            meta->kind = RESPONSE_KIND_BINARY;
+        }
+    }
+
+    if (meta->kind != RESPONSE_KIND_IMAGE && meta->kind != RESPONSE_KIND_BINARY) {
+        const char* cursor = response->body;
+        const char* end = response->body + response->body_size;
+        while (cursor < end) {
+            const char* newline = (const char*)memchr(cursor, '\n', (size_t)(end - cursor));
+            meta->line_count++;
+            if (!newline) {
+                break;
+            }
+            cursor = newline + 1;
+        }
+    }
+}
+
+/* returns the cached metadata, recomputing it only after the body was replaced */
+const ResponseMeta* response_get_meta(Response* response) {
+    if (response == NULL) {
+        return NULL;
+    }
+    if (!response->meta.valid) {
+        response_compute_meta(response);
+    }
+    return &response->meta;
+}
+
 
 
 /* finds a header by name and returns its index */
@@ -0,0 +1,1361 @@
+/**
+ * comparing two responses for tinyrequest
+ *
+ * the line diff works in four steps. both texts are split into lines and
+ * each line is hashed, several threads at a time for big bodies. lines are
+ * then interned so equal lines share an integer id. lines whose id never
+ * appears on the other side are marked as changed straight away and left
+ * out of the next step, which is what keeps two completely different bodies
+ * fast. finally the remaining id sequences go through myers' divide and
+ * conquer diff, which only needs memory proportional to the input.
+ *
+ * the myers part follows the classic middle snake search. when the edit
+ * distance of a range gets large it stops searching for the optimal split
+ * and takes the furthest point reached so far instead, like gnu diff does,
+ * so the running time stays bounded on inputs with many scattered changes.
+ */
+
+#include "response_diff.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <strings.h>
+#include <limits.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <cjson/cJSON.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/* below this size a slice of text is not worth its own hashing thread */
+#define DIFF_MIN_CHUNK_SIZE (1024 * 1024)
+/* lower bound for the myers cost cap, see diff_middle_snake */
+#define DIFF_MIN_COST_LIMIT 256
+/* total diagonals the myers search may visit before it gives up on alignment */
+#define DIFF_WORK_LIMIT 60000000LL
+
+/* a line as a byte range with its hash */
+typedef struct {
+    size_t offset;
+    size_t length;
+    uint64_t hash;
+} DiffLine;
+
+/* lines of one side */
+typedef struct {
+    char* text;
+    size_t size;
+    DiffLine* lines;
+    int count;
+} DiffText;
+
+struct ResponseDiff {
+    pthread_mutex_t mutex;
+    pthread_t thread;
+    bool thread_started;
+    bool running;
+    atomic_int cancel_requested;
+    unsigned int generation;
+    int mode;
+    char error[128];
+    double elapsed_ms;
+
+    DiffText sides[2];
+
+    DiffRow* rows;
+    int row_count;
+    int* hunks;
+    int hunk_count;
+    int added;
+    int removed;
+    int changed;
+
+    JsonDiffEntry* json_entries;
+    int json_count;
+    int json_capacity;
+    bool truncated;
+};
+
+/* global out-of-memory handler */
+static void (*g_diff_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_diff_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_diff_out_of_memory_handler) {
+        g_diff_out_of_memory_handler(operation);
+    } else {
+        default_diff_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void response_diff_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_diff_out_of_memory_handler = handler;
+}
+
+static double diff_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static bool diff_cancelled(ResponseDiff* diff) {
+    return atomic_load(&diff->cancel_requested) != 0;
+}
+
+static void diff_set_error(ResponseDiff* diff, const char* message) {
+    snprintf(diff->error, sizeof(diff->error), "%s", message);
+}
+
+/* ------------------------------------------------------------------ */
+/* line splitting and hashing                                          */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char* text;
+    size_t begin;
+    size_t end;
+    DiffLine* lines;
+    int count;
+    int capacity;
+    bool failed;
+    ResponseDiff* owner;
+} LineChunk;
+
+/* word-at-a-time multiply/xorshift hash, lines are hashed once so this is the hot loop */
+static uint64_t hash_line(const char* data, size_t length) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ length;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, length - i);
+    hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ULL;
+    return hash ^ (hash >> 29);
+}
+
+/* splits one chunk of text into lines, a trailing line without newline counts too */
+static void* split_chunk_lines(void* arg) {
+    LineChunk* chunk = (LineChunk*)arg;
+    size_t position = chunk->begin;
+
+    while (position < chunk->end) {
+        if (chunk->count == chunk->capacity) {
+            int capacity = chunk->capacity ? chunk->capacity * 2 : 1024;
+            DiffLine* lines = (DiffLine*)realloc(chunk->lines, sizeof(DiffLine) * capacity);
+            if (!lines) {
+                chunk->failed = true;
+                return NULL;
+            }
+            chunk->lines = lines;
+            chunk->capacity = capacity;
+        }
+
+        const char* start = chunk->text + position;
+        const char* newline = (const char*)memchr(start, '\n', chunk->end - position);
+        size_t length = newline ? (size_t)(newline - start) : chunk->end - position;
+
+        DiffLine* line = &chunk->lines[chunk->count++];
+        line->offset = position;
+        line->length = length;
+        line->hash = hash_line(start, length);
+
+        position += length + 1;
+
+        if ((chunk->count & 0xFFF) == 0 && diff_cancelled(chunk->owner)) {
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static int diff_worker_limit(size_t size) {
+#ifndef _WIN32
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    long cpus = 4;
+#endif
+    if (cpus < 1) {
+        cpus = 1;
+    }
+
+    size_t by_size = size / DIFF_MIN_CHUNK_SIZE;
+    int workers = cpus < RESPONSE_DIFF_MAX_WORKERS ? (int)cpus : RESPONSE_DIFF_MAX_WORKERS;
+    if ((size_t)workers > by_size) {
+        workers = by_size > 0 ? (int)by_size : 1;
+    }
+    return workers;
+}
+
+/* fills side->lines, chunk boundaries are moved to just after a newline */
+static int split_lines(ResponseDiff* diff, DiffText* side) {
+    LineChunk chunks[RESPONSE_DIFF_MAX_WORKERS];
+    pthread_t threads[RESPONSE_DIFF_MAX_WORKERS];
+    bool started[RESPONSE_DIFF_MAX_WORKERS];
+    int workers = diff_worker_limit(side->size);
+
+    memset(chunks, 0, sizeof(chunks));
+    size_t begin = 0;
+    for (int i = 0; i < workers; i++) {
+        size_t end = (i == workers - 1) ? side->size : side->size / workers * (i + 1);
+        if (end < begin) {
+            end = begin;
+        }
+        if (end < side->size) {
+            const char* newline = (const char*)memchr(side->text + end, '\n', side->size - end);
+            end = newline ? (size_t)(newline - side->text) + 1 : side->size;
+        }
+
+        chunks[i].text = side->text;
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        chunks[i].owner = diff;
+        begin = end;
+    }
+
+    for (int i = 0; i < workers; i++) {
+        started[i] = (i > 0) && pthread_create(&threads[i], NULL, split_chunk_lines, &chunks[i]) == 0;
+        if (i > 0 && !started[i]) {
+            split_chunk_lines(&chunks[i]);
+        }
+    }
+    split_chunk_lines(&chunks[0]);
+    for (int i = 1; i < workers; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    size_t total = 0;
+    bool failed = false;
+    for (int i = 0; i < workers; i++) {
+        total += chunks[i].count;
+        failed = failed || chunks[i].failed;
+    }
+
+    if (!failed && total > INT_MAX / 2) {
+        diff_set_error(diff, "Too many lines to compare");
+        failed = true;
+    }
+
+    if (!failed) {
+        side->lines = (DiffLine*)malloc(sizeof(DiffLine) * (total > 0 ? total : 1));
+        if (!side->lines) {
+            handle_out_of_memory("diff line table");
+            failed = true;
+        }
+    }
+
+    if (!failed) {
+        size_t position = 0;
+        for (int i = 0; i < workers; i++) {
+            if (chunks[i].count > 0) {
+                memcpy(side->lines + position, chunks[i].lines, sizeof(DiffLine) * chunks[i].count);
+                position += chunks[i].count;
+            }
+        }
+        side->count = (int)total;
+    }
+
+    for (int i = 0; i < workers; i++) {
+        free(chunks[i].lines);
+    }
+
+    return failed ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* interning                                                           */
+/* ------------------------------------------------------------------ */
+
+/* the hash lives in the slot so most probes never touch the line table */
+typedef struct {
+    uint64_t hash;
+    int line;       /* representative line, -1 for an empty slot */
+    int side;
+    int id;
+} InternSlot;
+
+static bool lines_equal(const DiffText* a, int a_line, const DiffText* b, int b_line) {
+    const DiffLine* left = &a->lines[a_line];
+    const DiffLine* right = &b->lines[b_line];
+    return left->hash == right->hash && left->length == right->length &&
+           memcmp(a->text + left->offset, b->text + right->offset, left->length) == 0;
+}
+
+/* doubles the intern table, slots only move so no line is compared again */
+static InternSlot* grow_intern_table(InternSlot* table, size_t* capacity) {
+    size_t grown_capacity = *capacity * 2;
+    InternSlot* grown = (InternSlot*)malloc(sizeof(InternSlot) * grown_capacity);
+    if (!grown) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < grown_capacity; i++) {
+        grown[i].line = -1;
+    }
+    for (size_t i = 0; i < *capacity; i++) {
+        if (table[i].line < 0) {
+            continue;
+        }
+        size_t slot = (size_t)table[i].hash & (grown_capacity - 1);
+        while (grown[slot].line >= 0) {
+            slot = (slot + 1) & (grown_capacity - 1);
+        }
+        grown[slot] = table[i];
+    }
+
+    free(table);
+    *capacity = grown_capacity;
+    return grown;
+}
+
+/*
+ * gives equal lines in [begin, end) of each side the same id and counts how
+ * often each id appears per side. ids are indexed relative to begin. the
+ * table is sized by distinct lines rather than total lines, responses tend
+ * to repeat a lot of lines and a small table stays in cache.
+ *
+ * lines are matched on their 64-bit hash alone - comparing the bytes here
+ * means a random read into the text for every line, which costs more than
+ * the rest of the diff. build_rows compares the bytes of every line it
+ * reports as equal instead, in order, so a hash collision can only make
+ * the diff a little less minimal, never wrong.
+ */
+static int intern_lines(ResponseDiff* diff, const int begin[2], const int end[2], int* ids[2],
+                        int** counts_out, int* id_count) {
+    size_t total = (size_t)(end[0] - begin[0]) + (size_t)(end[1] - begin[1]);
+    size_t capacity = 1024;
+
+    InternSlot* table = (InternSlot*)malloc(sizeof(InternSlot) * capacity);
+    int* counts = (int*)malloc(sizeof(int) * 2 * (total + 1));
+    ids[0] = (int*)malloc(sizeof(int) * (end[0] - begin[0] + 1));
+    ids[1] = (int*)malloc(sizeof(int) * (end[1] - begin[1] + 1));
+    if (!table || !counts || !ids[0] || !ids[1]) {
+        handle_out_of_memory("diff line interning");
+        free(table);
+        free(counts);
+        return -1;
+    }
+
+    for (size_t i = 0; i < capacity; i++) {
+        table[i].line = -1;
+    }
+
+    int next_id = 0;
+    for (int s = 0; s < 2 && !diff_cancelled(diff); s++) {
+        const DiffText* side = &diff->sides[s];
+        for (int i = begin[s]; i < end[s]; i++) {
+            uint64_t hash = side->lines[i].hash;
+            size_t slot = (size_t)hash & (capacity - 1);
+
+            while (table[slot].line >= 0) {
+                if (table[slot].hash == hash) {
+                    break;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+
+            if (table[slot].line < 0) {
+                table[slot].hash = hash;
+                table[slot].line = i;
+                table[slot].side = s;
+                table[slot].id = next_id;
+                counts[next_id * 2] = 0;
+                counts[next_id * 2 + 1] = 0;
+                next_id++;
+            }
+
+            int id = table[slot].id;
+            ids[s][i - begin[s]] = id;
+            counts[id * 2 + s]++;
+
+            /* keep the load factor under one half */
+            if ((size_t)next_id * 2 > capacity) {
+                InternSlot* grown = grow_intern_table(table, &capacity);
+                if (!grown) {
+                    handle_out_of_memory("diff line interning");
+                    free(table);
+                    free(counts);
+                    return -1;
+                }
+                table = grown;
+            }
+        }
+    }
+
+    free(table);
+    *counts_out = counts;
+    *id_count = next_id;
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* myers diff                                                          */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const int* xv;
+    const int* yv;
+    bool* xchanged;
+    bool* ychanged;
+    int* fd;        /* forward furthest x per diagonal, offset applied */
+    int* bd;        /* backward furthest x per diagonal, offset applied */
+    int cost_limit;
+    long long work;         /* diagonals visited so far */
+    long long work_limit;   /* past this every remaining range is reported as changed */
+    ResponseDiff* owner;
+} MyersContext;
+
+typedef struct {
+    int xoff;
+    int xlim;
+    int yoff;
+    int ylim;
+} MyersRange;
+
+/* finds the split point of the shortest edit script for a range, (xmid, ymid) lies on it */
+static void diff_middle_snake(MyersContext* ctx, int xoff, int xlim, int yoff, int ylim, int* xmid, int* ymid) {
+    const int* xv = ctx->xv;
+    const int* yv = ctx->yv;
+    int* fd = ctx->fd;
+    int* bd = ctx->bd;
+    const int dmin = xoff - ylim;
+    const int dmax = xlim - yoff;
+    const int fmid = xoff - yoff;
+    const int bmid = xlim - ylim;
+    int fmin = fmid, fmax = fmid;
+    int bmin = bmid, bmax = bmid;
+    const bool odd = ((fmid - bmid) & 1) != 0;
+
+    fd[fmid] = xoff;
+    bd[bmid] = xlim;
+
+    for (int cost = 1;; cost++) {
+        /* extend the forward search by one edit */
+        if (fmin > dmin) fd[--fmin - 1] = -1; else ++fmin;
+        if (fmax < dmax) fd[++fmax + 1] = -1; else --fmax;
+        for (int d = fmax; d >= fmin; d -= 2) {
+            int tlo = fd[d - 1], thi = fd[d + 1];
+            int x = tlo >= thi ? tlo + 1 : thi;
+            int y = x - d;
+            while (x < xlim && y < ylim && xv[x] == yv[y]) {
+                x++;
+                y++;
+            }
+            fd[d] = x;
+            if (odd && bmin <= d && d <= bmax && bd[d] <= x) {
+                *xmid = x;
+                *ymid = y;
+                return;
+            }
+        }
+
+        /* and the backward search */
+        if (bmin > dmin) bd[--bmin - 1] = INT_MAX; else ++bmin;
+        if (bmax < dmax) bd[++bmax + 1] = INT_MAX; else --bmax;
+        for (int d = bmax; d >= bmin; d -= 2) {
+            int tlo = bd[d - 1], thi = bd[d + 1];
+            int x = tlo < thi ? tlo : thi - 1;
+            int y = x - d;
+            while (x > xoff && y > yoff && xv[x - 1] == yv[y - 1]) {
+                x--;
+                y--;
+            }
+            bd[d] = x;
+            if (!odd && fmin <= d && d <= fmax && x <= fd[d]) {
+                *xmid = x;
+                *ymid = y;
+                return;
+            }
+        }
+
+        ctx->work += (fmax - fmin) / 2 + (bmax - bmin) / 2 + 2;
+        if (cost >= ctx->cost_limit || ctx->work > ctx->work_limit || diff_cancelled(ctx->owner)) {
+            /* too expensive, take whichever search got furthest along its diagonals */
+            int fxybest = -1, fxbest = xoff;
+            for (int d = fmax; d >= fmin; d -= 2) {
+                int x = fd[d] < xlim ? fd[d] : xlim;
+                int y = x - d;
+                if (y > ylim) {
+                    x = ylim + d;
+                    y = ylim;
+                }
+                if (fxybest < x + y) {
+                    fxybest = x + y;
+                    fxbest = x;
+                }
+            }
+
+            int bxybest = INT_MAX, bxbest = xlim;
+            for (int d = bmax; d >= bmin; d -= 2) {
+                int x = bd[d] > xoff ? bd[d] : xoff;
+                int y = x - d;
+                if (y < yoff) {
+                    x = yoff + d;
+                    y = yoff;
+                }
+                if (x + y < bxybest) {
+                    bxybest = x + y;
+                    bxbest = x;
+                }
+            }
+
+            if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff)) {
+                *xmid = fxbest;
+                *ymid = fxybest - fxbest;
+            } else {
+                *xmid = bxbest;
+                *ymid = bxybest - bxbest;
+            }
+            return;
+        }
+    }
+}
+
+/* marks changed elements of xv and yv inside the given ranges, split ranges go on an explicit stack */
+static int diff_compare_sequences(MyersContext* ctx, const MyersRange* ranges, int range_count) {
+    int stack_capacity = range_count + 64;
+    int stack_count = 0;
+    MyersRange* stack = (MyersRange*)malloc(sizeof(MyersRange) * stack_capacity);
+    if (!stack) {
+        handle_out_of_memory("diff range stack");
+        return -1;
+    }
+
+    for (int i = range_count - 1; i >= 0; i--) {
+        stack[stack_count++] = ranges[i];
+    }
+
+    while (stack_count > 0) {
+        MyersRange range = stack[--stack_count];
+        int xoff = range.xoff, xlim = range.xlim, yoff = range.yoff, ylim = range.ylim;
+
+        while (xoff < xlim && yoff < ylim && ctx->xv[xoff] == ctx->yv[yoff]) {
+            xoff++;
+            yoff++;
+        }
+        while (xlim > xoff && ylim > yoff && ctx->xv[xlim - 1] == ctx->yv[ylim - 1]) {
+            xlim--;
+            ylim--;
+        }
+
+        /* out of budget, the rest is reported unaligned which is still a valid diff */
+        if (xoff == xlim || yoff == ylim || ctx->work > ctx->work_limit) {
+            for (int x = xoff; x < xlim; x++) ctx->xchanged[x] = true;
+            for (int y = yoff; y < ylim; y++) ctx->ychanged[y] = true;
+            continue;
+        }
+
+        int xmid, ymid;
+        diff_middle_snake(ctx, xoff, xlim, yoff, ylim, &xmid, &ymid);
+
+        /* a degenerate split would loop forever, mark the range as changed instead */
+        if ((xmid == xoff && ymid == yoff) || (xmid == xlim && ymid == ylim)) {
+            for (int x = xoff; x < xlim; x++) ctx->xchanged[x] = true;
+            for (int y = yoff; y < ylim; y++) ctx->ychanged[y] = true;
+            continue;
+        }
+
+        if (stack_count + 2 > stack_capacity) {
+            int capacity = stack_capacity * 2;
+            MyersRange* grown = (MyersRange*)realloc(stack, sizeof(MyersRange) * capacity);
+            if (!grown) {
+                handle_out_of_memory("diff range stack");
+                free(stack);
+                return -1;
+            }
+            stack = grown;
+            stack_capacity = capacity;
+        }
+
+        stack[stack_count++] = (MyersRange){xmid, xlim, ymid, ylim};
+        stack[stack_count++] = (MyersRange){xoff, xmid, yoff, ymid};
+    }
+
+    free(stack);
+    return 0;
+}
+
+/*
+ * splits the sequences at lines that occur exactly once on each side, the
+ * way patience diff does. the longest run of such lines that appears in the
+ * same order on both sides is kept as fixed points and myers only has to
+ * work on the gaps between them, which keeps big bodies with changes all
+ * over the place from turning into one huge expensive range.
+ */
+static MyersRange* diff_anchor_ranges(const int* xv, int xn, const int* yv, int yn,
+                                      const int* counts, int id_count, int* range_count) {
+    int* y_position = (int*)malloc(sizeof(int) * (id_count > 0 ? id_count : 1));
+    int* candidates_x = (int*)malloc(sizeof(int) * (xn + 1));
+    int* candidates_y = (int*)malloc(sizeof(int) * (xn + 1));
+    int* tails = (int*)malloc(sizeof(int) * (xn + 1));
+    int* previous = (int*)malloc(sizeof(int) * (xn + 1));
+    MyersRange* ranges = NULL;
+
+    if (!y_position || !candidates_x || !candidates_y || !tails || !previous) {
+        handle_out_of_memory("diff anchors");
+        goto done;
+    }
+
+    for (int i = 0; i < id_count; i++) {
+        y_position[i] = -1;
+    }
+    for (int y = 0; y < yn; y++) {
+        int id = yv[y];
+        if (counts[id * 2] == 1 && counts[id * 2 + 1] == 1) {
+            y_position[id] = y;
+        }
+    }
+
+    int candidate_count = 0;
+    for (int x = 0; x < xn; x++) {
+        int y = y_position[xv[x]];
+        if (y >= 0) {
+            candidates_x[candidate_count] = x;
+            candidates_y[candidate_count] = y;
+            candidate_count++;
+        }
+    }
+
+    /* longest increasing run of y positions, o(n log n) with patience sorting */
+    int length = 0;
+    for (int i = 0; i < candidate_count; i++) {
+        int low = 0, high = length;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (candidates_y[tails[middle]] < candidates_y[i]) low = middle + 1; else high = middle;
+        }
+        previous[i] = low > 0 ? tails[low - 1] : -1;
+        tails[low] = i;
+        if (low == length) length++;
+    }
+
+    ranges = (MyersRange*)malloc(sizeof(MyersRange) * (length + 1));
+    if (!ranges) {
+        handle_out_of_memory("diff anchors");
+        goto done;
+    }
+
+    /* walk the chain backwards, each anchor closes the gap in front of it */
+    int count = length + 1;
+    int next_x = xn, next_y = yn;
+    int k = length > 0 ? tails[length - 1] : -1;
+    for (int r = length; r >= 0; r--) {
+        int anchor_x = k >= 0 ? candidates_x[k] : -1;
+        int anchor_y = k >= 0 ? candidates_y[k] : -1;
+        ranges[r] = (MyersRange){anchor_x + 1, next_x, anchor_y + 1, next_y};
+        next_x = anchor_x;
+        next_y = anchor_y;
+        k = k >= 0 ? previous[k] : -1;
+    }
+    *range_count = count;
+
+done:
+    free(y_position);
+    free(candidates_x);
+    free(candidates_y);
+    free(tails);
+    free(previous);
+    return ranges;
+}
+
+/* ------------------------------------------------------------------ */
+/* building the side-by-side rows                                      */
+/* ------------------------------------------------------------------ */
+
+static int push_row(ResponseDiff* diff, int* capacity, int left, int right, int kind) {
+    if (diff->row_count == *capacity) {
+        int grown_capacity = *capacity ? *capacity * 2 : 1024;
+        DiffRow* rows = (DiffRow*)realloc(diff->rows, sizeof(DiffRow) * grown_capacity);
+        if (!rows) {
+            handle_out_of_memory("diff rows");
+            return -1;
+        }
+        diff->rows = rows;
+        *capacity = grown_capacity;
+    }
+
+    DiffRow* row = &diff->rows[diff->row_count++];
+    row->left_line = left;
+    row->right_line = right;
+    row->kind = kind;
+    return 0;
+}
+
+static int push_hunk(ResponseDiff* diff, int* capacity, int row) {
+    if (diff->hunk_count == *capacity) {
+        int grown_capacity = *capacity ? *capacity * 2 : 64;
+        int* hunks = (int*)realloc(diff->hunks, sizeof(int) * grown_capacity);
+        if (!hunks) {
+            handle_out_of_memory("diff hunks");
+            return -1;
+        }
+        diff->hunks = hunks;
+        *capacity = grown_capacity;
+    }
+
+    diff->hunks[diff->hunk_count++] = row;
+    return 0;
+}
+
+/* pairs up changed lines block by block, the leftovers become pure deletes or inserts */
+static int build_rows(ResponseDiff* diff, const bool* left_changed, const bool* right_changed) {
+    int left_count = diff->sides[0].count;
+    int right_count = diff->sides[1].count;
+    int row_capacity = 0;
+    int hunk_capacity = 0;
+    int i = 0, j = 0;
+
+    while (i < left_count || j < right_count) {
+        if (i < left_count && j < right_count && !left_changed[i] && !right_changed[j]) {
+            if (lines_equal(&diff->sides[0], i, &diff->sides[1], j)) {
+                if (push_row(diff, &row_capacity, i++, j++, DIFF_ROW_EQUAL) != 0) return -1;
+            } else {
+                /* the hashes collided, the lines only looked equal */
+                if (push_hunk(diff, &hunk_capacity, diff->row_count) != 0) return -1;
+                if (push_row(diff, &row_capacity, i++, j++, DIFF_ROW_CHANGED) != 0) return -1;
+                diff->changed++;
+            }
+            continue;
+        }
+
+        int left_start = i, right_start = j;
+        while (i < left_count && left_changed[i]) i++;
+        while (j < right_count && right_changed[j]) j++;
+
+        /* one side ran out while the other still has unchanged lines, treat them as changes */
+        if (i == left_start && j == right_start) {
+            if (i < left_count) i++; else j++;
+        }
+
+        if (push_hunk(diff, &hunk_capacity, diff->row_count) != 0) return -1;
+
+        int removed = i - left_start;
+        int added = j - right_start;
+        int paired = removed < added ? removed : added;
+        for (int k = 0; k < paired; k++) {
+            if (push_row(diff, &row_capacity, left_start + k, right_start + k, DIFF_ROW_CHANGED) != 0) return -1;
+        }
+        for (int k = paired; k < removed; k++) {
+            if (push_row(diff, &row_capacity, left_start + k, -1, DIFF_ROW_DELETED) != 0) return -1;
+        }
+        for (int k = paired; k < added; k++) {
+            if (push_row(diff, &row_capacity, -1, right_start + k, DIFF_ROW_INSERTED) != 0) return -1;
+        }
+
+        diff->changed += paired;
+        diff->removed += removed - paired;
+        diff->added += added - paired;
+    }
+
+    return 0;
+}
+
+/* runs the full line diff over diff->sides */
+static int run_line_diff(ResponseDiff* diff) {
+    for (int s = 0; s < 2; s++) {
+        if (split_lines(diff, &diff->sides[s]) != 0) {
+            if (!diff->error[0]) diff_set_error(diff, "Out of memory splitting lines");
+            return -1;
+        }
+    }
+    if (diff_cancelled(diff)) {
+        return -1;
+    }
+
+    int* ids[2] = {NULL, NULL};
+    int* counts = NULL;
+    bool* changed[2] = {NULL, NULL};
+    int* reduced[2] = {NULL, NULL};
+    int* reduced_map[2] = {NULL, NULL};
+    bool* reduced_changed[2] = {NULL, NULL};
+    int reduced_count[2] = {0, 0};
+    int* diagonals = NULL;
+    MyersRange* ranges = NULL;
+    int result = -1;
+
+    /* unchanged head and tail lines are common in practice and cost nothing to skip */
+    int begin[2] = {0, 0};
+    int end[2] = {diff->sides[0].count, diff->sides[1].count};
+    while (begin[0] < end[0] && begin[1] < end[1] &&
+           lines_equal(&diff->sides[0], begin[0], &diff->sides[1], begin[1])) {
+        begin[0]++;
+        begin[1]++;
+    }
+    while (end[0] > begin[0] && end[1] > begin[1] &&
+           lines_equal(&diff->sides[0], end[0] - 1, &diff->sides[1], end[1] - 1)) {
+        end[0]--;
+        end[1]--;
+    }
+
+    int id_count = 0;
+    if (intern_lines(diff, begin, end, ids, &counts, &id_count) != 0) {
+        diff_set_error(diff, "Out of memory comparing lines");
+        goto done;
+    }
+    if (diff_cancelled(diff)) {
+        goto done;
+    }
+
+    for (int s = 0; s < 2; s++) {
+        int count = diff->sides[s].count;
+        changed[s] = (bool*)calloc(count + 1, sizeof(bool));
+        reduced[s] = (int*)malloc(sizeof(int) * (count + 1));
+        reduced_map[s] = (int*)malloc(sizeof(int) * (count + 1));
+        reduced_changed[s] = (bool*)calloc(count + 1, sizeof(bool));
+        if (!changed[s] || !reduced[s] || !reduced_map[s] || !reduced_changed[s]) {
+            handle_out_of_memory("diff sequences");
+            diff_set_error(diff, "Out of memory comparing lines");
+            goto done;
+        }
+
+        /* a line that never appears on the other side is a change no matter what */
+        int other = 1 - s;
+        for (int i = begin[s]; i < end[s]; i++) {
+            int id = ids[s][i - begin[s]];
+            if (counts[id * 2 + other] == 0) {
+                changed[s][i] = true;
+            } else {
+                reduced[s][reduced_count[s]] = id;
+                reduced_map[s][reduced_count[s]] = i;
+                reduced_count[s]++;
+            }
+        }
+    }
+
+    size_t diagonal_count = (size_t)reduced_count[0] + reduced_count[1] + 3;
+    diagonals = (int*)malloc(sizeof(int) * diagonal_count * 2);
+    if (!diagonals) {
+        handle_out_of_memory("diff diagonals");
+        diff_set_error(diff, "Out of memory comparing lines");
+        goto done;
+    }
+
+    MyersContext ctx;
+    ctx.xv = reduced[0];
+    ctx.yv = reduced[1];
+    ctx.xchanged = reduced_changed[0];
+    ctx.ychanged = reduced_changed[1];
+    ctx.fd = diagonals + reduced_count[1] + 1;
+    ctx.bd = diagonals + diagonal_count + reduced_count[1] + 1;
+    ctx.cost_limit = (int)sqrt((double)diagonal_count) * 4;
+    if (ctx.cost_limit < DIFF_MIN_COST_LIMIT) {
+        ctx.cost_limit = DIFF_MIN_COST_LIMIT;
+    }
+    ctx.work = 0;
+    ctx.work_limit = DIFF_WORK_LIMIT;
+    ctx.owner = diff;
+
+    int range_count = 0;
+    ranges = diff_anchor_ranges(reduced[0], reduced_count[0], reduced[1], reduced_count[1],
+                                counts, id_count, &range_count);
+    if (!ranges || diff_compare_sequences(&ctx, ranges, range_count) != 0) {
+        diff_set_error(diff, "Out of memory comparing lines");
+        goto done;
+    }
+    if (diff_cancelled(diff)) {
+        goto done;
+    }
+
+    for (int s = 0; s < 2; s++) {
+        for (int i = 0; i < reduced_count[s]; i++) {
+            if (reduced_changed[s][i]) {
+                changed[s][reduced_map[s][i]] = true;
+            }
+        }
+    }
+
+    if (build_rows(diff, changed[0], changed[1]) != 0) {
+        diff_set_error(diff, "Out of memory building diff");
+        goto done;
+    }
+
+    result = 0;
+
+done:
+    for (int s = 0; s < 2; s++) {
+        free(ids[s]);
+        free(changed[s]);
+        free(reduced[s]);
+        free(reduced_map[s]);
+        free(reduced_changed[s]);
+    }
+    free(counts);
+    free(diagonals);
+    free(ranges);
+    return result;
+}
+
+/* ------------------------------------------------------------------ */
+/* structural json diff                                                */
+/* ------------------------------------------------------------------ */
+
+static void json_preview(const cJSON* node, char* buffer, size_t size) {
+    if (!node) {
+        buffer[0] = '\0';
+        return;
+    }
+
+    if (cJSON_IsObject(node)) {
+        snprintf(buffer, size, "{...} (%d members)", cJSON_GetArraySize(node));
+    } else if (cJSON_IsArray(node)) {
+        snprintf(buffer, size, "[...] (%d items)", cJSON_GetArraySize(node));
+    } else {
+        char* printed = cJSON_PrintUnformatted(node);
+        snprintf(buffer, size, "%s", printed ? printed : "?");
+        if (printed) {
+            cJSON_free(printed);
+        }
+    }
+}
+
+static bool add_json_entry(ResponseDiff* diff, int kind, const char* path, const cJSON* left, const cJSON* right) {
+    if (diff->json_count >= RESPONSE_DIFF_MAX_JSON_ENTRIES) {
+        diff->truncated = true;
+        return false;
+    }
+
+    if (diff->json_count == diff->json_capacity) {
+        int capacity = diff->json_capacity ? diff->json_capacity * 2 : 64;
+        JsonDiffEntry* entries = (JsonDiffEntry*)realloc(diff->json_entries, sizeof(JsonDiffEntry) * capacity);
+        if (!entries) {
+            handle_out_of_memory("json diff entries");
+            diff->truncated = true;
+            return false;
+        }
+        diff->json_entries = entries;
+        diff->json_capacity = capacity;
+    }
+
+    JsonDiffEntry* entry = &diff->json_entries[diff->json_count++];
+    entry->kind = kind;
+    snprintf(entry->path, sizeof(entry->path), "%s", path);
+    json_preview(left, entry->left, sizeof(entry->left));
+    json_preview(right, entry->right, sizeof(entry->right));
+    return true;
+}
+
+static bool json_scalars_equal(const cJSON* left, const cJSON* right) {
+    if ((left->type & 0xFF) != (right->type & 0xFF)) {
+        return false;
+    }
+    if (cJSON_IsNumber(left)) {
+        return left->valuedouble == right->valuedouble;
+    }
+    if (cJSON_IsString(left)) {
+        return strcmp(left->valuestring ? left->valuestring : "", right->valuestring ? right->valuestring : "") == 0;
+    }
+    return true;
+}
+
+static int compare_member_names(const void* a, const void* b) {
+    const cJSON* left = *(const cJSON* const*)a;
+    const cJSON* right = *(const cJSON* const*)b;
+    return strcmp(left->string ? left->string : "", right->string ? right->string : "");
+}
+
+/* collects the children of a container so objects can be matched by sorted key */
+static const cJSON** json_children(const cJSON* node, int* count, bool sort) {
+    int size = cJSON_GetArraySize(node);
+    const cJSON** children = (const cJSON**)malloc(sizeof(cJSON*) * (size > 0 ? size : 1));
+    if (!children) {
+        handle_out_of_memory("json diff children");
+        return NULL;
+    }
+
+    int i = 0;
+    for (const cJSON* child = node->child; child && i < size; child = child->next) {
+        children[i++] = child;
+    }
+    if (sort) {
+        qsort(children, i, sizeof(cJSON*), compare_member_names);
+    }
+    *count = i;
+    return children;
+}
+
+/* path is a scratch buffer shared by the whole walk, each level appends and restores it */
+static bool json_diff_walk(ResponseDiff* diff, const cJSON* left, const cJSON* right, char* path, size_t path_size) {
+    if (diff_cancelled(diff)) {
+        return false;
+    }
+
+    bool left_object = cJSON_IsObject(left), right_object = cJSON_IsObject(right);
+    bool left_array = cJSON_IsArray(left), right_array = cJSON_IsArray(right);
+
+    if (left_object != right_object || left_array != right_array) {
+        return add_json_entry(diff, JSON_DIFF_CHANGED, path, left, right);
+    }
+    if (!left_object && !left_array) {
+        return json_scalars_equal(left, right) ? true : add_json_entry(diff, JSON_DIFF_CHANGED, path, left, right);
+    }
+
+    size_t path_length = strlen(path);
+    int left_count = 0, right_count = 0;
+    const cJSON** left_children = json_children(left, &left_count, left_object);
+    const cJSON** right_children = json_children(right, &right_count, left_object);
+    bool keep_going = left_children && right_children;
+
+    if (keep_going && left_array) {
+        int common = left_count < right_count ? left_count : right_count;
+        for (int i = 0; i < left_count || i < right_count; i++) {
+            snprintf(path + path_length, path_size - path_length, "[%d]", i);
+            if (i < common) {
+                keep_going = json_diff_walk(diff, left_children[i], right_children[i], path, path_size);
+            } else if (i < left_count) {
+                keep_going = add_json_entry(diff, JSON_DIFF_REMOVED, path, left_children[i], NULL);
+            } else {
+                keep_going = add_json_entry(diff, JSON_DIFF_ADDED, path, NULL, right_children[i]);
+            }
+            if (!keep_going) break;
+        }
+    } else if (keep_going) {
+        int i = 0, j = 0;
+        while (keep_going && (i < left_count || j < right_count)) {
+            int order;
+            if (i == left_count) order = 1;
+            else if (j == right_count) order = -1;
+            else order = compare_member_names(&left_children[i], &right_children[j]);
+
+            const char* name = order <= 0 ? left_children[i]->string : right_children[j]->string;
+            snprintf(path + path_length, path_size - path_length, ".%s", name ? name : "");
+
+            if (order == 0) {
+                keep_going = json_diff_walk(diff, left_children[i++], right_children[j++], path, path_size);
+            } else if (order < 0) {
+                keep_going = add_json_entry(diff, JSON_DIFF_REMOVED, path, left_children[i++], NULL);
+            } else {
+                keep_going = add_json_entry(diff, JSON_DIFF_ADDED, path, NULL, right_children[j++]);
+            }
+        }
+    }
+
+    path[path_length] = '\0';
+    free(left_children);
+    free(right_children);
+    return keep_going;
+}
+
+static int run_json_diff(ResponseDiff* diff) {
+    cJSON* left = cJSON_ParseWithLength(diff->sides[0].text, diff->sides[0].size);
+    if (!left) {
+        diff_set_error(diff, "Previous response is not valid JSON");
+        return -1;
+    }
+
+    cJSON* right = cJSON_ParseWithLength(diff->sides[1].text, diff->sides[1].size);
+    if (!right) {
+        cJSON_Delete(left);
+        diff_set_error(diff, "Current response is not valid JSON");
+        return -1;
+    }
+
+    char path[256] = "$";
+    json_diff_walk(diff, left, right, path, sizeof(path));
+
+    cJSON_Delete(left);
+    cJSON_Delete(right);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* lifecycle                                                           */
+/* ------------------------------------------------------------------ */
+
+static void clear_results(ResponseDiff* diff) {
+    for (int s = 0; s < 2; s++) {
+        free(diff->sides[s].text);
+        free(diff->sides[s].lines);
+        memset(&diff->sides[s], 0, sizeof(DiffText));
+    }
+
+    free(diff->rows);
+    diff->rows = NULL;
+    diff->row_count = 0;
+    free(diff->hunks);
+    diff->hunks = NULL;
+    diff->hunk_count = 0;
+    diff->added = 0;
+    diff->removed = 0;
+    diff->changed = 0;
+
+    free(diff->json_entries);
+    diff->json_entries = NULL;
+    diff->json_count = 0;
+    diff->json_capacity = 0;
+    diff->truncated = false;
+
+    diff->error[0] = '\0';
+    diff->elapsed_ms = 0.0;
+}
+
+static void* response_diff_worker(void* arg) {
+    ResponseDiff* diff = (ResponseDiff*)arg;
+    double started = diff_now_ms();
+
+    int result = diff->mode == RESPONSE_DIFF_MODE_JSON ? run_json_diff(diff) : run_line_diff(diff);
+    if (result != 0 && diff_cancelled(diff) && !diff->error[0]) {
+        diff_set_error(diff, "Cancelled");
+    }
+
+    pthread_mutex_lock(&diff->mutex);
+    diff->elapsed_ms = diff_now_ms() - started;
+    diff->running = false;
+    pthread_mutex_unlock(&diff->mutex);
+
+    wake_signal_post();
+    return NULL;
+}
+
+/* creates an idle diff */
+ResponseDiff* response_diff_create(void) {
+    ResponseDiff* diff = (ResponseDiff*)calloc(1, sizeof(ResponseDiff));
+    if (!diff) {
+        handle_out_of_memory("response diff creation");
+        return NULL;
+    }
+
+    pthread_mutex_init(&diff->mutex, NULL);
+    atomic_init(&diff->cancel_requested, 0);
+    return diff;
+}
+
+/* stops the worker and frees the results */
+void response_diff_destroy(ResponseDiff* diff) {
+    if (!diff) {
+        return;
+    }
+
+    response_diff_cancel(diff);
+    clear_results(diff);
+    pthread_mutex_destroy(&diff->mutex);
+    free(diff);
+}
+
+/* asks the worker to stop and waits for it */
+void response_diff_cancel(ResponseDiff* diff) {
+    if (!diff || !diff->thread_started) {
+        return;
+    }
+
+    atomic_store(&diff->cancel_requested, 1);
+    pthread_join(diff->thread, NULL);
+    diff->thread_started = false;
+    atomic_store(&diff->cancel_requested, 0);
+}
+
+static char* copy_text(const char* text, size_t size) {
+    char* copy = (char*)malloc(size + 1);
+    if (!copy) {
+        handle_out_of_memory("diff text copy");
+        return NULL;
+    }
+    if (size > 0) {
+        memcpy(copy, text, size);
+    }
+    copy[size] = '\0';
+    return copy;
+}
+
+/* copies both texts and starts the worker */
+int response_diff_start(ResponseDiff* diff, const char* left, size_t left_size,
+                        const char* right, size_t right_size, int mode) {
+    if (!diff) {
+        return -1;
+    }
+
+    response_diff_cancel(diff);
+    clear_results(diff);
+    diff->generation++;
+    diff->mode = mode;
+
+    diff->sides[0].text = copy_text(left ? left : "", left ? left_size : 0);
+    diff->sides[0].size = left ? left_size : 0;
+    diff->sides[1].text = copy_text(right ? right : "", right ? right_size : 0);
+    diff->sides[1].size = right ? right_size : 0;
+    if (!diff->sides[0].text || !diff->sides[1].text) {
+        diff_set_error(diff, "Out of memory copying responses");
+        return -1;
+    }
+
+    diff->running = true;
+    if (pthread_create(&diff->thread, NULL, response_diff_worker, diff) != 0) {
+        diff->running = false;
+        diff_set_error(diff, "Failed to start diff thread");
+        return -1;
+    }
+    diff->thread_started = true;
+    return 0;
+}
+
+bool response_diff_is_running(ResponseDiff* diff) {
+    if (!diff) {
+        return false;
+    }
+
+    pthread_mutex_lock(&diff->mutex);
+    bool running = diff->running;
+    pthread_mutex_unlock(&diff->mutex);
+    return running;
+}
+
+unsigned int response_diff_get_generation(ResponseDiff* diff) {
+    return diff ? diff->generation : 0;
+}
+
+const char* response_diff_get_error(ResponseDiff* diff) {
+    if (!diff || response_diff_is_running(diff)) {
+        return "";
+    }
+    return diff->error;
+}
+
+double response_diff_get_elapsed_ms(ResponseDiff* diff) {
+    if (!diff || response_diff_is_running(diff)) {
+        return 0.0;
+    }
+    return diff->elapsed_ms;
+}
+
+int response_diff_get_mode(ResponseDiff* diff) {
+    return diff ? diff->mode : RESPONSE_DIFF_MODE_LINES;
+}
+
+/* line diff results */
+const DiffRow* response_diff_get_rows(ResponseDiff* diff, int* count) {
+    if (!diff || response_diff_is_running(diff)) {
+        if (count) *count = 0;
+        return NULL;
+    }
+    if (count) *count = diff->row_count;
+    return diff->rows;
+}
+
+int response_diff_get_hunk_count(ResponseDiff* diff) {
+    if (!diff || response_diff_is_running(diff)) {
+        return 0;
+    }
+    return diff->hunk_count;
+}
+
+int response_diff_get_hunk_row(ResponseDiff* diff, int hunk) {
+    if (!diff || hunk < 0 || hunk >= diff->hunk_count) {
+        return -1;
+    }
+    return diff->hunks[hunk];
+}
+
+const char* response_diff_get_line(ResponseDiff* diff, int side, int line, size_t* length) {
+    if (!diff || side < 0 || side > 1 || line < 0 || line >= diff->sides[side].count) {
+        if (length) *length = 0;
+        return NULL;
+    }
+
+    const DiffLine* entry = &diff->sides[side].lines[line];
+    if (length) *length = entry->length;
+    return diff->sides[side].text + entry->offset;
+}
+
+void response_diff_get_stats(ResponseDiff* diff, int* added, int* removed, int* changed) {
+    bool ready = diff && !response_diff_is_running(diff);
+    if (added) *added = ready ? diff->added : 0;
+    if (removed) *removed = ready ? diff->removed : 0;
+    if (changed) *changed = ready ? diff->changed : 0;
+}
+
+/* structural json diff results */
+const JsonDiffEntry* response_diff_get_json_entries(ResponseDiff* diff, int* count) {
+    if (!diff || response_diff_is_running(diff)) {
+        if (count) *count = 0;
+        return NULL;
+    }
+    if (count) *count = diff->json_count;
+    return diff->json_entries;
+}
+
+bool response_diff_is_truncated(ResponseDiff* diff) {
+    return diff && !response_diff_is_running(diff) && diff->truncated;
+}
+
+/* ------------------------------------------------------------------ */
+/* headers                                                             */
+/* ------------------------------------------------------------------ */
+
+static int find_header(const HeaderList* list, const char* name, const bool* used) {
+    for (int i = 0; i < list->count; i++) {
+        if (!used[i] && strcasecmp(list->headers[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void fill_header_entry(HeaderDiffEntry* entry, int kind, const char* name, const char* left, const char* right) {
+    entry->kind = kind;
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    snprintf(entry->left, sizeof(entry->left), "%s", left ? left : "");
+    snprintf(entry->right, sizeof(entry->right), "%s", right ? right : "");
+}
+
+/* headers are matched by case-insensitive name, repeated names pair up in order */
+int response_diff_headers(const HeaderList* left, const HeaderList* right, HeaderDiffEntry** entries) {
+    if (!left || !right || !entries) {
+        return -1;
+    }
+
+    *entries = NULL;
+    int capacity = left->count + right->count;
+    HeaderDiffEntry* list = (HeaderDiffEntry*)malloc(sizeof(HeaderDiffEntry) * (capacity > 0 ? capacity : 1));
+    bool* used = (bool*)calloc(right->count + 1, sizeof(bool));
+    if (!list || !used) {
+        handle_out_of_memory("header diff");
+        free(list);
+        free(used);
+        return -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < left->count; i++) {
+        const Header* header = &left->headers[i];
+        int match = find_header(right, header->name, used);
+        if (match < 0) {
+            fill_header_entry(&list[count++], JSON_DIFF_REMOVED, header->name, header->value, NULL);
+        } else {
+            used[match] = true;
+            if (strcmp(header->value, right->headers[match].value) != 0) {
+                fill_header_entry(&list[count++], JSON_DIFF_CHANGED, header->name, header->value,
+                                  right->headers[match].value);
+            }
+        }
+    }
+
+    for (int i = 0; i < right->count; i++) {
+        if (!used[i]) {
+            fill_header_entry(&list[count++], JSON_DIFF_ADDED, right->headers[i].name, NULL, right->headers[i].value);
+        }
+    }
+
+    free(used);
+    *entries = list;
+    return count;
+}
@@ -0,0 +1,782 @@
+/**
+ * incremental full-text search over response bodies for tinyrequest
+ *
+ * the text to search is copied once per response and then split into
+ * contiguous chunks, one per worker thread. each worker scans its chunk in small slices and
+ * publishes what it found after every slice, so the ui sees matches trickle
+ * in instead of waiting for the whole body. cancellation is checked between
+ * slices, which keeps restarting a search on every keystroke cheap.
+ *
+ * matches stay grouped by chunk and chunks cover the text in order, so the
+ * combined match list is always sorted by offset even while it is growing.
+ *
+ * a separate thread counts the newlines of the copy once, keeping the line
+ * number and line start at every block boundary. turning an offset into a
+ * line then scans one block at most.
+ */
+
+#include "response_search.h"
+#include "wake_signal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <regex.h>
+#ifdef REG_STARTEND
+#define RESPONSE_SEARCH_HAVE_REGEX 1
+#endif
+#endif
+
+/* bytes scanned between publishing results and checking for cancellation */
+#define SEARCH_SLICE_SIZE (256 * 1024)
+/* below this size a chunk is not worth its own thread */
+#define SEARCH_MIN_CHUNK_SIZE (1024 * 1024)
+#define SEARCH_PENDING_BATCH 256
+/* bytes between line index entries, the most a lookup has to scan */
+#define SEARCH_LINE_BLOCK_SIZE (64 * 1024)
+
+/* one worker's share of the text and the matches it has published */
+typedef struct {
+    struct ResponseSearch* owner;
+    size_t begin;
+    size_t end;
+    SearchMatch* matches;
+    int count;
+    int capacity;
+    bool done;
+    bool thread_started;
+    pthread_t thread;
+} SearchChunk;
+
+struct ResponseSearch {
+    pthread_mutex_t mutex;
+    SearchChunk chunks[RESPONSE_SEARCH_MAX_WORKERS];
+    int chunk_count;
+    int running_workers;
+    int total_matches;
+    bool truncated;
+    atomic_int cancel_requested;
+    unsigned int generation;
+
+    char* text;
+    size_t text_size;
+    bool text_lost;
+
+    /* read by lookups only once lines_ready is set */
+    size_t* block_lines;
+    size_t* block_line_starts;
+    size_t line_count;
+    bool lines_ready;
+    bool index_thread_started;
+    pthread_t index_thread;
+    atomic_int index_cancel;
+
+    char pattern[RESPONSE_SEARCH_MAX_PATTERN];
+    unsigned char folded_pattern[RESPONSE_SEARCH_MAX_PATTERN];
+    size_t pattern_len;
+    int flags;
+    char error[128];
+};
+
+/* matches a worker has found but not yet published */
+typedef struct {
+    SearchMatch items[SEARCH_PENDING_BATCH];
+    int count;
+} PendingMatches;
+
+/* global out-of-memory handler */
+static void (*g_search_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_search_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_search_out_of_memory_handler) {
+        g_search_out_of_memory_handler(operation);
+    } else {
+        default_search_out_of_memory_handler(operation);
+    }
+}
+
+/* returns the number of worker threads worth using on this machine */
+static int search_worker_limit(void) {
+#ifndef _WIN32
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        cpus = 1;
+    }
+    return cpus < RESPONSE_SEARCH_MAX_WORKERS ? (int)cpus : RESPONSE_SEARCH_MAX_WORKERS;
+#else
+    return 4;
+#endif
+}
+
+/* moves pending matches into the chunk's shared list, returns false when the worker should stop */
+static bool flush_pending(SearchChunk* chunk, PendingMatches* pending) {
+    ResponseSearch* search = chunk->owner;
+    bool keep_going = true;
+
+    if (pending->count == 0) {
+        return !atomic_load(&search->cancel_requested);
+    }
+
+    pthread_mutex_lock(&search->mutex);
+
+    int room = RESPONSE_SEARCH_MAX_MATCHES - search->total_matches;
+    int to_copy = pending->count;
+    if (to_copy > room) {
+        to_copy = room;
+        search->truncated = true;
+        keep_going = false;
+    }
+
+    if (chunk->count + to_copy > chunk->capacity) {
+        int new_capacity = chunk->capacity > 0 ? chunk->capacity * 2 : 1024;
+        while (new_capacity < chunk->count + to_copy) {
+            new_capacity *= 2;
+        }
+        SearchMatch* grown = (SearchMatch*)realloc(chunk->matches, new_capacity * sizeof(SearchMatch));
+        if (!grown) {
+            handle_out_of_memory("search match list growth");
+            search->truncated = true;
+            to_copy = 0;
+            keep_going = false;
+        } else {
+            chunk->matches = grown;
+            chunk->capacity = new_capacity;
+        }
+    }
+
+    if (to_copy > 0) {
+        memcpy(chunk->matches + chunk->count, pending->items, to_copy * sizeof(SearchMatch));
+        chunk->count += to_copy;
+        search->total_matches += to_copy;
+    }
+
+    pthread_mutex_unlock(&search->mutex);
+
+    pending->count = 0;
+    return keep_going && !atomic_load(&search->cancel_requested);
+}
+
+/* queues a match for publishing, returns false when the worker should stop */
+static bool add_match(SearchChunk* chunk, PendingMatches* pending, size_t offset, size_t length) {
+    pending->items[pending->count].offset = offset;
+    pending->items[pending->count].length = length;
+    pending->count++;
+
+    if (pending->count == SEARCH_PENDING_BATCH) {
+        return flush_pending(chunk, pending);
+    }
+    return true;
+}
+
+/* scans a chunk for an exact substring, using memchr to jump between candidates */
+static void search_chunk_exact(SearchChunk* chunk, PendingMatches* pending) {
+    ResponseSearch* search = chunk->owner;
+    const char* text = search->text;
+    const char* text_end = text + search->text_size;
+    const char* pattern = search->pattern;
+    size_t len = search->pattern_len;
+
+    for (size_t slice = chunk->begin; slice < chunk->end; slice += SEARCH_SLICE_SIZE) {
+        size_t slice_end = slice + SEARCH_SLICE_SIZE < chunk->end ? slice + SEARCH_SLICE_SIZE : chunk->end;
+        const char* p = text + slice;
+        const char* last = text + slice_end;
+
+        while (p < last) {
+            p = (const char*)memchr(p, pattern[0], (size_t)(last - p));
+            if (!p) {
+                break;
+            }
+            if ((size_t)(text_end - p) >= len && memcmp(p + 1, pattern + 1, len - 1) == 0) {
+                if (!add_match(chunk, pending, (size_t)(p - text), len)) {
+                    return;
+                }
+                p += len;
+            } else {
+                p++;
+            }
+        }
+
+        if (!flush_pending(chunk, pending)) {
+            return;
+        }
+    }
+}
+
+/* scans a chunk for a substring ignoring ascii case */
+static void search_chunk_folded(SearchChunk* chunk, PendingMatches* pending) {
+    ResponseSearch* search = chunk->owner;
+    const unsigned char* text = (const unsigned char*)search->text;
+    const unsigned char* text_end = text + search->text_size;
+    const unsigned char* pattern = search->folded_pattern;
+    size_t len = search->pattern_len;
+
+    int first_lower = pattern[0];
+    int first_upper = toupper(pattern[0]);
+
+    for (size_t slice = chunk->begin; slice < chunk->end; slice += SEARCH_SLICE_SIZE) {
+        size_t slice_end = slice + SEARCH_SLICE_SIZE < chunk->end ? slice + SEARCH_SLICE_SIZE : chunk->end;
+        const unsigned char* p = text + slice;
+        const unsigned char* last = text + slice_end;
+
+        /* track the next occurrence of each case of the first byte so memchr does the skipping */
+        const unsigned char* next_lower = NULL;
+        const unsigned char* next_upper = NULL;
+
+        while (p < last) {
+            if (!next_lower || next_lower < p) {
+                next_lower = (const unsigned char*)memchr(p, first_lower, (size_t)(last - p));
+                if (!next_lower) {
+                    next_lower = last;
+                }
+            }
+            if (!next_upper || next_upper < p) {
+                next_upper = first_upper == first_lower ? last :
+                    (const unsigned char*)memchr(p, first_upper, (size_t)(last - p));
+                if (!next_upper) {
+                    next_upper = last;
+                }
+            }
+
+            p = next_lower < next_upper ? next_lower : next_upper;
+            if (p >= last) {
+                break;
+            }
+            if ((size_t)(text_end - p) < len) {
+                break;
+            }
+
+            size_t i = 1;
+            while (i < len && tolower(p[i]) == pattern[i]) {
+                i++;
+            }
+
+            if (i == len) {
+                if (!add_match(chunk, pending, (size_t)(p - text), len)) {
+                    return;
+                }
+                p += len;
+            } else {
+                p++;
+            }
+        }
+
+        if (!flush_pending(chunk, pending)) {
+            return;
+        }
+    }
+}
+
+#ifdef RESPONSE_SEARCH_HAVE_REGEX
+/* scans a chunk line by line with a posix regular expression */
+static void search_chunk_regex(SearchChunk* chunk, PendingMatches* pending) {
+    ResponseSearch* search = chunk->owner;
+    const char* text = search->text;
+    regex_t regex;
+
+    int cflags = REG_EXTENDED | REG_NEWLINE;
+    if (search->flags & RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE) {
+        cflags |= REG_ICASE;
+    }
+    if (regcomp(&regex, search->pattern, cflags) != 0) {
+        return;
+    }
+
+    size_t since_flush = 0;
+    size_t line_start = chunk->begin;
+
+    while (line_start < chunk->end) {
+        const char* newline = (const char*)memchr(text + line_start, '\n', chunk->end - line_start);
+        size_t line_end = newline ? (size_t)(newline - text) : chunk->end;
+
+        size_t cursor = line_start;
+        int eflags = REG_STARTEND;
+        while (cursor <= line_end) {
+            regmatch_t match;
+            match.rm_so = (regoff_t)cursor;
+            match.rm_eo = (regoff_t)line_end;
+            if (regexec(&regex, text, 1, &match, eflags) != 0) {
+                break;
+            }
+
+            size_t match_start = (size_t)match.rm_so;
+            size_t match_end = (size_t)match.rm_eo;
+            if (match_end > match_start) {
+                if (!add_match(chunk, pending, match_start, match_end - match_start)) {
+                    regfree(&regex);
+                    return;
+                }
+                cursor = match_end;
+            } else {
+                /* empty matches are not useful to navigate to, step past them */
+                cursor = match_start + 1;
+            }
+            eflags = REG_STARTEND | REG_NOTBOL;
+        }
+
+        since_flush += line_end - line_start + 1;
+        if (since_flush >= SEARCH_SLICE_SIZE) {
+            since_flush = 0;
+            if (!flush_pending(chunk, pending)) {
+                regfree(&regex);
+                return;
+            }
+        }
+
+        line_start = line_end + 1;
+    }
+
+    flush_pending(chunk, pending);
+    regfree(&regex);
+}
+#endif
+
+/* worker thread entry point, scans one chunk */
+static void* search_worker(void* arg) {
+    SearchChunk* chunk = (SearchChunk*)arg;
+    ResponseSearch* search = chunk->owner;
+    PendingMatches* pending = (PendingMatches*)malloc(sizeof(PendingMatches));
+
+    if (pending) {
+        pending->count = 0;
+#ifdef RESPONSE_SEARCH_HAVE_REGEX
+        if (search->flags & RESPONSE_SEARCH_FLAG_REGEX) {
+            search_chunk_regex(chunk, pending);
+        } else
+#endif
+        if (search->flags & RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE) {
+            search_chunk_folded(chunk, pending);
+        } else {
+            search_chunk_exact(chunk, pending);
+        }
+        free(pending);
+    } else {
+        handle_out_of_memory("search worker buffer");
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    chunk->done = true;
+    search->running_workers--;
+    pthread_mutex_unlock(&search->mutex);
+
+    wake_signal_post();
+    return NULL;
+}
+
+/* counts the newlines of the text once, recording where each block starts */
+static void* line_index_worker(void* arg) {
+    ResponseSearch* search = (ResponseSearch*)arg;
+    const char* text = search->text;
+    size_t block_count = search->text_size / SEARCH_LINE_BLOCK_SIZE + 1;
+    size_t lines = 0;
+    size_t line_start = 0;
+
+    for (size_t block = 0; block < block_count; block++) {
+        if (atomic_load(&search->index_cancel)) {
+            return NULL;
+        }
+
+        size_t begin = block * SEARCH_LINE_BLOCK_SIZE;
+        size_t end = begin + SEARCH_LINE_BLOCK_SIZE < search->text_size ? begin + SEARCH_LINE_BLOCK_SIZE :
+                                                                            search->text_size;
+        search->block_lines[block] = lines;
+        search->block_line_starts[block] = line_start;
+
+        const char* p = text + begin;
+        const char* last = text + end;
+        while (p < last && (p = (const char*)memchr(p, '\n', (size_t)(last - p))) != NULL) {
+            lines++;
+            p++;
+            line_start = (size_t)(p - text);
+        }
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    search->line_count = lines + 1;
+    search->lines_ready = true;
+    pthread_mutex_unlock(&search->mutex);
+
+    wake_signal_post();
+    return NULL;
+}
+
+/* stops the line index thread if it still runs */
+static void stop_line_index(ResponseSearch* search) {
+    if (search->index_thread_started) {
+        atomic_store(&search->index_cancel, 1);
+        pthread_join(search->index_thread, NULL);
+        search->index_thread_started = false;
+        atomic_store(&search->index_cancel, 0);
+    }
+}
+
+/* releases the text copy and its line index, the line index thread must be stopped */
+static void reset_text(ResponseSearch* search) {
+    free(search->text);
+    free(search->block_lines);
+    free(search->block_line_starts);
+    search->text = NULL;
+    search->text_size = 0;
+    search->text_lost = false;
+    search->block_lines = NULL;
+    search->block_line_starts = NULL;
+    search->line_count = 0;
+    search->lines_ready = false;
+}
+
+/* releases every chunk's match list */
+static void reset_results(ResponseSearch* search) {
+    for (int i = 0; i < RESPONSE_SEARCH_MAX_WORKERS; i++) {
+        free(search->chunks[i].matches);
+        memset(&search->chunks[i], 0, sizeof(SearchChunk));
+    }
+    search->chunk_count = 0;
+    search->running_workers = 0;
+    search->total_matches = 0;
+    search->truncated = false;
+    search->error[0] = '\0';
+}
+
+/* creates a new idle search */
+ResponseSearch* response_search_create(void) {
+    ResponseSearch* search = (ResponseSearch*)malloc(sizeof(ResponseSearch));
+    if (!search) {
+        handle_out_of_memory("response search creation");
+        return NULL;
+    }
+
+    memset(search, 0, sizeof(ResponseSearch));
+    if (pthread_mutex_init(&search->mutex, NULL) != 0) {
+        free(search);
+        return NULL;
+    }
+    atomic_init(&search->cancel_requested, 0);
+    atomic_init(&search->index_cancel, 0);
+
+    return search;
+}
+
+/* stops any running workers and frees the search */
+void response_search_destroy(ResponseSearch* search) {
+    if (!search) {
+        return;
+    }
+
+    response_search_cancel(search);
+    stop_line_index(search);
+    reset_results(search);
+    reset_text(search);
+    pthread_mutex_destroy(&search->mutex);
+    free(search);
+}
+
+/* stops running workers and waits for them, results found so far are kept */
+void response_search_cancel(ResponseSearch* search) {
+    if (!search) {
+        return;
+    }
+
+    atomic_store(&search->cancel_requested, 1);
+    for (int i = 0; i < search->chunk_count; i++) {
+        if (search->chunks[i].thread_started) {
+            pthread_join(search->chunks[i].thread, NULL);
+            search->chunks[i].thread_started = false;
+        }
+    }
+    atomic_store(&search->cancel_requested, 0);
+}
+
+/* replaces the text with a private copy and starts indexing its lines */
+int response_search_set_text(ResponseSearch* search, const char* text, size_t text_size) {
+    if (!search) {
+        return -1;
+    }
+
+    response_search_cancel(search);
+    stop_line_index(search);
+    reset_results(search);
+    reset_text(search);
+
+    if (!text || text_size == 0) {
+        return 0;
+    }
+
+    search->text = (char*)malloc(text_size + 1);
+    if (!search->text) {
+        handle_out_of_memory("response search text copy");
+        search->text_lost = true;
+        return -1;
+    }
+    memcpy(search->text, text, text_size);
+    search->text[text_size] = '\0';
+    search->text_size = text_size;
+
+    /* without an index matches are still found, they just have no line */
+    size_t block_count = text_size / SEARCH_LINE_BLOCK_SIZE + 1;
+    search->block_lines = (size_t*)malloc(block_count * sizeof(size_t));
+    search->block_line_starts = (size_t*)malloc(block_count * sizeof(size_t));
+    if (!search->block_lines || !search->block_line_starts) {
+        handle_out_of_memory("response search line index");
+        return 0;
+    }
+    if (pthread_create(&search->index_thread, NULL, line_index_worker, search) == 0) {
+        search->index_thread_started = true;
+    }
+
+    return 0;
+}
+
+/* starts searching the text copy for pattern */
+int response_search_start(ResponseSearch* search, const char* pattern, int flags) {
+    if (!search || !pattern) {
+        return -1;
+    }
+
+    response_search_cancel(search);
+    reset_results(search);
+    search->generation++;
+
+    size_t pattern_len = strlen(pattern);
+    if (pattern_len >= sizeof(search->pattern)) {
+        snprintf(search->error, sizeof(search->error), "Search text is too long");
+        return -1;
+    }
+
+    memcpy(search->pattern, pattern, pattern_len + 1);
+    search->pattern_len = pattern_len;
+    search->flags = flags;
+    for (size_t i = 0; i < pattern_len; i++) {
+        search->folded_pattern[i] = (unsigned char)tolower((unsigned char)pattern[i]);
+    }
+
+    if (pattern_len > 0 && search->text_lost) {
+        snprintf(search->error, sizeof(search->error), "Not enough memory to search this response");
+        return -1;
+    }
+    if (pattern_len == 0 || !search->text) {
+        return 0;
+    }
+
+    if (flags & RESPONSE_SEARCH_FLAG_REGEX) {
+#ifdef RESPONSE_SEARCH_HAVE_REGEX
+        regex_t probe;
+        int cflags = REG_EXTENDED | REG_NEWLINE;
+        if (flags & RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE) {
+            cflags |= REG_ICASE;
+        }
+        int rc = regcomp(&probe, pattern, cflags);
+        if (rc != 0) {
+            char reason[96];
+            regerror(rc, &probe, reason, sizeof(reason));
+            snprintf(search->error, sizeof(search->error), "Invalid regex: %s", reason);
+            return -1;
+        }
+        regfree(&probe);
+#else
+        snprintf(search->error, sizeof(search->error), "Regex search is not supported on this platform");
+        return -1;
+#endif
+    }
+
+    size_t text_size = search->text_size;
+    int chunk_count = (int)(text_size / SEARCH_MIN_CHUNK_SIZE);
+    int worker_limit = search_worker_limit();
+    if (chunk_count < 1) {
+        chunk_count = 1;
+    }
+    if (chunk_count > worker_limit) {
+        chunk_count = worker_limit;
+    }
+
+    /* split evenly, regex chunks are snapped to line starts so lines are never split */
+    size_t chunk_size = text_size / chunk_count;
+    size_t begin = 0;
+    for (int i = 0; i < chunk_count; i++) {
+        size_t end = (i == chunk_count - 1) ? text_size : begin + chunk_size;
+        if ((flags & RESPONSE_SEARCH_FLAG_REGEX) && end < text_size) {
+            const char* newline = (const char*)memchr(search->text + end, '\n', text_size - end);
+            end = newline ? (size_t)(newline - search->text) + 1 : text_size;
+        }
+        if (end < begin) {
+            end = begin;
+        }
+
+        search->chunks[i].owner = search;
+        search->chunks[i].begin = begin;
+        search->chunks[i].end = end;
+        begin = end;
+    }
+    search->chunk_count = chunk_count;
+
+    pthread_mutex_lock(&search->mutex);
+    for (int i = 0; i < chunk_count; i++) {
+        if (pthread_create(&search->chunks[i].thread, NULL, search_worker, &search->chunks[i]) == 0) {
+            search->chunks[i].thread_started = true;
+            search->running_workers++;
+        } else {
+            search->chunks[i].done = true;
+            search->truncated = true;
+        }
+    }
+    pthread_mutex_unlock(&search->mutex);
+
+    return 0;
+}
+
+/* returns how many matches have been published so far */
+int response_search_get_match_count(ResponseSearch* search) {
+    if (!search) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    int count = search->total_matches;
+    pthread_mutex_unlock(&search->mutex);
+    return count;
+}
+
+/* copies the match at index in offset order */
+int response_search_get_match(ResponseSearch* search, int index, SearchMatch* match) {
+    if (!search || !match || index < 0) {
+        return -1;
+    }
+
+    int result = -1;
+    pthread_mutex_lock(&search->mutex);
+    for (int i = 0; i < search->chunk_count; i++) {
+        if (index < search->chunks[i].count) {
+            *match = search->chunks[i].matches[index];
+            result = 0;
+            break;
+        }
+        index -= search->chunks[i].count;
+    }
+    pthread_mutex_unlock(&search->mutex);
+    return result;
+}
+
+/* returns the index of the first match at or after offset, or -1 */
+int response_search_find_next_index(ResponseSearch* search, size_t offset) {
+    if (!search) {
+        return -1;
+    }
+
+    int result = -1;
+    int base = 0;
+    pthread_mutex_lock(&search->mutex);
+    for (int i = 0; i < search->chunk_count && result < 0; i++) {
+        const SearchChunk* chunk = &search->chunks[i];
+        if (chunk->count > 0 && chunk->matches[chunk->count - 1].offset >= offset) {
+            int lo = 0;
+            int hi = chunk->count - 1;
+            while (lo < hi) {
+                int mid = lo + (hi - lo) / 2;
+                if (chunk->matches[mid].offset < offset) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            result = base + lo;
+        }
+        base += chunk->count;
+    }
+    pthread_mutex_unlock(&search->mutex);
+    return result;
+}
+
+/* returns true while any worker is still scanning */
+bool response_search_is_running(ResponseSearch* search) {
+    if (!search) {
+        return false;
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    bool running = search->running_workers > 0;
+    pthread_mutex_unlock(&search->mutex);
+    return running;
+}
+
+/* returns true if the match list was capped or a worker failed */
+bool response_search_is_truncated(ResponseSearch* search) {
+    if (!search) {
+        return false;
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    bool truncated = search->truncated;
+    pthread_mutex_unlock(&search->mutex);
+    return truncated;
+}
+
+/* returns a counter that changes every time a search is started */
+unsigned int response_search_get_generation(ResponseSearch* search) {
+    return search ? search->generation : 0;
+}
+
+/* returns the reason the last start failed, or an empty string */
+const char* response_search_get_error(ResponseSearch* search) {
+    return search ? search->error : "";
+}
+
+/* works out the line and column of offset from the nearest block before it */
+int response_search_locate(ResponseSearch* search, size_t offset, size_t* line, size_t* column) {
+    if (!search || !line || !column) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    bool ready = search->lines_ready;
+    pthread_mutex_unlock(&search->mutex);
+    if (!ready || offset > search->text_size) {
+        return -1;
+    }
+
+    size_t block = offset / SEARCH_LINE_BLOCK_SIZE;
+    size_t lines = search->block_lines[block];
+    size_t line_start = search->block_line_starts[block];
+
+    const char* p = search->text + block * SEARCH_LINE_BLOCK_SIZE;
+    const char* last = search->text + offset;
+    while (p < last && (p = (const char*)memchr(p, '\n', (size_t)(last - p))) != NULL) {
+        lines++;
+        p++;
+        line_start = (size_t)(p - search->text);
+    }
+
+    *line = lines;
+    *column = offset - line_start;
+    return 0;
+}
+
+/* returns the number of lines once the line index is built */
+size_t response_search_get_line_count(ResponseSearch* search) {
+    if (!search) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&search->mutex);
+    size_t count = search->lines_ready ? search->line_count : 0;
+    pthread_mutex_unlock(&search->mutex);
+    return count;
+}
+
+/* returns true if this build supports regex searches */
+bool response_search_regex_supported(void) {
+#ifdef RESPONSE_SEARCH_HAVE_REGEX
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,1023 @@
+/**
+ * auto-save snapshots for tinyrequest
+ *
+ * an object is named <64 bit fnv-1a of its bytes>-<length>, both in hex,
+ * and never changes once written. a manifest is json:
+ *
+ *   { "version": 1, "created_at": <unix seconds>,
+ *     "state": <ref>,
+ *     "collections": [ { "file": "<id>.json", "data": <ref>, "journal": <ref> } ] }
+ *
+ * where a ref is { "object", "size", "mtime" } and size and mtime are what
+ * the file had when it was stored. state and journal are left out when
+ * there was no such file. manifest names sort by the time they were taken.
+ */
+
+#include "snapshot_store.h"
+#include "binary_io.h"
+#include "collection_store.h"
+#include "collection_journal.h"
+#include "persistence.h"
+#include "cJSON.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#endif
+
+#define SNAPSHOT_VERSION 1
+#define OBJECTS_DIR "objects"
+#define SNAPSHOTS_DIR "snapshots"
+#define MANIFEST_PREFIX "snapshot-"
+#define MANIFEST_SUFFIX ".json"
+#define STATE_FILENAME "collections_state.json"
+
+/* where a file was stored and what it looked like then */
+typedef struct {
+    bool present;
+    char object[48];
+    uint64_t size;
+    int64_t mtime;
+} SnapshotRef;
+
+typedef struct {
+    char file[128];         /* name in the collections directory */
+    SnapshotRef data;
+    SnapshotRef journal;
+} SnapshotEntry;
+
+typedef struct {
+    int64_t created_at;
+    SnapshotRef state;
+    SnapshotEntry* entries;
+    int count;
+    int capacity;
+} SnapshotManifest;
+
+typedef struct {
+    char** items;
+    int count;
+    int capacity;
+    bool failed;
+} NameList;
+
+/* global out-of-memory handler */
+static void (*g_snapshot_store_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_snapshot_store_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_snapshot_store_out_of_memory_handler) {
+        g_snapshot_store_out_of_memory_handler(operation);
+    } else {
+        default_snapshot_store_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom handler for out-of-memory situations */
+void snapshot_store_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_snapshot_store_out_of_memory_handler = handler;
+}
+
+/* --- files --- */
+
+static bool has_suffix(const char* name, const char* suffix) {
+    size_t name_length = strlen(name);
+    size_t suffix_length = strlen(suffix);
+    return name_length > suffix_length && strcmp(name + name_length - suffix_length, suffix) == 0;
+}
+
+static char* auto_save_path(const char* directory, const char* filename) {
+    char relative[256];
+    snprintf(relative, sizeof(relative), "%s/%s", directory, filename);
+    return persistence_get_auto_save_path(relative);
+}
+
+static int make_directory(const char* path) {
+#ifdef _WIN32
+    if (_mkdir(path) == 0) {
+        return 0;
+    }
+#else
+    if (mkdir(path, 0755) == 0) {
+        return 0;
+    }
+#endif
+    struct stat st;
+    return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR ? 0 : -1;
+}
+
+/* auto_save and the two directories in it */
+static int create_directories(void) {
+    if (persistence_create_config_dir() != 0 || persistence_create_auto_save_dir() != 0) {
+        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+
+    const char* directories[2] = { OBJECTS_DIR, SNAPSHOTS_DIR };
+    for (int i = 0; i < 2; i++) {
+        char* path = persistence_get_auto_save_path(directories[i]);
+        if (!path) {
+            return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        }
+        int result = make_directory(path);
+        free(path);
+        if (result != 0) {
+            return PERSISTENCE_ERROR_PERMISSION_DENIED;
+        }
+    }
+    return PERSISTENCE_SUCCESS;
+}
+
+/* size and modification time, false if there is no such file */
+static bool stat_file(const char* path, uint64_t* size, int64_t* mtime) {
+    struct stat st;
+    if (stat(path, &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG) {
+        return false;
+    }
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+/* persistence_file_exists logs every call, this runs once per file per snapshot */
+static bool file_exists(const char* path) {
+    uint64_t size;
+    int64_t mtime;
+    return stat_file(path, &size, &mtime);
+}
+
+/* reads a whole file, empty ones included */
+static char* read_file(const char* path, size_t* length, int* error) {
+    *length = 0;
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        *error = file_exists(path) ? PERSISTENCE_ERROR_PERMISSION_DENIED
+                                               : PERSISTENCE_ERROR_FILE_NOT_FOUND;
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (file_size < 0) {
+        fclose(file);
+        *error = PERSISTENCE_ERROR_PERMISSION_DENIED;
+        return NULL;
+    }
+
+    char* data = (char*)malloc((size_t)file_size + 1);
+    if (!data) {
+        fclose(file);
+        handle_out_of_memory("snapshot file read");
+        *error = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
+    }
+
+    size_t read_size = fread(data, 1, (size_t)file_size, file);
+    fclose(file);
+    if (read_size != (size_t)file_size) {
+        free(data);
+        *error = PERSISTENCE_ERROR_CORRUPTED_DATA;
+        return NULL;
+    }
+
+    data[read_size] = '\0';
+    *length = read_size;
+    *error = PERSISTENCE_SUCCESS;
+    return data;
+}
+
+static void name_list_add(NameList* list, const char* name) {
+    if (list->failed) {
+        return;
+    }
+    if (list->count >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 32;
+        char** items = (char**)realloc(list->items, capacity * sizeof(char*));
+        if (!items) {
+            handle_out_of_memory("snapshot name list");
+            list->failed = true;
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    size_t length = strlen(name);
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) {
+        handle_out_of_memory("snapshot name list");
+        list->failed = true;
+        return;
+    }
+    memcpy(copy, name, length + 1);
+    list->items[list->count++] = copy;
+}
+
+static void name_list_free(NameList* list) {
+    for (int i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(NameList));
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static void name_list_sort(NameList* list) {
+    if (list->count > 1) {
+        qsort(list->items, list->count, sizeof(char*), compare_names);
+    }
+}
+
+static bool name_list_contains(const NameList* list, const char* name) {
+    return list->count > 0 &&
+           bsearch(&name, list->items, list->count, sizeof(char*), compare_names) != NULL;
+}
+
+/* the names of the regular files in a directory ending in suffix, unsorted */
+static int list_directory(const char* directory, const char* suffix, NameList* list) {
+#ifdef _WIN32
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s\\*", directory);
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find_handle = FindFirstFileA(pattern, &find_data);
+    if (find_handle == INVALID_HANDLE_VALUE) {
+        return PERSISTENCE_SUCCESS;
+    }
+    do {
+        if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+            (!suffix || has_suffix(find_data.cFileName, suffix))) {
+            name_list_add(list, find_data.cFileName);
+        }
+    } while (FindNextFileA(find_handle, &find_data));
+    FindClose(find_handle);
+#else
+    DIR* dir = opendir(directory);
+    if (!dir) {
+        return PERSISTENCE_SUCCESS;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || (suffix && !has_suffix(entry->d_name, suffix))) {
+            continue;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            name_list_add(list, entry->d_name);
+        }
+    }
+    closedir(dir);
+#endif
+    return list->failed ? PERSISTENCE_ERROR_MEMORY_ALLOCATION : PERSISTENCE_SUCCESS;
+}
+
+/* lists a directory under auto_save */
+static int list_auto_save_directory(const char* name, const char* suffix, NameList* list) {
+    char* directory = persistence_get_auto_save_path(name);
+    if (!directory) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    int result = list_directory(directory, suffix, list);
+    free(directory);
+    return result;
+}
+
+/* --- objects --- */
+
+static void object_name(const void* data, size_t length, char* name, size_t name_size) {
+    snprintf(name, name_size, "%016llx-%llx",
+             (unsigned long long)binary_hash64(data, length), (unsigned long long)length);
+}
+
+static bool object_exists(const char* object) {
+    char* path = auto_save_path(OBJECTS_DIR, object);
+    bool exists = path && file_exists(path);
+    free(path);
+    return exists;
+}
+
+/* reads an object back and checks it is still what its name says */
+static char* read_object(const char* object, size_t* length, int* error) {
+    char* path = auto_save_path(OBJECTS_DIR, object);
+    if (!path) {
+        *error = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return NULL;
+    }
+    char* data = read_file(path, length, error);
+    free(path);
+    if (!data) {
+        return NULL;
+    }
+
+    char expected[48];
+    object_name(data, *length, expected, sizeof(expected));
+    if (strcmp(expected, object) != 0) {
+        free(data);
+        *error = PERSISTENCE_ERROR_CORRUPTED_DATA;
+        return NULL;
+    }
+    return data;
+}
+
+/* stores a file as an object, unless the previous ref says it did not
+ * change. a file that is not there leaves the ref not present */
+static int store_file(const char* path, const SnapshotRef* previous, int64_t previous_created_at,
+                      SnapshotRef* ref) {
+    memset(ref, 0, sizeof(SnapshotRef));
+
+    uint64_t size;
+    int64_t mtime;
+    if (!stat_file(path, &size, &mtime)) {
+        return PERSISTENCE_SUCCESS;
+    }
+
+    /* a write in the second the previous snapshot was taken may not have moved
+     * mtime past what it recorded, such a file is hashed again */
+    if (previous && previous->present && previous->size == size && previous->mtime == mtime &&
+        mtime < previous_created_at && object_exists(previous->object)) {
+        *ref = *previous;
+        return PERSISTENCE_SUCCESS;
+    }
+
+    int error;
+    size_t length;
+    char* data = read_file(path, &length, &error);
+    if (!data) {
+        /* removed between the stat and the read, it is simply not in this snapshot */
+        return error == PERSISTENCE_ERROR_FILE_NOT_FOUND ? PERSISTENCE_SUCCESS : error;
+    }
+
+    object_name(data, length, ref->object, sizeof(ref->object));
+    int result = PERSISTENCE_SUCCESS;
+    if (!object_exists(ref->object)) {
+        char* object_path = auto_save_path(OBJECTS_DIR, ref->object);
+        result = object_path ? persistence_write_file_atomic(object_path, data, length)
+                             : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        free(object_path);
+    }
+    free(data);
+
+    if (result == PERSISTENCE_SUCCESS) {
+        ref->present = true;
+        ref->size = size;
+        ref->mtime = mtime;
+    }
+    return result;
+}
+
+/* --- manifests --- */
+
+static void manifest_cleanup(SnapshotManifest* manifest) {
+    free(manifest->entries);
+    memset(manifest, 0, sizeof(SnapshotManifest));
+}
+
+static SnapshotEntry* manifest_add_entry(SnapshotManifest* manifest) {
+    if (manifest->count >= manifest->capacity) {
+        int capacity = manifest->capacity > 0 ? manifest->capacity * 2 : 16;
+        SnapshotEntry* entries = (SnapshotEntry*)realloc(manifest->entries, capacity * sizeof(SnapshotEntry));
+        if (!entries) {
+            handle_out_of_memory("snapshot manifest");
+            return NULL;
+        }
+        manifest->entries = entries;
+        manifest->capacity = capacity;
+    }
+
+    SnapshotEntry* entry = &manifest->entries[manifest->count++];
+    memset(entry, 0, sizeof(SnapshotEntry));
+    return entry;
+}
+
+static const SnapshotEntry* manifest_find(const SnapshotManifest* manifest, const char* file) {
+    for (int i = 0; i < manifest->count; i++) {
+        if (strcmp(manifest->entries[i].file, file) == 0) {
+            return &manifest->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    return strcmp(((const SnapshotEntry*)a)->file, ((const SnapshotEntry*)b)->file);
+}
+
+static bool same_ref(const SnapshotRef* a, const SnapshotRef* b) {
+    return a->present == b->present && (!a->present || strcmp(a->object, b->object) == 0);
+}
+
+/* true when two manifests would restore the same files */
+static bool same_contents(const SnapshotManifest* a, const SnapshotManifest* b) {
+    if (a->count != b->count || !same_ref(&a->state, &b->state)) {
+        return false;
+    }
+    for (int i = 0; i < a->count; i++) {
+        const SnapshotEntry* x = &a->entries[i];
+        const SnapshotEntry* y = &b->entries[i];
+        if (strcmp(x->file, y->file) != 0 || !same_ref(&x->data, &y->data) || !same_ref(&x->journal, &y->journal)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static cJSON* ref_to_json(const SnapshotRef* ref) {
+    cJSON* json = cJSON_CreateObject();
+    if (json) {
+        cJSON_AddStringToObject(json, "object", ref->object);
+        cJSON_AddNumberToObject(json, "size", (double)ref->size);
+        cJSON_AddNumberToObject(json, "mtime", (double)ref->mtime);
+    }
+    return json;
+}
+
+/* a missing or malformed ref is left not present */
+static bool ref_from_json(const cJSON* json, SnapshotRef* ref) {
+    memset(ref, 0, sizeof(SnapshotRef));
+    if (!json) {
+        return true;
+    }
+
+    const cJSON* object = cJSON_GetObjectItem(json, "object");
+    const cJSON* size = cJSON_GetObjectItem(json, "size");
+    const cJSON* mtime = cJSON_GetObjectItem(json, "mtime");
+    if (!cJSON_IsString(object) || !cJSON_IsNumber(size) || !cJSON_IsNumber(mtime) ||
+        strlen(object->valuestring) >= sizeof(ref->object) || strchr(object->valuestring, '/') ||
+        strchr(object->valuestring, '\\')) {
+        return false;
+    }
+
+    snprintf(ref->object, sizeof(ref->object), "%s", object->valuestring);
+    ref->size = (uint64_t)size->valuedouble;
+    ref->mtime = (int64_t)mtime->valuedouble;
+    ref->present = true;
+    return true;
+}
+
+static char* manifest_serialize(const SnapshotManifest* manifest) {
+    cJSON* json = cJSON_CreateObject();
+    if (!json) {
+        return NULL;
+    }
+
+    cJSON_AddNumberToObject(json, "version", SNAPSHOT_VERSION);
+    cJSON_AddNumberToObject(json, "created_at", (double)manifest->created_at);
+    if (manifest->state.present) {
+        cJSON_AddItemToObject(json, "state", ref_to_json(&manifest->state));
+    }
+
+    cJSON* collections = cJSON_CreateArray();
+    cJSON_AddItemToObject(json, "collections", collections);
+    for (int i = 0; collections && i < manifest->count; i++) {
+        const SnapshotEntry* entry = &manifest->entries[i];
+        cJSON* item = cJSON_CreateObject();
+        if (!item) {
+            break;
+        }
+        cJSON_AddStringToObject(item, "file", entry->file);
+        cJSON_AddItemToObject(item, "data", ref_to_json(&entry->data));
+        if (entry->journal.present) {
+            cJSON_AddItemToObject(item, "journal", ref_to_json(&entry->journal));
+        }
+        cJSON_AddItemToArray(collections, item);
+    }
+
+    char* text = cJSON_Print(json);
+    cJSON_Delete(json);
+    return text;
+}
+
+static bool valid_manifest_name(const char* name) {
+    return name && strncmp(name, MANIFEST_PREFIX, strlen(MANIFEST_PREFIX)) == 0 &&
+           has_suffix(name, MANIFEST_SUFFIX) && !strchr(name, '/') && !strchr(name, '\\') &&
+           strlen(name) < sizeof(((SnapshotInfo*)0)->name);
+}
+
+/* reads a manifest, returns a PersistenceError */
+static int manifest_read(const char* name, SnapshotManifest* manifest) {
+    memset(manifest, 0, sizeof(SnapshotManifest));
+    if (!valid_manifest_name(name)) {
+        return PERSISTENCE_ERROR_INVALID_PATH;
+    }
+
+    char* path = auto_save_path(SNAPSHOTS_DIR, name);
+    if (!path) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    int error;
+    size_t length;
+    char* text = read_file(path, &length, &error);
+    free(path);
+    if (!text) {
+        return error;
+    }
+
+    cJSON* json = cJSON_Parse(text);
+    free(text);
+    if (!json) {
+        return PERSISTENCE_ERROR_INVALID_JSON;
+    }
+
+    int result = PERSISTENCE_SUCCESS;
+    const cJSON* version = cJSON_GetObjectItem(json, "version");
+    const cJSON* created_at = cJSON_GetObjectItem(json, "created_at");
+    const cJSON* collections = cJSON_GetObjectItem(json, "collections");
+    if (!cJSON_IsNumber(version) || version->valueint != SNAPSHOT_VERSION || !cJSON_IsNumber(created_at) ||
+        !cJSON_IsArray(collections) || !ref_from_json(cJSON_GetObjectItem(json, "state"), &manifest->state)) {
+        result = PERSISTENCE_ERROR_CORRUPTED_DATA;
+    } else {
+        manifest->created_at = (int64_t)created_at->valuedouble;
+    }
+
+    const cJSON* item;
+    cJSON_ArrayForEach(item, collections) {
+        if (result != PERSISTENCE_SUCCESS) {
+            break;
+        }
+        const cJSON* file = cJSON_GetObjectItem(item, "file");
+        SnapshotRef data, journal;
+        if (!cJSON_IsString(file) || strlen(file->valuestring) >= sizeof(manifest->entries[0].file) ||
+            strchr(file->valuestring, '/') || strchr(file->valuestring, '\\') ||
+            !ref_from_json(cJSON_GetObjectItem(item, "data"), &data) || !data.present ||
+            !ref_from_json(cJSON_GetObjectItem(item, "journal"), &journal)) {
+            result = PERSISTENCE_ERROR_CORRUPTED_DATA;
+            break;
+        }
+
+        SnapshotEntry* entry = manifest_add_entry(manifest);
+        if (!entry) {
+            result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        snprintf(entry->file, sizeof(entry->file), "%s", file->valuestring);
+        entry->data = data;
+        entry->journal = journal;
+    }
+
+    cJSON_Delete(json);
+    if (result != PERSISTENCE_SUCCESS) {
+        manifest_cleanup(manifest);
+    }
+    return result;
+}
+
+/* the manifests newest first */
+static int list_manifests(NameList* list) {
+    int result = list_auto_save_directory(SNAPSHOTS_DIR, MANIFEST_SUFFIX, list);
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    /* drop anything that is not ours, then reverse the sorted order */
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+        if (valid_manifest_name(list->items[i])) {
+            list->items[kept++] = list->items[i];
+        } else {
+            free(list->items[i]);
+        }
+    }
+    list->count = kept;
+    name_list_sort(list);
+    for (int i = 0; i < list->count / 2; i++) {
+        char* swap = list->items[i];
+        list->items[i] = list->items[list->count - 1 - i];
+        list->items[list->count - 1 - i] = swap;
+    }
+    return PERSISTENCE_SUCCESS;
+}
+
+/* a new manifest name, unused and sorting after every earlier one */
+static bool next_manifest_name(int64_t created_at, char* name, size_t name_size) {
+    time_t seconds = (time_t)created_at;
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+
+    for (int sequence = 0; sequence < 100; sequence++) {
+        snprintf(name, name_size, MANIFEST_PREFIX "%04d%02d%02d-%02d%02d%02d-%02d" MANIFEST_SUFFIX,
+                 utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, sequence);
+        char* path = auto_save_path(SNAPSHOTS_DIR, name);
+        if (!path) {
+            return false;
+        }
+        bool taken = file_exists(path);
+        free(path);
+        if (!taken) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* --- collections directory --- */
+
+/* a collection file's id, its name without the extension. false for other files */
+static bool collection_file_id(const char* file, char* id, size_t id_size) {
+    size_t length = strlen(file);
+    size_t suffix;
+    if (has_suffix(file, ".json")) {
+        suffix = strlen(".json");
+    } else if (has_suffix(file, COLLECTION_STORE_EXTENSION)) {
+        suffix = strlen(COLLECTION_STORE_EXTENSION);
+    } else {
+        return false;
+    }
+    if (length - suffix >= id_size) {
+        return false;
+    }
+    snprintf(id, id_size, "%.*s", (int)(length - suffix), file);
+    return true;
+}
+
+typedef struct {
+    SnapshotManifest* manifest;
+    const SnapshotManifest* previous;
+    int result;
+} CreateContext;
+
+static void store_collection_file(const char* filepath, void* user_data) {
+    CreateContext* context = (CreateContext*)user_data;
+    if (context->result != PERSISTENCE_SUCCESS) {
+        return;
+    }
+
+    const char* file = filepath + strlen(filepath);
+    while (file > filepath && file[-1] != '/' && file[-1] != '\\') {
+        file--;
+    }
+    char id[128];
+    if (!collection_file_id(file, id, sizeof(id))) {
+        return;
+    }
+
+    SnapshotEntry* entry = manifest_add_entry(context->manifest);
+    if (!entry) {
+        context->result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        return;
+    }
+    snprintf(entry->file, sizeof(entry->file), "%s", file);
+
+    const SnapshotEntry* previous = manifest_find(context->previous, file);
+    int64_t previous_created_at = context->previous->created_at;
+    int result = store_file(filepath, previous ? &previous->data : NULL, previous_created_at, &entry->data);
+
+    char* journal_path = collection_journal_get_path(id);
+    if (result == PERSISTENCE_SUCCESS) {
+        result = journal_path ? store_file(journal_path, previous ? &previous->journal : NULL,
+                                           previous_created_at, &entry->journal)
+                              : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    free(journal_path);
+
+    if (result != PERSISTENCE_SUCCESS) {
+        context->result = result;
+    } else if (!entry->data.present) {
+        context->manifest->count--;
+    }
+}
+
+/* --- api --- */
+
+int snapshot_store_create(char* name, size_t name_size, bool* created) {
+    if (created) {
+        *created = false;
+    }
+    if (name && name_size > 0) {
+        name[0] = '\0';
+    }
+
+    int result = create_directories();
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    NameList manifests = {0};
+    result = list_manifests(&manifests);
+    SnapshotManifest previous = {0};
+    if (result == PERSISTENCE_SUCCESS && manifests.count > 0) {
+        /* a broken newest manifest just means every file is hashed again */
+        if (manifest_read(manifests.items[0], &previous) != PERSISTENCE_SUCCESS) {
+            memset(&previous, 0, sizeof(previous));
+        }
+    }
+
+    SnapshotManifest manifest = {0};
+    manifest.created_at = (int64_t)time(NULL);
+
+    if (result == PERSISTENCE_SUCCESS) {
+        char* state_path = persistence_get_config_path(STATE_FILENAME);
+        result = state_path ? store_file(state_path, &previous.state, previous.created_at, &manifest.state)
+                            : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        free(state_path);
+    }
+
+    if (result == PERSISTENCE_SUCCESS) {
+        CreateContext context = { &manifest, &previous, PERSISTENCE_SUCCESS };
+        result = persistence_for_each_collection_file(store_collection_file, &context);
+        if (result == PERSISTENCE_SUCCESS) {
+            result = context.result;
+        }
+    }
+
+    if (result == PERSISTENCE_SUCCESS && manifest.count > 1) {
+        qsort(manifest.entries, manifest.count, sizeof(SnapshotEntry), compare_entries);
+    }
+
+    if (result == PERSISTENCE_SUCCESS) {
+        if (manifests.count > 0 && previous.created_at > 0 && same_contents(&manifest, &previous)) {
+            if (name && name_size > 0) {
+                snprintf(name, name_size, "%s", manifests.items[0]);
+            }
+        } else {
+            char manifest_name[64];
+            char* text = manifest_serialize(&manifest);
+            char* path = NULL;
+            if (!text || !next_manifest_name(manifest.created_at, manifest_name, sizeof(manifest_name)) ||
+                !(path = auto_save_path(SNAPSHOTS_DIR, manifest_name))) {
+                result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            } else {
+                result = persistence_write_file_atomic(path, text, strlen(text));
+            }
+            free(path);
+            free(text);
+
+            if (result == PERSISTENCE_SUCCESS) {
+                if (created) {
+                    *created = true;
+                }
+                if (name && name_size > 0) {
+                    snprintf(name, name_size, "%s", manifest_name);
+                }
+            }
+        }
+    }
+
+    manifest_cleanup(&manifest);
+    manifest_cleanup(&previous);
+    name_list_free(&manifests);
+    return result;
+}
+
+static void add_refs(NameList* referenced, const SnapshotManifest* manifest) {
+    if (manifest->state.present) {
+        name_list_add(referenced, manifest->state.object);
+    }
+    for (int i = 0; i < manifest->count; i++) {
+        name_list_add(referenced, manifest->entries[i].data.object);
+        if (manifest->entries[i].journal.present) {
+            name_list_add(referenced, manifest->entries[i].journal.object);
+        }
+    }
+}
+
+int snapshot_store_rotate(int keep_count) {
+    if (keep_count < 1) {
+        keep_count = 1;
+    }
+
+    NameList manifests = {0};
+    int result = list_manifests(&manifests);
+
+    for (int i = keep_count; result == PERSISTENCE_SUCCESS && i < manifests.count; i++) {
+        char* path = auto_save_path(SNAPSHOTS_DIR, manifests.items[i]);
+        if (!path) {
+            result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        remove(path);
+        free(path);
+    }
+
+    /* every object a kept manifest refers to. one that can not be read keeps
+     * every object, dropping what it refers to would lose it for good */
+    NameList referenced = {0};
+    int kept = manifests.count < keep_count ? manifests.count : keep_count;
+    for (int i = 0; result == PERSISTENCE_SUCCESS && i < kept; i++) {
+        SnapshotManifest manifest;
+        result = manifest_read(manifests.items[i], &manifest);
+        if (result == PERSISTENCE_SUCCESS) {
+            add_refs(&referenced, &manifest);
+            manifest_cleanup(&manifest);
+        }
+    }
+    if (result == PERSISTENCE_SUCCESS && referenced.failed) {
+        result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    name_list_sort(&referenced);
+
+    NameList objects = {0};
+    if (result == PERSISTENCE_SUCCESS) {
+        result = list_auto_save_directory(OBJECTS_DIR, NULL, &objects);
+    }
+    for (int i = 0; result == PERSISTENCE_SUCCESS && i < objects.count; i++) {
+        if (name_list_contains(&referenced, objects.items[i])) {
+            continue;
+        }
+        char* path = auto_save_path(OBJECTS_DIR, objects.items[i]);
+        if (path) {
+            remove(path);
+            free(path);
+        }
+    }
+
+    name_list_free(&objects);
+    name_list_free(&referenced);
+    name_list_free(&manifests);
+    return result;
+}
+
+int snapshot_store_list(SnapshotInfo** snapshots, int* count) {
+    if (!snapshots || !count) {
+        return PERSISTENCE_ERROR_NULL_PARAM;
+    }
+    *snapshots = NULL;
+    *count = 0;
+
+    NameList manifests = {0};
+    int result = list_manifests(&manifests);
+    if (result != PERSISTENCE_SUCCESS || manifests.count == 0) {
+        name_list_free(&manifests);
+        return result;
+    }
+
+    SnapshotInfo* infos = (SnapshotInfo*)calloc(manifests.count, sizeof(SnapshotInfo));
+    if (!infos) {
+        handle_out_of_memory("snapshot list");
+        name_list_free(&manifests);
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    /* broken manifests are skipped, they can not be restored anyway */
+    int listed = 0;
+    for (int i = 0; i < manifests.count; i++) {
+        SnapshotManifest manifest;
+        if (manifest_read(manifests.items[i], &manifest) != PERSISTENCE_SUCCESS) {
+            continue;
+        }
+        SnapshotInfo* info = &infos[listed++];
+        snprintf(info->name, sizeof(info->name), "%s", manifests.items[i]);
+        info->created_at = manifest.created_at;
+        info->collection_count = manifest.count;
+        manifest_cleanup(&manifest);
+    }
+
+    name_list_free(&manifests);
+    *snapshots = infos;
+    *count = listed;
+    return PERSISTENCE_SUCCESS;
+}
+
+typedef struct {
+    char* data;
+    size_t length;
+} LoadedObject;
+
+/* writes one file of a snapshot back, or removes it when the snapshot has none */
+static int restore_file(const char* path, const SnapshotRef* ref, const LoadedObject* object) {
+    if (!path) {
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    if (ref->present) {
+        return persistence_write_file_atomic(path, object->data, object->length);
+    }
+    if (file_exists(path) && remove(path) != 0) {
+        return PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+    return PERSISTENCE_SUCCESS;
+}
+
+int snapshot_store_restore(const char* name) {
+    SnapshotManifest manifest;
+    int result = manifest_read(name, &manifest);
+    if (result != PERSISTENCE_SUCCESS) {
+        return result;
+    }
+
+    /* every object is read and checked before anything is touched, a
+     * snapshot with a missing or damaged object is not half restored.
+     * slot 0 is the state, then data and journal of each entry */
+    int slots = 1 + manifest.count * 2;
+    LoadedObject* objects = (LoadedObject*)calloc(slots, sizeof(LoadedObject));
+    if (!objects) {
+        handle_out_of_memory("snapshot restore");
+        manifest_cleanup(&manifest);
+        return PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    for (int i = 0; result == PERSISTENCE_SUCCESS && i < slots; i++) {
+        const SnapshotRef* ref = i == 0 ? &manifest.state
+                               : (i % 2 ? &manifest.entries[(i - 1) / 2].data : &manifest.entries[(i - 1) / 2].journal);
+        if (ref->present) {
+            objects[i].data = read_object(ref->object, &objects[i].length, &result);
+        }
+    }
+
+    /* what is about to be replaced becomes a snapshot of its own */
+    if (result == PERSISTENCE_SUCCESS) {
+        result = snapshot_store_create(NULL, 0, NULL);
+    }
+    if (result == PERSISTENCE_SUCCESS && persistence_create_collections_dir() != 0) {
+        result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+    }
+
+    /* collection files and journals the snapshot does not have go first */
+    NameList present = {0};
+    NameList wanted = {0};
+    if (result == PERSISTENCE_SUCCESS) {
+        char* directory = persistence_get_collections_path("");
+        result = directory ? list_directory(directory, NULL, &present) : PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+        free(directory);
+    }
+    for (int i = 0; result == PERSISTENCE_SUCCESS && i < manifest.count; i++) {
+        char id[128];
+        if (collection_file_id(manifest.entries[i].file, id, sizeof(id))) {
+            name_list_add(&wanted, id);
+        }
+    }
+    if (result == PERSISTENCE_SUCCESS && (present.failed || wanted.failed)) {
+        result = PERSISTENCE_ERROR_MEMORY_ALLOCATION;
+    }
+    name_list_sort(&wanted);
+    for (int i = 0; result == PERSISTENCE_SUCCESS && i < present.count; i++) {
+        const char* file = present.items[i];
+        char id[128];
+        bool ours = collection_file_id(file, id, sizeof(id));
+        if (!ours && has_suffix(file, ".journal") && strlen(file) - strlen(".journal") < sizeof(id)) {
+            snprintf(id, sizeof(id), "%.*s", (int)(strlen(file) - strlen(".journal")), file);
+            ours = true;
+        }
+        if (ours && !name_list_contains(&wanted, id)) {
+            char* path = persistence_get_collections_path(file);
+            if (path && remove(path) != 0) {
+                result = PERSISTENCE_ERROR_PERMISSION_DENIED;
+            }
+            free(path);
+        }
+    }
+
+    for (int i = 0; result == PERSISTENCE_SUCCESS && i < manifest.count; i++) {
+        const SnapshotEntry* entry = &manifest.entries[i];
+        char id[128];
+        if (!collection_file_id(entry->file, id, sizeof(id))) {
+            continue;
+        }
+
+        char* path = persistence_get_collections_path(entry->file);
+        result = restore_file(path, &entry->data, &objects[1 + i * 2]);
+        free(path);
+
+        /* the same collection in the other format would be loaded next to it */
+        if (result == PERSISTENCE_SUCCESS) {
+            char twin[160];
+            snprintf(twin, sizeof(twin), "%s%s", id,
+                     has_suffix(entry->file, ".json") ? COLLECTION_STORE_EXTENSION : ".json");
+            SnapshotRef none = {0};
+            path = persistence_get_collections_path(twin);
+            result = restore_file(path, &none, NULL);
+            free(path);
+        }
+
+        if (result == PERSISTENCE_SUCCESS) {
+            path = collection_journal_get_path(id);
+            result = restore_file(path, &entry->journal, &objects[2 + i * 2]);
+            free(path);
+        }
+    }
+
+    if (result == PERSISTENCE_SUCCESS && manifest.state.present) {
+        char* path = persistence_get_config_path(STATE_FILENAME);
+        result = restore_file(path, &manifest.state, &objects[0]);
+        free(path);
+    }
+
+    name_list_free(&wanted);
+    name_list_free(&present);
+    for (int i = 0; i < slots; i++) {
+        free(objects[i].data);
+    }
+    free(objects);
+    manifest_cleanup(&manifest);
+    return result;
+}
@@ -0,0 +1,204 @@
+/**
+ * growable text storage for tinyrequest
+ *
+ * buffers start out pointing at a shared empty string and allocate on the
+ * first write. growth doubles the capacity, which keeps appends and
+ * keystrokes amortized constant time.
+ */
+
+#include "text_buffer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* smallest allocation, most bodies fit without ever growing */
+#define TEXT_BUFFER_MIN_CAPACITY 256
+
+static char g_empty_text[1] = {0};
+
+/* global out-of-memory handler */
+static void (*g_text_out_of_memory_handler)(const char* operation) = NULL;
+
+/* default out-of-memory handler */
+static void default_text_out_of_memory_handler(const char* operation) {
+    fprintf(stderr, "Out of memory error during: %s\n", operation ? operation : "unknown operation");
+    fflush(stderr);
+}
+
+/* helper function to handle memory allocation failures */
+static void handle_out_of_memory(const char* operation) {
+    if (g_text_out_of_memory_handler) {
+        g_text_out_of_memory_handler(operation);
+    } else {
+        default_text_out_of_memory_handler(operation);
+    }
+}
+
+/* sets a custom out-of-memory handler for text buffer allocations */
+void text_buffer_set_out_of_memory_handler(void (*handler)(const char* operation)) {
+    g_text_out_of_memory_handler = handler;
+}
+
+/* initializes an empty buffer without allocating */
+void text_buffer_init(TextBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+    buffer->data = g_empty_text;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->generation = 0;
+}
+
+/* frees the buffer's memory and leaves it empty */
+void text_buffer_cleanup(TextBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+    if (buffer->capacity > 0) {
+        free(buffer->data);
+    }
+
+    /* keep counting so results cached for the old content stay stale */
+    unsigned int generation = buffer->generation + 1;
+    text_buffer_init(buffer);
+    buffer->generation = generation;
+}
+
+/* makes room for at least capacity bytes including the terminator */
+int text_buffer_reserve(TextBuffer* buffer, size_t capacity) {
+    if (!buffer) {
+        return -1;
+    }
+    if (capacity <= buffer->capacity) {
+        return 0;
+    }
+    if (capacity > TEXT_BUFFER_MAX_SIZE + 1) {
+        return -1;
+    }
+
+    size_t new_capacity = buffer->capacity > 0 ? buffer->capacity : TEXT_BUFFER_MIN_CAPACITY;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+    if (new_capacity > TEXT_BUFFER_MAX_SIZE + 1) {
+        new_capacity = TEXT_BUFFER_MAX_SIZE + 1;
+    }
+
+    char* data = buffer->capacity > 0 ? (char*)realloc(buffer->data, new_capacity) : (char*)malloc(new_capacity);
+    if (!data) {
+        handle_out_of_memory("text buffer growth");
+        return -1;
+    }
+
+    if (buffer->capacity == 0) {
+        data[0] = '\0';
+    }
+    buffer->data = data;
+    buffer->capacity = new_capacity;
+    return 0;
+}
+
+/* replaces the content with length bytes of text */
+int text_buffer_set(TextBuffer* buffer, const char* text, size_t length) {
+    if (!buffer || (!text && length > 0)) {
+        return -1;
+    }
+    if (length == 0) {
+        text_buffer_clear(buffer);
+        return 0;
+    }
+    if (text_buffer_reserve(buffer, length + 1) != 0) {
+        return -1;
+    }
+
+    memmove(buffer->data, text, length);
+    buffer->data[length] = '\0';
+    buffer->length = length;
+    buffer->generation++;
+    return 0;
+}
+
+int text_buffer_set_cstr(TextBuffer* buffer, const char* text) {
+    return text_buffer_set(buffer, text, text ? strlen(text) : 0);
+}
+
+/* adds length bytes of text at the end */
+int text_buffer_append(TextBuffer* buffer, const char* text, size_t length) {
+    if (!buffer || (!text && length > 0)) {
+        return -1;
+    }
+    if (length == 0) {
+        return 0;
+    }
+    if (length > TEXT_BUFFER_MAX_SIZE - buffer->length ||
+        text_buffer_reserve(buffer, buffer->length + length + 1) != 0) {
+        return -1;
+    }
+
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    buffer->generation++;
+    return 0;
+}
+
+/* adds printf-formatted text at the end */
+int text_buffer_appendf(TextBuffer* buffer, const char* format, ...) {
+    if (!buffer || !format) {
+        return -1;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (needed < 0) {
+        return -1;
+    }
+    if ((size_t)needed > TEXT_BUFFER_MAX_SIZE - buffer->length ||
+        text_buffer_reserve(buffer, buffer->length + (size_t)needed + 1) != 0) {
+        return -1;
+    }
+
+    va_start(args, format);
+    vsnprintf(buffer->data + buffer->length, (size_t)needed + 1, format, args);
+    va_end(args);
+    buffer->length += (size_t)needed;
+    buffer->generation++;
+    return 0;
+}
+
+/* empties the buffer but keeps its memory for reuse */
+void text_buffer_clear(TextBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+    buffer->length = 0;
+    if (buffer->capacity > 0) {
+        buffer->data[0] = '\0';
+    }
+    buffer->generation++;
+}
+
+/* records the length after data was edited in place */
+void text_buffer_set_length(TextBuffer* buffer, size_t length) {
+    if (!buffer || buffer->capacity == 0) {
+        return;
+    }
+    if (length >= buffer->capacity) {
+        length = buffer->capacity - 1;
+    }
+    buffer->length = length;
+    buffer->data[length] = '\0';
+    buffer->generation++;
+}
+
+/* compares the content with length bytes of text */
+bool text_buffer_equals(const TextBuffer* buffer, const char* text, size_t length) {
+    if (!buffer) {
+        return false;
+    }
+    return buffer->length == length && (length == 0 || memcmp(buffer->data, text, length) == 0);
+}
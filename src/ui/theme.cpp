@@ -1,5 +1,6 @@
 #include "ui/theme.h"
 #include "font_awesome.h"
+#include "wake_signal.h"
 #include <stdlib.h>
 #include <math.h>
 
@@ -312,6 +313,9 @@ void theme_render_loading_spinner(const ModernGruvboxTheme* theme) {
     const char* spinner_chars[] = {"|", "/", "-", "\\", "|", "/", "-", "\\"};
     int spinner_index = (int)(spinner_time * 4.0f) % 8;
 
+    /* the spinner moves on its own, keep the idle loop drawing while it is shown */
+    wake_signal_post();
+
     ImGui::TextColored(theme->status_loading, "%s", spinner_chars[spinner_index]);
 }
 
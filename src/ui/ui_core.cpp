@@ -4,6 +4,9 @@
 #include "ui/ui_request_panel.h"
 #include "ui/ui_response_panel.h"
 #include "ui/ui_dialogs.h"
+#include "ui/ui_profiler.h"
+#include "ui/ui_history.h"
+#include "ui/ui_mock_server.h"
 #include "ui/theme.h"
 #include "font_awesome.h"
 #include "app_state.h"
@@ -11,6 +14,7 @@
 #include "imgui_impl_opengl3.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 
 extern "C" {
 
@@ -76,6 +80,41 @@ void ui_core_cleanup(UIManager* ui) {
     }
 }
 
+/* one line under the panels with the last status message and save timing */
+static void ui_core_render_status_bar(AppState* state) {
+    const ModernGruvboxTheme* theme = theme_get_current();
+
+    ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 16.0f);
+    ImGui::AlignTextToFramePadding();
+    ImGui::TextColored(theme->fg_secondary, "%s", state->status_message);
+
+    char details[160];
+    details[0] = '\0';
+    int in_flight = app_state_count_requests_in_progress(state);
+    if (in_flight > 0) {
+        snprintf(details, sizeof(details), "%s %d in flight   ", ICON_FA_SPINNER, in_flight);
+    }
+    if (state->collections_loading) {
+        size_t length = strlen(details);
+        snprintf(details + length, sizeof(details) - length, "%s Loading collections...   ", ICON_FA_SPINNER);
+    }
+    if (persistence_worker_get_pending_count(state->persistence_worker) > 0) {
+        size_t length = strlen(details);
+        snprintf(details + length, sizeof(details) - length, "%s Saving...", ICON_FA_SAVE);
+    } else if (state->last_save_duration_ms > 0.0) {
+        size_t length = strlen(details);
+        snprintf(details + length, sizeof(details) - length, "%s Saved %d collection%s in %.1f ms",
+                 ICON_FA_SAVE, state->last_save_written, state->last_save_written == 1 ? "" : "s",
+                 state->last_save_duration_ms);
+    }
+
+    if (details[0] != '\0') {
+        float width = ImGui::CalcTextSize(details).x;
+        ImGui::SameLine(ImGui::GetWindowWidth() - width - 16.0f);
+        ImGui::TextColored(theme->fg_tertiary, "%s", details);
+    }
+}
+
 void ui_core_render(UIManager* ui, AppState* state) {
     if (!ui || !state) {
         return;
@@ -95,13 +134,16 @@ void ui_core_render(UIManager* ui, AppState* state) {
                  ImGuiWindowFlags_NoTitleBar);
 
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(16.0f, 12.0f));
-    ImGui::BeginChild("MainContent", ImVec2(0, 0), false, ImGuiWindowFlags_None);
+    float status_bar_height = ImGui::GetFrameHeightWithSpacing();
+    ImGui::BeginChild("MainContent", ImVec2(0, -status_bar_height), false, ImGuiWindowFlags_None);
 
     ui_main_tabs_render(ui, state);
 
     ImGui::EndChild(); 
     ImGui::PopStyleVar(); 
 
+    ui_core_render_status_bar(state);
+
     ImGui::End();
     ImGui::PopStyleVar(2); 
 
@@ -116,6 +158,10 @@ void ui_core_render(UIManager* ui, AppState* state) {
     if (state->show_cookie_manager) {
         ui_dialogs_render_cookie_manager(ui, state);
     }
+
+    ui_history_render(state);
+    ui_mock_server_render(state);
+    ui_profiler_render(state);
 }
 
 void ui_core_update_from_state(UIManager* ui, const AppState* state) {
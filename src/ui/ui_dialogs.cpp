@@ -62,7 +62,7 @@ void ui_dialogs_render_save_dialog(UIManager* ui, AppState* state) {
         ImGui::SameLine();
         ImGui::TextColored(theme->fg_secondary, "%d", state->current_request.headers.count);
 
-        size_t body_len = strlen(state->body_buffer);
+        size_t body_len = state->body_buffer.length;
         ImGui::TextColored(theme->accent_secondary, "[BODY]:");
         ImGui::SameLine();
         if (body_len > 0) {
@@ -0,0 +1,450 @@
+/*
+ * renders binary data as a virtualized hex dump with an ascii column
+ * only visible rows are formatted, large bodies are shown through a sliding
+ * window so the float scroll position stays exact, handles mouse selection,
+ * copy and goto offset
+ */
+
+#include "ui/ui_hex_view.h"
+#include "ui/theme.h"
+#include "font_awesome.h"
+#include "imgui.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+extern "C" {
+
+/* column layout in characters: "<offset>  xx xx xx xx xx xx xx xx  xx ... xx |ascii...........|" */
+#define HEX_VIEW_GAP_AFTER_OFFSET 2
+#define HEX_VIEW_MAX_COPY_BYTES (16 * 1024 * 1024)
+
+static int hex_view_offset_digits(size_t size) {
+    int digits = 8;
+    while (digits < (int)(sizeof(size_t) * 2) && (size >> (digits * 4)) != 0) {
+        digits++;
+    }
+    return digits;
+}
+
+static int hex_view_hex_column(int offset_digits, int byte_index) {
+    return offset_digits + HEX_VIEW_GAP_AFTER_OFFSET + byte_index * 3 + (byte_index >= 8 ? 1 : 0);
+}
+
+static int hex_view_ascii_column(int offset_digits, int byte_index) {
+    return hex_view_hex_column(offset_digits, HEX_VIEW_BYTES_PER_ROW) + 1 + byte_index;
+}
+
+/* maps a character column to the byte it belongs to, -1 if it is not over a byte */
+static int hex_view_byte_at_column(int offset_digits, float column) {
+    for (int i = 0; i < HEX_VIEW_BYTES_PER_ROW; i++) {
+        float hex_start = (float)hex_view_hex_column(offset_digits, i);
+        if (column >= hex_start && column < hex_start + 3.0f) {
+            return i;
+        }
+        float ascii_start = (float)hex_view_ascii_column(offset_digits, i);
+        if (column >= ascii_start && column < ascii_start + 1.0f) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void hex_view_selection_range(const HexViewState* view, size_t* first, size_t* last) {
+    if (view->selection_anchor <= view->selection_cursor) {
+        *first = view->selection_anchor;
+        *last = view->selection_cursor;
+    } else {
+        *first = view->selection_cursor;
+        *last = view->selection_anchor;
+    }
+}
+
+/* formats one row of the dump into line, returns its length */
+static int hex_view_format_row(char* line, size_t line_size, const unsigned char* data, size_t size,
+                               size_t row_offset, int offset_digits) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    int pos = snprintf(line, line_size, "%0*zX  ", offset_digits, row_offset);
+
+    for (int i = 0; i < HEX_VIEW_BYTES_PER_ROW; i++) {
+        if (i == 8) {
+            line[pos++] = ' ';
+        }
+        if (row_offset + i < size) {
+            unsigned char byte = data[row_offset + i];
+            line[pos++] = hex_digits[byte >> 4];
+            line[pos++] = hex_digits[byte & 0x0F];
+        } else {
+            line[pos++] = ' ';
+            line[pos++] = ' ';
+        }
+        line[pos++] = ' ';
+    }
+
+    line[pos++] = '|';
+    for (int i = 0; i < HEX_VIEW_BYTES_PER_ROW && row_offset + i < size; i++) {
+        unsigned char byte = data[row_offset + i];
+        line[pos++] = (byte >= 0x20 && byte < 0x7F) ? (char)byte : '.';
+    }
+    line[pos++] = '|';
+    line[pos] = '\0';
+    return pos;
+}
+
+/* paints a byte range of one row in both the hex and ascii columns */
+static void hex_view_paint_range(ImDrawList* draw_list, ImVec2 row_origin, float char_width, float line_height,
+                                 int offset_digits, int first, int last, ImU32 color) {
+    float hex_x0 = row_origin.x + hex_view_hex_column(offset_digits, first) * char_width;
+    float hex_x1 = row_origin.x + (hex_view_hex_column(offset_digits, last) + 2) * char_width;
+    draw_list->AddRectFilled(ImVec2(hex_x0, row_origin.y), ImVec2(hex_x1, row_origin.y + line_height), color);
+
+    float ascii_x0 = row_origin.x + hex_view_ascii_column(offset_digits, first) * char_width;
+    float ascii_x1 = row_origin.x + (hex_view_ascii_column(offset_digits, last) + 1) * char_width;
+    draw_list->AddRectFilled(ImVec2(ascii_x0, row_origin.y), ImVec2(ascii_x1, row_origin.y + line_height), color);
+}
+
+/* copies the selection either as hex or as raw text */
+static void hex_view_copy_selection(const unsigned char* data, HexViewState* view, bool as_text) {
+    size_t first, last;
+    hex_view_selection_range(view, &first, &last);
+    size_t length = last - first + 1;
+    if (length > HEX_VIEW_MAX_COPY_BYTES) {
+        length = HEX_VIEW_MAX_COPY_BYTES;
+    }
+
+    char* text = (char*)malloc(as_text ? length + 1 : length * 3 + 1);
+    if (!text) {
+        return;
+    }
+
+    if (as_text) {
+        for (size_t i = 0; i < length; i++) {
+            unsigned char byte = data[first + i];
+            text[i] = (byte >= 0x20 && byte < 0x7F) || byte == '\n' || byte == '\t' ? (char)byte : '.';
+        }
+        text[length] = '\0';
+    } else {
+        static const char hex_digits[] = "0123456789ABCDEF";
+        size_t pos = 0;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char byte = data[first + i];
+            text[pos++] = hex_digits[byte >> 4];
+            text[pos++] = hex_digits[byte & 0x0F];
+            text[pos++] = ' ';
+        }
+        text[pos > 0 ? pos - 1 : 0] = '\0';
+    }
+
+    ImGui::SetClipboardText(text);
+    free(text);
+}
+
+/* clears selection, highlight and pending scroll */
+void ui_hex_view_reset(HexViewState* view) {
+    if (!view) {
+        return;
+    }
+
+    memset(view, 0, sizeof(HexViewState));
+    view->scroll_to_offset = HEX_VIEW_NO_OFFSET;
+}
+
+/* asks the view to bring offset into view on the next frame, moving the window to it */
+void ui_hex_view_scroll_to(HexViewState* view, size_t offset) {
+    if (view) {
+        view->scroll_to_offset = offset;
+        view->page_offset = offset - offset % HEX_VIEW_PAGE_STEP;
+    }
+}
+
+/* marks a range (like a search match) that is painted independently of the selection */
+void ui_hex_view_set_highlight(HexViewState* view, size_t offset, size_t length) {
+    if (view) {
+        view->highlight_offset = offset;
+        view->highlight_length = length;
+    }
+}
+
+/* renders the visible rows of the dump */
+void ui_hex_view_render(const char* id, const unsigned char* data, size_t size,
+                        HexViewState* view, float width, float height) {
+    if (!id || !view) {
+        return;
+    }
+
+    const ModernGruvboxTheme* theme = theme_get_current();
+
+    ImGui::BeginChild(id, ImVec2(width, height), true,
+                      ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_AlwaysVerticalScrollbar);
+    ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 2.0f));
+
+    if (!data || size == 0) {
+        ImGui::TextColored(theme->fg_tertiary, "No data");
+        ImGui::PopStyleVar();
+        ImGui::EndChild();
+        return;
+    }
+
+    /* a body that shrank under the view starts over on its first page */
+    if (view->page_offset >= size || view->page_offset % HEX_VIEW_PAGE_STEP != 0) {
+        view->page_offset = 0;
+    }
+
+    int offset_digits = hex_view_offset_digits(size);
+    size_t page_bytes = size - view->page_offset < HEX_VIEW_PAGE_SIZE ? size - view->page_offset : HEX_VIEW_PAGE_SIZE;
+    int page_rows = (int)((page_bytes + HEX_VIEW_BYTES_PER_ROW - 1) / HEX_VIEW_BYTES_PER_ROW);
+    float char_width = ImGui::CalcTextSize("F").x;
+    float line_height = ImGui::GetTextLineHeight();
+    float row_height = ImGui::GetTextLineHeightWithSpacing();
+
+    bool jumped = false;
+    if (view->scroll_to_offset != HEX_VIEW_NO_OFFSET && view->scroll_to_offset >= view->page_offset &&
+        view->scroll_to_offset - view->page_offset < page_bytes) {
+        int target_row = (int)((view->scroll_to_offset - view->page_offset) / HEX_VIEW_BYTES_PER_ROW);
+        ImGui::SetScrollY(target_row * row_height - ImGui::GetWindowHeight() * 0.4f);
+        jumped = true;
+    }
+    view->scroll_to_offset = HEX_VIEW_NO_OFFSET;
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    ImU32 selection_color = ImGui::GetColorU32(theme_alpha_blend(theme->accent_primary, 0.35f));
+    ImU32 highlight_color = ImGui::GetColorU32(theme_alpha_blend(theme->warning, 0.45f));
+    ImVec4 offset_color = theme->fg_tertiary;
+
+    size_t selection_first = 0;
+    size_t selection_last = 0;
+    if (view->has_selection) {
+        hex_view_selection_range(view, &selection_first, &selection_last);
+    }
+
+    bool window_hovered = ImGui::IsWindowHovered();
+    ImVec2 mouse = ImGui::GetMousePos();
+    bool mouse_pressed = window_hovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left);
+    bool shift_held = ImGui::GetIO().KeyShift;
+
+    if (!ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        view->dragging = false;
+    }
+
+    size_t first_shown = HEX_VIEW_NO_OFFSET;
+    size_t last_shown = 0;
+    char line[160];
+    ImGuiListClipper clipper;
+    clipper.Begin(page_rows, row_height);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            size_t row_offset = view->page_offset + (size_t)row * HEX_VIEW_BYTES_PER_ROW;
+            int row_bytes = (int)((size - row_offset) < HEX_VIEW_BYTES_PER_ROW ? (size - row_offset) : HEX_VIEW_BYTES_PER_ROW);
+            ImVec2 row_origin = ImGui::GetCursorScreenPos();
+            if (first_shown == HEX_VIEW_NO_OFFSET) {
+                first_shown = row_offset;
+            }
+            last_shown = row_offset + row_bytes - 1;
+
+            /* backgrounds first so the text stays readable on top */
+            if (view->highlight_length > 0) {
+                size_t first = view->highlight_offset;
+                size_t last = view->highlight_offset + view->highlight_length - 1;
+                if (last >= row_offset && first < row_offset + row_bytes) {
+                    int from = first > row_offset ? (int)(first - row_offset) : 0;
+                    int to = last < row_offset + row_bytes - 1 ? (int)(last - row_offset) : row_bytes - 1;
+                    hex_view_paint_range(draw_list, row_origin, char_width, line_height, offset_digits, from, to, highlight_color);
+                }
+            }
+            if (view->has_selection && selection_last >= row_offset && selection_first < row_offset + row_bytes) {
+                int from = selection_first > row_offset ? (int)(selection_first - row_offset) : 0;
+                int to = selection_last < row_offset + row_bytes - 1 ? (int)(selection_last - row_offset) : row_bytes - 1;
+                hex_view_paint_range(draw_list, row_origin, char_width, line_height, offset_digits, from, to, selection_color);
+            }
+
+            hex_view_format_row(line, sizeof(line), data, size, row_offset, offset_digits);
+            ImGui::TextColored(offset_color, "%.*s", offset_digits, line);
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextUnformatted(line + offset_digits);
+
+            /* hit test against this row for clicks and drags */
+            if ((mouse_pressed || view->dragging) && mouse.y >= row_origin.y && mouse.y < row_origin.y + row_height) {
+                int index = hex_view_byte_at_column(offset_digits, (mouse.x - row_origin.x) / char_width);
+                if (index >= 0 && index < row_bytes) {
+                    size_t byte_offset = row_offset + index;
+                    if (mouse_pressed) {
+                        if (!shift_held || !view->has_selection) {
+                            view->selection_anchor = byte_offset;
+                        }
+                        view->selection_cursor = byte_offset;
+                        view->has_selection = true;
+                        view->dragging = true;
+                    } else {
+                        view->selection_cursor = byte_offset;
+                    }
+                }
+            }
+        }
+    }
+    clipper.End();
+
+    /* keep scrolling while dragging a selection past the edges, the selection follows to the rows shown */
+    float scroll_y = ImGui::GetScrollY();
+    float window_height = ImGui::GetWindowHeight();
+    bool scrolled = false;
+    if (view->dragging && first_shown != HEX_VIEW_NO_OFFSET) {
+        float window_y = ImGui::GetWindowPos().y;
+        if (mouse.y < window_y) {
+            scroll_y -= row_height;
+            view->selection_cursor = first_shown;
+            scrolled = true;
+        } else if (mouse.y > window_y + window_height) {
+            scroll_y += row_height;
+            view->selection_cursor = last_shown;
+            scrolled = true;
+        }
+    }
+
+    /* near either end of the window it slides on by half a page, moving the
+     * scroll position with it so the same rows stay on screen */
+    float step_height = (float)(HEX_VIEW_PAGE_STEP / HEX_VIEW_BYTES_PER_ROW) * row_height;
+    if (!jumped && scroll_y > ImGui::GetScrollMaxY() - window_height && view->page_offset + HEX_VIEW_PAGE_SIZE < size) {
+        view->page_offset += HEX_VIEW_PAGE_STEP;
+        scroll_y -= step_height;
+        scrolled = true;
+    } else if (!jumped && scroll_y < window_height && view->page_offset > 0) {
+        view->page_offset -= HEX_VIEW_PAGE_STEP;
+        scroll_y += step_height;
+        scrolled = true;
+    }
+    if (scrolled) {
+        ImGui::SetScrollY(scroll_y);
+    }
+
+    bool focused = ImGui::IsWindowFocused();
+    ImGui::PopStyleVar();
+    ImGui::EndChild();
+
+    ImGuiIO& io = ImGui::GetIO();
+    if (focused && view->has_selection && io.KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_C)) {
+        hex_view_copy_selection(data, view, false);
+    }
+}
+
+/* parses "0x1f", "1f h" style hex or plain decimal offsets */
+static bool hex_view_parse_offset(const char* text, size_t* offset) {
+    while (*text == ' ') text++;
+    if (*text == '\0') {
+        return false;
+    }
+
+    char* end = NULL;
+    unsigned long long value;
+    if (strncasecmp(text, "0x", 2) == 0) {
+        value = strtoull(text + 2, &end, 16);
+    } else {
+        value = strtoull(text, &end, 10);
+        if (end && (*end == 'h' || *end == 'H' || (*end >= 'a' && *end <= 'f') || (*end >= 'A' && *end <= 'F'))) {
+            value = strtoull(text, &end, 16);
+            if (*end == 'h' || *end == 'H') end++;
+        }
+    }
+
+    while (end && *end == ' ') end++;
+    if (!end || *end != '\0') {
+        return false;
+    }
+
+    *offset = (size_t)value;
+    return true;
+}
+
+/* renders goto offset input, selection info and copy buttons */
+void ui_hex_view_render_toolbar(const unsigned char* data, size_t size, HexViewState* view) {
+    if (!view) {
+        return;
+    }
+
+    const ModernGruvboxTheme* theme = theme_get_current();
+    bool go = false;
+
+    ImGui::PushItemWidth(140.0f);
+    theme_push_input_style(theme);
+    if (ImGui::InputTextWithHint("##HexGoto", "Offset (0x...)", view->goto_buffer, sizeof(view->goto_buffer),
+                                 ImGuiInputTextFlags_EnterReturnsTrue)) {
+        go = true;
+    }
+    theme_pop_input_style();
+    ImGui::PopItemWidth();
+
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button(ICON_FA_ARROW_RIGHT " Go", ImVec2(60, 0))) {
+        go = true;
+    }
+    theme_pop_button_style();
+
+    /* bodies over one page get buttons to jump a page at a time, scrolling past the window moves it too */
+    if (size > HEX_VIEW_PAGE_SIZE) {
+        size_t page = view->page_offset / HEX_VIEW_PAGE_SIZE;
+        size_t page_count = (size + HEX_VIEW_PAGE_SIZE - 1) / HEX_VIEW_PAGE_SIZE;
+
+        ImGui::SameLine();
+        theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+        ImGui::BeginDisabled(view->page_offset == 0);
+        if (ImGui::Button("Prev##HexPage", ImVec2(50, 0))) {
+            ui_hex_view_scroll_to(view, view->page_offset > HEX_VIEW_PAGE_SIZE ? view->page_offset - HEX_VIEW_PAGE_SIZE : 0);
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(view->page_offset + HEX_VIEW_PAGE_SIZE >= size);
+        if (ImGui::Button("Next##HexPage", ImVec2(50, 0))) {
+            ui_hex_view_scroll_to(view, view->page_offset + HEX_VIEW_PAGE_SIZE);
+        }
+        ImGui::EndDisabled();
+        theme_pop_button_style();
+
+        ImGui::SameLine();
+        theme_push_caption_style();
+        ImGui::TextColored(theme->fg_secondary, "Page %zu of %zu", page + 1, page_count);
+        theme_pop_text_style();
+    }
+
+    if (go) {
+        size_t offset;
+        if (hex_view_parse_offset(view->goto_buffer, &offset) && size > 0) {
+            if (offset >= size) {
+                offset = size - 1;
+            }
+            view->selection_anchor = offset;
+            view->selection_cursor = offset;
+            view->has_selection = true;
+            ui_hex_view_scroll_to(view, offset);
+        }
+    }
+
+    if (view->has_selection && data) {
+        size_t first, last;
+        hex_view_selection_range(view, &first, &last);
+
+        ImGui::SameLine();
+        theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+        if (ImGui::Button(ICON_FA_COPY " Hex", ImVec2(70, 0))) {
+            hex_view_copy_selection(data, view, false);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Copy selected bytes as hex (Ctrl+C)");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_COPY " Text", ImVec2(70, 0))) {
+            hex_view_copy_selection(data, view, true);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Copy selected bytes as text");
+        }
+        theme_pop_button_style();
+
+        ImGui::SameLine();
+        theme_push_caption_style();
+        ImGui::TextColored(theme->fg_secondary, "0x%zX-0x%zX (%zu bytes)", first, last, last - first + 1);
+        theme_pop_text_style();
+    }
+}
+
+}
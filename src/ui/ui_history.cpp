@@ -0,0 +1,566 @@
+/*
+ * history window, reads a page of rows around what is on screen from the history store
+ */
+
+#include "ui/ui_history.h"
+#include "ui/theme.h"
+#include "history_store.h"
+#include "font_awesome.h"
+#include "imgui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* rows kept around the visible ones, the list never holds more than this */
+#define HISTORY_PAGE_ROWS 128
+
+/* most entries the url filter collects */
+#define HISTORY_URL_MATCHES_MAX 10000
+
+/* response bytes drawn in the details, the rest is in the response view */
+#define HISTORY_BODY_PREVIEW 16384
+
+extern "C" {
+
+typedef struct {
+    bool valid;
+    unsigned int generation;
+    int first_row;
+    int count;
+    HistorySummary rows[HISTORY_PAGE_ROWS];
+} HistoryPage;
+
+static HistoryPage g_page;
+
+static char g_url_filter[2048] = {0};
+static bool g_filter_by_url = false;
+static uint64_t* g_url_ids = NULL;
+static int g_url_id_count = 0;
+static unsigned int g_url_generation = 0;
+static bool g_url_ids_valid = false;
+
+static char g_jump_date[16] = {0};
+static int g_scroll_to_row = -1;
+
+static char g_export_from[16] = {0};
+static char g_export_to[16] = {0};
+static char g_export_path[1024] = "history.har";
+static bool g_export_bodies = false;
+static char g_export_message[128] = {0};
+
+static uint64_t g_selected_id = 0;
+static bool g_selected_loaded = false;
+static int g_selected_result = 0;
+static HistoryEntry g_selected;
+
+static void drop_selection(void) {
+    if (g_selected_loaded) {
+        history_entry_cleanup(&g_selected);
+        g_selected_loaded = false;
+    }
+}
+
+/* opens or closes the window, nothing is read while it is closed */
+void ui_history_toggle(AppState* state) {
+    if (!state) {
+        return;
+    }
+
+    state->show_history = !state->show_history;
+    if (!state->show_history) {
+        drop_selection();
+        g_page.valid = false;
+        free(g_url_ids);
+        g_url_ids = NULL;
+        g_url_ids_valid = false;
+    }
+}
+
+static void format_bytes(double bytes, char* out, size_t out_size) {
+    if (bytes >= 1024.0 * 1024.0) {
+        snprintf(out, out_size, "%.1f MB", bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024.0) {
+        snprintf(out, out_size, "%.1f KB", bytes / 1024.0);
+    } else {
+        snprintf(out, out_size, "%.0f B", bytes);
+    }
+}
+
+static void format_time(int64_t time_ms, char* out, size_t out_size) {
+    time_t seconds = (time_t)(time_ms / 1000);
+    struct tm* local = localtime(&seconds);
+    if (!local || strftime(out, out_size, "%Y-%m-%d %H:%M:%S", local) == 0) {
+        snprintf(out, out_size, "-");
+    }
+}
+
+static ImVec4 status_color(const ModernGruvboxTheme* theme, int status_code) {
+    if (status_code >= 200 && status_code < 300) {
+        return theme->success;
+    } else if (status_code >= 300 && status_code < 500) {
+        return theme->warning;
+    } else if (status_code >= 500) {
+        return theme->error;
+    }
+    return theme->fg_tertiary;
+}
+
+static int row_count(HistoryStore* store) {
+    return g_filter_by_url ? g_url_id_count : history_store_get_count(store);
+}
+
+/* the url filter is a list of ids, collected again whenever the history changes */
+static void refresh_url_ids(HistoryStore* store, unsigned int generation) {
+    if (!g_filter_by_url || (g_url_ids_valid && g_url_generation == generation)) {
+        return;
+    }
+
+    if (!g_url_ids) {
+        g_url_ids = (uint64_t*)malloc(HISTORY_URL_MATCHES_MAX * sizeof(uint64_t));
+    }
+    g_url_id_count = g_url_ids ? history_store_find_url(store, g_url_filter, g_url_ids, HISTORY_URL_MATCHES_MAX) : 0;
+    g_url_generation = generation;
+    g_url_ids_valid = true;
+    g_page.valid = false;
+}
+
+/* makes sure rows first..last are in the page, reading a new page centered on them if not */
+static void ensure_page(HistoryStore* store, unsigned int generation, int first, int last) {
+    if (g_page.valid && g_page.generation == generation && first >= g_page.first_row &&
+        last <= g_page.first_row + g_page.count) {
+        return;
+    }
+
+    int margin = (HISTORY_PAGE_ROWS - (last - first)) / 2;
+    int start = first - (margin > 0 ? margin : 0);
+    if (start < 0) {
+        start = 0;
+    }
+
+    int count = 0;
+    if (g_filter_by_url) {
+        for (int row = start; row < g_url_id_count && count < HISTORY_PAGE_ROWS; row++) {
+            if (!history_store_read_summary(store, g_url_ids[row], &g_page.rows[count])) {
+                break;
+            }
+            count++;
+        }
+    } else {
+        count = history_store_read_summaries(store, start, HISTORY_PAGE_ROWS, g_page.rows);
+    }
+
+    g_page.valid = true;
+    g_page.generation = generation;
+    g_page.first_row = start;
+    g_page.count = count;
+}
+
+/* the first or the last millisecond of a YYYY-MM-DD day in local time */
+static bool parse_day(const char* date, bool end_of_day, int64_t* time_ms) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (sscanf(date, "%d-%d-%d", &year, &month, &day) != 3) {
+        return false;
+    }
+
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    local.tm_year = year - 1900;
+    local.tm_mon = month - 1;
+    local.tm_mday = day;
+    local.tm_hour = end_of_day ? 23 : 0;
+    local.tm_min = end_of_day ? 59 : 0;
+    local.tm_sec = end_of_day ? 59 : 0;
+    local.tm_isdst = -1;
+    time_t seconds = mktime(&local);
+    if (seconds == (time_t)-1) {
+        return false;
+    }
+
+    *time_ms = (int64_t)seconds * 1000 + (end_of_day ? 999 : 0);
+    return true;
+}
+
+static void jump_to_date(HistoryStore* store) {
+    /* the newest entry of that day, or the first one before it */
+    int64_t end_of_day = 0;
+    if (!parse_day(g_jump_date, true, &end_of_day)) {
+        return;
+    }
+
+    g_filter_by_url = false;
+    g_scroll_to_row = history_store_find_row_by_time(store, end_of_day);
+}
+
+/* exports the days asked for, or every day when both are empty. with the
+ * url filter on only the requests it found go out */
+static void start_export(AppState* state, HistoryStore* store, unsigned int generation) {
+    int64_t from_ms = 0;
+    int64_t to_ms = INT64_MAX;
+    if ((g_export_from[0] != '\0' && !parse_day(g_export_from, false, &from_ms)) ||
+        (g_export_to[0] != '\0' && !parse_day(g_export_to, true, &to_ms))) {
+        snprintf(g_export_message, sizeof(g_export_message), "Dates are YYYY-MM-DD");
+        return;
+    }
+
+    uint64_t first_id = 0;
+    uint64_t last_id = 0;
+    if (!history_store_find_time_range(store, from_ms, to_ms, &first_id, &last_id)) {
+        snprintf(g_export_message, sizeof(g_export_message), "No requests in that range");
+        return;
+    }
+
+    if (!g_filter_by_url) {
+        g_export_message[0] = '\0';
+        app_state_start_har_export(state, NULL, 0, first_id, last_id, g_export_path, g_export_bodies);
+        return;
+    }
+
+    /* the url matches come newest first, the file lists them oldest first */
+    refresh_url_ids(store, generation);
+    uint64_t* ids = g_url_id_count > 0 ? (uint64_t*)malloc((size_t)g_url_id_count * sizeof(uint64_t)) : NULL;
+    int id_count = 0;
+    for (int i = g_url_id_count - 1; ids && i >= 0; i--) {
+        if (g_url_ids[i] >= first_id && g_url_ids[i] <= last_id) {
+            ids[id_count++] = g_url_ids[i];
+        }
+    }
+
+    if (id_count == 0) {
+        snprintf(g_export_message, sizeof(g_export_message), "No requests to this URL in that range");
+    } else {
+        g_export_message[0] = '\0';
+        app_state_start_har_export(state, ids, id_count, 0, 0, g_export_path, g_export_bodies);
+    }
+    free(ids);
+}
+
+static void render_export_popup(AppState* state, HistoryStore* store, unsigned int generation,
+                                const ModernGruvboxTheme* theme) {
+    if (!ImGui::BeginPopup("##ExportHistoryHar")) {
+        return;
+    }
+
+    ImGui::TextUnformatted(g_filter_by_url ? "Requests to the filtered URL" : "All requests");
+    ImGui::SetNextItemWidth(100.0f);
+    ImGui::InputTextWithHint("##ExportFrom", "From", g_export_from, sizeof(g_export_from));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100.0f);
+    ImGui::InputTextWithHint("##ExportTo", "To", g_export_to, sizeof(g_export_to));
+    ImGui::SetNextItemWidth(320.0f);
+    ImGui::InputTextWithHint("##ExportPath", "File path", g_export_path, sizeof(g_export_path));
+    ImGui::Checkbox("Include bodies", &g_export_bodies);
+
+    if (state->har_export) {
+        HarExportProgress progress;
+        har_export_get_progress(state->har_export, &progress);
+        float fraction = progress.total > 0 ? (float)progress.written / (float)progress.total : 0.0f;
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%d / %d", progress.written, progress.total);
+        ImGui::ProgressBar(fraction, ImVec2(320.0f, 0.0f), overlay);
+
+        theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+        if (ImGui::Button("Cancel", ImVec2(80, 0))) {
+            har_export_cancel(state->har_export);
+        }
+        theme_pop_button_style();
+    } else {
+        theme_push_button_style(theme, BUTTON_TYPE_PRIMARY);
+        if (ImGui::Button("Export", ImVec2(80, 0)) && g_export_path[0] != '\0') {
+            start_export(state, store, generation);
+        }
+        theme_pop_button_style();
+        ImGui::SameLine();
+        theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+        if (ImGui::Button("Close", ImVec2(80, 0))) {
+            ImGui::CloseCurrentPopup();
+        }
+        theme_pop_button_style();
+    }
+
+    if (g_export_message[0] != '\0') {
+        ImGui::TextColored(theme->error, "%s", g_export_message);
+    }
+    ImGui::EndPopup();
+}
+
+static void render_toolbar(AppState* state, HistoryStore* store, unsigned int generation,
+                           const ModernGruvboxTheme* theme) {
+    ImGui::SetNextItemWidth(260.0f);
+    if (ImGui::InputTextWithHint("##HistoryUrl", "Exact URL", g_url_filter, sizeof(g_url_filter),
+                                 ImGuiInputTextFlags_EnterReturnsTrue)) {
+        g_filter_by_url = g_url_filter[0] != '\0';
+        g_url_ids_valid = false;
+        g_page.valid = false;
+    }
+
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button(ICON_FA_GLOBE " This request", ImVec2(120, 0))) {
+        snprintf(g_url_filter, sizeof(g_url_filter), "%s", state->url_buffer);
+        g_filter_by_url = g_url_filter[0] != '\0';
+        g_url_ids_valid = false;
+        g_page.valid = false;
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Show only requests to the URL in the request editor");
+    }
+
+    if (g_filter_by_url) {
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_TIMES " All", ImVec2(60, 0))) {
+            g_filter_by_url = false;
+            g_page.valid = false;
+        }
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100.0f);
+    if (ImGui::InputTextWithHint("##HistoryDate", "YYYY-MM-DD", g_jump_date, sizeof(g_jump_date),
+                                 ImGuiInputTextFlags_EnterReturnsTrue)) {
+        jump_to_date(store);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_CLOCK " Go", ImVec2(60, 0))) {
+        jump_to_date(store);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_DOWNLOAD " Export HAR", ImVec2(110, 0))) {
+        g_export_message[0] = '\0';
+        ImGui::OpenPopup("##ExportHistoryHar");
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Write the history, or the filtered URL's part of it, to a HAR file");
+    }
+    theme_pop_button_style();
+    render_export_popup(state, store, generation, theme);
+
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_DANGER);
+    if (ImGui::Button(ICON_FA_TRASH " Clear", ImVec2(80, 0))) {
+        ImGui::OpenPopup("Clear history?");
+    }
+    theme_pop_button_style();
+
+    if (ImGui::BeginPopupModal("Clear history?", NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::TextUnformatted("Every recorded request and response is deleted.");
+        theme_push_button_style(theme, BUTTON_TYPE_DANGER);
+        if (ImGui::Button("Clear", ImVec2(80, 0))) {
+            history_store_clear(store);
+            drop_selection();
+            g_selected_id = 0;
+            ImGui::CloseCurrentPopup();
+        }
+        theme_pop_button_style();
+        ImGui::SameLine();
+        theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+        if (ImGui::Button("Cancel", ImVec2(80, 0))) {
+            ImGui::CloseCurrentPopup();
+        }
+        theme_pop_button_style();
+        ImGui::EndPopup();
+    }
+}
+
+static void render_list(HistoryStore* store, unsigned int generation, const ModernGruvboxTheme* theme, float height) {
+    int total = row_count(store);
+
+    theme_push_caption_style();
+    if (g_filter_by_url) {
+        ImGui::TextColored(theme->fg_tertiary, "%d request%s to this URL%s", total, total == 1 ? "" : "s",
+                           total == HISTORY_URL_MATCHES_MAX ? ", newest shown" : "");
+    } else {
+        ImGui::TextColored(theme->fg_tertiary, "%d request%s", total, total == 1 ? "" : "s");
+    }
+    theme_pop_text_style();
+
+    ImGui::BeginChild("HistoryList", ImVec2(0, height), true, ImGuiWindowFlags_None);
+
+    float row_height = ImGui::GetTextLineHeightWithSpacing();
+    if (g_scroll_to_row >= 0) {
+        ImGui::SetScrollY(g_scroll_to_row * row_height);
+        g_scroll_to_row = -1;
+    }
+
+    ImGui::Columns(5, "HistoryColumns", true);
+    ImGuiListClipper clipper;
+    clipper.Begin(total, row_height);
+    while (clipper.Step()) {
+        ensure_page(store, generation, clipper.DisplayStart, clipper.DisplayEnd);
+
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            int slot = row - g_page.first_row;
+            if (slot < 0 || slot >= g_page.count) {
+                ImGui::TextColored(theme->fg_disabled, "-");
+                ImGui::NextColumn();
+                ImGui::NextColumn();
+                ImGui::NextColumn();
+                ImGui::NextColumn();
+                ImGui::NextColumn();
+                continue;
+            }
+
+            const HistorySummary* summary = &g_page.rows[slot];
+            char label[64];
+            format_time(summary->sent_at_ms, label, sizeof(label));
+
+            ImGui::PushID((int)(summary->id & 0x7fffffff));
+            if (ImGui::Selectable(label, summary->id == g_selected_id, ImGuiSelectableFlags_SpanAllColumns)) {
+                if (summary->id != g_selected_id) {
+                    drop_selection();
+                    g_selected_id = summary->id;
+                }
+            }
+            ImGui::PopID();
+            ImGui::NextColumn();
+
+            ImGui::TextColored(theme->accent_primary, "%s", summary->method);
+            ImGui::NextColumn();
+
+            if (summary->result != 0 || summary->status_code == 0) {
+                ImGui::TextColored(theme->error, "failed");
+            } else {
+                ImGui::TextColored(status_color(theme, summary->status_code), "%d", summary->status_code);
+            }
+            ImGui::NextColumn();
+
+            char size[32];
+            format_bytes((double)summary->body_size, size, sizeof(size));
+            ImGui::TextColored(theme->fg_secondary, "%.0f ms  %s", summary->duration_ms, size);
+            ImGui::NextColumn();
+
+            ImGui::TextUnformatted(summary->url);
+            ImGui::NextColumn();
+        }
+    }
+    ImGui::Columns(1);
+
+    ImGui::EndChild();
+}
+
+static void render_headers(const char* id, const HeaderList* headers, const ModernGruvboxTheme* theme) {
+    if (headers->count == 0) {
+        ImGui::TextColored(theme->fg_disabled, "No headers");
+        return;
+    }
+
+    ImGui::PushID(id);
+    for (int i = 0; i < headers->count; i++) {
+        ImGui::TextColored(theme->accent_secondary, "%s:", headers->headers[i].name);
+        ImGui::SameLine();
+        ImGui::TextUnformatted(headers->headers[i].value);
+    }
+    ImGui::PopID();
+}
+
+static void render_details(AppState* state, HistoryStore* store, const ModernGruvboxTheme* theme) {
+    if (g_selected_id == 0) {
+        theme_render_status_indicator("Select a request to see what was sent and received", STATUS_TYPE_INFO, theme);
+        return;
+    }
+
+    if (!g_selected_loaded) {
+        g_selected_result = history_store_read_entry(store, g_selected_id, &g_selected);
+        g_selected_loaded = true;
+    }
+
+    if (g_selected_result != 0) {
+        theme_render_status_indicator("This entry is no longer in the history", STATUS_TYPE_WARNING, theme);
+        return;
+    }
+
+    const HistoryEntry* entry = &g_selected;
+    char sent_at[64];
+    char size[32];
+    format_time(entry->summary.sent_at_ms, sent_at, sizeof(sent_at));
+    format_bytes((double)entry->summary.body_size, size, sizeof(size));
+
+    ImGui::TextColored(theme->accent_primary, "%s", entry->request.method);
+    ImGui::SameLine();
+    ImGui::TextWrapped("%s", entry->request.url);
+    ImGui::TextColored(status_color(theme, entry->response.status_code), "%d %s", entry->response.status_code,
+                       entry->response.status_text);
+    ImGui::SameLine();
+    ImGui::TextColored(theme->fg_secondary, "%s, %.1f ms, %s%s", sent_at, entry->summary.duration_ms, size,
+                       entry->response.is_truncated ? ", body cut" : "");
+
+    theme_push_button_style(theme, BUTTON_TYPE_PRIMARY);
+    if (ImGui::Button(ICON_FA_ARROW_RIGHT " Open response", ImVec2(140, 0))) {
+        if (app_state_open_history_entry(state, &g_selected) == 0) {
+            drop_selection();
+        }
+    }
+    theme_pop_button_style();
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button(ICON_FA_COPY " Copy URL", ImVec2(100, 0))) {
+        ImGui::SetClipboardText(entry->request.url);
+    }
+    theme_pop_button_style();
+
+    if (ImGui::CollapsingHeader("Request headers")) {
+        render_headers("RequestHeaders", &entry->request.headers, theme);
+    }
+    if (entry->request.body_size > 0 && ImGui::CollapsingHeader("Request body")) {
+        size_t shown = entry->request.body_size < HISTORY_BODY_PREVIEW ? entry->request.body_size : HISTORY_BODY_PREVIEW;
+        ImGui::TextUnformatted(entry->request.body, entry->request.body + shown);
+    }
+    if (ImGui::CollapsingHeader("Response headers")) {
+        render_headers("ResponseHeaders", &entry->response.headers, theme);
+    }
+    if (entry->response.body_size > 0 && ImGui::CollapsingHeader("Response body", ImGuiTreeNodeFlags_DefaultOpen)) {
+        size_t shown = entry->response.body_size < HISTORY_BODY_PREVIEW ? entry->response.body_size : HISTORY_BODY_PREVIEW;
+        ImGui::TextUnformatted(entry->response.body, entry->response.body + shown);
+        if (shown < entry->response.body_size) {
+            ImGui::TextColored(theme->fg_tertiary, "Open the response to see all of it");
+        }
+    }
+}
+
+/* draws the window while it is open */
+void ui_history_render(AppState* state) {
+    if (!state || !state->show_history) {
+        return;
+    }
+
+    const ModernGruvboxTheme* theme = theme_get_current();
+
+    ImGui::SetNextWindowSize(ImVec2(820, 560), ImGuiCond_FirstUseEver);
+    bool open = true;
+    if (!ImGui::Begin(ICON_FA_CLOCK " History", &open, ImGuiWindowFlags_NoCollapse)) {
+        ImGui::End();
+        if (!open) {
+            ui_history_toggle(state);
+        }
+        return;
+    }
+
+    HistoryStore* store = state->history_store;
+    if (!store) {
+        theme_render_status_indicator("History is off, the history files could not be opened", STATUS_TYPE_WARNING, theme);
+    } else if (!history_store_is_ready(store)) {
+        theme_render_status_indicator("Loading history...", STATUS_TYPE_INFO, theme);
+    } else {
+        unsigned int generation = history_store_get_generation(store);
+        refresh_url_ids(store, generation);
+
+        render_toolbar(state, store, generation, theme);
+        ImGui::Spacing();
+        render_list(store, generation, theme, ImGui::GetContentRegionAvail().y * 0.55f);
+        ImGui::Spacing();
+        ImGui::BeginChild("HistoryDetails", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+        render_details(state, store, theme);
+        ImGui::EndChild();
+    }
+
+    ImGui::End();
+
+    if (!open) {
+        ui_history_toggle(state);
+    }
+}
+
+}
@@ -0,0 +1,232 @@
+/*
+ * shows image responses as gl textures
+ * decoding happens on the image decoder's thread, this file owns the lru texture cache
+ */
+
+#include "ui/ui_image_preview.h"
+#include "ui/theme.h"
+#include "image_decoder.h"
+#include "font_awesome.h"
+#include "imgui.h"
+#include <GLFW/glfw3.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+extern "C" {
+
+typedef enum {
+    IMAGE_ENTRY_EMPTY = 0,
+    IMAGE_ENTRY_DECODING,
+    IMAGE_ENTRY_DECODED,  /* pixels are in memory, waiting for their upload */
+    IMAGE_ENTRY_READY,
+    IMAGE_ENTRY_FAILED
+} ImageEntryState;
+
+typedef struct {
+    uint64_t key;
+    ImageEntryState state;
+    GLuint texture;
+    DecodedImage image;
+    unsigned long last_used;
+} ImageCacheEntry;
+
+static ImageDecoder* g_image_decoder = NULL;
+static ImageCacheEntry g_image_cache[IMAGE_PREVIEW_CACHE_SIZE];
+static unsigned long g_image_frame = 0;
+
+static void release_cache_entry(ImageCacheEntry* entry) {
+    if (entry->texture) {
+        glDeleteTextures(1, &entry->texture);
+    }
+    decoded_image_cleanup(&entry->image);
+    memset(entry, 0, sizeof(ImageCacheEntry));
+}
+
+static ImageCacheEntry* find_cache_entry(uint64_t key) {
+    for (int i = 0; i < IMAGE_PREVIEW_CACHE_SIZE; i++) {
+        if (g_image_cache[i].state != IMAGE_ENTRY_EMPTY && g_image_cache[i].key == key) {
+            return &g_image_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/* returns a free slot, evicting the least recently drawn entry if needed */
+static ImageCacheEntry* claim_cache_entry(uint64_t key) {
+    ImageCacheEntry* victim = &g_image_cache[0];
+    for (int i = 0; i < IMAGE_PREVIEW_CACHE_SIZE; i++) {
+        if (g_image_cache[i].state == IMAGE_ENTRY_EMPTY) {
+            victim = &g_image_cache[i];
+            break;
+        }
+        if (g_image_cache[i].last_used < victim->last_used) {
+            victim = &g_image_cache[i];
+        }
+    }
+
+    release_cache_entry(victim);
+    victim->key = key;
+    victim->last_used = g_image_frame;
+    return victim;
+}
+
+/* moves finished decodes from the decoder into their cache entries */
+static void collect_decoded_images(void) {
+    DecodedImage image;
+    while (image_decoder_poll(g_image_decoder, &image)) {
+        ImageCacheEntry* entry = find_cache_entry(image.key);
+        if (!entry || entry->state != IMAGE_ENTRY_DECODING) {
+            /* evicted while it was decoding */
+            decoded_image_cleanup(&image);
+            continue;
+        }
+
+        entry->image = image;
+        entry->state = image.pixels ? IMAGE_ENTRY_DECODED : IMAGE_ENTRY_FAILED;
+    }
+}
+
+static bool upload_texture(ImageCacheEntry* entry) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    if (!texture) {
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, entry->image.width, entry->image.height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, entry->image.pixels);
+
+    entry->texture = texture;
+    entry->state = IMAGE_ENTRY_READY;
+
+    /* the gpu has its own copy now */
+    free(entry->image.pixels);
+    entry->image.pixels = NULL;
+    return true;
+}
+
+/* uploads one decoded image per frame, the one on screen first */
+static void upload_pending_textures(ImageCacheEntry* wanted) {
+    if (wanted && wanted->state == IMAGE_ENTRY_DECODED) {
+        upload_texture(wanted);
+        return;
+    }
+
+    for (int i = 0; i < IMAGE_PREVIEW_CACHE_SIZE; i++) {
+        if (g_image_cache[i].state == IMAGE_ENTRY_DECODED) {
+            upload_texture(&g_image_cache[i]);
+            return;
+        }
+    }
+}
+
+/* draws the image scaled to fit the available space, never enlarged past 1:1 */
+static void render_image_entry(const ImageCacheEntry* entry, const ModernGruvboxTheme* theme) {
+    ImGui::TextColored(theme->fg_secondary, "%d x %d", entry->image.source_width, entry->image.source_height);
+    if (entry->image.width != entry->image.source_width || entry->image.height != entry->image.source_height) {
+        ImGui::SameLine();
+        theme_push_caption_style();
+        ImGui::TextColored(theme->fg_tertiary, "(preview scaled to %d x %d)", entry->image.width, entry->image.height);
+        theme_pop_text_style();
+    }
+
+    ImVec2 available = ImGui::GetContentRegionAvail();
+    float scale = 1.0f;
+    if (entry->image.width > 0 && entry->image.height > 0) {
+        float scale_x = available.x / (float)entry->image.width;
+        float scale_y = available.y / (float)entry->image.height;
+        scale = scale_x < scale_y ? scale_x : scale_y;
+        if (scale > 1.0f || scale <= 0.0f) {
+            scale = 1.0f;
+        }
+    }
+
+    ImVec2 size((float)entry->image.width * scale, (float)entry->image.height * scale);
+    if (size.x < available.x) {
+        ImGui::SetCursorPosX(ImGui::GetCursorPosX() + (available.x - size.x) * 0.5f);
+    }
+    ImGui::Image((ImTextureID)(intptr_t)entry->texture, size);
+}
+
+/* draws the preview for key inside a child window */
+void ui_image_preview_render(const char* id, uint64_t key, const char* data, size_t size,
+                             float width, float height) {
+    const ModernGruvboxTheme* theme = theme_get_current();
+    g_image_frame++;
+
+    if (!g_image_decoder) {
+        g_image_decoder = image_decoder_create(IMAGE_DECODER_DEFAULT_MAX_DIMENSION);
+    }
+
+    ImGui::BeginChild(id, ImVec2(width, height), true, ImGuiWindowFlags_HorizontalScrollbar);
+
+    if (!g_image_decoder) {
+        theme_render_status_indicator("Image decoder unavailable", STATUS_TYPE_ERROR, theme);
+        ImGui::EndChild();
+        return;
+    }
+
+    collect_decoded_images();
+
+    ImageCacheEntry* entry = find_cache_entry(key);
+    bool needs_submit = false;
+    if (!entry) {
+        entry = claim_cache_entry(key);
+        entry->state = IMAGE_ENTRY_DECODING;
+        needs_submit = true;
+    } else if (entry->state == IMAGE_ENTRY_DECODING && !image_decoder_is_pending(g_image_decoder, key)) {
+        /* a newer submission replaced this one in the queue before it started */
+        needs_submit = true;
+    }
+
+    if (needs_submit && image_decoder_submit(g_image_decoder, key, data, size) != 0) {
+        entry->state = IMAGE_ENTRY_FAILED;
+        snprintf(entry->image.error, sizeof(entry->image.error), "Could not queue image for decoding");
+    }
+    entry->last_used = g_image_frame;
+
+    upload_pending_textures(entry);
+
+    switch (entry->state) {
+        case IMAGE_ENTRY_READY:
+            render_image_entry(entry, theme);
+            break;
+        case IMAGE_ENTRY_FAILED:
+            theme_render_status_indicator(entry->image.error[0] ? entry->image.error : "Failed to decode image",
+                                          STATUS_TYPE_ERROR, theme);
+            break;
+        default:
+            ImGui::TextColored(theme->fg_secondary, ICON_FA_SPINNER " Decoding image...");
+            break;
+    }
+
+    ImGui::EndChild();
+}
+
+/* drops every texture and stops the decoder thread */
+void ui_image_preview_cleanup(void) {
+    for (int i = 0; i < IMAGE_PREVIEW_CACHE_SIZE; i++) {
+        if (g_image_cache[i].state != IMAGE_ENTRY_EMPTY) {
+            release_cache_entry(&g_image_cache[i]);
+        }
+    }
+
+    if (g_image_decoder) {
+        image_decoder_destroy(g_image_decoder);
+        g_image_decoder = NULL;
+    }
+}
+
+}
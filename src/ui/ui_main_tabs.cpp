@@ -6,11 +6,48 @@
 #include "ui/ui_response_panel.h"
 #include "font_awesome.h"
 #include "persistence.h"
+#include "profiler.h"
+#include "request_index.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 
 extern "C" {
 
+/* one line of the flattened collections tree */
+typedef enum {
+    TREE_ROW_COLLECTION = 0,
+    TREE_ROW_REQUEST,
+    TREE_ROW_EMPTY,
+    TREE_ROW_LOADING
+} TreeRowKind;
+
+typedef struct {
+    int kind;
+    int collection_index;
+    int request_index;
+} TreeRow;
+
+static TreeRow* g_tree_rows = NULL;
+static int g_tree_row_count = 0;
+static int g_tree_row_capacity = 0;
+static bool g_tree_rows_dirty = true;
+static uint64_t g_tree_layout_signature = 0;
+
+static bool* g_tree_expanded = NULL;
+static int g_tree_expanded_count = 0;
+
+static RequestIndex* g_request_index = NULL;
+static char g_tree_filter[256] = {0};
+static bool g_tree_search_dirty = true;
+static unsigned int g_tree_search_generation = 0;
+static const RequestIndexMatch* g_tree_matches = NULL;
+static int g_tree_match_count = 0;
+static double g_tree_search_ms = 0.0;
+static unsigned int g_tree_indexed_edit_generation = 0;
+
 void ui_main_tabs_render(UIManager* ui, AppState* state) {
     if (!ui || !state) {
         return;
@@ -64,6 +101,17 @@ void ui_main_tabs_render_collections_tab(UIManager* ui, AppState* state) {
 
     ImGui::SameLine();
     float button_width = 40.0f;
+    ImGui::SetCursorPosX(ImGui::GetWindowWidth() - 96.0f - 8.0f);
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button(ICON_FA_DOWNLOAD, ImVec2(40, 24))) {
+        state->show_import_dialog = true;
+    }
+    theme_pop_button_style();
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Import Collection");
+    }
+
+    ImGui::SameLine();
     ImGui::SetCursorPosX(ImGui::GetWindowWidth() - 48.0f - 8.0f);
     theme_push_button_style(theme, BUTTON_TYPE_PRIMARY);
     if (ImGui::Button(ICON_FA_PLUS, ImVec2(40, 24))) {
@@ -86,6 +134,7 @@ void ui_main_tabs_render_collections_tab(UIManager* ui, AppState* state) {
     }
 
     ui_collections_render_create_dialog(ui, state);
+    ui_collections_render_import_dialog(ui, state);
     ui_collections_render_rename_dialog(ui, state);
     ui_collections_render_request_create_dialog(ui, state);
 }
@@ -154,6 +203,127 @@ void ui_main_tabs_render_request_tab(UIManager* ui, AppState* state) {
     }
 }
 
+/* formats a byte count for the transfer list */
+static void ui_main_tabs_format_bytes(double bytes, char* out, size_t out_size) {
+    if (bytes >= 1024.0 * 1024.0) {
+        snprintf(out, out_size, "%.1f MB", bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024.0) {
+        snprintf(out, out_size, "%.1f KB", bytes / 1024.0);
+    } else {
+        snprintf(out, out_size, "%.0f B", bytes);
+    }
+}
+
+/* one row per transfer in flight with its progress and a cancel button */
+static void ui_main_tabs_render_transfers(AppState* state, const ModernGruvboxTheme* theme) {
+    if (app_state_count_requests_in_progress(state) == 0) {
+        return;
+    }
+
+    for (int i = 0; i < state->request_tab_count; i++) {
+        RequestTab* tab = &state->request_tabs[i];
+        if (!tab->request_in_progress) {
+            continue;
+        }
+
+        RequestTransferProgress progress;
+        if (request_engine_get_progress(state->request_engine, tab->transfer_id, &progress) != 0) {
+            continue;
+        }
+
+        ImGui::PushID(tab->id);
+
+        char received[32];
+        char overlay[96];
+        float fraction = 0.0f;
+        ui_main_tabs_format_bytes(progress.downloaded, received, sizeof(received));
+        if (progress.state == REQUEST_TRANSFER_QUEUED) {
+            snprintf(overlay, sizeof(overlay), "Queued");
+        } else if (progress.download_total > 0.0) {
+            char total[32];
+            ui_main_tabs_format_bytes(progress.download_total, total, sizeof(total));
+            fraction = (float)(progress.downloaded / progress.download_total);
+            snprintf(overlay, sizeof(overlay), "%s / %s  %.1f s", received, total, progress.elapsed_ms / 1000.0);
+        } else {
+            snprintf(overlay, sizeof(overlay), "%s  %.1f s", received, progress.elapsed_ms / 1000.0);
+        }
+
+        float button_width = ImGui::GetFrameHeight();
+        float title_width = ImGui::GetContentRegionAvail().x * 0.35f;
+
+        if (ImGui::Selectable(tab->title, i == state->active_request_tab, ImGuiSelectableFlags_None,
+                              ImVec2(title_width, 0))) {
+            app_state_set_active_request_tab(state, i);
+        }
+        ImGui::SameLine();
+
+        ImGui::PushStyleColor(ImGuiCol_PlotHistogram, theme->accent_primary);
+        ImGui::ProgressBar(fraction, ImVec2(-button_width - ImGui::GetStyle().ItemSpacing.x, 0), overlay);
+        ImGui::PopStyleColor();
+        ImGui::SameLine();
+
+        if (ImGui::Button(ICON_FA_TIMES, ImVec2(button_width, 0))) {
+            app_state_cancel_request(state, i);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Cancel request");
+        }
+
+        ImGui::PopID();
+    }
+
+    ImGui::Separator();
+}
+
+/* one tab per request that was sent, selecting a tab shows its response */
+static void ui_main_tabs_render_request_tabs(AppState* state, const ModernGruvboxTheme* theme) {
+    static int shown_tab_id = 0;
+
+    RequestTab* current = app_state_get_current_tab(state);
+    /* the active tab changed outside the tab bar, usually because a request was just sent */
+    bool select_active = current && current->id != shown_tab_id;
+    int close_index = -1;
+
+    if (ImGui::BeginTabBar("##RequestTabs", ImGuiTabBarFlags_FittingPolicyScroll)) {
+        for (int i = 0; i < state->request_tab_count; i++) {
+            RequestTab* tab = &state->request_tabs[i];
+
+            char label[192];
+            snprintf(label, sizeof(label), "%s%s###request_tab_%d",
+                     tab->request_in_progress ? ICON_FA_SPINNER " " : "", tab->title, tab->id);
+
+            ImGuiTabItemFlags flags = (select_active && i == state->active_request_tab) ? ImGuiTabItemFlags_SetSelected : 0;
+            bool open = true;
+
+            if (tab->request_in_progress) {
+                ImGui::PushStyleColor(ImGuiCol_Text, theme->accent_primary);
+            }
+            bool visible = ImGui::BeginTabItem(label, state->request_tab_count > 1 ? &open : NULL, flags);
+            if (tab->request_in_progress) {
+                ImGui::PopStyleColor();
+            }
+
+            if (visible) {
+                if (!select_active && i != state->active_request_tab) {
+                    app_state_set_active_request_tab(state, i);
+                }
+                ImGui::EndTabItem();
+            }
+            if (!open) {
+                close_index = i;
+            }
+        }
+        ImGui::EndTabBar();
+    }
+
+    if (close_index >= 0) {
+        app_state_close_request_tab(state, close_index);
+    }
+
+    current = app_state_get_current_tab(state);
+    shown_tab_id = current ? current->id : 0;
+}
+
 void ui_main_tabs_render_response_tab(UIManager* ui, AppState* state) {
     if (!ui || !state) {
         return;
@@ -165,9 +335,23 @@ void ui_main_tabs_render_response_tab(UIManager* ui, AppState* state) {
     ImGui::Text(ICON_FA_DOWNLOAD " Response Details");
     ImGui::PopStyleColor();
     ImGui::Separator();
+
+    ui_main_tabs_render_request_tabs(state, theme);
+    ui_main_tabs_render_transfers(state, theme);
     ImGui::Spacing();
 
-    if (state->current_response.status_code == 0 && !state->request_in_progress) {
+    const Response* response = app_state_get_current_response(state);
+    bool in_progress = app_state_is_request_in_progress(state);
+
+    if (in_progress && response && response->status_code == 0) {
+
+        theme_render_status_indicator("Waiting for response...", STATUS_TYPE_LOADING, theme);
+
+    } else if (response && response->status_code == 0 && response->status_text[0] != '\0') {
+
+        theme_render_status_indicator(response->status_text, STATUS_TYPE_ERROR, theme);
+
+    } else if (!response || response->status_code == 0) {
 
         ImVec2 window_size = ImGui::GetContentRegionAvail();
 
@@ -313,16 +497,255 @@ void ui_collections_render_empty_state(UIManager* ui, AppState* state, const Mod
     theme_pop_button_style();
 }
 
-void ui_collections_render_tree_view(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme) {
+/* frees the tree rows and the search index */
+void ui_main_tabs_cleanup(void) {
+    free(g_tree_rows);
+    g_tree_rows = NULL;
+    g_tree_row_count = 0;
+    g_tree_row_capacity = 0;
+    g_tree_rows_dirty = true;
+
+    free(g_tree_expanded);
+    g_tree_expanded = NULL;
+    g_tree_expanded_count = 0;
+
+    request_index_destroy(g_request_index);
+    g_request_index = NULL;
+    g_tree_matches = NULL;
+    g_tree_match_count = 0;
+    g_tree_search_dirty = true;
+}
 
-    ImGui::BeginChild("CollectionsTreeView", ImVec2(0, 0), false, ImGuiWindowFlags_None);
+/* tracks collection layout changes, the rows only store indices so renames do not matter */
+static uint64_t ui_collections_layout_signature(const CollectionManager* manager) {
+    uint64_t hash = 1469598103934665603ULL;
+    hash = (hash ^ (uint64_t)manager->count) * 1099511628211ULL;
+    for (int i = 0; i < manager->count; i++) {
+        hash = (hash ^ (uint64_t)(uintptr_t)manager->collections[i].requests) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)manager->collections[i].request_count) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)manager->collections[i].loaded) * 1099511628211ULL;
+    }
+    return hash;
+}
 
-    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 4.0f);
+static bool ui_collections_push_row(int kind, int collection_index, int request_index) {
+    if (g_tree_row_count >= g_tree_row_capacity) {
+        int capacity = g_tree_row_capacity > 0 ? g_tree_row_capacity * 2 : 256;
+        TreeRow* rows = (TreeRow*)realloc(g_tree_rows, (size_t)capacity * sizeof(TreeRow));
+        if (!rows) {
+            return false;
+        }
+        g_tree_rows = rows;
+        g_tree_row_capacity = capacity;
+    }
+
+    TreeRow* row = &g_tree_rows[g_tree_row_count++];
+    row->kind = kind;
+    row->collection_index = collection_index;
+    row->request_index = request_index;
+    return true;
+}
+
+static bool ui_collections_is_expanded(int collection_index) {
+    return collection_index < g_tree_expanded_count && g_tree_expanded[collection_index];
+}
+
+static void ui_collections_set_expanded(int collection_index, bool expanded) {
+    if (collection_index >= g_tree_expanded_count) {
+        int count = collection_index + 16;
+        bool* grown = (bool*)realloc(g_tree_expanded, (size_t)count * sizeof(bool));
+        if (!grown) {
+            return;
+        }
+        memset(grown + g_tree_expanded_count, 0, (size_t)(count - g_tree_expanded_count) * sizeof(bool));
+        g_tree_expanded = grown;
+        g_tree_expanded_count = count;
+    }
+    g_tree_expanded[collection_index] = expanded;
+    g_tree_rows_dirty = true;
+}
+
+/* ImGui::GetTime only moves between frames, the search is timed inside one */
+static double tree_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
 
+/* brings the index up to date and searches again if the query or any request changed */
+static void ui_collections_update_search(AppState* state) {
     CollectionManager* manager = state->collection_manager;
 
+    if (!g_request_index) {
+        g_request_index = request_index_create();
+        if (!g_request_index) {
+            return;
+        }
+    }
+
+    request_index_sync(g_request_index, manager);
+    /* the request being edited is written straight into its collection, so re-read it once
+     * a method or url edit has been synced into it. renames go through the collection's
+     * generation and are picked up by the sync above */
+    unsigned int edit_generation =
+        state->synced_generation[SYNC_FIELD_METHOD] + state->synced_generation[SYNC_FIELD_URL];
+    if (edit_generation != g_tree_indexed_edit_generation) {
+        if (manager->active_collection_index >= 0 && manager->active_request_index >= 0) {
+            request_index_refresh_request(g_request_index, manager, manager->active_collection_index,
+                                          manager->active_request_index);
+        }
+        g_tree_indexed_edit_generation = edit_generation;
+    }
+
+    unsigned int generation = request_index_get_generation(g_request_index);
+    if (!g_tree_search_dirty && generation == g_tree_search_generation) {
+        return;
+    }
+
+    double started = tree_now_ms();
+    const RequestIndexMatch* matches = NULL;
+    int count = request_index_search(g_request_index, g_tree_filter, &matches);
+    g_tree_search_ms = tree_now_ms() - started;
+
+    g_tree_matches = matches;
+    g_tree_match_count = count > 0 ? count : 0;
+    g_tree_search_generation = generation;
+    g_tree_search_dirty = false;
+    g_tree_rows_dirty = true;
+}
+
+/* flattens the tree into the rows that would be visible if the list were endless */
+static void ui_collections_build_rows(CollectionManager* manager) {
+    g_tree_row_count = 0;
+
+    if (g_tree_filter[0]) {
+        /* matches come in collection order, every collection with a match is shown open */
+        int m = 0;
+        while (m < g_tree_match_count) {
+            int collection_index = g_tree_matches[m].collection_index;
+            if (!ui_collections_push_row(TREE_ROW_COLLECTION, collection_index, -1)) {
+                return;
+            }
+            while (m < g_tree_match_count && g_tree_matches[m].collection_index == collection_index) {
+                if (!ui_collections_push_row(TREE_ROW_REQUEST, collection_index, g_tree_matches[m].request_index)) {
+                    return;
+                }
+                m++;
+            }
+        }
+        return;
+    }
+
     for (int i = 0; i < manager->count; i++) {
-        ui_collections_render_collection_node(ui, state, theme, i);
+        if (!ui_collections_push_row(TREE_ROW_COLLECTION, i, -1)) {
+            return;
+        }
+        if (!ui_collections_is_expanded(i)) {
+            continue;
+        }
+        if (!manager->collections[i].loaded) {
+            ui_collections_push_row(TREE_ROW_LOADING, i, -1);
+            continue;
+        }
+        if (manager->collections[i].request_count == 0) {
+            ui_collections_push_row(TREE_ROW_EMPTY, i, -1);
+            continue;
+        }
+        for (int j = 0; j < manager->collections[i].request_count; j++) {
+            if (!ui_collections_push_row(TREE_ROW_REQUEST, i, j)) {
+                return;
+            }
+        }
+    }
+}
+
+static void ui_collections_render_search_box(AppState* state, const ModernGruvboxTheme* theme) {
+    bool filtering = g_tree_filter[0] != '\0';
+
+    ImGui::SetNextItemWidth(filtering ? -ImGui::GetFrameHeight() - ImGui::GetStyle().ItemSpacing.x : -1.0f);
+    theme_push_input_style(theme);
+    if (ImGui::InputTextWithHint("##CollectionsSearch", "Search requests...",
+                                 g_tree_filter, sizeof(g_tree_filter))) {
+        g_tree_search_dirty = true;
+        g_tree_rows_dirty = true;
+    }
+    theme_pop_input_style();
+
+    if (filtering) {
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_TIMES, ImVec2(ImGui::GetFrameHeight(), ImGui::GetFrameHeight()))) {
+            g_tree_filter[0] = '\0';
+            g_tree_rows_dirty = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Clear search");
+        }
+
+        ImGui::TextColored(theme->fg_tertiary, "%d of %d requests (%.1f ms)", g_tree_match_count,
+                           collection_manager_get_total_requests(state->collection_manager), g_tree_search_ms);
+    }
+}
+
+void ui_collections_render_tree_view(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme) {
+    PROFILE_SCOPE("collections_tree");
+
+    CollectionManager* manager = state->collection_manager;
+
+    ui_collections_render_search_box(state, theme);
+
+    if (g_tree_filter[0]) {
+        ui_collections_update_search(state);
+    }
+
+    uint64_t signature = ui_collections_layout_signature(manager);
+    if (signature != g_tree_layout_signature) {
+        g_tree_layout_signature = signature;
+        g_tree_rows_dirty = true;
+    }
+    if (g_tree_rows_dirty) {
+        ui_collections_build_rows(manager);
+        g_tree_rows_dirty = false;
+    }
+
+    ImGui::BeginChild("CollectionsTreeView", ImVec2(0, 0), false, ImGuiWindowFlags_None);
+
+    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 4.0f);
+
+    if (g_tree_filter[0] && g_tree_row_count == 0) {
+        ImGui::TextColored(theme->fg_disabled, ICON_FA_FILE " No requests match");
+    }
+
+    /* only the rows in view are submitted, so a huge collection costs what a small one does */
+    ImGuiListClipper clipper;
+    clipper.Begin(g_tree_row_count);
+    while (clipper.Step()) {
+        for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+            const TreeRow* row = &g_tree_rows[r];
+            switch (row->kind) {
+                case TREE_ROW_COLLECTION:
+                    ui_collections_render_collection_node(ui, state, theme, row->collection_index);
+                    break;
+                case TREE_ROW_REQUEST:
+                    ImGui::PushID(row->collection_index);
+                    ImGui::Indent();
+                    ui_collections_render_request_node(ui, state, theme, row->collection_index, row->request_index);
+                    ImGui::Unindent();
+                    ImGui::PopID();
+                    break;
+                case TREE_ROW_LOADING:
+                    ImGui::Indent();
+                    ImGui::TextColored(theme->fg_disabled, ICON_FA_SPINNER " Loading requests...");
+                    ImGui::Unindent();
+                    break;
+                default:
+                    ImGui::Indent();
+                    ImGui::PushStyleColor(ImGuiCol_Text, theme->fg_disabled);
+                    ImGui::Text(ICON_FA_FILE " No requests in this collection");
+                    ImGui::PopStyleColor();
+                    ImGui::Unindent();
+                    break;
+            }
+        }
     }
 
     ImGui::EndChild();
@@ -339,7 +762,7 @@ void ui_collections_render_collection_node(UIManager* ui, AppState* state, const
     ImGui::PushID(collection_index);
 
     bool is_active_collection = (manager->active_collection_index == collection_index);
-    bool is_expanded = false;
+    bool filtering = g_tree_filter[0] != '\0';
 
     if (is_active_collection) {
         ImGui::PushStyleColor(ImGuiCol_Header, theme_alpha_blend(theme->accent_primary, 0.3f));
@@ -348,23 +771,36 @@ void ui_collections_render_collection_node(UIManager* ui, AppState* state, const
     }
 
     char collection_label[512];
-    snprintf(collection_label, sizeof(collection_label), "%s %s (%d)", 
-             ICON_FA_FOLDER, collection->name, collection->request_count);
+    if (collection->loaded) {
+        snprintf(collection_label, sizeof(collection_label), "%s %s (%d)", 
+                 ICON_FA_FOLDER, collection->name, collection->request_count);
+    } else {
+        snprintf(collection_label, sizeof(collection_label), "%s %s %s",
+                 ICON_FA_FOLDER, collection->name, ICON_FA_SPINNER);
+    }
 
-    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
-    if (collection->request_count == 0) {
+    /* open state lives in the row list, imgui only draws the arrow */
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick |
+                               ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    if (collection->loaded && collection->request_count == 0) {
         flags |= ImGuiTreeNodeFlags_Leaf;
     }
 
-    is_expanded = ImGui::TreeNodeEx(collection_label, flags);
+    bool was_expanded = filtering || ui_collections_is_expanded(collection_index);
+    ImGui::SetNextItemOpen(was_expanded, ImGuiCond_Always);
+    bool is_expanded = ImGui::TreeNodeEx("##collection", flags, "%s", collection_label);
+    if (is_expanded != was_expanded && !filtering) {
+        ui_collections_set_expanded(collection_index, is_expanded);
+        /* still a placeholder, read this one before the rest of the queue */
+        if (is_expanded) {
+            app_state_request_collection_load(state, collection_index);
+        }
+    }
 
     if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) {
-        printf("DEBUG: ui_collections_render_collection_node - collection clicked: index=%d, name='%s'\n",
-               collection_index, collection->name);
         app_state_set_active_collection(state, collection_index);
 
         app_state_set_active_tab(state, TAB_REQUEST);
-        printf("DEBUG: ui_collections_render_collection_node - collection selection completed\n");
     }
 
     if (ImGui::BeginPopupContextItem()) {
@@ -393,22 +829,6 @@ void ui_collections_render_collection_node(UIManager* ui, AppState* state, const
         ImGui::PopStyleColor(3);
     }
 
-    if (is_expanded) {
-        for (int j = 0; j < collection->request_count; j++) {
-            ui_collections_render_request_node(ui, state, theme, collection_index, j);
-        }
-
-        if (collection->request_count == 0) {
-            ImGui::Indent();
-            ImGui::PushStyleColor(ImGuiCol_Text, theme->fg_disabled);
-            ImGui::Text(ICON_FA_FILE " No requests in this collection");
-            ImGui::PopStyleColor();
-            ImGui::Unindent();
-        }
-
-        ImGui::TreePop();
-    }
-
     ImGui::PopID();
 }
 
@@ -561,6 +981,117 @@ void ui_collections_render_create_dialog(UIManager* ui, AppState* state) {
     }
 }
 
+/* the import runs on its own thread, the dialog stays open with its progress
+ * until it finished or was cancelled */
+void ui_collections_render_import_dialog(UIManager* ui, AppState* state) {
+    if (!state->show_import_dialog && !ImGui::IsPopupOpen("Import Collection")) {
+        return;
+    }
+
+    const ModernGruvboxTheme* theme = theme_get_current();
+
+    ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+    ImGui::SetNextWindowSize(ImVec2(480, 230), ImGuiCond_Always);
+
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(20, 20));
+
+    if (ImGui::BeginPopupModal("Import Collection", NULL, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoTitleBar)) {
+
+        ImGui::PushStyleColor(ImGuiCol_Text, theme->accent_primary);
+        ImGui::Text(ICON_FA_DOWNLOAD " Import Collection");
+        ImGui::PopStyleColor();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        bool running = state->importer != NULL;
+
+        ImGui::Text("Postman, Insomnia, HAR or TinyRequest file:");
+        ImGui::SetNextItemWidth(-1.0f);
+        if (running) {
+            ImGui::BeginDisabled();
+        }
+        bool submitted = ImGui::InputText("##import_path", state->last_import_path, sizeof(state->last_import_path),
+                                          ImGuiInputTextFlags_EnterReturnsTrue);
+        if (running) {
+            ImGui::EndDisabled();
+        }
+
+        ImGui::Spacing();
+
+        if (running) {
+            CollectionImportProgress progress;
+            collection_importer_get_progress(state->importer, &progress);
+
+            char done[32];
+            char total[32];
+            char overlay[96];
+            ui_main_tabs_format_bytes((double)progress.bytes_done, done, sizeof(done));
+            ui_main_tabs_format_bytes((double)progress.bytes_total, total, sizeof(total));
+            snprintf(overlay, sizeof(overlay), "%s / %s  %d requests", done, total, progress.request_count);
+            float fraction = progress.bytes_total > 0 ? (float)progress.bytes_done / (float)progress.bytes_total : 0.0f;
+
+            ImGui::PushStyleColor(ImGuiCol_PlotHistogram, theme->accent_primary);
+            ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0), overlay);
+            ImGui::PopStyleColor();
+        } else if (state->import_message[0] != '\0') {
+            ImGui::PushStyleColor(ImGuiCol_Text, theme->error);
+            ImGui::TextWrapped("%s", state->import_message);
+            ImGui::PopStyleColor();
+        }
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        if (running) {
+            theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+            if (ImGui::Button(ICON_FA_TIMES " Cancel", ImVec2(80, 0))) {
+                app_state_cancel_import(state);
+            }
+            theme_pop_button_style();
+        } else {
+            bool can_import = state->last_import_path[0] != '\0';
+
+            if (!can_import) {
+                ImGui::BeginDisabled();
+            }
+
+            theme_push_button_style(theme, BUTTON_TYPE_SUCCESS);
+            if (ImGui::Button(ICON_FA_CHECK " Import", ImVec2(80, 0)) || (submitted && can_import)) {
+                app_state_start_import(state, state->last_import_path);
+            }
+            theme_pop_button_style();
+
+            if (!can_import) {
+                ImGui::EndDisabled();
+            }
+
+            ImGui::SameLine();
+
+            theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+            if (ImGui::Button(ICON_FA_TIMES " Close", ImVec2(80, 0))) {
+                state->show_import_dialog = false;
+                state->import_message[0] = '\0';
+            }
+            theme_pop_button_style();
+        }
+
+        /* a finished import closes the dialog from app_state_poll_import */
+        if (!state->show_import_dialog) {
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+
+    ImGui::PopStyleVar();
+
+    if (state->show_import_dialog && !ImGui::IsPopupOpen("Import Collection")) {
+        ImGui::OpenPopup("Import Collection");
+    }
+}
+
 void ui_collections_render_rename_dialog(UIManager* ui, AppState* state) {
     if (!state->show_collection_rename_dialog) {
         return;
@@ -724,7 +1255,8 @@ void ui_collections_render_collection_context_menu(UIManager* ui, AppState* stat
         state->collection_name_buffer[sizeof(state->collection_name_buffer) - 1] = '\0';
     }
 
-    if (ImGui::MenuItem(ICON_FA_COPY " Duplicate")) {
+    if (ImGui::MenuItem(ICON_FA_COPY " Duplicate") &&
+        app_state_ensure_collection_loaded(state, collection_index) == 0) {
         collection_manager_duplicate_collection(manager, collection_index);
         app_state_save_all_collections(state);
     }
@@ -791,7 +1323,7 @@ bool ui_collections_handle_rename_collection(UIManager* ui, AppState* state, int
     }
 
     Collection* collection = collection_manager_get_collection(state->collection_manager, collection_index);
-    if (!collection) {
+    if (!collection || app_state_ensure_collection_loaded(state, collection_index) != 0) {
         return false;
     }
 
@@ -799,11 +1331,12 @@ bool ui_collections_handle_rename_collection(UIManager* ui, AppState* state, int
         return false;
     }
 
+    unsigned int base_generation = collection->generation;
     if (collection_set_name(collection, state->collection_name_buffer) != 0) {
         return false;
     }
 
-    app_state_save_all_collections(state);
+    app_state_journal_set_collection(state, collection, base_generation);
 
     snprintf(state->status_message, sizeof(state->status_message), 
              "Collection renamed to '%s'", state->collection_name_buffer);
@@ -832,7 +1365,7 @@ bool ui_collections_handle_delete_collection(UIManager* ui, AppState* state, int
         return false;
     }
 
-    persistence_delete_collection_file(collection_id);
+    app_state_delete_collection_file(state, collection_id);
 
     app_state_save_all_collections(state);
 
@@ -848,7 +1381,7 @@ bool ui_collections_handle_create_request(UIManager* ui, AppState* state, int co
     }
 
     Collection* collection = collection_manager_get_collection(state->collection_manager, collection_index);
-    if (!collection) {
+    if (!collection || app_state_ensure_collection_loaded(state, collection_index) != 0) {
         return false;
     }
 
@@ -857,6 +1390,7 @@ bool ui_collections_handle_create_request(UIManager* ui, AppState* state, int co
     strcpy(new_request.method, "GET");
     strcpy(new_request.url, "https://");
 
+    unsigned int base_generation = collection->generation;
     int request_index = collection_add_request(collection, &new_request, state->request_name_buffer);
     request_cleanup(&new_request);
 
@@ -864,6 +1398,9 @@ bool ui_collections_handle_create_request(UIManager* ui, AppState* state, int co
         return false;
     }
 
+    /* journaled before switching, which syncs and journals the request that was active */
+    app_state_journal_put_request(state, collection, base_generation, request_index);
+
     app_state_set_active_collection(state, collection_index);
     app_state_set_active_request(state, request_index);
 
@@ -871,8 +1408,6 @@ bool ui_collections_handle_create_request(UIManager* ui, AppState* state, int co
 
     app_state_set_active_tab(state, TAB_REQUEST);
 
-    app_state_save_all_collections(state);
-
     snprintf(state->status_message, sizeof(state->status_message), 
              "Request '%s' created", state->request_name_buffer);
 
@@ -898,10 +1433,13 @@ bool ui_collections_handle_delete_request(UIManager* ui, AppState* state, int co
         strcpy(name_copy, "Unnamed Request");
     }
 
+    unsigned int base_generation = collection->generation;
     if (collection_remove_request(collection, request_index) != 0) {
         return false;
     }
 
+    app_state_journal_remove_request(state, collection, base_generation, request_index);
+
     CollectionManager* manager = state->collection_manager;
     if (manager->active_collection_index == collection_index && 
         manager->active_request_index == request_index) {
@@ -915,8 +1453,6 @@ bool ui_collections_handle_delete_request(UIManager* ui, AppState* state, int co
         app_state_set_active_request(state, manager->active_request_index - 1);
     }
 
-    app_state_save_all_collections(state);
-
     snprintf(state->status_message, sizeof(state->status_message), 
              "Request '%s' deleted", name_copy);
 
@@ -933,16 +1469,17 @@ bool ui_collections_handle_duplicate_request(UIManager* ui, AppState* state, int
         return false;
     }
 
+    unsigned int base_generation = collection->generation;
     int new_index = collection_duplicate_request(collection, request_index);
     if (new_index < 0) {
         return false;
     }
 
+    app_state_journal_put_request(state, collection, base_generation, new_index);
+
     app_state_set_active_collection(state, collection_index);
     app_state_set_active_request(state, new_index);
 
-    app_state_save_all_collections(state);
-
     const char* request_name = collection_get_request_name(collection, request_index);
     snprintf(state->status_message, sizeof(state->status_message), 
              "Request '%s' duplicated", request_name ? request_name : "Unnamed Request");
@@ -963,6 +1500,11 @@ bool ui_collections_handle_move_request(UIManager* ui, AppState* state, int sour
         return false;
     }
 
+    /* moving into a placeholder would be lost when its file replaces it */
+    if (app_state_ensure_collection_loaded(state, target_collection) != 0) {
+        return false;
+    }
+
     Request* request_to_move = collection_get_request(source_col, request_index);
     const char* request_name = collection_get_request_name(source_col, request_index);
 
@@ -970,6 +1512,9 @@ bool ui_collections_handle_move_request(UIManager* ui, AppState* state, int sour
         return false;
     }
 
+    unsigned int target_base = target_col->generation;
+    unsigned int source_base = source_col->generation;
+
     int new_index = collection_add_request(target_col, request_to_move, request_name);
     if (new_index < 0) {
         return false;
@@ -981,6 +1526,10 @@ bool ui_collections_handle_move_request(UIManager* ui, AppState* state, int sour
         return false;
     }
 
+    /* the copy is on disk before the original goes */
+    app_state_journal_put_request(state, target_col, target_base, new_index);
+    app_state_journal_remove_request(state, source_col, source_base, request_index);
+
     if (manager->active_collection_index == source_collection && 
         manager->active_request_index == request_index) {
         app_state_set_active_collection(state, target_collection);
@@ -991,8 +1540,6 @@ bool ui_collections_handle_move_request(UIManager* ui, AppState* state, int sour
         app_state_set_active_request(state, manager->active_request_index - 1);
     }
 
-    app_state_save_all_collections(state);
-
     snprintf(state->status_message, sizeof(state->status_message), 
              "Request '%s' moved to '%s'", request_name, target_col->name);
 
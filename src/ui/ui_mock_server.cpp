@@ -0,0 +1,263 @@
+/*
+ * mock server window, starts and stops the server app_state holds
+ */
+
+#include "ui/ui_mock_server.h"
+#include "ui/theme.h"
+#include "font_awesome.h"
+#include "imgui.h"
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+
+static MockServerOptions g_options;
+static bool g_options_ready = false;
+static int g_collection_index = -1;
+static float g_error_percent = 0.0f;
+static int g_seed = 1;
+static char g_start_message[256] = {0};
+
+/* opens or closes the window, the server keeps running while it is closed */
+void ui_mock_server_toggle(AppState* state) {
+    if (!state) {
+        return;
+    }
+    state->show_mock_server = !state->show_mock_server;
+}
+
+static ImVec4 status_color(const ModernGruvboxTheme* theme, int status_code) {
+    if (status_code >= 200 && status_code < 300) {
+        return theme->success;
+    } else if (status_code >= 300 && status_code < 500) {
+        return theme->warning;
+    } else if (status_code >= 500) {
+        return theme->error;
+    }
+    return theme->fg_tertiary;
+}
+
+static void clamp_int(int* value, int min, int max) {
+    if (*value < min) {
+        *value = min;
+    } else if (*value > max) {
+        *value = max;
+    }
+}
+
+/* the collection combo, a placeholder still on disk is loaded once picked */
+static Collection* render_collection_picker(AppState* state) {
+    CollectionManager* manager = state->collection_manager;
+    if (g_collection_index < 0 || g_collection_index >= manager->count) {
+        g_collection_index = state->selected_collection_index >= 0 ? state->selected_collection_index : 0;
+    }
+
+    Collection* selected = collection_manager_get_collection(manager, g_collection_index);
+    ImGui::SetNextItemWidth(280.0f);
+    if (ImGui::BeginCombo("Collection", selected ? selected->name : "")) {
+        for (int i = 0; i < manager->count; i++) {
+            ImGui::PushID(i);
+            if (ImGui::Selectable(manager->collections[i].name, i == g_collection_index)) {
+                g_collection_index = i;
+                if (!manager->collections[i].loaded) {
+                    app_state_request_collection_load(state, i);
+                }
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndCombo();
+    }
+    return collection_manager_get_collection(manager, g_collection_index);
+}
+
+static void render_options(void) {
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::InputInt("Port", &g_options.port);
+    clamp_int(&g_options.port, 0, 65535);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("0 picks a free port");
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::InputInt("Threads", &g_options.threads);
+    clamp_int(&g_options.threads, 1, MOCK_SERVER_MAX_THREADS);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Requests answered at once, a kept-alive connection holds one while it is open");
+    }
+
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::InputInt("Latency ms", &g_options.latency_ms, 10, 100);
+    clamp_int(&g_options.latency_ms, 0, MOCK_SERVER_MAX_DELAY_MS);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::InputInt("Jitter ms", &g_options.jitter_ms, 10, 100);
+    clamp_int(&g_options.jitter_ms, 0, MOCK_SERVER_MAX_DELAY_MS - g_options.latency_ms);
+
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderFloat("Errors", &g_error_percent, 0.0f, 100.0f, "%.1f %%");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::InputInt("Error status", &g_options.error_status);
+    clamp_int(&g_options.error_status, 100, 599);
+
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::InputInt("Seed", &g_seed);
+    clamp_int(&g_seed, 0, 2147483647);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Runs with the same seed fail and wait the same way, request for request");
+    }
+}
+
+static void render_stopped(AppState* state, const ModernGruvboxTheme* theme) {
+    if (!state->collection_manager || state->collection_manager->count == 0) {
+        theme_render_status_indicator("Create or import a collection to serve it", STATUS_TYPE_INFO, theme);
+        return;
+    }
+
+    Collection* collection = render_collection_picker(state);
+    render_options();
+    ImGui::Spacing();
+
+    bool loaded = collection && collection->loaded;
+    ImGui::BeginDisabled(!loaded);
+    theme_push_button_style(theme, BUTTON_TYPE_PRIMARY);
+    if (ImGui::Button(ICON_FA_BOLT " Start", ImVec2(90, 0))) {
+        g_options.error_rate = g_error_percent / 100.0;
+        g_options.seed = (uint64_t)g_seed;
+        int result = app_state_start_mock_server(state, g_collection_index, &g_options);
+        snprintf(g_start_message, sizeof(g_start_message), "%s",
+                 result == MOCK_SERVER_SUCCESS ? "" : mock_server_error_string(result));
+    }
+    theme_pop_button_style();
+    ImGui::EndDisabled();
+
+    if (!loaded) {
+        ImGui::SameLine();
+        ImGui::TextColored(theme->fg_tertiary, "Loading the collection...");
+    } else if (g_start_message[0]) {
+        ImGui::SameLine();
+        ImGui::TextColored(theme->error, "%s", g_start_message);
+    }
+
+    ImGui::Spacing();
+    theme_push_caption_style();
+    ImGui::TextColored(theme->fg_tertiary, "Each request answers with the response history last recorded for its url.");
+    ImGui::TextColored(theme->fg_tertiary, "Example bodies can use {{params.id}}, {{query.name}}, {{header.name}},");
+    ImGui::TextColored(theme->fg_tertiary, "{{body}}, {{method}}, {{path}}, {{now}} and {{seq}}.");
+    theme_pop_text_style();
+}
+
+static void render_routes(MockServer* server, const ModernGruvboxTheme* theme) {
+    int count = mock_server_get_route_count(server);
+    if (count == 0) {
+        theme_render_status_indicator("The collection has no requests, every path gets a 404", STATUS_TYPE_WARNING,
+                                      theme);
+        return;
+    }
+
+    ImGui::Columns(4, "MockRoutes", true);
+    ImGui::TextColored(theme->accent_secondary, "Method");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "Path");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "Answers");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "Hits");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (int i = 0; i < count; i++) {
+        MockRouteInfo route;
+        if (!mock_server_get_route(server, i, &route)) {
+            continue;
+        }
+        ImGui::TextUnformatted(route.method);
+        ImGui::NextColumn();
+        ImGui::TextUnformatted(route.path);
+        ImGui::NextColumn();
+        if (route.has_example) {
+            ImGui::TextColored(status_color(theme, route.status_code), "%d", route.status_code);
+        } else {
+            ImGui::TextColored(theme->fg_tertiary, "200, no example");
+        }
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long)route.hits);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+static void render_running(AppState* state, const ModernGruvboxTheme* theme) {
+    MockServer* server = state->mock_server;
+    char url[96];
+    snprintf(url, sizeof(url), "http://%s:%d", g_options.host, mock_server_get_port(server));
+
+    ImGui::TextColored(theme->success, ICON_FA_CIRCLE_CHECK " Serving %s on %s", state->mock_collection_name, url);
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button(ICON_FA_COPY " Copy URL")) {
+        ImGui::SetClipboardText(url);
+    }
+    theme_pop_button_style();
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_DANGER);
+    if (ImGui::Button(ICON_FA_TIMES " Stop", ImVec2(80, 0))) {
+        app_state_stop_mock_server(state);
+        theme_pop_button_style();
+        return;
+    }
+    theme_pop_button_style();
+
+    MockServerStats stats;
+    mock_server_get_stats(server, &stats);
+    ImGui::TextColored(theme->fg_secondary, "%llu requests, %llu without a route, %llu errors injected",
+                       (unsigned long long)stats.requests, (unsigned long long)stats.unmatched,
+                       (unsigned long long)stats.errors_injected);
+    if (g_options.latency_ms > 0 || g_options.jitter_ms > 0 || g_options.error_rate > 0.0) {
+        ImGui::TextColored(theme->fg_tertiary, "Latency %d ms, jitter %d ms, %.1f %% errors as %d", g_options.latency_ms,
+                           g_options.jitter_ms, g_options.error_rate * 100.0, g_options.error_status);
+    }
+
+    ImGui::Spacing();
+    ImGui::BeginChild("MockRoutes", ImVec2(0, 0), false);
+    render_routes(server, theme);
+    ImGui::EndChild();
+}
+
+/* draws the window while it is open */
+void ui_mock_server_render(AppState* state) {
+    if (!state || !state->show_mock_server) {
+        return;
+    }
+
+    if (!g_options_ready) {
+        mock_server_options_init(&g_options);
+        g_options_ready = true;
+    }
+
+    const ModernGruvboxTheme* theme = theme_get_current();
+
+    ImGui::SetNextWindowSize(ImVec2(640, 420), ImGuiCond_FirstUseEver);
+    bool open = true;
+    if (!ImGui::Begin(ICON_FA_CUBE " Mock Server", &open, ImGuiWindowFlags_NoCollapse)) {
+        ImGui::End();
+        if (!open) {
+            ui_mock_server_toggle(state);
+        }
+        return;
+    }
+
+    if (state->mock_server) {
+        render_running(state, theme);
+    } else {
+        render_stopped(state, theme);
+    }
+
+    ImGui::End();
+
+    if (!open) {
+        ui_mock_server_toggle(state);
+    }
+}
+
+}
@@ -39,9 +39,12 @@ void ui_panels_render_headers_panel(UIManager* ui, HeaderList* headers, void* ap
 
             ImGui::BeginGroup();
 
+            /* headers are edited in place in the request, so each edit is marked for the next sync to journal and save */
             ImGui::SetNextItemWidth(120);
             theme_push_input_style(theme);
-            ImGui::InputText("##header_name", headers->headers[i].name, sizeof(headers->headers[i].name));
+            if (ImGui::InputText("##header_name", headers->headers[i].name, sizeof(headers->headers[i].name))) {
+                app_state_mark_changed(state);
+            }
             theme_pop_input_style();
 
             ImGui::SameLine();
@@ -50,14 +53,18 @@ void ui_panels_render_headers_panel(UIManager* ui, HeaderList* headers, void* ap
 
             ImGui::SetNextItemWidth(244);
             theme_push_input_style(theme);
-            ImGui::InputText("##header_value", headers->headers[i].value, sizeof(headers->headers[i].value));
+            if (ImGui::InputText("##header_value", headers->headers[i].value, sizeof(headers->headers[i].value))) {
+                app_state_mark_changed(state);
+            }
             theme_pop_input_style();
 
             ImGui::SameLine();
 
             theme_push_button_style(theme, BUTTON_TYPE_DANGER);
             if (ImGui::Button(font_awesome_icon_with_fallback(ICON_FA_XMARK, "Remove"), ImVec2(40, 28))) {
-                header_list_remove(headers, i);
+                if (header_list_remove(headers, i) == 0) {
+                    app_state_mark_changed(state);
+                }
                 theme_pop_button_style();
                 ImGui::EndGroup();
                 ImGui::PopID();
@@ -124,7 +131,7 @@ void ui_panels_render_headers_panel(UIManager* ui, HeaderList* headers, void* ap
     theme_push_button_style(theme, BUTTON_TYPE_SUCCESS);
     if (ImGui::Button(font_awesome_icon_with_fallback(ICON_FA_PLUS, "+"), ImVec2(40, 28))) {
         if (header_list_add(headers, state->header_name_buffer, state->header_value_buffer) == 0) {
-
+            app_state_mark_changed(state);
             state->header_name_buffer[0] = '\0';
             state->header_value_buffer[0] = '\0';
         }
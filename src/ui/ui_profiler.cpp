@@ -0,0 +1,191 @@
+/*
+ * profiler overlay, reads the frame ring kept by the profiler module
+ */
+
+#include "ui/ui_profiler.h"
+#include "ui/theme.h"
+#include "profiler.h"
+#include "persistence.h"
+#include "font_awesome.h"
+#include "imgui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* frame time budget drawn as the graph's minimum height, 30 fps */
+#define PROFILER_GRAPH_MIN_MS 33.3f
+
+extern "C" {
+
+static char g_export_message[512] = {0};
+static bool g_export_failed = false;
+
+/* opens or closes the overlay, recording follows its visibility */
+void ui_profiler_toggle(AppState* state) {
+    if (!state) {
+        return;
+    }
+
+    state->show_profiler = !state->show_profiler;
+    if (state->show_profiler) {
+        profiler_reset();
+    }
+    profiler_set_enabled(state->show_profiler);
+}
+
+/* saves the recorded frames as a timestamped trace in the config directory */
+static void export_trace(void) {
+    char filename[64];
+    time_t now = time(NULL);
+    strftime(filename, sizeof(filename), "trace-%Y%m%d-%H%M%S.json", localtime(&now));
+
+    char* path = NULL;
+    if (persistence_create_config_dir() == 0) {
+        path = persistence_get_config_path(filename);
+    }
+
+    if (path && profiler_export_chrome_trace(path) == 0) {
+        snprintf(g_export_message, sizeof(g_export_message), "Saved %s", path);
+        g_export_failed = false;
+    } else {
+        snprintf(g_export_message, sizeof(g_export_message), "Could not write %s", path ? path : filename);
+        g_export_failed = true;
+    }
+    free(path);
+}
+
+static void render_summary(const ModernGruvboxTheme* theme) {
+    int frame_count = profiler_get_frame_count();
+    double p50 = profiler_get_frame_percentile(0.50);
+    double p99 = profiler_get_frame_percentile(0.99);
+    double max = profiler_get_frame_percentile(1.0);
+
+    ImGui::TextColored(theme->fg_secondary, "%d frames", frame_count);
+    ImGui::SameLine();
+    ImGui::TextColored(theme->fg_primary, "p50 %.2f ms", p50);
+    ImGui::SameLine();
+    ImGui::TextColored(p99 > PROFILER_GRAPH_MIN_MS ? theme->warning : theme->fg_primary, "p99 %.2f ms", p99);
+    ImGui::SameLine();
+    ImGui::TextColored(max > PROFILER_GRAPH_MIN_MS ? theme->error : theme->fg_primary, "max %.2f ms", max);
+}
+
+static void render_frame_graph(void) {
+    static float times[PROFILER_FRAME_HISTORY];
+    int count = profiler_get_frame_times(times, PROFILER_FRAME_HISTORY);
+
+    float scale = PROFILER_GRAPH_MIN_MS;
+    for (int i = 0; i < count; i++) {
+        if (times[i] > scale) {
+            scale = times[i];
+        }
+    }
+
+    char overlay[32];
+    snprintf(overlay, sizeof(overlay), "%.1f ms", count > 0 ? times[count - 1] : 0.0f);
+    ImGui::PlotHistogram("##FrameTimes", times, count, 0, overlay, 0.0f, scale,
+                         ImVec2(ImGui::GetContentRegionAvail().x, 80.0f));
+}
+
+static void render_scope_table(const ModernGruvboxTheme* theme) {
+    ProfilerScopeStats stats[PROFILER_MAX_SCOPES];
+    int count = profiler_get_scope_stats(stats, PROFILER_MAX_SCOPES);
+    int frame_count = profiler_get_frame_count();
+
+    if (count == 0) {
+        theme_render_status_indicator("No scopes recorded yet", STATUS_TYPE_INFO, theme);
+        return;
+    }
+
+    double frame_total = 0.0;
+    for (int i = 0; i < frame_count; i++) {
+        frame_total += profiler_get_frame(i)->duration_ms;
+    }
+
+    ImGui::Columns(5, "ProfilerScopes", true);
+    ImGui::TextColored(theme->accent_secondary, "Scope");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "Calls/frame");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "Avg ms");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "Max ms");
+    ImGui::NextColumn();
+    ImGui::TextColored(theme->accent_secondary, "% of frame");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (int i = 0; i < count; i++) {
+        const ProfilerScopeStats* entry = &stats[i];
+        ImGui::TextUnformatted(entry->name);
+        ImGui::NextColumn();
+        ImGui::Text("%.2f", frame_count > 0 ? (double)entry->calls / frame_count : 0.0);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", entry->calls > 0 ? entry->total_ms / entry->calls : 0.0);
+        ImGui::NextColumn();
+        ImGui::TextColored(entry->max_ms > PROFILER_GRAPH_MIN_MS ? theme->warning : theme->fg_primary,
+                           "%.3f", entry->max_ms);
+        ImGui::NextColumn();
+        ImGui::Text("%.1f", frame_total > 0.0 ? entry->total_ms / frame_total * 100.0 : 0.0);
+        ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+}
+
+/* draws the overlay window while it is open */
+void ui_profiler_render(AppState* state) {
+    if (!state || !state->show_profiler) {
+        return;
+    }
+
+    const ModernGruvboxTheme* theme = theme_get_current();
+
+    ImGui::SetNextWindowSize(ImVec2(560, 420), ImGuiCond_FirstUseEver);
+    bool open = true;
+    if (!ImGui::Begin(ICON_FA_CHART_BAR " Profiler", &open, ImGuiWindowFlags_NoCollapse)) {
+        ImGui::End();
+        if (!open) {
+            ui_profiler_toggle(state);
+        }
+        return;
+    }
+
+    bool recording = profiler_is_enabled();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button(recording ? ICON_FA_TIMES " Pause" : ICON_FA_REFRESH " Resume", ImVec2(90, 0))) {
+        profiler_set_enabled(!recording);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_TRASH " Clear", ImVec2(80, 0))) {
+        profiler_reset();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_DOWNLOAD " Export trace", ImVec2(120, 0))) {
+        export_trace();
+    }
+    theme_pop_button_style();
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Save the recorded frames as Chrome trace JSON (chrome://tracing, Perfetto)");
+    }
+
+    if (g_export_message[0]) {
+        theme_push_caption_style();
+        ImGui::TextColored(g_export_failed ? theme->error : theme->fg_tertiary, "%s", g_export_message);
+        theme_pop_text_style();
+    }
+
+    ImGui::Spacing();
+    render_summary(theme);
+    render_frame_graph();
+    ImGui::Spacing();
+    render_scope_table(theme);
+
+    ImGui::End();
+
+    if (!open) {
+        ui_profiler_toggle(state);
+    }
+}
+
+}
@@ -2,6 +2,8 @@
 #include "ui/ui_panels.h"
 #include "ui/ui_core.h"
 #include "ui/theme.h"
+#include "ui/ui_text_input.h"
+#include "json_validator.h"
 #include "font_awesome.h"
 #include "http_client.h"
 #include <stdlib.h>
@@ -9,8 +11,19 @@
 #include <stdio.h>
 #include <cjson/cJSON.h>
 
+/* typing has to pause this long before the json body is validated again */
+#define JSON_VALIDATION_DEBOUNCE_SECONDS 0.3
+/* bytes shown on either side of a json error */
+#define JSON_ERROR_CONTEXT_BYTES 60
+
 extern "C" {
 
+static JsonValidator* g_json_validator = NULL;
+static unsigned int g_json_seen_generation = 0;
+static double g_json_last_edit_time = 0.0;
+static bool g_json_submitted = false;
+static unsigned int g_json_submitted_generation = 0;
+
 static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state);
 static void ui_request_panel_apply_authentication(AppState* state);
 
@@ -46,7 +59,7 @@ void ui_request_panel_render(UIManager* ui, AppState* state) {
     theme_push_input_style(theme);
     if (ImGui::Combo("##method", &state->selected_method_index, methods, method_count)) {
 
-        app_state_mark_ui_dirty(state);
+        app_state_mark_field_dirty(state, SYNC_FIELD_METHOD);
         app_state_set_unsaved_changes(state, true);
     }
     theme_pop_input_style();
@@ -74,7 +87,7 @@ void ui_request_panel_render(UIManager* ui, AppState* state) {
 
     if (ImGui::InputText("##url", state->url_buffer, sizeof(state->url_buffer))) {
 
-        app_state_mark_ui_dirty(state);
+        app_state_mark_field_dirty(state, SYNC_FIELD_URL);
         app_state_set_unsaved_changes(state, true);
     }
 
@@ -82,7 +95,7 @@ void ui_request_panel_render(UIManager* ui, AppState* state) {
 
     ImGui::SameLine();
 
-    bool can_send = !state->request_in_progress && url_valid;
+    bool can_send = !app_state_is_active_request_in_progress(state) && url_valid;
     if (!can_send) {
         ImGui::BeginDisabled();
     }
@@ -186,7 +199,7 @@ void ui_request_panel_render(UIManager* ui, AppState* state) {
                                         strcmp(current_method, "PUT") == 0 ||
                                         strcmp(current_method, "PATCH") == 0 ||
                                         strcmp(current_method, "DELETE") == 0);
-            if (method_supports_body && strlen(state->body_buffer) > 0) {
+            if (method_supports_body && state->body_buffer.length > 0) {
                 snprintf(tab_label, sizeof(tab_label), "%s ●", request_tab_names[i]); 
             } else {
                 strcpy(tab_label, request_tab_names[i]);
@@ -260,14 +273,12 @@ bool ui_request_panel_handle_send_request(UIManager* ui, AppState* state) {
         return false;
     }
 
-    if (state->request_in_progress) {
+    if (app_state_is_active_request_in_progress(state)) {
         return false;
     }
 
-    state->request_in_progress = true;
-    snprintf(state->status_message, sizeof(state->status_message), "Sending request...");
-
-    state->ui_state_dirty = true;
+    /* compare every field once before sending, not just the ones marked as edited */
+    app_state_mark_ui_dirty(state);
     app_state_sync_ui_to_request(state);
 
     ui_request_panel_apply_authentication(state);
@@ -284,20 +295,16 @@ bool ui_request_panel_handle_send_request(UIManager* ui, AppState* state) {
         }
     }
 
-    if (strlen(state->body_buffer) > 0) {
+    if (state->body_buffer.length > 0) {
 
-        int body_result = request_set_body(request_to_send, state->body_buffer, strlen(state->body_buffer));
+        int body_result = request_set_body(request_to_send, state->body_buffer.data, state->body_buffer.length);
         if (body_result != 0) {
 
-            state->request_in_progress = false;
             snprintf(state->status_message, sizeof(state->status_message), "Failed to prepare request body");
             return false;
         }
     }
 
-    response_cleanup(&state->current_response);
-    response_init(&state->current_response);
-
     if (request_to_send != &state->current_request) {
         request_cleanup(&state->current_request);
         request_init(&state->current_request);
@@ -318,7 +325,6 @@ bool ui_request_panel_handle_send_request(UIManager* ui, AppState* state) {
             int body_result = request_set_body(&state->current_request, request_to_send->body, request_to_send->body_size);
             if (body_result != 0) {
 
-                state->request_in_progress = false;
                 snprintf(state->status_message, sizeof(state->status_message), "Failed to prepare request body");
                 return false;
             }
@@ -333,52 +339,21 @@ bool ui_request_panel_handle_send_request(UIManager* ui, AppState* state) {
         }
     }
 
-    int result;
-    Collection* active_collection = app_state_get_active_collection(state);
-    if (active_collection) {
-        result = http_client_send_request_with_cookies(state->http_client, &state->current_request, &state->current_response, active_collection);
-    } else {
-
-        result = http_client_send_request(state->http_client, &state->current_request, &state->current_response);
-    }
-
-    if (result == 0) {
-
-        if (state->current_response.status_code >= 200 && state->current_response.status_code < 300) {
-            snprintf(state->status_message, sizeof(state->status_message), 
-                    "Success: %d %s (%.2f ms)", 
-                    state->current_response.status_code,
-                    state->current_response.status_text,
-                    state->current_response.response_time);
-        } else if (state->current_response.status_code > 0) {
-            snprintf(state->status_message, sizeof(state->status_message), 
-                    "HTTP %d: %s (%.2f ms)", 
-                    state->current_response.status_code,
-                    state->current_response.status_text,
-                    state->current_response.response_time);
-        } else {
-            snprintf(state->status_message, sizeof(state->status_message), 
-                    "Network Error: %s", 
-                    state->current_response.status_text);
-        }
-    } else {
-
-        if (state->current_response.status_text[0] != '\0') {
-            snprintf(state->status_message, sizeof(state->status_message), 
-                    "Error: %s", state->current_response.status_text);
-        } else {
-            snprintf(state->status_message, sizeof(state->status_message), 
-                    "Failed to send request (error code: %d)", result);
-        }
+    /* each request gets its own response tab, sending one never waits for another */
+    CollectionManager* manager = state->collection_manager;
+    int tab_index = app_state_open_request_tab(state, manager->active_collection_index,
+                                               request_to_send != &state->current_request ? manager->active_request_index : -1);
+    if (tab_index < 0) {
+        snprintf(state->status_message, sizeof(state->status_message), "Too many requests in flight");
+        return false;
     }
 
-    if (request_to_send != &state->current_request) {
-        app_state_check_and_perform_auto_save(state);
+    if (app_state_send_request(state, tab_index, &state->current_request) != 0) {
+        return false;
     }
+    app_state_set_active_request_tab(state, tab_index);
 
-    state->request_in_progress = false;
-
-    return (result == 0);
+    return true;
 }
 
 void ui_request_panel_render_request_header(UIManager* ui, AppState* state, Request* request, Collection* collection) {
@@ -427,9 +402,10 @@ void ui_request_panel_render_request_header(UIManager* ui, AppState* state, Requ
     ImGui::SetNextItemWidth(dynamic_width);
     if (ImGui::InputText("##request_name", request_name_edit_buffer, sizeof(request_name_edit_buffer))) {
 
-        if (strlen(request_name_edit_buffer) > 0) {
-            collection_rename_request(collection, request_index, request_name_edit_buffer);
-            app_state_set_unsaved_changes(state, true);
+        unsigned int base_generation = collection->generation;
+        if (strlen(request_name_edit_buffer) > 0 &&
+            collection_rename_request(collection, request_index, request_name_edit_buffer) == 0) {
+            app_state_journal_put_request(state, collection, base_generation, request_index);
         }
     }
 
@@ -516,10 +492,12 @@ bool ui_request_panel_handle_duplicate_request(UIManager* ui, AppState* state) {
         strcpy(duplicate_name, "Untitled Request (Copy)");
     }
 
+    unsigned int base_generation = active_collection->generation;
     int new_request_index = collection_duplicate_request(active_collection, current_request_index);
     if (new_request_index >= 0) {
 
         collection_rename_request(active_collection, new_request_index, duplicate_name);
+        app_state_journal_put_request(state, active_collection, base_generation, new_request_index);
 
         app_state_set_active_request(state, new_request_index);
 
@@ -530,8 +508,6 @@ bool ui_request_panel_handle_duplicate_request(UIManager* ui, AppState* state) {
             app_state_sync_request_to_ui(state);
         }
 
-        app_state_save_all_collections(state);
-
         snprintf(state->status_message, sizeof(state->status_message), 
                 "Request duplicated successfully");
         return true;
@@ -544,7 +520,6 @@ bool ui_request_panel_handle_duplicate_request(UIManager* ui, AppState* state) {
 
 static void ui_request_panel_format_json_body(AppState* state);
 static void ui_request_panel_minify_json_body(AppState* state);
-static void ui_request_panel_show_json_validation_status(AppState* state, const ModernGruvboxTheme* theme);
 static void ui_request_panel_render_json_body(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme);
 static void ui_request_panel_render_form_data_body(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme);
 static void ui_request_panel_render_form_urlencoded_body(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme);
@@ -558,7 +533,7 @@ static void ui_request_panel_apply_authentication(AppState* state);
 static void ui_request_panel_update_form_data_body(AppState* state, char form_keys[][256], char form_values[][512], bool form_enabled[], int pair_count, bool is_multipart) {
     if (!state) return;
 
-    state->body_buffer[0] = '\0';
+    text_buffer_clear(&state->body_buffer);
 
     if (is_multipart) {
 
@@ -567,27 +542,22 @@ static void ui_request_panel_update_form_data_body(AppState* state, char form_ke
         for (int i = 0; i < pair_count; i++) {
             if (form_enabled[i] && strlen(form_keys[i]) > 0) {
 
-                size_t current_len = strlen(state->body_buffer);
-                size_t remaining = sizeof(state->body_buffer) - current_len - 1;
-
-                snprintf(state->body_buffer + current_len, remaining,
+                text_buffer_appendf(&state->body_buffer,
                     "--%s\r\nContent-Disposition: form-data; name=\"%s\"\r\n\r\n%s\r\n",
                     boundary, form_keys[i], form_values[i]);
             }
         }
 
-        if (strlen(state->body_buffer) > 0) {
-            size_t current_len = strlen(state->body_buffer);
-            size_t remaining = sizeof(state->body_buffer) - current_len - 1;
-            snprintf(state->body_buffer + current_len, remaining, "--%s--\r\n", boundary);
+        if (state->body_buffer.length > 0) {
+            text_buffer_appendf(&state->body_buffer, "--%s--\r\n", boundary);
         }
 
     } else {
 
         for (int i = 0; i < pair_count; i++) {
             if (form_enabled[i] && strlen(form_keys[i]) > 0) {
-                if (strlen(state->body_buffer) > 0) {
-                    strcat(state->body_buffer, "&");
+                if (state->body_buffer.length > 0) {
+                    text_buffer_append(&state->body_buffer, "&", 1);
                 }
 
                 char encoded_key[512];
@@ -596,16 +566,13 @@ static void ui_request_panel_update_form_data_body(AppState* state, char form_ke
                 ui_request_panel_url_encode(form_keys[i], encoded_key, sizeof(encoded_key));
                 ui_request_panel_url_encode(form_values[i], encoded_value, sizeof(encoded_value));
 
-                size_t current_len = strlen(state->body_buffer);
-                size_t remaining = sizeof(state->body_buffer) - current_len - 1;
-
-                snprintf(state->body_buffer + current_len, remaining, "%s=%s", encoded_key, encoded_value);
+                text_buffer_appendf(&state->body_buffer, "%s=%s", encoded_key, encoded_value);
             }
         }
     }
 
     app_state_sync_ui_to_request(state);
-    app_state_mark_ui_dirty(state);
+    app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
     app_state_set_unsaved_changes(state, true);
 }
 
@@ -681,18 +648,16 @@ static void ui_request_panel_url_decode(const char* input, char* output, size_t
 }
 
 static void ui_request_panel_format_json_body(AppState* state) {
-    if (!state || strlen(state->body_buffer) == 0) {
+    if (!state || state->body_buffer.length == 0) {
         return;
     }
 
-    cJSON* json = cJSON_Parse(state->body_buffer);
+    cJSON* json = cJSON_Parse(state->body_buffer.data);
     if (json) {
         char* formatted = cJSON_Print(json);
         if (formatted) {
 
-            size_t formatted_len = strlen(formatted);
-            if (formatted_len < sizeof(state->body_buffer)) {
-                strcpy(state->body_buffer, formatted);
+            if (text_buffer_set_cstr(&state->body_buffer, formatted) == 0) {
 
                 Request* active_request = app_state_get_active_request(state);
                 HeaderList* headers = active_request ? &active_request->headers : &state->current_request.headers;
@@ -706,7 +671,7 @@ static void ui_request_panel_format_json_body(AppState* state) {
 
                 header_list_add(headers, "Content-Type", "application/json");
 
-                app_state_mark_ui_dirty(state);
+                app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
                 app_state_set_unsaved_changes(state, true);
             }
             free(formatted);
@@ -715,19 +680,17 @@ static void ui_request_panel_format_json_body(AppState* state) {
     }
 }
 
-static void ui_request_panel_format_json_body_separate(AppState* state, char* json_buffer) {
-    if (!state || !json_buffer || strlen(json_buffer) == 0) {
+static void ui_request_panel_format_json_body_separate(AppState* state, TextBuffer* json_buffer) {
+    if (!state || !json_buffer || json_buffer->length == 0) {
         return;
     }
 
-    cJSON* json = cJSON_Parse(json_buffer);
+    cJSON* json = cJSON_Parse(json_buffer->data);
     if (json) {
         char* formatted = cJSON_Print(json);
         if (formatted) {
 
-            size_t formatted_len = strlen(formatted);
-            if (formatted_len < sizeof(state->json_body_buffer)) {
-                strcpy(json_buffer, formatted);
+            if (text_buffer_set_cstr(json_buffer, formatted) == 0) {
 
                 Request* active_request = app_state_get_active_request(state);
                 HeaderList* headers = active_request ? &active_request->headers : &state->current_request.headers;
@@ -741,7 +704,7 @@ static void ui_request_panel_format_json_body_separate(AppState* state, char* js
 
                 header_list_add(headers, "Content-Type", "application/json");
 
-                app_state_mark_ui_dirty(state);
+                app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
                 app_state_set_unsaved_changes(state, true);
             }
             free(formatted);
@@ -751,18 +714,16 @@ static void ui_request_panel_format_json_body_separate(AppState* state, char* js
 }
 
 static void ui_request_panel_minify_json_body(AppState* state) {
-    if (!state || strlen(state->body_buffer) == 0) {
+    if (!state || state->body_buffer.length == 0) {
         return;
     }
 
-    cJSON* json = cJSON_Parse(state->body_buffer);
+    cJSON* json = cJSON_Parse(state->body_buffer.data);
     if (json) {
         char* minified = cJSON_PrintUnformatted(json);
         if (minified) {
 
-            size_t minified_len = strlen(minified);
-            if (minified_len < sizeof(state->body_buffer)) {
-                strcpy(state->body_buffer, minified);
+            if (text_buffer_set_cstr(&state->body_buffer, minified) == 0) {
 
                 Request* active_request = app_state_get_active_request(state);
                 HeaderList* headers = active_request ? &active_request->headers : &state->current_request.headers;
@@ -776,7 +737,7 @@ static void ui_request_panel_minify_json_body(AppState* state) {
 
                 header_list_add(headers, "Content-Type", "application/json");
 
-                app_state_mark_ui_dirty(state);
+                app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
                 app_state_set_unsaved_changes(state, true);
             }
             free(minified);
@@ -785,19 +746,17 @@ static void ui_request_panel_minify_json_body(AppState* state) {
     }
 }
 
-static void ui_request_panel_minify_json_body_separate(AppState* state, char* json_buffer) {
-    if (!state || !json_buffer || strlen(json_buffer) == 0) {
+static void ui_request_panel_minify_json_body_separate(AppState* state, TextBuffer* json_buffer) {
+    if (!state || !json_buffer || json_buffer->length == 0) {
         return;
     }
 
-    cJSON* json = cJSON_Parse(json_buffer);
+    cJSON* json = cJSON_Parse(json_buffer->data);
     if (json) {
         char* minified = cJSON_PrintUnformatted(json);
         if (minified) {
 
-            size_t minified_len = strlen(minified);
-            if (minified_len < sizeof(state->json_body_buffer)) {
-                strcpy(json_buffer, minified);
+            if (text_buffer_set_cstr(json_buffer, minified) == 0) {
 
                 Request* active_request = app_state_get_active_request(state);
                 HeaderList* headers = active_request ? &active_request->headers : &state->current_request.headers;
@@ -811,7 +770,7 @@ static void ui_request_panel_minify_json_body_separate(AppState* state, char* js
 
                 header_list_add(headers, "Content-Type", "application/json");
 
-                app_state_mark_ui_dirty(state);
+                app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
                 app_state_set_unsaved_changes(state, true);
             }
             free(minified);
@@ -820,56 +779,122 @@ static void ui_request_panel_minify_json_body_separate(AppState* state, char* js
     }
 }
 
-static void ui_request_panel_show_json_validation_status(AppState* state, const ModernGruvboxTheme* theme) {
-    if (strlen(state->body_buffer) == 0) {
+/* queues the json body for validation once typing has paused for a moment */
+static void ui_request_panel_update_json_validation(TextBuffer* json_buffer, bool editing) {
+    double now = ImGui::GetTime();
+    if (json_buffer->generation != g_json_seen_generation) {
+        g_json_seen_generation = json_buffer->generation;
+        g_json_last_edit_time = now;
+    }
+
+    if (json_buffer->length == 0) {
+        return;
+    }
+    if (g_json_submitted && g_json_submitted_generation == json_buffer->generation) {
+        return;
+    }
+    /* while the editor has focus the caret timer keeps frames coming, so the debounce gets to fire */
+    if (editing && now - g_json_last_edit_time < JSON_VALIDATION_DEBOUNCE_SECONDS) {
         return;
     }
 
-    cJSON* json = cJSON_Parse(state->body_buffer);
-    if (json) {
-        ImGui::PushStyleColor(ImGuiCol_Text, theme->success);
-        ImGui::Text(ICON_FA_CHECK " Valid JSON");
-        ImGui::PopStyleColor();
-        cJSON_Delete(json);
-    } else {
-        const char* error_ptr = cJSON_GetErrorPtr();
-        ImGui::PushStyleColor(ImGuiCol_Text, theme->error);
-        if (error_ptr) {
-            ImGui::Text(ICON_FA_TIMES " Invalid JSON: Error near '%.10s'", error_ptr);
-        } else {
-            ImGui::Text(ICON_FA_TIMES " Invalid JSON format");
+    if (!g_json_validator) {
+        g_json_validator = json_validator_create();
+        if (!g_json_validator) {
+            return;
         }
-        ImGui::PopStyleColor();
     }
+    if (json_validator_submit(g_json_validator, json_buffer->generation, json_buffer->data, json_buffer->length) == 0) {
+        g_json_submitted = true;
+        g_json_submitted_generation = json_buffer->generation;
+    }
+}
+
+/* draws the line the error is on with a caret under the failing byte */
+static void ui_request_panel_show_json_error_line(const TextBuffer* json_buffer, const JsonValidationResult* result,
+                                                  const ModernGruvboxTheme* theme) {
+    size_t line_start = result->error_offset - (size_t)(result->error_column - 1);
+    size_t line_end = line_start;
+    while (line_end < json_buffer->length && json_buffer->data[line_end] != '\n' &&
+           json_buffer->data[line_end] != '\r') {
+        line_end++;
+    }
+    if (line_end < result->error_offset) {
+        line_end = result->error_offset;
+    }
+
+    /* long lines are clipped to a window around the error */
+    size_t window_start = result->error_offset > line_start + JSON_ERROR_CONTEXT_BYTES ?
+                          result->error_offset - JSON_ERROR_CONTEXT_BYTES : line_start;
+    size_t window_end = line_end - result->error_offset > JSON_ERROR_CONTEXT_BYTES ?
+                        result->error_offset + JSON_ERROR_CONTEXT_BYTES : line_end;
+
+    char snippet[2 * JSON_ERROR_CONTEXT_BYTES + 1];
+    size_t snippet_length = 0;
+    for (size_t i = window_start; i < window_end && i < json_buffer->length; i++) {
+        unsigned char c = (unsigned char)json_buffer->data[i];
+        snippet[snippet_length++] = c < 0x20 ? ' ' : (char)c;
+    }
+    snippet[snippet_length] = '\0';
+
+    size_t caret_offset = result->error_offset - window_start;
+    if (caret_offset > snippet_length) {
+        caret_offset = snippet_length;
+    }
+    float start_x = ImGui::GetCursorPosX();
+
+    ImGui::PushStyleColor(ImGuiCol_Text, theme->fg_secondary);
+    ImGui::TextUnformatted(snippet, snippet + snippet_length);
+    ImGui::PopStyleColor();
+
+    ImGui::SetCursorPosX(start_x + ImGui::CalcTextSize(snippet, snippet + caret_offset).x);
+    ImGui::PushStyleColor(ImGuiCol_Text, theme->error);
+    ImGui::TextUnformatted("^");
+    ImGui::PopStyleColor();
 }
 
-static void ui_request_panel_show_json_validation_status_separate(AppState* state, const ModernGruvboxTheme* theme, char* json_buffer) {
-    if (!json_buffer || strlen(json_buffer) == 0) {
+/* shows the cached validation result, dimmed while a newer edit is still being checked */
+static void ui_request_panel_show_json_validation_status(const ModernGruvboxTheme* theme, TextBuffer* json_buffer) {
+    if (!json_buffer || json_buffer->length == 0) {
         return;
     }
 
-    cJSON* json = cJSON_Parse(json_buffer);
-    if (json) {
-        ImGui::PushStyleColor(ImGuiCol_Text, theme->success);
+    JsonValidationResult result;
+    if (!g_json_validator || !json_validator_get_result(g_json_validator, &result)) {
+        ImGui::TextColored(theme->fg_tertiary, ICON_FA_SPINNER " Checking JSON...");
+        return;
+    }
+
+    bool current = result.generation == json_buffer->generation;
+    if (result.valid) {
+        ImGui::PushStyleColor(ImGuiCol_Text, current ? theme->success : theme->fg_tertiary);
         ImGui::Text(ICON_FA_CHECK " Valid JSON");
         ImGui::PopStyleColor();
-        cJSON_Delete(json);
-    } else {
-        const char* error_ptr = cJSON_GetErrorPtr();
-        ImGui::PushStyleColor(ImGuiCol_Text, theme->error);
-        if (error_ptr) {
-            ImGui::Text(ICON_FA_TIMES " Invalid JSON: Error near '%.10s'", error_ptr);
-        } else {
-            ImGui::Text(ICON_FA_TIMES " Invalid JSON format");
-        }
-        ImGui::PopStyleColor();
+        return;
+    }
+
+    ImGui::PushStyleColor(ImGuiCol_Text, current ? theme->error : theme->fg_tertiary);
+    ImGui::Text(ICON_FA_TIMES " Invalid JSON at line %d, column %d: %s",
+                result.error_line, result.error_column, result.message);
+    ImGui::PopStyleColor();
+
+    /* an old result's offsets no longer match the text */
+    if (!current) {
+        return;
     }
+
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Go to error")) {
+        ui_text_input_select(json_buffer, result.error_offset, result.error_offset < json_buffer->length ? 1 : 0);
+    }
+
+    ui_request_panel_show_json_error_line(json_buffer, &result, theme);
 }
 
 static void ui_request_panel_render_json_body(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme) {
     (void)ui; 
 
-    char* json_buffer = app_state_get_content_buffer(state, CONTENT_TYPE_JSON);
+    TextBuffer* json_buffer = app_state_get_content_buffer(state, CONTENT_TYPE_JSON);
     if (!json_buffer) {
         return;
     }
@@ -907,12 +932,13 @@ static void ui_request_panel_render_json_body(UIManager* ui, AppState* state, co
     ImGui::PushStyleColor(ImGuiCol_FrameBg, theme_alpha_blend(theme->success, 0.1f));
     ImGui::PushStyleColor(ImGuiCol_Border, theme_alpha_blend(theme->success, 0.3f));
 
-    if (ImGui::InputTextMultiline("##json_body", json_buffer, sizeof(state->json_body_buffer),
-                                  ImVec2(-1.0f, -1.0f))) {
+    bool edited = ui_text_input_multiline("##json_body", json_buffer, -1.0f, -1.0f, 0);
+    bool editing = ImGui::IsItemActive();
+    if (edited) {
 
-        if (strlen(json_buffer) > 0) {
+        if (json_buffer->length > 0) {
 
-            const char* trimmed = json_buffer;
+            const char* trimmed = json_buffer->data;
             while (*trimmed == ' ' || *trimmed == '\t' || *trimmed == '\n' || *trimmed == '\r') {
                 trimmed++;
             }
@@ -942,15 +968,17 @@ static void ui_request_panel_render_json_body(UIManager* ui, AppState* state, co
         }
 
         app_state_sync_content_to_body_buffer(state, CONTENT_TYPE_JSON);
-        app_state_mark_ui_dirty(state);
+        app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
         app_state_set_unsaved_changes(state, true);
     }
 
     ImGui::PopStyleColor(2);
     ImGui::EndChild();
 
+    ui_request_panel_update_json_validation(json_buffer, editing);
+
     ImGui::Spacing();
-    ui_request_panel_show_json_validation_status_separate(state, theme, json_buffer);
+    ui_request_panel_show_json_validation_status(theme, json_buffer);
 }
 
 static void ui_request_panel_render_form_data_body(UIManager* ui, AppState* state, const ModernGruvboxTheme* theme) {
@@ -1078,8 +1106,8 @@ static void ui_request_panel_render_form_data_body(UIManager* ui, AppState* stat
             form_enabled[i] = (i == 0); 
         }
         form_pair_count = 1;
-        state->body_buffer[0] = '\0';
-        app_state_mark_ui_dirty(state);
+        text_buffer_clear(&state->body_buffer);
+        app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
         app_state_set_unsaved_changes(state, true);
     }
     theme_pop_button_style();
@@ -1302,8 +1330,8 @@ static void ui_request_panel_render_form_urlencoded_body(UIManager* ui, AppState
             urlencoded_enabled[i] = (i == 0); 
         }
         urlencoded_pair_count = 1;
-        state->body_buffer[0] = '\0';
-        app_state_mark_ui_dirty(state);
+        text_buffer_clear(&state->body_buffer);
+        app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
         app_state_set_unsaved_changes(state, true);
     }
     theme_pop_button_style();
@@ -1427,21 +1455,17 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
     bool is_yaml = (strcmp(type_name, "YAML") == 0);
     bool is_plain_text = (strcmp(type_name, "Plain Text") == 0);
 
-    char* content_buffer = NULL;
-    size_t buffer_size = 0;
+    TextBuffer* content_buffer = NULL;
     ContentType content_type;
 
     if (is_xml) {
         content_buffer = app_state_get_content_buffer(state, CONTENT_TYPE_XML);
-        buffer_size = sizeof(state->xml_body_buffer);
         content_type = CONTENT_TYPE_XML;
     } else if (is_yaml) {
         content_buffer = app_state_get_content_buffer(state, CONTENT_TYPE_YAML);
-        buffer_size = sizeof(state->yaml_body_buffer);
         content_type = CONTENT_TYPE_YAML;
     } else {
         content_buffer = app_state_get_content_buffer(state, CONTENT_TYPE_PLAIN_TEXT);
-        buffer_size = sizeof(state->plain_text_body_buffer);
         content_type = CONTENT_TYPE_PLAIN_TEXT;
     }
 
@@ -1455,9 +1479,9 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
         theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
         if (ImGui::Button(is_xml ? "Format XML" : "Format YAML", ImVec2(100, 0))) {
 
-            if (strlen(content_buffer) > 0) {
+            if (content_buffer->length > 0) {
 
-                app_state_mark_ui_dirty(state);
+                app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
                 app_state_set_unsaved_changes(state, true);
             }
         }
@@ -1472,9 +1496,9 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
         theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
         if (ImGui::Button("Validate", ImVec2(80, 0))) {
 
-            if (strlen(content_buffer) > 0) {
+            if (content_buffer->length > 0) {
 
-                bool has_content = strlen(content_buffer) > 0;
+                bool has_content = content_buffer->length > 0;
                 if (has_content) {
                     snprintf(state->status_message, sizeof(state->status_message),
                             "%s content appears valid", type_name);
@@ -1508,11 +1532,10 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
         ImGui::PushStyleColor(ImGuiCol_Text, theme->fg_primary);
     }
 
-    if (ImGui::InputTextMultiline("##raw_body", content_buffer, buffer_size,
-                                  ImVec2(-1.0f, -1.0f))) {
+    if (ui_text_input_multiline("##raw_body", content_buffer, -1.0f, -1.0f, 0)) {
 
         app_state_sync_content_to_body_buffer(state, content_type);
-        app_state_mark_ui_dirty(state);
+        app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
         app_state_set_unsaved_changes(state, true);
     }
 
@@ -1521,10 +1544,10 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
 
     ImGui::Spacing();
 
-    if (strlen(content_buffer) > 0) {
+    if (content_buffer->length > 0) {
 
         ImGui::PushStyleColor(ImGuiCol_Text, theme->fg_secondary);
-        ImGui::Text("Content length: %zu bytes", strlen(content_buffer));
+        ImGui::Text("Content length: %zu bytes", content_buffer->length);
         ImGui::PopStyleColor();
 
         if (is_xml) {
@@ -1532,7 +1555,7 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
             ImGui::Spacing();
             ImGui::SameLine();
 
-            const char* content = content_buffer;
+            const char* content = content_buffer->data;
             bool has_opening_tag = (strstr(content, "<") != NULL);
             bool has_closing_tag = (strstr(content, ">") != NULL);
 
@@ -1550,7 +1573,7 @@ static void ui_request_panel_render_raw_body(UIManager* ui, AppState* state, con
             ImGui::Spacing();
             ImGui::SameLine();
 
-            const char* content = content_buffer;
+            const char* content = content_buffer->data;
             bool has_yaml_structure = (strstr(content, ":") != NULL || strstr(content, "-") != NULL);
 
             if (has_yaml_structure) {
@@ -1621,9 +1644,9 @@ void ui_request_panel_render_body_panel(UIManager* ui, AppState* state) {
                 } else if (strstr(content_type_header, "application/x-yaml") != NULL || strstr(content_type_header, "text/yaml") != NULL) {
                     selected_body_type = 5; 
                 }
-            } else if (strlen(state->body_buffer) > 0) {
+            } else if (state->body_buffer.length > 0) {
 
-                const char* content = state->body_buffer;
+                const char* content = state->body_buffer.data;
                 const char* trimmed = content;
                 while (*trimmed == ' ' || *trimmed == '\t' || *trimmed == '\n' || *trimmed == '\r') {
                     trimmed++;
@@ -1662,21 +1685,21 @@ void ui_request_panel_render_body_panel(UIManager* ui, AppState* state) {
 
                 switch (previous_body_type) {
                     case 0: 
-                        app_state_set_content_buffer(state, CONTENT_TYPE_JSON, state->body_buffer);
+                        app_state_set_content_buffer(state, CONTENT_TYPE_JSON, state->body_buffer.data);
                         break;
                     case 3: 
-                        app_state_set_content_buffer(state, CONTENT_TYPE_PLAIN_TEXT, state->body_buffer);
+                        app_state_set_content_buffer(state, CONTENT_TYPE_PLAIN_TEXT, state->body_buffer.data);
                         break;
                     case 4: 
-                        app_state_set_content_buffer(state, CONTENT_TYPE_XML, state->body_buffer);
+                        app_state_set_content_buffer(state, CONTENT_TYPE_XML, state->body_buffer.data);
                         break;
                     case 5: 
-                        app_state_set_content_buffer(state, CONTENT_TYPE_YAML, state->body_buffer);
+                        app_state_set_content_buffer(state, CONTENT_TYPE_YAML, state->body_buffer.data);
                         break;
                 }
             }
 
-            char* new_buffer = NULL;
+            TextBuffer* new_buffer = NULL;
             switch (selected_body_type) {
                 case 0: 
                     new_buffer = app_state_get_content_buffer(state, CONTENT_TYPE_JSON);
@@ -1697,8 +1720,7 @@ void ui_request_panel_render_body_panel(UIManager* ui, AppState* state) {
             }
 
             if (new_buffer && selected_body_type != 1 && selected_body_type != 2) {
-                strncpy(state->body_buffer, new_buffer, sizeof(state->body_buffer) - 1);
-                state->body_buffer[sizeof(state->body_buffer) - 1] = '\0';
+                text_buffer_set(&state->body_buffer, new_buffer->data, new_buffer->length);
             }
         }
 
@@ -1728,7 +1750,7 @@ void ui_request_panel_render_body_panel(UIManager* ui, AppState* state) {
             header_list_add(headers, "Content-Type", content_type_value);
         }
 
-        app_state_mark_ui_dirty(state);
+        app_state_mark_field_dirty(state, SYNC_FIELD_BODY);
         app_state_set_unsaved_changes(state, true);
     }
     theme_pop_input_style();
@@ -1804,7 +1826,7 @@ void ui_request_panel_handle_keyboard_shortcuts(UIManager* ui, AppState* state)
                              strncmp(state->url_buffer, "https://", 8) == 0) &&
                              strlen(state->url_buffer) > 8;
 
-            if (!state->request_in_progress && url_valid) {
+            if (!app_state_is_active_request_in_progress(state) && url_valid) {
                 ui_request_panel_handle_send_request(ui, state);
             }
         }
@@ -1892,7 +1914,9 @@ static void ui_request_panel_apply_authentication(AppState* state) {
             break;
     }
 
-    app_state_mark_ui_dirty(state);
+    /* a query parameter api key changes the url, so the url buffer is copied back as well */
+    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
+    app_state_mark_field_dirty(state, SYNC_FIELD_URL);
     app_state_set_unsaved_changes(state, true);
 }
 
@@ -1922,7 +1946,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
         // Synchronize the change to per-request data
         current_request->selected_auth_type = state->selected_auth_type;
         ui_request_panel_apply_authentication(state);
-        app_state_mark_ui_dirty(state);
+        app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
         app_state_set_unsaved_changes(state, true);
     }
     theme_pop_input_style();
@@ -1946,7 +1970,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     // Sync to per-request data
                     current_request->auth_api_key_enabled = state->auth_api_key_enabled;
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
                 ImGui::Spacing();
@@ -1963,7 +1987,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     strncpy(current_request->auth_api_key_name, state->auth_api_key_name, sizeof(current_request->auth_api_key_name) - 1);
                     current_request->auth_api_key_name[sizeof(current_request->auth_api_key_name) - 1] = '\0';
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -1976,7 +2000,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     strncpy(current_request->auth_api_key_value, state->auth_api_key_value, sizeof(current_request->auth_api_key_value) - 1);
                     current_request->auth_api_key_value[sizeof(current_request->auth_api_key_value) - 1] = '\0';
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -1989,7 +2013,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     // Sync to per-request data
                     current_request->auth_api_key_location = state->auth_api_key_location;
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -2027,7 +2051,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     // Sync to per-request data
                     current_request->auth_bearer_enabled = state->auth_bearer_enabled;
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
                 ImGui::Spacing();
@@ -2044,7 +2068,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     strncpy(current_request->auth_bearer_token, state->auth_bearer_token, sizeof(current_request->auth_bearer_token) - 1);
                     current_request->auth_bearer_token[sizeof(current_request->auth_bearer_token) - 1] = '\0';
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -2082,7 +2106,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     // Sync to per-request data
                     current_request->auth_basic_enabled = state->auth_basic_enabled;
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
                 ImGui::Spacing();
@@ -2099,7 +2123,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     strncpy(current_request->auth_basic_username, state->auth_basic_username, sizeof(current_request->auth_basic_username) - 1);
                     current_request->auth_basic_username[sizeof(current_request->auth_basic_username) - 1] = '\0';
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -2112,7 +2136,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     strncpy(current_request->auth_basic_password, state->auth_basic_password, sizeof(current_request->auth_basic_password) - 1);
                     current_request->auth_basic_password[sizeof(current_request->auth_basic_password) - 1] = '\0';
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -2150,7 +2174,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     // Sync to per-request data
                     current_request->auth_oauth_enabled = state->auth_oauth_enabled;
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
                 ImGui::Spacing();
@@ -2167,7 +2191,7 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
                     strncpy(current_request->auth_oauth_token, state->auth_oauth_token, sizeof(current_request->auth_oauth_token) - 1);
                     current_request->auth_oauth_token[sizeof(current_request->auth_oauth_token) - 1] = '\0';
                     ui_request_panel_apply_authentication(state);
-                    app_state_mark_ui_dirty(state);
+                    app_state_mark_field_dirty(state, SYNC_FIELD_AUTH);
                     app_state_set_unsaved_changes(state, true);
                 }
 
@@ -2237,4 +2261,12 @@ static void ui_request_panel_render_auth_panel(UIManager* ui, AppState* state) {
     ImGui::PopStyleColor();
 }
 
+void ui_request_panel_cleanup(void) {
+    if (g_json_validator) {
+        json_validator_destroy(g_json_validator);
+        g_json_validator = NULL;
+    }
+    g_json_submitted = false;
+}
+
 } 
\ No newline at end of file
@@ -0,0 +1,355 @@
+/*
+ * compares the current response with the previous one
+ * body diffs run on the response_diff worker, this file only draws results
+ */
+
+#include "ui/ui_response_diff.h"
+#include "response_diff.h"
+#include "font_awesome.h"
+#include "imgui.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+extern "C" {
+
+/* characters of a line drawn per row, minified bodies can have megabyte-long lines */
+#define DIFF_VIEW_MAX_LINE_CHARS 400
+
+static ResponseDiff* g_response_diff = NULL;
+static int g_diff_mode = RESPONSE_DIFF_MODE_LINES;
+static const char* g_diff_left_body = NULL;
+static size_t g_diff_left_size = 0;
+static const char* g_diff_right_body = NULL;
+static size_t g_diff_right_size = 0;
+static int g_diff_started_mode = -1;
+static int g_diff_current_hunk = -1;
+static int g_diff_scroll_row = -1;
+
+static bool body_looks_like_json(const char* body, size_t size) {
+    if (!body) {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        char c = body[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            continue;
+        }
+        return c == '{' || c == '[';
+    }
+    return false;
+}
+
+/* restarts the diff when either response or the mode changed since the last run */
+static void start_diff_if_needed(const Response* previous, const Response* current) {
+    if (!g_response_diff) {
+        g_response_diff = response_diff_create();
+        if (!g_response_diff) {
+            return;
+        }
+    }
+
+    if (g_diff_left_body == previous->body && g_diff_left_size == previous->body_size &&
+        g_diff_right_body == current->body && g_diff_right_size == current->body_size &&
+        g_diff_started_mode == g_diff_mode) {
+        return;
+    }
+
+    g_diff_left_body = previous->body;
+    g_diff_left_size = previous->body_size;
+    g_diff_right_body = current->body;
+    g_diff_right_size = current->body_size;
+    g_diff_started_mode = g_diff_mode;
+    g_diff_current_hunk = -1;
+    g_diff_scroll_row = -1;
+
+    response_diff_start(g_response_diff, previous->body, previous->body_size,
+                        current->body, current->body_size, g_diff_mode);
+}
+
+static void render_change_summary(const Response* previous, const Response* current, const ModernGruvboxTheme* theme) {
+    ImVec4 status_color = previous->status_code == current->status_code ? theme->fg_secondary : theme->warning;
+    ImGui::TextColored(theme->fg_tertiary, "Status");
+    ImGui::SameLine(90.0f);
+    ImGui::TextColored(status_color, "%d " ICON_FA_ARROW_RIGHT " %d", previous->status_code, current->status_code);
+
+    ImGui::TextColored(theme->fg_tertiary, "Time");
+    ImGui::SameLine(90.0f);
+    double delta = previous->response_time > 0.0
+                       ? (current->response_time - previous->response_time) / previous->response_time * 100.0
+                       : 0.0;
+    ImVec4 time_color = delta < -1.0 ? theme->success : (delta > 1.0 ? theme->error : theme->fg_secondary);
+    ImGui::TextColored(time_color, "%.2f ms " ICON_FA_ARROW_RIGHT " %.2f ms (%+.1f%%)",
+                       previous->response_time, current->response_time, delta);
+
+    ImGui::TextColored(theme->fg_tertiary, "Size");
+    ImGui::SameLine(90.0f);
+    ImVec4 size_color = previous->body_size == current->body_size ? theme->fg_secondary : theme->warning;
+    ImGui::TextColored(size_color, "%zu " ICON_FA_ARROW_RIGHT " %zu bytes", previous->body_size, current->body_size);
+}
+
+static void render_header_changes(const Response* previous, const Response* current, const ModernGruvboxTheme* theme) {
+    HeaderDiffEntry* entries = NULL;
+    int count = response_diff_headers(&previous->headers, &current->headers, &entries);
+    if (count < 0) {
+        return;
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "Headers (%d changed)###DiffHeaders", count);
+    if (ImGui::TreeNodeEx(label, count > 0 ? ImGuiTreeNodeFlags_DefaultOpen : 0)) {
+        if (count == 0) {
+            theme_push_caption_style();
+            ImGui::TextColored(theme->fg_tertiary, "Same headers");
+            theme_pop_text_style();
+        }
+
+        for (int i = 0; i < count; i++) {
+            const HeaderDiffEntry* entry = &entries[i];
+            if (entry->kind == JSON_DIFF_ADDED) {
+                ImGui::TextColored(theme->success, "+ %s: %s", entry->name, entry->right);
+            } else if (entry->kind == JSON_DIFF_REMOVED) {
+                ImGui::TextColored(theme->error, "- %s: %s", entry->name, entry->left);
+            } else {
+                ImGui::TextColored(theme->warning, "~ %s: %s " ICON_FA_ARROW_RIGHT " %s",
+                                   entry->name, entry->left, entry->right);
+            }
+        }
+        ImGui::TreePop();
+    }
+
+    free(entries);
+}
+
+/* draws part of one side's line clipped to its column */
+static void draw_diff_cell(ImDrawList* draw_list, ImVec2 origin, float width, int line, int side, ImU32 text_color,
+                           ImU32 number_color, float number_width) {
+    if (line < 0) {
+        return;
+    }
+
+    char number[16];
+    snprintf(number, sizeof(number), "%d", line + 1);
+    draw_list->AddText(origin, number_color, number);
+
+    size_t length = 0;
+    const char* text = response_diff_get_line(g_response_diff, side, line, &length);
+    if (!text) {
+        return;
+    }
+    if (length > DIFF_VIEW_MAX_LINE_CHARS) {
+        length = DIFF_VIEW_MAX_LINE_CHARS;
+    }
+
+    ImVec4 clip(origin.x + number_width, origin.y, origin.x + width - 4.0f, origin.y + ImGui::GetTextLineHeightWithSpacing());
+    draw_list->AddText(ImGui::GetFont(), ImGui::GetFontSize(), ImVec2(origin.x + number_width, origin.y),
+                       text_color, text, text + length, 0.0f, &clip);
+}
+
+static void render_line_diff(const ModernGruvboxTheme* theme) {
+    int row_count = 0;
+    const DiffRow* rows = response_diff_get_rows(g_response_diff, &row_count);
+    int hunk_count = response_diff_get_hunk_count(g_response_diff);
+    int added, removed, changed;
+    response_diff_get_stats(g_response_diff, &added, &removed, &changed);
+
+    if (hunk_count == 0) {
+        theme_render_status_indicator("Bodies are identical", STATUS_TYPE_SUCCESS, theme);
+        ImGui::SameLine();
+        ImGui::TextColored(theme->fg_tertiary, "(%.1f ms)", response_diff_get_elapsed_ms(g_response_diff));
+        return;
+    }
+
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    ImGui::BeginDisabled(g_diff_current_hunk <= 0);
+    if (ImGui::Button("Prev", ImVec2(60, 0))) {
+        g_diff_current_hunk--;
+        g_diff_scroll_row = response_diff_get_hunk_row(g_response_diff, g_diff_current_hunk);
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(g_diff_current_hunk >= hunk_count - 1);
+    if (ImGui::Button("Next", ImVec2(60, 0))) {
+        g_diff_current_hunk++;
+        g_diff_scroll_row = response_diff_get_hunk_row(g_response_diff, g_diff_current_hunk);
+    }
+    ImGui::EndDisabled();
+    theme_pop_button_style();
+
+    ImGui::SameLine();
+    ImGui::TextColored(theme->success, "+%d", added);
+    ImGui::SameLine();
+    ImGui::TextColored(theme->error, "-%d", removed);
+    ImGui::SameLine();
+    ImGui::TextColored(theme->warning, "~%d", changed);
+    ImGui::SameLine();
+    theme_push_caption_style();
+    ImGui::TextColored(theme->fg_tertiary, "%d of %d changes, %.1f ms",
+                       g_diff_current_hunk + 1, hunk_count, response_diff_get_elapsed_ms(g_response_diff));
+    theme_pop_text_style();
+
+    ImGui::BeginChild("ResponseDiffRows", ImVec2(-1.0f, -1.0f), true, ImGuiWindowFlags_AlwaysVerticalScrollbar);
+
+    float row_height = ImGui::GetTextLineHeightWithSpacing();
+    if (g_diff_scroll_row >= 0) {
+        ImGui::SetScrollY(g_diff_scroll_row * row_height - ImGui::GetWindowHeight() * 0.3f);
+        g_diff_scroll_row = -1;
+    }
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    float half_width = ImGui::GetContentRegionAvail().x * 0.5f;
+    char widest_number[16];
+    snprintf(widest_number, sizeof(widest_number), "%d ", row_count);
+    float number_width = ImGui::CalcTextSize(widest_number).x + 4.0f;
+
+    ImU32 text_color = ImGui::GetColorU32(theme->fg_primary);
+    ImU32 number_color = ImGui::GetColorU32(theme->fg_tertiary);
+    ImU32 removed_color = ImGui::GetColorU32(theme_alpha_blend(theme->error, 0.18f));
+    ImU32 added_color = ImGui::GetColorU32(theme_alpha_blend(theme->success, 0.18f));
+    ImU32 missing_color = ImGui::GetColorU32(theme_alpha_blend(theme->fg_tertiary, 0.08f));
+    ImU32 divider_color = ImGui::GetColorU32(theme->border_normal);
+
+    ImGuiListClipper clipper;
+    clipper.Begin(row_count, row_height);
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const DiffRow* row = &rows[i];
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            ImVec2 right_origin(origin.x + half_width, origin.y);
+
+            if (row->kind != DIFF_ROW_EQUAL) {
+                ImU32 left_background = row->left_line >= 0 ? removed_color : missing_color;
+                ImU32 right_background = row->right_line >= 0 ? added_color : missing_color;
+                draw_list->AddRectFilled(origin, ImVec2(origin.x + half_width, origin.y + row_height), left_background);
+                draw_list->AddRectFilled(right_origin, ImVec2(right_origin.x + half_width, origin.y + row_height),
+                                         right_background);
+            }
+
+            draw_diff_cell(draw_list, origin, half_width, row->left_line, RESPONSE_DIFF_LEFT,
+                           text_color, number_color, number_width);
+            draw_diff_cell(draw_list, right_origin, half_width, row->right_line, RESPONSE_DIFF_RIGHT,
+                           text_color, number_color, number_width);
+            draw_list->AddLine(ImVec2(right_origin.x - 2.0f, origin.y), ImVec2(right_origin.x - 2.0f, origin.y + row_height),
+                               divider_color);
+
+            ImGui::Dummy(ImVec2(half_width * 2.0f, row_height));
+        }
+    }
+    clipper.End();
+
+    ImGui::EndChild();
+}
+
+static void render_json_diff(const ModernGruvboxTheme* theme) {
+    int count = 0;
+    const JsonDiffEntry* entries = response_diff_get_json_entries(g_response_diff, &count);
+
+    if (count == 0) {
+        theme_render_status_indicator("Documents are structurally identical", STATUS_TYPE_SUCCESS, theme);
+        ImGui::SameLine();
+        ImGui::TextColored(theme->fg_tertiary, "(%.1f ms)", response_diff_get_elapsed_ms(g_response_diff));
+        return;
+    }
+
+    theme_push_caption_style();
+    ImGui::TextColored(theme->fg_tertiary, "%d%s differences, %.1f ms", count,
+                       response_diff_is_truncated(g_response_diff) ? "+" : "",
+                       response_diff_get_elapsed_ms(g_response_diff));
+    theme_pop_text_style();
+
+    ImGui::BeginChild("ResponseDiffJson", ImVec2(-1.0f, -1.0f), true,
+                      ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_AlwaysVerticalScrollbar);
+
+    ImGuiListClipper clipper;
+    clipper.Begin(count, ImGui::GetTextLineHeightWithSpacing());
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const JsonDiffEntry* entry = &entries[i];
+            if (entry->kind == JSON_DIFF_ADDED) {
+                ImGui::TextColored(theme->success, "+ %s = %s", entry->path, entry->right);
+            } else if (entry->kind == JSON_DIFF_REMOVED) {
+                ImGui::TextColored(theme->error, "- %s = %s", entry->path, entry->left);
+            } else {
+                ImGui::TextColored(theme->warning, "~ %s: %s " ICON_FA_ARROW_RIGHT " %s",
+                                   entry->path, entry->left, entry->right);
+            }
+        }
+    }
+    clipper.End();
+
+    ImGui::EndChild();
+}
+
+/* draws the compare tab */
+void ui_response_diff_render(AppState* state, const ModernGruvboxTheme* theme) {
+    if (!state || !theme) {
+        return;
+    }
+
+    const Response* previous = app_state_get_previous_response(state);
+    const Response* current = app_state_get_current_response(state);
+
+    if (!previous || !current || previous->status_code <= 0) {
+        theme_render_status_indicator("Send the request again to compare with this response", STATUS_TYPE_INFO, theme);
+        return;
+    }
+
+    render_change_summary(previous, current, theme);
+    ImGui::Spacing();
+    render_header_changes(previous, current, theme);
+    ImGui::Spacing();
+
+    bool both_json = body_looks_like_json(previous->body, previous->body_size) &&
+                     body_looks_like_json(current->body, current->body_size);
+    if (!both_json) {
+        g_diff_mode = RESPONSE_DIFF_MODE_LINES;
+    } else {
+        ImGui::TextColored(theme->fg_secondary, "Compare");
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Lines", g_diff_mode == RESPONSE_DIFF_MODE_LINES)) {
+            g_diff_mode = RESPONSE_DIFF_MODE_LINES;
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("JSON structure", g_diff_mode == RESPONSE_DIFF_MODE_JSON)) {
+            g_diff_mode = RESPONSE_DIFF_MODE_JSON;
+        }
+    }
+
+    start_diff_if_needed(previous, current);
+    if (!g_response_diff) {
+        theme_render_status_indicator("Could not start the comparison", STATUS_TYPE_ERROR, theme);
+        return;
+    }
+
+    if (response_diff_is_running(g_response_diff)) {
+        theme_render_status_indicator("Comparing bodies...", STATUS_TYPE_LOADING, theme);
+        return;
+    }
+
+    const char* error = response_diff_get_error(g_response_diff);
+    if (error[0] != '\0') {
+        theme_render_status_indicator(error, STATUS_TYPE_ERROR, theme);
+        return;
+    }
+
+    if (response_diff_get_mode(g_response_diff) == RESPONSE_DIFF_MODE_JSON) {
+        render_json_diff(theme);
+    } else {
+        render_line_diff(theme);
+    }
+}
+
+/* stops a running diff and frees its results */
+void ui_response_diff_cleanup(void) {
+    if (g_response_diff) {
+        response_diff_destroy(g_response_diff);
+        g_response_diff = NULL;
+    }
+
+    g_diff_left_body = NULL;
+    g_diff_right_body = NULL;
+    g_diff_started_mode = -1;
+}
+
+}
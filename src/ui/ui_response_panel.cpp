@@ -3,6 +3,13 @@
 #include "ui/theme.h"
 #include "font_awesome.h"
 #include "app_state.h"
+#include "response_search.h"
+#include "json_filter.h"
+#include "ui/ui_hex_view.h"
+#include "ui/ui_image_preview.h"
+#include "ui/ui_response_diff.h"
+#include "image_decoder.h"
+#include "profiler.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -140,6 +147,8 @@ static void auto_format_json_if_needed(const char* json_string) {
         return;
     }
 
+    PROFILE_SCOPE("format_json");
+
     if (g_formatted_json) {
         free(g_formatted_json);
         g_formatted_json = NULL;
@@ -148,25 +157,547 @@ static void auto_format_json_if_needed(const char* json_string) {
     g_formatted_json = format_json_string(json_string);
 }
 
+/* a typed query waits this long for the next keystroke before it is searched */
+#define BODY_SEARCH_DEBOUNCE_SECONDS 0.2
+
+static ResponseSearch* g_body_search = NULL;
+static char g_search_query[RESPONSE_SEARCH_MAX_PATTERN] = {0};
+static int g_search_flags = RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE;
+static int g_search_current = -1;
+static bool g_search_scroll_pending = false;
+static bool g_search_restart_pending = false;
+static double g_search_edit_time = 0.0;
+static const char* g_search_source = NULL;
+static size_t g_search_source_size = 0;
+static bool g_search_locate_pending = false;
+static size_t g_search_match_line = 0;
+static size_t g_search_match_column = 0;
+
+static void cleanup_body_search(void) {
+    if (g_body_search) {
+        response_search_destroy(g_body_search);
+        g_body_search = NULL;
+    }
+    g_search_source = NULL;
+    g_search_source_size = 0;
+    g_search_current = -1;
+    g_search_restart_pending = false;
+    g_search_locate_pending = false;
+}
+
+static void __attribute__((destructor)) ui_response_panel_search_destructor(void) {
+    cleanup_body_search();
+}
+
+/*
+ * restarts the search when the searched text or the query changes. a new
+ * text and option toggles restart right away, typing waits for a pause so
+ * each keystroke does not cancel and respawn the workers.
+ */
+static void restart_body_search_if_needed(const char* text, size_t text_size, bool query_edited, bool restart_now) {
+    if (!g_body_search) {
+        g_body_search = response_search_create();
+        if (!g_body_search) {
+            return;
+        }
+    }
+
+    if (text != g_search_source || text_size != g_search_source_size) {
+        g_search_source = text;
+        g_search_source_size = text_size;
+        response_search_set_text(g_body_search, text, text_size);
+        restart_now = true;
+    }
+
+    double now = ImGui::GetTime();
+    if (query_edited) {
+        g_search_edit_time = now;
+        g_search_restart_pending = true;
+    }
+    /* while the input has focus the caret timer keeps frames coming, so the debounce gets to fire */
+    if (!restart_now && !(g_search_restart_pending && now - g_search_edit_time >= BODY_SEARCH_DEBOUNCE_SECONDS)) {
+        return;
+    }
+
+    g_search_restart_pending = false;
+    g_search_current = -1;
+    g_search_scroll_pending = false;
+    g_search_locate_pending = false;
+    response_search_start(g_body_search, g_search_query, g_search_flags);
+}
+
+/* works out the line and column of the current match once the worker has indexed the lines */
+static void locate_search_match(void) {
+    SearchMatch match;
+    if (!g_search_locate_pending || !g_body_search ||
+        response_search_get_match(g_body_search, g_search_current, &match) != 0) {
+        return;
+    }
+
+    if (response_search_locate(g_body_search, match.offset, &g_search_match_line, &g_search_match_column) == 0) {
+        g_search_locate_pending = false;
+        g_search_scroll_pending = true;
+    }
+}
+
+/* moves the current match, it is scrolled to once its line is known */
+static void select_search_match(int index) {
+    SearchMatch match;
+    if (!g_body_search || response_search_get_match(g_body_search, index, &match) != 0) {
+        return;
+    }
+
+    g_search_current = index;
+    g_search_locate_pending = true;
+    locate_search_match();
+}
+
+/* draws text with the match range on a highlighted background */
+static void render_search_snippet(const char* text, size_t text_size, const SearchMatch* match,
+                                  const ModernGruvboxTheme* theme) {
+    const size_t context = 40;
+    size_t start = match->offset > context ? match->offset - context : 0;
+    size_t match_end = match->offset + match->length;
+    size_t end = match_end + context < text_size ? match_end + context : text_size;
+
+    char before[64];
+    char found[RESPONSE_SEARCH_MAX_PATTERN + 64];
+    char after[64];
+    size_t before_len = 0;
+    size_t found_len = 0;
+    size_t after_len = 0;
+
+    for (size_t i = start; i < end; i++) {
+        char c = text[i];
+        if (c == '\n' || c == '\r' || c == '\t' || c == '\0') {
+            c = ' ';
+        }
+        if (i < match->offset) {
+            if (c == ' ' && before_len == 0) continue;
+            if (before_len < sizeof(before) - 1) before[before_len++] = c;
+        } else if (i < match_end) {
+            if (found_len < sizeof(found) - 1) found[found_len++] = c;
+        } else if (after_len < sizeof(after) - 1) {
+            after[after_len++] = c;
+        }
+    }
+    before[before_len] = '\0';
+    found[found_len] = '\0';
+    after[after_len] = '\0';
+
+    theme_push_caption_style();
+    if (!g_search_locate_pending) {
+        ImGui::TextColored(theme->fg_tertiary, "Line %zu:", g_search_match_line + 1);
+        ImGui::SameLine();
+    }
+    ImGui::TextColored(theme->fg_secondary, "%s", before);
+    ImGui::SameLine(0.0f, 0.0f);
+
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImVec2 size = ImGui::CalcTextSize(found);
+    ImGui::GetWindowDrawList()->AddRectFilled(pos, ImVec2(pos.x + size.x, pos.y + size.y),
+                                              ImGui::GetColorU32(theme_alpha_blend(theme->warning, 0.45f)), 2.0f);
+    ImGui::TextColored(theme->fg_primary, "%s", found);
+    ImGui::SameLine(0.0f, 0.0f);
+    ImGui::TextColored(theme->fg_secondary, "%s", after);
+    theme_pop_text_style();
+}
+
+/* renders the search input, match counter and navigation for the preview tab */
+static void render_body_search_bar(const char* text, size_t text_size, const ModernGruvboxTheme* theme) {
+    bool query_edited = false;
+    bool options_changed = false;
+
+    ImGui::PushItemWidth(-260.0f);
+    theme_push_input_style(theme);
+    if (ImGui::InputTextWithHint("##ResponseSearch", "Search response body...", g_search_query, sizeof(g_search_query))) {
+        query_edited = true;
+    }
+    theme_pop_input_style();
+    ImGui::PopItemWidth();
+    bool input_focused = ImGui::IsItemFocused();
+    bool enter_pressed = input_focused && ImGui::IsKeyPressed(ImGuiKey_Enter);
+
+    ImGui::SameLine();
+    bool case_sensitive = (g_search_flags & RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE) == 0;
+    theme_push_button_style(theme, case_sensitive ? BUTTON_TYPE_PRIMARY : BUTTON_TYPE_NORMAL);
+    if (ImGui::Button("Aa", ImVec2(32, 0))) {
+        g_search_flags ^= RESPONSE_SEARCH_FLAG_CASE_INSENSITIVE;
+        options_changed = true;
+    }
+    theme_pop_button_style();
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip(case_sensitive ? "Case sensitive" : "Case insensitive");
+    }
+
+    if (response_search_regex_supported()) {
+        ImGui::SameLine();
+        bool regex = (g_search_flags & RESPONSE_SEARCH_FLAG_REGEX) != 0;
+        theme_push_button_style(theme, regex ? BUTTON_TYPE_PRIMARY : BUTTON_TYPE_NORMAL);
+        if (ImGui::Button(".*", ImVec2(32, 0))) {
+            g_search_flags ^= RESPONSE_SEARCH_FLAG_REGEX;
+            options_changed = true;
+        }
+        theme_pop_button_style();
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Use regular expression (matches within a line)");
+        }
+    }
+
+    /* enter searches a query still waiting out the debounce instead of stepping */
+    bool search_now = options_changed || (enter_pressed && g_search_restart_pending);
+    restart_body_search_if_needed(text, text_size, query_edited, search_now);
+    if (!g_body_search) {
+        return;
+    }
+    locate_search_match();
+
+    int match_count = response_search_get_match_count(g_body_search);
+    bool running = response_search_is_running(g_body_search);
+
+    /* jump to the first hit as soon as a worker reports one */
+    if (g_search_current < 0 && match_count > 0) {
+        select_search_match(0);
+    }
+
+    bool go_next = false;
+    bool go_prev = false;
+    if (enter_pressed && !search_now) {
+        if (ImGui::GetIO().KeyShift) {
+            go_prev = true;
+        } else {
+            go_next = true;
+        }
+    }
+
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button("<", ImVec2(28, 0))) {
+        go_prev = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(">", ImVec2(28, 0))) {
+        go_next = true;
+    }
+    theme_pop_button_style();
+
+    if (match_count > 0 && (go_next || go_prev)) {
+        int index = g_search_current;
+        if (go_next) {
+            index = (index + 1) % match_count;
+        } else {
+            index = (index <= 0) ? match_count - 1 : index - 1;
+        }
+        select_search_match(index);
+    }
+
+    ImGui::SameLine();
+    theme_push_caption_style();
+    if (strlen(g_search_query) == 0) {
+        ImGui::TextColored(theme->fg_tertiary, "No search");
+    } else if (strlen(response_search_get_error(g_body_search)) > 0) {
+        ImGui::TextColored(theme->error, "%s", response_search_get_error(g_body_search));
+    } else if (match_count == 0) {
+        ImGui::TextColored(running ? theme->fg_tertiary : theme->warning,
+                           running ? ICON_FA_SPINNER " Searching..." : "No matches");
+    } else {
+        ImGui::TextColored(theme->fg_secondary, "%d of %d%s%s", g_search_current + 1, match_count,
+                           response_search_is_truncated(g_body_search) ? "+" : "",
+                           running ? " " ICON_FA_SPINNER : "");
+    }
+    theme_pop_text_style();
+
+    SearchMatch match;
+    if (g_search_current >= 0 && response_search_get_match(g_body_search, g_search_current, &match) == 0) {
+        render_search_snippet(text, text_size, &match, theme);
+    }
+}
+
+/*
+ * paints the current match behind the body text and scrolls it into view.
+ * must be called right after the body child begins, before any text is drawn.
+ * exact placement only works for plain unwrapped text, the json tree view
+ * gets a proportional scroll instead.
+ */
+static void apply_search_highlight(const char* visible_text, size_t visible_size,
+                                   bool plain_text, const ModernGruvboxTheme* theme) {
+    SearchMatch match;
+    if (!g_body_search || g_search_current < 0 || g_search_locate_pending ||
+        response_search_get_match(g_body_search, g_search_current, &match) != 0) {
+        return;
+    }
+
+    float line_height = ImGui::GetTextLineHeight();
+
+    if (plain_text && match.offset + match.length <= visible_size) {
+        const char* line_start = visible_text + match.offset - g_search_match_column;
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float x = origin.x + ImGui::CalcTextSize(line_start, line_start + g_search_match_column).x;
+        float y = origin.y + g_search_match_line * line_height;
+        float width = ImGui::CalcTextSize(visible_text + match.offset, visible_text + match.offset + match.length).x;
+
+        ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(x - 1.0f, y), ImVec2(x + width + 1.0f, y + line_height),
+                                                  ImGui::GetColorU32(theme_alpha_blend(theme->warning, 0.45f)), 2.0f);
+
+        if (g_search_scroll_pending) {
+            ImGui::SetScrollY(g_search_match_line * line_height - ImGui::GetWindowHeight() * 0.4f);
+            float visible_width = ImGui::GetWindowWidth();
+            float local_x = x - origin.x;
+            if (local_x < ImGui::GetScrollX() || local_x + width > ImGui::GetScrollX() + visible_width) {
+                ImGui::SetScrollX(local_x - visible_width * 0.3f);
+            }
+            g_search_scroll_pending = false;
+        }
+    } else if (g_search_scroll_pending) {
+        /* the line layout is not known here, land near the match and let the snippet show it */
+        size_t total_lines = response_search_get_line_count(g_body_search);
+        float fraction = total_lines > 0 ? (float)g_search_match_line / (float)total_lines : 0.0f;
+        ImGui::SetScrollY(ImGui::GetScrollMaxY() * fraction);
+        g_search_scroll_pending = false;
+    }
+}
+
+/* hex view state, binary bodies open in hex mode until the user switches to text */
+static HexViewState g_hex_view = {0, 0, false, false, 0, 0, HEX_VIEW_NO_OFFSET, 0, {0}};
+static bool g_show_hex = false;
+static bool g_hex_mode_pending = true;
+
+/* image bodies open in the image preview, the key identifies them in its texture cache */
+static bool g_show_image = false;
+static bool g_can_show_image = false;
+static uint64_t g_image_key = 0;
+
+/* mirrors the current search match into the hex view */
+static void apply_search_highlight_hex(void) {
+    SearchMatch match;
+    if (!g_body_search || g_search_current < 0 ||
+        response_search_get_match(g_body_search, g_search_current, &match) != 0) {
+        ui_hex_view_set_highlight(&g_hex_view, 0, 0);
+        return;
+    }
+
+    ui_hex_view_set_highlight(&g_hex_view, match.offset, match.length);
+    if (g_search_scroll_pending) {
+        ui_hex_view_scroll_to(&g_hex_view, match.offset);
+        g_search_scroll_pending = false;
+    }
+}
+
+/* jsonpath filter state, the output replaces the body view while it is set. the
+ * filter runs on a worker, results from an older generation are dropped */
+static JsonFilterRunner* g_filter_runner = NULL;
+static unsigned int g_filter_generation = 0;
+static bool g_filter_pending = false;
+
+static char g_filter_expression[256] = {0};
+static char* g_filter_output = NULL;
+static size_t g_filter_output_size = 0;
+static long g_filter_match_count = -1;
+static bool g_filter_truncated = false;
+static bool g_filter_stale = false;
+static char g_filter_error[160] = {0};
+
+static void cleanup_filter_output(void) {
+    if (g_filter_output) {
+        free(g_filter_output);
+        g_filter_output = NULL;
+    }
+    g_filter_output_size = 0;
+    g_filter_match_count = -1;
+    g_filter_truncated = false;
+}
+
+static void __attribute__((destructor)) ui_response_panel_filter_destructor(void) {
+    cleanup_filter_output();
+}
+
+/* stops waiting for the filter that is running, its result is dropped when it arrives */
+static void cancel_response_filter(void) {
+    g_filter_generation++;
+    g_filter_pending = false;
+}
+
+/* hands the body to the filter worker, the old output stays away until the new one is ready */
+static void apply_response_filter(const Response* response) {
+    cleanup_filter_output();
+    cancel_response_filter();
+    g_filter_error[0] = '\0';
+    g_filter_stale = false;
+
+    if (strlen(g_filter_expression) == 0 || !response->body) {
+        return;
+    }
+
+    if (!g_filter_runner) {
+        g_filter_runner = json_filter_runner_create();
+    }
+    if (!g_filter_runner || json_filter_runner_submit(g_filter_runner, g_filter_generation, g_filter_expression,
+                                                      response->body, response->body_size) != 0) {
+        snprintf(g_filter_error, sizeof(g_filter_error), "Could not start the filter");
+        return;
+    }
+    g_filter_pending = true;
+}
+
+/* picks up a finished filter run */
+static void poll_response_filter(void) {
+    JsonFilterResult result;
+    if (!g_filter_runner || !json_filter_runner_take_result(g_filter_runner, &result)) {
+        return;
+    }
+    if (!g_filter_pending || result.generation != g_filter_generation) {
+        free(result.output);
+        return;
+    }
+
+    g_filter_pending = false;
+    cleanup_filter_output();
+    g_filter_output = result.output;
+    g_filter_output_size = result.output_size;
+    g_filter_match_count = result.match_count;
+    g_filter_truncated = result.truncated;
+    snprintf(g_filter_error, sizeof(g_filter_error), "%s", result.error);
+}
+
+/* renders the jsonpath filter input for json responses */
+static void render_response_filter_bar(const Response* response, const ModernGruvboxTheme* theme) {
+    bool apply = false;
+
+    poll_response_filter();
+
+    /* a new response re-runs the filter that was applied to the previous one */
+    if (g_filter_stale && (g_filter_match_count >= 0 || g_filter_pending)) {
+        apply = true;
+    }
+
+    ImGui::PushItemWidth(-170.0f);
+    theme_push_input_style(theme);
+    if (ImGui::InputTextWithHint("##ResponseFilter", "JSONPath filter, e.g. $.items[*].id", g_filter_expression,
+                                 sizeof(g_filter_expression), ImGuiInputTextFlags_EnterReturnsTrue)) {
+        apply = true;
+    }
+    theme_pop_input_style();
+    ImGui::PopItemWidth();
+
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_PRIMARY);
+    if (ImGui::Button("Filter", ImVec2(70, 0))) {
+        apply = true;
+    }
+    theme_pop_button_style();
+
+    ImGui::SameLine();
+    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+    if (ImGui::Button("Clear", ImVec2(70, 0))) {
+        g_filter_expression[0] = '\0';
+        g_filter_error[0] = '\0';
+        cleanup_filter_output();
+        cancel_response_filter();
+    }
+    theme_pop_button_style();
+
+    if (apply) {
+        apply_response_filter(response);
+    }
+
+    if (strlen(g_filter_error) > 0) {
+        theme_push_caption_style();
+        ImGui::TextColored(theme->error, "%s", g_filter_error);
+        theme_pop_text_style();
+    } else if (g_filter_pending) {
+        theme_push_caption_style();
+        ImGui::TextColored(theme->fg_tertiary, "Filtering...");
+        theme_pop_text_style();
+    } else if (g_filter_match_count >= 0) {
+        theme_push_caption_style();
+        ImGui::TextColored(g_filter_match_count > 0 ? theme->success : theme->warning,
+                           "%ld match%s%s", g_filter_match_count, g_filter_match_count == 1 ? "" : "es",
+                           g_filter_truncated ? " (output limit reached)" : "");
+        theme_pop_text_style();
+    }
+}
+
+/* shows at most max_size bytes of plain text */
+static void render_plain_text_limited(const char* text, size_t size, size_t max_size) {
+    ImGui::TextUnformatted(text, text + (size > max_size ? max_size : size));
+}
+
+static void render_timing_row(const char* phase, double ms) {
+    if (ms < 0.0) {
+        ImGui::Text("%-10s --", phase);
+    } else {
+        ImGui::Text("%-10s %.1f ms", phase, ms);
+    }
+}
+
+/* where the time went, the same phases a HAR export writes */
+static void render_timings_tooltip(const ResponseTimings* timings) {
+    ImGui::BeginTooltip();
+    render_timing_row("DNS", timings->dns_ms);
+    render_timing_row("Connect", timings->connect_ms);
+    render_timing_row("TLS", timings->ssl_ms);
+    render_timing_row("Send", timings->send_ms);
+    render_timing_row("Wait", timings->wait_ms);
+    render_timing_row("Receive", timings->receive_ms);
+    if (timings->http_version[0] != '\0' || timings->server_ip[0] != '\0') {
+        ImGui::Separator();
+        ImGui::Text("%s %s", timings->http_version, timings->server_ip);
+    }
+    ImGui::EndTooltip();
+}
+
+/* writes the response and the request it answered to a HAR file */
+static void render_har_export_button(AppState* state) {
+    static bool include_bodies = true;
+
+    if (ImGui::Button(ICON_FA_DOWNLOAD " HAR", ImVec2(70, 25))) {
+        if (state->last_export_path[0] == '\0') {
+            snprintf(state->last_export_path, sizeof(state->last_export_path), "response.har");
+        }
+        ImGui::OpenPopup("##ExportResponseHar");
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Export request and response as HAR");
+    }
+
+    if (ImGui::BeginPopup("##ExportResponseHar")) {
+        ImGui::SetNextItemWidth(320.0f);
+        ImGui::InputTextWithHint("##HarPath", "File path", state->last_export_path, sizeof(state->last_export_path));
+        ImGui::Checkbox("Include bodies", &include_bodies);
+        if (ImGui::Button("Export", ImVec2(80, 0)) && state->last_export_path[0] != '\0') {
+            app_state_export_response_har(state, state->active_request_tab, state->last_export_path, include_bodies);
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(80, 0))) {
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+}
+
 void ui_response_panel_render(UIManager* ui, AppState* state) {
     if (!ui || !state) {
         return;
     }
 
     const ModernGruvboxTheme* theme = theme_get_current();
-    Response* response = &state->current_response;
-
-    static int last_status_code = -1;
-    static size_t last_body_size = 0;
-    static char* last_body_ptr = NULL;
+    Response* response = app_state_get_current_response(state);
+    if (!response) {
+        return;
+    }
 
-    if (response->status_code != last_status_code ||
-        response->body_size != last_body_size ||
-        response->body != last_body_ptr) {
+    /* a new response, or another tab's, starts the views over. a body
+     * allocated where the last one was freed has a generation of its own */
+    static unsigned int last_generation = 0;
+    unsigned int generation = response_get_meta(response)->generation;
+    if (generation != last_generation) {
         reset_json_formatting_state();
-        last_status_code = response->status_code;
-        last_body_size = response->body_size;
-        last_body_ptr = response->body;
+        g_search_source = NULL;
+        g_filter_stale = true;
+        ui_hex_view_reset(&g_hex_view);
+        g_hex_mode_pending = true;
+        last_generation = generation;
     }
 
     ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(SPACING_SM, SPACING_MD));
@@ -270,6 +801,9 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
         ImGui::Button(time_text, ImVec2(70, 25));
         ImGui::PopStyleVar(3);
         ImGui::PopStyleColor(4);
+        if (response->timings.valid && ImGui::IsItemHovered()) {
+            render_timings_tooltip(&response->timings);
+        }
 
         ImGui::SameLine();
 
@@ -297,12 +831,15 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
         ImGui::PopStyleVar(3);
         ImGui::PopStyleColor(4);
 
+        ImGui::SameLine();
+        render_har_export_button(state);
+
         ImGui::EndGroup();
 
         ImGui::Separator();
 
         static int selected_tab = 0;
-        const char* tab_names[] = { "Preview", "Headers", "Cookies" };
+        const char* tab_names[] = { "Preview", "Headers", "Cookies", "Compare" };
         const int tab_count = sizeof(tab_names) / sizeof(tab_names[0]);
 
         ImGui::BeginGroup();
@@ -343,29 +880,26 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
         if (selected_tab == 0) {
             if (response->body && response->body_size > 0) {
 
-                bool is_json = false;
-                bool is_xml = false;
-                bool is_html = false;
-                const char* content_type = NULL;
-
-                for (int i = 0; i < response->headers.count; i++) {
-                    if (strcasecmp(response->headers.headers[i].name, "content-type") == 0) {
-                        content_type = response->headers.headers[i].value;
-                        break;
-                    }
+                const ResponseMeta* meta = response_get_meta(response);
+                bool is_json = meta->kind == RESPONSE_KIND_JSON;
+                bool is_xml = meta->kind == RESPONSE_KIND_XML;
+                bool is_html = meta->kind == RESPONSE_KIND_HTML;
+
+                if (g_hex_mode_pending) {
+                    g_can_show_image = meta->kind == RESPONSE_KIND_IMAGE &&
+                                       image_decoder_supports_content_type(meta->mime_type);
+                    g_show_image = g_can_show_image;
+                    g_show_hex = !g_show_image &&
+                                 (meta->kind == RESPONSE_KIND_IMAGE || meta->kind == RESPONSE_KIND_BINARY);
+                    g_image_key = g_can_show_image ? image_decoder_key(response->body, response->body_size) : 0;
+                    g_hex_mode_pending = false;
                 }
+                bool can_show_image = g_can_show_image;
 
-                if (content_type) {
-                    is_json = strstr(content_type, "application/json") != NULL;
-                    is_xml = strstr(content_type, "application/xml") != NULL || strstr(content_type, "text/xml") != NULL;
-                    is_html = strstr(content_type, "text/html") != NULL;
-                } else if (response->body) {
-
-                    const char* trimmed = response->body;
-                    while (*trimmed == ' ' || *trimmed == '\t' || *trimmed == '\n') trimmed++;
-                    is_json = (*trimmed == '{' || *trimmed == '[');
-                    is_xml = (*trimmed == '<' && strncmp(trimmed, "<?xml", 5) == 0);
-                    is_html = (*trimmed == '<' && (strncmp(trimmed, "<!DOCTYPE", 9) == 0 || strncmp(trimmed, "<html", 5) == 0));
+                if (g_show_hex || g_show_image) {
+                    is_json = false;
+                    is_xml = false;
+                    is_html = false;
                 }
 
                 if (is_json && !g_formatted_json) {
@@ -375,7 +909,7 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
                 const size_t MAX_DISPLAY_SIZE = 100000; 
                 bool is_truncated = response->body_size > MAX_DISPLAY_SIZE;
 
-                if (is_truncated) {
+                if (is_truncated && !g_show_hex && !g_show_image) {
                     theme_render_status_indicator(
                         "Large response truncated for performance",
                         STATUS_TYPE_WARNING,
@@ -384,6 +918,36 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
                     ImGui::Spacing();
                 }
 
+                if (is_json) {
+                    render_response_filter_bar(response, theme);
+                    ImGui::Spacing();
+                }
+
+                bool show_filter_output = is_json && g_filter_output != NULL;
+
+                const char* search_text = response->body;
+                size_t search_text_size = response->body_size;
+                bool search_plain_text = true;
+                if (show_filter_output) {
+                    search_text = g_filter_output;
+                    search_text_size = g_filter_output_size;
+                } else if (is_json && g_show_formatted && g_formatted_json) {
+                    search_text = g_formatted_json;
+                    search_text_size = strlen(g_formatted_json);
+                    search_plain_text = false;
+                }
+                size_t search_visible_size = search_text_size > MAX_DISPLAY_SIZE ? MAX_DISPLAY_SIZE : search_text_size;
+
+                if (!g_show_image) {
+                    render_body_search_bar(search_text, search_text_size, theme);
+                    ImGui::Spacing();
+                }
+
+                if (g_show_hex) {
+                    ui_hex_view_render_toolbar((const unsigned char*)response->body, response->body_size, &g_hex_view);
+                    ImGui::Spacing();
+                }
+
                 ImVec2 body_size = ImVec2(-1.0f, -60.0f); 
 
                 if (is_json) {
@@ -404,13 +968,26 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
                     ImGui::PushStyleColor(ImGuiCol_Text, theme->fg_primary);
                 }
 
-                if (g_word_wrap_enabled) {
+                if (g_show_image) {
+
+                    ui_image_preview_render("ResponseBodyImage", g_image_key, response->body, response->body_size,
+                                            body_size.x, body_size.y);
+                } else if (g_show_hex) {
+
+                    apply_search_highlight_hex();
+                    ui_hex_view_render("ResponseBodyHex", (const unsigned char*)response->body, response->body_size,
+                                       &g_hex_view, body_size.x, body_size.y);
+                } else if (g_word_wrap_enabled) {
 
                     ImGui::BeginChild("ResponseBodyWrap", body_size, true, ImGuiWindowFlags_AlwaysVerticalScrollbar);
 
+                    apply_search_highlight(search_text, search_visible_size, false, theme);
+
                     ImGui::PushTextWrapPos(0.0f);
 
-                    if (is_json && g_show_formatted && g_formatted_json) {
+                    if (show_filter_output) {
+                        render_plain_text_limited(g_filter_output, g_filter_output_size, MAX_DISPLAY_SIZE);
+                    } else if (is_json && g_show_formatted && g_formatted_json) {
 
                         if (strlen(g_formatted_json) > MAX_DISPLAY_SIZE) {
                             char temp_buffer[MAX_DISPLAY_SIZE + 1];
@@ -449,7 +1026,11 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
                     ImGui::BeginChild("ResponseBodyScroll", body_size, true,
                                      ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_AlwaysVerticalScrollbar);
 
-                    if (is_json && g_show_formatted && g_formatted_json) {
+                    apply_search_highlight(search_text, search_visible_size, search_plain_text, theme);
+
+                    if (show_filter_output) {
+                        render_plain_text_limited(g_filter_output, g_filter_output_size, MAX_DISPLAY_SIZE);
+                    } else if (is_json && g_show_formatted && g_formatted_json) {
 
                         if (strlen(g_formatted_json) > MAX_DISPLAY_SIZE) {
                             char temp_buffer[MAX_DISPLAY_SIZE + 1];
@@ -491,7 +1072,9 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
                 theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
                 if (ImGui::Button("Copy", ImVec2(80, 0))) {
 
-                    if (is_json && g_show_formatted && g_formatted_json) {
+                    if (show_filter_output) {
+                        ImGui::SetClipboardText(g_filter_output);
+                    } else if (is_json && g_show_formatted && g_formatted_json) {
                         ImGui::SetClipboardText(g_formatted_json);
                     } else {
                         ImGui::SetClipboardText(response->body);
@@ -505,13 +1088,36 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
 
                 ImGui::SameLine();
                 theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
-                if (ImGui::Button(g_word_wrap_enabled ? ICON_FA_LIST " Wrap" : ICON_FA_ARROW_RIGHT " No Wrap", ImVec2(90, 0))) {
-                    g_word_wrap_enabled = !g_word_wrap_enabled;
+                if (can_show_image) {
+                    if (ImGui::Button(g_show_image ? ICON_FA_CODE " Hex" : ICON_FA_FILE " Image", ImVec2(80, 0))) {
+                        g_show_image = !g_show_image;
+                        g_show_hex = !g_show_image;
+                    }
+                } else if (ImGui::Button(g_show_hex ? ICON_FA_FILE_CODE " Text" : ICON_FA_CODE " Hex", ImVec2(80, 0))) {
+                    g_show_hex = !g_show_hex;
+                    g_search_scroll_pending = g_search_current >= 0;
                 }
                 theme_pop_button_style();
 
                 if (ImGui::IsItemHovered()) {
-                    ImGui::SetTooltip(g_word_wrap_enabled ? "Disable word wrap (show horizontal scrollbar)" : "Enable word wrap (wrap long lines)");
+                    if (can_show_image) {
+                        ImGui::SetTooltip(g_show_image ? "Show the image bytes as a hex dump" : "Show the image");
+                    } else {
+                        ImGui::SetTooltip(g_show_hex ? "Show the body as text" : "Show the body as a hex dump");
+                    }
+                }
+
+                if (!g_show_hex && !g_show_image) {
+                    ImGui::SameLine();
+                    theme_push_button_style(theme, BUTTON_TYPE_NORMAL);
+                    if (ImGui::Button(g_word_wrap_enabled ? ICON_FA_LIST " Wrap" : ICON_FA_ARROW_RIGHT " No Wrap", ImVec2(90, 0))) {
+                        g_word_wrap_enabled = !g_word_wrap_enabled;
+                    }
+                    theme_pop_button_style();
+
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::SetTooltip(g_word_wrap_enabled ? "Disable word wrap (show horizontal scrollbar)" : "Enable word wrap (wrap long lines)");
+                    }
                 }
 
                 if (is_json) {
@@ -544,6 +1150,23 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
                     }
                 }
 
+                char meta_text[256];
+                int meta_length = snprintf(meta_text, sizeof(meta_text), "%s",
+                                           meta->mime_type[0] ? meta->mime_type : "unknown type");
+                if (meta->charset[0] && meta_length < (int)sizeof(meta_text)) {
+                    meta_length += snprintf(meta_text + meta_length, sizeof(meta_text) - meta_length, ", %s", meta->charset);
+                }
+                if (meta->encoding[0] && meta_length < (int)sizeof(meta_text)) {
+                    meta_length += snprintf(meta_text + meta_length, sizeof(meta_text) - meta_length, ", %s", meta->encoding);
+                }
+                if (meta->line_count > 0 && meta_length < (int)sizeof(meta_text)) {
+                    snprintf(meta_text + meta_length, sizeof(meta_text) - meta_length, ", %zu lines", meta->line_count);
+                }
+                ImGui::SameLine();
+                theme_push_caption_style();
+                ImGui::TextColored(theme->fg_tertiary, "%s", meta_text);
+                theme_pop_text_style();
+
             } else {
                 theme_render_status_indicator("No response body received", STATUS_TYPE_INFO, theme);
             }
@@ -861,7 +1484,7 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
         }
 
         else if (selected_tab == 3) {
-            theme_render_status_indicator("Test functionality not implemented yet", STATUS_TYPE_INFO, theme);
+            ui_response_diff_render(state, theme);
         }
 
     } else {
@@ -909,6 +1532,15 @@ void ui_response_panel_render(UIManager* ui, AppState* state) {
 
 void ui_response_panel_cleanup(void) {
     cleanup_formatted_json();
+    cleanup_body_search();
+    if (g_filter_runner) {
+        json_filter_runner_destroy(g_filter_runner);
+        g_filter_runner = NULL;
+    }
+    g_filter_pending = false;
+    cleanup_filter_output();
+    ui_image_preview_cleanup();
+    ui_response_diff_cleanup();
 }
 
 } 
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+ * multiline text input that grows a TextBuffer through imgui's resize callback
+ */
+
+#include "ui/ui_text_input.h"
+#include "imgui.h"
+#include <string.h>
+
+extern "C" {
+
+/* one pending selection request, consumed once the editor is active */
+static const TextBuffer* g_select_buffer = NULL;
+static size_t g_select_offset = 0;
+static size_t g_select_length = 0;
+
+/* imgui asks for BufSize bytes when the edited text outgrows the current array */
+static int text_input_callback(ImGuiInputTextCallbackData* data) {
+    TextBuffer* buffer = (TextBuffer*)data->UserData;
+
+    if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+        if (text_buffer_reserve(buffer, (size_t)data->BufSize) == 0) {
+            data->Buf = buffer->data;
+        } else {
+            /* out of room, imgui keeps editing within the old capacity */
+            data->BufSize = (int)buffer->capacity;
+        }
+    } else if (data->EventFlag == ImGuiInputTextFlags_CallbackAlways && g_select_buffer == buffer) {
+        size_t text_length = (size_t)data->BufTextLen;
+        size_t start = g_select_offset < text_length ? g_select_offset : text_length;
+        size_t end = g_select_length < text_length - start ? start + g_select_length : text_length;
+
+        data->SelectionStart = (int)start;
+        data->SelectionEnd = (int)end;
+        data->CursorPos = (int)end;
+        g_select_buffer = NULL;
+    }
+    return 0;
+}
+
+/* draws an InputTextMultiline over the buffer, returns true when the text was edited */
+bool ui_text_input_multiline(const char* label, TextBuffer* buffer, float width, float height, int flags) {
+    if (!label || !buffer) {
+        return false;
+    }
+
+    /* the shared empty string must never be written to, give imgui a real array */
+    if (text_buffer_reserve(buffer, buffer->length + 1) != 0) {
+        ImGui::TextDisabled("(body too large to edit)");
+        return false;
+    }
+
+    flags |= ImGuiInputTextFlags_CallbackResize;
+    if (g_select_buffer == buffer) {
+        ImGui::SetKeyboardFocusHere();
+        flags |= ImGuiInputTextFlags_CallbackAlways;
+    }
+
+    bool changed = ImGui::InputTextMultiline(label, buffer->data, buffer->capacity,
+                                             ImVec2(width, height), flags,
+                                             text_input_callback, buffer);
+    if (changed) {
+        text_buffer_set_length(buffer, strlen(buffer->data));
+    }
+    return changed;
+}
+
+/* selects length bytes at offset the next time the editor for buffer is drawn */
+void ui_text_input_select(TextBuffer* buffer, size_t offset, size_t length) {
+    g_select_buffer = buffer;
+    g_select_offset = offset;
+    g_select_length = length;
+}
+
+}
@@ -3,6 +3,7 @@
 #include "ui/ui_request_panel.h"
 #include "ui/ui_response_panel.h"
 #include "ui/ui_dialogs.h"
+#include "ui/ui_main_tabs.h"
 #include "ui/ui_panels.h"
 #include "app_state.h"
 #include "request_response.h"
@@ -24,6 +25,9 @@ int ui_manager_init(UIManager* ui, GLFWwindow* window) {
 }
 
 void ui_manager_cleanup(UIManager* ui) {
+    ui_main_tabs_cleanup();
+    ui_request_panel_cleanup();
+    ui_response_panel_cleanup();
     ui_core_cleanup(ui);
 }
 
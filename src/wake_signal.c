@@ -0,0 +1,26 @@
+/**
+ * ui loop wakeups for tinyrequest
+ *
+ * the handler is set at startup and cleared again at shutdown while a
+ * worker the ui did not join yet may still be posting, so it is kept in an
+ * atomic pointer and a post sees either the old handler or none.
+ */
+
+#include "wake_signal.h"
+#include <stddef.h>
+#include <stdatomic.h>
+
+static void (*_Atomic g_wake_handler)(void) = NULL;
+
+/* asks the ui loop to draw another frame */
+void wake_signal_post(void) {
+    void (*handler)(void) = atomic_load(&g_wake_handler);
+    if (handler) {
+        handler();
+    }
+}
+
+/* sets the function that wakes the ui loop */
+void wake_signal_set_handler(void (*handler)(void)) {
+    atomic_store(&g_wake_handler, handler);
+}
@@ -0,0 +1,280 @@
+/**
+ * round trip of the collection converters
+ *
+ * a collection is written as json, converted to a .trc store file and back
+ * to json, and what each of the three files reads back as is compared field
+ * by field. one collection has a request large enough to be compressed, the
+ * other only requests below COLLECTION_STORE_COMPRESS_MIN, so a build with
+ * zstd covers compressed and raw blobs. a build configured with
+ * -DTINYREQUEST_WITH_ZSTD=OFF runs the same test without compression.
+ */
+
+#include "collection_store.h"
+#include "collection_reader.h"
+#include "persistence.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            g_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_STRING(what, expected, actual) \
+    CHECK(strcmp((expected), (actual)) == 0, "%s: '%s' != '%s'", (what), (expected), (actual))
+
+#define CHECK_NUMBER(what, expected, actual) \
+    CHECK((long long)(expected) == (long long)(actual), "%s: %lld != %lld", (what), \
+          (long long)(expected), (long long)(actual))
+
+static void add_request(Collection* collection, const char* name, const char* method, const char* url,
+                        const char* body, int auth_type) {
+    Request request;
+    request_init(&request);
+    snprintf(request.method, sizeof(request.method), "%s", method);
+    snprintf(request.url, sizeof(request.url), "%s", url);
+    header_list_add(&request.headers, "Accept", "application/json");
+    header_list_add(&request.headers, "X-Trace", "round trip \"quoted\" \xc3\xa9");
+    if (body) {
+        request_set_body(&request, body, strlen(body));
+    }
+
+    /* json keeps the fields of the selected auth type only */
+    request.selected_auth_type = auth_type;
+    if (auth_type == 1) {
+        snprintf(request.auth_api_key_name, sizeof(request.auth_api_key_name), "X-Api-Key");
+        snprintf(request.auth_api_key_value, sizeof(request.auth_api_key_value), "key-%s", name);
+        request.auth_api_key_location = 1;
+    } else if (auth_type == 2) {
+        snprintf(request.auth_bearer_token, sizeof(request.auth_bearer_token), "bearer-%s", name);
+    } else if (auth_type == 3) {
+        snprintf(request.auth_basic_username, sizeof(request.auth_basic_username), "user");
+        snprintf(request.auth_basic_password, sizeof(request.auth_basic_password), "pass:word");
+    } else if (auth_type == 4) {
+        snprintf(request.auth_oauth_token, sizeof(request.auth_oauth_token), "oauth-%s", name);
+    }
+    request.auth_api_key_enabled = true;
+    request.auth_bearer_enabled = auth_type != 2;
+    request.auth_basic_enabled = true;
+    request.auth_oauth_enabled = false;
+
+    collection_add_request(collection, &request, name);
+    request_cleanup(&request);
+}
+
+static void build_collection(Collection* collection, PersistenceAuth* auth, bool large_body) {
+    collection_init(collection, large_body ? "Round trip large" : "Round trip small", "Converted there and back");
+    snprintf(collection->id, sizeof(collection->id), "%s", large_body ? "roundtrip-large" : "roundtrip-small");
+    collection->created_at = 1700000000;
+    collection->modified_at = 1700000500;
+
+    add_request(collection, "List users", "GET", "https://api.example.com/users?page=2", NULL, 0);
+    add_request(collection, "Create user", "POST", "https://api.example.com/users",
+                "{\"name\":\"Ada\",\"tags\":[\"a\",\"b\"]}", 2);
+    add_request(collection, "Form login", "PUT", "https://api.example.com/login",
+                "user=ada&password=secret", 3);
+    add_request(collection, "Query key", "DELETE", "https://api.example.com/users/7", NULL, 1);
+
+    if (large_body) {
+        /* well past COLLECTION_STORE_COMPRESS_MIN and repetitive, so zstd keeps it compressed */
+        size_t size = 64 * 1024;
+        char* body = (char*)malloc(size + 1);
+        for (size_t i = 0; i < size; i++) {
+            body[i] = "line of text in a large body\n"[i % 29];
+        }
+        body[size] = '\0';
+        add_request(collection, "Upload", "PATCH", "https://api.example.com/upload", body, 4);
+        free(body);
+    }
+
+    cookie_jar_add_cookie(&collection->cookie_jar, "session", "abc123", "api.example.com", "/", 1900000000, 3600,
+                          true, true, false, true);
+    cookie_jar_add_cookie(&collection->cookie_jar, "theme", "dark", ".example.com", "/app", 0, -1,
+                          false, false, true, false);
+
+    memset(auth, 0, sizeof(PersistenceAuth));
+    auth->selected_auth_type = 2;
+    snprintf(auth->bearer_token, sizeof(auth->bearer_token), "collection-token");
+    auth->api_key_enabled = true;
+    auth->bearer_enabled = true;
+}
+
+static void compare_collections(const char* label, const Collection* expected, const Collection* actual) {
+    CHECK_STRING(label, expected->id, actual->id);
+    CHECK_STRING(label, expected->name, actual->name);
+    CHECK_STRING(label, expected->description, actual->description);
+    CHECK_NUMBER(label, expected->created_at, actual->created_at);
+    CHECK_NUMBER(label, expected->modified_at, actual->modified_at);
+    CHECK_NUMBER(label, expected->request_count, actual->request_count);
+    if (expected->request_count != actual->request_count) {
+        return;
+    }
+
+    for (int i = 0; i < expected->request_count; i++) {
+        const Request* a = &expected->requests[i];
+        const Request* b = &actual->requests[i];
+        CHECK_STRING(label, expected->request_names[i], actual->request_names[i]);
+        CHECK_STRING(label, a->method, b->method);
+        CHECK_STRING(label, a->url, b->url);
+        CHECK_NUMBER(label, a->body_size, b->body_size);
+        CHECK((a->body == NULL) == (b->body == NULL) &&
+              (!a->body || memcmp(a->body, b->body, a->body_size) == 0), "%s: body of request %d differs", label, i);
+
+        CHECK_NUMBER(label, a->headers.count, b->headers.count);
+        for (int h = 0; h < a->headers.count && h < b->headers.count; h++) {
+            CHECK_STRING(label, a->headers.headers[h].name, b->headers.headers[h].name);
+            CHECK_STRING(label, a->headers.headers[h].value, b->headers.headers[h].value);
+        }
+
+        CHECK_NUMBER(label, a->selected_auth_type, b->selected_auth_type);
+        CHECK_STRING(label, a->auth_api_key_name, b->auth_api_key_name);
+        CHECK_STRING(label, a->auth_api_key_value, b->auth_api_key_value);
+        CHECK_STRING(label, a->auth_bearer_token, b->auth_bearer_token);
+        CHECK_STRING(label, a->auth_basic_username, b->auth_basic_username);
+        CHECK_STRING(label, a->auth_basic_password, b->auth_basic_password);
+        CHECK_STRING(label, a->auth_oauth_token, b->auth_oauth_token);
+        CHECK_NUMBER(label, a->auth_api_key_location, b->auth_api_key_location);
+        CHECK_NUMBER(label, a->auth_api_key_enabled, b->auth_api_key_enabled);
+        CHECK_NUMBER(label, a->auth_bearer_enabled, b->auth_bearer_enabled);
+        CHECK_NUMBER(label, a->auth_basic_enabled, b->auth_basic_enabled);
+        CHECK_NUMBER(label, a->auth_oauth_enabled, b->auth_oauth_enabled);
+    }
+
+    CHECK_NUMBER(label, expected->cookie_jar.count, actual->cookie_jar.count);
+    for (int i = 0; i < expected->cookie_jar.count && i < actual->cookie_jar.count; i++) {
+        const StoredCookie* a = &expected->cookie_jar.cookies[i];
+        const StoredCookie* b = &actual->cookie_jar.cookies[i];
+        CHECK_STRING(label, a->name, b->name);
+        CHECK_STRING(label, a->value, b->value);
+        CHECK_STRING(label, a->domain, b->domain);
+        CHECK_STRING(label, a->path, b->path);
+        CHECK_NUMBER(label, a->expires, b->expires);
+        CHECK_NUMBER(label, a->max_age, b->max_age);
+        CHECK_NUMBER(label, a->secure, b->secure);
+        CHECK_NUMBER(label, a->http_only, b->http_only);
+        CHECK_NUMBER(label, a->same_site_strict, b->same_site_strict);
+        CHECK_NUMBER(label, a->same_site_lax, b->same_site_lax);
+        CHECK_NUMBER(label, a->created_at, b->created_at);
+    }
+}
+
+static void compare_auth(const char* label, const PersistenceAuth* a, const PersistenceAuth* b) {
+    CHECK_NUMBER(label, a->selected_auth_type, b->selected_auth_type);
+    CHECK_STRING(label, a->api_key_name, b->api_key_name);
+    CHECK_STRING(label, a->api_key_value, b->api_key_value);
+    CHECK_STRING(label, a->bearer_token, b->bearer_token);
+    CHECK_STRING(label, a->basic_username, b->basic_username);
+    CHECK_STRING(label, a->basic_password, b->basic_password);
+    CHECK_STRING(label, a->oauth_token, b->oauth_token);
+    CHECK_NUMBER(label, a->api_key_location, b->api_key_location);
+    CHECK_NUMBER(label, a->api_key_enabled, b->api_key_enabled);
+    CHECK_NUMBER(label, a->bearer_enabled, b->bearer_enabled);
+    CHECK_NUMBER(label, a->basic_enabled, b->basic_enabled);
+    CHECK_NUMBER(label, a->oauth_enabled, b->oauth_enabled);
+}
+
+/* only blobs of COLLECTION_STORE_COMPRESS_MIN bytes or more are compressed, and only with zstd */
+static void check_compression(const char* store_path) {
+    int error = 0;
+    CollectionStore* store = collection_store_open(store_path, &error);
+    CHECK(store != NULL, "%s does not open, error %d", store_path, error);
+    if (!store) {
+        return;
+    }
+
+    for (int i = 0; i < collection_store_get_request_count(store); i++) {
+        CollectionStoreEntry entry;
+        CHECK(collection_store_get_entry(store, i, &entry), "no index entry %d in %s", i, store_path);
+#ifdef TINYREQUEST_HAVE_ZSTD
+        bool expected = entry.size >= COLLECTION_STORE_COMPRESS_MIN;
+#else
+        bool expected = false;
+#endif
+        CHECK(entry.compressed == expected, "request '%s' in %s is%s compressed", entry.name, store_path,
+              entry.compressed ? "" : " not");
+    }
+    collection_store_close(store);
+}
+
+static void round_trip(bool large_body) {
+    const char* json_path = large_body ? "roundtrip_large.json" : "roundtrip_small.json";
+    const char* store_path = large_body ? "roundtrip_large.trc" : "roundtrip_small.trc";
+    const char* back_path = large_body ? "roundtrip_large_back.json" : "roundtrip_small_back.json";
+
+    Collection original;
+    PersistenceAuth auth;
+    build_collection(&original, &auth, large_body);
+
+    char* json = persistence_serialize_collection(&original, &auth);
+    CHECK(json != NULL, "the collection does not serialize");
+    if (!json) {
+        collection_cleanup(&original);
+        return;
+    }
+    CHECK_NUMBER("write json", PERSISTENCE_SUCCESS, persistence_write_file_atomic(json_path, json, strlen(json)));
+    free(json);
+
+    CHECK_NUMBER("json to store", PERSISTENCE_SUCCESS, collection_store_convert_from_json(json_path, store_path));
+    CHECK_NUMBER("store to json", PERSISTENCE_SUCCESS, collection_store_convert_to_json(store_path, back_path));
+    check_compression(store_path);
+
+    Collection from_json;
+    Collection from_store;
+    Collection from_back;
+    memset(&from_json, 0, sizeof(Collection));
+    memset(&from_store, 0, sizeof(Collection));
+    memset(&from_back, 0, sizeof(Collection));
+    PersistenceAuth json_auth;
+    PersistenceAuth store_auth;
+    PersistenceAuth back_auth;
+    bool json_has_auth = false;
+    bool store_has_auth = false;
+    bool back_has_auth = false;
+
+    CHECK_NUMBER("read json", PERSISTENCE_SUCCESS,
+                 collection_reader_read_file(&from_json, json_path, &json_auth, &json_has_auth));
+    CHECK_NUMBER("read store", PERSISTENCE_SUCCESS,
+                 collection_store_read_file(&from_store, store_path, &store_auth, &store_has_auth));
+    CHECK_NUMBER("read json again", PERSISTENCE_SUCCESS,
+                 collection_reader_read_file(&from_back, back_path, &back_auth, &back_has_auth));
+
+    /* json bodies are re-encoded on the way in, so the json file read back is the reference */
+    compare_collections("json and original", &original, &from_json);
+    compare_collections("store and json", &from_json, &from_store);
+    compare_collections("json, store, json", &from_json, &from_back);
+
+    CHECK(json_has_auth && store_has_auth && back_has_auth, "collection auth got lost");
+    if (json_has_auth && store_has_auth && back_has_auth) {
+        compare_auth("json auth", &auth, &json_auth);
+        compare_auth("store auth", &json_auth, &store_auth);
+        compare_auth("json, store, json auth", &json_auth, &back_auth);
+    }
+
+    collection_cleanup(&original);
+    collection_cleanup(&from_json);
+    collection_cleanup(&from_store);
+    collection_cleanup(&from_back);
+    remove(json_path);
+    remove(store_path);
+    remove(back_path);
+}
+
+int main(void) {
+    round_trip(false);
+    round_trip(true);
+
+    if (g_failures > 0) {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("collection store round trip passed\n");
+    return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * cookie header of a cookie jar
+ *
+ * the header is built into a buffer sized exactly for its cookies, so the
+ * last value ends right at the terminator. an off-by-one there sent the
+ * last cookie as "name=" without its value; every cookie, the last one
+ * included, has to go out whole, down to a value of the longest length a
+ * jar stores.
+ */
+
+#include "collections.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            g_failures++; \
+        } \
+    } while (0)
+
+static void add_cookie(CookieJar* jar, const char* name, const char* value) {
+    CHECK(cookie_jar_add_cookie(jar, name, value, "example.com", "/", 0, -1, false, false, false, false) >= 0,
+          "could not add cookie %s", name);
+}
+
+static void check_header(CookieJar* jar, const char* label, const char* expected) {
+    char* header = cookie_jar_build_cookie_header(jar, "http://example.com/users", false);
+    if (!header) {
+        CHECK(false, "%s: no cookie header", label);
+        return;
+    }
+    CHECK(strcmp(header, expected) == 0, "%s: cookie header is '%s', not '%s'", label, header, expected);
+    free(header);
+}
+
+int main(void) {
+    CookieJar jar;
+    cookie_jar_init(&jar);
+
+    add_cookie(&jar, "session", "abc123");
+    check_header(&jar, "one cookie", "session=abc123");
+
+    add_cookie(&jar, "theme", "dark");
+    check_header(&jar, "two cookies", "session=abc123; theme=dark");
+
+    /* a value of the longest length a cookie holds, last in the header */
+    char value[sizeof(((StoredCookie*)0)->value)];
+    memset(value, 'v', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    add_cookie(&jar, "long", value);
+    char expected[1024];
+    snprintf(expected, sizeof(expected), "session=abc123; theme=dark; long=%s", value);
+    check_header(&jar, "longest value", expected);
+
+    cookie_jar_cleanup(&jar);
+
+    if (g_failures > 0) {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("cookie jar header passed\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * snapshot, rotation and restore of the saved collections
+ *
+ * the collections directory of a throwaway config directory is snapshotted,
+ * edited and snapshotted again three times, the oldest snapshot is rotated
+ * away and the middle one restored. every collection file, journal and the
+ * state file has to come back byte for byte, files the snapshot did not
+ * have have to go, and the restore has to leave a snapshot of what it
+ * replaced that restores the newest state again.
+ */
+
+#ifndef _WIN32
+#define _XOPEN_SOURCE 700
+#endif
+
+#include "snapshot_store.h"
+#include "persistence.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            g_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_NUMBER(what, expected, actual) \
+    CHECK((long long)(expected) == (long long)(actual), "%s: %lld != %lld", (what), \
+          (long long)(expected), (long long)(actual))
+
+/* the files of one state of the collections directory, NULL for a file that is not there */
+typedef struct {
+    const char* state;
+    const char* a_json;
+    const char* a_journal;
+    const char* b_json;
+    const char* c_trc;
+} CollectionFiles;
+
+static const CollectionFiles FIRST = {
+    "{\"collection_count\":1}", "{\"id\":\"a\",\"name\":\"A\",\"requests\":[]}", NULL, NULL, NULL
+};
+
+static const CollectionFiles SECOND = {
+    "{\"collection_count\":2}", "{\"id\":\"a\",\"name\":\"A renamed\",\"requests\":[]}", "journal of a",
+    "{\"id\":\"b\",\"name\":\"B\",\"requests\":[]}", NULL
+};
+
+static const CollectionFiles THIRD = {
+    "{\"collection_count\":2}", "{\"id\":\"a\",\"name\":\"A renamed\",\"requests\":[]}", NULL,
+    NULL, "TRQC not really a store"
+};
+
+static char* file_path(const char* file) {
+    return strcmp(file, "collections_state.json") == 0 ? persistence_get_config_path(file)
+                                                       : persistence_get_collections_path(file);
+}
+
+static void put_file(const char* file, const char* text) {
+    char* path = file_path(file);
+    if (text) {
+        CHECK_NUMBER(file, PERSISTENCE_SUCCESS, persistence_write_file_atomic(path, text, strlen(text)));
+    } else {
+        remove(path);
+    }
+    free(path);
+}
+
+static void put_files(const CollectionFiles* files) {
+    put_file("collections_state.json", files->state);
+    put_file("a.json", files->a_json);
+    put_file("a.journal", files->a_journal);
+    put_file("b.json", files->b_json);
+    put_file("c.trc", files->c_trc);
+}
+
+static void check_file(const char* label, const char* file, const char* expected) {
+    char* path = file_path(file);
+    FILE* handle = path ? fopen(path, "rb") : NULL;
+    free(path);
+
+    if (!expected) {
+        CHECK(!handle, "%s: %s should not be there", label, file);
+    } else if (!handle) {
+        CHECK(false, "%s: %s is missing", label, file);
+    } else {
+        char actual[256];
+        size_t length = fread(actual, 1, sizeof(actual) - 1, handle);
+        actual[length] = '\0';
+        CHECK(strcmp(expected, actual) == 0, "%s: %s is '%s', not '%s'", label, file, actual, expected);
+    }
+    if (handle) {
+        fclose(handle);
+    }
+}
+
+static void check_files(const char* label, const CollectionFiles* files) {
+    check_file(label, "collections_state.json", files->state);
+    check_file(label, "a.json", files->a_json);
+    check_file(label, "a.journal", files->a_journal);
+    check_file(label, "b.json", files->b_json);
+    check_file(label, "c.trc", files->c_trc);
+}
+
+static void take_snapshot(const char* label, char* name, size_t name_size) {
+    bool created = false;
+    CHECK_NUMBER(label, PERSISTENCE_SUCCESS, snapshot_store_create(name, name_size, &created));
+    CHECK(created, "%s: no snapshot was written", label);
+}
+
+#ifndef _WIN32
+static int remove_entry(const char* path, const struct stat* info, int flag, struct FTW* ftw) {
+    (void)info;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+#endif
+
+/* points the config directory at a fresh one, returns false if that failed */
+static bool use_temp_config(char* root, size_t root_size) {
+#ifdef _WIN32
+    char temp[MAX_PATH];
+    if (GetTempPathA(sizeof(temp), temp) == 0) {
+        return false;
+    }
+    snprintf(root, root_size, "%stinyrequest-snapshot-%lu", temp, (unsigned long)GetCurrentProcessId());
+    if (_mkdir(root) != 0 || _putenv_s("LOCALAPPDATA", root) != 0) {
+        return false;
+    }
+#else
+    snprintf(root, root_size, "/tmp/tinyrequest-snapshot-XXXXXX");
+    if (!mkdtemp(root) || setenv("HOME", root, 1) != 0) {
+        return false;
+    }
+    /* the config directory is created without its parent */
+    char parent[600];
+    snprintf(parent, sizeof(parent), "%s/.config", root);
+    if (mkdir(parent, 0755) != 0) {
+        return false;
+    }
+#endif
+    return persistence_create_config_dir() == 0 && persistence_create_collections_dir() == 0;
+}
+
+int main(void) {
+    char root[512];
+    if (!use_temp_config(root, sizeof(root))) {
+        fprintf(stderr, "could not set up a config directory\n");
+        return 1;
+    }
+
+    char first[64];
+    char second[64];
+    char third[64];
+    put_files(&FIRST);
+    take_snapshot("first snapshot", first, sizeof(first));
+    put_files(&SECOND);
+    take_snapshot("second snapshot", second, sizeof(second));
+    put_files(&THIRD);
+    take_snapshot("third snapshot", third, sizeof(third));
+
+    /* nothing changed, so no new snapshot */
+    char unchanged[64];
+    bool created = true;
+    CHECK_NUMBER("unchanged snapshot", PERSISTENCE_SUCCESS, snapshot_store_create(unchanged, sizeof(unchanged), &created));
+    CHECK(!created && strcmp(unchanged, third) == 0, "an unchanged state wrote snapshot %s", unchanged);
+
+    CHECK_NUMBER("rotate", PERSISTENCE_SUCCESS, snapshot_store_rotate(2));
+    SnapshotInfo* snapshots = NULL;
+    int count = 0;
+    CHECK_NUMBER("list", PERSISTENCE_SUCCESS, snapshot_store_list(&snapshots, &count));
+    CHECK_NUMBER("snapshots after rotation", 2, count);
+    if (count == 2) {
+        CHECK(strcmp(snapshots[0].name, third) == 0 && strcmp(snapshots[1].name, second) == 0,
+              "rotation kept %s and %s", snapshots[0].name, snapshots[1].name);
+        CHECK_NUMBER("collections in the second snapshot", 2, snapshots[1].collection_count);
+    }
+    free(snapshots);
+    CHECK(snapshot_store_restore(first) != PERSISTENCE_SUCCESS, "the rotated snapshot %s still restores", first);
+    check_files("after a failed restore", &THIRD);
+
+    CHECK_NUMBER("restore", PERSISTENCE_SUCCESS, snapshot_store_restore(second));
+    check_files("restored", &SECOND);
+
+    /* the restore snapshotted the third state first, restoring the newest undoes it */
+    CHECK_NUMBER("list after restore", PERSISTENCE_SUCCESS, snapshot_store_list(&snapshots, &count));
+    CHECK(count >= 1, "no snapshot after the restore");
+    if (count >= 1) {
+        CHECK_NUMBER("undo restore", PERSISTENCE_SUCCESS, snapshot_store_restore(snapshots[0].name));
+        check_files("undone", &THIRD);
+    }
+    free(snapshots);
+
+#ifndef _WIN32
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+#endif
+
+    if (g_failures > 0) {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("snapshot store restore passed\n");
+    return 0;
+}